@@ -0,0 +1,249 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"runtime"
+	"unsafe"
+)
+
+// PropertyCallbackInfo is the argument that is passed to the accessor and
+// interceptor callbacks of an ObjectTemplate.
+type PropertyCallbackInfo struct {
+	ctx   *Context
+	this  *Object
+	key   string
+	index uint32
+}
+
+// Context is the current context that the callback is being executed in.
+func (i *PropertyCallbackInfo) Context() *Context {
+	return i.ctx
+}
+
+// This returns the receiver object of the property access.
+func (i *PropertyCallbackInfo) This() *Object {
+	return i.this
+}
+
+// Key returns the name of the property, for accessors and named
+// interceptors.
+func (i *PropertyCallbackInfo) Key() string {
+	return i.key
+}
+
+// Index returns the index of the property, for indexed interceptors.
+func (i *PropertyCallbackInfo) Index() uint32 {
+	return i.index
+}
+
+// AccessorGetter is called to read a property. For interceptors, a nil value
+// leaves the property to the object's own properties. If an error is returned,
+// it is thrown like the error of a FunctionCallbackWithError.
+type AccessorGetter func(info *PropertyCallbackInfo) (*Value, error)
+
+// AccessorSetter is called to assign value to a property.
+type AccessorSetter func(info *PropertyCallbackInfo, value *Value) error
+
+// InterceptorSetter is called to assign value to a property, and reports
+// whether it handled the assignment; if not, the value is set on the object
+// as usual.
+type InterceptorSetter func(info *PropertyCallbackInfo, value *Value) (bool, error)
+
+// InterceptorDeleter is called to delete a property, and reports whether it
+// handled the deletion; if not, the property is deleted from the object as
+// usual.
+type InterceptorDeleter func(info *PropertyCallbackInfo) (bool, error)
+
+// NamedPropertyHandler intercepts the accesses of the properties of the
+// objects of an ObjectTemplate that are named by strings, see
+// ObjectTemplate.SetNamedPropertyHandler. Callbacks left nil are not
+// installed.
+type NamedPropertyHandler struct {
+	Getter  AccessorGetter
+	Setter  InterceptorSetter
+	Deleter InterceptorDeleter
+	// Enumerator returns the names of the intercepted properties, for
+	// Object.keys and for-in loops.
+	Enumerator func(info *PropertyCallbackInfo) ([]string, error)
+}
+
+// IndexedPropertyHandler intercepts the accesses of the indexed properties of
+// the objects of an ObjectTemplate, see
+// ObjectTemplate.SetIndexedPropertyHandler. Callbacks left nil are not
+// installed.
+type IndexedPropertyHandler struct {
+	Getter  AccessorGetter
+	Setter  InterceptorSetter
+	Deleter InterceptorDeleter
+	// Enumerator returns the indexes of the intercepted properties.
+	Enumerator func(info *PropertyCallbackInfo) ([]uint32, error)
+}
+
+// propertyCallback is the Go side of an accessor or interceptor, called with
+// the operation on the property; it reports whether it handled it, and can
+// return a value for PROPERTY_GET and PROPERTY_ENUMERATE.
+type propertyCallback func(op C.int, info *PropertyCallbackInfo, value *Value) (*Value, bool, error)
+
+// SetAccessor adds a property to each instance created by this template,
+// whose value is computed by getter on each read and assigned by setter.
+// A nil setter makes assignments to the property do nothing.
+//
+// The callbacks are kept until the isolate is disposed.
+func (o *ObjectTemplate) SetAccessor(name string, getter AccessorGetter, setter AccessorSetter, attributes ...PropertyAttribute) {
+	o.setAccessor(name, getter, setter, C.ACCESSOR_PROPERTY, attributes)
+}
+
+// SetNativeDataProperty is like SetAccessor, but with a nil setter, an
+// assignment replaces the property with a plain data property.
+func (o *ObjectTemplate) SetNativeDataProperty(name string, getter AccessorGetter, setter AccessorSetter, attributes ...PropertyAttribute) {
+	o.setAccessor(name, getter, setter, C.NATIVE_DATA_PROPERTY, attributes)
+}
+
+// SetLazyDataProperty adds a property to each instance created by this
+// template whose value is computed by getter on its first read, after which
+// V8 replaces it with a plain data property. Use it to materialize the fields
+// of large host objects only once they are used.
+func (o *ObjectTemplate) SetLazyDataProperty(name string, getter AccessorGetter, attributes ...PropertyAttribute) {
+	o.setAccessor(name, getter, nil, C.LAZY_DATA_PROPERTY, attributes)
+}
+
+func (o *ObjectTemplate) setAccessor(name string, getter AccessorGetter, setter AccessorSetter, kind C.AccessorKind, attributes []PropertyAttribute) {
+	if getter == nil {
+		panic("nil AccessorGetter argument not supported")
+	}
+	var attrs PropertyAttribute
+	for _, a := range attributes {
+		attrs |= a
+	}
+
+	cbref := o.iso.registerPropertyCallback(func(op C.int, info *PropertyCallbackInfo, value *Value) (*Value, bool, error) {
+		if op == C.PROPERTY_SET {
+			return nil, true, setter(info, value)
+		}
+		val, err := getter(info)
+		return val, true, err
+	})
+
+	cname := C.CString(name)
+	defer C.free(unsafe.Pointer(cname))
+	var hasSetter C.int
+	if setter != nil {
+		hasSetter = 1
+	}
+	C.ObjectTemplateSetAccessor(o.ptr, cname, C.int(cbref), hasSetter, C.int(attrs), C.int(kind))
+	runtime.KeepAlive(o)
+}
+
+// SetNamedPropertyHandler installs the callbacks of handler as the
+// interceptors of the string named properties of each instance created by
+// this template, which are called for every access before the instance's own
+// properties are looked up. Properties named by symbols are not intercepted.
+// Enumerated names follow the instance's own properties.
+//
+// The callbacks are kept until the isolate is disposed.
+func (o *ObjectTemplate) SetNamedPropertyHandler(handler NamedPropertyHandler) {
+	var enumerate func(info *PropertyCallbackInfo) (interface{}, error)
+	if handler.Enumerator != nil {
+		enumerate = func(info *PropertyCallbackInfo) (interface{}, error) {
+			return handler.Enumerator(info)
+		}
+	}
+	o.setHandler(false, handler.Getter, handler.Setter, handler.Deleter, enumerate)
+}
+
+// SetIndexedPropertyHandler installs the callbacks of handler as the
+// interceptors of the indexed properties of each instance created by this
+// template, like SetNamedPropertyHandler.
+func (o *ObjectTemplate) SetIndexedPropertyHandler(handler IndexedPropertyHandler) {
+	var enumerate func(info *PropertyCallbackInfo) (interface{}, error)
+	if handler.Enumerator != nil {
+		enumerate = func(info *PropertyCallbackInfo) (interface{}, error) {
+			return handler.Enumerator(info)
+		}
+	}
+	o.setHandler(true, handler.Getter, handler.Setter, handler.Deleter, enumerate)
+}
+
+func (o *ObjectTemplate) setHandler(indexed bool, getter AccessorGetter, setter InterceptorSetter, deleter InterceptorDeleter, enumerate func(info *PropertyCallbackInfo) (interface{}, error)) {
+	var ops C.int
+	if getter != nil {
+		ops |= 1 << C.PROPERTY_GET
+	}
+	if setter != nil {
+		ops |= 1 << C.PROPERTY_SET
+	}
+	if deleter != nil {
+		ops |= 1 << C.PROPERTY_DELETE
+	}
+	if enumerate != nil {
+		ops |= 1 << C.PROPERTY_ENUMERATE
+	}
+	if ops == 0 {
+		return
+	}
+
+	cbref := o.iso.registerPropertyCallback(func(op C.int, info *PropertyCallbackInfo, value *Value) (*Value, bool, error) {
+		switch op {
+		case C.PROPERTY_GET:
+			val, err := getter(info)
+			return val, val != nil || err != nil, err
+		case C.PROPERTY_SET:
+			handled, err := setter(info, value)
+			return nil, handled || err != nil, err
+		case C.PROPERTY_DELETE:
+			handled, err := deleter(info)
+			return nil, handled || err != nil, err
+		default:
+			keys, err := enumerate(info)
+			if err != nil {
+				return nil, true, err
+			}
+			val, err := info.ctx.Import(keys)
+			return val, true, err
+		}
+	})
+
+	var cindexed C.int
+	if indexed {
+		cindexed = 1
+	}
+	C.ObjectTemplateSetHandler(o.ptr, C.int(cbref), cindexed, ops)
+	runtime.KeepAlive(o)
+}
+
+//export goPropertyCallback
+func goPropertyCallback(ctxref int, cbref int, op C.int, self C.ValuePtr, key *C.char, keyLength C.int, index C.uint32_t, value C.ValuePtr) (rval C.ValuePtr, rerr C.ValuePtr, handled C.int) {
+	ctx := getContext(ctxref)
+
+	info := &PropertyCallbackInfo{
+		ctx:   ctx,
+		this:  &Object{newValue(ctx, self)},
+		index: uint32(index),
+	}
+	if key != nil {
+		info.key = C.GoStringN(key, keyLength)
+	}
+	var val *Value
+	if value != nil {
+		val = newValue(ctx, value)
+	}
+
+	callback := ctx.iso.getPropertyCallback(cbref)
+	result, ok, err := callback(op, info, val)
+	if err != nil {
+		return nil, callbackError(ctx, err), 1
+	}
+	if !ok {
+		return nil, nil, 0
+	}
+	if result == nil {
+		return nil, nil, 1
+	}
+	return result.ptr, nil, 1
+}
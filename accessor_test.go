@@ -0,0 +1,204 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"errors"
+	"sort"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestObjectTemplateSetAccessor(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	type point struct{ x int32 }
+	tmpl := v8.NewObjectTemplate(iso)
+	tmpl.SetInternalFieldCount(1)
+	tmpl.SetAccessor("x", func(info *v8.PropertyCallbackInfo) (*v8.Value, error) {
+		p := info.This().GetAlignedPointerFromInternalField(0).Value().(*point)
+		return v8.NewValue(iso, p.x)
+	}, func(info *v8.PropertyCallbackInfo, value *v8.Value) error {
+		if value.Int32() < 0 {
+			return errors.New("negative " + info.Key())
+		}
+		p := info.This().GetAlignedPointerFromInternalField(0).Value().(*point)
+		p.x = value.Int32()
+		return nil
+	})
+	key := func(info *v8.PropertyCallbackInfo) (*v8.Value, error) {
+		return v8.NewValue(iso, info.Key())
+	}
+	tmpl.SetAccessor("readOnly", key, nil)
+	tmpl.SetNativeDataProperty("replaced", key, nil)
+
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	p := &point{x: 1}
+	h := v8.NewHandle(p)
+	defer h.Delete()
+	obj, err := tmpl.NewInstance(ctx)
+	fatalIf(t, err)
+	obj.SetAlignedPointerInInternalField(0, h)
+	fatalIf(t, ctx.Global().Set("p", obj))
+
+	val, err := ctx.RunScript(`
+		p.x = p.x + 41;
+		p.readOnly = "changed";
+		p.replaced = "changed";
+		[p.x, p.readOnly, p.replaced].join()
+	`, "accessor.js")
+	fatalIf(t, err)
+	if want := "42,readOnly,changed"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+	if p.x != 42 {
+		t.Errorf("expected the setter to update the Go value, got %v", p.x)
+	}
+	if _, err := ctx.RunScript("p.x = -1", "throw.js"); err == nil || err.Error() != "negative x" {
+		t.Errorf("expected the setter's error to be thrown, got %v", err)
+	}
+}
+
+func TestObjectTemplateSetLazyDataProperty(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	var calls int
+	tmpl := v8.NewObjectTemplate(iso)
+	tmpl.SetLazyDataProperty("headers", func(info *v8.PropertyCallbackInfo) (*v8.Value, error) {
+		calls++
+		return info.Context().Import(map[string]interface{}{"host": "example.com"})
+	})
+	ctx := v8.NewContext(iso, tmpl)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript("headers.host + headers.host", "lazy.js")
+	fatalIf(t, err)
+	if want := "example.comexample.com"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+	if calls != 1 {
+		t.Errorf("expected the getter to be called once, got %v", calls)
+	}
+}
+
+func TestObjectTemplateSetNamedPropertyHandler(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	row := map[string]string{"id": "7", "name": "go"}
+	tmpl := v8.NewObjectTemplate(iso)
+	tmpl.SetNamedPropertyHandler(v8.NamedPropertyHandler{
+		Getter: func(info *v8.PropertyCallbackInfo) (*v8.Value, error) {
+			if info.Key() == "fail" {
+				return nil, errors.New("no fail column")
+			}
+			if v, ok := row[info.Key()]; ok {
+				return v8.NewValue(iso, v)
+			}
+			return nil, nil
+		},
+		Setter: func(info *v8.PropertyCallbackInfo, value *v8.Value) (bool, error) {
+			if _, ok := row[info.Key()]; !ok {
+				return false, nil
+			}
+			row[info.Key()] = value.String()
+			return true, nil
+		},
+		Deleter: func(info *v8.PropertyCallbackInfo) (bool, error) {
+			if _, ok := row[info.Key()]; !ok {
+				return false, nil
+			}
+			delete(row, info.Key())
+			return true, nil
+		},
+		Enumerator: func(info *v8.PropertyCallbackInfo) ([]string, error) {
+			keys := make([]string, 0, len(row))
+			for k := range row {
+				keys = append(keys, k)
+			}
+			sort.Strings(keys)
+			return keys, nil
+		},
+	})
+
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	obj, err := tmpl.NewInstance(ctx)
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("row", obj))
+
+	val, err := ctx.RunScript(`
+		row.name = "v8go";
+		row.own = 1;
+		delete row.id;
+		[Object.keys(row).join(), row.name, "name" in row, "id" in row, row.own].join("|")
+	`, "row.js")
+	fatalIf(t, err)
+	if want := "own,name|v8go|true|false|1"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+	if row["name"] != "v8go" || len(row) != 1 {
+		t.Errorf("unexpected row: %v", row)
+	}
+	if _, err := ctx.RunScript("row.fail", "fail.js"); err == nil || err.Error() != "no fail column" {
+		t.Errorf("expected the getter's error to be thrown, got %v", err)
+	}
+}
+
+func TestObjectTemplateSetIndexedPropertyHandler(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	items := []int32{10, 20, 30}
+	tmpl := v8.NewObjectTemplate(iso)
+	tmpl.SetIndexedPropertyHandler(v8.IndexedPropertyHandler{
+		Getter: func(info *v8.PropertyCallbackInfo) (*v8.Value, error) {
+			if int(info.Index()) >= len(items) {
+				return nil, nil
+			}
+			return v8.NewValue(iso, items[info.Index()])
+		},
+		Setter: func(info *v8.PropertyCallbackInfo, value *v8.Value) (bool, error) {
+			if int(info.Index()) >= len(items) {
+				return false, nil
+			}
+			items[info.Index()] = value.Int32()
+			return true, nil
+		},
+		Enumerator: func(info *v8.PropertyCallbackInfo) ([]uint32, error) {
+			idx := make([]uint32, len(items))
+			for i := range idx {
+				idx[i] = uint32(i)
+			}
+			return idx, nil
+		},
+	})
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	obj, err := tmpl.NewInstance(ctx)
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("items", obj))
+
+	val, err := ctx.RunScript("items[1] += 2; items[5] = 1; [Object.keys(items).join(), items[1], items[5]].join('|')", "items.js")
+	fatalIf(t, err)
+	if want := "5,0,1,2|22|1"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+	if items[1] != 22 {
+		t.Errorf("expected the setter to update the Go slice, got %v", items)
+	}
+}
@@ -0,0 +1,148 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import "unsafe"
+
+// AllocationProfile is a sampled profile of the heap allocations of an
+// isolate, see Isolate.StartSamplingHeapProfiler.
+type AllocationProfile struct {
+	// root is the root node of the call tree, which stands for an empty
+	// call stack.
+	root *AllocationProfileNode
+}
+
+// Returns the root node of the call tree.
+func (p *AllocationProfile) GetRootNode() *AllocationProfileNode {
+	return p.root
+}
+
+type AllocationProfileNode struct {
+	// The resource name for script from where the function originates.
+	scriptResourceName string
+
+	// The function name (empty string for anonymous functions.)
+	functionName string
+
+	// The number of the line where the function originates.
+	lineNumber int
+
+	// The number of the column where the function originates.
+	columnNumber int
+
+	// The bytes and number of the sampled objects allocated by the function
+	// itself, that are still alive.
+	selfSize  uint64
+	selfCount int
+
+	// The children node of this node.
+	children []*AllocationProfileNode
+
+	// The parent node of this node.
+	parent *AllocationProfileNode
+}
+
+// Returns function name (empty string for anonymous functions.)
+func (n *AllocationProfileNode) GetFunctionName() string {
+	return n.functionName
+}
+
+// Returns resource name for script from where the function originates.
+func (n *AllocationProfileNode) GetScriptResourceName() string {
+	return n.scriptResourceName
+}
+
+// Returns number of the line where the function originates.
+func (n *AllocationProfileNode) GetLineNumber() int {
+	return n.lineNumber
+}
+
+// Returns number of the column where the function originates.
+func (n *AllocationProfileNode) GetColumnNumber() int {
+	return n.columnNumber
+}
+
+// Returns the size in bytes of the live objects that the function itself
+// allocated, as estimated from the samples.
+func (n *AllocationProfileNode) GetSelfSize() uint64 {
+	return n.selfSize
+}
+
+// Returns the number of sampled live objects that the function itself
+// allocated.
+func (n *AllocationProfileNode) GetSelfCount() int {
+	return n.selfCount
+}
+
+// Returns the size in bytes of the live objects that the function and its
+// callees allocated.
+func (n *AllocationProfileNode) GetTotalSize() uint64 {
+	size := n.selfSize
+	for _, child := range n.children {
+		size += child.GetTotalSize()
+	}
+	return size
+}
+
+// Retrieves the ancestor node, or nil if the root.
+func (n *AllocationProfileNode) GetParent() *AllocationProfileNode {
+	return n.parent
+}
+
+func (n *AllocationProfileNode) GetChildrenCount() int {
+	return len(n.children)
+}
+
+// Retrieves a child node by index.
+func (n *AllocationProfileNode) GetChild(index int) *AllocationProfileNode {
+	return n.children[index]
+}
+
+// StartSamplingHeapProfiler starts sampling the heap allocations of the
+// isolate, about one every sampleInterval bytes, recording call stacks of up
+// to stackDepth frames. Its overhead is low enough to leave it running. It
+// returns false if the sampling heap profiler is running already.
+func (i *Isolate) StartSamplingHeapProfiler(sampleInterval uint64, stackDepth int) bool {
+	return C.IsolateStartSamplingHeapProfiler(i.ptr, C.uint64_t(sampleInterval), C.int(stackDepth)) != 0
+}
+
+// StopSamplingHeapProfiler stops the sampling heap profiler, discarding its
+// samples.
+func (i *Isolate) StopSamplingHeapProfiler() {
+	C.IsolateStopSamplingHeapProfiler(i.ptr)
+}
+
+// GetAllocationProfile returns the profile of the sampled allocations that are
+// still alive, or nil if the sampling heap profiler is not running.
+func (i *Isolate) GetAllocationProfile() *AllocationProfile {
+	root := C.IsolateGetAllocationProfile(i.ptr)
+	if root == nil {
+		return nil
+	}
+	defer C.AllocationProfileNodeDelete(root)
+	return &AllocationProfile{root: newAllocationProfileNode(root, nil)}
+}
+
+func newAllocationProfileNode(node *C.AllocationProfileNode, parent *AllocationProfileNode) *AllocationProfileNode {
+	n := &AllocationProfileNode{
+		scriptResourceName: C.GoString(node.scriptResourceName),
+		functionName:       C.GoString(node.functionName),
+		lineNumber:         int(node.lineNumber),
+		columnNumber:       int(node.columnNumber),
+		selfSize:           uint64(node.selfSize),
+		selfCount:          int(node.selfCount),
+		parent:             parent,
+	}
+	if node.childrenCount > 0 {
+		children := (*[1 << 28]*C.AllocationProfileNode)(unsafe.Pointer(node.children))[:node.childrenCount:node.childrenCount]
+		n.children = make([]*AllocationProfileNode, len(children))
+		for i, child := range children {
+			n.children[i] = newAllocationProfileNode(child, n)
+		}
+	}
+	return n
+}
@@ -0,0 +1,74 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func findAllocationNode(n *v8.AllocationProfileNode, name string) *v8.AllocationProfileNode {
+	if n.GetFunctionName() == name {
+		return n
+	}
+	for i := 0; i < n.GetChildrenCount(); i++ {
+		if found := findAllocationNode(n.GetChild(i), name); found != nil {
+			return found
+		}
+	}
+	return nil
+}
+
+func TestSamplingHeapProfiler(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	if iso.GetAllocationProfile() != nil {
+		t.Error("expected no allocation profile before the profiler is started")
+	}
+	if !iso.StartSamplingHeapProfiler(1024, 16) {
+		t.Fatal("expected the sampling heap profiler to start")
+	}
+	if iso.StartSamplingHeapProfiler(1024, 16) {
+		t.Error("expected the sampling heap profiler to be running already")
+	}
+
+	_, err := ctx.RunScript(`
+var kept = [];
+function allocateHot() {
+  for (let i = 0; i < 1e4; i++) kept.push({i, s: "x" + i});
+}
+allocateHot();`, "hot.js")
+	fatalIf(t, err)
+
+	profile := iso.GetAllocationProfile()
+	if profile == nil {
+		t.Fatal("expected an allocation profile")
+	}
+	root := profile.GetRootNode()
+	if root.GetParent() != nil || root.GetTotalSize() == 0 {
+		t.Fatalf("unexpected root node, %d bytes", root.GetTotalSize())
+	}
+	hot := findAllocationNode(root, "allocateHot")
+	if hot == nil {
+		t.Fatal("expected a node for allocateHot")
+	}
+	if hot.GetScriptResourceName() != "hot.js" || hot.GetLineNumber() != 3 {
+		t.Errorf("unexpected location %s:%d", hot.GetScriptResourceName(), hot.GetLineNumber())
+	}
+	if hot.GetSelfSize() == 0 || hot.GetSelfCount() == 0 {
+		t.Errorf("expected allocateHot to allocate, got %d bytes in %d objects", hot.GetSelfSize(), hot.GetSelfCount())
+	}
+
+	iso.StopSamplingHeapProfiler()
+	if iso.GetAllocationProfile() != nil {
+		t.Error("expected no allocation profile once the profiler is stopped")
+	}
+}
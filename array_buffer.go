@@ -0,0 +1,112 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"unsafe"
+)
+
+// ArrayBuffer is a JavaScript ArrayBuffer. Its memory is outside of both the
+// Go and the JS heap, and can be read and written from Go without copying with
+// Bytes.
+type ArrayBuffer struct {
+	*Object
+}
+
+// ArrayBufferView is a view on an ArrayBuffer, i.e. a TypedArray such as a
+// Uint8Array, or a DataView.
+type ArrayBufferView struct {
+	*Object
+}
+
+// NewArrayBuffer creates a zero-filled ArrayBuffer of byteLength bytes in the
+// given context.
+func NewArrayBuffer(ctx *Context, byteLength int) (*ArrayBuffer, error) {
+	return newArrayBuffer(ctx, nil, byteLength)
+}
+
+// NewArrayBufferFromBytes creates an ArrayBuffer in the given context that
+// holds a copy of data. The copy is made once, straight into the memory that
+// becomes the backing store of the buffer.
+func NewArrayBufferFromBytes(ctx *Context, data []byte) (*ArrayBuffer, error) {
+	if len(data) == 0 {
+		return newArrayBuffer(ctx, nil, 0)
+	}
+	return newArrayBuffer(ctx, unsafe.Pointer(&data[0]), len(data))
+}
+
+func newArrayBuffer(ctx *Context, data unsafe.Pointer, byteLength int) (*ArrayBuffer, error) {
+	if ctx == nil {
+		return nil, errors.New("v8go: Context is required")
+	}
+	if byteLength < 0 {
+		return nil, errors.New("v8go: ArrayBuffer length must not be negative")
+	}
+	rtn := C.NewArrayBuffer(ctx.ptr, data, C.size_t(byteLength))
+	val, err := valueResult(ctx, rtn)
+	if err != nil {
+		return nil, err
+	}
+	return &ArrayBuffer{&Object{val}}, nil
+}
+
+// AsArrayBuffer will cast the value to the ArrayBuffer type. If the value is
+// not an ArrayBuffer then an error is returned.
+func (v *Value) AsArrayBuffer() (*ArrayBuffer, error) {
+	if !v.IsArrayBuffer() {
+		return nil, errors.New("v8go: value is not an ArrayBuffer")
+	}
+	return &ArrayBuffer{&Object{v}}, nil
+}
+
+// AsArrayBufferView will cast the value to the ArrayBufferView type. If the
+// value is not a TypedArray or DataView then an error is returned.
+func (v *Value) AsArrayBufferView() (*ArrayBufferView, error) {
+	if !v.IsArrayBufferView() {
+		return nil, errors.New("v8go: value is not an ArrayBufferView")
+	}
+	return &ArrayBufferView{&Object{v}}, nil
+}
+
+// ByteLength returns the length of the buffer in bytes.
+func (ab *ArrayBuffer) ByteLength() int {
+	return int(C.ValueArrayBufferContents(ab.ptr).byteLength)
+}
+
+// Bytes returns the contents of the buffer, without copying them. Writes to
+// the slice are seen by JS and vice versa. The slice must not be used once the
+// buffer's value has been released or its context closed.
+func (ab *ArrayBuffer) Bytes() []byte {
+	return arrayBufferBytes(C.ValueArrayBufferContents(ab.ptr))
+}
+
+// Buffer returns the ArrayBuffer that the view is on.
+func (v *ArrayBufferView) Buffer() *ArrayBuffer {
+	ptr := C.ArrayBufferViewBuffer(v.ptr)
+	return &ArrayBuffer{&Object{newValue(v.ctx, ptr)}}
+}
+
+// ByteLength returns the length of the view in bytes.
+func (v *ArrayBufferView) ByteLength() int {
+	return int(C.ValueArrayBufferContents(v.ptr).byteLength)
+}
+
+// Bytes returns the part of the underlying buffer that the view is on, without
+// copying it, in the same way as ArrayBuffer.Bytes.
+func (v *ArrayBufferView) Bytes() []byte {
+	return arrayBufferBytes(C.ValueArrayBufferContents(v.ptr))
+}
+
+func arrayBufferBytes(c C.ArrayBufferContents) []byte {
+	if c.byteLength == 0 {
+		return []byte{}
+	}
+	n := int(c.byteLength)
+	return (*[1 << 40]byte)(c.data)[:n:n]
+}
@@ -0,0 +1,94 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"bytes"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestArrayBuffer(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	if _, err := v8.NewArrayBuffer(nil, 1); err == nil {
+		t.Error("expected error but got <nil>")
+	}
+
+	ab, err := v8.NewArrayBufferFromBytes(ctx, []byte{1, 2, 3, 4})
+	fatalIf(t, err)
+	if !ab.IsArrayBuffer() {
+		t.Error("expected an ArrayBuffer")
+	}
+	if ab.ByteLength() != 4 {
+		t.Errorf("unexpected byte length: %d", ab.ByteLength())
+	}
+	fatalIf(t, ctx.Global().Set("ab", ab))
+
+	// Writes from JS are seen through the slice, and vice versa.
+	b := ab.Bytes()
+	_, err = ctx.RunScript("new Uint8Array(ab)[0] = 42", "ab.js")
+	fatalIf(t, err)
+	if !bytes.Equal(b, []byte{42, 2, 3, 4}) {
+		t.Errorf("unexpected bytes: %v", b)
+	}
+	b[3] = 7
+	sum, err := ctx.RunScript("new Uint8Array(ab).reduce((a,b) => a+b)", "ab.js")
+	fatalIf(t, err)
+	if sum.Int32() != 42+2+3+7 {
+		t.Errorf("unexpected sum: %v", sum)
+	}
+
+	empty, err := v8.NewArrayBuffer(ctx, 0)
+	fatalIf(t, err)
+	if b := empty.Bytes(); b == nil || len(b) != 0 {
+		t.Errorf("expected empty slice, got %v", b)
+	}
+	zeroed, err := v8.NewArrayBuffer(ctx, 16)
+	fatalIf(t, err)
+	if !bytes.Equal(zeroed.Bytes(), make([]byte, 16)) {
+		t.Errorf("expected zeroed bytes, got %v", zeroed.Bytes())
+	}
+}
+
+func TestArrayBufferView(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript("new Uint8Array([0, 1, 2, 3, 4, 5]).subarray(2, 5)", "view.js")
+	fatalIf(t, err)
+	if _, err := val.AsArrayBuffer(); err == nil {
+		t.Error("expected error but got <nil>")
+	}
+	view, err := val.AsArrayBufferView()
+	fatalIf(t, err)
+	if !bytes.Equal(view.Bytes(), []byte{2, 3, 4}) {
+		t.Errorf("unexpected bytes: %v", view.Bytes())
+	}
+	if view.ByteLength() != 3 {
+		t.Errorf("unexpected byte length: %d", view.ByteLength())
+	}
+	if n := view.Buffer().ByteLength(); n != 6 {
+		t.Errorf("unexpected buffer byte length: %d", n)
+	}
+
+	val, err = ctx.RunScript("new Float64Array(1024).fill(1)", "view.js")
+	fatalIf(t, err)
+	view, err = val.AsArrayBufferView()
+	fatalIf(t, err)
+	if n := len(view.Bytes()); n != 8*1024 {
+		t.Errorf("unexpected length: %d", n)
+	}
+}
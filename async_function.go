@@ -0,0 +1,119 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"sync"
+)
+
+// AsyncFunctionCallback is called for each call of a function created from
+// NewAsyncFunctionTemplate, on the goroutine running the JavaScript. It reads
+// the arguments it needs from info and returns the work to do on a goroutine
+// of its own; an error rejects the promise of the call right away.
+type AsyncFunctionCallback func(info *FunctionCallbackInfo) (AsyncWork, error)
+
+// AsyncWork is the Go side of an async function call, such as I/O. It runs on
+// a goroutine of its own and must not use the isolate. The promise of the call
+// is resolved with its result, converted as by Context.Import, or rejected with
+// its error, at the next microtask checkpoint of the context after it returns.
+type AsyncWork func() (interface{}, error)
+
+// asyncQueue holds the async function calls of a context that are in flight,
+// and those that have returned and wait for their promise to be settled.
+type asyncQueue struct {
+	mutex   sync.Mutex
+	pending int
+	done    []*asyncCall
+	// ready has a value once calls are done, for RunEventLoop to wake up.
+	ready chan struct{}
+}
+
+// asyncValue is the result of AsyncWork that creates the value of the
+// promise itself when it is settled, such as an ArrayBuffer that adopts
+// memory filled by the work, rather than having it converted by Import; an
+// error rejects the promise with it.
+type asyncValue func(ctx *Context) (*Value, error)
+
+type asyncCall struct {
+	resolver *PromiseResolver
+	result   interface{}
+	err      error
+}
+
+// NewAsyncFunctionTemplate creates a FunctionTemplate for functions that
+// return a promise right away and do the work of callback on a goroutine, so
+// that an isolate can have any number of calls, such as I/O, in flight while
+// it runs JavaScript. The promises are settled by the microtask checkpoints of
+// their context, see Context.RunEventLoop.
+func NewAsyncFunctionTemplate(iso *Isolate, callback AsyncFunctionCallback, opts ...FunctionTemplateOption) *FunctionTemplate {
+	if callback == nil {
+		panic("nil AsyncFunctionCallback argument not supported")
+	}
+	return NewFunctionTemplateWithError(iso, func(info *FunctionCallbackInfo) (*Value, error) {
+		ctx := info.Context()
+		resolver, err := NewPromiseResolver(ctx)
+		if err != nil {
+			return nil, err
+		}
+		work, err := callback(info)
+		if err != nil {
+			resolver.Reject(errorValue(ctx, err))
+			return resolver.GetPromise().Value, nil
+		}
+		call := &asyncCall{resolver: resolver}
+		ctx.async.start()
+		go func() {
+			call.result, call.err = work()
+			ctx.async.finish(call)
+		}()
+		return resolver.GetPromise().Value, nil
+	}, opts...)
+}
+
+func (q *asyncQueue) start() {
+	q.mutex.Lock()
+	q.pending++
+	if q.ready == nil {
+		q.ready = make(chan struct{}, 1)
+	}
+	q.mutex.Unlock()
+}
+
+func (q *asyncQueue) finish(call *asyncCall) {
+	q.mutex.Lock()
+	q.done = append(q.done, call)
+	q.mutex.Unlock()
+	select {
+	case q.ready <- struct{}{}:
+	default:
+	}
+}
+
+// settle resolves or rejects the promises of the calls that have returned,
+// and reports how many calls remain in flight.
+func (q *asyncQueue) settle(ctx *Context) int {
+	q.mutex.Lock()
+	done := q.done
+	q.done = nil
+	q.pending -= len(done)
+	pending := q.pending
+	q.mutex.Unlock()
+	for _, call := range done {
+		if call.err == nil {
+			var val *Value
+			if f, ok := call.result.(asyncValue); ok {
+				val, call.err = f(ctx)
+			} else {
+				val, call.err = ctx.Import(call.result)
+			}
+			if call.err == nil {
+				call.resolver.Resolve(val)
+				continue
+			}
+		}
+		call.resolver.Reject(errorValue(ctx, call.err))
+	}
+	return pending
+}
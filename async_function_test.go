@@ -0,0 +1,90 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"context"
+	"errors"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestAsyncFunctionTemplate(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	fetch := v8.NewAsyncFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) (v8.AsyncWork, error) {
+		key := info.Args()[0].String()
+		if key == "" {
+			return nil, errors.New("no key")
+		}
+		return func() (interface{}, error) {
+			time.Sleep(50 * time.Millisecond)
+			if key == "missing" {
+				return nil, errors.New("not found: " + key)
+			}
+			return map[string]interface{}{"key": key}, nil
+		}, nil
+	})
+	global := v8.NewObjectTemplate(iso)
+	fatalIf(t, global.Set("fetch", fetch))
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+
+	start := time.Now()
+	_, err := ctx.RunScript(`
+		var keys = [];
+		for (let i = 0; i < 20; i++) keys.push(fetch("k" + i).then(v => v.key));
+		Promise.all(keys).then(v => { keys = v.join() });
+		var errs = [];
+		fetch("missing").catch(e => errs.push(e.message));
+		fetch("").catch(e => errs.push(e.message));
+	`, "fetch.js")
+	fatalIf(t, err)
+	fatalIf(t, ctx.RunEventLoop(context.Background()))
+	if elapsed := time.Since(start); elapsed > 900*time.Millisecond {
+		t.Errorf("expected the calls to be in flight at once, took %v", elapsed)
+	}
+
+	val, err := ctx.RunScript("keys", "keys.js")
+	fatalIf(t, err)
+	if want := "k0,k1,k2,k3,k4,k5,k6,k7,k8,k9,k10,k11,k12,k13,k14,k15,k16,k17,k18,k19"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+	val, err = ctx.RunScript("errs.sort().join()", "errs.js")
+	fatalIf(t, err)
+	if want := "no key,not found: missing"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+}
+
+func TestAsyncFunctionTemplateEventLoopCanceled(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	release := make(chan struct{})
+	defer close(release)
+	wait := v8.NewAsyncFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) (v8.AsyncWork, error) {
+		return func() (interface{}, error) {
+			<-release
+			return nil, nil
+		}, nil
+	})
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	fatalIf(t, ctx.Global().Set("wait", wait.GetFunction(ctx)))
+	_, err := ctx.RunScript("wait()", "wait.js")
+	fatalIf(t, err)
+
+	cctx, cancel := context.WithTimeout(context.Background(), 20*time.Millisecond)
+	defer cancel()
+	if err := ctx.RunEventLoop(cctx); err != context.DeadlineExceeded {
+		t.Errorf("expected context.DeadlineExceeded, got %v", err)
+	}
+}
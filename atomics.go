@@ -0,0 +1,38 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+
+// DisallowAtomicsWait is an IsolateOption that makes Atomics.wait throw a
+// TypeError in the isolate, rather than block its thread, as it does on the
+// main thread of browsers. Atomics.waitAsync is still allowed.
+var DisallowAtomicsWait IsolateOption = isolateOptionFunc(func(opts *isolateOptions) {
+	opts.disallowAtomicsWait = true
+})
+
+// AtomicsWaitAsync is a ContextOption that makes Context.RunEventLoop wait
+// for the promises of Atomics.waitAsync in the context to settle, which they
+// do once another isolate that shares the SharedArrayBuffer, see
+// NewSharedArrayBuffer, calls Atomics.notify on it, or once they time out.
+// The loop checks for them every millisecond.
+var AtomicsWaitAsync ContextOption = contextOptionFunc(func(opts *contextOptions) {
+	opts.atomicsWaitAsync = true
+})
+
+// atomicsWaitAsyncPoll is the period in milliseconds at which RunEventLoop
+// checks for the promises of Atomics.waitAsync.
+const atomicsWaitAsyncPoll = 1
+
+// WakeAtomicsWait stops the Atomics.wait that the isolate is blocked in, if
+// any, which returns "ok" to the script as if it had been notified, and
+// returns whether there was one. It can be called from any goroutine, to let the isolate get on with
+// something else without terminating its script. TerminateExecution, and so
+// the deadlines of RunScriptWithTimeout and RunScriptContext, stop a wait as
+// well.
+func (i *Isolate) WakeAtomicsWait() bool {
+	return C.IsolateWakeAtomicsWait(i.ptr) != 0
+}
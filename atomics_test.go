@@ -0,0 +1,151 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"context"
+	"strings"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+// sharedContext creates a context whose global sab is a SharedArrayBuffer on
+// store, and i32 an Int32Array on it.
+func sharedContext(t *testing.T, store *v8.SharedBackingStore, opt ...v8.IsolateOption) *v8.Context {
+	t.Helper()
+	iso := v8.NewIsolate(opt...)
+	ctx := v8.NewContext(iso, v8.AtomicsWaitAsync)
+	t.Cleanup(func() {
+		ctx.Close()
+		iso.Dispose()
+	})
+	sab, err := v8.NewSharedArrayBuffer(ctx, store)
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("sab", sab))
+	_, err = ctx.RunScript(`const i32 = new Int32Array(sab)`, "shared.js")
+	fatalIf(t, err)
+	return ctx
+}
+
+func TestAtomicsWait(t *testing.T) {
+	t.Parallel()
+
+	store, err := v8.NewSharedBackingStore(16)
+	fatalIf(t, err)
+	waiter := sharedContext(t, store)
+	notifier := sharedContext(t, store)
+
+	// A wait that another isolate notifies.
+	done := make(chan string)
+	go func() {
+		val, err := waiter.RunScript(`Atomics.wait(i32, 0, 0)`, "wait.js")
+		if err != nil {
+			done <- err.Error()
+			return
+		}
+		done <- val.String()
+	}()
+	deadline := time.Now().Add(10 * time.Second)
+	for {
+		val, err := notifier.RunScript(`Atomics.store(i32, 0, 1); Atomics.notify(i32, 0)`, "notify.js")
+		fatalIf(t, err)
+		if val.Int32() == 1 {
+			break
+		}
+		// Not waiting yet; the value is put back for the wait to block.
+		_, err = notifier.RunScript(`Atomics.store(i32, 0, 0)`, "reset.js")
+		fatalIf(t, err)
+		if time.Now().After(deadline) {
+			t.Fatal("the wait never started")
+		}
+		time.Sleep(time.Millisecond)
+	}
+	if got := <-done; got != "ok" {
+		t.Errorf("expected the wait to be notified, got %q", got)
+	}
+
+	// A wait that Go stops.
+	_, err = waiter.RunScript(`Atomics.store(i32, 0, 0)`, "reset.js")
+	fatalIf(t, err)
+	go func() {
+		val, err := waiter.RunScript(`Atomics.wait(i32, 0, 0)`, "wait.js")
+		if err != nil {
+			done <- err.Error()
+			return
+		}
+		done <- val.String()
+	}()
+	for !waiter.Isolate().WakeAtomicsWait() {
+		time.Sleep(time.Millisecond)
+	}
+	if got := <-done; got != "ok" {
+		t.Errorf("expected the wait to be stopped, got %q", got)
+	}
+	if waiter.Isolate().WakeAtomicsWait() {
+		t.Error("expected no wait in progress")
+	}
+
+	// A wait that a deadline terminates.
+	start := time.Now()
+	_, err = waiter.RunScriptWithTimeout(`Atomics.wait(i32, 0, 0)`, "wait.js", 50*time.Millisecond)
+	if err != context.DeadlineExceeded {
+		t.Errorf("expected the wait to be terminated, got %v", err)
+	}
+	if elapsed := time.Since(start); elapsed > 5*time.Second {
+		t.Errorf("expected the wait to be terminated in time, took %v", elapsed)
+	}
+	val, err := waiter.RunScript(`Atomics.load(i32, 0)`, "after.js")
+	fatalIf(t, err)
+	if val.Int32() != 0 {
+		t.Errorf("expected the isolate to run again, got %v", val)
+	}
+}
+
+func TestAtomicsWaitAsync(t *testing.T) {
+	t.Parallel()
+
+	store, err := v8.NewSharedBackingStore(16)
+	fatalIf(t, err)
+	waiter := sharedContext(t, store)
+	notifier := sharedContext(t, store)
+
+	_, err = waiter.RunScript(`
+		const results = [];
+		Atomics.waitAsync(i32, 0, 0).value.then((v) => results.push(v));
+		Atomics.waitAsync(i32, 1, 0, 20).value.then((v) => results.push(v));
+	`, "wait.js")
+	fatalIf(t, err)
+	go func() {
+		time.Sleep(50 * time.Millisecond)
+		notifier.RunScript(`Atomics.store(i32, 0, 1); Atomics.notify(i32, 0)`, "notify.js")
+	}()
+	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Second)
+	defer cancel()
+	fatalIf(t, waiter.RunEventLoop(ctx))
+	val, err := waiter.RunScript(`results.join()`, "results.js")
+	fatalIf(t, err)
+	if got := val.String(); got != "timed-out,ok" {
+		t.Errorf("expected the waits to time out and be notified in turn, got %q", got)
+	}
+}
+
+func TestDisallowAtomicsWait(t *testing.T) {
+	t.Parallel()
+
+	store, err := v8.NewSharedBackingStore(16)
+	fatalIf(t, err)
+	ctx := sharedContext(t, store, v8.DisallowAtomicsWait)
+	_, err = ctx.RunScript(`Atomics.wait(i32, 0, 0)`, "wait.js")
+	if err == nil || !strings.Contains(err.Error(), "Atomics.wait") {
+		t.Errorf("expected Atomics.wait to be disallowed, got %v", err)
+	}
+	val, err := ctx.RunScript(`Atomics.waitAsync(i32, 0, 1).value`, "wait.js")
+	fatalIf(t, err)
+	if val.String() != "not-equal" {
+		t.Errorf("expected Atomics.waitAsync to be allowed, got %v", val)
+	}
+}
@@ -0,0 +1,86 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A stand-in for the header that cgo generates for the functions that v8go
+// exports from Go, so that v8go.cc can be built without Go. It must declare
+// the same functions as the generated header; the native benchmarks define
+// them as stubs that are never called.
+
+#ifndef V8GO_BENCH_CGO_EXPORT_H
+#define V8GO_BENCH_CGO_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long long GoInt;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct goPropertyCallback_return {
+  ValuePtr r0;
+  ValuePtr r1;
+  int r2;
+};
+extern struct goPropertyCallback_return goPropertyCallback(GoInt ctxref,
+                                                           GoInt cbref,
+                                                           int op,
+                                                           ValuePtr self,
+                                                           char* key,
+                                                           int keyLength,
+                                                           uint32_t index,
+                                                           ValuePtr value);
+extern int64_t goCPUBudgetExceeded(int ref, int64_t used);
+extern int goDynamicImport(GoInt ctxref,
+                           char* specifier,
+                           int specifierLen,
+                           char* referrer,
+                           int referrerLen,
+                           ValuePtr resolver);
+extern double goFastFunctionCallback(IsolatePtr iso,
+                                     GoInt cbref,
+                                     FastCallbackArgs* args);
+
+struct goFunctionCallback_return {
+  ValuePtr r0;
+  ValuePtr r1;
+};
+extern struct goFunctionCallback_return goFunctionCallback(
+    GoInt ctxref,
+    GoInt cbref,
+    ValuePtr* thisAndArgs,
+    GoInt argsCount);
+
+struct goPackedFunctionCallback_return {
+  ValuePtr r0;
+  ValuePtr r1;
+};
+extern struct goPackedFunctionCallback_return goPackedFunctionCallback(
+    GoInt ctxref,
+    GoInt cbref,
+    CallbackInfoPtr cinfo,
+    CallbackArg* args,
+    GoInt argsCount);
+extern void goHeapLimitReached(IsolatePtr iso, size_t current, size_t initial);
+extern int goHeapSnapshotWrite(int ref, char* data, int size);
+extern void goInspectorMessage(int ref, char* data, int size);
+
+struct goResolveModule_return {
+  ModulePtr r0;
+  ValuePtr r1;
+};
+extern struct goResolveModule_return goResolveModule(GoInt ctxref,
+                                                     GoInt resolverref,
+                                                     char* specifier,
+                                                     int specifierLen,
+                                                     ModulePtr referrer);
+extern GoInt goStreamingSourceRead(GoInt ref, uint8_t* buf, GoInt length);
+extern int goTraceWrite(char* data, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Benchmarks of the shim in v8go.cc on its own, without cgo, to tell a
+// regression of the shim from one of V8 or of cgo. v8go.cc is built into this
+// translation unit, so that its static helpers can be measured directly. The
+// results are printed in the format of go test, for benchstat.
+//
+// Usage: bench [-count n] [-benchtime seconds] [substring of benchmark names]
+
+#include "../../v8go.cc"
+
+/********** Go exports **********/
+
+// The functions that v8go.cc calls in Go; no benchmark calls into Go.
+
+extern "C" {
+
+static void goUnreachable(const char* name) {
+  fprintf(stderr, "bench: %s called without Go\n", name);
+  abort();
+}
+
+struct goPropertyCallback_return goPropertyCallback(GoInt, GoInt, int,
+                                                    ValuePtr, char*, int,
+                                                    uint32_t, ValuePtr) {
+  goUnreachable("goPropertyCallback");
+  return {};
+}
+
+int64_t goCPUBudgetExceeded(int, int64_t) {
+  goUnreachable("goCPUBudgetExceeded");
+  return 0;
+}
+
+int goDynamicImport(GoInt, char*, int, char*, int, ValuePtr) {
+  goUnreachable("goDynamicImport");
+  return 0;
+}
+
+double goFastFunctionCallback(IsolatePtr, GoInt, FastCallbackArgs*) {
+  goUnreachable("goFastFunctionCallback");
+  return 0;
+}
+
+struct goFunctionCallback_return goFunctionCallback(GoInt, GoInt, ValuePtr*,
+                                                    GoInt) {
+  goUnreachable("goFunctionCallback");
+  return {};
+}
+
+struct goPackedFunctionCallback_return
+goPackedFunctionCallback(GoInt, GoInt, CallbackInfoPtr, CallbackArg*, GoInt) {
+  goUnreachable("goPackedFunctionCallback");
+  return {};
+}
+
+void goHeapLimitReached(IsolatePtr, size_t, size_t) {
+  goUnreachable("goHeapLimitReached");
+}
+
+void goInspectorMessage(int, char*, int) {
+  goUnreachable("goInspectorMessage");
+}
+
+int goHeapSnapshotWrite(int, char*, int) {
+  goUnreachable("goHeapSnapshotWrite");
+  return 0;
+}
+
+struct goResolveModule_return goResolveModule(GoInt, GoInt, char*, int,
+                                              ModulePtr) {
+  goUnreachable("goResolveModule");
+  return {};
+}
+
+GoInt goStreamingSourceRead(GoInt, uint8_t*, GoInt) {
+  goUnreachable("goStreamingSourceRead");
+  return 0;
+}
+
+int goTraceWrite(char*, int) {
+  goUnreachable("goTraceWrite");
+  return 0;
+}
+}
+
+/********** Harness **********/
+
+namespace {
+
+// keep stops the compiler from optimizing away the computation of p.
+template <typename T>
+inline void keep(T const& p) {
+  asm volatile("" : : "g"(&p) : "memory");
+}
+
+struct benchmark {
+  std::string name;
+  // run runs n iterations of the benchmark.
+  std::function<void(int64_t n)> run;
+};
+
+double benchtime = 1;
+
+// measure runs b with a growing number of iterations until it takes
+// benchtime, like go test does, and prints the time per iteration.
+void measure(const benchmark& b) {
+  using clock = std::chrono::steady_clock;
+  int64_t n = 1;
+  for (;;) {
+    clock::time_point start = clock::now();
+    b.run(n);
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    if (elapsed >= benchtime || n >= 1000000000) {
+      printf("Benchmark%s\t%10lld\t%12.2f ns/op\n", b.name.c_str(),
+             (long long)n, elapsed * 1e9 / n);
+      fflush(stdout);
+      return;
+    }
+    // Aim for 20% over benchtime, growing at most a hundredfold at a time.
+    double next = elapsed > 0 ? n * benchtime * 1.2 / elapsed : n * 100.0;
+    n = std::max(n + 1, std::min<int64_t>((int64_t)next, n * 100));
+  }
+}
+
+/********** Benchmarks **********/
+
+// localValueScope enters the scopes of val, as each function on a value does.
+__attribute__((noinline)) void localValueScope(ValuePtr val) {
+  LOCAL_VALUE(val);
+  keep(value);
+}
+
+void benchLocalValueScope(ContextPtr ctx, int64_t n) {
+  ValuePtr val = NewValueInteger(ctx->iso, 1);
+  for (int64_t i = 0; i < n; i++) {
+    localValueScope(val);
+  }
+  ValueRelease(val, val->gen);
+}
+
+// benchExceptionError formats an exception for Go, or with lazy keeps it for
+// Go to format, see IsolateOptions.lazyErrors.
+void benchExceptionError(ContextPtr ctx, bool lazy, int64_t n) {
+  LOCAL_CONTEXT(ctx);
+  Local<String> src =
+      String::NewFromUtf8Literal(iso,
+                                 "function fail() { throw new Error('fail'); }\n"
+                                 "fail();");
+  ScriptOrigin origin(String::NewFromUtf8Literal(iso, "bench.js"));
+  Local<Script> script =
+      Script::Compile(local_ctx, src, &origin).ToLocalChecked();
+  if (!script->Run(local_ctx).IsEmpty()) {
+    goUnreachable("benchExceptionError");
+  }
+  isolateData(iso)->lazyErrors = lazy;
+  for (int64_t i = 0; i < n; i++) {
+    RtnError err = ExceptionError(try_catch, iso, local_ctx);
+    keep(err);
+    free((void*)err.msg);
+    free((void*)err.location);
+    free((void*)err.stack);
+    if (err.exception != nullptr) {
+      release_value(err.exception);
+    }
+  }
+  isolateData(iso)->lazyErrors = false;
+}
+
+void benchTrackedValue(ContextPtr ctx, int64_t n) {
+  LOCAL_CONTEXT(ctx);
+  Local<Value> v = Integer::New(iso, 1);
+  for (int64_t i = 0; i < n; i++) {
+    m_value* val = tracked_value(ctx, v);
+    keep(val);
+    release_value(val);
+  }
+}
+
+void benchCopyString(size_t length, int64_t n) {
+  std::string str(length, 'x');
+  for (int64_t i = 0; i < n; i++) {
+    const char* copy = CopyString(str);
+    keep(copy);
+    free((void*)copy);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int count = 1;
+  const char* filter = "";
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-count") == 0 && i + 1 < argc) {
+      count = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-benchtime") == 0 && i + 1 < argc) {
+      benchtime = atof(argv[++i]);
+    } else {
+      filter = argv[i];
+    }
+  }
+
+  PlatformOptions popts = {};
+  Init(popts);
+  IsolateOptions iopts = {};
+  IsolatePtr iso = NewIsolate(iopts);
+  ContextOptions copts = {};
+  ContextPtr ctx = NewContext(iso, nullptr, 0, copts);
+
+  std::vector<benchmark> benchmarks = {
+      {"LocalValueScope", [&](int64_t n) { benchLocalValueScope(ctx, n); }},
+      {"ExceptionError",
+       [&](int64_t n) { benchExceptionError(ctx, false, n); }},
+      {"ExceptionError/lazy",
+       [&](int64_t n) { benchExceptionError(ctx, true, n); }},
+      {"TrackedValue", [&](int64_t n) { benchTrackedValue(ctx, n); }},
+  };
+  for (size_t length : {16, 256, 4096}) {
+    benchmarks.push_back({"CopyString/" + std::to_string(length),
+                          [=](int64_t n) { benchCopyString(length, n); }});
+  }
+
+  printf("pkg: rogchap.com/v8go/bench/native\n");
+  for (const benchmark& b : benchmarks) {
+    if (b.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    for (int i = 0; i < count; i++) {
+      measure(b);
+    }
+  }
+
+  ContextFree(ctx);
+  IsolateDispose(iso);
+  return 0;
+}
@@ -0,0 +1,503 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"math"
+	"math/big"
+	"reflect"
+	"runtime"
+	"unsafe"
+)
+
+// Export converts the value, and all the values it contains, to Go with a
+// single call into V8:
+//
+//	undefined, null -> nil
+//	booleans        -> bool
+//	numbers         -> float64
+//	strings         -> string
+//	arrays          -> []interface{}
+//	other objects   -> map[string]interface{} of their own enumerable string-keyed properties
+//
+// Functions, symbols, BigInts, proxies and objects of built-in types other than
+// Object and Array, such as Date or Map, are not converted but returned as a
+// *Value. An error is returned if a getter throws or if the value contains
+// a cycle.
+func (v *Value) Export() (interface{}, error) {
+	rtn := C.ValueExport(v.ptr)
+	if rtn.data == nil {
+		return nil, newJSError(rtn.error)
+	}
+	defer C.free(unsafe.Pointer(rtn.data))
+	defer C.free(unsafe.Pointer(rtn.values))
+
+	d := bulkDecoder{
+		buf: (*[1 << 30]byte)(unsafe.Pointer(rtn.data))[:rtn.length:rtn.length],
+		ctx: v.ctx,
+	}
+	if rtn.valuesCount > 0 {
+		d.values = (*[1 << 28]C.ValuePtr)(unsafe.Pointer(rtn.values))[:rtn.valuesCount:rtn.valuesCount]
+	}
+	return d.decode(), nil
+}
+
+// KeyCollectionMode is whether the property names of an object include those
+// of its prototypes.
+type KeyCollectionMode int
+
+const (
+	// OwnOnly names the object's own properties only.
+	OwnOnly KeyCollectionMode = iota
+	// IncludePrototypes also names the properties of its prototype chain.
+	IncludePrototypes
+)
+
+// PropertyFilter selects the properties to name by their attributes. Its
+// values combine with |, and the zero value selects all properties.
+type PropertyFilter int
+
+const (
+	AllProperties    PropertyFilter = 0
+	OnlyWritable     PropertyFilter = C.PROPERTY_FILTER_ONLY_WRITABLE
+	OnlyEnumerable   PropertyFilter = C.PROPERTY_FILTER_ONLY_ENUMERABLE
+	OnlyConfigurable PropertyFilter = C.PROPERTY_FILTER_ONLY_CONFIGURABLE
+)
+
+// PropertyEntry is a property of an object, see Object.Entries.
+type PropertyEntry struct {
+	Name string
+	// Value is the value of the property, converted as by Export if it is a
+	// primitive; objects, including arrays, are a *Value.
+	Value interface{}
+}
+
+// OwnPropertyNames returns the names of the object's own properties that pass
+// the filter, in the order of Object.getOwnPropertyNames, with a single call
+// into V8. Array indices are named by their string; properties named by
+// symbols are left out.
+func (o *Object) OwnPropertyNames(filter PropertyFilter) ([]string, error) {
+	return o.PropertyNames(OwnOnly, filter)
+}
+
+// PropertyNames returns the names of the object's properties that pass the
+// filter, of its own or also of its prototypes as set by mode, like
+// OwnPropertyNames.
+func (o *Object) PropertyNames(mode KeyCollectionMode, filter PropertyFilter) ([]string, error) {
+	var names []string
+	err := o.properties(mode, filter, false, func(d *bulkDecoder) {
+		names = make([]string, d.arrayLength())
+		for i := range names {
+			names[i] = d.decode().(string)
+		}
+	})
+	return names, err
+}
+
+// Entries returns the names and values of the object's properties that pass
+// the filter, as PropertyNames names them, with a single call into V8 rather
+// than one for each property. An error is returned if a getter throws.
+func (o *Object) Entries(mode KeyCollectionMode, filter PropertyFilter) ([]PropertyEntry, error) {
+	var entries []PropertyEntry
+	err := o.properties(mode, filter, true, func(d *bulkDecoder) {
+		entries = make([]PropertyEntry, d.arrayLength())
+		for i := range entries {
+			entries[i].Name = d.decode().(string)
+			entries[i].Value = d.decode()
+		}
+	})
+	return entries, err
+}
+
+// properties calls decode with the result of ObjectPropertyNames.
+func (o *Object) properties(mode KeyCollectionMode, filter PropertyFilter, entries bool, decode func(d *bulkDecoder)) error {
+	cEntries := C.int(0)
+	if entries {
+		cEntries = 1
+	}
+	rtn := C.ObjectPropertyNames(o.ptr, C.int(mode), C.int(filter), cEntries)
+	return decodeBulk(o.ctx, rtn, decode)
+}
+
+// MapEntry is an entry of a Map, see Object.MapEntries.
+type MapEntry struct {
+	// Key and Value are converted as by Export if they are primitives;
+	// objects, including arrays, are a *Value.
+	Key   interface{}
+	Value interface{}
+}
+
+// MapEntries returns the entries of a Map in their insertion order, with a
+// single call into V8 rather than iterating the Map from JavaScript. An
+// error is returned if the object is not a Map.
+func (o *Object) MapEntries() ([]MapEntry, error) {
+	var entries []MapEntry
+	err := decodeBulk(o.ctx, C.ObjectCollectionEntries(o.ptr, 1), func(d *bulkDecoder) {
+		entries = make([]MapEntry, d.arrayLength()/2)
+		for i := range entries {
+			entries[i].Key = d.decode()
+			entries[i].Value = d.decode()
+		}
+	})
+	return entries, err
+}
+
+// SetValues returns the values of a Set in their insertion order, converted
+// like the keys of MapEntries, with a single call into V8. An error is
+// returned if the object is not a Set.
+func (o *Object) SetValues() ([]interface{}, error) {
+	var values []interface{}
+	err := decodeBulk(o.ctx, C.ObjectCollectionEntries(o.ptr, 0), func(d *bulkDecoder) {
+		values = d.decode().([]interface{})
+	})
+	return values, err
+}
+
+// decodeBulk calls decode with a decoder of rtn, unless it is an error, and
+// frees rtn.
+func decodeBulk(ctx *Context, rtn C.RtnBulk, decode func(d *bulkDecoder)) error {
+	if rtn.data == nil {
+		return newJSError(rtn.error)
+	}
+	defer C.free(unsafe.Pointer(rtn.data))
+	defer C.free(unsafe.Pointer(rtn.values))
+
+	d := bulkDecoder{
+		buf: (*[1 << 30]byte)(unsafe.Pointer(rtn.data))[:rtn.length:rtn.length],
+		ctx: ctx,
+	}
+	if rtn.valuesCount > 0 {
+		d.values = (*[1 << 28]C.ValuePtr)(unsafe.Pointer(rtn.values))[:rtn.valuesCount:rtn.valuesCount]
+	}
+	decode(&d)
+	return nil
+}
+
+// Import creates the JS value for a Go value with a single call into V8, the
+// reverse of Export:
+//
+//	nil                                      -> null
+//	bool                                     -> boolean
+//	int, int8-32, uint, uint8-32, float32/64 -> number
+//	int64, uint64, *big.Int                  -> BigInt, like NewValue
+//	string                                   -> string
+//	slices and arrays                        -> Array
+//	maps with string keys                    -> Object
+//	structs                                  -> Object
+//	Valuer                                   -> the value itself
+//
+// Object properties are created in the iteration order of the map. The
+// properties of the objects of a struct are its exported fields, in order,
+// named as set by a `v8:"name"` field tag, or else by the field's name; a
+// tag of "-" leaves the field out. The keys of a struct type are created once
+// per isolate, so that its objects are created without them, and share a
+// hidden class.
+func (c *Context) Import(v interface{}) (*Value, error) {
+	e := bulkEncoder{iso: c.iso}
+	if err := e.encode(v); err != nil {
+		return nil, err
+	}
+	var values *C.ValuePtr
+	if len(e.values) > 0 {
+		values = &e.values[0]
+	}
+	rtn := C.ContextImport(c.ptr, (*C.char)(unsafe.Pointer(&e.buf[0])), values)
+	// v holds the Values of e.values, which must not be released meanwhile.
+	runtime.KeepAlive(v)
+	return valueResult(c, rtn)
+}
+
+// bulkEncoder writes values in the bulk value format, see C.BulkTag.
+type bulkEncoder struct {
+	buf    []byte
+	values []C.ValuePtr
+	iso    *Isolate
+	depth  int
+}
+
+// bulkMaxDepth bounds the nesting of imported values, which also catches
+// maps and slices that contain themselves.
+const bulkMaxDepth = 1000
+
+func (e *bulkEncoder) tag(tag C.BulkTag) {
+	e.buf = append(e.buf, byte(tag))
+}
+
+func (e *bulkEncoder) uint32(n int) {
+	e.buf = append(e.buf, 0, 0, 0, 0)
+	binary.LittleEndian.PutUint32(e.buf[len(e.buf)-4:], uint32(n))
+}
+
+func (e *bulkEncoder) number(f float64) {
+	if i := int32(f); float64(i) == f && !(i == 0 && math.Signbit(f)) {
+		e.tag(C.BULK_INT32)
+		e.uint32(int(uint32(i)))
+		return
+	}
+	e.tag(C.BULK_NUMBER)
+	e.buf = append(e.buf, 0, 0, 0, 0, 0, 0, 0, 0)
+	binary.LittleEndian.PutUint64(e.buf[len(e.buf)-8:], math.Float64bits(f))
+}
+
+// int64 writes n as a BigInt, as NewValue creates it.
+func (e *bulkEncoder) int64(n int64) {
+	if n < 0 {
+		// -n wraps to itself for math.MinInt64, whose magnitude is the same.
+		e.bigInt(true, uint64(-n))
+		return
+	}
+	e.bigInt(false, uint64(n))
+}
+
+// bigInt writes a BigInt of the magnitude words, least significant first,
+// inline rather than as a value created with another call into V8.
+func (e *bulkEncoder) bigInt(negative bool, words ...uint64) {
+	e.tag(C.BULK_BIGINT)
+	if negative {
+		e.buf = append(e.buf, 1)
+	} else {
+		e.buf = append(e.buf, 0)
+	}
+	e.uint32(len(words))
+	for _, word := range words {
+		e.buf = append(e.buf, 0, 0, 0, 0, 0, 0, 0, 0)
+		binary.LittleEndian.PutUint64(e.buf[len(e.buf)-8:], word)
+	}
+}
+
+func (e *bulkEncoder) string(s string) {
+	e.uint32(len(s))
+	e.buf = append(e.buf, s...)
+}
+
+func (e *bulkEncoder) value(v *Value) {
+	e.tag(C.BULK_VALUE)
+	e.uint32(len(e.values))
+	e.values = append(e.values, v.ptr)
+}
+
+func (e *bulkEncoder) encode(v interface{}) error {
+	switch v := v.(type) {
+	case nil:
+		e.tag(C.BULK_NULL)
+	case bool:
+		if v {
+			e.tag(C.BULK_TRUE)
+		} else {
+			e.tag(C.BULK_FALSE)
+		}
+	case string:
+		e.tag(C.BULK_STRING)
+		e.string(v)
+	case int:
+		e.number(float64(v))
+	case int32:
+		e.number(float64(v))
+	case uint32:
+		e.number(float64(v))
+	case float64:
+		e.number(v)
+	case int64:
+		e.int64(v)
+	case uint64:
+		e.bigInt(false, v)
+	case *big.Int:
+		if v == nil {
+			e.tag(C.BULK_NULL)
+			return nil
+		}
+		words := make([]uint64, len(v.Bits()))
+		for i, word := range v.Bits() {
+			words[i] = uint64(word)
+		}
+		e.bigInt(v.Sign() < 0, words...)
+	case Valuer:
+		e.value(v.value())
+	case []interface{}:
+		if err := e.enter(); err != nil {
+			return err
+		}
+		e.tag(C.BULK_ARRAY)
+		e.uint32(len(v))
+		for _, elem := range v {
+			if err := e.encode(elem); err != nil {
+				return err
+			}
+		}
+		e.depth--
+	case map[string]interface{}:
+		if err := e.enter(); err != nil {
+			return err
+		}
+		e.tag(C.BULK_OBJECT)
+		e.uint32(len(v))
+		for key, prop := range v {
+			e.string(key)
+			if err := e.encode(prop); err != nil {
+				return err
+			}
+		}
+		e.depth--
+	default:
+		return e.encodeReflect(reflect.ValueOf(v))
+	}
+	return nil
+}
+
+// encodeReflect handles the types that encode does not have fast paths for.
+func (e *bulkEncoder) encodeReflect(rv reflect.Value) error {
+	switch rv.Kind() {
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32:
+		e.number(float64(rv.Int()))
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32:
+		e.number(float64(rv.Uint()))
+	case reflect.Float32, reflect.Float64:
+		e.number(rv.Float())
+	case reflect.Int64:
+		e.int64(rv.Int())
+	case reflect.Uint64:
+		e.bigInt(false, rv.Uint())
+	case reflect.Bool:
+		if rv.Bool() {
+			e.tag(C.BULK_TRUE)
+		} else {
+			e.tag(C.BULK_FALSE)
+		}
+	case reflect.String:
+		e.tag(C.BULK_STRING)
+		e.string(rv.String())
+	case reflect.Struct:
+		return e.encodeStruct(rv)
+	case reflect.Slice, reflect.Array:
+		if rv.Kind() == reflect.Slice && rv.IsNil() {
+			e.tag(C.BULK_NULL)
+			return nil
+		}
+		if err := e.enter(); err != nil {
+			return err
+		}
+		e.tag(C.BULK_ARRAY)
+		e.uint32(rv.Len())
+		for i := 0; i < rv.Len(); i++ {
+			if err := e.encode(rv.Index(i).Interface()); err != nil {
+				return err
+			}
+		}
+		e.depth--
+	case reflect.Map:
+		if rv.Type().Key().Kind() != reflect.String {
+			return fmt.Errorf("v8go: unsupported map key type `%s`", rv.Type().Key())
+		}
+		if rv.IsNil() {
+			e.tag(C.BULK_NULL)
+			return nil
+		}
+		if err := e.enter(); err != nil {
+			return err
+		}
+		e.tag(C.BULK_OBJECT)
+		e.uint32(rv.Len())
+		iter := rv.MapRange()
+		for iter.Next() {
+			e.string(iter.Key().String())
+			if err := e.encode(iter.Value().Interface()); err != nil {
+				return err
+			}
+		}
+		e.depth--
+	case reflect.Ptr, reflect.Interface:
+		if rv.IsNil() {
+			e.tag(C.BULK_NULL)
+			return nil
+		}
+		return e.encode(rv.Elem().Interface())
+	default:
+		return fmt.Errorf("v8go: unsupported value type `%s`", rv.Type())
+	}
+	return nil
+}
+
+func (e *bulkEncoder) enter() error {
+	e.depth++
+	if e.depth > bulkMaxDepth {
+		return errors.New("v8go: value is nested too deeply, or contains itself")
+	}
+	return nil
+}
+
+// bulkDecoder reads values in the bulk value format, see C.BulkTag; every
+// platform that v8go supports is little endian.
+type bulkDecoder struct {
+	buf    []byte
+	off    int
+	values []C.ValuePtr
+	ctx    *Context
+}
+
+func (d *bulkDecoder) uint32() uint32 {
+	n := binary.LittleEndian.Uint32(d.buf[d.off:])
+	d.off += 4
+	return n
+}
+
+// arrayLength reads the tag and length of a BULK_ARRAY.
+func (d *bulkDecoder) arrayLength() int {
+	d.off++
+	return int(d.uint32())
+}
+
+func (d *bulkDecoder) string() string {
+	n := int(d.uint32())
+	b := d.buf[d.off : d.off+n]
+	d.off += n
+	if d.ctx != nil && d.ctx.iso.interned != nil {
+		return d.ctx.iso.interned.internBytes(b)
+	}
+	return string(b)
+}
+
+func (d *bulkDecoder) decode() interface{} {
+	tag := d.buf[d.off]
+	d.off++
+	switch tag {
+	case C.BULK_UNDEFINED, C.BULK_NULL:
+		return nil
+	case C.BULK_FALSE:
+		return false
+	case C.BULK_TRUE:
+		return true
+	case C.BULK_INT32:
+		return float64(int32(d.uint32()))
+	case C.BULK_NUMBER:
+		n := math.Float64frombits(binary.LittleEndian.Uint64(d.buf[d.off:]))
+		d.off += 8
+		return n
+	case C.BULK_STRING:
+		return d.string()
+	case C.BULK_ARRAY:
+		elems := make([]interface{}, d.uint32())
+		for i := range elems {
+			elems[i] = d.decode()
+		}
+		return elems
+	case C.BULK_OBJECT:
+		count := int(d.uint32())
+		props := make(map[string]interface{}, count)
+		for i := 0; i < count; i++ {
+			key := d.string()
+			props[key] = d.decode()
+		}
+		return props
+	case C.BULK_VALUE:
+		return newValue(d.ctx, d.values[d.uint32()])
+	}
+	panic("v8go: invalid bulk value tag")
+}
@@ -0,0 +1,388 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"math"
+	"math/big"
+	"reflect"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestValueExport(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`({
+		a: 1, b: -2.5, c: "héllo", d: true, e: null, f: undefined,
+		g: [1, [2, "x"], {}], 7: "seven", [Symbol()]: "hidden",
+		h: { nested: { deep: false } },
+		fn() {}, date: new Date(0),
+	})`, "")
+	fatalIf(t, err)
+	got, err := val.Export()
+	fatalIf(t, err)
+
+	obj, ok := got.(map[string]interface{})
+	if !ok {
+		t.Fatalf("expected a map, got %T", got)
+	}
+	for _, key := range []string{"fn", "date"} {
+		v, ok := obj[key].(*v8.Value)
+		if !ok {
+			t.Errorf("expected %s to be a *Value, got %T", key, obj[key])
+			continue
+		}
+		if key == "fn" && !v.IsFunction() || key == "date" && !v.IsDate() {
+			t.Errorf("unexpected value for %s: %v", key, v)
+		}
+		delete(obj, key)
+	}
+	want := map[string]interface{}{
+		"a": float64(1), "b": -2.5, "c": "héllo", "d": true, "e": nil, "f": nil,
+		"g": []interface{}{float64(1), []interface{}{float64(2), "x"}, map[string]interface{}{}},
+		"7": "seven",
+		"h": map[string]interface{}{"nested": map[string]interface{}{"deep": false}},
+	}
+	if !reflect.DeepEqual(obj, want) {
+		t.Errorf("unexpected export:\n got %#v\nwant %#v", obj, want)
+	}
+
+	primitive, _ := v8.NewValue(iso, "just a string")
+	if got, err := primitive.Export(); err != nil || got != "just a string" {
+		t.Errorf("unexpected export of a string: %#v, %v", got, err)
+	}
+
+	cyclic, err := ctx.RunScript("const o = {a: []}; o.a.push(o); o", "")
+	fatalIf(t, err)
+	if _, err := cyclic.Export(); err == nil || !strings.Contains(err.Error(), "circular") {
+		t.Errorf("expected circular structure error, got %v", err)
+	}
+
+	throwing, err := ctx.RunScript("({ get x() { throw new Error('getter') } })", "")
+	fatalIf(t, err)
+	if _, err := throwing.Export(); err == nil || !strings.Contains(err.Error(), "getter") {
+		t.Errorf("expected getter error, got %v", err)
+	}
+}
+
+func TestContextImport(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	fn, err := ctx.RunScript("(function double(x) { return x * 2 })", "")
+	fatalIf(t, err)
+	val, err := ctx.Import(map[string]interface{}{
+		"int":    42,
+		"float":  1.5,
+		"str":    "héllo",
+		"bool":   true,
+		"nil":    nil,
+		"big":    int64(7),
+		"list":   []string{"a", "b"},
+		"nested": map[string][]int{"xs": {1, 2, 3}},
+		"7":      "seven",
+		"fn":     fn,
+	})
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("imported", val))
+
+	check, err := ctx.RunScript(`
+		const o = imported;
+		[
+			o.int === 42, o.float === 1.5, o.str === "héllo", o.bool === true,
+			o.nil === null, o.big === 7n, Array.isArray(o.list), o.list.join() === "a,b",
+			o.nested.xs.length === 3, o[7] === "seven", o.fn(2) === 4,
+			Object.getPrototypeOf(o) === Object.prototype,
+		].every(Boolean)
+	`, "")
+	fatalIf(t, err)
+	if !check.IsTrue() {
+		t.Error("imported object does not have the expected properties")
+	}
+
+	exported, err := val.Export()
+	fatalIf(t, err)
+	if got := exported.(map[string]interface{})["list"]; !reflect.DeepEqual(got, []interface{}{"a", "b"}) {
+		t.Errorf("unexpected round trip of list: %#v", got)
+	}
+
+	cyclic := []interface{}{nil}
+	cyclic[0] = cyclic
+	if _, err := ctx.Import(cyclic); err == nil {
+		t.Error("expected error importing a slice that contains itself")
+	}
+	if _, err := ctx.Import(make(chan int)); err == nil {
+		t.Error("expected error importing an unsupported type")
+	}
+	if _, err := ctx.Import(map[int]string{}); err == nil {
+		t.Error("expected error importing a map with non-string keys")
+	}
+}
+
+func TestContextImportBigInt(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.RecordShimStats)
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	huge, _ := new(big.Int).SetString("-123456789012345678901234567890", 10)
+	type typed struct {
+		I int64
+		U uint64
+	}
+	before, _ := iso.ShimStats()
+	val, err := ctx.Import([]interface{}{
+		int64(-7), int64(math.MinInt64), uint64(math.MaxUint64), big.NewInt(0),
+		huge, typed{I: math.MaxInt64, U: 3},
+	})
+	fatalIf(t, err)
+	after, _ := iso.ShimStats()
+	// BigInts are written inline, so the import creates only its result.
+	if n := after.LiveValues() - before.LiveValues(); n != 1 {
+		t.Errorf("expected the import to leave 1 value, got %d", n)
+	}
+	fatalIf(t, ctx.Global().Set("imported", val))
+	check, err := ctx.RunScript(`
+		const [a, b, c, d, e, f] = imported;
+		[
+			a === -7n, b === -(2n ** 63n), c === 2n ** 64n - 1n, d === 0n,
+			e === -123456789012345678901234567890n,
+			f.I === 2n ** 63n - 1n, f.U === 3n,
+		].every(Boolean)
+	`, "")
+	fatalIf(t, err)
+	if !check.IsTrue() {
+		t.Error("imported BigInts do not have the expected values")
+	}
+}
+
+func TestContextImportStruct(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	type tag struct {
+		Name string `v8:"name"`
+	}
+	type row struct {
+		ID      int    `v8:"id"`
+		Title   string `v8:"title"`
+		Score   float64
+		Big     int64
+		Tags    []tag  `v8:"tags"`
+		Parent  *row   `v8:"parent"`
+		Skipped string `v8:"-"`
+		hidden  bool
+	}
+	rows := []row{
+		{ID: 1, Title: "a", Score: 0.5, Big: 1 << 40, Tags: []tag{{"x"}}, Skipped: "s"},
+		{ID: 2, Title: "b", Parent: &row{ID: 1}},
+	}
+	val, err := ctx.Import(rows)
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("rows", val))
+
+	check, err := ctx.RunScript(`[
+		JSON.stringify(Object.keys(rows[0])), JSON.stringify(Object.keys(rows[1])),
+		rows[0].Big === 2n ** 40n, rows[0].tags[0].name, rows[1].parent.id, rows[1].parent.parent,
+	].join("|")`, "rows.js")
+	fatalIf(t, err)
+	if want := `["id","title","Score","Big","tags","parent"]|["id","title","Score","Big","tags","parent"]|true|x|1|`; check.String() != want {
+		t.Errorf("expected %q, got %q", want, check.String())
+	}
+
+	var got []row
+	fatalIf(t, val.ExportTo(&got))
+	rows[0].Skipped = ""
+	if !reflect.DeepEqual(got, rows) {
+		t.Errorf("unexpected round trip:\n got %#v\nwant %#v", got, rows)
+	}
+
+	var generic map[string]interface{}
+	obj, err := ctx.RunScript(`({a: 1, b: [true, "x"], c: 1n})`, "obj.js")
+	fatalIf(t, err)
+	fatalIf(t, obj.ExportTo(&generic))
+	if generic["a"] != float64(1) || !reflect.DeepEqual(generic["b"], []interface{}{true, "x"}) {
+		t.Errorf("unexpected export: %#v", generic)
+	}
+	var typed struct {
+		A int       `v8:"a"`
+		C *v8.Value `v8:"c"`
+	}
+	fatalIf(t, obj.ExportTo(&typed))
+	if typed.A != 1 || !typed.C.IsBigInt() {
+		t.Errorf("unexpected export: %#v", typed)
+	}
+
+	fraction, err := ctx.RunScript(`({id: 1.5})`, "fraction.js")
+	fatalIf(t, err)
+	var r row
+	if err := fraction.ExportTo(&r); err == nil || !strings.Contains(err.Error(), "of field id") {
+		t.Errorf("expected an error for a fraction, got %v", err)
+	}
+	if err := fraction.ExportTo(r); err == nil {
+		t.Error("expected an error for a non-pointer")
+	}
+}
+
+func BenchmarkContextImportStruct(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	type item struct {
+		ID    int     `v8:"id"`
+		Name  string  `v8:"name"`
+		Price float64 `v8:"price"`
+		Stock bool    `v8:"stock"`
+	}
+	items := make([]item, 100)
+	maps := make([]interface{}, len(items))
+	for i := range items {
+		items[i] = item{ID: i, Name: "item", Price: 9.99, Stock: true}
+		maps[i] = map[string]interface{}{"id": i, "name": "item", "price": 9.99, "stock": true}
+	}
+
+	b.Run("Maps", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				ctx.Import(maps)
+			})
+		}
+	})
+	b.Run("Structs", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				ctx.Import(items)
+			})
+		}
+	})
+}
+
+func TestObjectPropertyNames(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`
+	const proto = { inherited: 1 };
+	const obj = Object.create(proto);
+	Object.assign(obj, { host: "example.com", accept: "*/*", 2: 3, [Symbol()]: "hidden", nested: { a: 1 } });
+	Object.defineProperty(obj, "hidden", { value: true, enumerable: false });
+	obj`, "")
+	fatalIf(t, err)
+	obj, err := val.AsObject()
+	fatalIf(t, err)
+
+	names, err := obj.OwnPropertyNames(v8.OnlyEnumerable)
+	fatalIf(t, err)
+	if want := []string{"2", "host", "accept", "nested"}; !reflect.DeepEqual(names, want) {
+		t.Errorf("unexpected enumerable names %q, want %q", names, want)
+	}
+	names, err = obj.OwnPropertyNames(v8.AllProperties)
+	fatalIf(t, err)
+	if want := []string{"2", "host", "accept", "nested", "hidden"}; !reflect.DeepEqual(names, want) {
+		t.Errorf("unexpected names %q, want %q", names, want)
+	}
+	names, err = obj.PropertyNames(v8.IncludePrototypes, v8.OnlyEnumerable)
+	fatalIf(t, err)
+	if want := []string{"2", "host", "accept", "nested", "inherited"}; !reflect.DeepEqual(names, want) {
+		t.Errorf("unexpected names with prototypes %q, want %q", names, want)
+	}
+
+	entries, err := obj.Entries(v8.OwnOnly, v8.OnlyEnumerable)
+	fatalIf(t, err)
+	if len(entries) != 4 {
+		t.Fatalf("unexpected entries %+v", entries)
+	}
+	if entries[0] != (v8.PropertyEntry{Name: "2", Value: float64(3)}) || entries[1] != (v8.PropertyEntry{Name: "host", Value: "example.com"}) {
+		t.Errorf("unexpected entries %+v", entries)
+	}
+	if nested, ok := entries[3].Value.(*v8.Value); !ok || !nested.IsObject() {
+		t.Errorf("expected nested to be a *Value, got %T", entries[3].Value)
+	}
+
+	val, err = ctx.RunScript(`({ get fails() { throw new Error("getter") } })`, "")
+	fatalIf(t, err)
+	obj, _ = val.AsObject()
+	if _, err := obj.Entries(v8.OwnOnly, v8.AllProperties); err == nil || !strings.Contains(err.Error(), "getter") {
+		t.Errorf("expected the error of the getter, got %v", err)
+	}
+	if names, err := obj.OwnPropertyNames(v8.AllProperties); err != nil || len(names) != 1 {
+		t.Errorf("unexpected names %q, %v", names, err)
+	}
+}
+
+func TestObjectMapEntries(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`new Map([["a", 1], [2, "b"], [null, true], [{}, [1]]])`, "")
+	fatalIf(t, err)
+	obj, _ := val.AsObject()
+	entries, err := obj.MapEntries()
+	fatalIf(t, err)
+	if len(entries) != 4 {
+		t.Fatalf("unexpected entries %+v", entries)
+	}
+	want := []v8.MapEntry{{"a", float64(1)}, {float64(2), "b"}, {nil, true}}
+	if !reflect.DeepEqual(entries[:3], want) {
+		t.Errorf("unexpected entries %+v, want %+v", entries[:3], want)
+	}
+	key, ok1 := entries[3].Key.(*v8.Value)
+	value, ok2 := entries[3].Value.(*v8.Value)
+	if !ok1 || !ok2 || !key.IsObject() || !value.IsArray() {
+		t.Errorf("expected object entries as a *Value, got %+v", entries[3])
+	}
+	if _, err := obj.SetValues(); err == nil {
+		t.Error("expected an error for the values of a Map")
+	}
+
+	val, err = ctx.RunScript(`new Set(["x", 1, "x", Symbol.iterator])`, "")
+	fatalIf(t, err)
+	obj, _ = val.AsObject()
+	values, err := obj.SetValues()
+	fatalIf(t, err)
+	if len(values) != 3 || values[0] != "x" || values[1] != float64(1) {
+		t.Fatalf("unexpected values %+v", values)
+	}
+	if sym, ok := values[2].(*v8.Value); !ok || !sym.IsSymbol() {
+		t.Errorf("expected the symbol as a *Value, got %T", values[2])
+	}
+	if _, err := obj.MapEntries(); err == nil {
+		t.Error("expected an error for the entries of a Set")
+	}
+
+	val, _ = ctx.RunScript(`new Map()`, "")
+	obj, _ = val.AsObject()
+	if entries, err := obj.MapEntries(); err != nil || len(entries) != 0 {
+		t.Errorf("unexpected entries of an empty Map %+v, %v", entries, err)
+	}
+}
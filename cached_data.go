@@ -0,0 +1,176 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"sync"
+	"unsafe"
+)
+
+// ErrCachedDataMismatch is the error of CompilerCachedData.Check for a code
+// cache that V8 would reject.
+var ErrCachedDataMismatch = errors.New("v8go: code cache mismatch")
+
+// The header of a code cache, in little-endian 32-bit words, as laid out by
+// the version of V8 that v8go is built with.
+const (
+	cachedDataMagic = iota
+	cachedDataVersionHash
+	cachedDataSourceHash
+	cachedDataFlagHash
+	cachedDataPayloadLength
+	cachedDataChecksum
+	cachedDataHeaderWords
+)
+
+const (
+	cachedDataHeaderSize = cachedDataHeaderWords * 4
+	// cachedDataModuleBit marks the source hash of the cache of a module.
+	cachedDataModuleBit = 1 << 31
+)
+
+// cachedDataReference is the header of a code cache made by this process,
+// which the magic number, version and flag hashes of others must match. It is
+// learned again when the flags change, as told by CachedDataVersionTag.
+var cachedDataReference struct {
+	mu     sync.Mutex
+	tag    C.uint
+	header []byte
+}
+
+func cachedDataHeader(iso *Isolate) ([]byte, error) {
+	tag := C.CachedDataVersionTag()
+	cachedDataReference.mu.Lock()
+	defer cachedDataReference.mu.Unlock()
+	if cachedDataReference.header != nil && cachedDataReference.tag == tag {
+		return cachedDataReference.header, nil
+	}
+	us, err := iso.CompileUnboundScript("0", "cached_data.js", CompileOptions{})
+	if err != nil {
+		return nil, err
+	}
+	data := us.CreateCodeCache().Bytes
+	if len(data) < cachedDataHeaderSize {
+		return nil, errors.New("v8go: no code cache to check against")
+	}
+	cachedDataReference.tag = tag
+	cachedDataReference.header = data[:cachedDataHeaderSize:cachedDataHeaderSize]
+	return cachedDataReference.header, nil
+}
+
+// Check reports whether V8 would accept the code cache to compile source, as
+// a module if module is set, without compiling it or locking iso. It checks
+// the V8 version and flags the cache was made with, the length of its source
+// and the checksum of its contents, the same as V8 does, so a cache that
+// passes may still be rejected only for a source of the same length that
+// differs. The error is ErrCachedDataMismatch, wrapped, if the cache does not
+// match.
+//
+// The first call, and the first after the flags change, compiles a small
+// script in iso to learn the header of the caches of this process.
+func (cd *CompilerCachedData) Check(iso *Isolate, source string, module bool) error {
+	ref, err := cachedDataHeader(iso)
+	if err != nil {
+		return err
+	}
+	data := cd.Bytes
+	if len(data) < cachedDataHeaderSize {
+		return fmt.Errorf("%w: truncated header", ErrCachedDataMismatch)
+	}
+	word := func(b []byte, i int) uint32 {
+		return binary.LittleEndian.Uint32(b[i*4:])
+	}
+	for _, f := range []struct {
+		i    int
+		name string
+	}{
+		{cachedDataMagic, "magic number"},
+		{cachedDataVersionHash, "V8 version"},
+		{cachedDataFlagHash, "flags"},
+	} {
+		if word(data, f.i) != word(ref, f.i) {
+			return fmt.Errorf("%w: %s", ErrCachedDataMismatch, f.name)
+		}
+	}
+	hash := uint32(utf16Length(source))
+	if module {
+		hash |= cachedDataModuleBit
+	}
+	if word(data, cachedDataSourceHash) != hash {
+		return fmt.Errorf("%w: source", ErrCachedDataMismatch)
+	}
+	payload := data[cachedDataHeaderSize:]
+	if word(data, cachedDataPayloadLength) != uint32(len(payload)) {
+		return fmt.Errorf("%w: length", ErrCachedDataMismatch)
+	}
+	if word(data, cachedDataChecksum) != cachedDataChecksumOf(payload) {
+		return fmt.Errorf("%w: checksum", ErrCachedDataMismatch)
+	}
+	return nil
+}
+
+// utf16Length returns the length of s in V8, which counts UTF-16 code units.
+func utf16Length(s string) int {
+	n := 0
+	for _, r := range s {
+		if r > 0xffff {
+			n += 2
+		} else {
+			n++
+		}
+	}
+	return n
+}
+
+// cachedDataChecksumOf is V8's checksum of the payload of a code cache: an
+// Adler-32 whose sums start at 0 rather than 1, so not that of hash/adler32.
+func cachedDataChecksumOf(b []byte) uint32 {
+	const mod = 65521
+	// nmax is the most bytes that can be summed before b may overflow.
+	const nmax = 5552
+	var a, s uint32
+	for len(b) > 0 {
+		n := len(b)
+		if n > nmax {
+			n = nmax
+		}
+		for _, c := range b[:n] {
+			a += uint32(c)
+			s += a
+		}
+		a %= mod
+		s %= mod
+		b = b[n:]
+	}
+	return s<<16 | a
+}
+
+// compileConsumingOffThread compiles like CompileUnboundScript with
+// CompileOptions.ConsumeOffThread.
+func (i *Isolate) compileConsumingOffThread(source, origin string, opts CompileOptions) (*UnboundScript, error) {
+	cached := opts.CachedData
+	opts.ConsumeOffThread = false
+	if !opts.checked {
+		if err := cached.Check(i, source, false); err != nil {
+			if !errors.Is(err, ErrCachedDataMismatch) {
+				return nil, err
+			}
+			us, err := i.CompileUnboundScript(source, origin, CompileOptions{})
+			cached.Rejected = true
+			return us, err
+		}
+	}
+	data := (*C.uint8_t)(unsafe.Pointer(&cached.Bytes[0]))
+	opts.consumeTask = C.IsolateStartConsumingCodeCache(i.ptr, data, C.int(len(cached.Bytes)))
+	if opts.consumeTask != nil {
+		C.ConsumeTaskRun(opts.consumeTask)
+	}
+	return i.CompileUnboundScript(source, origin, opts)
+}
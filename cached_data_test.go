@@ -0,0 +1,88 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"errors"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestCompilerCachedDataCheck(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	const source = `const 𝒙 = 3; 𝒙 * 7`
+	us, err := iso.CompileUnboundScript(source, "check.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	cached := us.CreateCodeCache()
+	fatalIf(t, cached.Check(iso, source, false))
+
+	corrupted := append([]byte(nil), cached.Bytes...)
+	corrupted[len(corrupted)-1] ^= 0xff
+	for _, tt := range []struct {
+		name   string
+		bytes  []byte
+		source string
+		module bool
+	}{
+		{"source", cached.Bytes, source + " ", false},
+		{"module", cached.Bytes, source, true},
+		{"corrupted", corrupted, source, false},
+		{"truncated", cached.Bytes[:len(cached.Bytes)-1], source, false},
+		{"header", cached.Bytes[:8], source, false},
+	} {
+		tt := tt
+		t.Run(tt.name, func(t *testing.T) {
+			bad := &v8.CompilerCachedData{Bytes: tt.bytes}
+			if err := bad.Check(iso, tt.source, tt.module); !errors.Is(err, v8.ErrCachedDataMismatch) {
+				t.Errorf("expected a mismatch, got %v", err)
+			}
+		})
+	}
+}
+
+func TestCompileConsumeOffThread(t *testing.T) {
+	t.Parallel()
+
+	const source = `function f(x) { return x * 2 }; f(21)`
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	us, err := iso.CompileUnboundScript(source, "offthread.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	cached := us.CreateCodeCache()
+
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	ctx := v8.NewContext(iso2)
+	defer ctx.Close()
+	opts := v8.CompileOptions{CachedData: cached, ConsumeOffThread: true}
+	us2, err := iso2.CompileUnboundScript(source, "offthread.js", opts)
+	fatalIf(t, err)
+	if cached.Rejected {
+		t.Error("expected the code cache to be accepted")
+	}
+	val, err := us2.Run(ctx)
+	fatalIf(t, err)
+	if val.Int32() != 42 {
+		t.Errorf("unexpected result %v", val)
+	}
+
+	// A cache of another source is rejected before V8 sees it.
+	other := &v8.CompilerCachedData{Bytes: cached.Bytes}
+	opts = v8.CompileOptions{CachedData: other, ConsumeOffThread: true}
+	us3, err := iso2.CompileUnboundScript(`6 * 7`, "other.js", opts)
+	fatalIf(t, err)
+	if !other.Rejected {
+		t.Error("expected the code cache to be rejected")
+	}
+	val, err = us3.Run(ctx)
+	fatalIf(t, err)
+	if val.Int32() != 42 {
+		t.Errorf("unexpected result %v", val)
+	}
+}
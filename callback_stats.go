@@ -0,0 +1,101 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"runtime"
+	"time"
+	"unsafe"
+)
+
+// RecordCallbackStats is an IsolateOption that makes the isolate time the
+// calls of the callbacks of its function templates, see
+// FunctionTemplate.CallbackStats, at the cost of four reads of the clock per
+// call. The fast paths of templates made with FastFunction are not
+// timed when optimized code calls them directly.
+var RecordCallbackStats IsolateOption = isolateOptionFunc(func(opts *isolateOptions) {
+	opts.callbackStats = true
+})
+
+// CallbackStats are the durations of the calls of the callback of a function
+// template, split into the time spent making values of the receiver and
+// arguments, running the Go function, and handing its result or error back to
+// V8. The histograms are in nanoseconds.
+type CallbackStats struct {
+	// Args is the time taken to make values of the receiver and arguments;
+	// with PackedArgs, the values made by FunctionCallbackInfo.This and
+	// Args are part of Go instead.
+	Args MetricHistogram
+	// Go is the time taken by the Go function, including the lookup of its
+	// context and callback.
+	Go MetricHistogram
+	// Return is the time taken to return the result or throw the error.
+	Return MetricHistogram
+}
+
+// Calls returns the number of calls of the callback.
+func (s CallbackStats) Calls() uint64 {
+	return s.Args.Count
+}
+
+// Total returns the total time spent in calls of the callback.
+func (s CallbackStats) Total() time.Duration {
+	return s.Args.Sum + s.Go.Sum + s.Return.Sum
+}
+
+func newCallbackStats(c *C.CallbackStats) CallbackStats {
+	return CallbackStats{
+		Args:   newMetricHistogram(&c.phases[C.CALLBACK_PHASE_ARGS], time.Nanosecond),
+		Go:     newMetricHistogram(&c.phases[C.CALLBACK_PHASE_GO], time.Nanosecond),
+		Return: newMetricHistogram(&c.phases[C.CALLBACK_PHASE_RETURN], time.Nanosecond),
+	}
+}
+
+// CallbackRef returns the ref that identifies the callback of the template in
+// Isolate.CallbackStats.
+func (tmpl *FunctionTemplate) CallbackRef() int {
+	return tmpl.cbref
+}
+
+// CallbackStats returns the stats of the calls of the template's callback,
+// and false if its isolate was created without RecordCallbackStats.
+func (tmpl *FunctionTemplate) CallbackStats() (CallbackStats, bool) {
+	var length C.int
+	rtn := C.IsolateCallbackStats(tmpl.iso.ptr, C.int(tmpl.cbref), &length)
+	runtime.KeepAlive(tmpl)
+	if length < 0 {
+		return CallbackStats{}, false
+	}
+	if length == 0 {
+		return CallbackStats{}, true
+	}
+	defer C.free(unsafe.Pointer(rtn))
+	return newCallbackStats(rtn), true
+}
+
+// CallbackStats returns the stats of the callbacks of the function templates
+// of the isolate that have been called, by their CallbackRef, and false if it
+// was created without RecordCallbackStats. The stats of a callback are
+// dropped once V8 has collected its template.
+func (i *Isolate) CallbackStats() (map[int]CallbackStats, bool) {
+	var length C.int
+	rtn := C.IsolateCallbackStats(i.ptr, 0, &length)
+	if length < 0 {
+		return nil, false
+	}
+	stats := make(map[int]CallbackStats, int(length))
+	if length == 0 {
+		return stats, true
+	}
+	defer C.free(unsafe.Pointer(rtn))
+	for _, c := range (*[1 << 20]C.CallbackStats)(unsafe.Pointer(rtn))[:length:length] {
+		c := c
+		stats[int(c.ref)] = newCallbackStats(&c)
+	}
+	return stats, true
+}
@@ -0,0 +1,115 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"errors"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestCallbackStats(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.RecordCallbackStats)
+	defer iso.Dispose()
+	slow := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		time.Sleep(time.Millisecond)
+		return nil
+	})
+	failing := v8.NewFunctionTemplateWithError(iso, func(info *v8.FunctionCallbackInfo) (*v8.Value, error) {
+		return nil, errors.New("failed")
+	}, v8.PackedArgs)
+	unused := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value { return nil })
+	global := v8.NewObjectTemplate(iso)
+	fatalIf(t, global.Set("slow", slow))
+	fatalIf(t, global.Set("failing", failing))
+	fatalIf(t, global.Set("unused", unused))
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+
+	_, err := ctx.RunScript(`
+		for (let i = 0; i < 3; i++) slow(i, "x");
+		for (let i = 0; i < 5; i++) try { failing(i) } catch (e) {}
+	`, "stats.js")
+	fatalIf(t, err)
+
+	s, ok := slow.CallbackStats()
+	if !ok {
+		t.Fatal("expected the stats to be recorded")
+	}
+	if s.Calls() != 3 || s.Go.Count != 3 || s.Return.Count != 3 {
+		t.Errorf("expected 3 calls, got %+v", s)
+	}
+	if s.Go.Min < time.Millisecond || s.Go.Unit != time.Nanosecond {
+		t.Errorf("expected the Go phase to take the sleep, got %v in %v", s.Go.Min, s.Go.Unit)
+	}
+	if s.Total() < 3*time.Millisecond || s.Args.Max > s.Go.Min {
+		t.Errorf("unexpected durations %v and %v", s.Total(), s.Args.Max)
+	}
+	var buckets uint64
+	for _, n := range s.Go.Buckets {
+		buckets += n
+	}
+	if buckets != 3 {
+		t.Errorf("unexpected buckets %v", s.Go.Buckets)
+	}
+
+	stats, ok := iso.CallbackStats()
+	if !ok || len(stats) != 2 {
+		t.Fatalf("expected the stats of 2 callbacks, got %v", stats)
+	}
+	if f := stats[failing.CallbackRef()]; f.Calls() != 5 || f.Return.Count != 5 {
+		t.Errorf("expected 5 calls, got %+v", f)
+	}
+	if u, ok := unused.CallbackStats(); !ok || u.Calls() != 0 {
+		t.Errorf("expected no calls, got %+v", u)
+	}
+}
+
+func TestCallbackStatsDisabled(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	fn := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value { return nil })
+	if _, ok := fn.CallbackStats(); ok {
+		t.Error("expected no stats")
+	}
+	if _, ok := iso.CallbackStats(); ok {
+		t.Error("expected no stats")
+	}
+}
+
+func BenchmarkCallbackStats(b *testing.B) {
+	for _, bench := range []struct {
+		name string
+		opts []v8.IsolateOption
+	}{
+		{"Off", nil},
+		{"On", []v8.IsolateOption{v8.RecordCallbackStats}},
+	} {
+		b.Run(bench.name, func(b *testing.B) {
+			iso := v8.NewIsolate(bench.opts...)
+			defer iso.Dispose()
+			fn := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value { return nil })
+			global := v8.NewObjectTemplate(iso)
+			global.Set("f", fn)
+			ctx := v8.NewContext(iso, global)
+			defer ctx.Close()
+			loop, _ := ctx.RunScript(`(n) => { for (let i = 0; i < n; i++) f(i) }`, "bench.js")
+			f, _ := loop.AsFunction()
+			n, _ := v8.NewValue(iso, int32(100))
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				if _, err := f.Call(v8.Undefined(iso), n); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
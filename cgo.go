@@ -6,13 +6,13 @@ package v8go
 
 //go:generate clang-format -i --verbose -style=Chromium v8go.h v8go.cc
 
-// #cgo CXXFLAGS: -fno-rtti -fPIC -std=c++14 -DV8_COMPRESS_POINTERS -DV8_31BIT_SMIS_ON_64BIT_ARCH -I${SRCDIR}/deps/include -Wall
+// The flags of the V8 library of each build variant are in cgo_<variant>.go,
+// and at most one of their build tags can be set.
+
+// #cgo CXXFLAGS: -fno-rtti -fPIC -std=c++14 -I${SRCDIR}/deps/include -Wall
 // #cgo LDFLAGS: -pthread -lv8
 // #cgo libgcompat LDFLAGS: -lgcompat
-// #cgo darwin,amd64 LDFLAGS: -L${SRCDIR}/deps/darwin_x86_64
-// #cgo darwin,arm64 LDFLAGS: -L${SRCDIR}/deps/darwin_arm64
-// #cgo linux,amd64 LDFLAGS: -L${SRCDIR}/deps/linux_x86_64 -ldl
-// #cgo linux,arm64 LDFLAGS: -L${SRCDIR}/deps/linux_arm64 -ldl
+// #cgo linux LDFLAGS: -ldl
 import "C"
 
 // These imports forces `go mod vendor` to pull in all the folders that
@@ -20,8 +20,28 @@ import "C"
 // DO NOT REMOVE
 import (
 	_ "rogchap.com/v8go/deps/darwin_arm64"
+	_ "rogchap.com/v8go/deps/darwin_arm64/jitless"
+	_ "rogchap.com/v8go/deps/darwin_arm64/lite"
+	_ "rogchap.com/v8go/deps/darwin_arm64/lto"
+	_ "rogchap.com/v8go/deps/darwin_arm64/nocompress"
+	_ "rogchap.com/v8go/deps/darwin_arm64/sharedcage"
 	_ "rogchap.com/v8go/deps/darwin_x86_64"
+	_ "rogchap.com/v8go/deps/darwin_x86_64/jitless"
+	_ "rogchap.com/v8go/deps/darwin_x86_64/lite"
+	_ "rogchap.com/v8go/deps/darwin_x86_64/lto"
+	_ "rogchap.com/v8go/deps/darwin_x86_64/nocompress"
+	_ "rogchap.com/v8go/deps/darwin_x86_64/sharedcage"
 	_ "rogchap.com/v8go/deps/include"
 	_ "rogchap.com/v8go/deps/linux_arm64"
+	_ "rogchap.com/v8go/deps/linux_arm64/jitless"
+	_ "rogchap.com/v8go/deps/linux_arm64/lite"
+	_ "rogchap.com/v8go/deps/linux_arm64/lto"
+	_ "rogchap.com/v8go/deps/linux_arm64/nocompress"
+	_ "rogchap.com/v8go/deps/linux_arm64/sharedcage"
 	_ "rogchap.com/v8go/deps/linux_x86_64"
+	_ "rogchap.com/v8go/deps/linux_x86_64/jitless"
+	_ "rogchap.com/v8go/deps/linux_x86_64/lite"
+	_ "rogchap.com/v8go/deps/linux_x86_64/lto"
+	_ "rogchap.com/v8go/deps/linux_x86_64/nocompress"
+	_ "rogchap.com/v8go/deps/linux_x86_64/sharedcage"
 )
@@ -0,0 +1,21 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+//go:build !v8go_nocompress && !v8go_jitless && !v8go_lite && !v8go_lto && !v8go_sharedcage
+// +build !v8go_nocompress,!v8go_jitless,!v8go_lite,!v8go_lto,!v8go_sharedcage
+
+package v8go
+
+// #cgo CXXFLAGS: -DV8_COMPRESS_POINTERS -DV8_31BIT_SMIS_ON_64BIT_ARCH
+// #cgo darwin,amd64 LDFLAGS: -L${SRCDIR}/deps/darwin_x86_64
+// #cgo darwin,arm64 LDFLAGS: -L${SRCDIR}/deps/darwin_arm64
+// #cgo linux,amd64 LDFLAGS: -L${SRCDIR}/deps/linux_x86_64
+// #cgo linux,arm64 LDFLAGS: -L${SRCDIR}/deps/linux_arm64
+import "C"
+
+// BuildVariant is the variant of the V8 library that v8go is built with,
+// selected by the v8go_nocompress, v8go_jitless, v8go_lite, v8go_lto or
+// v8go_sharedcage build tag; the default library compresses pointers and has
+// the JIT compilers.
+const BuildVariant = "default"
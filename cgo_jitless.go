@@ -0,0 +1,20 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+//go:build v8go_jitless
+// +build v8go_jitless
+
+package v8go
+
+// #cgo CXXFLAGS: -DV8_COMPRESS_POINTERS -DV8_31BIT_SMIS_ON_64BIT_ARCH
+// #cgo darwin,amd64 LDFLAGS: -L${SRCDIR}/deps/darwin_x86_64/jitless
+// #cgo darwin,arm64 LDFLAGS: -L${SRCDIR}/deps/darwin_arm64/jitless
+// #cgo linux,amd64 LDFLAGS: -L${SRCDIR}/deps/linux_x86_64/jitless
+// #cgo linux,arm64 LDFLAGS: -L${SRCDIR}/deps/linux_arm64/jitless
+import "C"
+
+// BuildVariant is the variant of the V8 library that v8go is built with:
+// the v8go_jitless library runs JavaScript in the interpreter only, without
+// writable and executable memory, and has no WebAssembly.
+const BuildVariant = "jitless"
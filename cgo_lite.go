@@ -0,0 +1,21 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+//go:build v8go_lite
+// +build v8go_lite
+
+package v8go
+
+// #cgo CXXFLAGS: -DV8_COMPRESS_POINTERS -DV8_31BIT_SMIS_ON_64BIT_ARCH
+// #cgo darwin,amd64 LDFLAGS: -L${SRCDIR}/deps/darwin_x86_64/lite
+// #cgo darwin,arm64 LDFLAGS: -L${SRCDIR}/deps/darwin_arm64/lite
+// #cgo linux,amd64 LDFLAGS: -L${SRCDIR}/deps/linux_x86_64/lite
+// #cgo linux,arm64 LDFLAGS: -L${SRCDIR}/deps/linux_arm64/lite
+import "C"
+
+// BuildVariant is the variant of the V8 library that v8go is built with:
+// the v8go_lite library is jitless, and also drops the optimizations that
+// cost memory, such as eagerly allocated feedback, for the smallest
+// footprint per isolate.
+const BuildVariant = "lite"
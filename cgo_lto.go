@@ -0,0 +1,23 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+//go:build v8go_lto
+// +build v8go_lto
+
+package v8go
+
+// #cgo CXXFLAGS: -DV8_COMPRESS_POINTERS -DV8_31BIT_SMIS_ON_64BIT_ARCH -flto=thin
+// #cgo LDFLAGS: -flto=thin -fuse-ld=lld
+// #cgo darwin,amd64 LDFLAGS: -L${SRCDIR}/deps/darwin_x86_64/lto
+// #cgo darwin,arm64 LDFLAGS: -L${SRCDIR}/deps/darwin_arm64/lto
+// #cgo linux,amd64 LDFLAGS: -L${SRCDIR}/deps/linux_x86_64/lto
+// #cgo linux,arm64 LDFLAGS: -L${SRCDIR}/deps/linux_arm64/lto
+import "C"
+
+// BuildVariant is the variant of the V8 library that v8go is built with:
+// the v8go_lto library is the default one built with ThinLTO, and profile
+// guided optimization when the build has a profile, and is linked with
+// v8go's C++ at link time, which needs CC and CXX to be the clang that
+// built V8.
+const BuildVariant = "lto"
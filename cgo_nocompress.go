@@ -0,0 +1,19 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+//go:build v8go_nocompress
+// +build v8go_nocompress
+
+package v8go
+
+// #cgo darwin,amd64 LDFLAGS: -L${SRCDIR}/deps/darwin_x86_64/nocompress
+// #cgo darwin,arm64 LDFLAGS: -L${SRCDIR}/deps/darwin_arm64/nocompress
+// #cgo linux,amd64 LDFLAGS: -L${SRCDIR}/deps/linux_x86_64/nocompress
+// #cgo linux,arm64 LDFLAGS: -L${SRCDIR}/deps/linux_arm64/nocompress
+import "C"
+
+// BuildVariant is the variant of the V8 library that v8go is built with:
+// the v8go_nocompress library does not compress pointers, so that the heap of
+// an isolate can grow past 4GB, at the cost of more memory per object.
+const BuildVariant = "nocompress"
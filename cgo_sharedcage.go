@@ -0,0 +1,22 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+//go:build v8go_sharedcage
+// +build v8go_sharedcage
+
+package v8go
+
+// #cgo CXXFLAGS: -DV8_COMPRESS_POINTERS -DV8_COMPRESS_POINTERS_IN_SHARED_CAGE -DV8_31BIT_SMIS_ON_64BIT_ARCH
+// #cgo darwin,amd64 LDFLAGS: -L${SRCDIR}/deps/darwin_x86_64/sharedcage
+// #cgo darwin,arm64 LDFLAGS: -L${SRCDIR}/deps/darwin_arm64/sharedcage
+// #cgo linux,amd64 LDFLAGS: -L${SRCDIR}/deps/linux_x86_64/sharedcage
+// #cgo linux,arm64 LDFLAGS: -L${SRCDIR}/deps/linux_arm64/sharedcage
+import "C"
+
+// BuildVariant is the variant of the V8 library that v8go is built with:
+// the v8go_sharedcage library compresses pointers into a single cage that
+// all isolates of the process share, along with the read-only heap, so that
+// each isolate no longer has its own copy of the read-only objects; the heaps
+// of all isolates then fit in 4GB together.
+const BuildVariant = "sharedcage"
@@ -0,0 +1,247 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"crypto/sha256"
+	"encoding/binary"
+	"encoding/hex"
+	"errors"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"sync"
+	"sync/atomic"
+)
+
+// CodeCache is a persistent store of the code caches of compiled scripts, kept
+// as one file per script in a directory. Entries are keyed by a hash of the
+// source of the script and of the V8 version tag, which covers the V8 version
+// and the flags that affect code generation, so caches from other versions or
+// flags are never loaded. Entries are memory mapped and the mappings shared by
+// every isolate that uses the CodeCache. CodeCache is safe for concurrent use,
+// including by several processes sharing the directory.
+type CodeCache struct {
+	dir string
+
+	mu     sync.Mutex
+	mapped map[string]*MappedCachedData
+
+	hits, misses, rejections uint64
+}
+
+// CodeCacheStats counts the outcomes of CodeCache.CompileUnboundScript.
+type CodeCacheStats struct {
+	// Hits is the number of scripts compiled from a cached entry.
+	Hits uint64
+	// Misses is the number of scripts that had no entry.
+	Misses uint64
+	// Rejections is the number of entries that failed CompilerCachedData.Check
+	// or that V8 rejected, and that were then replaced.
+	Rejections uint64
+}
+
+// NewCodeCache creates a code cache that is stored in dir, creating dir if it
+// does not exist.
+func NewCodeCache(dir string) (*CodeCache, error) {
+	if err := os.MkdirAll(dir, 0o755); err != nil {
+		return nil, err
+	}
+	return &CodeCache{dir: dir, mapped: make(map[string]*MappedCachedData)}, nil
+}
+
+// CompileUnboundScript compiles the script like Isolate.CompileUnboundScript,
+// consuming the cached code of the script if there is any, which is checked
+// and deserialized without holding the isolate's lock, see
+// CompileOptions.ConsumeOffThread. If there is none, or V8 rejects it, the code cache of the newly compiled script is stored for
+// next time. opts.CachedData must be nil; opts.Mode is only used when there is
+// no usable cached code.
+// error will be of type `JSError` if not nil, unless the cache itself failed.
+func (c *CodeCache) CompileUnboundScript(iso *Isolate, source, origin string, opts CompileOptions) (*UnboundScript, error) {
+	cc, err := c.compile(iso, scriptCodeCache, source, opts, func(opts CompileOptions) (codeCacher, error) {
+		opts.ConsumeOffThread = opts.CachedData != nil
+		return iso.CompileUnboundScript(source, origin, opts)
+	})
+	if cc == nil {
+		return nil, err
+	}
+	return cc.(*UnboundScript), err
+}
+
+// CompileModule compiles the module like Context.CompileModule, using the
+// cache like CompileUnboundScript does.
+// error will be of type `JSError` if not nil, unless the cache itself failed.
+func (c *CodeCache) CompileModule(ctx *Context, source, origin string, opts CompileOptions) (*Module, error) {
+	cc, err := c.compile(ctx.Isolate(), moduleCodeCache, source, opts, func(opts CompileOptions) (codeCacher, error) {
+		return ctx.CompileModule(source, origin, opts)
+	})
+	if cc == nil {
+		return nil, err
+	}
+	return cc.(*Module), err
+}
+
+// codeCacher is compiled code that a code cache can be created from.
+type codeCacher interface {
+	CreateCodeCache() *CompilerCachedData
+}
+
+// The kinds of code in the cache, whose caches are not interchangeable even if
+// their source is the same.
+const (
+	scriptCodeCache = "script"
+	moduleCodeCache = "module"
+)
+
+func (c *CodeCache) compile(iso *Isolate, kind, source string, opts CompileOptions, compile func(CompileOptions) (codeCacher, error)) (codeCacher, error) {
+	if opts.CachedData != nil {
+		return nil, errors.New("v8go: CachedData is set by the CodeCache")
+	}
+	path := c.path(kind, source)
+
+	m, err := c.acquire(path)
+	if err != nil {
+		return nil, err
+	}
+	if m != nil {
+		cached := m.CachedData()
+		if err := cached.Check(iso, source, kind == moduleCodeCache); err != nil {
+			m.release()
+			if !errors.Is(err, ErrCachedDataMismatch) {
+				return nil, err
+			}
+			atomic.AddUint64(&c.rejections, 1)
+			c.evict(path, m)
+			cc, err := compile(opts)
+			if err != nil {
+				return nil, err
+			}
+			return cc, c.store(path, cc)
+		}
+		cc, err := compile(CompileOptions{CachedData: cached, checked: true})
+		m.release()
+		if err != nil {
+			return nil, err
+		}
+		if !cached.Rejected {
+			atomic.AddUint64(&c.hits, 1)
+			return cc, nil
+		}
+		atomic.AddUint64(&c.rejections, 1)
+		c.evict(path, m)
+		return cc, c.store(path, cc)
+	}
+
+	atomic.AddUint64(&c.misses, 1)
+	cc, err := compile(opts)
+	if err != nil {
+		return nil, err
+	}
+	return cc, c.store(path, cc)
+}
+
+// Update replaces the entry for source with the code cache of us, which must
+// have been compiled from source. Calling it once the script has run stores
+// the functions that were compiled lazily, which a cache created right after
+// compiling misses.
+func (c *CodeCache) Update(source string, us *UnboundScript) error {
+	path := c.path(scriptCodeCache, source)
+	if err := c.store(path, us); err != nil {
+		return err
+	}
+	c.mu.Lock()
+	m, ok := c.mapped[path]
+	c.mu.Unlock()
+	if ok {
+		c.evict(path, m)
+	}
+	return nil
+}
+
+// Stats returns the counts of hits, misses and rejections so far.
+func (c *CodeCache) Stats() CodeCacheStats {
+	return CodeCacheStats{
+		Hits:       atomic.LoadUint64(&c.hits),
+		Misses:     atomic.LoadUint64(&c.misses),
+		Rejections: atomic.LoadUint64(&c.rejections),
+	}
+}
+
+// Close unmaps the entries of the cache. Scripts compiled from them remain
+// valid, and the CodeCache can still be used after it is closed.
+func (c *CodeCache) Close() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for path, m := range c.mapped {
+		m.Close()
+		delete(c.mapped, path)
+	}
+}
+
+// acquire returns the mapping of the entry at path, held open until released,
+// or nil if there is no entry.
+func (c *CodeCache) acquire(path string) (*MappedCachedData, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	m, ok := c.mapped[path]
+	if !ok {
+		var err error
+		if m, err = MapCachedData(path); err != nil {
+			if os.IsNotExist(err) || err == errEmptyCachedData {
+				return nil, nil
+			}
+			return nil, err
+		}
+		c.mapped[path] = m
+	}
+	m.acquire()
+	return m, nil
+}
+
+// evict unmaps the rejected entry m once isolates compiling from it are done.
+func (c *CodeCache) evict(path string, m *MappedCachedData) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if c.mapped[path] == m {
+		delete(c.mapped, path)
+	}
+	m.Close()
+}
+
+func (c *CodeCache) path(kind, source string) string {
+	h := sha256.New()
+	h.Write([]byte(kind))
+	var tag [4]byte
+	binary.LittleEndian.PutUint32(tag[:], uint32(C.CachedDataVersionTag()))
+	h.Write(tag[:])
+	h.Write([]byte(source))
+	return filepath.Join(c.dir, hex.EncodeToString(h.Sum(nil))+".v8cache")
+}
+
+// store writes the code cache of cc to path, through a temporary file that is
+// renamed into place so that readers never see a partial entry.
+func (c *CodeCache) store(path string, cc codeCacher) error {
+	data := cc.CreateCodeCache().Bytes
+	if len(data) == 0 {
+		return nil
+	}
+	f, err := ioutil.TempFile(c.dir, ".v8cache-")
+	if err != nil {
+		return err
+	}
+	_, err = f.Write(data)
+	if cerr := f.Close(); err == nil {
+		err = cerr
+	}
+	if err == nil {
+		err = os.Rename(f.Name(), path)
+	}
+	if err != nil {
+		os.Remove(f.Name())
+	}
+	return err
+}
@@ -0,0 +1,157 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestCodeCache(t *testing.T) {
+	t.Parallel()
+
+	dir := t.TempDir()
+	cache, err := v8.NewCodeCache(dir)
+	fatalIf(t, err)
+
+	const source = "function foo() { return 'bar'; }; foo()"
+	run := func() {
+		iso := v8.NewIsolate()
+		defer iso.Dispose()
+		us, err := cache.CompileUnboundScript(iso, source, "script.js", v8.CompileOptions{})
+		fatalIf(t, err)
+		ctx := v8.NewContext(iso)
+		defer ctx.Close()
+		val, err := us.Run(ctx)
+		fatalIf(t, err)
+		if val.String() != "bar" {
+			t.Fatalf("invalid value returned, expected bar got %v", val)
+		}
+	}
+
+	run()
+	if s := cache.Stats(); s.Misses != 1 || s.Hits != 0 {
+		t.Fatalf("unexpected stats after first compile: %+v", s)
+	}
+	run()
+	if s := cache.Stats(); s.Misses != 1 || s.Hits != 1 {
+		t.Fatalf("unexpected stats after second compile: %+v", s)
+	}
+
+	entries, err := filepath.Glob(filepath.Join(dir, "*.v8cache"))
+	fatalIf(t, err)
+	if len(entries) != 1 {
+		t.Fatalf("expected 1 cache entry, got %d", len(entries))
+	}
+	corrupt := filepath.Join(dir, "corrupt")
+	fatalIf(t, ioutil.WriteFile(corrupt, []byte("not a code cache"), 0o644))
+	fatalIf(t, os.Rename(corrupt, entries[0]))
+	// The entry is still mapped, until the cache is closed.
+	run()
+	if s := cache.Stats(); s.Hits != 2 {
+		t.Fatalf("expected the mapped entry to be used: %+v", s)
+	}
+	cache.Close()
+
+	run()
+	if s := cache.Stats(); s.Rejections != 1 {
+		t.Fatalf("expected the corrupt entry to be rejected: %+v", s)
+	}
+	run()
+	if s := cache.Stats(); s.Hits != 3 {
+		t.Fatalf("expected the rejected entry to be replaced: %+v", s)
+	}
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	if _, err := cache.CompileUnboundScript(iso, source, "script.js", v8.CompileOptions{CachedData: &v8.CompilerCachedData{}}); err == nil {
+		t.Error("expected an error when CachedData is set")
+	}
+	if _, err := cache.CompileUnboundScript(iso, "invalid js", "script.js", v8.CompileOptions{}); err == nil {
+		t.Error("expected a compile error")
+	}
+}
+
+func TestMappedCachedData(t *testing.T) {
+	t.Parallel()
+
+	const source = "function foo() { return 'bar'; }; foo()"
+	iso := v8.NewIsolate()
+	us, err := iso.CompileUnboundScript(source, "script.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	path := filepath.Join(t.TempDir(), "script.v8cache")
+	fatalIf(t, ioutil.WriteFile(path, us.CreateCodeCache().Bytes, 0o644))
+	iso.Dispose()
+
+	m, err := v8.MapCachedData(path)
+	fatalIf(t, err)
+	defer m.Close()
+
+	for i := 0; i < 3; i++ {
+		iso := v8.NewIsolate()
+		cached := m.CachedData()
+		if cached.Bytes == nil || len(cached.Bytes) != m.Len() {
+			t.Fatalf("expected %d mapped bytes, got %d", m.Len(), len(cached.Bytes))
+		}
+		us, err := iso.CompileUnboundScript(source, "script.js", v8.CompileOptions{CachedData: cached})
+		fatalIf(t, err)
+		if cached.Rejected {
+			t.Fatal("expected the mapped code cache to be accepted")
+		}
+		ctx := v8.NewContext(iso)
+		val, err := us.Run(ctx)
+		fatalIf(t, err)
+		if val.String() != "bar" {
+			t.Errorf("invalid value returned, expected bar got %v", val)
+		}
+		ctx.Close()
+		iso.Dispose()
+	}
+
+	empty := filepath.Join(t.TempDir(), "empty.v8cache")
+	fatalIf(t, ioutil.WriteFile(empty, nil, 0o644))
+	if _, err := v8.MapCachedData(empty); err == nil {
+		t.Error("expected an error mapping an empty file")
+	}
+}
+
+func TestCodeCacheUpdate(t *testing.T) {
+	t.Parallel()
+
+	cache, err := v8.NewCodeCache(t.TempDir())
+	fatalIf(t, err)
+	defer cache.Close()
+
+	const source = "function handler() { return 'bar'; }; handler"
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	us, err := cache.CompileUnboundScript(iso, source, "script.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	// Map the cold entry, so that Update has to replace the mapping.
+	_, err = cache.CompileUnboundScript(iso, source, "script.js", v8.CompileOptions{})
+	fatalIf(t, err)
+
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	val, err := us.Run(ctx)
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	_, err = fn.Call(v8.Undefined(iso))
+	fatalIf(t, err)
+	fatalIf(t, cache.Update(source, us))
+
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	_, err = cache.CompileUnboundScript(iso2, source, "script.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	if s := cache.Stats(); s.Hits != 2 || s.Misses != 1 || s.Rejections != 0 {
+		t.Errorf("unexpected stats: %+v", s)
+	}
+}
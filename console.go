@@ -0,0 +1,102 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"time"
+	"unsafe"
+)
+
+// ConsoleLevel is the level of a console message, by the method of console
+// that wrote it.
+type ConsoleLevel int
+
+const (
+	// ConsoleDebug is console.debug.
+	ConsoleDebug ConsoleLevel = C.CONSOLE_DEBUG
+	// ConsoleLog is console.log, info, dir, dirxml, table and trace.
+	ConsoleLog ConsoleLevel = C.CONSOLE_LOG
+	// ConsoleWarn is console.warn.
+	ConsoleWarn ConsoleLevel = C.CONSOLE_WARN
+	// ConsoleError is console.error, and console.assert when its condition
+	// is falsy.
+	ConsoleError ConsoleLevel = C.CONSOLE_ERROR
+)
+
+func (l ConsoleLevel) String() string {
+	switch l {
+	case ConsoleDebug:
+		return "debug"
+	case ConsoleLog:
+		return "log"
+	case ConsoleWarn:
+		return "warn"
+	case ConsoleError:
+		return "error"
+	}
+	return "unknown"
+}
+
+// ConsoleMessage is a message written to the console of a context, see
+// BufferConsole.
+type ConsoleMessage struct {
+	Level ConsoleLevel
+	// Message is the arguments of the call, as strings separated by spaces;
+	// it is truncated to 16KB.
+	Message string
+	Time    time.Time
+}
+
+// BufferConsole is an IsolateOption that makes the console methods of the
+// contexts of the isolate write their messages at level or above into a
+// buffer of each context, without calling into Go, until they are drained
+// with Context.DrainConsole. The buffer keeps the latest capacity messages,
+// and the older ones are counted as dropped. Arguments that are not strings
+// are converted without running JavaScript, so objects show as their class,
+// as in #<Object>. The methods other than those of the ConsoleLevels, such as
+// console.time and console.count, do nothing, as the whole console does
+// without BufferConsole. An inspector session of the isolate, see
+// Context.NewInspectorSession, takes over its console for good.
+func BufferConsole(capacity int, level ConsoleLevel) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.consoleCapacity = capacity
+		opts.consoleLevel = level
+	})
+}
+
+// consoleDrainBuffer is the size of the text that DrainConsole moves at a
+// time, which holds at least one message of the longest.
+const consoleDrainBuffer = 32 << 10
+
+// DrainConsole appends the console messages of the context since the last
+// call to dst, along with the number of messages dropped meanwhile. It can be
+// called from any goroutine, even while the context runs JavaScript, but not
+// once it is closed; the context of an isolate created without BufferConsole
+// has no messages.
+func (c *Context) DrainConsole(dst []ConsoleMessage) ([]ConsoleMessage, uint64) {
+	var records [64]C.ConsoleRecord
+	buf := make([]byte, consoleDrainBuffer)
+	var dropped uint64
+	for {
+		var d C.uint64_t
+		n := int(C.ContextDrainConsole(c.ptr, &records[0], C.size_t(len(records)),
+			(*C.char)(unsafe.Pointer(&buf[0])), C.size_t(len(buf)), &d))
+		dropped += uint64(d)
+		if n == 0 {
+			return dst, dropped
+		}
+		text := buf
+		for _, r := range records[:n] {
+			dst = append(dst, ConsoleMessage{
+				Level:   ConsoleLevel(r.level),
+				Message: string(text[:r.length]),
+				Time:    time.Unix(0, int64(r.time)),
+			})
+			text = text[r.length:]
+		}
+	}
+}
@@ -0,0 +1,115 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"strings"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestBufferConsole(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.BufferConsole(4, v8.ConsoleLog))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	other := v8.NewContext(iso)
+	defer other.Close()
+
+	start := time.Now()
+	_, err := ctx.RunScript(`
+		console.debug("filtered");
+		console.log("hello", 1, true, null, undefined, Symbol("s"), {});
+		console.warn("café");
+		console.assert(true, "holds");
+		console.assert(false, "fails");
+		console.time("nothing");
+	`, "console.js")
+	fatalIf(t, err)
+	_, err = other.RunScript(`console.error("other")`, "other.js")
+	fatalIf(t, err)
+
+	messages, dropped := ctx.DrainConsole(nil)
+	if dropped != 0 {
+		t.Errorf("expected no dropped messages, got %d", dropped)
+	}
+	want := []v8.ConsoleMessage{
+		{Level: v8.ConsoleLog, Message: "hello 1 true null undefined Symbol(s) #<Object>"},
+		{Level: v8.ConsoleWarn, Message: "café"},
+		{Level: v8.ConsoleError, Message: "Assertion failed: fails"},
+	}
+	if len(messages) != len(want) {
+		t.Fatalf("expected %d messages, got %+v", len(want), messages)
+	}
+	for i, m := range messages {
+		if m.Level != want[i].Level || m.Message != want[i].Message {
+			t.Errorf("expected %v %q, got %v %q", want[i].Level, want[i].Message, m.Level, m.Message)
+		}
+		if m.Time.Before(start.Add(-time.Second)) {
+			t.Errorf("unexpected time %v", m.Time)
+		}
+	}
+	if messages, _ := ctx.DrainConsole(nil); len(messages) != 0 {
+		t.Errorf("expected the messages to be drained, got %+v", messages)
+	}
+	if messages, _ := other.DrainConsole(nil); len(messages) != 1 || messages[0].Message != "other" {
+		t.Errorf("expected the message of the other context, got %+v", messages)
+	}
+
+	// A full buffer keeps the latest messages, and long ones are truncated.
+	_, err = ctx.RunScript(`
+		for (let i = 0; i < 10; i++) console.log(i);
+		console.log("x".repeat(1 << 20));
+		console.log("x".repeat(1 << 20));
+	`, "full.js")
+	fatalIf(t, err)
+	messages, dropped = ctx.DrainConsole(nil)
+	if dropped != 8 || len(messages) != 4 || messages[0].Message != "8" {
+		t.Fatalf("expected the last 4 of 12 messages, got %d dropped and %+v", dropped, messages[:1])
+	}
+	for _, m := range messages[2:] {
+		if len(m.Message) != 16<<10 || strings.Trim(m.Message, "x") != "" {
+			t.Errorf("expected a truncated message, got %d bytes", len(m.Message))
+		}
+	}
+}
+
+func TestConsoleWithoutBuffer(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+	_, err := ctx.RunScript(`console.log("nowhere")`, "console.js")
+	fatalIf(t, err)
+	if messages, dropped := ctx.DrainConsole(nil); len(messages) != 0 || dropped != 0 {
+		t.Errorf("expected no messages, got %+v", messages)
+	}
+}
+
+func BenchmarkConsoleLog(b *testing.B) {
+	iso := v8.NewIsolate(v8.BufferConsole(1024, v8.ConsoleLog))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	fn, err := ctx.RunScript(`(n) => { for (let i = 0; i < n; i++) console.log("request", i, "done") }`, "bench.js")
+	if err != nil {
+		b.Fatal(err)
+	}
+	f, _ := fn.AsFunction()
+	n, _ := v8.NewValue(iso, int32(100))
+	var messages []v8.ConsoleMessage
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := f.Call(v8.Undefined(iso), n); err != nil {
+			b.Fatal(err)
+		}
+		messages, _ = ctx.DrainConsole(messages[:0])
+	}
+}
@@ -8,8 +8,10 @@ package v8go
 // #include "v8go.h"
 import "C"
 import (
+	"fmt"
 	"runtime"
 	"sync"
+	"time"
 	"unsafe"
 )
 
@@ -21,8 +23,11 @@ type ctxRef struct {
 	refCount int
 }
 
-var ctxMutex sync.RWMutex
-var ctxRegistry = make(map[int]*ctxRef)
+// ctxRegistry maps refs to *ctxRef. Lookups happen on every callback, from
+// any number of isolates at once, so they are lock-free; ctxMutex only
+// serializes changes to the registry.
+var ctxMutex sync.Mutex
+var ctxRegistry sync.Map
 var ctxSeq = 0
 
 // Context is a global root execution environment that allows separate,
@@ -31,11 +36,40 @@ type Context struct {
 	ref int
 	ptr C.ContextPtr
 	iso *Isolate
+
+	// modules maps the C.ModulePtr of the modules compiled in the context to
+	// their *Module, and imports the modules of each ModuleCache by specifier.
+	modules sync.Map
+	imports sync.Map
+
+	// async holds the async function calls of the context, see
+	// NewAsyncFunctionTemplate.
+	async asyncQueue
+	// continuations holds the refs of the callbacks of the promise
+	// continuations of the context that have not been called yet.
+	continuations sync.Map
+	// fetch holds the open response bodies of the context, see Fetch.
+	fetch *fetchState
+
+	// closeMutex keeps the finalizers of values, see ReleaseUnreachableValues,
+	// from queueing them while the context is closed.
+	closeMutex sync.RWMutex
 }
 
 type contextOptions struct {
 	iso   *Isolate
 	gTmpl *ObjectTemplate
+
+	ownMicrotaskQueue bool
+	timers            bool
+	textEncoding      bool
+	performance       bool
+	crypto            bool
+	atomicsWaitAsync  bool
+	timerResolution   time.Duration
+	fetch             *FetchOptions
+	snapshotIndex     int
+	global            *Object
 }
 
 // ContextOption sets options such as Isolate and Global Template to the NewContext
@@ -43,6 +77,40 @@ type ContextOption interface {
 	apply(*contextOptions)
 }
 
+type contextOptionFunc func(*contextOptions)
+
+func (f contextOptionFunc) apply(opts *contextOptions) {
+	f(opts)
+}
+
+// OwnMicrotaskQueue gives the context a microtask queue of its own, instead
+// of the default queue that it shares with the other contexts of the isolate,
+// so that the promises of one context do not hold up those of another. The
+// microtasks of the queue only run when Context.PerformMicrotaskCheckpoint is
+// called.
+var OwnMicrotaskQueue ContextOption = contextOptionFunc(func(opts *contextOptions) {
+	opts.ownMicrotaskQueue = true
+})
+
+// SnapshotContext makes the context start from the context at index of the
+// isolate's startup snapshot, see SnapshotCreator.Create, rather than the
+// first one. NewContext panics if the snapshot has no such context.
+func SnapshotContext(index int) ContextOption {
+	return contextOptionFunc(func(opts *contextOptions) {
+		opts.snapshotIndex = index
+	})
+}
+
+// ReuseGlobal makes the context reuse the global proxy object that another
+// context of the isolate detached with DetachGlobal, so that references to
+// the global that are held by JS code refer to the new context. The new
+// context must be created before the detached one is closed.
+func ReuseGlobal(global *Object) ContextOption {
+	return contextOptionFunc(func(opts *contextOptions) {
+		opts.global = global
+	})
+}
+
 // NewContext creates a new JavaScript context; if no Isolate is passed as a
 // ContextOption than a new Isolate will be created.
 func NewContext(opt ...ContextOption) *Context {
@@ -66,13 +134,46 @@ func NewContext(opt ...ContextOption) *Context {
 	ref := ctxSeq
 	ctxMutex.Unlock()
 
+	cOptions := C.ContextOptions{snapshotIndex: C.int(opts.snapshotIndex)}
+	if opts.ownMicrotaskQueue {
+		cOptions.ownMicrotaskQueue = 1
+	}
+	if opts.global != nil {
+		cOptions.globalObject = opts.global.ptr
+	}
+	ptr := C.NewContext(opts.iso.ptr, opts.gTmpl.ptr, C.int(ref), cOptions)
+	runtime.KeepAlive(opts.gTmpl)
+	runtime.KeepAlive(opts.global)
+	if ptr == nil {
+		panic(fmt.Errorf("v8go: no context at index %d in the snapshot of the isolate", opts.snapshotIndex))
+	}
 	ctx := &Context{
 		ref: ref,
-		ptr: C.NewContext(opts.iso.ptr, opts.gTmpl.ptr, C.int(ref)),
+		ptr: ptr,
 		iso: opts.iso,
 	}
 	ctx.register()
-	runtime.KeepAlive(opts.gTmpl)
+	if opts.timers {
+		C.ContextInstallTimers(ctx.ptr)
+	}
+	if opts.textEncoding {
+		C.ContextInstallTextCoding(ctx.ptr)
+	}
+	if opts.performance {
+		resolution := float64(opts.timerResolution) / float64(time.Millisecond)
+		C.ContextInstallPerformance(ctx.ptr, C.double(resolution))
+	}
+	if opts.crypto {
+		C.ContextInstallCrypto(ctx.ptr)
+	}
+	if opts.atomicsWaitAsync {
+		C.ContextTrackAtomicsWaitAsync(ctx.ptr)
+	}
+	if opts.fetch != nil {
+		if err := ctx.installFetch(opts.fetch); err != nil {
+			panic(fmt.Errorf("v8go: installing fetch: %w", err))
+		}
+	}
 	return ctx
 }
 
@@ -86,12 +187,9 @@ func (c *Context) Isolate() *Isolate {
 // reference for the script and used in the stack trace if there is an error.
 // error will be of type `JSError` if not nil.
 func (c *Context) RunScript(source string, origin string) (*Value, error) {
-	cSource := C.CString(source)
-	cOrigin := C.CString(origin)
-	defer C.free(unsafe.Pointer(cSource))
-	defer C.free(unsafe.Pointer(cOrigin))
-
-	rtn := C.RunScript(c.ptr, cSource, cOrigin)
+	rtn := C.RunScript(c.ptr, stringArg(source), stringArg(origin))
+	runtime.KeepAlive(source)
+	runtime.KeepAlive(origin)
 	return valueResult(c, rtn)
 }
 
@@ -104,74 +202,137 @@ func (c *Context) RunScript(source string, origin string) (*Value, error) {
 // global proxy object.
 func (c *Context) Global() *Object {
 	valPtr := C.ContextGlobal(c.ptr)
-	v := &Value{valPtr, c}
+	v := newValue(c, valPtr)
 	return &Object{v}
 }
 
-// PerformMicrotaskCheckpoint runs the default MicrotaskQueue until empty.
-// This is used to make progress on Promises.
+// DetachGlobal detaches the global proxy object from the context and returns
+// it, to be reused by a new context with the ReuseGlobal option. The context
+// keeps running, but its scripts can no longer reach their global object
+// through the proxy. Like other values of the context, the returned Object
+// must not be used once the context is closed.
+func (c *Context) DetachGlobal() *Object {
+	ptr := C.ContextDetachGlobal(c.ptr)
+	return &Object{newValue(c, ptr)}
+}
+
+// PerformMicrotaskCheckpoint runs the MicrotaskQueue of the context until
+// empty, which is the default queue of the isolate unless the context was
+// created with OwnMicrotaskQueue. This is used to make progress on Promises.
+// The dynamic imports of the isolate that have been finished or rejected are
+// settled first, see DynamicImport.Finish, as are the async function calls of
+// the context that have returned, see NewAsyncFunctionTemplate.
 func (c *Context) PerformMicrotaskCheckpoint() {
-	C.IsolatePerformMicrotaskCheckpoint(c.iso.ptr)
+	c.iso.finishDynamicImports()
+	c.async.settle(c)
+	C.ContextPerformMicrotaskCheckpoint(c.ptr)
 }
 
 // Close will dispose the context and free the memory.
 // Access to any values associated with the context after calling Close may panic.
 func (c *Context) Close() {
+	c.close(false)
+}
+
+// CloseDeferred closes the context like Close, but leaves most of the work of
+// freeing its values, which takes time in proportion to their number, for
+// later: it is done in bounded slices by Isolate.ReclaimContexts, which a
+// Scheduler calls while it is idle, and whatever is left when the isolate is
+// disposed. It suits contexts that have made many values and are closed at
+// the end of a request, whose latency would otherwise include freeing them.
+func (c *Context) CloseDeferred() {
+	c.close(true)
+}
+
+func (c *Context) close(deferred bool) {
+	if c.fetch != nil {
+		c.fetch.close()
+	}
 	c.deregister()
-	C.ContextFree(c.ptr)
+	c.closeMutex.Lock()
+	if deferred {
+		C.ContextFreeDeferred(c.ptr)
+	} else {
+		C.ContextFree(c.ptr)
+	}
 	c.ptr = nil
+	c.closeMutex.Unlock()
+	c.continuations.Range(func(ref, _ interface{}) bool {
+		c.iso.cbs.Delete(ref)
+		c.continuations.Delete(ref)
+		return true
+	})
 }
 
 func (c *Context) register() {
 	ctxMutex.Lock()
-	r := ctxRegistry[c.ref]
-	if r == nil {
-		r = &ctxRef{ctx: c}
-		ctxRegistry[c.ref] = r
-	}
-	r.refCount++
+	r, _ := ctxRegistry.LoadOrStore(c.ref, &ctxRef{ctx: c})
+	r.(*ctxRef).refCount++
 	ctxMutex.Unlock()
 }
 
 func (c *Context) deregister() {
 	ctxMutex.Lock()
 	defer ctxMutex.Unlock()
-	r := ctxRegistry[c.ref]
-	if r == nil {
+	v, ok := ctxRegistry.Load(c.ref)
+	if !ok {
 		return
 	}
+	r := v.(*ctxRef)
 	r.refCount--
 	if r.refCount <= 0 {
-		delete(ctxRegistry, c.ref)
+		ctxRegistry.Delete(c.ref)
 	}
 }
 
 func getContext(ref int) *Context {
-	ctxMutex.RLock()
-	defer ctxMutex.RUnlock()
-	r := ctxRegistry[ref]
-	if r == nil {
+	r, ok := ctxRegistry.Load(ref)
+	if !ok {
 		return nil
 	}
-	return r.ctx
-}
-
-//export goContext
-func goContext(ref int) C.ContextPtr {
-	ctx := getContext(ref)
-	return ctx.ptr
+	return r.(*ctxRef).ctx
 }
 
 func valueResult(ctx *Context, rtn C.RtnValue) (*Value, error) {
 	if rtn.value == nil {
 		return nil, newJSError(rtn.error)
 	}
-	return &Value{rtn.value, ctx}, nil
+	return newReleasableValue(ctx, rtn.value), nil
 }
 
 func objectResult(ctx *Context, rtn C.RtnValue) (*Object, error) {
 	if rtn.value == nil {
 		return nil, newJSError(rtn.error)
 	}
-	return &Object{&Value{rtn.value, ctx}}, nil
+	return &Object{newReleasableValue(ctx, rtn.value)}, nil
+}
+
+// newValue wraps ptr, which has just been returned by ctx, or by the isolate
+// if ctx is nil, in a Value.
+func newValue(ctx *Context, ptr C.ValuePtr) *Value {
+	v := &Value{ptr: ptr, ctx: ctx}
+	if ptr != nil {
+		v.gen = uint32((*C.ValueHead)(unsafe.Pointer(ptr)).gen)
+	}
+	return v
+}
+
+// newReleasableValue wraps ptr, which has just been returned by the context,
+// in a Value that is released once it is unreachable, if the isolate is
+// created with ReleaseUnreachableValues.
+func newReleasableValue(ctx *Context, ptr C.ValuePtr) *Value {
+	v := newValue(ctx, ptr)
+	if ctx != nil && ctx.iso.releaseUnreachable {
+		// The generation of the slot of the value tells whether the value is
+		// still in it once the finalizer runs, rather than released by a
+		// ValueScope.
+		runtime.SetFinalizer(v, func(v *Value) {
+			ctx.closeMutex.RLock()
+			if ctx.ptr != nil && v.ptr != nil {
+				C.ValueReleaseDeferred(v.ptr, C.uint32_t(v.gen))
+			}
+			ctx.closeMutex.RUnlock()
+		})
+	}
+	return v
 }
@@ -178,6 +178,122 @@ func ExampleContext() {
 	// 7
 }
 
+func TestContextReuseGlobal(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx1 := v8.NewContext(iso)
+	_, err := ctx1.RunScript("var x = 1", "x.js")
+	fatalIf(t, err)
+
+	global := ctx1.DetachGlobal()
+	ctx2 := v8.NewContext(iso, v8.ReuseGlobal(global))
+	defer ctx2.Close()
+	if !global.SameValue(ctx2.Global().Value) {
+		t.Error("expected the new context to reuse the detached global")
+	}
+	ctx1.Close()
+
+	val, err := ctx2.RunScript("var y = 2; typeof x", "y.js")
+	fatalIf(t, err)
+	if val.String() != "undefined" {
+		t.Errorf("expected the globals of the detached context to be left behind, got %q", val.String())
+	}
+}
+
+func TestContextOwnMicrotaskQueue(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx1 := v8.NewContext(iso, v8.OwnMicrotaskQueue)
+	defer ctx1.Close()
+	ctx2 := v8.NewContext(iso, v8.OwnMicrotaskQueue)
+	defer ctx2.Close()
+
+	const script = "var done = false; Promise.resolve().then(() => { done = true })"
+	for _, ctx := range []*v8.Context{ctx1, ctx2} {
+		_, err := ctx.RunScript(script, "promise.js")
+		fatalIf(t, err)
+	}
+	done := func(ctx *v8.Context) bool {
+		val, err := ctx.RunScript("done", "done.js")
+		fatalIf(t, err)
+		return val.Boolean()
+	}
+	if done(ctx1) || done(ctx2) {
+		t.Fatal("expected the microtasks to wait for a checkpoint")
+	}
+
+	ctx1.PerformMicrotaskCheckpoint()
+	if !done(ctx1) {
+		t.Error("expected the checkpoint to run the microtasks of its context")
+	}
+	if done(ctx2) {
+		t.Error("expected the checkpoint to leave the queue of the other context")
+	}
+	ctx2.PerformMicrotaskCheckpoint()
+	if !done(ctx2) {
+		t.Error("expected the microtasks of the other context to run")
+	}
+}
+
+// fillValues makes n values in ctx.
+func fillValues(t testing.TB, ctx *v8.Context, n int) {
+	obj, err := ctx.RunScript("({x: 1})", "fill.js")
+	if err != nil {
+		t.Fatal(err)
+	}
+	o, _ := obj.AsObject()
+	for i := 0; i < n; i++ {
+		if _, err := o.Get("x"); err != nil {
+			t.Fatal(err)
+		}
+	}
+}
+
+func TestContextCloseDeferred(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	for i := 0; i < 2; i++ {
+		ctx := v8.NewContext(iso)
+		fillValues(t, ctx, 10000)
+		ctx.CloseDeferred()
+	}
+	if iso.DeadValues() == 0 {
+		t.Fatal("expected the values of the contexts to be left")
+	}
+
+	left := iso.ReclaimContexts(1000)
+	if left < 19000 || left > 21000 {
+		t.Fatalf("expected about 19000 values left, got %d", left)
+	}
+	slices := 1
+	for ; left > 0; slices++ {
+		next := iso.ReclaimContexts(1000)
+		if next >= left {
+			t.Fatalf("expected progress, %d values left after %d", next, left)
+		}
+		left = next
+	}
+	if slices < 15 || iso.DeadValues() > 0 {
+		t.Errorf("expected about 20 slices, got %d", slices)
+	}
+
+	// The isolate stays usable, and frees what is left when disposed.
+	ctx := v8.NewContext(iso)
+	fillValues(t, ctx, 1000)
+	ctx.CloseDeferred()
+	if left := iso.ReclaimContexts(0); left != 0 {
+		t.Errorf("expected all values to be freed, got %d left", left)
+	}
+	ctx = v8.NewContext(iso)
+	ctx.CloseDeferred()
+}
+
 func ExampleContext_isolate() {
 	iso := v8.NewIsolate()
 	defer iso.Dispose()
@@ -208,3 +324,35 @@ func ExampleContext_globalTemplate() {
 	// Output:
 	// v1.0.0
 }
+
+func BenchmarkContextClose(b *testing.B) {
+	for _, deferred := range []bool{false, true} {
+		b.Run(fmt.Sprintf("deferred=%v", deferred), func(b *testing.B) {
+			iso := v8.NewIsolate()
+			defer iso.Dispose()
+			for n := 0; n < b.N; n++ {
+				b.StopTimer()
+				ctx := v8.NewContext(iso)
+				fillValues(b, ctx, 100000)
+				b.StartTimer()
+				if deferred {
+					ctx.CloseDeferred()
+				} else {
+					ctx.Close()
+				}
+				b.StopTimer()
+				iso.ReclaimContexts(0)
+				b.StartTimer()
+			}
+		})
+	}
+}
+
+func BenchmarkNewContext(b *testing.B) {
+	b.ReportAllocs()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	for n := 0; n < b.N; n++ {
+		v8.NewContext(iso).Close()
+	}
+}
@@ -0,0 +1,170 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"encoding/json"
+	"errors"
+	"fmt"
+	"sync"
+)
+
+// CoverageMode is how much a Coverage records of the code that runs.
+type CoverageMode int
+
+const (
+	// CoverageBestEffort reports the functions that have run, from the
+	// invocation counts that V8 keeps anyway, at no cost to the code that
+	// runs. The counts are not exact and may be lost once V8 has collected
+	// the feedback of a function, which makes it seem never to have run.
+	CoverageBestEffort CoverageMode = iota
+	// CoverageFunctions counts the calls of each function exactly, at the
+	// cost of keeping the feedback of every function alive.
+	CoverageFunctions
+	// CoverageBlocks also counts how often each block within a function,
+	// such as a branch of an if statement, has run, at the cost of
+	// instrumenting the code that runs.
+	CoverageBlocks
+)
+
+// CoverageRange is a range of the source of a script, between offsets in
+// UTF-16 code units, that ran Count times. The first range of a function
+// covers the whole function; the ranges after it are blocks within it whose
+// counts differ, and nest in the ranges before them.
+type CoverageRange struct {
+	StartOffset int `json:"startOffset"`
+	EndOffset   int `json:"endOffset"`
+	Count       int `json:"count"`
+}
+
+// FunctionCoverage is the coverage of a function of a script.
+type FunctionCoverage struct {
+	FunctionName string          `json:"functionName"`
+	Ranges       []CoverageRange `json:"ranges"`
+	// IsBlockCoverage is whether Ranges has the counts of the blocks within
+	// the function, as CoverageBlocks records them.
+	IsBlockCoverage bool `json:"isBlockCoverage"`
+}
+
+// ScriptCoverage is the coverage of a script, by the script's origin.
+type ScriptCoverage struct {
+	ScriptID  string             `json:"scriptId"`
+	URL       string             `json:"url"`
+	Functions []FunctionCoverage `json:"functions"`
+}
+
+// Coverage records which JavaScript of an isolate runs and how often, see
+// Context.StartCoverage.
+type Coverage struct {
+	mutex  sync.Mutex
+	mode   CoverageMode
+	client *inspectorClient
+}
+
+// StartCoverage starts to record the coverage of the JavaScript of the
+// context's isolate, in all of its contexts, in the given mode. The counts of
+// CoverageFunctions and CoverageBlocks start at zero for the code that has
+// run before, which runs slower once it is recompiled to count. The coverage
+// is recorded through a session of the isolate's inspector, until it is
+// stopped or the isolate is disposed of.
+func (c *Context) StartCoverage(mode CoverageMode) (*Coverage, error) {
+	if mode < CoverageBestEffort || mode > CoverageBlocks {
+		return nil, fmt.Errorf("v8go: invalid coverage mode %d", mode)
+	}
+	cov := &Coverage{mode: mode, client: newInspectorClient(c)}
+	err := cov.client.call("Profiler.enable", nil, nil)
+	if err == nil && mode != CoverageBestEffort {
+		err = cov.client.call("Profiler.startPreciseCoverage", map[string]bool{
+			"callCount": true,
+			"detailed":  mode == CoverageBlocks,
+		}, nil)
+	}
+	if err != nil {
+		cov.client.session.Close()
+		return nil, err
+	}
+	return cov, nil
+}
+
+// Take returns the coverage of the scripts of the isolate. The counts of
+// CoverageFunctions and CoverageBlocks are those since the last Take, which
+// resets them; those of CoverageBestEffort are since the functions were
+// compiled, or since their feedback was last collected.
+func (cov *Coverage) Take() ([]ScriptCoverage, error) {
+	cov.mutex.Lock()
+	defer cov.mutex.Unlock()
+	method := "Profiler.takePreciseCoverage"
+	if cov.mode == CoverageBestEffort {
+		method = "Profiler.getBestEffortCoverage"
+	}
+	var result struct {
+		Result []ScriptCoverage `json:"result"`
+	}
+	if err := cov.client.call(method, nil, &result); err != nil {
+		return nil, err
+	}
+	return result.Result, nil
+}
+
+// Stop stops recording the coverage, after which the code runs at its usual
+// speed again once it is recompiled.
+func (cov *Coverage) Stop() {
+	cov.mutex.Lock()
+	defer cov.mutex.Unlock()
+	cov.client.session.Close()
+}
+
+// inspectorClient drives a session of the inspector for v8go itself, one
+// command at a time.
+type inspectorClient struct {
+	session  *InspectorSession
+	id       int
+	response *inspectorResponse
+}
+
+type inspectorResponse struct {
+	ID     int             `json:"id"`
+	Result json.RawMessage `json:"result"`
+	Error  *struct {
+		Message string `json:"message"`
+	} `json:"error"`
+}
+
+func newInspectorClient(c *Context) *inspectorClient {
+	ic := &inspectorClient{}
+	ic.session = c.NewInspectorSession(func(message []byte) {
+		var r inspectorResponse
+		// Notifications have no id.
+		if json.Unmarshal(message, &r) == nil && r.ID == ic.id {
+			ic.response = &r
+		}
+	})
+	return ic
+}
+
+// call sends the command method to the inspector with params, unless nil,
+// and decodes its result into result, unless nil.
+func (ic *inspectorClient) call(method string, params interface{}, result interface{}) error {
+	ic.id++
+	ic.response = nil
+	msg, err := json.Marshal(struct {
+		ID     int         `json:"id"`
+		Method string      `json:"method"`
+		Params interface{} `json:"params,omitempty"`
+	}{ic.id, method, params})
+	if err != nil {
+		return err
+	}
+	ic.session.Dispatch(msg)
+	switch {
+	case ic.response == nil:
+		return errors.New("v8go: the inspector session is closed")
+	case ic.response.Error != nil:
+		return fmt.Errorf("v8go: %s: %s", method, ic.response.Error.Message)
+	case result != nil:
+		return json.Unmarshal(ic.response.Result, result)
+	}
+	return nil
+}
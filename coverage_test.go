@@ -0,0 +1,90 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+const coverageScript = `
+function used(x) {
+  if (x > 0) {
+    return 1;
+  }
+  return 2;
+}
+function unused() {}
+for (let i = 0; i < 3; i++) used(1);
+`
+
+func functionCoverage(scripts []v8.ScriptCoverage, url, name string) *v8.FunctionCoverage {
+	for _, s := range scripts {
+		if s.URL != url {
+			continue
+		}
+		for i, f := range s.Functions {
+			if f.FunctionName == name {
+				return &s.Functions[i]
+			}
+		}
+	}
+	return nil
+}
+
+func TestCoverage(t *testing.T) {
+	t.Parallel()
+
+	for _, mode := range []v8.CoverageMode{v8.CoverageBestEffort, v8.CoverageFunctions, v8.CoverageBlocks} {
+		iso := v8.NewIsolate()
+		ctx := v8.NewContext(iso)
+		cov, err := ctx.StartCoverage(mode)
+		fatalIf(t, err)
+		_, err = ctx.RunScript(coverageScript, "coverage.js")
+		fatalIf(t, err)
+		scripts, err := cov.Take()
+		fatalIf(t, err)
+
+		used := functionCoverage(scripts, "coverage.js", "used")
+		if used == nil || len(used.Ranges) == 0 || used.Ranges[0].Count == 0 {
+			t.Fatalf("mode %d: expected coverage of used, got %+v", mode, used)
+		}
+		if mode != v8.CoverageBestEffort && used.Ranges[0].Count != 3 {
+			t.Errorf("mode %d: expected 3 calls of used, got %+v", mode, used.Ranges)
+		}
+		if unused := functionCoverage(scripts, "coverage.js", "unused"); unused == nil || unused.Ranges[0].Count != 0 {
+			t.Errorf("mode %d: expected no calls of unused, got %+v", mode, unused)
+		}
+		if mode == v8.CoverageBlocks {
+			// The block after the early return never runs.
+			if !used.IsBlockCoverage || len(used.Ranges) < 2 || used.Ranges[len(used.Ranges)-1].Count != 0 {
+				t.Errorf("expected the block coverage of used, got %+v", used)
+			}
+			scripts, err = cov.Take()
+			fatalIf(t, err)
+			if used = functionCoverage(scripts, "coverage.js", "used"); used != nil && used.Ranges[0].Count != 0 {
+				t.Errorf("expected Take to reset the counts, got %+v", used.Ranges)
+			}
+		}
+		cov.Stop()
+		ctx.Close()
+		iso.Dispose()
+	}
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	if _, err := ctx.StartCoverage(v8.CoverageBlocks + 1); err == nil {
+		t.Error("expected an error for an invalid mode")
+	}
+	cov, err := ctx.StartCoverage(v8.CoverageFunctions)
+	fatalIf(t, err)
+	cov.Stop()
+	if _, err := cov.Take(); err == nil {
+		t.Error("expected an error once the coverage is stopped")
+	}
+}
@@ -0,0 +1,91 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"runtime"
+	"sync"
+	"time"
+)
+
+// ErrCPUBudgetExceeded is returned by RunScriptWithBudget when the script was
+// terminated for using up its CPU budget.
+var ErrCPUBudgetExceeded = errors.New("v8go: CPU budget exceeded")
+
+// CPUBudget limits the CPU time that JavaScript may use, as opposed to the
+// wall time that RunScriptWithTimeout limits; time the thread spends waiting,
+// or in Go callbacks that block, is not counted.
+type CPUBudget struct {
+	// Limit is the CPU time that may be used.
+	Limit time.Duration
+	// OnExceeded, if set, is called on the thread running the JavaScript once
+	// used exceeds the limit. It returns how much more CPU time may be used,
+	// or 0 to terminate the execution. It must not use the isolate.
+	OnExceeded func(used time.Duration) time.Duration
+}
+
+// cpuBudgetRegistry maps refs to the CPUBudget of RunScriptWithBudget calls
+// in progress.
+var cpuBudgetMutex sync.Mutex
+var cpuBudgetRegistry sync.Map
+var cpuBudgetSeq = 0
+
+// RunScriptWithBudget executes the source JavaScript like RunScript, and
+// terminates it once it has used up budget, in which case the error is
+// ErrCPUBudgetExceeded. The CPU time is sampled by the watchdog of the process
+// every few milliseconds, so a script may overrun its budget by that much.
+// The isolate can run JavaScript again once it has returned.
+func (c *Context) RunScriptWithBudget(source string, origin string, budget CPUBudget) (*Value, error) {
+	var val *Value
+	err := c.iso.withCPUBudget(budget, func() (err error) {
+		val, err = c.RunScript(source, origin)
+		return err
+	})
+	return val, err
+}
+
+// withCPUBudget calls run, having the isolate's execution terminated once the
+// CPU time of run exceeds budget. As the CPU time is that of the thread, run
+// is kept on the current OS thread.
+func (i *Isolate) withCPUBudget(budget CPUBudget, run func() error) error {
+	if budget.Limit <= 0 {
+		return ErrCPUBudgetExceeded
+	}
+	cpuBudgetMutex.Lock()
+	cpuBudgetSeq++
+	ref := cpuBudgetSeq
+	cpuBudgetMutex.Unlock()
+	cpuBudgetRegistry.Store(ref, budget)
+	defer cpuBudgetRegistry.Delete(ref)
+
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	id := C.IsolateArmCPUBudget(i.ptr, C.int64_t(budget.Limit), C.int(ref))
+	err := run()
+	if C.IsolateDisarmCPUBudget(i.ptr, id) != 0 && err != nil {
+		return ErrCPUBudgetExceeded
+	}
+	return err
+}
+
+//export goCPUBudgetExceeded
+func goCPUBudgetExceeded(ref C.int, used C.int64_t) C.int64_t {
+	v, ok := cpuBudgetRegistry.Load(int(ref))
+	if !ok {
+		return 0
+	}
+	budget := v.(CPUBudget)
+	if budget.OnExceeded == nil {
+		return 0
+	}
+	extension := budget.OnExceeded(time.Duration(used))
+	if extension < 0 {
+		return 0
+	}
+	return C.int64_t(extension)
+}
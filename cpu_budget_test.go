@@ -0,0 +1,69 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestRunScriptWithBudget(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	val, err := ctx.RunScriptWithBudget("1 + 1", "quick.js", v8.CPUBudget{Limit: time.Second})
+	fatalIf(t, err)
+	if val.Integer() != 2 {
+		t.Errorf("expected 2, got %v", val)
+	}
+
+	_, err = ctx.RunScriptWithBudget("for (;;) {}", "loop.js", v8.CPUBudget{Limit: 20 * time.Millisecond})
+	if err != v8.ErrCPUBudgetExceeded {
+		t.Fatalf("expected ErrCPUBudgetExceeded, got %v", err)
+	}
+
+	val, err = ctx.RunScript("'alive'", "after.js")
+	fatalIf(t, err)
+	if val.String() != "alive" {
+		t.Errorf("expected the isolate to run again, got %v", val)
+	}
+}
+
+func TestRunScriptWithBudgetExtended(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	var calls int
+	var last time.Duration
+	budget := v8.CPUBudget{
+		Limit: 10 * time.Millisecond,
+		OnExceeded: func(used time.Duration) time.Duration {
+			calls++
+			last = used
+			if calls < 3 {
+				return 10 * time.Millisecond
+			}
+			return 0
+		},
+	}
+	_, err := ctx.RunScriptWithBudget("for (;;) {}", "loop.js", budget)
+	if err != v8.ErrCPUBudgetExceeded {
+		t.Fatalf("expected ErrCPUBudgetExceeded, got %v", err)
+	}
+	if calls != 3 {
+		t.Errorf("expected OnExceeded to be called 3 times, got %d", calls)
+	}
+	if last < 30*time.Millisecond {
+		t.Errorf("expected at least 30ms of CPU time used, got %v", last)
+	}
+}
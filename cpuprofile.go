@@ -16,9 +16,16 @@ type CPUProfile struct {
 	// The CPU profile title.
 	title string
 
-	// root is the root node of the top down call tree.
+	// root is the root node of the top down call tree, which is built when
+	// it is first asked for.
 	root *CPUProfileNode
 
+	// interval is the sampling interval of the profiler.
+	interval time.Duration
+
+	// samplesCount is the number of samples that the profile recorded.
+	samplesCount int
+
 	// startTimeOffset is the time when the profile recording was started
 	// since some unspecified starting point.
 	startTimeOffset time.Duration
@@ -36,9 +43,51 @@ func (c *CPUProfile) GetTitle() string {
 
 // Returns the root node of the top down call tree.
 func (c *CPUProfile) GetTopDownRoot() *CPUProfileNode {
+	if c.root == nil && c.p != nil {
+		c.root = newCPUProfileNode(C.CPUProfileGetTopDownRoot(c.p), nil)
+	}
 	return c.root
 }
 
+// CPUProfileSample is a sample recorded by a CPU profile: the node of the
+// function that was running, and when.
+type CPUProfileSample struct {
+	// NodeID is the id of the node, see CPUProfileNode.GetNodeId.
+	NodeID int
+	// Timestamp is the time of the sample since the same unspecified point
+	// as the start and end of the profile.
+	Timestamp time.Duration
+}
+
+// Returns the samples of the profile in the order they were taken, if it was
+// started with the RecordSamples option.
+func (c *CPUProfile) GetSamples() []CPUProfileSample {
+	if c.p == nil || c.samplesCount == 0 {
+		return nil
+	}
+	ids := make([]C.uint, c.samplesCount)
+	timestamps := make([]C.int64_t, c.samplesCount)
+	C.CPUProfileGetSamples(c.p, &ids[0], &timestamps[0])
+	samples := make([]CPUProfileSample, c.samplesCount)
+	for i := range samples {
+		samples[i] = CPUProfileSample{
+			NodeID:    int(ids[i]),
+			Timestamp: time.Duration(timestamps[i]) * time.Microsecond,
+		}
+	}
+	return samples
+}
+
+// Returns the start time of the profile since some unspecified point.
+func (c *CPUProfile) GetStartTime() time.Duration {
+	return c.startTimeOffset
+}
+
+// Returns the end time of the profile since the same point as the start time.
+func (c *CPUProfile) GetEndTime() time.Duration {
+	return c.endTimeOffset
+}
+
 // Returns the duration of the profile.
 func (c *CPUProfile) GetDuration() time.Duration {
 	return c.endTimeOffset - c.startTimeOffset
@@ -0,0 +1,168 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"compress/gzip"
+	"errors"
+	"io"
+	"time"
+	"unsafe"
+)
+
+// WritePprof writes the profile to w in the gzipped protocol buffer format of
+// pprof, with a sample count and CPU time for each call stack. The profile is
+// read as flat tables with shared strings, without building the node tree of
+// GetTopDownRoot.
+func (c *CPUProfile) WritePprof(w io.Writer) error {
+	if c.p == nil {
+		return errors.New("v8go: CPU profile has been deleted")
+	}
+	table := C.CPUProfileGetTable(c.p)
+	defer C.CPUProfileTableFree(table)
+	nodes := (*[1 << 28]C.CPUProfileTableNode)(unsafe.Pointer(table.nodes))[:table.nodeCount:table.nodeCount]
+	functions := (*[1 << 28]C.CPUProfileTableFunction)(unsafe.Pointer(table.functions))[:table.functionCount:table.functionCount]
+	offsets := (*[1 << 28]C.int)(unsafe.Pointer(table.stringOffsets))[: table.stringCount+1 : table.stringCount+1]
+	data := (*[1 << 30]byte)(unsafe.Pointer(table.stringData))[:offsets[table.stringCount]:offsets[table.stringCount]]
+
+	// The strings of the sample and period types follow those of the table.
+	strSamples := int64(table.stringCount)
+	strCount, strCPU, strNanoseconds := strSamples+1, strSamples+2, strSamples+3
+
+	var b protobuf
+	valueType := func(tag int, typ, unit int64) {
+		start := b.startMessage()
+		b.int64(1, typ)
+		b.int64(2, unit)
+		b.endMessage(tag, start)
+	}
+	valueType(1, strSamples, strCount)
+	valueType(1, strCPU, strNanoseconds)
+
+	// A sample for each node that was hit, with the stack of the node up to,
+	// but excluding, the root node 0.
+	var stack []uint64
+	for i, node := range nodes {
+		if node.hitCount == 0 || i == 0 {
+			continue
+		}
+		stack = stack[:0]
+		for n := i; n > 0; n = int(nodes[n].parent) {
+			stack = append(stack, uint64(n))
+		}
+		start := b.startMessage()
+		b.packedUint64(1, stack)
+		hits := int64(node.hitCount)
+		b.packedInt64(2, []int64{hits, hits * int64(c.interval)})
+		b.endMessage(2, start)
+	}
+	// A location for each node, in its function.
+	for i, node := range nodes[1:] {
+		start := b.startMessage()
+		b.uint64(1, uint64(i+1))
+		line := b.startMessage()
+		b.uint64(1, uint64(node.function)+1)
+		b.int64(2, int64(node.line))
+		b.endMessage(4, line)
+		b.endMessage(4, start)
+	}
+	for i, fn := range functions {
+		start := b.startMessage()
+		b.uint64(1, uint64(i+1))
+		b.int64(2, int64(fn.name))
+		b.int64(3, int64(fn.name))
+		b.int64(4, int64(fn.scriptName))
+		b.int64(5, int64(fn.line))
+		b.endMessage(5, start)
+	}
+	for i := 0; i < int(table.stringCount); i++ {
+		b.bytes(6, data[offsets[i]:offsets[i+1]])
+	}
+	for _, s := range []string{"samples", "count", "cpu", "nanoseconds"} {
+		b.bytes(6, []byte(s))
+	}
+	duration := c.GetDuration()
+	b.int64(9, time.Now().Add(-duration).UnixNano())
+	b.int64(10, int64(duration))
+	valueType(11, strCPU, strNanoseconds)
+	b.int64(12, int64(c.interval))
+
+	zw := gzip.NewWriter(w)
+	if _, err := zw.Write(b.buf); err != nil {
+		return err
+	}
+	return zw.Close()
+}
+
+// protobuf encodes the protocol buffer messages of a pprof profile.
+type protobuf struct {
+	buf []byte
+}
+
+func (b *protobuf) varint(x uint64) {
+	for x >= 0x80 {
+		b.buf = append(b.buf, byte(x)|0x80)
+		x >>= 7
+	}
+	b.buf = append(b.buf, byte(x))
+}
+
+func (b *protobuf) key(tag int, wireType int) {
+	b.varint(uint64(tag)<<3 | uint64(wireType))
+}
+
+func (b *protobuf) uint64(tag int, x uint64) {
+	if x == 0 {
+		return
+	}
+	b.key(tag, 0)
+	b.varint(x)
+}
+
+func (b *protobuf) int64(tag int, x int64) {
+	b.uint64(tag, uint64(x))
+}
+
+func (b *protobuf) bytes(tag int, s []byte) {
+	b.key(tag, 2)
+	b.varint(uint64(len(s)))
+	b.buf = append(b.buf, s...)
+}
+
+func (b *protobuf) packedUint64(tag int, xs []uint64) {
+	start := b.startMessage()
+	for _, x := range xs {
+		b.varint(x)
+	}
+	b.endMessage(tag, start)
+}
+
+func (b *protobuf) packedInt64(tag int, xs []int64) {
+	start := b.startMessage()
+	for _, x := range xs {
+		b.varint(uint64(x))
+	}
+	b.endMessage(tag, start)
+}
+
+// startMessage starts a length delimited field, which its fields are encoded
+// into until endMessage.
+func (b *protobuf) startMessage() int {
+	return len(b.buf)
+}
+
+// endMessage ends the field started at start, moving its contents behind its
+// key and length.
+func (b *protobuf) endMessage(tag int, start int) {
+	n := len(b.buf) - start
+	h := protobuf{buf: make([]byte, 0, 20)}
+	h.key(tag, 2)
+	h.varint(uint64(n))
+	b.buf = append(b.buf, h.buf...)
+	copy(b.buf[start+len(h.buf):], b.buf[start:start+n])
+	copy(b.buf[start:], h.buf)
+}
@@ -0,0 +1,75 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"fmt"
+	"sync/atomic"
+	"time"
+)
+
+// continuousProfileSeq makes the titles of the profiles of continuous
+// profiling unique.
+var continuousProfileSeq uint64
+
+// ContinuousProfiling collects CPU profiles back to back, handing each one to
+// Go once it has covered its period, see StartContinuousProfiling.
+type ContinuousProfiling struct {
+	profiler *CPUProfiler
+	opts     CPUProfilingOptions
+	handle   func(*CPUProfile)
+	stop     chan struct{}
+	done     chan struct{}
+}
+
+// StartContinuousProfiling starts collecting CPU profiles with opts, each for
+// period, until Stop is called. The next profile is started before the
+// previous one is stopped, so the profiler samples without a gap. handle is
+// called with each profile, which it must Delete, from a goroutine of its
+// own; the profiles are taken while the isolate runs no JavaScript, so a
+// period can be extended by the script that is running.
+func (c *CPUProfiler) StartContinuousProfiling(period time.Duration, opts CPUProfilingOptions, handle func(*CPUProfile)) *ContinuousProfiling {
+	p := &ContinuousProfiling{
+		profiler: c,
+		opts:     opts,
+		handle:   handle,
+		stop:     make(chan struct{}),
+		done:     make(chan struct{}),
+	}
+	title := p.start()
+	go p.run(period, title)
+	return p
+}
+
+// Stop stops collecting profiles once the profile being collected has been
+// handed to Go. It must be called before the profiler is disposed of.
+func (p *ContinuousProfiling) Stop() {
+	close(p.stop)
+	<-p.done
+}
+
+// start starts the next profile, returning its title.
+func (p *ContinuousProfiling) start() string {
+	title := fmt.Sprintf("v8go-continuous-%d", atomic.AddUint64(&continuousProfileSeq, 1))
+	p.profiler.StartProfilingWithOptions(title, p.opts)
+	return title
+}
+
+func (p *ContinuousProfiling) run(period time.Duration, title string) {
+	defer close(p.done)
+	ticker := time.NewTicker(period)
+	defer ticker.Stop()
+	for {
+		select {
+		case <-ticker.C:
+			next := p.start()
+			p.handle(p.profiler.StopProfiling(title))
+			title = next
+		case <-p.stop:
+			p.handle(p.profiler.StopProfiling(title))
+			return
+		}
+	}
+}
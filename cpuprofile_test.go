@@ -5,6 +5,9 @@
 package v8go_test
 
 import (
+	"bytes"
+	"compress/gzip"
+	"io/ioutil"
 	"testing"
 
 	v8 "rogchap.com/v8go"
@@ -68,3 +71,106 @@ func TestCPUProfile_Delete(t *testing.T) {
 	// noop when called multiple times
 	cpuProfile.Delete()
 }
+
+func TestCPUProfileWritePprof(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext(nil)
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	cpuProfiler := v8.NewCPUProfiler(iso)
+	defer cpuProfiler.Dispose()
+
+	cpuProfiler.StartProfiling("pprof")
+	_, err := ctx.RunScript(profileScript, "script.js")
+	fatalIf(t, err)
+	val, err := ctx.Global().Get("start")
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	_, err = fn.Call(ctx.Global())
+	fatalIf(t, err)
+	cpuProfile := cpuProfiler.StopProfiling("pprof")
+
+	var buf bytes.Buffer
+	fatalIf(t, cpuProfile.WritePprof(&buf))
+	zr, err := gzip.NewReader(&buf)
+	fatalIf(t, err)
+	profile, err := ioutil.ReadAll(zr)
+	fatalIf(t, err)
+	for _, s := range []string{"delay", "loop", "script.js", "samples", "nanoseconds"} {
+		if n := bytes.Count(profile, []byte(s)); n != 1 {
+			t.Errorf("expected the string %q once in the string table, got %d", s, n)
+		}
+	}
+
+	cpuProfile.Delete()
+	if err := cpuProfile.WritePprof(&buf); err == nil {
+		t.Error("expected an error writing a deleted profile")
+	}
+}
+
+func TestCPUProfileGetSamples(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext(nil)
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	cpuProfiler := v8.NewCPUProfiler(iso)
+	defer cpuProfiler.Dispose()
+
+	cpuProfiler.StartProfilingWithOptions("samples", v8.CPUProfilingOptions{RecordSamples: true})
+	cpuProfiler.StartProfiling("aggregated")
+	_, err := ctx.RunScript(profileScript, "script.js")
+	fatalIf(t, err)
+	val, err := ctx.Global().Get("start")
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	_, err = fn.Call(ctx.Global())
+	fatalIf(t, err)
+	aggregated := cpuProfiler.StopProfiling("aggregated")
+	defer aggregated.Delete()
+	cpuProfile := cpuProfiler.StopProfiling("samples")
+	defer cpuProfile.Delete()
+
+	if samples := aggregated.GetSamples(); len(samples) != 0 {
+		t.Errorf("expected no samples without RecordSamples, got %d", len(samples))
+	}
+
+	samples := cpuProfile.GetSamples()
+	if len(samples) == 0 {
+		t.Fatal("expected samples")
+	}
+	nodes := map[int]*v8.CPUProfileNode{}
+	var walk func(n *v8.CPUProfileNode)
+	walk = func(n *v8.CPUProfileNode) {
+		nodes[n.GetNodeId()] = n
+		for i := 0; i < n.GetChildrenCount(); i++ {
+			walk(n.GetChild(i))
+		}
+	}
+	walk(cpuProfile.GetTopDownRoot())
+	var loops int
+	prev := cpuProfile.GetStartTime()
+	for _, s := range samples {
+		node, ok := nodes[s.NodeID]
+		if !ok {
+			t.Fatalf("sample of unknown node %d", s.NodeID)
+		}
+		if node.GetFunctionName() == "loop" {
+			loops++
+		}
+		if s.Timestamp < prev || s.Timestamp > cpuProfile.GetEndTime() {
+			t.Errorf("sample at %v out of order, after %v and before the end at %v", s.Timestamp, prev, cpuProfile.GetEndTime())
+		}
+		prev = s.Timestamp
+	}
+	if loops == 0 {
+		t.Error("expected samples in loop")
+	}
+}
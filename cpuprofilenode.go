@@ -4,7 +4,42 @@
 
 package v8go
 
+// CPUProfileSourceType is what the function of a CPUProfileNode is.
+type CPUProfileSourceType int
+
+const (
+	// CPUProfileSourceScript is a function of a script.
+	CPUProfileSourceScript CPUProfileSourceType = iota
+	// CPUProfileSourceBuiltin is a builtin function or native script.
+	CPUProfileSourceBuiltin
+	// CPUProfileSourceCallback is a callback into native code, such as Go.
+	CPUProfileSourceCallback
+	// CPUProfileSourceInternal is internal to V8, such as the garbage
+	// collector.
+	CPUProfileSourceInternal
+	// CPUProfileSourceUnresolved is a function that could not be symbolized.
+	CPUProfileSourceUnresolved
+)
+
+// CPUProfileLineTick is the number of samples taken while a line of a
+// function was running.
+type CPUProfileLineTick struct {
+	Line     int
+	HitCount int
+}
+
+// CPUProfileDeoptInfo is a deoptimization of the function of a node, with the
+// position in the script of the innermost frame of the deoptimized code.
+type CPUProfileDeoptInfo struct {
+	Reason   string
+	ScriptID int
+	Position int
+}
+
 type CPUProfileNode struct {
+	// The id of the node, unique within its profile.
+	nodeID int
+
 	// The resource name for script from where the function originates.
 	scriptResourceName string
 
@@ -17,6 +52,24 @@ type CPUProfileNode struct {
 	// The number of the column where the function originates.
 	columnNumber int
 
+	// The id of the script where the function originates.
+	scriptID int
+
+	// The number of samples taken while the function itself was running.
+	hitCount int
+
+	// The reason the function was not optimized, if any.
+	bailoutReason string
+
+	// What the function is, a script function or not.
+	sourceType CPUProfileSourceType
+
+	// The hits of each line of the function that was hit.
+	lineTicks []CPUProfileLineTick
+
+	// The deoptimizations of the function.
+	deoptInfos []CPUProfileDeoptInfo
+
 	// The children node of this node.
 	children []*CPUProfileNode
 
@@ -24,6 +77,11 @@ type CPUProfileNode struct {
 	parent *CPUProfileNode
 }
 
+// Returns the id of the node, which the samples of the profile refer to.
+func (c *CPUProfileNode) GetNodeId() int {
+	return c.nodeID
+}
+
 // Returns function name (empty string for anonymous functions.)
 func (c *CPUProfileNode) GetFunctionName() string {
 	return c.functionName
@@ -44,6 +102,38 @@ func (c *CPUProfileNode) GetColumnNumber() int {
 	return c.columnNumber
 }
 
+// Returns the id of the script where the function originates.
+func (c *CPUProfileNode) GetScriptId() int {
+	return c.scriptID
+}
+
+// Returns the number of samples taken while the function itself, as opposed
+// to its callees, was running.
+func (c *CPUProfileNode) GetHitCount() int {
+	return c.hitCount
+}
+
+// Returns the reason the function was not optimized, or an empty string.
+func (c *CPUProfileNode) GetBailoutReason() string {
+	return c.bailoutReason
+}
+
+// Returns what the function is, a script function or not.
+func (c *CPUProfileNode) GetSourceType() CPUProfileSourceType {
+	return c.sourceType
+}
+
+// Returns the number of samples taken on each line of the function that was
+// running when one was taken.
+func (c *CPUProfileNode) GetLineTicks() []CPUProfileLineTick {
+	return c.lineTicks
+}
+
+// Returns the deoptimizations of the function.
+func (c *CPUProfileNode) GetDeoptInfos() []CPUProfileDeoptInfo {
+	return c.deoptInfos
+}
+
 // Retrieves the ancestor node, or nil if the root.
 func (c *CPUProfileNode) GetParent() *CPUProfileNode {
 	return c.parent
@@ -110,3 +110,96 @@ func checkNode(t *testing.T, node *v8.CPUProfileNode, scriptResourceName string,
 		t.Fatalf("expected node at column %d, but got %d", column, node.GetColumnNumber())
 	}
 }
+
+func TestCPUProfileNodeMetadata(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext(nil)
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	cpuProfiler := v8.NewCPUProfiler(iso)
+	defer cpuProfiler.Dispose()
+
+	cpuProfiler.StartProfiling("metadata")
+	_, err := ctx.RunScript(profileScript, "script.js")
+	fatalIf(t, err)
+	val, err := ctx.Global().Get("start")
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	timeout, err := v8.NewValue(iso, int32(200))
+	fatalIf(t, err)
+	_, err = fn.Call(ctx.Global(), timeout)
+	fatalIf(t, err)
+	cpuProfile := cpuProfiler.StopProfiling("metadata")
+	defer cpuProfile.Delete()
+
+	startNode := findChild(t, cpuProfile.GetTopDownRoot(), "start")
+	loopNode := findChild(t, findChild(t, findChild(t, startNode, "foo"), "delay"), "loop")
+	if loopNode.GetSourceType() != v8.CPUProfileSourceScript || loopNode.GetScriptId() == 0 {
+		t.Errorf("expected loop to be a script function, got %v in script %d", loopNode.GetSourceType(), loopNode.GetScriptId())
+	}
+	if loopNode.GetHitCount() == 0 {
+		t.Fatal("expected loop to be hit")
+	}
+	var ticks int
+	for _, tick := range loopNode.GetLineTicks() {
+		if tick.Line < 1 || tick.Line > 10 {
+			t.Errorf("unexpected tick %+v outside of loop", tick)
+		}
+		ticks += tick.HitCount
+	}
+	if ticks != loopNode.GetHitCount() {
+		t.Errorf("expected the line ticks to add up to the %d hits, got %d", loopNode.GetHitCount(), ticks)
+	}
+	for _, info := range loopNode.GetDeoptInfos() {
+		if info.Reason == "" {
+			t.Errorf("expected the deoptimization to have a reason, got %+v", info)
+		}
+	}
+}
+
+func TestCPUProfileNodeDeoptInfos(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext(nil)
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	cpuProfiler := v8.NewCPUProfiler(iso)
+	defer cpuProfiler.Dispose()
+
+	// run is optimized for numbers, and deoptimized once it gets a string.
+	cpuProfiler.StartProfiling("deopt")
+	_, err := ctx.RunScript(`
+function add(a, b) { return a + b }
+function run(x, n) { let s = x; for (let i = 0; i < n; i++) s = add(s, i); return s }
+for (let k = 0; k < 20; k++) run(0, 1e5);
+for (let k = 0; k < 5; k++) run("a", 1e4);`, "deopt.js")
+	fatalIf(t, err)
+	cpuProfile := cpuProfiler.StopProfiling("deopt")
+	defer cpuProfile.Delete()
+
+	var infos []v8.CPUProfileDeoptInfo
+	var walk func(n *v8.CPUProfileNode)
+	walk = func(n *v8.CPUProfileNode) {
+		if n.GetFunctionName() == "run" {
+			infos = append(infos, n.GetDeoptInfos()...)
+		}
+		for i := 0; i < n.GetChildrenCount(); i++ {
+			walk(n.GetChild(i))
+		}
+	}
+	walk(cpuProfile.GetTopDownRoot())
+	if len(infos) == 0 {
+		t.Fatal("expected run to be deoptimized")
+	}
+	for _, info := range infos {
+		if info.Reason == "" || info.ScriptID == 0 || info.Position == 0 {
+			t.Errorf("unexpected deoptimization %+v", info)
+		}
+	}
+}
@@ -14,17 +14,51 @@ import (
 	"unsafe"
 )
 
+// CPUProfilingMode is how the line numbers of the nodes of a CPU profile are
+// computed.
+type CPUProfilingMode int
+
+const (
+	// CPUProfilingLeafNodeLineNumbers gives intermediate nodes the line at
+	// which their function starts. It is the default.
+	CPUProfilingLeafNodeLineNumbers CPUProfilingMode = C.CPU_PROFILING_LEAF_NODE_LINE_NUMBERS
+	// CPUProfilingCallerLineNumbers gives intermediate nodes the line of the
+	// call site of their child, with a node for each distinct call site.
+	CPUProfilingCallerLineNumbers CPUProfilingMode = C.CPU_PROFILING_CALLER_LINE_NUMBERS
+)
+
+// CPUProfilingOptions configures a CPU profile, see StartProfilingWithOptions.
+type CPUProfilingOptions struct {
+	Mode CPUProfilingMode
+	// RecordSamples makes the profile record each of its samples, with its
+	// timestamp, which CPUProfile.GetSamples returns; MaxSamples is the
+	// number of samples recorded at most, and 0 means no limit.
+	RecordSamples bool
+	MaxSamples    uint
+	// SamplingInterval is a lower bound of the interval at which the profile
+	// records samples, rounded to a multiple of the interval of the profiler;
+	// 0 means every sample of the profiler.
+	SamplingInterval time.Duration
+}
+
 type CPUProfiler struct {
 	p   *C.CPUProfiler
 	iso *Isolate
+
+	// interval is the sampling interval of the profiler.
+	interval time.Duration
 }
 
+// defaultSamplingInterval is the sampling interval of V8's CPU profiler.
+const defaultSamplingInterval = time.Millisecond
+
 // CPUProfiler is used to control CPU profiling.
 func NewCPUProfiler(iso *Isolate) *CPUProfiler {
 	profiler := C.NewCPUProfiler(iso.ptr)
 	return &CPUProfiler{
-		p:   profiler,
-		iso: iso,
+		p:        profiler,
+		iso:      iso,
+		interval: defaultSamplingInterval,
 	}
 }
 
@@ -52,6 +86,51 @@ func (c *CPUProfiler) StartProfiling(title string) {
 	C.CPUProfilerStartProfiling(c.p, tstr)
 }
 
+// SetSamplingInterval changes the interval at which the profiler samples, by
+// default 1ms. It must be called while no profile is being collected.
+func (c *CPUProfiler) SetSamplingInterval(interval time.Duration) {
+	if c.p == nil || c.iso.ptr == nil {
+		panic("profiler or isolate are nil")
+	}
+	C.CPUProfilerSetSamplingInterval(c.p, C.int(interval/time.Microsecond))
+	c.interval = interval
+}
+
+// SetUsePreciseSampling sets whether the profiler favors the regularity of its
+// samples over CPU usage, which matters on Windows only; it does by default.
+func (c *CPUProfiler) SetUsePreciseSampling(precise bool) {
+	if c.p == nil || c.iso.ptr == nil {
+		panic("profiler or isolate are nil")
+	}
+	var cprecise C.int
+	if precise {
+		cprecise = 1
+	}
+	C.CPUProfilerSetUsePreciseSampling(c.p, cprecise)
+}
+
+// StartProfilingWithOptions starts collecting a CPU profile like
+// StartProfiling, with the given options.
+func (c *CPUProfiler) StartProfilingWithOptions(title string, opts CPUProfilingOptions) {
+	if c.p == nil || c.iso.ptr == nil {
+		panic("profiler or isolate are nil")
+	}
+
+	tstr := C.CString(title)
+	defer C.free(unsafe.Pointer(tstr))
+
+	var record C.int
+	if opts.RecordSamples {
+		record = 1
+	}
+	C.CPUProfilerStartProfilingWithOptions(c.p, tstr, C.CPUProfilingOptions{
+		mode:               C.int(opts.Mode),
+		recordSamples:      record,
+		maxSamples:         C.uint(opts.MaxSamples),
+		samplingIntervalUs: C.int(opts.SamplingInterval / time.Microsecond),
+	})
+}
+
 // Stops collecting CPU profile with a given title and returns it.
 // If the title given is empty, finishes the last profile started.
 func (c *CPUProfiler) StopProfiling(title string) *CPUProfile {
@@ -67,21 +146,45 @@ func (c *CPUProfiler) StopProfiling(title string) *CPUProfile {
 	return &CPUProfile{
 		p:               profile,
 		title:           C.GoString(profile.title),
-		root:            newCPUProfileNode(profile.root, nil),
-		startTimeOffset: time.Duration(profile.startTime) * time.Millisecond,
-		endTimeOffset:   time.Duration(profile.endTime) * time.Millisecond,
+		interval:        c.interval,
+		samplesCount:    int(profile.samplesCount),
+		startTimeOffset: time.Duration(profile.startTime) * time.Microsecond,
+		endTimeOffset:   time.Duration(profile.endTime) * time.Microsecond,
 	}
 }
 
 func newCPUProfileNode(node *C.CPUProfileNode, parent *CPUProfileNode) *CPUProfileNode {
 	n := &CPUProfileNode{
+		nodeID:             int(node.nodeId),
 		scriptResourceName: C.GoString(node.scriptResourceName),
 		functionName:       C.GoString(node.functionName),
 		lineNumber:         int(node.lineNumber),
 		columnNumber:       int(node.columnNumber),
+		scriptID:           int(node.scriptId),
+		hitCount:           int(node.hitCount),
+		bailoutReason:      C.GoString(node.bailoutReason),
+		sourceType:         CPUProfileSourceType(node.sourceType),
 		parent:             parent,
 	}
 
+	if node.lineTickCount > 0 {
+		n.lineTicks = make([]CPUProfileLineTick, node.lineTickCount)
+		for i, tick := range (*[1 << 28]C.CPUProfileLineTick)(unsafe.Pointer(node.lineTicks))[:node.lineTickCount:node.lineTickCount] {
+			n.lineTicks[i] = CPUProfileLineTick{Line: int(tick.line), HitCount: int(tick.hitCount)}
+		}
+	}
+
+	if node.deoptInfoCount > 0 {
+		n.deoptInfos = make([]CPUProfileDeoptInfo, node.deoptInfoCount)
+		for i, info := range (*[1 << 28]C.CPUProfileDeoptInfo)(unsafe.Pointer(node.deoptInfos))[:node.deoptInfoCount:node.deoptInfoCount] {
+			n.deoptInfos[i] = CPUProfileDeoptInfo{
+				Reason:   C.GoString(info.reason),
+				ScriptID: int(info.scriptId),
+				Position: int(info.position),
+			}
+		}
+	}
+
 	if node.childrenCount > 0 {
 		n.children = make([]*CPUProfileNode, node.childrenCount)
 		for i, child := range (*[1 << 28]*C.CPUProfileNode)(unsafe.Pointer(node.children))[:node.childrenCount:node.childrenCount] {
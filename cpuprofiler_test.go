@@ -6,6 +6,7 @@ package v8go_test
 
 import (
 	"testing"
+	"time"
 
 	v8 "rogchap.com/v8go"
 )
@@ -107,3 +108,75 @@ function start(timeout) {
   } while (duration < timeout);
   return duration;
 };`
+
+func TestCPUProfilerOptions(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext(nil)
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	cpuProfiler := v8.NewCPUProfiler(iso)
+	defer cpuProfiler.Dispose()
+	cpuProfiler.SetSamplingInterval(100 * time.Microsecond)
+	cpuProfiler.SetUsePreciseSampling(false)
+
+	cpuProfiler.StartProfilingWithOptions("options", v8.CPUProfilingOptions{
+		Mode:       v8.CPUProfilingCallerLineNumbers,
+		MaxSamples: 1000,
+	})
+	_, err := ctx.RunScript(profileScript, "script.js")
+	fatalIf(t, err)
+	val, err := ctx.Global().Get("start")
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	_, err = fn.Call(ctx.Global())
+	fatalIf(t, err)
+	cpuProfile := cpuProfiler.StopProfiling("options")
+	defer cpuProfile.Delete()
+
+	if cpuProfile.GetTitle() != "options" {
+		t.Errorf("expected the profile to be titled options, got %q", cpuProfile.GetTitle())
+	}
+	if cpuProfile.GetTopDownRoot().GetChildrenCount() == 0 {
+		t.Error("expected the profile to have samples")
+	}
+}
+
+func TestCPUProfilerContinuousProfiling(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext(nil)
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	cpuProfiler := v8.NewCPUProfiler(iso)
+	defer cpuProfiler.Dispose()
+
+	profiles := make(chan *v8.CPUProfile, 100)
+	continuous := cpuProfiler.StartContinuousProfiling(10*time.Millisecond, v8.CPUProfilingOptions{}, func(p *v8.CPUProfile) {
+		profiles <- p
+	})
+	for i := 0; i < 5; i++ {
+		_, err := ctx.RunScript("for (let i = 0; i < 1e5; i++) Math.sqrt(i)", "work.js")
+		fatalIf(t, err)
+		time.Sleep(10 * time.Millisecond)
+	}
+	continuous.Stop()
+	close(profiles)
+
+	titles := map[string]bool{}
+	for p := range profiles {
+		if titles[p.GetTitle()] {
+			t.Errorf("profile %q handed over twice", p.GetTitle())
+		}
+		titles[p.GetTitle()] = true
+		p.Delete()
+	}
+	if len(titles) < 2 {
+		t.Errorf("expected several profiles, got %d", len(titles))
+	}
+}
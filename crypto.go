@@ -0,0 +1,18 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// Crypto installs a crypto object in the global object of the context, with
+// the getRandomValues and randomUUID methods of the Web Crypto API. They are
+// implemented natively, without calling into Go: getRandomValues fills the
+// backing store of the integer typed array it is given in place, of at most
+// 64KB, and randomUUID returns a random version 4 UUID. Their random bytes
+// come from a pool of each thread, which is refilled 4KB at a time from the
+// CSPRNG of the operating system, getrandom on Linux. A process that forks
+// without exec must not use them in both the parent and the child, which
+// would share the pool.
+var Crypto ContextOption = contextOptionFunc(func(opts *contextOptions) {
+	opts.crypto = true
+})
@@ -0,0 +1,74 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"regexp"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestCrypto(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Crypto)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`
+		const a = new Uint8Array(64), b = new Uint32Array(8);
+		const same = crypto.getRandomValues(a) === a && crypto.getRandomValues(b) === b;
+		const big = crypto.getRandomValues(new Uint8Array(65536));
+		const part = new Uint8Array(16);
+		crypto.getRandomValues(part.subarray(4, 12));
+		[same, a.some((x) => x !== 0), b.some((x) => x !== 0), big.some((x) => x !== 0),
+			part.slice(0, 4).every((x) => x === 0) && part.slice(12).every((x) => x === 0)].join()`, "random.js")
+	fatalIf(t, err)
+	if got := val.String(); got != "true,true,true,true,true" {
+		t.Errorf("expected the arrays to be filled in place, got %q", got)
+	}
+
+	uuid := regexp.MustCompile(`^[0-9a-f]{8}-[0-9a-f]{4}-4[0-9a-f]{3}-[89ab][0-9a-f]{3}-[0-9a-f]{12}$`)
+	val, err = ctx.RunScript(`Array.from({length: 100}, () => crypto.randomUUID()).join(" ")`, "uuid.js")
+	fatalIf(t, err)
+	seen := make(map[string]bool)
+	for _, id := range strings.Fields(val.String()) {
+		if !uuid.MatchString(id) || seen[id] {
+			t.Errorf("expected a new version 4 UUID, got %q", id)
+		}
+		seen[id] = true
+	}
+
+	val, err = ctx.RunScript(`
+		const errors = [];
+		for (const f of [() => crypto.getRandomValues(new Float64Array(1)), () => crypto.getRandomValues([1]),
+			() => crypto.getRandomValues(new Uint8Array(65537))]) {
+			try { f(); } catch (e) { errors.push(e.name); }
+		}
+		errors.join()`, "errors.js")
+	fatalIf(t, err)
+	if got := val.String(); got != "TypeError,TypeError,RangeError" {
+		t.Errorf("expected errors for invalid arrays, got %q", got)
+	}
+}
+
+func BenchmarkCryptoRandomUUID(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Crypto)
+	defer ctx.Close()
+	fn, _ := ctx.RunScript(`(n) => { for (let i = 0; i < n; i++) crypto.randomUUID(); }`, "bench.js")
+	f, _ := fn.AsFunction()
+	n, _ := v8.NewValue(iso, int32(1000))
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := f.Call(v8.Undefined(iso), n); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
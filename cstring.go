@@ -0,0 +1,186 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"sync"
+	"unsafe"
+)
+
+// externalStringMinLength is the length from which ASCII strings are passed to
+// V8 as external strings, which V8 uses in place rather than copying them onto
+// its heap. Shorter strings are cheaper to copy than to track.
+const externalStringMinLength = 64 << 10
+
+// maxStringLength is the length of the longest string V8 can create, its
+// String::kMaxLength on 64-bit platforms.
+const maxStringLength = 1<<29 - 24
+
+// stringArg prepares s to be passed to C without copying it to a C string.
+// Unless the StringArg is external, it points into s, so the caller must keep
+// s alive until the call has returned.
+func stringArg(s string) C.StringArg {
+	if len(s) >= externalStringMinLength && isASCII(s) {
+		// ASCII is valid Latin-1, so the bytes can be used as a one-byte
+		// string as is; the copy is owned, and eventually freed, by V8.
+		p := C.malloc(C.size_t(len(s)))
+		copy((*[1 << 30]byte)(p)[:len(s):len(s)], s)
+		return C.StringArg{data: (*C.char)(p), length: C.int(len(s)), external: 1}
+	}
+	return C.StringArg{data: stringData(s), length: C.int(len(s))}
+}
+
+// bytesArg is stringArg for the bytes of b, which the caller must keep alive
+// until the call has returned.
+func bytesArg(b []byte) C.StringArg {
+	return stringArg(*(*string)(unsafe.Pointer(&b)))
+}
+
+// stringData returns a pointer to the bytes of s, or nil if s is empty.
+func stringData(s string) *C.char {
+	if len(s) == 0 {
+		return nil
+	}
+	return *(**C.char)(unsafe.Pointer(&s))
+}
+
+func isASCII(s string) bool {
+	for i := 0; i < len(s); i++ {
+		if s[i] >= 0x80 {
+			return false
+		}
+	}
+	return true
+}
+
+// utf8ScratchSize is the size of the pooled buffers that strings are written
+// into by V8 before being copied into a Go string; longer strings are written
+// straight into the memory of the Go string.
+const utf8ScratchSize = 1024
+
+var utf8Scratch = sync.Pool{
+	New: func() interface{} { return new([utf8ScratchSize]byte) },
+}
+
+// utf8String returns the string that write writes with Utf8Result, copying it
+// once from V8 for short strings, and not at all otherwise.
+func utf8String(write func(buf *C.char, cap C.int) C.RtnUtf8) (string, C.RtnError) {
+	scratch := utf8Scratch.Get().(*[utf8ScratchSize]byte)
+	defer utf8Scratch.Put(scratch)
+
+	rtn := write((*C.char)(unsafe.Pointer(&scratch[0])), utf8ScratchSize)
+	if rtn.string == nil {
+		return string(scratch[:rtn.length]), rtn.error
+	}
+	return utf8Returned(rtn), rtn.error
+}
+
+// utf8Returned writes the string that Utf8Result returned, as it did not fit
+// into the buffer, straight into the memory of a Go string.
+func utf8Returned(rtn C.RtnUtf8) string {
+	buf := stringWriteUtf8(nil, rtn)
+	// buf is not referenced anywhere else, so it can safely become the string.
+	return *(*string)(unsafe.Pointer(&buf))
+}
+
+// stringWriteUtf8 appends the string that Utf8Result returned to dst grown to
+// fit it, and releases the string. It is written a second time if its UTF-8
+// turns out to be longer than rtn.length, as that of a one-byte string that
+// is not ASCII is.
+func stringWriteUtf8(dst []byte, rtn C.RtnUtf8) []byte {
+	n, length := len(dst), int(rtn.length)
+	for {
+		grown := make([]byte, n+length)
+		copy(grown, dst)
+		written := int(C.StringWriteUtf8(rtn.string, (*C.char)(unsafe.Pointer(&grown[n])), C.int(length)))
+		if written <= length {
+			C.ValueRelease(rtn.string, (*C.ValueHead)(unsafe.Pointer(rtn.string)).gen)
+			return grown[:n+written]
+		}
+		length = written
+	}
+}
+
+// internTableSize is the number of strings an internTable holds.
+const internTableSize = 4096
+
+// internTable holds the Go strings of an isolate created with InternStrings,
+// each in the slot of its hash.
+type internTable struct {
+	mutex     sync.Mutex
+	maxLength int
+	strings   [internTableSize]string
+}
+
+func newInternTable(maxLength int) *internTable {
+	if maxLength > utf8ScratchSize {
+		maxLength = utf8ScratchSize
+	}
+	return &internTable{maxLength: maxLength}
+}
+
+// intern returns the Go string of b, which hashes to hash, from the table if
+// it holds it, and otherwise puts a copy of b into the table.
+func (t *internTable) intern(hash uint32, b []byte) string {
+	slot := &t.strings[hash%internTableSize]
+	t.mutex.Lock()
+	s := *slot
+	if s != string(b) {
+		s = string(b)
+		*slot = s
+	}
+	t.mutex.Unlock()
+	return s
+}
+
+// internBytes interns b by a hash of its own, for the strings that V8 does
+// not hash, such as those of the bulk format.
+func (t *internTable) internBytes(b []byte) string {
+	if len(b) > t.maxLength {
+		return string(b)
+	}
+	// FNV-1a
+	hash := uint32(2166136261)
+	for _, c := range b {
+		hash = (hash ^ uint32(c)) * 16777619
+	}
+	return t.intern(hash, b)
+}
+
+// valueString is Value.String for the isolate of t, which interns the
+// strings of up to maxLength bytes by the hash of V8.
+func (t *internTable) valueString(ptr C.ValuePtr) string {
+	scratch := utf8Scratch.Get().(*[utf8ScratchSize]byte)
+	defer utf8Scratch.Put(scratch)
+
+	rtn := C.ValueToUtf8Hash(ptr, (*C.char)(unsafe.Pointer(&scratch[0])), utf8ScratchSize, C.int(t.maxLength))
+	switch {
+	case rtn.string != nil:
+		return utf8Returned(rtn)
+	case int(rtn.length) > t.maxLength:
+		return string(scratch[:rtn.length])
+	}
+	return t.intern(uint32(rtn.hash), scratch[:rtn.length])
+}
+
+// utf8Append appends the string that write writes with Utf8Result to dst,
+// writing it straight into the spare capacity of dst when it fits, and else
+// into dst grown to fit it.
+func utf8Append(dst []byte, write func(buf *C.char, cap C.int) C.RtnUtf8) ([]byte, C.RtnError) {
+	n := len(dst)
+	spare := dst[n:cap(dst)]
+	var buf *C.char
+	if len(spare) > 0 {
+		buf = (*C.char)(unsafe.Pointer(&spare[0]))
+	}
+	rtn := write(buf, C.int(len(spare)))
+	if rtn.string == nil {
+		return dst[:n+int(rtn.length)], rtn.error
+	}
+	return stringWriteUtf8(dst, rtn), rtn.error
+}
@@ -10,9 +10,40 @@ valid_archs = ['arm64', 'x86_64']
 current_arch = platform.uname()[4].lower().replace("amd64", "x86_64")
 default_arch = current_arch if current_arch in valid_archs else None
 
+# The trimmed icudtl.dat files that third_party/icu of V8 comes with, by the
+# directory they are in: fewer locales, and leaner data for each of them.
+icu_subsets = ['flutter', 'ios']
+
 parser = argparse.ArgumentParser()
 parser.add_argument('--debug', dest='debug', action='store_true')
 parser.add_argument('--no-clang', dest='clang', action='store_false')
+parser.add_argument('--variant',
+    dest='variant',
+    action='store',
+    choices=['default', 'nocompress', 'jitless', 'lite', 'lto', 'sharedcage'],
+    default='default',
+    help='build a variant of V8, selected with the v8go_<variant> build tag')
+parser.add_argument('--pgo-profile',
+    dest='pgo_profile',
+    action='store',
+    help='optimize the lto variant with this merged clang profile')
+parser.add_argument('--pgo-train',
+    dest='pgo_train',
+    action='store_true',
+    help='build the lto variant instrumented, profile the v8go benchmarks with it and optimize it with the profile')
+parser.add_argument('--llvm-profdata',
+    dest='llvm_profdata',
+    action='store',
+    help='the llvm-profdata of the clang version that builds V8, to merge the profiles of --pgo-train; by default that of the clang of V8, which is fetched')
+parser.add_argument('--icu-data-file',
+    dest='icu_data_file',
+    action='store_true',
+    help='load the ICU data from an icudtl.dat, copied next to the library, instead of embedding it in the library')
+parser.add_argument('--icu-subset',
+    dest='icu_subset',
+    action='store',
+    choices=list(icu_subsets),
+    help='with --icu-data-file, copy this prebuilt subset of the ICU data of V8 instead of the full data')
 parser.add_argument('--arch',
     dest='arch',
     action='store',
@@ -21,6 +52,12 @@ parser.add_argument('--arch',
     required=default_arch is None)
 parser.set_defaults(debug=False, clang=True)
 args = parser.parse_args()
+if (args.pgo_profile or args.pgo_train) and args.variant != 'lto':
+    parser.error('--pgo-profile and --pgo-train build the lto variant')
+if args.variant == 'lto' and not args.clang:
+    parser.error('the lto variant is built with clang')
+if args.icu_subset and not args.icu_data_file:
+    parser.error('--icu-subset selects the data of --icu-data-file')
 
 deps_path = os.path.dirname(os.path.realpath(__file__))
 v8_path = os.path.join(deps_path, "v8")
@@ -48,6 +85,9 @@ gclient_sln = [
     },
 ]
 
+# Frame pointers let perf and other sampling profilers, which walk stacks with
+# them like the Go runtime does, unwind from JIT code through V8 into Go, see
+# PlatformOptions.Perf; the library leaves out unwind tables.
 gn_args = """
 is_debug=%s
 is_clang=%s
@@ -65,12 +105,48 @@ treat_warnings_as_errors=false
 v8_embedder_string="-v8go"
 v8_enable_gdbjit=false
 v8_enable_i18n_support=true
-icu_use_data_file=false
+icu_use_data_file=%s
 v8_enable_test_features=false
 v8_untrusted_code_mitigations=false
 exclude_unwind_tables=true
+enable_frame_pointers=true
 """
 
+# The gn args of each variant, on top of gn_args. Pointer compression limits
+# the heap of an isolate to 4GB, so the nocompress variant turns it off for
+# larger heaps; jitless and lite trade speed for less memory per isolate, and
+# run without writable and executable memory, at the cost of WebAssembly.
+variant_gn_args = {
+    "default": "",
+    "nocompress": """
+v8_enable_pointer_compression=false
+""",
+    "jitless": """
+v8_jitless=true
+""",
+    "lite": """
+v8_enable_lite_mode=true
+""",
+    # ThinLTO leaves the objects of the library as LLVM bitcode, which the
+    # v8go_lto build tag links together with v8go.cc, so that the calls of the
+    # cgo shims into V8 are optimized across both. Cgo must then use a clang
+    # and lld of the LLVM version that V8 is built with.
+    "lto": """
+use_thin_lto=true
+""",
+    # All isolates of the process share one pointer compression cage, and
+    # with it the read-only heap and the builtins embedded in it, instead of
+    # a copy each; their heaps share the 4GB of the cage.
+    "sharedcage": """
+v8_enable_pointer_compression_shared_cage=true
+v8_enable_shared_ro_heap=true
+""",
+}
+
+# The benchmarks that --pgo-train profiles the library with.
+pgo_train_bench = "."
+pgo_train_benchtime = "2000x"
+
 def v8deps():
     spec = "solutions = %s" % gclient_sln
     env = os.environ.copy()
@@ -86,6 +162,12 @@ def os_arch():
     u = platform.uname()
     return u[0].lower() + "_" + args.arch
 
+def variant_path():
+    dest_path = os.path.join(deps_path, os_arch())
+    if args.variant != "default":
+        dest_path = os.path.join(dest_path, args.variant)
+    return dest_path
+
 def v8_arch():
     if args.arch == "x86_64":
         return "x64"
@@ -109,17 +191,8 @@ def update_last_change():
     out_path = os.path.join(v8_path, "build", "util", "LASTCHANGE")
     subprocess.check_call(["python", "build/util/lastchange.py", "-o", out_path], cwd=v8_path)
 
-def main():
-    v8deps()
-    if is_windows:
-        apply_mingw_patches()
-
-    gn_path = os.path.join(tools_path, "gn")
-    assert(os.path.exists(gn_path))
-    ninja_path = os.path.join(tools_path, "ninja" + (".exe" if is_windows else ""))
-    assert(os.path.exists(ninja_path))
-
-    build_path = os.path.join(deps_path, ".build", os_arch())
+def build(gn_path, ninja_path, pgo_args=""):
+    build_path = os.path.join(deps_path, ".build", os_arch() + "_" + args.variant)
     env = os.environ.copy()
 
     is_debug = 'true' if args.debug else 'false'
@@ -131,7 +204,9 @@ def main():
     strip_debug_info = 'false' if args.debug else 'true'
 
     arch = v8_arch()
-    gnargs = gn_args % (is_debug, is_clang, arch, arch, symbol_level, strip_debug_info)
+    icu_use_data_file = 'true' if args.icu_data_file else 'false'
+    gnargs = gn_args % (is_debug, is_clang, arch, arch, symbol_level, strip_debug_info, icu_use_data_file)
+    gnargs += variant_gn_args[args.variant] + pgo_args
     gen_args = gnargs.replace('\n', ' ')
 
     subprocess.check_call(cmd([gn_path, "gen", build_path, "--args=" + gen_args]),
@@ -142,12 +217,70 @@ def main():
                         env=env)
 
     lib_fn = os.path.join(build_path, "obj/libv8_monolith.a")
-    dest_path = os.path.join(deps_path, os_arch())
+    dest_path = variant_path()
     if not os.path.exists(dest_path):
         os.makedirs(dest_path)
     dest_fn = os.path.join(dest_path, 'libv8.a')
     shutil.copy(lib_fn, dest_fn)
 
+    # v8go maps the file into memory, so that the processes of a host share
+    # its pages; see v8go.InitializeICU.
+    if args.icu_data_file:
+        icu_fn = os.path.join(build_path, "icudtl.dat")
+        if args.icu_subset:
+            icu_fn = os.path.join(v8_path, "third_party", "icu", args.icu_subset, "icudtl.dat")
+        shutil.copy(icu_fn, os.path.join(dest_path, "icudtl.dat"))
+
+def pgo_train():
+    """Runs the benchmarks of v8go with the instrumented library of the lto
+    variant, and returns the path of the merged profile."""
+    profile_path = os.path.join(deps_path, ".build", os_arch() + "_pgo")
+    shutil.rmtree(profile_path, ignore_errors=True)
+    os.makedirs(profile_path)
+    clang_path = os.path.join(v8_path, "third_party", "llvm-build", "Release+Asserts", "bin")
+    env = os.environ.copy()
+    env["CC"] = os.path.join(clang_path, "clang")
+    env["CXX"] = os.path.join(clang_path, "clang++")
+    env["CGO_LDFLAGS"] = (env.get("CGO_LDFLAGS", "") + " -fprofile-generate").strip()
+    env["LLVM_PROFILE_FILE"] = os.path.join(profile_path, "v8go-%p.profraw")
+    subprocess.check_call(["go", "test", "-tags", "v8go_lto", "-run", "^$",
+                           "-bench", pgo_train_bench, "-benchtime", pgo_train_benchtime, "."],
+                        cwd=os.path.dirname(deps_path),
+                        env=env)
+
+    llvm_profdata = args.llvm_profdata
+    if not llvm_profdata:
+        # The clang of V8 comes without llvm-profdata, which is part of the
+        # coverage tools of its package.
+        subprocess.check_call(["python", "tools/clang/scripts/update.py", "--package=coverage_tools"],
+                            cwd=v8_path)
+        llvm_profdata = os.path.join(clang_path, "llvm-profdata")
+    profdata_fn = os.path.join(profile_path, "v8go.profdata")
+    raw = [os.path.join(profile_path, f) for f in os.listdir(profile_path) if f.endswith(".profraw")]
+    subprocess.check_call([llvm_profdata, "merge", "-o", profdata_fn] + raw)
+    return profdata_fn
+
+def main():
+    v8deps()
+    if is_windows:
+        apply_mingw_patches()
+
+    gn_path = os.path.join(tools_path, "gn")
+    assert(os.path.exists(gn_path))
+    ninja_path = os.path.join(tools_path, "ninja" + (".exe" if is_windows else ""))
+    assert(os.path.exists(ninja_path))
+
+    # Chromium's PGO phases: 1 instruments the build, 2 optimizes it with the
+    # profile at pgo_data_path.
+    pgo_profile = args.pgo_profile
+    if args.pgo_train:
+        build(gn_path, ninja_path, "\nchrome_pgo_phase=1\n")
+        pgo_profile = pgo_train()
+    if pgo_profile:
+        build(gn_path, ninja_path, '\nchrome_pgo_phase=2\npgo_data_path="%s"\n' % os.path.abspath(pgo_profile))
+    else:
+        build(gn_path, ninja_path)
+
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,3 @@
+// Package jitless is required to provide support for vendoring modules
+// DO NOT REMOVE
+package jitless
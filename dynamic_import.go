@@ -0,0 +1,160 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"fmt"
+)
+
+// DynamicImportHandler is called for each import() call of an isolate, on the
+// goroutine running the JavaScript. It must not block; it starts loading the
+// module, for example on another goroutine, and completes the import with
+// DynamicImport.Finish or Reject once it is loaded.
+type DynamicImportHandler func(imp *DynamicImport)
+
+// DynamicImport is an import() call, whose promise is settled at the first
+// microtask checkpoint of the isolate after the import is finished or
+// rejected.
+type DynamicImport struct {
+	// Specifier is the specifier that is imported.
+	Specifier string
+	// Referrer is the origin of the script or module that calls import().
+	Referrer string
+
+	ctx      *Context
+	resolver *PromiseResolver
+
+	done   bool
+	finish func() (*Module, error)
+	err    error
+}
+
+// SetDynamicImportHandler sets the handler of the isolate's import() calls.
+// When it is nil, the default, import() calls return a rejected promise.
+func (i *Isolate) SetDynamicImportHandler(handler DynamicImportHandler) {
+	i.importMutex.Lock()
+	i.importHandler = handler
+	i.importMutex.Unlock()
+	enabled := 0
+	if handler != nil {
+		enabled = 1
+	}
+	C.IsolateSetDynamicImport(i.ptr, C.int(enabled))
+}
+
+// Context returns the context that calls import().
+func (d *DynamicImport) Context() *Context {
+	return d.ctx
+}
+
+// Finish completes the import with the module that load returns. load is
+// called at the next microtask checkpoint of the isolate, on the goroutine
+// that performs it, so it can compile and link the module in the import's
+// context; the module is instantiated and evaluated if it has not been yet,
+// and the promise of the import resolved with its namespace. Finish and Reject
+// can be called from any goroutine, and only the first call takes effect.
+func (d *DynamicImport) Finish(load func() (*Module, error)) {
+	d.complete(load, nil)
+}
+
+// Reject completes the import with err, which its promise is rejected with at
+// the next microtask checkpoint of the isolate.
+func (d *DynamicImport) Reject(err error) {
+	d.complete(nil, err)
+}
+
+func (d *DynamicImport) complete(load func() (*Module, error), err error) {
+	iso := d.ctx.iso
+	iso.importMutex.Lock()
+	defer iso.importMutex.Unlock()
+	if d.done {
+		return
+	}
+	d.done = true
+	d.finish = load
+	d.err = err
+	iso.imports = append(iso.imports, d)
+}
+
+// settle resolves or rejects the promise of a completed import.
+func (d *DynamicImport) settle() {
+	if d.err == nil {
+		var m *Module
+		if m, d.err = d.finish(); d.err == nil {
+			d.err = evaluateDynamicImport(m)
+		}
+		if d.err == nil {
+			d.resolver.Resolve(m.Namespace())
+			return
+		}
+	}
+	d.resolver.Reject(errorValue(d.ctx, d.err))
+}
+
+func evaluateDynamicImport(m *Module) error {
+	if m == nil {
+		return errors.New("v8go: no module was loaded")
+	}
+	switch m.Status() {
+	case ModuleUninstantiated:
+		return fmt.Errorf("v8go: module %s has not been instantiated", m.Origin())
+	case ModuleInstantiated:
+		if _, err := m.Evaluate(); err != nil {
+			return err
+		}
+	}
+	if m.Status() == ModuleErrored {
+		return newJSErrorFromValue(m.Exception())
+	}
+	return nil
+}
+
+// finishDynamicImports settles the imports that have been completed since the
+// last microtask checkpoint.
+func (i *Isolate) finishDynamicImports() {
+	i.importMutex.Lock()
+	imports := i.imports
+	i.imports = nil
+	i.importMutex.Unlock()
+	for _, d := range imports {
+		if d.ctx.ptr != nil {
+			d.settle()
+		}
+	}
+}
+
+// errorValue converts err to a value to throw, or to reject a promise with.
+func errorValue(ctx *Context, err error) *Value {
+	if verr, ok := err.(ValueError); ok {
+		return verr.value()
+	}
+	return NewError(ctx.iso, err.Error()).value()
+}
+
+//export goDynamicImport
+func goDynamicImport(ctxref int, specifier *C.char, specifierLen C.int, referrer *C.char, referrerLen C.int, resolver C.ValuePtr) C.int {
+	ctx := getContext(ctxref)
+	if ctx == nil {
+		return 0
+	}
+	ctx.iso.importMutex.Lock()
+	handler := ctx.iso.importHandler
+	ctx.iso.importMutex.Unlock()
+	if handler == nil {
+		return 0
+	}
+
+	handler(&DynamicImport{
+		Specifier: C.GoStringN(specifier, specifierLen),
+		Referrer:  C.GoStringN(referrer, referrerLen),
+		ctx:       ctx,
+		resolver:  &PromiseResolver{&Object{newValue(ctx, resolver)}, nil},
+	})
+	return 1
+}
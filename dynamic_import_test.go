@@ -0,0 +1,125 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"errors"
+	"strings"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+// settle performs microtask checkpoints until the promise is settled.
+func settle(t *testing.T, ctx *v8.Context, val *v8.Value) *v8.Promise {
+	t.Helper()
+	p, err := val.AsPromise()
+	fatalIf(t, err)
+	deadline := time.Now().Add(5 * time.Second)
+	for p.State() == v8.Pending {
+		if time.Now().After(deadline) {
+			t.Fatal("timed out waiting for the promise to settle")
+		}
+		time.Sleep(time.Millisecond)
+		ctx.PerformMicrotaskCheckpoint()
+	}
+	return p
+}
+
+func TestDynamicImport(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript("import('/mod.js')", "main.js")
+	fatalIf(t, err)
+	if p := settle(t, ctx, val); p.State() != v8.Rejected {
+		t.Error("expected import() to be rejected without a handler")
+	}
+
+	var imports []*v8.DynamicImport
+	iso.SetDynamicImportHandler(func(imp *v8.DynamicImport) {
+		imports = append(imports, imp)
+		go func() {
+			if imp.Specifier == "/missing.js" {
+				imp.Reject(errors.New("no such module"))
+				return
+			}
+			imp.Finish(func() (*v8.Module, error) {
+				return imp.Context().CompileModule("export const value = 'loaded';", imp.Specifier, v8.CompileOptions{})
+			})
+		}()
+	})
+
+	val, err = ctx.RunScript("import('/mod.js').then(ns => ns.value)", "main.js")
+	fatalIf(t, err)
+	// Compiling a module that is not instantiated is an error.
+	if p := settle(t, ctx, val); p.State() != v8.Rejected || !strings.Contains(p.Result().String(), "not been instantiated") {
+		t.Errorf("expected the import to be rejected, got %v", p.Result())
+	}
+	if len(imports) != 1 || imports[0].Specifier != "/mod.js" || imports[0].Referrer != "main.js" {
+		t.Fatalf("unexpected imports: %+v", imports)
+	}
+
+	iso.SetDynamicImportHandler(func(imp *v8.DynamicImport) {
+		go imp.Finish(func() (*v8.Module, error) {
+			m, err := imp.Context().CompileModule("export const value = 'loaded';", imp.Specifier, v8.CompileOptions{})
+			if err != nil {
+				return nil, err
+			}
+			return m, m.Instantiate(nil)
+		})
+	})
+	val, err = ctx.RunScript("import('/mod.js').then(ns => ns.value)", "main.js")
+	fatalIf(t, err)
+	if p := settle(t, ctx, val); p.State() != v8.Fulfilled || p.Result().String() != "loaded" {
+		t.Errorf("expected the import to resolve to loaded, got %v", p.Result())
+	}
+}
+
+func TestModuleCacheDynamicImport(t *testing.T) {
+	t.Parallel()
+
+	sources := map[string]string{
+		"/main.js": "export async function lazy() { const { value } = await import('/lazy.js'); return value; }",
+		"/lazy.js": "import { base } from '/base.js'; export const value = base + 1;",
+		"/base.js": "export const base = 41;",
+	}
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	cache := v8.NewModuleCache(iso, v8.ModuleCacheConfig{
+		Load: func(specifier string) (string, error) {
+			if source, ok := sources[specifier]; ok {
+				return source, nil
+			}
+			return "", errors.New("no such module: " + specifier)
+		},
+	})
+	iso.SetDynamicImportHandler(cache.DynamicImport)
+
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	m, err := cache.Import(ctx, "/main.js")
+	fatalIf(t, err)
+	lazy, err := m.Namespace().Get("lazy")
+	fatalIf(t, err)
+	fn, err := lazy.AsFunction()
+	fatalIf(t, err)
+	val, err := fn.Call(v8.Undefined(iso))
+	fatalIf(t, err)
+	if p := settle(t, ctx, val); p.State() != v8.Fulfilled || p.Result().Integer() != 42 {
+		t.Errorf("expected the lazy module to be imported, got %v", p.Result())
+	}
+
+	val, err = ctx.RunScript("import('/missing.js')", "main.js")
+	fatalIf(t, err)
+	if p := settle(t, ctx, val); p.State() != v8.Rejected || !strings.Contains(p.Result().String(), "no such module") {
+		t.Errorf("expected the import to be rejected, got %v", p.Result())
+	}
+}
@@ -10,16 +10,67 @@ import "C"
 import (
 	"fmt"
 	"io"
+	"sync"
 	"unsafe"
 )
 
 // JSError is an error that is returned if there is are any
 // JavaScript exceptions handled in the context. When used with the fmt
 // verb `%+v`, will output the JavaScript stack trace, if available.
+//
+// The Message and StackTrace of an error of an isolate created with
+// LazyErrors are empty until Error or Format is first called.
 type JSError struct {
 	Message    string
 	Location   string
 	StackTrace string
+
+	// lazy is the exception that Message and StackTrace are formatted from,
+	// of an isolate created with LazyErrors.
+	lazy *lazyException
+	// exception is the value that was thrown, of an isolate created with
+	// KeepExceptions.
+	exception *Value
+}
+
+type lazyException struct {
+	once   sync.Once
+	ptr    C.ValuePtr
+	ctxRef int
+}
+
+// LazyErrors is an IsolateOption that makes the JSErrors of the isolate
+// format the exception that was thrown, if it is an object, only once the
+// Message or StackTrace are asked for with Error or Format, instead of when
+// the error is returned. Converting an object to a string runs JavaScript, as
+// does formatting the stack of an Error; callers that only tell whether a
+// call failed, such as those of scripts that throw for control flow, need
+// neither. The exception is held until then, or until its context is closed,
+// after which the error can no longer be formatted.
+var LazyErrors IsolateOption = isolateOptionFunc(func(opts *isolateOptions) {
+	opts.lazyErrors = true
+})
+
+// KeepExceptions is an IsolateOption that makes the JSErrors of the isolate
+// keep the value that was thrown, see JSError.Exception, so that the fields
+// of an error object, such as a code or a cause, can be read without parsing
+// them from the message. Like any value, the exception is held until its
+// context is closed or it is released with Value.Release.
+var KeepExceptions IsolateOption = isolateOptionFunc(func(opts *isolateOptions) {
+	opts.keepExceptions = true
+})
+
+// Exception returns the value that was thrown, if the error is of an isolate
+// created with KeepExceptions and of a JavaScript exception rather than one
+// of termination; otherwise it returns nil.
+func (e *JSError) Exception() *Value {
+	return e.exception
+}
+
+// hasError returns whether rtnErr is an exception, which it is unless it is
+// zero.
+func hasError(rtnErr C.RtnError) bool {
+	return rtnErr.msg != nil || rtnErr.exception != nil
 }
 
 func newJSError(rtnErr C.RtnError) error {
@@ -31,16 +82,67 @@ func newJSError(rtnErr C.RtnError) error {
 	C.free(unsafe.Pointer(rtnErr.msg))
 	C.free(unsafe.Pointer(rtnErr.location))
 	C.free(unsafe.Pointer(rtnErr.stack))
+	if rtnErr.exception == nil {
+		return err
+	}
+	ctxRef := int(rtnErr.exceptionContext)
+	ctx := getContext(ctxRef)
+	if ctx != nil && ctx.iso.keepExceptions {
+		err.exception = newValue(ctx, rtnErr.exception)
+	}
+	if rtnErr.msg == nil {
+		err.lazy = &lazyException{ptr: rtnErr.exception, ctxRef: ctxRef}
+	}
+	return err
+}
+
+// format formats the Message and StackTrace of a lazy error from its
+// exception, unless they have been.
+func (e *JSError) format() {
+	if e.lazy == nil {
+		return
+	}
+	e.lazy.once.Do(func() {
+		if ctx := getContext(e.lazy.ctxRef); ctx == nil || ctx.ptr == nil {
+			e.Message = "v8go: the exception was not formatted before its context was closed"
+			return
+		}
+		keep := C.int(0)
+		if e.exception != nil {
+			keep = 1
+		}
+		rtnErr := C.ExceptionErrorFormat(e.lazy.ptr, keep)
+		e.Message = C.GoString(rtnErr.msg)
+		e.StackTrace = C.GoString(rtnErr.stack)
+		C.free(unsafe.Pointer(rtnErr.msg))
+		C.free(unsafe.Pointer(rtnErr.stack))
+	})
+}
+
+// newJSErrorFromValue converts a value that was thrown, or that a promise was
+// rejected with, to a JSError.
+func newJSErrorFromValue(v *Value) error {
+	err := &JSError{Message: v.String()}
+	if v.ctx != nil && v.ctx.iso.keepExceptions {
+		err.exception = v
+	}
+	if v.IsObject() {
+		if stack, e := v.Object().Get("stack"); e == nil && stack.IsString() {
+			err.StackTrace = stack.String()
+		}
+	}
 	return err
 }
 
 func (e *JSError) Error() string {
+	e.format()
 	return e.Message
 }
 
 // Format implements the fmt.Formatter interface to provide a custom formatter
 // primarily to output the javascript stack trace with %+v
 func (e *JSError) Format(s fmt.State, verb rune) {
+	e.format()
 	switch verb {
 	case 'v':
 		if s.Flag('+') && e.StackTrace != "" {
@@ -6,6 +6,7 @@ package v8go_test
 
 import (
 	"fmt"
+	"strings"
 	"testing"
 
 	v8 "rogchap.com/v8go"
@@ -117,3 +118,82 @@ func TestJSErrorFormat_forSyntaxError(t *testing.T) {
 		t.Errorf("unexpected verbose error message: %q", msg)
 	}
 }
+
+func TestLazyErrors(t *testing.T) {
+	t.Parallel()
+
+	eager := v8.NewIsolate()
+	defer eager.Dispose()
+	lazy := v8.NewIsolate(v8.LazyErrors)
+	defer lazy.Dispose()
+	script := `
+	function fail(v) { throw v }
+	fail(new Error('fail'));
+	`
+	for _, source := range []string{script, "let y = 1 +;", "throw 'primitive'"} {
+		eagerCtx := v8.NewContext(eager)
+		_, want := eagerCtx.RunScript(source, "fail.js")
+		lazyCtx := v8.NewContext(lazy)
+		_, err := lazyCtx.RunScript(source, "fail.js")
+		got, exp := err.(*v8.JSError), want.(*v8.JSError)
+		if got.Location != exp.Location {
+			t.Errorf("unexpected location %q, want %q", got.Location, exp.Location)
+		}
+		if s := fmt.Sprintf("%+v", got); s != fmt.Sprintf("%+v", exp) {
+			t.Errorf("unexpected error %q, want %q", s, fmt.Sprintf("%+v", exp))
+		}
+		if got.Message != exp.Message || got.StackTrace != exp.StackTrace {
+			t.Errorf("unexpected formatted error %+v, want %+v", *got, *exp)
+		}
+		eagerCtx.Close()
+		lazyCtx.Close()
+	}
+
+	ctx := v8.NewContext(lazy)
+	_, err := ctx.RunScript(script, "fail.js")
+	ctx.Close()
+	if !strings.Contains(err.Error(), "context was closed") {
+		t.Errorf("unexpected error of a closed context %q", err)
+	}
+}
+
+func TestKeepExceptions(t *testing.T) {
+	t.Parallel()
+
+	for _, opts := range [][]v8.IsolateOption{{v8.KeepExceptions}, {v8.KeepExceptions, v8.LazyErrors}} {
+		iso := v8.NewIsolate(opts...)
+		ctx := v8.NewContext(iso)
+		_, err := ctx.RunScript("const e = new Error('not found'); e.status = 404; throw e", "fail.js")
+		e := err.(*v8.JSError)
+		exc := e.Exception()
+		if exc == nil || !exc.IsNativeError() {
+			t.Fatalf("expected the Error that was thrown, got %v", exc)
+		}
+		if status, err := exc.Object().Get("status"); err != nil || status.Int32() != 404 {
+			t.Errorf("unexpected status %v, %v", status, err)
+		}
+		if e.Error() != "Error: not found" {
+			t.Errorf("unexpected message %q", e.Error())
+		}
+		// The exception is still there once the lazy error is formatted.
+		if status, err := exc.Object().Get("status"); err != nil || status.Int32() != 404 {
+			t.Errorf("unexpected status %v, %v", status, err)
+		}
+
+		_, err = ctx.RunScript("throw 'primitive'", "fail.js")
+		if exc := err.(*v8.JSError).Exception(); exc == nil || exc.String() != "primitive" {
+			t.Errorf("expected the string that was thrown, got %v", exc)
+		}
+		ctx.Close()
+		iso.Dispose()
+	}
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	_, err := ctx.RunScript("throw new Error('fail')", "fail.js")
+	if exc := err.(*v8.JSError).Exception(); exc != nil {
+		t.Errorf("expected no exception without KeepExceptions, got %v", exc)
+	}
+}
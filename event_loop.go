@@ -0,0 +1,88 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"context"
+	"time"
+)
+
+// Timers installs setTimeout, setInterval, clearTimeout and clearInterval in
+// the global object of the context. The timers are kept in a heap in C++ and
+// their callbacks run in Context.RunEventLoop, each followed by a microtask
+// checkpoint. Like in browsers, delays are in milliseconds, at least 1ms, and
+// timer ids are numbers.
+var Timers ContextOption = contextOptionFunc(func(opts *contextOptions) {
+	opts.timers = true
+})
+
+// RunEventLoop runs the event loop of the context on the calling goroutine,
+// which is the one that uses the isolate, until there is nothing left to do,
+// in which case it returns nil, or until ctx is done, in which case it returns
+// ctx.Err(). Each turn of the loop runs the finalizers of collected objects,
+// see Object.SetWeak, settles the async function calls of the context that
+// have returned, see NewAsyncFunctionTemplate, performs a microtask
+// checkpoint, runs the foreground tasks that V8 posted to the platform and
+// runs the timers that are due, see Timers. It then sleeps until
+// the next timer is due or an async function call returns. The loop is done
+// once no timer is set and no async function call is in flight, nor, in a
+// context created with AtomicsWaitAsync, a wait of Atomics.waitAsync; an
+// exception thrown by a timer callback stops it with a *JSError.
+func (c *Context) RunEventLoop(ctx context.Context) error {
+	var wait *time.Timer
+	defer func() {
+		if wait != nil {
+			wait.Stop()
+		}
+	}()
+	for {
+		c.iso.RunFinalizers()
+		c.PerformMicrotaskCheckpoint()
+		rtn := C.ContextRunTimers(c.ptr)
+		if hasError(rtn.error) {
+			return newJSError(rtn.error)
+		}
+
+		c.async.mutex.Lock()
+		pending := c.async.pending
+		ready := c.async.ready
+		c.async.mutex.Unlock()
+		next := float64(rtn.next)
+		if pending == 0 && next < 0 && rtn.asyncWaits == 0 {
+			return nil
+		}
+		// V8 settles the promises of Atomics.waitAsync in tasks that it
+		// posts without telling, so the loop checks for them every
+		// millisecond while there are any.
+		if rtn.asyncWaits > 0 && (next < 0 || next > atomicsWaitAsyncPoll) {
+			next = atomicsWaitAsyncPoll
+		}
+
+		var due <-chan time.Time
+		if next >= 0 {
+			d := time.Duration(next * float64(time.Millisecond))
+			if wait == nil {
+				wait = time.NewTimer(d)
+			} else {
+				wait.Reset(d)
+			}
+			due = wait.C
+		}
+		select {
+		case <-ready:
+		case <-due:
+		case <-ctx.Done():
+			return ctx.Err()
+		}
+		if due != nil && !wait.Stop() {
+			select {
+			case <-wait.C:
+			default:
+			}
+		}
+	}
+}
@@ -0,0 +1,103 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"context"
+	"strings"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestRunEventLoopTimers(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Timers)
+	defer ctx.Close()
+
+	start := time.Now()
+	_, err := ctx.RunScript(`
+		var log = [];
+		setTimeout((a, b) => log.push("timeout " + a + b), 200, "x", "y");
+		setTimeout(() => log.push("first"));
+		clearTimeout(setTimeout(() => log.push("cleared"), 10));
+		var ticks = 0;
+		var id = setInterval(() => {
+			log.push("tick " + ++ticks);
+			if (ticks == 3) clearInterval(id);
+			Promise.resolve().then(() => log.push("microtask " + ticks));
+		}, 5);
+	`, "timers.js")
+	fatalIf(t, err)
+	fatalIf(t, ctx.RunEventLoop(context.Background()))
+	if elapsed := time.Since(start); elapsed < 200*time.Millisecond {
+		t.Errorf("expected the loop to wait for the timers, took %v", elapsed)
+	}
+
+	val, err := ctx.RunScript("log.join()", "log.js")
+	fatalIf(t, err)
+	want := "first,tick 1,microtask 1,tick 2,microtask 2,tick 3,microtask 3,timeout xy"
+	if val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+}
+
+func TestRunEventLoopTimerException(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Timers)
+	defer ctx.Close()
+
+	_, err := ctx.RunScript(`setTimeout(() => { throw new Error("boom") }, 1)`, "throw.js")
+	fatalIf(t, err)
+	err = ctx.RunEventLoop(context.Background())
+	if err == nil || !strings.Contains(err.Error(), "boom") {
+		t.Errorf("expected the exception of the timer, got %v", err)
+	}
+
+	if _, err := ctx.RunScript("setTimeout()", "invalid.js"); err == nil {
+		t.Error("expected setTimeout without a callback to throw")
+	}
+}
+
+func TestRunEventLoopTimersAndAsyncFunctions(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	sleep := v8.NewAsyncFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) (v8.AsyncWork, error) {
+		d := time.Duration(info.ArgNumber(0)) * time.Millisecond
+		return func() (interface{}, error) {
+			time.Sleep(d)
+			return "slept", nil
+		}, nil
+	})
+	global := v8.NewObjectTemplate(iso)
+	fatalIf(t, global.Set("sleep", sleep))
+	ctx := v8.NewContext(iso, global, v8.Timers)
+	defer ctx.Close()
+
+	_, err := ctx.RunScript(`
+		var log = [];
+		sleep(20).then(v => {
+			log.push(v);
+			setTimeout(() => log.push("after"), 5);
+		});
+		setTimeout(() => log.push("timer"), 5);
+	`, "mixed.js")
+	fatalIf(t, err)
+	fatalIf(t, ctx.RunEventLoop(context.Background()))
+	val, err := ctx.RunScript("log.join()", "log.js")
+	fatalIf(t, err)
+	if want := "timer,slept,after"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+}
@@ -61,7 +61,7 @@ func newExceptionError(iso *Isolate, typ C.ErrorTypeIndex, msg string) *Exceptio
 	if eptr == nil {
 		panic(fmt.Errorf("invalid error type index: %d", typ))
 	}
-	return &Exception{&Value{ptr: eptr}}
+	return &Exception{newValue(nil, eptr)}
 }
 
 // An Exception is a JavaScript exception.
@@ -103,7 +103,8 @@ func (e *Exception) String() string {
 	if e.Value == nil {
 		return "<nil>"
 	}
-	s := C.ExceptionGetMessageString(e.ptr)
-	defer C.free(unsafe.Pointer(s))
-	return C.GoString(s)
+	s, _ := utf8String(func(buf *C.char, cap C.int) C.RtnUtf8 {
+		return C.ExceptionGetMessageString(e.ptr, buf, cap)
+	})
+	return s
 }
@@ -21,3 +21,27 @@ var GetContext = getContext
 func (c *Context) Ref() int {
 	return c.ref
 }
+
+// CallbackCount is exported for testing only.
+func (i *Isolate) CallbackCount() int {
+	n := 0
+	i.cbs.Range(func(key, value interface{}) bool {
+		n++
+		return true
+	})
+	return n
+}
+
+// DeadValues is exported for testing only.
+func (i *Isolate) DeadValues() int {
+	return i.deadValues()
+}
+
+// ParseCPUList, ReadNUMANodes, ThreadAffinity and CurrentCPU are exported for
+// testing only.
+var (
+	ParseCPUList   = parseCPUList
+	ReadNUMANodes  = readNUMANodes
+	ThreadAffinity = threadAffinity
+	CurrentCPU     = currentCPU
+)
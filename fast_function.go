@@ -0,0 +1,122 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+
+import (
+	"fmt"
+	"sync"
+	"unsafe"
+)
+
+type fastFunction func(args *C.FastCallbackArgs) float64
+
+// fastKey identifies the fast function of a template; fast calls are made
+// without a context, so by the isolate and the template's callback ref.
+type fastKey struct {
+	iso C.IsolatePtr
+	ref int
+}
+
+// fastRegistry maps fastKeys to fastFunctions; like the context registry it
+// is read without a lock.
+var fastRegistry sync.Map
+
+// FastFunction gives the function created from a FunctionTemplate a fast
+// path: once V8 has optimized the JS code calling the function, it calls fn
+// directly with the arguments converted to the Go types of fn, without
+// creating a FunctionCallbackInfo or any values. The callback of the
+// template is still used for calls that are not optimized and for arguments
+// that do not convert, so both must behave the same.
+//
+// fn must have one of the following types:
+//
+//	func(float64) float64
+//	func(float64, float64) float64
+//	func(int32, int32) int32
+//	func(int32, float64) float64
+//	func([]float64) float64 // called with the elements of a Float64Array
+//
+// and must not use the isolate in any way, nor keep a reference to the slice
+// it was called with.
+//
+// V8 only makes fast calls when the --turbo-fast-api-calls flag is set, see SetFlags.
+func FastFunction(fn interface{}) FunctionTemplateOption {
+	signature, call := fastFunctionOf(fn)
+	return functionTemplateOptionFunc(func(opts *functionTemplateOptions) {
+		opts.fastSignature = signature
+		opts.fastFunction = call
+	})
+}
+
+func fastFunctionOf(fn interface{}) (C.FastCallbackSignature, fastFunction) {
+	switch fn := fn.(type) {
+	case func(float64) float64:
+		return C.FAST_CALLBACK_FLOAT64_FLOAT64, func(args *C.FastCallbackArgs) float64 {
+			return fn(float64(args.number[0]))
+		}
+	case func(float64, float64) float64:
+		return C.FAST_CALLBACK_FLOAT64_FLOAT64_FLOAT64, func(args *C.FastCallbackArgs) float64 {
+			return fn(float64(args.number[0]), float64(args.number[1]))
+		}
+	case func(int32, int32) int32:
+		return C.FAST_CALLBACK_INT32_INT32_INT32, func(args *C.FastCallbackArgs) float64 {
+			return float64(fn(int32(args.int32[0]), int32(args.int32[1])))
+		}
+	case func(int32, float64) float64:
+		return C.FAST_CALLBACK_INT32_FLOAT64_FLOAT64, func(args *C.FastCallbackArgs) float64 {
+			return fn(int32(args.int32[0]), float64(args.number[0]))
+		}
+	case func([]float64) float64:
+		return C.FAST_CALLBACK_FLOAT64ARRAY_FLOAT64, func(args *C.FastCallbackArgs) float64 {
+			var elems []float64
+			if n := int(args.length); n > 0 {
+				elems = (*[1 << 28]float64)(unsafe.Pointer(args.float64s))[:n:n]
+			}
+			return fn(elems)
+		}
+	}
+	panic(fmt.Sprintf("v8go: unsupported fast function type %T", fn))
+}
+
+func (i *Isolate) registerFastFunction(ref int, fn fastFunction) {
+	fastRegistry.Store(fastKey{i.ptr, ref}, fn)
+
+	i.cbMutex.Lock()
+	if i.fastRefs == nil {
+		i.fastRefs = make(map[int]struct{})
+	}
+	i.fastRefs[ref] = struct{}{}
+	i.cbMutex.Unlock()
+}
+
+func (i *Isolate) unregisterFastFunction(ref int) {
+	i.cbMutex.Lock()
+	_, ok := i.fastRefs[ref]
+	delete(i.fastRefs, ref)
+	i.cbMutex.Unlock()
+	if ok {
+		fastRegistry.Delete(fastKey{i.ptr, ref})
+	}
+}
+
+func (i *Isolate) unregisterFastFunctions() {
+	i.cbMutex.Lock()
+	refs := i.fastRefs
+	i.fastRefs = nil
+	i.cbMutex.Unlock()
+
+	for ref := range refs {
+		fastRegistry.Delete(fastKey{i.ptr, ref})
+	}
+}
+
+//export goFastFunctionCallback
+func goFastFunctionCallback(iso C.IsolatePtr, cbref int, args *C.FastCallbackArgs) C.double {
+	fn, _ := fastRegistry.Load(fastKey{iso, cbref})
+	return C.double(fn.(fastFunction)(args))
+}
@@ -0,0 +1,81 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestFastFunction(t *testing.T) {
+	v8.SetFlags("--turbo-fast-api-calls", "--allow-natives-syntax")
+	defer v8.SetFlags("--noturbo-fast-api-calls", "--noallow-natives-syntax")
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	var slowCalls, fastCalls int
+	add := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		slowCalls++
+		val, _ := v8.NewValue(iso, info.ArgNumber(0)+info.ArgNumber(1))
+		return val
+	}, v8.PackedArgs, v8.FastFunction(func(a, b float64) float64 {
+		fastCalls++
+		return a + b
+	}))
+	sum := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		slowCalls++
+		return info.Arg(0)
+	}, v8.FastFunction(func(elems []float64) float64 {
+		fastCalls++
+		var total float64
+		for _, e := range elems {
+			total += e
+		}
+		return total
+	}))
+
+	global := v8.NewObjectTemplate(iso)
+	global.Set("add", add)
+	global.Set("sum", sum)
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`
+		function f(a, b) { return add(a, b); }
+		%PrepareFunctionForOptimization(f);
+		f(1, 2);
+		f(1, 2);
+		%OptimizeFunctionOnNextCall(f);
+		f(1.5, 2);
+	`, "")
+	fatalIf(t, err)
+	if val.Number() != 3.5 {
+		t.Errorf("expected 3.5, got %v", val)
+	}
+	if slowCalls != 2 || fastCalls != 1 {
+		t.Errorf("expected 2 slow calls and 1 fast call, got %d and %d", slowCalls, fastCalls)
+	}
+
+	val, err = ctx.RunScript(`
+		function g(a) { return sum(a); }
+		%PrepareFunctionForOptimization(g);
+		g(new Float64Array([1, 2]));
+		%OptimizeFunctionOnNextCall(g);
+		g(new Float64Array([1, 2, 3.5]));
+	`, "")
+	fatalIf(t, err)
+	if slowCalls+fastCalls != 5 {
+		t.Errorf("expected 5 calls, got %d", slowCalls+fastCalls)
+	}
+	if fastCalls == 2 && val.Number() != 6.5 {
+		t.Errorf("expected 6.5, got %v", val)
+	}
+
+	if recoverPanic(func() { v8.FastFunction(func(string) float64 { return 0 }) }) == nil {
+		t.Error("expected panic for an unsupported fast function type")
+	}
+}
@@ -0,0 +1,607 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"bytes"
+	"context"
+	"errors"
+	"io"
+	"io/ioutil"
+	"net/http"
+	"reflect"
+	"strings"
+	"sync"
+	"unsafe"
+)
+
+// FetchOptions configures the fetch function that the Fetch option installs.
+type FetchOptions struct {
+	// Client sends the requests. When it is nil, they are sent by a client
+	// that every context shares, whose transport keeps up to 256 idle
+	// connections to each host, so that contexts reuse the connections that
+	// others have opened.
+	Client *http.Client
+	// ChunkSize is the most bytes of each chunk that a response body is read
+	// in, 64KB by default and at most 16MB.
+	ChunkSize int
+	// MaxBodySize is the most bytes of a response body that fetch reads,
+	// whether in chunks or at once; a body that is longer fails with a
+	// RangeError as soon as the bytes read exceed it, rather than once it has
+	// been buffered. A body read into an ArrayBuffer is also limited to what
+	// is left of the ArrayBufferQuota of the isolate. 0 means no limit.
+	MaxBodySize int
+}
+
+// fetchClient is the client of FetchOptions with no Client of their own.
+var fetchClient = func() *http.Client {
+	t := http.DefaultTransport.(*http.Transport).Clone()
+	t.MaxIdleConns = 1024
+	t.MaxIdleConnsPerHost = 256
+	return &http.Client{Transport: t}
+}()
+
+const (
+	fetchChunkSize    = 64 << 10
+	fetchMaxChunkSize = 16 << 20
+)
+
+// Fetch is a ContextOption that installs fetch and Headers in the global
+// object of the context, for scripts to make HTTP requests with. Each call of
+// fetch sends its request on a goroutine of its own, see
+// NewAsyncFunctionTemplate, so that a context can have any number of them in
+// flight; their promises are settled by Context.RunEventLoop.
+//
+// A Response has the status, statusText, ok, url and headers of the
+// response, and its body is read with arrayBuffer, text or json, or in chunks
+// with body.getReader or for await over body. Each chunk is a Uint8Array
+// over an ArrayBuffer that the body was read into directly, without a copy,
+// and which counts against the ArrayBufferQuota of the isolate. Bodies that
+// are neither read to the end nor canceled hold on to their connection until
+// the context is closed, which also cancels the requests in flight.
+func Fetch(opts FetchOptions) ContextOption {
+	if opts.Client == nil {
+		opts.Client = fetchClient
+	}
+	if opts.ChunkSize <= 0 {
+		opts.ChunkSize = fetchChunkSize
+	} else if opts.ChunkSize > fetchMaxChunkSize {
+		opts.ChunkSize = fetchMaxChunkSize
+	}
+	return contextOptionFunc(func(o *contextOptions) {
+		o.fetch = &opts
+	})
+}
+
+// fetchState holds the response bodies of the fetch calls of a context that
+// are still open, by the id that the JavaScript side refers to them by.
+type fetchState struct {
+	opts   FetchOptions
+	ctx    context.Context
+	cancel context.CancelFunc
+
+	mutex  sync.Mutex
+	seq    int
+	bodies map[int]*fetchBody
+}
+
+// fetchBody is an open response body and the number of bytes read from it,
+// which only the read in flight updates, as the reads of a body are chained.
+type fetchBody struct {
+	io.ReadCloser
+	read int
+}
+
+// fetchTemplates are the native functions of fetch, which the isolate creates
+// for the first context with Fetch and which call into the fetchState of the
+// context they are called in.
+type fetchTemplates struct {
+	script                       *UnboundScript
+	start, read, readAll, cancel *FunctionTemplate
+}
+
+// fetchSource is the JavaScript side of fetch, which builds fetch, Headers
+// and Response on top of the native functions. Header lists cross over as
+// strings of names and values separated by NUL, which neither can contain.
+// The native functions reject with errors of the isolate rather than of the
+// context, which the errors of fetch are recreated from.
+const fetchSource = `(function (start, read, readAll, cancel) {
+	"use strict";
+	const name = (n) => String(n).toLowerCase();
+	const failed = (prefix) => (e) => {
+		throw new (e && e.name === "RangeError" ? RangeError : TypeError)(prefix + (e && e.message));
+	};
+
+	class Headers {
+		#map = new Map();
+		constructor(init) {
+			if (init === undefined || init === null) return;
+			if (typeof init[Symbol.iterator] === "function") {
+				for (const [k, v] of init) this.append(k, v);
+			} else {
+				for (const k of Object.keys(init)) this.append(k, init[k]);
+			}
+		}
+		append(k, v) {
+			k = name(k);
+			v = String(v);
+			const prev = this.#map.get(k);
+			this.#map.set(k, prev === undefined ? v : prev + ", " + v);
+		}
+		set(k, v) { this.#map.set(name(k), String(v)); }
+		get(k) {
+			const v = this.#map.get(name(k));
+			return v === undefined ? null : v;
+		}
+		has(k) { return this.#map.has(name(k)); }
+		delete(k) { this.#map.delete(name(k)); }
+		forEach(fn, thisArg) {
+			for (const [k, v] of this) fn.call(thisArg, v, k, this);
+		}
+		entries() {
+			return [...this.#map.entries()].sort((a, b) => a[0] < b[0] ? -1 : a[0] > b[0] ? 1 : 0)[Symbol.iterator]();
+		}
+		keys() { return [...this.entries()].map((e) => e[0])[Symbol.iterator](); }
+		values() { return [...this.entries()].map((e) => e[1])[Symbol.iterator](); }
+		[Symbol.iterator]() { return this.entries(); }
+	}
+
+	// The body of a response, read by one reader at a time, whose reads are
+	// chained so that the chunks arrive in order.
+	class ResponseBody {
+		#id;
+		#done = false;
+		#locked = false;
+		#pending = Promise.resolve();
+		constructor(id) { this.#id = id; }
+		get locked() { return this.#locked; }
+		getReader() {
+			if (this.#locked) throw new TypeError("the body is locked");
+			this.#locked = true;
+			let released = false;
+			const check = () => {
+				if (released) throw new TypeError("the reader is released");
+			};
+			return {
+				read: () => { check(); return this.#read(); },
+				cancel: () => { check(); this.#cancel(); return Promise.resolve(); },
+				releaseLock: () => { if (!released) { released = true; this.#locked = false; } },
+			};
+		}
+		async *[Symbol.asyncIterator]() {
+			const reader = this.getReader();
+			try {
+				for (;;) {
+					const { value, done } = await reader.read();
+					if (done) return;
+					yield value;
+				}
+			} finally {
+				reader.cancel();
+				reader.releaseLock();
+			}
+		}
+		#read() {
+			const chunk = this.#pending.then(() => this.#done ? null : read(this.#id).catch(failed("")));
+			this.#pending = chunk.catch(() => { this.#done = true; });
+			return chunk.then((buf) => {
+				if (buf === null) {
+					this.#done = true;
+					return { value: undefined, done: true };
+				}
+				return { value: new Uint8Array(buf), done: false };
+			});
+		}
+		#cancel() {
+			if (!this.#done) {
+				this.#done = true;
+				this.#pending.then(() => cancel(this.#id));
+			}
+		}
+		static consume(body, text) {
+			body.#locked = true;
+			body.#done = true;
+			return readAll(body.#id, text).catch(failed(""));
+		}
+	}
+
+	class Response {
+		#status; #statusText; #url; #headers; #body; #used = false;
+		constructor(status, statusText, url, headers, id) {
+			this.#status = status;
+			this.#statusText = statusText;
+			this.#url = url;
+			this.#headers = new Headers();
+			const list = headers === "" ? [] : headers.split("\0");
+			for (let i = 0; i + 1 < list.length; i += 2) this.#headers.append(list[i], list[i + 1]);
+			this.#body = id === 0 ? null : new ResponseBody(id);
+		}
+		get status() { return this.#status; }
+		get statusText() { return this.#statusText; }
+		get ok() { return this.#status >= 200 && this.#status < 300; }
+		get url() { return this.#url; }
+		get headers() { return this.#headers; }
+		get body() { return this.#body; }
+		get bodyUsed() { return this.#used || (this.#body !== null && this.#body.locked); }
+		#consume(text) {
+			if (this.bodyUsed) return Promise.reject(new TypeError("the body is already used"));
+			this.#used = true;
+			if (this.#body === null) return Promise.resolve(text ? "" : new ArrayBuffer(0));
+			return ResponseBody.consume(this.#body, text);
+		}
+		arrayBuffer() { return this.#consume(false); }
+		text() { return this.#consume(true); }
+		json() { return this.text().then(JSON.parse); }
+	}
+
+	function fetch(input, init = {}) {
+		try {
+			const url = String(typeof input === "object" && input !== null && "url" in input ? input.url : input);
+			const method = init.method === undefined ? "GET" : String(init.method).toUpperCase();
+			const headers = [];
+			for (const [k, v] of new Headers(init.headers)) headers.push(k, v);
+			let body = init.body;
+			if (body === undefined || body === null) {
+				body = undefined;
+			} else if (method === "GET" || method === "HEAD") {
+				throw new TypeError("a " + method + " request cannot have a body");
+			} else if (!(body instanceof ArrayBuffer) && !ArrayBuffer.isView(body)) {
+				body = String(body);
+			}
+			return start(url, method, headers.join("\0"), body).then((r) => new Response(...r), failed("fetch failed: "));
+		} catch (e) {
+			return Promise.reject(e);
+		}
+	}
+
+	return { fetch, Headers };
+})`
+
+// fetchFunctions returns the native functions of fetch of the isolate.
+func (i *Isolate) fetchFunctions() (*fetchTemplates, error) {
+	i.fetchMutex.Lock()
+	defer i.fetchMutex.Unlock()
+	if i.fetch != nil {
+		return i.fetch, nil
+	}
+	script, err := i.CompileUnboundScript(fetchSource, "v8go:fetch", CompileOptions{})
+	if err != nil {
+		return nil, err
+	}
+	i.fetch = &fetchTemplates{
+		script:  script,
+		start:   NewAsyncFunctionTemplate(i, fetchStart),
+		read:    NewAsyncFunctionTemplate(i, fetchRead),
+		readAll: NewAsyncFunctionTemplate(i, fetchReadAll),
+		cancel: NewFunctionTemplate(i, func(info *FunctionCallbackInfo) *Value {
+			if body := info.Context().fetch.take(int(info.ArgInt32(0))); body != nil {
+				body.Close()
+			}
+			return nil
+		}),
+	}
+	return i.fetch, nil
+}
+
+// installFetch installs fetch and Headers in the global object of the context.
+func (c *Context) installFetch(opts *FetchOptions) error {
+	fns, err := c.iso.fetchFunctions()
+	if err != nil {
+		return err
+	}
+	ctx, cancel := context.WithCancel(context.Background())
+	c.fetch = &fetchState{opts: *opts, ctx: ctx, cancel: cancel, bodies: make(map[int]*fetchBody)}
+	factory, err := fns.script.Run(c)
+	if err != nil {
+		return err
+	}
+	fn, err := factory.AsFunction()
+	if err != nil {
+		return err
+	}
+	exports, err := fn.Call(Undefined(c.iso), fns.start.GetFunction(c), fns.read.GetFunction(c),
+		fns.readAll.GetFunction(c), fns.cancel.GetFunction(c))
+	if err != nil {
+		return err
+	}
+	obj, err := exports.AsObject()
+	if err != nil {
+		return err
+	}
+	global := c.Global()
+	for _, name := range []string{"fetch", "Headers"} {
+		val, err := obj.Get(name)
+		if err != nil {
+			return err
+		}
+		if err := global.Set(name, val); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// add registers an open response body and returns its id.
+func (s *fetchState) add(body io.ReadCloser) int {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+	if s.bodies == nil {
+		// The context is closed.
+		body.Close()
+		return 0
+	}
+	s.seq++
+	s.bodies[s.seq] = &fetchBody{ReadCloser: body}
+	return s.seq
+}
+
+func (s *fetchState) get(id int) *fetchBody {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+	return s.bodies[id]
+}
+
+// take unregisters the body of id, for the caller to close.
+func (s *fetchState) take(id int) *fetchBody {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+	body := s.bodies[id]
+	delete(s.bodies, id)
+	return body
+}
+
+// close cancels the requests of the context and closes its open bodies.
+func (s *fetchState) close() {
+	s.cancel()
+	s.mutex.Lock()
+	bodies := s.bodies
+	s.bodies = nil
+	s.mutex.Unlock()
+	for _, body := range bodies {
+		body.Close()
+	}
+}
+
+// fetchNoLimit is the limit of bufferLimit when there is none.
+const fetchNoLimit = int(^uint(0) >> 1)
+
+// bufferLimit returns the most bytes that the next read of body may buffer:
+// what is left of the MaxBodySize of the options and, for an ArrayBuffer, of
+// the ArrayBufferQuota of the isolate. It is called with the isolate's lock.
+func (s *fetchState) bufferLimit(iso *Isolate, body *fetchBody, arrayBuffer bool) int {
+	limit := fetchNoLimit
+	if s.opts.MaxBodySize > 0 {
+		limit = s.opts.MaxBodySize - body.read
+	}
+	if quota := iso.arrayBufferQuota; arrayBuffer && quota > 0 {
+		left := 0
+		if used := iso.ArrayBufferMemory(); used < quota {
+			left = int(quota - used)
+		}
+		if left < limit {
+			limit = left
+		}
+	}
+	if limit < 0 {
+		limit = 0
+	}
+	return limit
+}
+
+var errFetchBody = errors.New("fetch: the body is closed")
+
+// fetchRangeError rejects a call with a RangeError of msg.
+func fetchRangeError(msg string) asyncValue {
+	return func(ctx *Context) (*Value, error) {
+		return nil, NewRangeError(ctx.iso, msg)
+	}
+}
+
+var (
+	fetchTooLarge    = fetchRangeError("fetch: the body exceeds its size limit")
+	fetchAllocFailed = fetchRangeError("Array buffer allocation failed")
+)
+
+// cBytes is the slice of the n bytes of C memory at data.
+func cBytes(data unsafe.Pointer, n int) []byte {
+	var b []byte
+	h := (*reflect.SliceHeader)(unsafe.Pointer(&b))
+	h.Data, h.Len, h.Cap = uintptr(data), n, n
+	return b
+}
+
+// fetchBuffer is the ArrayBuffer that adopts the n bytes of data, which is
+// freed if the buffer would exceed the ArrayBufferQuota of the isolate.
+func fetchBuffer(data unsafe.Pointer, n int) asyncValue {
+	return func(ctx *Context) (*Value, error) {
+		rtn := C.NewArrayBufferAdopted(ctx.ptr, data, C.size_t(n))
+		val, err := valueResult(ctx, rtn)
+		if err != nil {
+			return nil, NewRangeError(ctx.iso, err.Error())
+		}
+		return val, nil
+	}
+}
+
+// fetchStart sends a request: fetchStart(url, method, headers, body) resolves
+// to the arguments of the Response constructor.
+func fetchStart(info *FunctionCallbackInfo) (AsyncWork, error) {
+	state := info.Context().fetch
+	url := info.ArgString(0)
+	method := info.ArgString(1)
+	headers := info.ArgString(2)
+	var body []byte
+	if arg := info.Arg(3); arg.IsString() {
+		body = []byte(arg.String())
+	} else if arg.IsArrayBuffer() {
+		ab, _ := arg.AsArrayBuffer()
+		body = append([]byte(nil), ab.Bytes()...)
+	} else if arg.IsArrayBufferView() {
+		view, _ := arg.AsArrayBufferView()
+		body = append([]byte(nil), view.Bytes()...)
+	}
+	return func() (interface{}, error) {
+		var reader io.Reader
+		if body != nil {
+			reader = bytes.NewReader(body)
+		}
+		req, err := http.NewRequestWithContext(state.ctx, method, url, reader)
+		if err != nil {
+			return nil, err
+		}
+		if headers != "" {
+			list := strings.Split(headers, "\x00")
+			for i := 0; i+1 < len(list); i += 2 {
+				req.Header.Add(list[i], list[i+1])
+			}
+		}
+		resp, err := state.opts.Client.Do(req)
+		if err != nil {
+			return nil, err
+		}
+		var list []string
+		for k, vs := range resp.Header {
+			for _, v := range vs {
+				list = append(list, k, v)
+			}
+		}
+		id := 0
+		if resp.Body != http.NoBody {
+			if id = state.add(resp.Body); id == 0 {
+				return nil, context.Canceled
+			}
+		} else {
+			resp.Body.Close()
+		}
+		statusText := ""
+		if i := strings.IndexByte(resp.Status, ' '); i >= 0 {
+			statusText = resp.Status[i+1:]
+		}
+		return []interface{}{resp.StatusCode, statusText, resp.Request.URL.String(), strings.Join(list, "\x00"), id}, nil
+	}, nil
+}
+
+// fetchRead reads the next chunk of a body: fetchRead(id) resolves to an
+// ArrayBuffer, or null at the end of the body.
+func fetchRead(info *FunctionCallbackInfo) (AsyncWork, error) {
+	ctx := info.Context()
+	state := ctx.fetch
+	id := int(info.ArgInt32(0))
+	body := state.get(id)
+	if body == nil {
+		return nil, errFetchBody
+	}
+	// A byte past the limit is read to tell a body that exceeds it.
+	limit := state.bufferLimit(ctx.iso, body, true)
+	size := state.opts.ChunkSize
+	if limit < size {
+		size = limit + 1
+	}
+	return func() (interface{}, error) {
+		data := C.malloc(C.size_t(size))
+		if data == nil {
+			return fetchAllocFailed, nil
+		}
+		n, err := body.Read(cBytes(data, size))
+		if n == 0 || n > limit {
+			C.free(data)
+			if body := state.take(id); body != nil {
+				body.Close()
+			}
+			if n > limit {
+				return fetchTooLarge, nil
+			}
+			if err == nil || err == io.EOF {
+				return nil, nil
+			}
+			return nil, err
+		}
+		body.read += n
+		// A read that leaves most of the chunk empty, as reads of a body
+		// streamed in small pieces do, gives the rest of it back.
+		if n < size/2 {
+			if p := C.realloc(data, C.size_t(n)); p != nil {
+				data = p
+			}
+		}
+		return fetchBuffer(data, n), nil
+	}, nil
+}
+
+// fetchReadAll reads the rest of a body: fetchReadAll(id, text) resolves to
+// a string if text is true, or else to an ArrayBuffer.
+func fetchReadAll(info *FunctionCallbackInfo) (AsyncWork, error) {
+	ctx := info.Context()
+	state := ctx.fetch
+	body := state.take(int(info.ArgInt32(0)))
+	if body == nil {
+		return nil, errFetchBody
+	}
+	text := info.ArgBoolean(1)
+	limit := state.bufferLimit(ctx.iso, body, !text)
+	return func() (interface{}, error) {
+		defer body.Close()
+		if text {
+			var r io.Reader = body
+			if limit < fetchNoLimit {
+				r = io.LimitReader(body, int64(limit)+1)
+			}
+			b, err := ioutil.ReadAll(r)
+			if err != nil {
+				return nil, err
+			}
+			if len(b) > limit {
+				return fetchTooLarge, nil
+			}
+			return string(b), nil
+		}
+		size, n := state.opts.ChunkSize, 0
+		if limit < size {
+			size = limit + 1
+		}
+		data := C.malloc(C.size_t(size))
+		if data == nil {
+			return fetchAllocFailed, nil
+		}
+		for {
+			if n == size {
+				// The buffer grows up to a byte past the limit.
+				if limit-size < size {
+					size = limit + 1
+				} else {
+					size *= 2
+				}
+				p := C.realloc(data, C.size_t(size))
+				if p == nil {
+					C.free(data)
+					return fetchAllocFailed, nil
+				}
+				data = p
+			}
+			m, err := body.Read(cBytes(data, size)[n:])
+			n += m
+			if n > limit {
+				C.free(data)
+				return fetchTooLarge, nil
+			}
+			if err == io.EOF {
+				break
+			}
+			if err != nil {
+				C.free(data)
+				return nil, err
+			}
+		}
+		if n > 0 && n < size {
+			if p := C.realloc(data, C.size_t(n)); p != nil {
+				data = p
+			}
+		}
+		return fetchBuffer(data, n), nil
+	}, nil
+}
@@ -0,0 +1,216 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"context"
+	"fmt"
+	"io/ioutil"
+	"net/http"
+	"net/http/httptest"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func fetchServer(t testing.TB) *httptest.Server {
+	srv := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		switch r.URL.Path {
+		case "/echo":
+			body, _ := ioutil.ReadAll(r.Body)
+			w.Header().Set("X-Method", r.Method)
+			w.Header().Set("X-Token", r.Header.Get("X-Token"))
+			w.Header().Set("Content-Type", "application/json")
+			fmt.Fprintf(w, `{"path":%q,"body":%q}`, r.URL.RawQuery, body)
+		case "/stream":
+			flusher := w.(http.Flusher)
+			for i := 0; i < 3; i++ {
+				fmt.Fprintf(w, "chunk%d;", i)
+				flusher.Flush()
+			}
+		case "/big":
+			w.Write([]byte(strings.Repeat("x", 1<<20)))
+		case "/empty":
+			w.WriteHeader(http.StatusNoContent)
+		default:
+			http.NotFound(w, r)
+		}
+	}))
+	t.Cleanup(srv.Close)
+	return srv
+}
+
+func runFetch(t *testing.T, ctx *v8.Context, source string) *v8.Value {
+	t.Helper()
+	val, err := ctx.RunScript(source, "fetch.js")
+	fatalIf(t, err)
+	fatalIf(t, ctx.RunEventLoop(context.Background()))
+	p, err := val.AsPromise()
+	fatalIf(t, err)
+	if p.State() != v8.Fulfilled {
+		t.Fatalf("expected the promise to be fulfilled, got %v: %v", p.State(), p.Result().DetailString())
+	}
+	return p.Result()
+}
+
+func TestFetch(t *testing.T) {
+	t.Parallel()
+
+	srv := fetchServer(t)
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Fetch(v8.FetchOptions{ChunkSize: 4}))
+	defer ctx.Close()
+	fatalIf(t, ctx.Global().Set("base", srv.URL))
+
+	t.Run("json", func(t *testing.T) {
+		val := runFetch(t, ctx, `(async () => {
+			const r = await fetch(base + "/echo?q", {method: "post", headers: {"x-token": "t"}, body: "hi"});
+			const j = await r.json();
+			return [r.status, r.ok, r.statusText, r.headers.get("X-Method"), r.headers.get("x-token"), j.path, j.body, r.bodyUsed].join();
+		})()`)
+		if got, want := val.String(), "200,true,OK,POST,t,q,hi,true"; got != want {
+			t.Errorf("expected %q, got %q", want, got)
+		}
+	})
+
+	t.Run("concurrent", func(t *testing.T) {
+		val := runFetch(t, ctx, `(async () => {
+			const rs = await Promise.all(Array.from({length: 16}, (_, i) =>
+				fetch(base + "/echo?" + i).then((r) => r.json())));
+			return rs.map((j) => j.path).join();
+		})()`)
+		if got, want := val.String(), "0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15"; got != want {
+			t.Errorf("expected %q, got %q", want, got)
+		}
+	})
+
+	t.Run("stream", func(t *testing.T) {
+		val := runFetch(t, ctx, `(async () => {
+			const r = await fetch(base + "/stream");
+			let text = "", chunks = 0;
+			for await (const chunk of r.body) {
+				if (!(chunk instanceof Uint8Array) || chunk.length > 4) throw new Error("bad chunk");
+				text += String.fromCharCode(...chunk);
+				chunks++;
+			}
+			return [text, chunks >= 6, r.bodyUsed].join();
+		})()`)
+		if got, want := val.String(), "chunk0;chunk1;chunk2;,true,false"; got != want {
+			t.Errorf("expected %q, got %q", want, got)
+		}
+	})
+
+	t.Run("reader", func(t *testing.T) {
+		val := runFetch(t, ctx, `(async () => {
+			const r = await fetch(base + "/big");
+			const reader = r.body.getReader();
+			const first = await reader.read();
+			await reader.cancel();
+			return [first.value.length, r.bodyUsed].join();
+		})()`)
+		if got, want := val.String(), "4,true"; got != want {
+			t.Errorf("expected %q, got %q", want, got)
+		}
+	})
+
+	t.Run("arrayBuffer", func(t *testing.T) {
+		val := runFetch(t, ctx, `(async () => {
+			const r = await fetch(base + "/big");
+			const buf = await r.arrayBuffer();
+			const empty = await fetch(base + "/empty");
+			return [buf.byteLength, new Uint8Array(buf)[12345], empty.status, empty.body, (await empty.text()).length].join();
+		})()`)
+		if got, want := val.String(), fmt.Sprintf("%d,120,204,,0", 1<<20); got != want {
+			t.Errorf("expected %q, got %q", want, got)
+		}
+	})
+
+	t.Run("errors", func(t *testing.T) {
+		val := runFetch(t, ctx, `(async () => {
+			const errors = [];
+			for (const [url, init] of [["http://127.0.0.1:1/"], [base, {body: "x"}], ["::"]]) {
+				try { await fetch(url, init); } catch (e) { errors.push(e instanceof TypeError); }
+			}
+			const r = await fetch(base + "/missing");
+			await r.text();
+			try { await r.text(); } catch (e) { errors.push(e instanceof TypeError); }
+			return [r.status, r.ok, ...errors].join();
+		})()`)
+		if got, want := val.String(), "404,false,true,true,true,true"; got != want {
+			t.Errorf("expected %q, got %q", want, got)
+		}
+	})
+
+	h := runFetch(t, ctx, `Promise.resolve([...new Headers([["B", "1"], ["a", "2"], ["b", "3"]])].join(";"))`)
+	if got, want := h.String(), "a,2;b,1, 3"; got != want {
+		t.Errorf("expected %q, got %q", want, got)
+	}
+}
+
+func TestFetchQuota(t *testing.T) {
+	t.Parallel()
+
+	srv := fetchServer(t)
+	iso := v8.NewIsolate(v8.ArrayBufferQuota(1 << 10))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Fetch(v8.FetchOptions{}))
+	defer ctx.Close()
+	fatalIf(t, ctx.Global().Set("base", srv.URL))
+
+	val := runFetch(t, ctx, `fetch(base + "/big").then((r) => r.arrayBuffer()).then(() => "", (e) => e.name)`)
+	if got := val.String(); got != "RangeError" {
+		t.Errorf("expected a RangeError, got %q", got)
+	}
+}
+
+func TestFetchMaxBodySize(t *testing.T) {
+	t.Parallel()
+
+	srv := fetchServer(t)
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	// The body of /stream is exactly 21 bytes long.
+	ctx := v8.NewContext(iso, v8.Fetch(v8.FetchOptions{ChunkSize: 4, MaxBodySize: 21}))
+	defer ctx.Close()
+	fatalIf(t, ctx.Global().Set("base", srv.URL))
+
+	val := runFetch(t, ctx, `(async () => {
+		const results = [(await (await fetch(base + "/stream")).text()).length];
+		for (const read of [(r) => r.arrayBuffer(), (r) => r.text(), async (r) => { for await (const _ of r.body); }]) {
+			try {
+				await read(await fetch(base + "/big"));
+				results.push("read");
+			} catch (e) {
+				results.push(e.name);
+			}
+		}
+		return results.join();
+	})()`)
+	if got, want := val.String(), "21,RangeError,RangeError,RangeError"; got != want {
+		t.Errorf("expected %q, got %q", want, got)
+	}
+}
+
+func BenchmarkFetch(b *testing.B) {
+	srv := fetchServer(b)
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Fetch(v8.FetchOptions{}))
+	defer ctx.Close()
+	ctx.Global().Set("base", srv.URL)
+	fn, _ := ctx.RunScript(`() => Promise.all(Array.from({length: 8}, () => fetch(base + "/echo").then((r) => r.json())))`, "bench.js")
+	f, _ := fn.AsFunction()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := f.Call(v8.Undefined(iso)); err != nil {
+			b.Fatal(err)
+		}
+		if err := ctx.RunEventLoop(context.Background()); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
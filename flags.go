@@ -0,0 +1,161 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"fmt"
+	"strconv"
+)
+
+// Flag is a typed V8 flag, the tuning knobs of the compilation tiers and the
+// garbage collector that SetEngineFlags sets. Like those of SetFlags, flags
+// are global to the process: V8 has no per isolate tiering.
+//
+// Scripts that run once, in isolates that are thrown away, spend CPU on
+// TurboFan and on feedback that never pays off; for them,
+//
+//	v8go.SetEngineFlags(v8go.Optimize(false), v8go.MaxLazy(true))
+//
+// leaves the code in the interpreter and Sparkplug, and compiles functions
+// only once they are called.
+type Flag struct {
+	name  string
+	value string
+	// init flags only take effect before the first isolate is created.
+	init bool
+}
+
+// String returns the flag as it is passed to SetFlags.
+func (f Flag) String() string {
+	if f.value == "true" {
+		return "--" + f.name
+	}
+	if f.value == "false" {
+		return "--no" + f.name
+	}
+	return "--" + f.name + "=" + f.value
+}
+
+func boolFlag(name string, on bool) Flag {
+	return Flag{name: name, value: strconv.FormatBool(on)}
+}
+
+func intFlag(name string, n int) Flag {
+	return Flag{name: name, value: strconv.Itoa(n)}
+}
+
+// Optimize turns TurboFan, the optimizing compiler, on or off (--opt). It is
+// on by default.
+func Optimize(on bool) Flag {
+	return boolFlag("opt", on)
+}
+
+// Sparkplug turns Sparkplug, the baseline compiler between the interpreter
+// and TurboFan, on or off (--sparkplug).
+func Sparkplug(on bool) Flag {
+	return boolFlag("sparkplug", on)
+}
+
+// MaxLazy compiles the functions of scripts only when they are first called,
+// including those that V8 would compile eagerly (--max-lazy).
+func MaxLazy(on bool) Flag {
+	return boolFlag("max_lazy", on)
+}
+
+// LazyFeedbackAllocation delays the allocation of the feedback of functions
+// until they have run for a while, which saves memory for functions that run
+// a few times (--lazy-feedback-allocation). It is on by default.
+func LazyFeedbackAllocation(on bool) Flag {
+	return boolFlag("lazy_feedback_allocation", on)
+}
+
+// InterruptBudget is the amount of bytecode, in bytes, that a function
+// executes between the checks of whether it is hot enough to be optimized by
+// TurboFan (--interrupt-budget); higher budgets tier up later.
+func InterruptBudget(bytes int) Flag {
+	return intFlag("interrupt_budget", bytes)
+}
+
+// FeedbackAllocationBudget is the amount of bytecode, in bytes, that a
+// function executes before its feedback is allocated, with
+// LazyFeedbackAllocation (--budget-for-feedback-vector-allocation).
+func FeedbackAllocationBudget(bytes int) Flag {
+	return intFlag("budget_for_feedback_vector_allocation", bytes)
+}
+
+// TicksBeforeOptimization is the number of interrupt budgets that a function
+// uses up before TurboFan optimizes it (--ticks-before-optimization).
+func TicksBeforeOptimization(ticks int) Flag {
+	return intFlag("ticks_before_optimization", ticks)
+}
+
+// SingleThreadedGC runs the garbage collector on the thread of the isolate
+// only, without concurrent or parallel marking and sweeping
+// (--single-threaded-gc), for processes that run many isolates and should
+// not compete with them for cores. It must be set before the first isolate is
+// created.
+func SingleThreadedGC(on bool) Flag {
+	f := boolFlag("single_threaded_gc", on)
+	f.init = true
+	return f
+}
+
+// RegExpLinearEngine turns on the experimental linear-time engine of V8 for
+// regular expressions (--enable-experimental-regexp-engine), which matches
+// RegExps with the RegExpLinear flag, or the l flag of a literal. V8 has no
+// per isolate RegExp engine setting, so it applies to every isolate of the
+// process.
+func RegExpLinearEngine(on bool) Flag {
+	return boolFlag("enable_experimental_regexp_engine", on)
+}
+
+// RegExpBacktrackFallback makes V8 match again with its linear-time engine,
+// rather than keep backtracking, once a match has backtracked more than
+// RegExpBacktracksBeforeFallback times, or more than the limit of a RegExp
+// from NewRegExpWithBacktrackLimit
+// (--enable-experimental-regexp-engine-on-excessive-backtracks). This bounds
+// the time of the patterns that the engine supports without failing them;
+// the others keep backtracking. Like RegExpLinearEngine, it applies to every
+// isolate of the process.
+func RegExpBacktrackFallback(on bool) Flag {
+	return boolFlag("enable_experimental_regexp_engine_on_excessive_backtracks", on)
+}
+
+// RegExpBacktracksBeforeFallback is the number of backtracks of a match after
+// which RegExpBacktrackFallback falls back to the linear-time engine
+// (--regexp-backtracks-before-fallback), for every isolate of the process.
+// A RegExp from NewRegExpWithBacktrackLimit has a limit of its own.
+func RegExpBacktracksBeforeFallback(backtracks int) Flag {
+	return intFlag("regexp_backtracks_before_fallback", backtracks)
+}
+
+// SetEngineFlags sets the flags of V8, which affect every isolate, including
+// those that exist. It returns ErrPlatformInitialized, and sets none of the
+// flags, if one of them must be set before the first isolate is created, and
+// V8 has been initialized.
+func SetEngineFlags(flags ...Flag) error {
+	args := make([]string, len(flags))
+	for i, f := range flags {
+		if f.name == "" {
+			return fmt.Errorf("v8go: Flag %d is not set", i)
+		}
+		if n, err := strconv.Atoi(f.value); err == nil && n < 0 {
+			return fmt.Errorf("v8go: negative value of %s", f)
+		}
+		args[i] = f.String()
+	}
+
+	platformMutex.Lock()
+	defer platformMutex.Unlock()
+	if platformInitialized {
+		for _, f := range flags {
+			if f.init {
+				return ErrPlatformInitialized
+			}
+		}
+	}
+	SetFlags(args...)
+	return nil
+}
@@ -0,0 +1,92 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"os"
+	"os/exec"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestFlagString(t *testing.T) {
+	t.Parallel()
+	tests := []struct {
+		flag v8.Flag
+		want string
+	}{
+		{v8.Optimize(false), "--noopt"},
+		{v8.Sparkplug(true), "--sparkplug"},
+		{v8.InterruptBudget(1 << 20), "--interrupt_budget=1048576"},
+		{v8.RegExpBacktracksBeforeFallback(1000), "--regexp_backtracks_before_fallback=1000"},
+	}
+	for _, tt := range tests {
+		if got := tt.flag.String(); got != tt.want {
+			t.Errorf("expected %q, got %q", tt.want, got)
+		}
+	}
+	if err := v8.SetEngineFlags(v8.InterruptBudget(-1)); err == nil {
+		t.Error("expected an error for a negative budget")
+	}
+	if err := v8.SetEngineFlags(v8.Flag{}); err == nil {
+		t.Error("expected an error for a zero Flag")
+	}
+}
+
+// TestSetEngineFlags runs in a process of its own, as the flags are global
+// and some have to be set before the first isolate of the process is created.
+func TestSetEngineFlags(t *testing.T) {
+	if os.Getenv("V8GO_TEST_ENGINE_FLAGS") == "" {
+		t.Parallel()
+		cmd := exec.Command(os.Args[0], "-test.run=^TestSetEngineFlags$", "-test.v")
+		cmd.Env = append(os.Environ(), "V8GO_TEST_ENGINE_FLAGS=1")
+		if out, err := cmd.CombinedOutput(); err != nil {
+			t.Fatalf("%v\n%s", err, out)
+		}
+		return
+	}
+
+	fatalIf(t, v8.SetEngineFlags(v8.SingleThreadedGC(true), v8.Optimize(false), v8.MaxLazy(true)))
+	v8.SetFlags("--allow-natives-syntax")
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	// The bit of %GetOptimizationStatus that tells a function is optimized.
+	const optimized = 1 << 4
+	val, err := ctx.RunScript(`
+		function add(a, b) { return a + b; }
+		%PrepareFunctionForOptimization(add);
+		add(1, 2);
+		add(3, 4);
+		%OptimizeFunctionOnNextCall(add);
+		add(5, 6);
+		%GetOptimizationStatus(add);
+	`, "opt.js")
+	fatalIf(t, err)
+	if val.Int32()&optimized != 0 {
+		t.Errorf("expected the function not to be optimized, got status %#x", val.Int32())
+	}
+
+	if err := v8.SetEngineFlags(v8.SingleThreadedGC(false)); err != v8.ErrPlatformInitialized {
+		t.Errorf("expected ErrPlatformInitialized, got %v", err)
+	}
+	fatalIf(t, v8.SetEngineFlags(v8.Optimize(true)))
+	val, err = ctx.RunScript(`
+		function mul(a, b) { return a * b; }
+		%PrepareFunctionForOptimization(mul);
+		mul(1, 2);
+		mul(3, 4);
+		%OptimizeFunctionOnNextCall(mul);
+		mul(5, 6);
+		%GetOptimizationStatus(mul);
+	`, "opt.js")
+	fatalIf(t, err)
+	if val.Int32()&optimized == 0 {
+		t.Errorf("expected the function to be optimized, got status %#x", val.Int32())
+	}
+}
@@ -8,7 +8,9 @@ package v8go
 // #include "v8go.h"
 import "C"
 import (
+	"math"
 	"runtime"
+	"strconv"
 	"unsafe"
 )
 
@@ -26,6 +28,13 @@ type FunctionCallbackInfo struct {
 	ctx  *Context
 	args []*Value
 	this *Object
+
+	// For templates created with PackedArgs, the arguments are delivered by
+	// value and only turned into a *Value when used; cinfo is only valid until
+	// the callback returns.
+	cinfo   C.CallbackInfoPtr
+	packed  []C.CallbackArg
+	expired bool
 }
 
 // A ValueError can be returned from a FunctionCallbackWithError, and
@@ -42,36 +51,257 @@ func (i *FunctionCallbackInfo) Context() *Context {
 
 // This returns the receiver object "this".
 func (i *FunctionCallbackInfo) This() *Object {
+	if i.this == nil && (i.packed != nil || i.expired) {
+		ptr := C.CallbackInfoThis(i.callbackInfo())
+		i.this = &Object{newValue(i.ctx, ptr)}
+	}
 	return i.this
 }
 
 // Args returns a slice of the value arguments that are passed to the JS function.
 func (i *FunctionCallbackInfo) Args() []*Value {
+	if i.args == nil && i.packed != nil {
+		args := make([]*Value, len(i.packed))
+		for n := range i.packed {
+			args[n] = i.Arg(n)
+		}
+		i.args = args
+	}
 	return i.args
 }
 
+// Length returns the number of arguments passed to the JS function.
+func (i *FunctionCallbackInfo) Length() int {
+	if i.expired {
+		panic(errCallbackInfoExpired)
+	}
+	if i.packed != nil {
+		return len(i.packed)
+	}
+	return len(i.args)
+}
+
+// Arg returns the argument at index n, or undefined if fewer arguments were
+// passed to the JS function.
+func (i *FunctionCallbackInfo) Arg(n int) *Value {
+	if n < 0 || n >= i.Length() {
+		return Undefined(i.ctx.iso)
+	}
+	if i.args != nil {
+		return i.args[n]
+	}
+	arg := &i.packed[n]
+	switch arg.kind {
+	case C.CALLBACK_ARG_UNDEFINED:
+		return Undefined(i.ctx.iso)
+	case C.CALLBACK_ARG_NULL:
+		return Null(i.ctx.iso)
+	case C.CALLBACK_ARG_BOOLEAN:
+		return i.ctx.iso.cachedValue(C.CACHED_VALUE_FALSE - int(arg.int32))
+	case C.CALLBACK_ARG_INT32:
+		if cached, ok := i.ctx.iso.cachedInt(int64(arg.int32)); ok {
+			return cached
+		}
+	}
+	ptr := C.CallbackInfoArg(i.callbackInfo(), C.int(n))
+	return newValue(i.ctx, ptr)
+}
+
+// ArgInt32 returns the argument at index n converted to an int32, as
+// `arg | 0` would in JS. For templates created with PackedArgs, primitive
+// arguments are converted without calling into V8.
+func (i *FunctionCallbackInfo) ArgInt32(n int) int32 {
+	if arg := i.packedArg(n); arg != nil {
+		switch arg.kind {
+		case C.CALLBACK_ARG_INT32, C.CALLBACK_ARG_BOOLEAN:
+			return int32(arg.int32)
+		case C.CALLBACK_ARG_NUMBER:
+			return toInt32(float64(arg.number))
+		case C.CALLBACK_ARG_UNDEFINED, C.CALLBACK_ARG_NULL:
+			return 0
+		}
+	}
+	return i.Arg(n).Int32()
+}
+
+// ArgNumber returns the argument at index n converted to a number, as
+// `Number(arg)` would in JS. For templates created with PackedArgs, primitive
+// arguments are converted without calling into V8.
+func (i *FunctionCallbackInfo) ArgNumber(n int) float64 {
+	if arg := i.packedArg(n); arg != nil {
+		switch arg.kind {
+		case C.CALLBACK_ARG_INT32, C.CALLBACK_ARG_NUMBER:
+			return float64(arg.number)
+		case C.CALLBACK_ARG_BOOLEAN:
+			return float64(arg.int32)
+		case C.CALLBACK_ARG_UNDEFINED:
+			return math.NaN()
+		case C.CALLBACK_ARG_NULL:
+			return 0
+		}
+	}
+	return i.Arg(n).Number()
+}
+
+// ArgBoolean returns the argument at index n converted to a boolean, as
+// `Boolean(arg)` would in JS. For templates created with PackedArgs, primitive
+// arguments are converted without calling into V8.
+func (i *FunctionCallbackInfo) ArgBoolean(n int) bool {
+	if arg := i.packedArg(n); arg != nil {
+		switch arg.kind {
+		case C.CALLBACK_ARG_INT32, C.CALLBACK_ARG_BOOLEAN:
+			return arg.int32 != 0
+		case C.CALLBACK_ARG_NUMBER:
+			return arg.number != 0 && !math.IsNaN(float64(arg.number))
+		case C.CALLBACK_ARG_STRING:
+			return arg.length > 0
+		case C.CALLBACK_ARG_UNDEFINED, C.CALLBACK_ARG_NULL:
+			return false
+		}
+	}
+	return i.Arg(n).Boolean()
+}
+
+// ArgString returns the argument at index n converted to a string, as
+// `String(arg)` would in JS. For templates created with PackedArgs, short
+// strings and other primitives are converted without calling into V8.
+func (i *FunctionCallbackInfo) ArgString(n int) string {
+	if arg := i.packedArg(n); arg != nil {
+		switch arg.kind {
+		case C.CALLBACK_ARG_STRING:
+			return C.GoStringN(&arg.data[0], arg.length)
+		case C.CALLBACK_ARG_INT32:
+			return strconv.Itoa(int(arg.int32))
+		case C.CALLBACK_ARG_BOOLEAN:
+			return strconv.FormatBool(arg.int32 != 0)
+		case C.CALLBACK_ARG_UNDEFINED:
+			return "undefined"
+		case C.CALLBACK_ARG_NULL:
+			return "null"
+		}
+	}
+	return i.Arg(n).String()
+}
+
+// packedArg returns the packed argument at index n, or nil if the argument
+// was not passed or the callback did not receive packed arguments.
+func (i *FunctionCallbackInfo) packedArg(n int) *C.CallbackArg {
+	if i.args != nil || n < 0 || n >= len(i.packed) {
+		return nil
+	}
+	return &i.packed[n]
+}
+
+func (i *FunctionCallbackInfo) callbackInfo() C.CallbackInfoPtr {
+	if i.cinfo == nil {
+		panic(errCallbackInfoExpired)
+	}
+	return i.cinfo
+}
+
+const errCallbackInfoExpired = "v8go: packed FunctionCallbackInfo arguments used after the callback returned"
+
+// toInt32 performs the steps in https://tc39.es/ecma262/#sec-toint32.
+func toInt32(f float64) int32 {
+	if math.IsNaN(f) || math.IsInf(f, 0) {
+		return 0
+	}
+	return int32(uint32(int64(math.Mod(math.Trunc(f), 1<<32))))
+}
+
+// FunctionTemplateOption configures how a FunctionTemplate is created,
+// see NewFunctionTemplateWithError.
+type FunctionTemplateOption interface {
+	apply(*functionTemplateOptions)
+}
+
+type functionTemplateOptions struct {
+	packedArgs    bool
+	fastSignature C.FastCallbackSignature
+	fastFunction  fastFunction
+	signature     *FunctionTemplate
+	length        int
+
+	nonConstructor bool
+	sideEffectFree bool
+}
+
+type functionTemplateOptionFunc func(*functionTemplateOptions)
+
+func (f functionTemplateOptionFunc) apply(opts *functionTemplateOptions) {
+	f(opts)
+}
+
+// PackedArgs makes the arguments of the function reach the callback by
+// value: numbers, booleans, null, undefined and short strings are copied into
+// the FunctionCallbackInfo, and values for the receiver and for other
+// arguments are only created when used. Read arguments with the Arg* methods
+// of FunctionCallbackInfo to avoid creating values altogether. This is much
+// cheaper for hot host functions, but the FunctionCallbackInfo cannot be
+// used to access the arguments after the callback has returned.
+var PackedArgs FunctionTemplateOption = functionTemplateOptionFunc(func(opts *functionTemplateOptions) {
+	opts.packedArgs = true
+})
+
+// NonConstructor makes the function throw a TypeError when called with new,
+// and leaves out its prototype object, which saves an allocation for each
+// function made from the template.
+var NonConstructor FunctionTemplateOption = functionTemplateOptionFunc(func(opts *functionTemplateOptions) {
+	opts.nonConstructor = true
+})
+
+// SideEffectFree declares that the callback has no side effects observable
+// from JS, so that the function may be called by evaluations that must not
+// have any, such as the inspector's previews of expressions.
+var SideEffectFree FunctionTemplateOption = functionTemplateOptionFunc(func(opts *functionTemplateOptions) {
+	opts.sideEffectFree = true
+})
+
+// Length sets the length property of the function, the number of arguments
+// it expects, which is 0 by default.
+func Length(n int) FunctionTemplateOption {
+	return functionTemplateOptionFunc(func(opts *functionTemplateOptions) {
+		opts.length = n
+	})
+}
+
+// Signature makes the function throw a TypeError, without calling the
+// callback, unless it is called on an instance of receiver, that is an object
+// made by the function of receiver, or of a template that inherits from it.
+// Use it for the methods of a class set on its PrototypeTemplate, which can
+// then rely on the internal fields of their receiver.
+func Signature(receiver *FunctionTemplate) FunctionTemplateOption {
+	if receiver == nil {
+		panic("nil FunctionTemplate argument not supported")
+	}
+	return functionTemplateOptionFunc(func(opts *functionTemplateOptions) {
+		opts.signature = receiver
+	})
+}
+
 // FunctionTemplate is used to create functions at runtime.
 // There can only be one function created from a FunctionTemplate in a context.
 // The lifetime of the created function is equal to the lifetime of the context.
 type FunctionTemplate struct {
 	*template
+	cbref int
 }
 
 // NewFunctionTemplate creates a FunctionTemplate for a given
 // callback. Prefer using NewFunctionTemplateWithError.
-func NewFunctionTemplate(iso *Isolate, callback FunctionCallback) *FunctionTemplate {
+func NewFunctionTemplate(iso *Isolate, callback FunctionCallback, opts ...FunctionTemplateOption) *FunctionTemplate {
 	if callback == nil {
 		panic("nil FunctionCallback argument not supported")
 	}
 	return NewFunctionTemplateWithError(iso, func(info *FunctionCallbackInfo) (*Value, error) {
 		return callback(info), nil
-	})
+	}, opts...)
 }
 
 // NewFunctionTemplateWithError creates a FunctionTemplate for a given
 // callback. If the callback returns an error, it will be thrown as a
 // JS error.
-func NewFunctionTemplateWithError(iso *Isolate, callback FunctionCallbackWithError) *FunctionTemplate {
+func NewFunctionTemplateWithError(iso *Isolate, callback FunctionCallbackWithError, opts ...FunctionTemplateOption) *FunctionTemplate {
 	if iso == nil {
 		panic("nil Isolate argument not supported")
 	}
@@ -79,14 +309,81 @@ func NewFunctionTemplateWithError(iso *Isolate, callback FunctionCallbackWithErr
 		panic("nil FunctionCallback argument not supported")
 	}
 
+	var options functionTemplateOptions
+	for _, o := range opts {
+		if o != nil {
+			o.apply(&options)
+		}
+	}
+	var cOptions C.FunctionTemplateOptions
+	if options.packedArgs {
+		cOptions.packedArgs = 1
+	}
+	cOptions.fastSignature = C.int(options.fastSignature)
+	if options.signature != nil {
+		cOptions.signature = options.signature.ptr
+	}
+	cOptions.length = C.int(options.length)
+	if options.nonConstructor {
+		cOptions.nonConstructor = 1
+	}
+	if options.sideEffectFree {
+		cOptions.sideEffectFree = 1
+	}
+
+	iso.releaseCallbacks()
 	cbref := iso.registerCallback(callback)
+	if options.fastFunction != nil {
+		iso.registerFastFunction(cbref, options.fastFunction)
+	}
 
 	tmpl := &template{
-		ptr: C.NewFunctionTemplate(iso.ptr, C.int(cbref)),
+		ptr: C.NewFunctionTemplate(iso.ptr, C.int(cbref), cOptions),
 		iso: iso,
 	}
+	runtime.KeepAlive(options.signature)
 	runtime.SetFinalizer(tmpl, (*template).finalizer)
-	return &FunctionTemplate{tmpl}
+	iso.trackTemplate(tmpl)
+	return &FunctionTemplate{tmpl, cbref}
+}
+
+// PrototypeTemplate returns the template of the prototype object of the
+// function, on which to set the methods and accessors that every instance
+// shares, so that instances share their hidden class and V8 can cache the
+// lookups of their methods.
+func (tmpl *FunctionTemplate) PrototypeTemplate() *ObjectTemplate {
+	ptr := C.FunctionTemplatePrototypeTemplate(tmpl.ptr)
+	runtime.KeepAlive(tmpl)
+	return newObjectTemplate(tmpl.iso, ptr)
+}
+
+// InstanceTemplate returns the template of the objects that the function
+// creates when called as a constructor, such as to set their internal field
+// count; the callback receives the new object as This.
+func (tmpl *FunctionTemplate) InstanceTemplate() *ObjectTemplate {
+	ptr := C.FunctionTemplateInstanceTemplate(tmpl.ptr)
+	runtime.KeepAlive(tmpl)
+	return newObjectTemplate(tmpl.iso, ptr)
+}
+
+// Inherit makes the prototype of the function inherit from the prototype of
+// the function of parent, as with class extends in JS, and its instances
+// instances of parent for Signature. It must be called before any function is
+// made from the template.
+func (tmpl *FunctionTemplate) Inherit(parent *FunctionTemplate) {
+	C.FunctionTemplateInherit(tmpl.ptr, parent.ptr)
+	runtime.KeepAlive(tmpl)
+	runtime.KeepAlive(parent)
+}
+
+// SetClassName sets the name of the function, which is also the name of its
+// instances in stack traces and heap snapshots. It must be called before any
+// function is made from the template.
+func (tmpl *FunctionTemplate) SetClassName(name string) {
+	cname := C.CString(name)
+	defer C.free(unsafe.Pointer(cname))
+	C.FunctionTemplateSetClassName(tmpl.ptr, cname)
+	runtime.KeepAlive(tmpl)
 }
 
 // GetFunction returns an instance of this function template bound to the given context.
@@ -109,30 +406,61 @@ func goFunctionCallback(ctxref int, cbref int, thisAndArgs *C.ValuePtr, argsCoun
 	this := *thisAndArgs
 	info := &FunctionCallbackInfo{
 		ctx:  ctx,
-		this: &Object{&Value{ptr: this, ctx: ctx}},
+		this: &Object{newValue(ctx, this)},
 		args: make([]*Value, argsCount),
 	}
 
 	argv := (*[1 << 30]C.ValuePtr)(unsafe.Pointer(thisAndArgs))[1 : argsCount+1 : argsCount+1]
 	for i, v := range argv {
-		val := &Value{ptr: v, ctx: ctx}
+		val := newValue(ctx, v)
 		info.args[i] = val
 	}
 
+	return callFunctionCallback(info, cbref)
+}
+
+//export goPackedFunctionCallback
+func goPackedFunctionCallback(ctxref int, cbref int, cinfo C.CallbackInfoPtr, args *C.CallbackArg, argsCount int) (rval C.ValuePtr, rerr C.ValuePtr) {
+	ctx := getContext(ctxref)
+
+	info := &FunctionCallbackInfo{
+		ctx:    ctx,
+		cinfo:  cinfo,
+		packed: (*[1 << 24]C.CallbackArg)(unsafe.Pointer(args))[:argsCount:argsCount],
+	}
+	defer func() {
+		// The packed arguments live on the C stack of the callback; arguments
+		// that were already turned into values remain usable.
+		info.expired = info.args == nil
+		info.cinfo = nil
+		info.packed = nil
+	}()
+
+	return callFunctionCallback(info, cbref)
+}
+
+func callFunctionCallback(info *FunctionCallbackInfo, cbref int) (rval C.ValuePtr, rerr C.ValuePtr) {
+	ctx := info.ctx
 	callbackFunc := ctx.iso.getCallback(cbref)
 	val, err := callbackFunc(info)
 	if err != nil {
-		if verr, ok := err.(ValueError); ok {
-			return nil, verr.value().ptr
-		}
-		errv, err := NewValue(ctx.iso, err.Error())
-		if err != nil {
-			panic(err)
-		}
-		return nil, errv.ptr
+		return nil, callbackError(ctx, err)
 	}
 	if val == nil {
 		return nil, nil
 	}
 	return val.ptr, nil
 }
+
+// callbackError returns the value to throw for the error of a callback: the
+// value of a ValueError, or else the string of the error.
+func callbackError(ctx *Context, err error) C.ValuePtr {
+	if verr, ok := err.(ValueError); ok {
+		return verr.value().ptr
+	}
+	errv, err := NewValue(ctx.iso, err.Error())
+	if err != nil {
+		panic(err)
+	}
+	return errv.ptr
+}
@@ -133,6 +133,92 @@ func TestFunctionTemplateGetFunction(t *testing.T) {
 	})
 }
 
+func TestFunctionTemplateClass(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	type point struct{ x, y float64 }
+	pointClass := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		h := v8.NewHandle(&point{info.ArgNumber(0), info.ArgNumber(1)})
+		info.This().SetAlignedPointerInInternalField(0, h)
+		info.This().SetWeak(h.Delete)
+		return nil
+	})
+	pointClass.SetClassName("Point")
+	pointClass.InstanceTemplate().SetInternalFieldCount(1)
+	receiver := func(info *v8.PropertyCallbackInfo) *point {
+		return info.This().GetAlignedPointerFromInternalField(0).Value().(*point)
+	}
+	pointClass.PrototypeTemplate().SetAccessor("x", func(info *v8.PropertyCallbackInfo) (*v8.Value, error) {
+		return v8.NewValue(iso, receiver(info).x)
+	}, nil)
+	norm := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		p := info.This().GetAlignedPointerFromInternalField(0).Value().(*point)
+		val, _ := v8.NewValue(iso, p.x*p.x+p.y*p.y)
+		return val
+	}, v8.Signature(pointClass))
+	fatalIf(t, pointClass.PrototypeTemplate().Set("norm", norm))
+
+	labeledClass := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		h := v8.NewHandle(&point{info.ArgNumber(0), info.ArgNumber(1)})
+		info.This().SetAlignedPointerInInternalField(0, h)
+		info.This().SetWeak(h.Delete)
+		return nil
+	})
+	labeledClass.SetClassName("LabeledPoint")
+	labeledClass.InstanceTemplate().SetInternalFieldCount(1)
+	labeledClass.Inherit(pointClass)
+
+	global := v8.NewObjectTemplate(iso)
+	fatalIf(t, global.Set("Point", pointClass))
+	fatalIf(t, global.Set("LabeledPoint", labeledClass))
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`
+		const p = new Point(3, 4);
+		const l = new LabeledPoint(1, 2);
+		[
+			p.norm(), p.x, l.norm(), l instanceof Point,
+			Point.name, Object.getPrototypeOf(p) === Object.getPrototypeOf(new Point(0, 0)),
+			p.hasOwnProperty("norm"),
+		].join()
+	`, "class.js")
+	fatalIf(t, err)
+	if want := "25,3,5,true,Point,true,false"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+
+	_, err = ctx.RunScript("p.norm.call({})", "receiver.js")
+	if err == nil || !strings.Contains(err.Error(), "Illegal invocation") {
+		t.Errorf("expected the signature to reject the receiver, got %v", err)
+	}
+}
+
+func TestFunctionTemplateOptions(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	cb := func(*v8.FunctionCallbackInfo) *v8.Value { return nil }
+	global := v8.NewObjectTemplate(iso)
+	fatalIf(t, global.Set("plain", v8.NewFunctionTemplate(iso, cb)))
+	fatalIf(t, global.Set("host", v8.NewFunctionTemplate(iso, cb, v8.NonConstructor, v8.SideEffectFree, v8.Length(2))))
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript("[plain.length, typeof plain.prototype, typeof new plain(), host.length, typeof host.prototype, host()].join()", "options.js")
+	fatalIf(t, err)
+	if want := "0,object,object,2,undefined,"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+	if _, err := ctx.RunScript("new host()", "new.js"); err == nil || !strings.Contains(err.Error(), "not a constructor") {
+		t.Errorf("expected a TypeError from new, got %v", err)
+	}
+}
+
 func TestFunctionCallbackInfoThis(t *testing.T) {
 	t.Parallel()
 
@@ -162,6 +248,71 @@ func TestFunctionCallbackInfoThis(t *testing.T) {
 	}
 }
 
+func TestFunctionTemplatePackedArgs(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	var got []string
+	var ints []int32
+	var bools []bool
+	fn := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		got = got[:0]
+		ints = ints[:0]
+		bools = bools[:0]
+		for n := 0; n < info.Length(); n++ {
+			got = append(got, info.ArgString(n))
+			ints = append(ints, info.ArgInt32(n))
+			bools = append(bools, info.ArgBoolean(n))
+		}
+		if info.Length() > 0 {
+			return info.Arg(0)
+		}
+		return nil
+	}, v8.PackedArgs)
+
+	global := v8.NewObjectTemplate(iso)
+	global.Set("fn", fn)
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`fn(1, -2.5, 4294967297, true, null, undefined, "héllo", "`+strings.Repeat("x", 100)+`", {a: 1})`, "")
+	fatalIf(t, err)
+	if val.Int32() != 1 {
+		t.Errorf("expected first argument to be returned, got %v", val)
+	}
+	wantStrings := []string{"1", "-2.5", "4294967297", "true", "null", "undefined", "héllo", strings.Repeat("x", 100), "[object Object]"}
+	if fmt.Sprint(got) != fmt.Sprint(wantStrings) {
+		t.Errorf("unexpected string conversion: %q", got)
+	}
+	wantInts := []int32{1, -2, 1, 1, 0, 0, 0, 0, 0}
+	if fmt.Sprint(ints) != fmt.Sprint(wantInts) {
+		t.Errorf("unexpected int32 conversion: %v", ints)
+	}
+	wantBools := []bool{true, true, true, true, false, false, true, true, true}
+	if fmt.Sprint(bools) != fmt.Sprint(wantBools) {
+		t.Errorf("unexpected boolean conversion: %v", bools)
+	}
+
+	var info *v8.FunctionCallbackInfo
+	argsfn := v8.NewFunctionTemplate(iso, func(i *v8.FunctionCallbackInfo) *v8.Value {
+		info = i
+		if i.This() == nil {
+			t.Error("expected receiver")
+		}
+		return nil
+	}, v8.PackedArgs)
+	global.Set("argsfn", argsfn)
+	ctx2 := v8.NewContext(iso, global)
+	defer ctx2.Close()
+	_, err = ctx2.RunScript("argsfn('a')", "")
+	fatalIf(t, err)
+	if recoverPanic(func() { info.Arg(0) }) == nil {
+		t.Error("expected panic using packed arguments after the callback returned")
+	}
+}
+
 func ExampleFunctionTemplate() {
 	iso := v8.NewIsolate()
 	defer iso.Dispose()
@@ -177,3 +328,97 @@ func ExampleFunctionTemplate() {
 	// Output:
 	// [foo bar 0 1]
 }
+
+func TestFunctionTemplateCallbackReleased(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	newFunction := func() {
+		ctx := v8.NewContext(iso)
+		defer ctx.Close()
+		tmpl := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value { return nil })
+		fatalIf(t, ctx.Global().Set("f", tmpl.GetFunction(ctx)))
+		_, err := ctx.RunScript("f()", "f.js")
+		fatalIf(t, err)
+		tmpl.Release()
+	}
+	for i := 0; i < 10; i++ {
+		newFunction()
+	}
+	before := iso.CallbackCount()
+	iso.LowMemoryNotification()
+	newFunction()
+	if after := iso.CallbackCount(); after >= before {
+		t.Errorf("expected the callbacks of collected templates to be released, %d before and %d after", before, after)
+	}
+
+	// A template that is still in use keeps its callback.
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	called := false
+	tmpl := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		called = true
+		return nil
+	})
+	fatalIf(t, ctx.Global().Set("g", tmpl.GetFunction(ctx)))
+	tmpl.Release()
+	iso.LowMemoryNotification()
+	newFunction()
+	_, err := ctx.RunScript("g()", "g.js")
+	fatalIf(t, err)
+	if !called {
+		t.Error("expected a function of a released template to keep its callback")
+	}
+}
+
+func TestPromiseContinuationsReleasedOnClose(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	before := iso.CallbackCount()
+	ctx := v8.NewContext(iso)
+	for i := 0; i < 10; i++ {
+		resolver, err := v8.NewPromiseResolver(ctx)
+		fatalIf(t, err)
+		resolver.GetPromise().Then(func(info *v8.FunctionCallbackInfo) *v8.Value { return nil })
+	}
+	ctx.Close()
+	if after := iso.CallbackCount(); after != before {
+		t.Errorf("expected the continuations to be released with the context, %d before and %d after", before, after)
+	}
+}
+
+// BenchmarkFunctionTemplateCallback measures the round trip of a call from
+// JavaScript into a Go callback and back, by number of arguments.
+func BenchmarkFunctionTemplateCallback(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	fn := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		return nil
+	})
+	global := v8.NewObjectTemplate(iso)
+	global.Set("f", fn)
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+
+	for _, arity := range []int{0, 1, 4, 8} {
+		args := make([]string, arity)
+		for i := range args {
+			args[i] = fmt.Sprint(i)
+		}
+		loop, err := ctx.RunScript(fmt.Sprintf("(n) => { for (let i = 0; i < n; i++) f(%s); }", strings.Join(args, ", ")), "bench.js")
+		if err != nil {
+			b.Fatal(err)
+		}
+		fn, _ := loop.AsFunction()
+		b.Run(fmt.Sprintf("Args%d", arity), func(b *testing.B) {
+			b.ReportAllocs()
+			n, _ := v8.NewValue(iso, int32(b.N))
+			if _, err := fn.Call(v8.Undefined(iso), n); err != nil {
+				b.Fatal(err)
+			}
+		})
+	}
+}
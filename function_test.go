@@ -119,6 +119,91 @@ func TestFunctionCallError(t *testing.T) {
 	}
 }
 
+func TestFunctionCallBatch(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`(function(a, b) {
+		if (a < 0) throw new Error("negative");
+		return a * (b === undefined ? 10 : b);
+	})`, "scale.js")
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	num := func(n int32) v8.Valuer {
+		v, err := v8.NewValue(iso, n)
+		fatalIf(t, err)
+		return v
+	}
+
+	args := [][]v8.Valuer{{num(1), num(2)}, {num(3)}, {num(4), num(5)}}
+	results, err := fn.CallBatch(v8.Undefined(iso), args)
+	fatalIf(t, err)
+	if len(results) != 3 || results[0].Int32() != 2 || results[1].Int32() != 30 || results[2].Int32() != 20 {
+		t.Errorf("unexpected results: %v", results)
+	}
+	numbers, err := fn.CallBatchNumbers([]float64{-1}, v8.Undefined(iso), args)
+	fatalIf(t, err)
+	if len(numbers) != 4 || numbers[0] != -1 || numbers[1] != 2 || numbers[2] != 30 || numbers[3] != 20 {
+		t.Errorf("unexpected numbers: %v", numbers)
+	}
+
+	args[1] = []v8.Valuer{num(-1)}
+	results, err = fn.CallBatch(v8.Undefined(iso), args)
+	if err == nil || err.Error() != "Error: negative" {
+		t.Errorf("expected the exception of the second call, got %v", err)
+	}
+	if len(results) != 1 || results[0].Int32() != 2 {
+		t.Errorf("expected the result of the first call, got %v", results)
+	}
+	if results, err := fn.CallBatch(v8.Undefined(iso), nil); err != nil || len(results) != 0 {
+		t.Errorf("expected no results, got %v, %v", results, err)
+	}
+}
+
+func BenchmarkFunctionCallBatch(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	val, _ := ctx.RunScript("(function(row) { return row * 2 + 1; })", "")
+	fn, _ := val.AsFunction()
+	const n = 1000
+	args := make([][]v8.Valuer, n)
+	for i := range args {
+		v, _ := v8.NewValue(iso, int32(i))
+		args[i] = []v8.Valuer{v}
+	}
+	recv := v8.Undefined(iso)
+
+	b.Run("Call", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				for _, list := range args {
+					fn.Call(recv, list...)
+				}
+			})
+		}
+	})
+	b.Run("CallBatch", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				fn.CallBatch(recv, args)
+			})
+		}
+	})
+	b.Run("CallBatchNumbers", func(b *testing.B) {
+		var numbers []float64
+		for i := 0; i < b.N; i++ {
+			numbers, _ = fn.CallBatchNumbers(numbers[:0], recv, args)
+		}
+	})
+}
+
 func TestFunctionSourceMapUrl(t *testing.T) {
 	t.Parallel()
 
@@ -202,3 +287,49 @@ func TestFunctionNewInstanceError(t *testing.T) {
 		t.Errorf("want %+v, got: %+v", want, got)
 	}
 }
+
+func TestContextCompileFunction(t *testing.T) {
+	t.Parallel()
+
+	const source = "return prefix + req.name;"
+	compile := func(opts v8.CompileFunctionOptions) (*v8.Function, *v8.Context) {
+		iso := v8.NewIsolate()
+		t.Cleanup(iso.Dispose)
+		ctx := v8.NewContext(iso)
+		t.Cleanup(ctx.Close)
+
+		ext, err := ctx.RunScript("({prefix: 'hello '})", "ext.js")
+		fatalIf(t, err)
+		extObj, err := ext.AsObject()
+		fatalIf(t, err)
+		opts.Arguments = []string{"req"}
+		opts.ContextExtensions = []*v8.Object{extObj}
+		fn, err := ctx.CompileFunction(source, "handler.js", opts)
+		fatalIf(t, err)
+
+		req, err := ctx.RunScript("({name: 'world'})", "req.js")
+		fatalIf(t, err)
+		val, err := fn.Call(v8.Undefined(iso), req)
+		fatalIf(t, err)
+		if val.String() != "hello world" {
+			t.Errorf("expected hello world, got %v", val)
+		}
+		return fn, ctx
+	}
+
+	fn, _ := compile(v8.CompileFunctionOptions{})
+	cachedData := fn.CreateCodeCache()
+	if len(cachedData.Bytes) == 0 {
+		t.Fatal("expected a code cache for the function")
+	}
+
+	compile(v8.CompileFunctionOptions{CompileOptions: v8.CompileOptions{CachedData: cachedData}})
+	if cachedData.Rejected {
+		t.Error("expected the code cache to be accepted")
+	}
+
+	_, ctx := compile(v8.CompileFunctionOptions{})
+	if _, err := ctx.CompileFunction("return )", "bad.js", v8.CompileFunctionOptions{}); err == nil {
+		t.Error("expected a syntax error")
+	}
+}
@@ -0,0 +1,89 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import "time"
+
+// GCType is the kind of a garbage collection.
+type GCType int
+
+// The GCTypes of v8::GCType.
+const (
+	GCScavenge             GCType = 1 << 0
+	GCMarkSweepCompact     GCType = 1 << 1
+	GCIncrementalMarking   GCType = 1 << 2
+	GCProcessWeakCallbacks GCType = 1 << 3
+)
+
+func (t GCType) String() string {
+	switch t {
+	case GCScavenge:
+		return "scavenge"
+	case GCMarkSweepCompact:
+		return "mark-sweep-compact"
+	case GCIncrementalMarking:
+		return "incremental-marking"
+	case GCProcessWeakCallbacks:
+		return "process-weak-callbacks"
+	}
+	return "unknown"
+}
+
+// GCEvent is a garbage collection of an isolate, see RecordGCEvents.
+type GCEvent struct {
+	Type     GCType
+	Start    time.Time
+	Duration time.Duration
+	// UsedBefore and UsedAfter are the used heap size in bytes at the start
+	// and at the end of the collection.
+	UsedBefore uint64
+	UsedAfter  uint64
+}
+
+// Freed returns the number of bytes the collection freed.
+func (e GCEvent) Freed() uint64 {
+	if e.UsedAfter > e.UsedBefore {
+		return 0
+	}
+	return e.UsedBefore - e.UsedAfter
+}
+
+// RecordGCEvents is an IsolateOption that makes the isolate record each of its
+// garbage collections, buffering up to capacity of them until they are
+// drained with Isolate.DrainGCEvents. Recording takes no lock, and collections
+// that find the buffer full are counted as dropped.
+func RecordGCEvents(capacity int) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.gcEventCapacity = capacity
+	})
+}
+
+// DrainGCEvents appends the GC events the isolate has recorded since the last
+// call to dst, along with the number of events dropped meanwhile. It can be
+// called from any goroutine, even while the isolate runs JavaScript; an
+// isolate created without RecordGCEvents has no events.
+func (i *Isolate) DrainGCEvents(dst []GCEvent) ([]GCEvent, uint64) {
+	var buf [64]C.GCEvent
+	var dropped uint64
+	for {
+		var d C.uint64_t
+		n := int(C.IsolateDrainGCEvents(i.ptr, &buf[0], C.size_t(len(buf)), &d))
+		dropped += uint64(d)
+		for _, e := range buf[:n] {
+			dst = append(dst, GCEvent{
+				Type:       GCType(e._type),
+				Start:      time.Unix(0, int64(e.start)),
+				Duration:   time.Duration(e.duration),
+				UsedBefore: uint64(e.usedBefore),
+				UsedAfter:  uint64(e.usedAfter),
+			})
+		}
+		if n < len(buf) {
+			return dst, dropped
+		}
+	}
+}
@@ -0,0 +1,65 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestRecordGCEvents(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.RecordGCEvents(256))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	start := time.Now()
+	_, err := ctx.RunScript("var garbage = []; for (let i = 0; i < 1e5; i++) garbage.push({i}); garbage = null", "garbage.js")
+	fatalIf(t, err)
+	iso.LowMemoryNotification()
+
+	events, dropped := iso.DrainGCEvents(nil)
+	if dropped != 0 {
+		t.Errorf("expected no dropped events, got %d", dropped)
+	}
+	var full *v8.GCEvent
+	for i, e := range events {
+		if e.Start.Before(start.Add(-time.Second)) || e.Duration < 0 {
+			t.Errorf("unexpected event %+v", e)
+		}
+		if e.Type == v8.GCMarkSweepCompact {
+			full = &events[i]
+		}
+	}
+	if full == nil {
+		t.Fatalf("expected a mark-sweep-compact collection, got %+v", events)
+	}
+	if full.Freed() == 0 {
+		t.Errorf("expected the collection to free the garbage, got %+v", *full)
+	}
+	if events, _ := iso.DrainGCEvents(nil); len(events) != 0 {
+		t.Errorf("expected the events to be drained, got %d", len(events))
+	}
+
+	// A full buffer drops the collections that do not fit.
+	small := v8.NewIsolate(v8.RecordGCEvents(1))
+	defer small.Dispose()
+	small.LowMemoryNotification()
+	events, dropped = small.DrainGCEvents(nil)
+	if len(events) != 1 || dropped == 0 {
+		t.Errorf("expected 1 event and some dropped, got %d and %d dropped", len(events), dropped)
+	}
+
+	plain := v8.NewIsolate()
+	defer plain.Dispose()
+	plain.LowMemoryNotification()
+	if events, _ := plain.DrainGCEvents(nil); len(events) != 0 {
+		t.Errorf("expected no events without RecordGCEvents, got %d", len(events))
+	}
+}
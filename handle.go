@@ -0,0 +1,47 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"sync"
+	"sync/atomic"
+)
+
+// Handle refers to a Go value from V8, in an internal field of an object,
+// see Object.SetAlignedPointerInInternalField, or in an External value, see
+// NewExternal. Go pointers cannot be kept by C, so the value is kept in a
+// table of the process that is read without taking a lock, the way
+// runtime/cgo.Handle does on Go 1.17 and later.
+//
+// A handle keeps its value alive until Delete is called, which an object can
+// do as its finalizer, see Object.SetWeak. The zero Handle is not valid.
+type Handle uintptr
+
+var (
+	handles   sync.Map // Handle -> interface{}
+	handleSeq uintptr
+)
+
+// NewHandle returns a handle for the value v.
+func NewHandle(v interface{}) Handle {
+	h := Handle(atomic.AddUintptr(&handleSeq, 1))
+	handles.Store(h, v)
+	return h
+}
+
+// Value returns the value of a valid handle.
+// Panics if the handle is invalid or has been deleted.
+func (h Handle) Value() interface{} {
+	v, ok := handles.Load(h)
+	if !ok {
+		panic("v8go: misuse of an invalid Handle")
+	}
+	return v
+}
+
+// Delete invalidates the handle, releasing its value.
+func (h Handle) Delete() {
+	handles.Delete(h)
+}
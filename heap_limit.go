@@ -0,0 +1,59 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import "sync"
+
+// HeapLimit describes an isolate whose heap has run out.
+type HeapLimit struct {
+	// Current is the heap limit in bytes that was reached.
+	Current uint64
+	// Initial is the heap limit in bytes that the isolate was created with.
+	Initial uint64
+}
+
+// heapLimitHandler is the OnHeapLimit handler of an isolate.
+type heapLimitHandler struct {
+	iso    *Isolate
+	handle func(*Isolate, HeapLimit)
+}
+
+// heapLimitRegistry maps the isolates that have an OnHeapLimit handler to
+// their *heapLimitHandler.
+var heapLimitRegistry sync.Map
+
+// OnHeapLimit is an IsolateOption that calls handle when the heap of the
+// isolate runs out, instead of V8 aborting the process. Either way, the
+// JavaScript that is running is terminated, the limit is raised for it to
+// unwind, and Isolate.HeapLimitReached reports true from then on; such an
+// isolate should only be disposed of.
+//
+// handle is called during a garbage collection, on the thread running the
+// isolate: it must not use the isolate, nor dispose of it; that is for the
+// caller of the terminated execution to do once it has returned.
+func OnHeapLimit(handle func(iso *Isolate, limit HeapLimit)) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.heapLimitHandler = handle
+	})
+}
+
+// HeapLimitReached returns whether the heap of the isolate has run out, in
+// which case its execution has been terminated and it should be disposed of.
+// Isolates of an IsolatePool whose heap has run out are replaced.
+func (i *Isolate) HeapLimitReached() bool {
+	return C.IsolateHeapLimitReached(i.ptr) != 0
+}
+
+//export goHeapLimitReached
+func goHeapLimitReached(iso C.IsolatePtr, current, initial C.size_t) {
+	v, ok := heapLimitRegistry.Load(iso)
+	if !ok {
+		return
+	}
+	h := v.(*heapLimitHandler)
+	h.handle(h.iso, HeapLimit{Current: uint64(current), Initial: uint64(initial)})
+}
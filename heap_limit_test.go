@@ -0,0 +1,73 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestOnHeapLimit(t *testing.T) {
+	t.Parallel()
+
+	var reached []v8.HeapLimit
+	var reachedIso *v8.Isolate
+	iso := v8.NewIsolate(v8.HeapSize(0, 16<<20), v8.OnHeapLimit(func(iso *v8.Isolate, limit v8.HeapLimit) {
+		reachedIso = iso
+		reached = append(reached, limit)
+	}))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript("[1, 2, 3].length", "quick.js")
+	fatalIf(t, err)
+	if val.Integer() != 3 || iso.HeapLimitReached() {
+		t.Fatalf("unexpected result %v, heap limit reached %v", val, iso.HeapLimitReached())
+	}
+
+	_, err = ctx.RunScript("const a = []; for (;;) { a.push({v: a.length}) }", "grow.js")
+	if err == nil {
+		t.Fatal("expected the execution to be terminated")
+	}
+	if !iso.HeapLimitReached() {
+		t.Error("expected the heap limit to be reached")
+	}
+	if len(reached) != 1 || reachedIso != iso {
+		t.Fatalf("expected one report for the isolate, got %v", reached)
+	}
+	if reached[0].Current == 0 || reached[0].Initial == 0 {
+		t.Errorf("unexpected heap limit: %+v", reached[0])
+	}
+}
+
+func TestIsolatePoolReplacesHeapLimitReached(t *testing.T) {
+	t.Parallel()
+
+	pool := v8.NewIsolatePool(v8.IsolatePoolConfig{
+		Size:           1,
+		IsolateOptions: []v8.IsolateOption{v8.HeapSize(0, 16<<20)},
+	})
+	defer pool.Close()
+
+	ctx := pool.Get()
+	iso := ctx.Isolate()
+	if _, err := ctx.RunScript("const a = []; for (;;) { a.push({v: a.length}) }", "grow.js"); err == nil {
+		t.Fatal("expected the execution to be terminated")
+	}
+	pool.Put(ctx)
+
+	ctx = pool.Get()
+	defer pool.Put(ctx)
+	if ctx.Isolate() == iso {
+		t.Error("expected the isolate to be replaced")
+	}
+	val, err := ctx.RunScript("'alive'", "after.js")
+	fatalIf(t, err)
+	if val.String() != "alive" {
+		t.Errorf("unexpected result %v", val)
+	}
+}
@@ -0,0 +1,57 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"io"
+	"sync"
+	"unsafe"
+)
+
+// heapSnapshotWriter is the destination of a WriteHeapSnapshot call, and the
+// first error writing to it.
+type heapSnapshotWriter struct {
+	w   io.Writer
+	err error
+}
+
+// heapSnapshotRegistry maps refs to the *heapSnapshotWriter of
+// WriteHeapSnapshot calls in progress.
+var heapSnapshotMutex sync.Mutex
+var heapSnapshotRegistry sync.Map
+var heapSnapshotSeq = 0
+
+// WriteHeapSnapshot takes a snapshot of the isolate's heap and writes it to w
+// as JSON, in the .heapsnapshot format that Chrome DevTools loads. The
+// snapshot is written as it is serialized, in chunks, without being buffered
+// as a whole. The isolate must not run JavaScript meanwhile; writing stops at
+// the first error of w, which is returned.
+func (i *Isolate) WriteHeapSnapshot(w io.Writer) error {
+	heapSnapshotMutex.Lock()
+	heapSnapshotSeq++
+	ref := heapSnapshotSeq
+	heapSnapshotMutex.Unlock()
+	hw := &heapSnapshotWriter{w: w}
+	heapSnapshotRegistry.Store(ref, hw)
+	defer heapSnapshotRegistry.Delete(ref)
+
+	C.IsolateWriteHeapSnapshot(i.ptr, C.int(ref))
+	return hw.err
+}
+
+//export goHeapSnapshotWrite
+func goHeapSnapshotWrite(ref C.int, data *C.char, size C.int) C.int {
+	v, _ := heapSnapshotRegistry.Load(int(ref))
+	hw := v.(*heapSnapshotWriter)
+	// The chunk is only valid for the call, which io.Writer does not retain.
+	chunk := (*[1 << 30]byte)(unsafe.Pointer(data))[:size:size]
+	if _, err := hw.w.Write(chunk); err != nil {
+		hw.err = err
+		return 0
+	}
+	return 1
+}
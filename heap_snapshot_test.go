@@ -0,0 +1,72 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"bytes"
+	"encoding/json"
+	"errors"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+// chunkWriter counts its writes.
+type chunkWriter struct {
+	bytes.Buffer
+	writes int
+}
+
+func (w *chunkWriter) Write(p []byte) (int, error) {
+	w.writes++
+	return w.Buffer.Write(p)
+}
+
+type failingWriter struct {
+	writes int
+}
+
+func (w *failingWriter) Write(p []byte) (int, error) {
+	w.writes++
+	return 0, errors.New("disk full")
+}
+
+func TestWriteHeapSnapshot(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+	_, err := ctx.RunScript("class LeakyTenantObject {}; var leaks = []; for (let i = 0; i < 100; i++) leaks.push(new LeakyTenantObject())", "leak.js")
+	fatalIf(t, err)
+
+	var w chunkWriter
+	fatalIf(t, ctx.Isolate().WriteHeapSnapshot(&w))
+	if w.writes < 2 {
+		t.Errorf("expected the snapshot to be written in chunks, got %d writes", w.writes)
+	}
+	var snapshot struct {
+		Snapshot struct {
+			NodeCount int `json:"node_count"`
+		} `json:"snapshot"`
+		Strings []string `json:"strings"`
+	}
+	fatalIf(t, json.Unmarshal(w.Bytes(), &snapshot))
+	if snapshot.Snapshot.NodeCount == 0 {
+		t.Error("expected the snapshot to have nodes")
+	}
+	if !strings.Contains(strings.Join(snapshot.Strings, "\n"), "LeakyTenantObject") {
+		t.Error("expected the snapshot to contain LeakyTenantObject")
+	}
+
+	var fw failingWriter
+	if err := ctx.Isolate().WriteHeapSnapshot(&fw); err == nil || err.Error() != "disk full" {
+		t.Errorf("expected the error of the writer, got %v", err)
+	}
+	if fw.writes != 1 {
+		t.Errorf("expected writing to stop at the first error, got %d writes", fw.writes)
+	}
+}
@@ -0,0 +1,104 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"syscall"
+	"unsafe"
+)
+
+// icuDataFileName is the name of the ICU data file that a V8 library built
+// with deps/build.py --icu-data-file is shipped with.
+const icuDataFileName = "icudtl.dat"
+
+var (
+	icuInitialized bool
+	errICUData     = errors.New("v8go: the ICU data is already initialized")
+)
+
+// InitializeICU maps the ICU data file at path, an icudtl.dat, read-only
+// into memory for the Intl support of V8, like V8::InitializeICU. Every
+// process that maps the same file shares its pages, instead of each binary
+// embedding its own copy of the data. It must be called before the first
+// isolate is created, and returns ErrPlatformInitialized after.
+//
+// Only a V8 library built with deps/build.py --icu-data-file loads its ICU
+// data from a file; the prebuilt libraries embed theirs, and InitializeICU
+// only checks that path can be read. Without a call to InitializeICU, the
+// ICU data of a library that needs a file is mapped from the icudtl.dat next
+// to the executable, if there is one.
+func InitializeICU(path string) error {
+	f, err := os.Open(path)
+	if err != nil {
+		return err
+	}
+	defer f.Close()
+	fi, err := f.Stat()
+	if err != nil {
+		return err
+	}
+	if fi.Size() == 0 {
+		return fmt.Errorf("v8go: empty ICU data file %s", path)
+	}
+
+	platformMutex.Lock()
+	defer platformMutex.Unlock()
+	if platformInitialized {
+		return ErrPlatformInitialized
+	}
+	if icuInitialized {
+		return errICUData
+	}
+	if C.ICUDataFromFile() == 0 {
+		return nil
+	}
+	if err := mapICUData(f, fi.Size()); err != nil {
+		return fmt.Errorf("v8go: ICU data file %s: %w", path, err)
+	}
+	return nil
+}
+
+// mapICUData hands the ICU data file f to ICU. The mapping is never unmapped,
+// as ICU keeps using it for the life of the process. It is called with the
+// platformMutex held.
+func mapICUData(f *os.File, size int64) error {
+	data, err := syscall.Mmap(int(f.Fd()), 0, int(size), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return err
+	}
+	if code := C.SetICUData(unsafe.Pointer(&data[0])); code != 0 {
+		syscall.Munmap(data)
+		return fmt.Errorf("invalid ICU data (UErrorCode %d)", int(code))
+	}
+	icuInitialized = true
+	return nil
+}
+
+// initDefaultICU maps the icudtl.dat next to the executable, if the library
+// needs an ICU data file and InitializeICU has not been given one. It is
+// called with the platformMutex held, before the platform is created.
+func initDefaultICU() {
+	if icuInitialized || C.ICUDataFromFile() == 0 {
+		return
+	}
+	exe, err := os.Executable()
+	if err != nil {
+		return
+	}
+	f, err := os.Open(filepath.Join(filepath.Dir(exe), icuDataFileName))
+	if err != nil {
+		return
+	}
+	defer f.Close()
+	if fi, err := f.Stat(); err == nil && fi.Size() > 0 {
+		mapICUData(f, fi.Size())
+	}
+}
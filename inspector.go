@@ -0,0 +1,105 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"sync"
+	"unsafe"
+)
+
+// InspectorSession is a session of the Chrome DevTools protocol with the V8
+// inspector of an isolate, through which a client such as Chrome DevTools
+// profiles it while it runs, with the Profiler and HeapProfiler domains, and
+// evaluates JavaScript and inspects objects in it, with the Runtime domain.
+// The session sends the messages of the client to the inspector with
+// Dispatch, and passes the responses and notifications of the inspector to
+// its handler; relaying them over a WebSocket, whose URL DevTools is opened
+// with, is left to the embedder.
+//
+// The inspector cannot pause JavaScript: the breakpoints and pause commands
+// of the Debugger domain have no effect.
+type InspectorSession struct {
+	ptr     C.InspectorSessionPtr
+	iso     *Isolate
+	ref     int
+	handler func(message []byte)
+}
+
+// inspectorRegistry maps refs to the open *InspectorSession.
+var inspectorMutex sync.Mutex
+var inspectorRegistry = make(map[int]*InspectorSession)
+var inspectorSeq = 0
+
+// NewInspectorSession connects a session of the Chrome DevTools protocol to
+// the inspector of the context's isolate, which inspects the context from
+// then on. Each response and notification of the session is passed to
+// handler as a JSON message, which the handler may retain. The handler is
+// called with the isolate's lock held, by Dispatch or whatever runs
+// JavaScript in the isolate, so it must not block or use the isolate; it
+// would typically send the message on to the client. The session must be
+// closed before the isolate is disposed of, or it is closed then.
+func (c *Context) NewInspectorSession(handler func(message []byte)) *InspectorSession {
+	inspectorMutex.Lock()
+	inspectorSeq++
+	s := &InspectorSession{iso: c.iso, ref: inspectorSeq, handler: handler}
+	inspectorRegistry[s.ref] = s
+	inspectorMutex.Unlock()
+	s.ptr = C.ContextNewInspectorSession(c.ptr, C.int(s.ref))
+	return s
+}
+
+// Dispatch sends a JSON message of the protocol to the inspector, such as
+// {"id":1,"method":"Profiler.start"}. The response to a command is passed
+// to the handler before Dispatch returns, as are the notifications of the
+// command; the message is ignored if the session is closed. Dispatch may be
+// called from any goroutine, but waits for the isolate's lock.
+func (s *InspectorSession) Dispatch(message []byte) {
+	if s.ptr == nil || len(message) == 0 {
+		return
+	}
+	cmsg := C.CBytes(message)
+	defer C.free(cmsg)
+	C.InspectorSessionDispatch(s.ptr, (*C.char)(cmsg), C.int(len(message)))
+}
+
+// Close disconnects the session from the inspector, which stops what the
+// session has started, such as a profile.
+func (s *InspectorSession) Close() {
+	if s.ptr == nil {
+		return
+	}
+	C.InspectorSessionFree(s.ptr)
+	s.ptr = nil
+	inspectorMutex.Lock()
+	delete(inspectorRegistry, s.ref)
+	inspectorMutex.Unlock()
+}
+
+// closeInspectorSessions forgets the sessions of the isolate, which
+// IsolateDispose closes.
+func (i *Isolate) closeInspectorSessions() {
+	inspectorMutex.Lock()
+	for ref, s := range inspectorRegistry {
+		if s.iso == i {
+			delete(inspectorRegistry, ref)
+			s.ptr = nil
+		}
+	}
+	inspectorMutex.Unlock()
+}
+
+//export goInspectorMessage
+func goInspectorMessage(ref C.int, data *C.char, size C.int) {
+	inspectorMutex.Lock()
+	s := inspectorRegistry[int(ref)]
+	inspectorMutex.Unlock()
+	if s == nil {
+		return
+	}
+	s.handler(C.GoBytes(unsafe.Pointer(data), size))
+}
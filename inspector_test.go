@@ -0,0 +1,117 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"encoding/json"
+	"fmt"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+type inspectorMessage struct {
+	ID     int             `json:"id"`
+	Method string          `json:"method"`
+	Params json.RawMessage `json:"params"`
+	Result json.RawMessage `json:"result"`
+	Error  json.RawMessage `json:"error"`
+}
+
+func TestInspectorSession(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	var messages []inspectorMessage
+	session := ctx.NewInspectorSession(func(message []byte) {
+		var m inspectorMessage
+		if err := json.Unmarshal(message, &m); err != nil {
+			t.Errorf("invalid message %q: %v", message, err)
+		}
+		messages = append(messages, m)
+	})
+	defer session.Close()
+	id := 0
+	call := func(method, params string) json.RawMessage {
+		t.Helper()
+		id++
+		messages = nil
+		session.Dispatch([]byte(fmt.Sprintf(`{"id":%d,"method":%q,"params":%s}`, id, method, params)))
+		for _, m := range messages {
+			if m.ID == id && m.Method == "" {
+				if m.Error != nil {
+					t.Fatalf("%s: %s", method, m.Error)
+				}
+				return m.Result
+			}
+		}
+		t.Fatalf("%s: no response in %+v", method, messages)
+		return nil
+	}
+
+	result := call("Runtime.evaluate", `{"expression":"'ü' + (1 + 2)"}`)
+	var evaluated struct {
+		Result struct{ Value string }
+	}
+	if err := json.Unmarshal(result, &evaluated); err != nil || evaluated.Result.Value != "ü3" {
+		t.Errorf("unexpected Runtime.evaluate result %s", result)
+	}
+
+	call("Runtime.enable", `{}`)
+	if _, err := ctx.RunScript("console.log('hello')", "log.js"); err != nil {
+		t.Fatal(err)
+	}
+	found := false
+	for _, m := range messages {
+		found = found || m.Method == "Runtime.consoleAPICalled" && strings.Contains(string(m.Params), "hello")
+	}
+	if !found {
+		t.Errorf("expected Runtime.consoleAPICalled, got %+v", messages)
+	}
+
+	call("Profiler.enable", `{}`)
+	call("Profiler.start", `{}`)
+	if _, err := ctx.RunScript("function busy() { let x = 0; for (let i = 0; i < 1e6; i++) x += i; return x } busy()", "busy.js"); err != nil {
+		t.Fatal(err)
+	}
+	result = call("Profiler.stop", `{}`)
+	if !strings.Contains(string(result), `"nodes"`) {
+		t.Errorf("unexpected Profiler.stop result %s", result)
+	}
+
+	call("HeapProfiler.enable", `{}`)
+	call("HeapProfiler.collectGarbage", `{}`)
+	call("HeapProfiler.takeHeapSnapshot", `{"reportProgress":false}`)
+	var chunks int
+	for _, m := range messages {
+		if m.Method == "HeapProfiler.addHeapSnapshotChunk" {
+			chunks++
+		}
+	}
+	if chunks == 0 {
+		t.Errorf("expected heap snapshot chunks")
+	}
+}
+
+func TestInspectorSessionDispose(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	ctx := v8.NewContext(iso)
+	session := ctx.NewInspectorSession(func([]byte) {})
+	other := v8.NewContext(iso)
+	other.NewInspectorSession(func([]byte) {})
+	other.Close()
+	ctx.Close()
+	iso.Dispose()
+	// The sessions were closed with the isolate.
+	session.Close()
+	session.Dispatch([]byte(`{"id":1,"method":"Runtime.enable"}`))
+}
@@ -0,0 +1,59 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+
+// NewIntlFormattersTemplate creates the template of an object to bind in a
+// global template, whose methods Collator, DateTimeFormat, DisplayNames,
+// ListFormat, NumberFormat, PluralRules and RelativeTimeFormat take the
+// locales and options of the Intl constructor of the same name and return a
+// formatter that the isolate keeps, for every context, by its kind, locales
+// and options, rather than a new one, which loads the locale data of ICU:
+//
+//	global.Set("intl", v8.NewIntlFormattersTemplate(iso))
+//	...
+//	intl.NumberFormat("de", {style: "currency", currency: "EUR"}).format(n)
+//
+// The locales and options are taken by their JSON. The isolate keeps the 256
+// most recently used formatters in a context of its own, so that no script
+// can change them for another, and each call returns a new object of the
+// calling context whose compare, format, formatRange, formatRangeToParts,
+// formatToParts, of, resolvedOptions and select methods call the formatter's,
+// returning copies of the objects they return. It is not an instance of the
+// Intl constructor.
+//
+// The template may be part of the global template of the contexts of a
+// startup snapshot; the formatters themselves are made again by the isolates
+// created from it.
+func NewIntlFormattersTemplate(iso *Isolate) *ObjectTemplate {
+	if iso == nil {
+		panic("nil Isolate argument not supported")
+	}
+	return newObjectTemplate(iso, C.NewIntlFormattersTemplate(iso.ptr))
+}
+
+// IntlFormatterStats counts the lookups of the formatters of the templates of
+// NewIntlFormattersTemplate in the cache of an isolate.
+type IntlFormatterStats struct {
+	// Hits is the number of formatters found in the cache.
+	Hits uint64
+	// Misses is the number of formatters that were made and cached.
+	Misses uint64
+	// Length is the number of formatters in the cache.
+	Length int
+}
+
+// IntlFormatterStats returns the counts of the formatter cache of the
+// isolate.
+func (i *Isolate) IntlFormatterStats() IntlFormatterStats {
+	s := C.IsolateIntlFormatterStats(i.ptr)
+	return IntlFormatterStats{
+		Hits:   uint64(s.hits),
+		Misses: uint64(s.misses),
+		Length: int(s.length),
+	}
+}
@@ -0,0 +1,116 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestIntlFormatters(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	global := v8.NewObjectTemplate(iso)
+	fatalIf(t, global.Set("intl", v8.NewIntlFormattersTemplate(iso)))
+
+	for i := 0; i < 2; i++ {
+		ctx := v8.NewContext(iso, global)
+		val, err := ctx.RunScript(`[
+			intl.DateTimeFormat('es', {month: 'long'}).format(new Date(9e8)),
+			intl.NumberFormat('de', {style: 'currency', currency: 'EUR'}).format(1234.5),
+			intl.PluralRules('en').select(1),
+			intl.Collator('en').compare('a', 'b'),
+			intl.NumberFormat('de', {style: 'currency', currency: 'EUR'}).formatToParts(1)[0] instanceof Object,
+			intl.NumberFormat('de', {style: 'currency', currency: 'EUR'}).resolvedOptions().locale,
+		].join('|')`, "intl.js")
+		fatalIf(t, err)
+		if want := "enero|1.234,50\u00a0€|one|-1|true|de"; val.String() != want {
+			t.Errorf("expected %q, got %q", want, val.String())
+		}
+		// Changing the prototypes of a context leaves the formatters alone.
+		_, err = ctx.RunScript(`Intl.NumberFormat.prototype.format = () => 'changed'`, "change.js")
+		fatalIf(t, err)
+		ctx.Close()
+	}
+	// Each formatter is made once, and found again by the other calls and
+	// by the calls of its methods.
+	want := v8.IntlFormatterStats{Hits: 20, Misses: 4, Length: 4}
+	if got := iso.IntlFormatterStats(); got != want {
+		t.Errorf("expected %+v, got %+v", want, got)
+	}
+
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+	for _, tt := range []struct{ script, err string }{
+		{`intl.NumberFormat('not a locale!')`, "RangeError"},
+		{`intl.NumberFormat('en').of('x')`, "TypeError: of is not a method"},
+		{`intl.NumberFormat('en').format.call({}, 1)`, "TypeError"},
+		{`intl.NumberFormat('en', {notation: 'bogus'})`, "RangeError"},
+	} {
+		_, err := ctx.RunScript(tt.script, "error.js")
+		if err == nil || !strings.Contains(err.Error(), tt.err) {
+			t.Errorf("%s: expected %s, got %v", tt.script, tt.err, err)
+		}
+	}
+	val, err := ctx.RunScript(`(() => {
+		try { intl.NumberFormat('not a locale!') } catch (e) { return e instanceof RangeError }
+	})()`, "error.js")
+	fatalIf(t, err)
+	if !val.Boolean() {
+		t.Error("expected an error of the calling context")
+	}
+}
+
+func TestIntlFormattersSnapshot(t *testing.T) {
+	t.Parallel()
+
+	creator := v8.NewSnapshotCreator()
+	global := v8.NewObjectTemplate(creator.Isolate())
+	fatalIf(t, global.Set("intl", v8.NewIntlFormattersTemplate(creator.Isolate())))
+	setup := v8.NewContext(creator.Isolate(), global)
+	_, err := setup.RunScript(`var euros = intl.NumberFormat('de', {style: 'currency', currency: 'EUR'})`, "setup.js")
+	fatalIf(t, err)
+	snapshot, err := creator.Create(setup, v8.FunctionCodeKeep)
+	fatalIf(t, err)
+
+	iso := v8.NewIsolate(v8.FromSnapshot(snapshot))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	val, err := ctx.RunScript(`euros.format(2) + '|' + intl.PluralRules('en').select(2)`, "snapshot.js")
+	fatalIf(t, err)
+	if want := "2,00\u00a0€|other"; val.String() != want {
+		t.Errorf("expected %q, got %q", want, val.String())
+	}
+}
+
+func BenchmarkIntlFormatters(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	global := v8.NewObjectTemplate(iso)
+	global.Set("intl", v8.NewIntlFormattersTemplate(iso))
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+	for _, bench := range []struct{ name, script string }{
+		{"New", `(n) => new Intl.NumberFormat('de', {style: 'currency', currency: 'EUR'}).format(n)`},
+		{"Cached", `(n) => intl.NumberFormat('de', {style: 'currency', currency: 'EUR'}).format(n)`},
+	} {
+		b.Run(bench.name, func(b *testing.B) {
+			fn, _ := ctx.RunScript(bench.script, "bench.js")
+			f, _ := fn.AsFunction()
+			n, _ := v8.NewValue(iso, int32(42))
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				if _, err := f.Call(v8.Undefined(iso), n); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
@@ -5,6 +5,9 @@
 package v8go_test
 
 import (
+	"io/ioutil"
+	"os"
+	"path/filepath"
 	"testing"
 
 	v8 "rogchap.com/v8go"
@@ -60,3 +63,24 @@ try {
 		t.Fatalf("expected value to be %v, but was %v", "123.456,789", v)
 	}
 }
+
+func TestInitializeICU(t *testing.T) {
+	t.Parallel()
+
+	dir := t.TempDir()
+	if err := v8.InitializeICU(filepath.Join(dir, "icudtl.dat")); !os.IsNotExist(err) {
+		t.Errorf("expected a missing file error, got %v", err)
+	}
+	path := filepath.Join(dir, "empty.dat")
+	fatalIf(t, ioutil.WriteFile(path, nil, 0o644))
+	if err := v8.InitializeICU(path); err == nil {
+		t.Error("expected an error for an empty file")
+	}
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	fatalIf(t, ioutil.WriteFile(path, []byte("icu"), 0o644))
+	if err := v8.InitializeICU(path); err != v8.ErrPlatformInitialized {
+		t.Errorf("expected ErrPlatformInitialized, got %v", err)
+	}
+}
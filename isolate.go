@@ -9,24 +9,79 @@ package v8go
 import "C"
 
 import (
+	"errors"
+	"runtime"
 	"sync"
+	"time"
 	"unsafe"
 )
 
-var v8once sync.Once
-
 // Isolate is a JavaScript VM instance with its own heap and
 // garbage collector. Most applications will create one isolate
 // with many V8 contexts for execution.
 type Isolate struct {
 	ptr C.IsolatePtr
 
-	cbMutex sync.RWMutex
-	cbSeq   int
-	cbs     map[int]FunctionCallbackWithError
+	// cbs maps callback refs to FunctionCallbackWithError or, for accessors
+	// and interceptors, propertyCallback; it is read on every callback, so
+	// without taking cbMutex, which guards cbSeq and fastRefs.
+	cbMutex  sync.Mutex
+	cbSeq    int
+	cbs      sync.Map
+	fastRefs map[int]struct{}
+
+	// cached holds the immortal undefined, null, boolean and small integer
+	// values of the isolate, indexed by C.CachedValueIndex.
+	cached []Value
+
+	// snapshot is the startup snapshot that the isolate was created from,
+	// which it uses until it is disposed.
+	snapshot *Snapshot
+	// creator is the SnapshotCreator that owns the isolate, if any.
+	creator *SnapshotCreator
+
+	// importHandler handles the import() calls of the isolate, and imports
+	// are the ones whose completion waits for a microtask checkpoint.
+	importMutex   sync.Mutex
+	importHandler DynamicImportHandler
+	imports       []*DynamicImport
+
+	// freedTemplates are the templates whose wrappers have been finalized;
+	// their handles are reset by the next releaseCallbacks, as that needs the
+	// isolate's lock. templatesDisposed is set once the isolate is disposed.
+	templateMutex     sync.Mutex
+	freedTemplates    []C.TemplatePtr
+	templatesDisposed bool
 
-	null      *Value
-	undefined *Value
+	// finalizers are the finalizers of the objects that Object.SetWeak waits
+	// to be collected, by ref.
+	finalizerMutex sync.Mutex
+	finalizerSeq   int
+	finalizers     map[int]func()
+
+	// shapes maps the struct types that Context.Import has created objects
+	// of to the ids of their shapes in the isolate, see structShape.
+	shapes sync.Map
+
+	// keepExceptions is whether JSErrors keep their exception, see
+	// KeepExceptions.
+	keepExceptions bool
+	// interned is the intern table of the strings of the isolate, if it is
+	// created with InternStrings.
+	interned *internTable
+	// stringCacheMaxLength is the length of the longest strings that the
+	// isolate caches, see CacheNewStrings.
+	stringCacheMaxLength int
+	// releaseUnreachable is whether values are released once unreachable,
+	// see ReleaseUnreachableValues.
+	releaseUnreachable bool
+	// fetch holds the native functions of fetch, created for the first
+	// context with Fetch.
+	fetchMutex sync.Mutex
+	fetch      *fetchTemplates
+	// arrayBufferQuota is the ArrayBufferQuota of the isolate, which fetch
+	// reads response bodies within.
+	arrayBufferQuota uint64
 }
 
 // HeapStatistics represents V8 isolate heap statistics
@@ -44,6 +99,182 @@ type HeapStatistics struct {
 	NumberOfDetachedContexts uint64
 }
 
+// HeapSpaceStatistics represents the statistics of one of the spaces of a V8
+// isolate heap, such as new_space, old_space, code_space or
+// large_object_space.
+type HeapSpaceStatistics struct {
+	SpaceName          string
+	SpaceSize          uint64
+	SpaceUsedSize      uint64
+	SpaceAvailableSize uint64
+	PhysicalSpaceSize  uint64
+}
+
+// HeapCodeStatistics represents the memory taken up by code in a V8 isolate
+// heap.
+type HeapCodeStatistics struct {
+	CodeAndMetadataSize      uint64
+	BytecodeAndMetadataSize  uint64
+	ExternalScriptSourceSize uint64
+}
+
+// MemoryMeasurement is the heap memory of an isolate attributed to each of its
+// contexts, see Isolate.MeasureMemory.
+type MemoryMeasurement struct {
+	// Contexts maps the open contexts of the isolate to their size in bytes.
+	Contexts map[*Context]uint64
+	// Unattributed is the size in bytes of the memory that is shared by the
+	// contexts, or belongs to contexts that have been closed.
+	Unattributed uint64
+}
+
+// IsolateOption configures how an Isolate is created, see NewIsolate.
+type IsolateOption interface {
+	apply(*isolateOptions)
+}
+
+type isolateOptions struct {
+	pooledArrayBuffers bool
+	arrayBufferQuota   uint64
+	heapSizeInitial    uint64
+	heapSizeMax        uint64
+	constraints        ResourceConstraints
+	snapshot           *Snapshot
+	heapLimitHandler   func(*Isolate, HeapLimit)
+	gcEventCapacity    int
+	shimStats          bool
+	callbackStats      bool
+	lazyErrors         bool
+	keepExceptions     bool
+	// uncaughtStackTrace is set by UncaughtStackTrace, which sets the frames
+	// and options of the stack traces of uncaught exceptions.
+	uncaughtStackTrace        bool
+	uncaughtStackTraceFrames  int
+	uncaughtStackTraceOptions StackTraceOptions
+	internStrings             int
+	releaseUnreachable        bool
+	consoleCapacity           int
+	consoleLevel              ConsoleLevel
+	disallowAtomicsWait       bool
+	stackSize                 uint64
+	stringCacheCapacity       int
+	stringCacheMaxLength      int
+}
+
+type isolateOptionFunc func(*isolateOptions)
+
+func (f isolateOptionFunc) apply(opts *isolateOptions) {
+	f(opts)
+}
+
+// PooledArrayBuffers makes the isolate recycle the memory of array buffers of
+// up to 1MB, in power-of-two size classes, instead of returning it to the
+// system allocator when they are garbage collected. It suits scripts that
+// create many short lived buffers.
+var PooledArrayBuffers IsolateOption = isolateOptionFunc(func(opts *isolateOptions) {
+	opts.pooledArrayBuffers = true
+})
+
+// ArrayBufferQuota caps the memory that the array buffers of the isolate may
+// take up at once to the given number of bytes. Allocations beyond it fail,
+// which is a RangeError in JS. A quota of 0 means no limit.
+func ArrayBufferQuota(bytes uint64) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.arrayBufferQuota = bytes
+	})
+}
+
+// StackTraceOptions are the details of the frames of a stack trace that V8
+// captures, see UncaughtStackTrace.
+type StackTraceOptions int
+
+var (
+	StackTraceLineNumber            = StackTraceOptions(C.StackTraceLineNumber)
+	StackTraceColumnOffset          = StackTraceOptions(C.StackTraceColumnOffset)
+	StackTraceScriptName            = StackTraceOptions(C.StackTraceScriptName)
+	StackTraceFunctionName          = StackTraceOptions(C.StackTraceFunctionName)
+	StackTraceIsEval                = StackTraceOptions(C.StackTraceIsEval)
+	StackTraceIsConstructor         = StackTraceOptions(C.StackTraceIsConstructor)
+	StackTraceScriptNameOrSourceURL = StackTraceOptions(C.StackTraceScriptNameOrSourceURL)
+	StackTraceScriptID              = StackTraceOptions(C.StackTraceScriptId)
+	// StackTraceOverview is the line, column, script name and function name
+	// of each frame, which an isolate captures by default.
+	StackTraceOverview = StackTraceOptions(C.StackTraceOverview)
+	// StackTraceDetailed adds whether each frame is an eval or a constructor
+	// call, and the source URL of the script.
+	StackTraceDetailed = StackTraceOptions(C.StackTraceDetailed)
+)
+
+// UncaughtStackTrace sets the stack trace that the isolate captures, with
+// the given number of frames and details of each, whenever an exception is
+// thrown that nothing in JavaScript catches, for the message of the
+// exception; by default it captures 10 frames with StackTraceOverview. A
+// frames count of 0 or fewer captures none, which saves the cost of a stack
+// walk on every such throw. JSError.StackTrace and the location of a JSError
+// are not affected: the former is the stack property of an Error, whose depth
+// Error.stackTraceLimit sets, and the latter is where the exception was
+// thrown.
+func UncaughtStackTrace(frames int, options StackTraceOptions) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.uncaughtStackTrace = true
+		opts.uncaughtStackTraceFrames = frames
+		opts.uncaughtStackTraceOptions = options
+	})
+}
+
+// InternStrings makes the isolate intern the Go strings of the strings of up
+// to maxLength bytes, at most 1024, that Value.String and Export convert: a
+// string that is converted again is returned as the Go string it was
+// converted to before, rather than as a new copy, which saves the garbage of
+// converters that read the same field names and enumeration values over and
+// over. The strings are found by the hash that V8 keeps of each string, in a
+// table of 4096 of them, in which a string replaces the one of the same slot.
+func InternStrings(maxLength int) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.internStrings = maxLength
+	})
+}
+
+// ReleaseUnreachableValues makes the isolate release the values that its
+// contexts return from scripts, calls and property reads once the Go garbage
+// collector finds their Value unreachable, as Value.Release would, rather
+// than when their context is closed. A finalizer cannot lock the isolate, so
+// it queues the value on its context, and the next call into the context
+// releases it. The values must then be kept reachable, by the Go values that
+// wrap them, for as long as V8 may use them: a value that Go code has only
+// kept the C handle of, such as one passed to a pending call from another
+// goroutine, may be released under the call.
+var ReleaseUnreachableValues IsolateOption = isolateOptionFunc(func(opts *isolateOptions) {
+	opts.releaseUnreachable = true
+})
+
+// HeapSize sizes the heap of the isolate to start at initial bytes and grow to
+// at most maximum bytes, leaving V8 to divide them between the generations of
+// the heap. A ResourceConstraints option can then override the size of each
+// generation.
+func HeapSize(initial, maximum uint64) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.heapSizeInitial = initial
+		opts.heapSizeMax = maximum
+	})
+}
+
+// ResourceConstraints sets the sizes of the parts of the isolate's heap, in
+// bytes. It is an IsolateOption; fields that are 0 keep V8's default.
+type ResourceConstraints struct {
+	InitialOldGenerationSize   uint64
+	MaxOldGenerationSize       uint64
+	InitialYoungGenerationSize uint64
+	MaxYoungGenerationSize     uint64
+	// CodeRangeSize is the size of the virtual memory reserved for compiled
+	// code, on platforms where V8 reserves it up front.
+	CodeRangeSize uint64
+}
+
+func (c ResourceConstraints) apply(opts *isolateOptions) {
+	opts.constraints = c
+}
+
 // NewIsolate creates a new V8 isolate. Only one thread may access
 // a given isolate at a time, but different threads may access
 // different isolates simultaneously.
@@ -51,21 +282,118 @@ type HeapStatistics struct {
 // by calling iso.Dispose().
 // An *Isolate can be used as a v8go.ContextOption to create a new
 // Context, rather than creating a new default Isolate.
-func NewIsolate() *Isolate {
-	v8once.Do(func() {
-		C.Init()
-	})
-	iso := &Isolate{
-		ptr: C.NewIsolate(),
-		cbs: make(map[int]FunctionCallbackWithError),
+func NewIsolate(opt ...IsolateOption) *Isolate {
+	initV8()
+	opts := isolateOptions{}
+	for _, o := range opt {
+		if o != nil {
+			o.apply(&opts)
+		}
+	}
+	var cOptions C.IsolateOptions
+	if opts.pooledArrayBuffers {
+		cOptions.pooledArrayBuffers = 1
+	}
+	cOptions.arrayBufferQuota = C.size_t(opts.arrayBufferQuota)
+	cOptions.heapSizeInitial = C.size_t(opts.heapSizeInitial)
+	cOptions.heapSizeMax = C.size_t(opts.heapSizeMax)
+	cOptions.initialOldGenerationSize = C.size_t(opts.constraints.InitialOldGenerationSize)
+	cOptions.maxOldGenerationSize = C.size_t(opts.constraints.MaxOldGenerationSize)
+	cOptions.initialYoungGenerationSize = C.size_t(opts.constraints.InitialYoungGenerationSize)
+	cOptions.maxYoungGenerationSize = C.size_t(opts.constraints.MaxYoungGenerationSize)
+	cOptions.codeRangeSize = C.size_t(opts.constraints.CodeRangeSize)
+	if opts.snapshot != nil {
+		cOptions.snapshot = opts.snapshot.ptr
+	}
+	cOptions.gcEventCapacity = C.int(opts.gcEventCapacity)
+	if opts.shimStats {
+		cOptions.shimStats = 1
+	}
+	if opts.callbackStats {
+		cOptions.callbackStats = 1
+	}
+	if opts.lazyErrors {
+		cOptions.lazyErrors = 1
+	}
+	if opts.keepExceptions {
+		cOptions.keepExceptions = 1
+	}
+	if opts.uncaughtStackTrace {
+		cOptions.uncaughtStackTraceFrames = -1
+		if opts.uncaughtStackTraceFrames > 0 {
+			cOptions.uncaughtStackTraceFrames = C.int(opts.uncaughtStackTraceFrames)
+		}
+		cOptions.uncaughtStackTraceOptions = C.int(opts.uncaughtStackTraceOptions)
+	}
+
+	cOptions.consoleCapacity = C.int(opts.consoleCapacity)
+	cOptions.consoleLevel = C.int(opts.consoleLevel)
+	if opts.disallowAtomicsWait {
+		cOptions.disallowAtomicsWait = 1
+	}
+	cOptions.stackSize = C.size_t(opts.stackSize)
+	if opts.stringCacheCapacity > 0 && opts.stringCacheMaxLength > 0 {
+		cOptions.stringCacheCapacity = C.int(opts.stringCacheCapacity)
+		cOptions.stringCacheMaxLength = C.int(opts.stringCacheMaxLength)
+	}
+
+	iso := newIsolate(C.NewIsolate(cOptions))
+	iso.keepExceptions = opts.keepExceptions
+	iso.stringCacheMaxLength = int(cOptions.stringCacheMaxLength)
+	if opts.internStrings > 0 {
+		iso.interned = newInternTable(opts.internStrings)
+	}
+	iso.releaseUnreachable = opts.releaseUnreachable
+	iso.arrayBufferQuota = opts.arrayBufferQuota
+	if opts.heapLimitHandler != nil {
+		heapLimitRegistry.Store(iso.ptr, &heapLimitHandler{iso: iso, handle: opts.heapLimitHandler})
+	}
+	if opts.snapshot != nil {
+		iso.snapshot = opts.snapshot
+		iso.restoreSnapshotCallbacks(opts.snapshot)
 	}
-	iso.null = newValueNull(iso)
-	iso.undefined = newValueUndefined(iso)
 	return iso
 }
 
+// newIsolate wraps the isolate that ptr points to, which has been set up by
+// the C side.
+func newIsolate(ptr C.IsolatePtr) *Isolate {
+	iso := &Isolate{ptr: ptr}
+	ptrs := (*[1 << 20]C.ValuePtr)(unsafe.Pointer(C.IsolateCachedValues(iso.ptr)))[:C.CACHED_VALUE_COUNT:C.CACHED_VALUE_COUNT]
+	types := (*[1 << 20]C.uint64_t)(unsafe.Pointer(C.IsolateCachedValueTypes(iso.ptr)))[:len(ptrs):len(ptrs)]
+	iso.cached = make([]Value, len(ptrs))
+	for i, ptr := range ptrs {
+		// The types are filled in up front, as the cached values are shared.
+		iso.cached[i].ptr = ptr
+		iso.cached[i].types = uint64(types[i]) | valueTypesKnown
+	}
+	return iso
+}
+
+// cachedValue returns one of the isolate's immortal values; these can be
+// shared without a cgo call and are not freed by (*Value).Release.
+func (i *Isolate) cachedValue(idx int) *Value {
+	return &i.cached[idx]
+}
+
+// cachedInt returns the cached value for n, if n is within the range of
+// small integers cached by the isolate.
+func (i *Isolate) cachedInt(n int64) (*Value, bool) {
+	if n < C.CACHED_SMALL_INT_MIN || n > C.CACHED_SMALL_INT_MAX {
+		return nil, false
+	}
+	return i.cachedValue(int(C.CACHED_VALUE_SMALL_INT + n - C.CACHED_SMALL_INT_MIN)), true
+}
+
+// ArrayBufferMemory returns the number of bytes currently taken up by the
+// array buffers of the isolate, which ArrayBufferQuota applies to.
+func (i *Isolate) ArrayBufferMemory() uint64 {
+	return uint64(C.IsolateArrayBufferMemory(i.ptr))
+}
+
 // TerminateExecution terminates forcefully the current thread
-// of JavaScript execution in the given isolate.
+// of JavaScript execution in the given isolate, including an Atomics.wait
+// that it is blocked in.
 func (i *Isolate) TerminateExecution() {
 	C.IsolateTerminateExecution(i.ptr)
 }
@@ -81,19 +409,20 @@ type CompileOptions struct {
 	CachedData *CompilerCachedData
 
 	Mode CompileMode
-}
 
-// CompileUnboundScript will create an UnboundScript (i.e. context-indepdent)
-// using the provided source JavaScript, origin (a.k.a. filename), and options.
-// If options contain a non-null CachedData, compilation of the script will use
-// that code cache.
-// error will be of type `JSError` if not nil.
-func (i *Isolate) CompileUnboundScript(source, origin string, opts CompileOptions) (*UnboundScript, error) {
-	cSource := C.CString(source)
-	cOrigin := C.CString(origin)
-	defer C.free(unsafe.Pointer(cSource))
-	defer C.free(unsafe.Pointer(cOrigin))
+	// ConsumeOffThread makes Isolate.CompileUnboundScript check CachedData
+	// against the source before V8 is handed it, see CompilerCachedData.Check,
+	// and deserialize it without holding the isolate's lock, so that other
+	// goroutines can use the isolate meanwhile. A cache that fails the check
+	// is Rejected and the script compiled without it.
+	ConsumeOffThread bool
 
+	// checked is set when CachedData has passed CompilerCachedData.Check.
+	checked     bool
+	consumeTask C.ConsumeTaskPtr
+}
+
+func (opts CompileOptions) cOptions() C.CompileOptions {
 	var cOptions C.CompileOptions
 	if opts.CachedData != nil {
 		if opts.Mode != 0 {
@@ -104,11 +433,25 @@ func (i *Isolate) CompileUnboundScript(source, origin string, opts CompileOption
 			data:   (*C.uchar)(unsafe.Pointer(&opts.CachedData.Bytes[0])),
 			length: C.int(len(opts.CachedData.Bytes)),
 		}
+		cOptions.consumeTask = opts.consumeTask
 	} else {
 		cOptions.compileOption = C.int(opts.Mode)
 	}
+	return cOptions
+}
 
-	rtn := C.IsolateCompileUnboundScript(i.ptr, cSource, cOrigin, cOptions)
+// CompileUnboundScript will create an UnboundScript (i.e. context-indepdent)
+// using the provided source JavaScript, origin (a.k.a. filename), and options.
+// If options contain a non-null CachedData, compilation of the script will use
+// that code cache.
+// error will be of type `JSError` if not nil.
+func (i *Isolate) CompileUnboundScript(source, origin string, opts CompileOptions) (*UnboundScript, error) {
+	if opts.CachedData != nil && opts.ConsumeOffThread {
+		return i.compileConsumingOffThread(source, origin, opts)
+	}
+	rtn := C.IsolateCompileUnboundScript(i.ptr, stringArg(source), stringArg(origin), opts.cOptions())
+	runtime.KeepAlive(source)
+	runtime.KeepAlive(origin)
 	if rtn.ptr == nil {
 		return nil, newJSError(rtn.error)
 	}
@@ -140,13 +483,171 @@ func (i *Isolate) GetHeapStatistics() HeapStatistics {
 	}
 }
 
+// GetHeapSpaceStatistics returns the statistics of each space of the heap of
+// the isolate.
+func (i *Isolate) GetHeapSpaceStatistics() []HeapSpaceStatistics {
+	n := int(C.IsolateNumberOfHeapSpaces(i.ptr))
+	spaces := make([]HeapSpaceStatistics, 0, n)
+	for idx := 0; idx < n; idx++ {
+		hss := C.IsolateGetHeapSpaceStatistics(i.ptr, C.int(idx))
+		spaces = append(spaces, HeapSpaceStatistics{
+			SpaceName:          C.GoString(hss.space_name),
+			SpaceSize:          uint64(hss.space_size),
+			SpaceUsedSize:      uint64(hss.space_used_size),
+			SpaceAvailableSize: uint64(hss.space_available_size),
+			PhysicalSpaceSize:  uint64(hss.physical_space_size),
+		})
+	}
+	return spaces
+}
+
+// GetHeapCodeStatistics returns the memory taken up by the code, bytecode and
+// external script sources of the isolate.
+func (i *Isolate) GetHeapCodeStatistics() HeapCodeStatistics {
+	hcs := C.IsolateGetHeapCodeStatistics(i.ptr)
+	return HeapCodeStatistics{
+		CodeAndMetadataSize:      uint64(hcs.code_and_metadata_size),
+		BytecodeAndMetadataSize:  uint64(hcs.bytecode_and_metadata_size),
+		ExternalScriptSourceSize: uint64(hcs.external_script_source_size),
+	}
+}
+
+// MeasureMemory attributes the memory of the isolate's heap to its contexts,
+// so that the context of a tenant that takes up too much can be found. It
+// forces full garbage collections to take the measurement, so it is costly,
+// and it fails if V8 does not complete the measurement.
+func (i *Isolate) MeasureMemory() (MemoryMeasurement, error) {
+	rtn := C.IsolateMeasureMemory(i.ptr)
+	if rtn.completed == 0 {
+		return MemoryMeasurement{}, errors.New("v8go: memory measurement did not complete")
+	}
+	defer C.free(unsafe.Pointer(rtn.contexts))
+	m := MemoryMeasurement{
+		Contexts:     make(map[*Context]uint64, int(rtn.count)),
+		Unattributed: uint64(rtn.unattributed),
+	}
+	sizes := (*[1 << 28]C.ContextMemory)(unsafe.Pointer(rtn.contexts))[:rtn.count:rtn.count]
+	for _, size := range sizes {
+		if ctx := getContext(int(size.ref)); ctx != nil {
+			m.Contexts[ctx] += uint64(size.bytes)
+		} else {
+			m.Unattributed += uint64(size.bytes)
+		}
+	}
+	return m, nil
+}
+
+// MemoryPressureLevel is the level of memory pressure reported with
+// Isolate.MemoryPressureNotification.
+type MemoryPressureLevel int
+
+const (
+	MemoryPressureNone     MemoryPressureLevel = C.MEMORY_PRESSURE_NONE
+	MemoryPressureModerate MemoryPressureLevel = C.MEMORY_PRESSURE_MODERATE
+	MemoryPressureCritical MemoryPressureLevel = C.MEMORY_PRESSURE_CRITICAL
+)
+
+// LowMemoryNotification makes the isolate collect as much garbage as it can,
+// with full garbage collections that block until done. It suits an isolate
+// between two uses, rather than one that is serving a request.
+func (i *Isolate) LowMemoryNotification() {
+	C.IsolateLowMemoryNotification(i.ptr)
+}
+
+// MemoryPressureNotification tells the isolate about the memory pressure of
+// the process, which makes it collect garbage more or less eagerly. It can be
+// called from any goroutine, even while the isolate runs JavaScript; at the
+// critical level, the isolate interrupts a running script to collect garbage.
+func (i *Isolate) MemoryPressureNotification(level MemoryPressureLevel) {
+	C.IsolateMemoryPressureNotification(i.ptr, C.int(level))
+}
+
+// IdleNotification lets the isolate do garbage collection work that is due,
+// for up to idle, while it has nothing else to do. It returns true once
+// there is nothing left to collect, in which case there is no need to call it
+// again until the isolate has run more JavaScript.
+func (i *Isolate) IdleNotification(idle time.Duration) bool {
+	return C.IsolateIdleNotification(i.ptr, C.double(idle.Seconds())) != 0
+}
+
+// AdjustAmountOfExternalAllocatedMemory tells the isolate about change bytes
+// of memory, allocated or freed outside its heap, that JavaScript objects keep
+// alive, so that it takes them into account for garbage collection. It returns
+// the amount of external memory the isolate has been told about in total.
+func (i *Isolate) AdjustAmountOfExternalAllocatedMemory(change int64) int64 {
+	return int64(C.IsolateAdjustExternalMemory(i.ptr, C.int64_t(change)))
+}
+
+// Lock starts an isolate session: the calling goroutine is locked to its
+// operating system thread, which takes the isolate's V8 lock until the
+// matching call to Unlock. Every call into the isolate otherwise acquires
+// and releases that lock itself, so holding it is much cheaper for code
+// that makes many calls in a row, such as converting a large value.
+// Sessions of the same goroutine nest. Only one goroutine can hold the lock
+// at a time: Lock in another blocks until the session ends. Unlock must be
+// called from the goroutine that called Lock.
+func (i *Isolate) Lock() {
+	runtime.LockOSThread()
+	C.IsolateLock(i.ptr)
+}
+
+// Unlock ends an isolate session started by Lock.
+func (i *Isolate) Unlock() {
+	C.IsolateUnlock(i.ptr)
+	runtime.UnlockOSThread()
+}
+
+// ReclaimContexts frees about budget values of the contexts of the isolate
+// closed with Context.CloseDeferred, oldest first, or all of them for a
+// budget of 0 or less, and returns the number of values that are left to
+// free. It takes the isolate's lock for the time it takes, which is about
+// that of freeing as many values with Value.Release.
+func (i *Isolate) ReclaimContexts(budget int) int {
+	if budget < 0 {
+		budget = 0
+	}
+	return int(C.IsolateReclaimContexts(i.ptr, C.size_t(budget)))
+}
+
+// deadValues returns the number of values that ReclaimContexts has left to
+// free, without taking the isolate's lock.
+func (i *Isolate) deadValues() int {
+	return int(C.IsolateDeadValues(i.ptr))
+}
+
 // Dispose will dispose the Isolate VM; subsequent calls will panic.
 func (i *Isolate) Dispose() {
 	if i.ptr == nil {
 		return
 	}
-	C.IsolateDispose(i.ptr)
+	if i.creator != nil {
+		i.creator.Dispose()
+		return
+	}
+	ptr := i.release()
+	C.IsolateDispose(ptr)
+	i.snapshot = nil
+}
+
+// release detaches the isolate from Go ahead of disposing of it, and returns
+// its pointer for C.IsolateDispose.
+func (i *Isolate) release() C.IsolatePtr {
+	i.unregisterFastFunctions()
+	i.closeInspectorSessions()
+	heapLimitRegistry.Delete(i.ptr)
+	i.templateMutex.Lock()
+	for _, ptr := range i.freedTemplates {
+		C.TemplateFreeWrapper(ptr)
+	}
+	i.freedTemplates = nil
+	i.templatesDisposed = true
+	i.templateMutex.Unlock()
+	ptr := i.ptr
 	i.ptr = nil
+	i.finalizerMutex.Lock()
+	i.finalizers = nil
+	i.finalizerMutex.Unlock()
+	return ptr
 }
 
 // ThrowException schedules an exception to be thrown when returning to
@@ -157,9 +658,9 @@ func (i *Isolate) ThrowException(value *Value) *Value {
 	if i.ptr == nil {
 		panic("Isolate has been disposed")
 	}
-	return &Value{
-		ptr: C.IsolateThrowException(i.ptr, value.ptr),
-	}
+	rtn := C.IsolateThrowException(i.ptr, value.ptr)
+	runtime.KeepAlive(value)
+	return newValue(nil, rtn)
 }
 
 // Deprecated: use `iso.Dispose()`.
@@ -175,13 +676,84 @@ func (i *Isolate) registerCallback(cb FunctionCallbackWithError) int {
 	i.cbMutex.Lock()
 	i.cbSeq++
 	ref := i.cbSeq
-	i.cbs[ref] = cb
 	i.cbMutex.Unlock()
+	i.cbs.Store(ref, cb)
+	return ref
+}
+
+// registerContinuation registers the callbacks of a promise continuation in
+// ctx, of which at most one is ever called; the first call unregisters them
+// all. The callbacks of a promise that is never settled are unregistered when
+// ctx is closed.
+func (i *Isolate) registerContinuation(ctx *Context, cbs ...FunctionCallbackWithError) []int {
+	i.cbMutex.Lock()
+	first := i.cbSeq + 1
+	i.cbSeq += len(cbs)
+	i.cbMutex.Unlock()
+	refs := make([]int, len(cbs))
+	for n, cb := range cbs {
+		cb := cb
+		refs[n] = first + n
+		ctx.continuations.Store(refs[n], struct{}{})
+		i.cbs.Store(refs[n], FunctionCallbackWithError(func(info *FunctionCallbackInfo) (*Value, error) {
+			for m := range cbs {
+				i.cbs.Delete(first + m)
+				ctx.continuations.Delete(first + m)
+			}
+			return cb(info)
+		}))
+	}
+	return refs
+}
+
+// releaseCallbacks unregisters the callbacks of the function templates that
+// V8 has collected, which happens once a template has been released and no
+// function made from it is left in any context.
+func (i *Isolate) releaseCallbacks() {
+	i.templateMutex.Lock()
+	freed := i.freedTemplates
+	i.freedTemplates = nil
+	i.templateMutex.Unlock()
+	if len(freed) > 0 {
+		C.TemplatesFree(i.ptr, &freed[0], C.int(len(freed)))
+	}
+
+	var refs [64]C.int
+	for {
+		n := int(C.IsolateDrainReleasedCallbacks(i.ptr, &refs[0], C.size_t(len(refs))))
+		for _, ref := range refs[:n] {
+			i.cbs.Delete(int(ref))
+			i.unregisterFastFunction(int(ref))
+		}
+		if n < len(refs) {
+			return
+		}
+	}
+}
+
+// registerPropertyCallback registers the callback of accessors or
+// interceptors; they share the refs and the map of function callbacks.
+func (i *Isolate) registerPropertyCallback(cb propertyCallback) int {
+	i.cbMutex.Lock()
+	i.cbSeq++
+	ref := i.cbSeq
+	i.cbMutex.Unlock()
+	i.cbs.Store(ref, cb)
 	return ref
 }
 
+func (i *Isolate) getPropertyCallback(ref int) propertyCallback {
+	cb, ok := i.cbs.Load(ref)
+	if !ok {
+		return nil
+	}
+	return cb.(propertyCallback)
+}
+
 func (i *Isolate) getCallback(ref int) FunctionCallbackWithError {
-	i.cbMutex.RLock()
-	defer i.cbMutex.RUnlock()
-	return i.cbs[ref]
+	cb, ok := i.cbs.Load(ref)
+	if !ok {
+		return nil
+	}
+	return cb.(FunctionCallbackWithError)
 }
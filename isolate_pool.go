@@ -0,0 +1,316 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"context"
+	"sync"
+	"sync/atomic"
+)
+
+// IsolatePoolConfig configures an IsolatePool.
+type IsolatePoolConfig struct {
+	// Size is the number of warm contexts, each in an isolate of its own, that
+	// the pool keeps ready to be borrowed.
+	Size int
+	// IsolateOptions are the options that the isolates of the pool are created
+	// with, such as FromSnapshot.
+	IsolateOptions []IsolateOption
+	// Global, if set, creates the global template of the contexts of an
+	// isolate. It is called once per isolate.
+	Global func(iso *Isolate) *ObjectTemplate
+	// MaxUses is the number of contexts an isolate hands out before it is
+	// disposed of and replaced by a new one; 0 means no limit.
+	MaxUses int
+	// NotifyLowMemory makes the pool send a low memory notification to an
+	// isolate, which collects as much garbage as it can, before it creates
+	// the isolate's next context.
+	NotifyLowMemory bool
+	// DisposeAsync makes the pool dispose of the isolates it replaces with
+	// Isolate.DisposeAsync, so that recycling an isolate waits for the
+	// disposal of the last one only once MaxPendingDisposals are pending.
+	DisposeAsync bool
+	// NUMA spreads the isolates of the pool across the NUMA nodes of the
+	// machine, see NUMANodes. Each isolate belongs to a node, on whose CPUs
+	// its contexts are created and recycled, so that Linux allocates its heap
+	// in the node's memory, and Get hands out the contexts of the node of the
+	// calling thread first, so that callers that lock their goroutine to a
+	// node with LockOSThreadToNode run isolates of their node. On machines of
+	// a single node it does nothing.
+	//
+	// The pool only pins threads while it creates and recycles contexts: a
+	// context from Get runs on whatever thread its caller's goroutine is on,
+	// and memory that the isolate allocates meanwhile may come from another
+	// node. To keep the execution of a context on its node, lock the goroutine
+	// that uses it with LockOSThreadToNode and the node from Node, or run the
+	// context under a Scheduler with OwnerThread started from such a
+	// goroutine.
+	NUMA bool
+}
+
+// IsolatePoolNodeStats are the counts of an IsolatePool for a NUMA node, see
+// IsolatePool.NodeStats.
+type IsolatePoolNodeStats struct {
+	// Node is the ID of the node.
+	Node int
+	// Isolates is the number of isolates of the pool on the node.
+	Isolates int
+	// Ready is the number of warm contexts of the node that are ready.
+	Ready int
+	// Gets is the number of contexts that Get handed out to callers
+	// running on the node, of which LocalGets were of an isolate of the
+	// node.
+	Gets      uint64
+	LocalGets uint64
+	// Created is the number of isolates created on the node.
+	Created uint64
+}
+
+// IsolatePool hands out fresh contexts from a pool of warm isolates. A
+// borrowed context is returned with Put, after which the pool closes it and,
+// in the background, creates the next context of its isolate, or replaces the
+// isolate. IsolatePool is safe for concurrent use.
+type IsolatePool struct {
+	cfg IsolatePoolConfig
+	// nodes are the NUMA nodes that the isolates are placed on, a single
+	// node unless the pool places them, and ready holds the warm contexts of
+	// each.
+	nodes []NUMANode
+	ready []chan *Context
+	stats []poolNodeCounters
+	// work counts the contexts being created or recycled in the background.
+	work sync.WaitGroup
+
+	mu       sync.Mutex
+	closed   bool
+	isolates map[*Isolate]*pooledIsolate
+}
+
+type pooledIsolate struct {
+	global *ObjectTemplate
+	uses   int
+	// node is the index of the NUMA node of the isolate in the pool's nodes.
+	node int
+}
+
+type poolNodeCounters struct {
+	gets, localGets, created uint64
+}
+
+// NewIsolatePool creates a pool and starts creating its warm contexts in the
+// background.
+func NewIsolatePool(cfg IsolatePoolConfig) *IsolatePool {
+	if cfg.Size < 0 {
+		panic("v8go: IsolatePool size must not be negative")
+	}
+	p := &IsolatePool{
+		cfg:      cfg,
+		nodes:    []NUMANode{{}},
+		isolates: make(map[*Isolate]*pooledIsolate),
+	}
+	if cfg.NUMA {
+		p.nodes = NUMANodes()
+	}
+	// Each node keeps its share of the warm contexts.
+	perNode := (cfg.Size + len(p.nodes) - 1) / len(p.nodes)
+	p.ready = make([]chan *Context, len(p.nodes))
+	for i := range p.ready {
+		p.ready[i] = make(chan *Context, perNode)
+	}
+	p.stats = make([]poolNodeCounters, len(p.nodes))
+	p.work.Add(cfg.Size)
+	for i := 0; i < cfg.Size; i++ {
+		node := i % len(p.nodes)
+		go func() {
+			defer p.work.Done()
+			p.offer(p.onNode(node, func() *Context { return p.create(node) }))
+		}()
+	}
+	return p
+}
+
+// Get returns a fresh context, creating one if no warm context is ready.
+// With NUMA, it returns a context of the node of the calling thread if one is
+// ready, and else creates one there, unless another node has one ready.
+func (p *IsolatePool) Get() *Context {
+	node := 0
+	if len(p.nodes) > 1 {
+		node = currentNUMANode()
+	}
+	stats := &p.stats[node]
+	atomic.AddUint64(&stats.gets, 1)
+	for i := range p.ready {
+		select {
+		case ctx := <-p.ready[(node+i)%len(p.ready)]:
+			if i == 0 {
+				atomic.AddUint64(&stats.localGets, 1)
+			}
+			return ctx
+		default:
+		}
+	}
+	p.mu.Lock()
+	closed := p.closed
+	p.mu.Unlock()
+	if closed {
+		panic("v8go: IsolatePool is closed")
+	}
+	atomic.AddUint64(&stats.localGets, 1)
+	return p.onNode(node, func() *Context { return p.create(node) })
+}
+
+// Put returns a context that was borrowed with Get to the pool. The context,
+// and any values of it, must not be used afterwards.
+func (p *IsolatePool) Put(ctx *Context) {
+	p.mu.Lock()
+	pi, ok := p.isolates[ctx.iso]
+	closed := p.closed
+	if ok && !closed {
+		// Added under the lock, so that Close cannot be waiting yet.
+		p.work.Add(1)
+	}
+	p.mu.Unlock()
+	if !ok {
+		panic("v8go: Context does not belong to the IsolatePool")
+	}
+	if closed {
+		p.dispose(ctx)
+		return
+	}
+	go func() {
+		defer p.work.Done()
+		p.offer(p.onNode(pi.node, func() *Context { return p.recycle(ctx, pi) }))
+	}()
+}
+
+// Close disposes of the isolates of the pool, once the contexts that are
+// being recycled are done. Contexts borrowed from the pool are disposed of
+// when they are returned with Put.
+func (p *IsolatePool) Close() {
+	p.mu.Lock()
+	p.closed = true
+	p.mu.Unlock()
+	p.work.Wait()
+	for _, ready := range p.ready {
+		for len(ready) > 0 {
+			p.dispose(<-ready)
+		}
+	}
+}
+
+// NodeStats returns the counts of the pool for each of the NUMA nodes that it
+// places isolates on, or for a single node, of ID 0, without NUMA.
+func (p *IsolatePool) NodeStats() []IsolatePoolNodeStats {
+	stats := make([]IsolatePoolNodeStats, len(p.nodes))
+	for i, node := range p.nodes {
+		stats[i] = IsolatePoolNodeStats{
+			Node:      node.ID,
+			Ready:     len(p.ready[i]),
+			Gets:      atomic.LoadUint64(&p.stats[i].gets),
+			LocalGets: atomic.LoadUint64(&p.stats[i].localGets),
+			Created:   atomic.LoadUint64(&p.stats[i].created),
+		}
+	}
+	p.mu.Lock()
+	for _, pi := range p.isolates {
+		stats[pi.node].Isolates++
+	}
+	p.mu.Unlock()
+	return stats
+}
+
+// Node returns the NUMA node of the isolate of ctx, a context of the pool,
+// and false if the pool does not place its isolates on nodes.
+func (p *IsolatePool) Node(ctx *Context) (NUMANode, bool) {
+	if len(p.nodes) < 2 {
+		return NUMANode{}, false
+	}
+	p.mu.Lock()
+	pi, ok := p.isolates[ctx.iso]
+	p.mu.Unlock()
+	if !ok {
+		panic("v8go: Context does not belong to the IsolatePool")
+	}
+	return p.nodes[pi.node], true
+}
+
+// onNode calls fn with the calling thread restricted to the CPUs of node, if
+// the pool places its isolates on nodes.
+func (p *IsolatePool) onNode(node int, fn func() *Context) *Context {
+	if len(p.nodes) > 1 {
+		if unlock, err := LockOSThreadToNode(p.nodes[node]); err == nil {
+			defer unlock()
+		}
+	}
+	return fn()
+}
+
+// create creates an isolate of node and its first context.
+func (p *IsolatePool) create(node int) *Context {
+	iso := NewIsolate(p.cfg.IsolateOptions...)
+	atomic.AddUint64(&p.stats[node].created, 1)
+	pi := &pooledIsolate{node: node}
+	if p.cfg.Global != nil {
+		pi.global = p.cfg.Global(iso)
+	}
+	p.mu.Lock()
+	p.isolates[iso] = pi
+	p.mu.Unlock()
+	return p.newContext(iso, pi)
+}
+
+func (p *IsolatePool) newContext(iso *Isolate, pi *pooledIsolate) *Context {
+	pi.uses++
+	if pi.global != nil {
+		return NewContext(iso, pi.global)
+	}
+	return NewContext(iso)
+}
+
+// recycle closes ctx and returns the next context of its isolate, or of the
+// isolate that replaces it, once it has used up MaxUses or run out of heap.
+func (p *IsolatePool) recycle(ctx *Context, pi *pooledIsolate) *Context {
+	iso := ctx.iso
+	if iso.HeapLimitReached() || p.cfg.MaxUses > 0 && pi.uses >= p.cfg.MaxUses {
+		p.dispose(ctx)
+		return p.create(pi.node)
+	}
+	ctx.Close()
+	if p.cfg.NotifyLowMemory {
+		iso.LowMemoryNotification()
+	}
+	return p.newContext(iso, pi)
+}
+
+// offer makes ctx ready to be borrowed, unless its node has its share of
+// warm contexts or the pool is closed.
+func (p *IsolatePool) offer(ctx *Context) {
+	p.mu.Lock()
+	if !p.closed {
+		select {
+		case p.ready[p.isolates[ctx.iso].node] <- ctx:
+			p.mu.Unlock()
+			return
+		default:
+		}
+	}
+	p.mu.Unlock()
+	p.dispose(ctx)
+}
+
+func (p *IsolatePool) dispose(ctx *Context) {
+	iso := ctx.iso
+	if p.cfg.DisposeAsync {
+		// The values of the context are freed along with the isolate.
+		ctx.CloseDeferred()
+		iso.DisposeAsync(context.Background())
+	} else {
+		ctx.Close()
+		iso.Dispose()
+	}
+	p.mu.Lock()
+	delete(p.isolates, iso)
+	p.mu.Unlock()
+}
@@ -0,0 +1,137 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"sync"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestIsolatePool(t *testing.T) {
+	t.Parallel()
+
+	pool := v8.NewIsolatePool(v8.IsolatePoolConfig{
+		Size:            2,
+		MaxUses:         3,
+		NotifyLowMemory: true,
+		Global: func(iso *v8.Isolate) *v8.ObjectTemplate {
+			global := v8.NewObjectTemplate(iso)
+			global.Set("answer", int32(42))
+			return global
+		},
+	})
+	defer pool.Close()
+
+	var wg sync.WaitGroup
+	for i := 0; i < 8; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for j := 0; j < 5; j++ {
+				ctx := pool.Get()
+				// Every context starts fresh, without the state left by the
+				// previous borrower.
+				val, err := ctx.RunScript("const leaked = typeof previous; globalThis.previous = 1; leaked + answer", "pool.js")
+				if err != nil {
+					t.Error(err)
+				} else if val.String() != "undefined42" {
+					t.Errorf("unexpected result: %q", val.String())
+				}
+				pool.Put(ctx)
+			}
+		}()
+	}
+	wg.Wait()
+
+	other := v8.NewContext()
+	defer other.Isolate().Dispose()
+	defer other.Close()
+	if recoverPanic(func() { pool.Put(other) }) == nil {
+		t.Error("expected panic for a context that is not from the pool")
+	}
+}
+
+func TestIsolatePoolDisposeAsync(t *testing.T) {
+	t.Parallel()
+
+	pool := v8.NewIsolatePool(v8.IsolatePoolConfig{Size: 1, MaxUses: 1, DisposeAsync: true})
+	defer pool.Close()
+	for i := 0; i < 5; i++ {
+		ctx := pool.Get()
+		val, err := ctx.RunScript("typeof previous", "pool.js")
+		fatalIf(t, err)
+		if val.String() != "undefined" {
+			t.Errorf("unexpected result: %q", val.String())
+		}
+		_, err = ctx.RunScript("globalThis.previous = 1", "pool.js")
+		fatalIf(t, err)
+		pool.Put(ctx)
+	}
+}
+
+func TestIsolatePoolNUMA(t *testing.T) {
+	t.Parallel()
+
+	pool := v8.NewIsolatePool(v8.IsolatePoolConfig{Size: 4, NUMA: true})
+	defer pool.Close()
+	for i := 0; i < 10; i++ {
+		ctx := pool.Get()
+		run := func() {
+			val, err := ctx.RunScript("6 * 7", "pool.js")
+			fatalIf(t, err)
+			if val.Int32() != 42 {
+				t.Errorf("unexpected result: %v", val)
+			}
+		}
+		node, ok := pool.Node(ctx)
+		if ok != (len(v8.NUMANodes()) > 1) {
+			t.Errorf("expected Node to report a node only with several nodes, got %v", ok)
+		}
+		if !ok {
+			run()
+		} else if unlock, err := v8.LockOSThreadToNode(node); err == nil {
+			run()
+			unlock()
+		} else {
+			t.Errorf("unexpected error pinning to node %d: %v", node.ID, err)
+		}
+		pool.Put(ctx)
+	}
+
+	stats := pool.NodeStats()
+	if len(stats) != len(v8.NUMANodes()) {
+		t.Fatalf("expected the stats of %d nodes, got %+v", len(v8.NUMANodes()), stats)
+	}
+	var gets, local, created uint64
+	for _, s := range stats {
+		if s.LocalGets > s.Gets {
+			t.Errorf("expected at most %d local gets, got %d", s.Gets, s.LocalGets)
+		}
+		gets += s.Gets
+		local += s.LocalGets
+		created += s.Created
+	}
+	if gets != 10 || created < 4 {
+		t.Errorf("expected 10 gets and 4 isolates, got %+v", stats)
+	}
+	if len(stats) == 1 && local != gets {
+		t.Errorf("expected every get of a single node to be local, got %+v", stats)
+	}
+}
+
+func TestIsolatePoolClose(t *testing.T) {
+	t.Parallel()
+
+	pool := v8.NewIsolatePool(v8.IsolatePoolConfig{Size: 1})
+	ctx := pool.Get()
+	pool.Close()
+	// Contexts borrowed before Close are disposed of on return.
+	pool.Put(ctx)
+	if recoverPanic(func() { pool.Get() }) == nil {
+		t.Error("expected panic for a closed pool")
+	}
+}
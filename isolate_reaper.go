@@ -0,0 +1,82 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"context"
+	"runtime"
+	"sync"
+)
+
+// MaxPendingDisposals is the number of isolates that may wait to be disposed
+// of by DisposeAsync before it waits for room.
+const MaxPendingDisposals = 16
+
+// reaper disposes of the isolates handed to DisposeAsync, one at a time, on
+// an operating system thread of its own. slots holds a token for each isolate
+// that waits to be disposed of or is being disposed of.
+var reaper = struct {
+	once  sync.Once
+	slots chan struct{}
+	queue chan reaperItem
+}{
+	slots: make(chan struct{}, MaxPendingDisposals),
+	queue: make(chan reaperItem, MaxPendingDisposals),
+}
+
+type reaperItem struct {
+	ptr C.IsolatePtr
+	// snapshot must outlive the isolate that was created from it.
+	snapshot *Snapshot
+}
+
+func runReaper() {
+	runtime.LockOSThread()
+	for item := range reaper.queue {
+		C.IsolateDispose(item.ptr)
+		runtime.KeepAlive(item.snapshot)
+		<-reaper.slots
+	}
+}
+
+// DisposeAsync disposes of the isolate like Dispose, but leaves the disposal
+// of its heap, which takes time in proportion to its size, to a thread of its
+// own, so that the caller can go on at once. The isolate must not be used
+// afterwards, and must not be locked, see Lock.
+//
+// Once MaxPendingDisposals isolates are waiting to be disposed of, DisposeAsync
+// waits for one of them to be done, or for ctx to be done, in which case it
+// returns ctx's error and leaves the isolate as it is, to be disposed of some
+// other way.
+func (i *Isolate) DisposeAsync(ctx context.Context) error {
+	if i.ptr == nil {
+		return nil
+	}
+	if i.creator != nil {
+		i.creator.Dispose()
+		return nil
+	}
+	reaper.once.Do(func() { go runReaper() })
+	select {
+	case reaper.slots <- struct{}{}:
+	default:
+		select {
+		case reaper.slots <- struct{}{}:
+		case <-ctx.Done():
+			return ctx.Err()
+		}
+	}
+	reaper.queue <- reaperItem{ptr: i.release(), snapshot: i.snapshot}
+	i.snapshot = nil
+	return nil
+}
+
+// PendingDisposals returns the number of isolates handed to DisposeAsync that
+// have not been disposed of yet.
+func PendingDisposals() int {
+	return len(reaper.slots)
+}
@@ -0,0 +1,85 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"context"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestIsolateDisposeAsync(t *testing.T) {
+	t.Parallel()
+
+	creator := v8.NewSnapshotCreator()
+	setup := v8.NewContext(creator.Isolate())
+	_, err := setup.RunScript(`var fromSnapshot = 42`, "setup.js")
+	fatalIf(t, err)
+	snapshot, err := creator.Create(setup, v8.FunctionCodeKeep)
+	fatalIf(t, err)
+	creator.Isolate().Dispose()
+
+	for i := 0; i < 2*v8.MaxPendingDisposals; i++ {
+		iso := v8.NewIsolate(v8.FromSnapshot(snapshot))
+		ctx := v8.NewContext(iso)
+		_, err := ctx.RunScript(`globalThis.big = Array.from({length: 1e5}, (_, i) => ({i}))`, "big.js")
+		fatalIf(t, err)
+		ctx.CloseDeferred()
+		fatalIf(t, iso.DisposeAsync(context.Background()))
+		if pending := v8.PendingDisposals(); pending > v8.MaxPendingDisposals {
+			t.Fatalf("expected at most %d pending disposals, got %d", v8.MaxPendingDisposals, pending)
+		}
+		// Disposing of it again does nothing.
+		fatalIf(t, iso.DisposeAsync(context.Background()))
+		iso.Dispose()
+	}
+
+	// A context that is done leaves the isolate usable if there is no room.
+	iso := v8.NewIsolate()
+	done, cancel := context.WithCancel(context.Background())
+	cancel()
+	if err := iso.DisposeAsync(done); err != nil {
+		if err != context.Canceled {
+			t.Fatalf("expected the context's error, got %v", err)
+		}
+		ctx := v8.NewContext(iso)
+		ctx.Close()
+		iso.Dispose()
+	}
+
+	deadline := time.Now().Add(30 * time.Second)
+	for v8.PendingDisposals() > 0 {
+		if time.Now().After(deadline) {
+			t.Fatal("expected the isolates to be disposed of")
+		}
+		time.Sleep(time.Millisecond)
+	}
+}
+
+func BenchmarkIsolateDispose(b *testing.B) {
+	for _, async := range []bool{false, true} {
+		name := "sync"
+		if async {
+			name = "async"
+		}
+		b.Run(name, func(b *testing.B) {
+			for n := 0; n < b.N; n++ {
+				b.StopTimer()
+				iso := v8.NewIsolate()
+				ctx := v8.NewContext(iso)
+				ctx.RunScript(`globalThis.big = Array.from({length: 1e5}, (_, i) => ({i}))`, "big.js")
+				ctx.Close()
+				b.StartTimer()
+				if async {
+					iso.DisposeAsync(context.Background())
+				} else {
+					iso.Dispose()
+				}
+			}
+		})
+	}
+}
@@ -6,10 +6,15 @@ package v8go_test
 
 import (
 	"encoding/json"
+	"errors"
 	"fmt"
 	"math/rand"
+	"os"
+	"runtime"
+	"strconv"
 	"strings"
 	"testing"
+	"time"
 
 	v8 "rogchap.com/v8go"
 )
@@ -98,6 +103,59 @@ func TestIsolateCompileUnboundScript(t *testing.T) {
 	}
 }
 
+type failingReader struct{ err error }
+
+func (r failingReader) Read([]byte) (int, error) { return 0, r.err }
+
+func TestIsolateCompileUnboundScriptStreaming(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	// Larger than a chunk, with a multi-byte character across chunks.
+	var src strings.Builder
+	src.WriteString("var s = 'Ω';\n")
+	for src.Len() < 200<<10 {
+		src.WriteString("s += 'Ω' + String.fromCharCode(65);\n")
+	}
+	src.WriteString("s.length")
+	want, err := ctx.RunScript(src.String(), "reference.js")
+	fatalIf(t, err)
+
+	// The isolate keeps serving other goroutines while the script compiles.
+	done := make(chan struct{})
+	go func() {
+		defer close(done)
+		other := v8.NewContext(iso)
+		defer other.Close()
+		for i := 0; i < 10; i++ {
+			if _, err := other.RunScript("1 + 1", "other.js"); err != nil {
+				t.Error(err)
+			}
+		}
+	}()
+
+	us, err := iso.CompileUnboundScriptStreaming(strings.NewReader(src.String()), "streamed.js")
+	fatalIf(t, err)
+	<-done
+	val, err := us.Run(ctx)
+	fatalIf(t, err)
+	if val.Int32() != want.Int32() {
+		t.Errorf("unexpected result: expected %d, got %d", want.Int32(), val.Int32())
+	}
+
+	_, err = iso.CompileUnboundScriptStreaming(strings.NewReader("invalid js"), "invalid.js")
+	if _, ok := err.(*v8.JSError); !ok {
+		t.Errorf("expected a JSError, got %v", err)
+	}
+	readErr := errors.New("read failed")
+	if _, err := iso.CompileUnboundScriptStreaming(failingReader{readErr}, "failing.js"); err != readErr {
+		t.Errorf("expected the read error, got %v", err)
+	}
+}
+
 func TestIsolateCompileUnboundScript_CachedDataRejected(t *testing.T) {
 	s := "function foo() { return 'bar'; }; foo()"
 	iso := v8.NewIsolate()
@@ -159,6 +217,134 @@ func TestIsolateGetHeapStatistics(t *testing.T) {
 	}
 }
 
+func TestIsolateGetHeapSpaceStatistics(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	spaces := map[string]v8.HeapSpaceStatistics{}
+	var used uint64
+	for _, space := range iso.GetHeapSpaceStatistics() {
+		spaces[space.SpaceName] = space
+		used += space.SpaceUsedSize
+	}
+	for _, name := range []string{"new_space", "old_space", "code_space", "large_object_space"} {
+		if _, ok := spaces[name]; !ok {
+			t.Errorf("expected a %s, got %v", name, spaces)
+		}
+	}
+	if total := iso.GetHeapStatistics().UsedHeapSize; used != total {
+		t.Errorf("expected the spaces to use %d bytes in total, got %d", total, used)
+	}
+
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	_, err := ctx.RunScript("function f(x) { return x * 2 }; f(1)", "code.js")
+	fatalIf(t, err)
+	if code := iso.GetHeapCodeStatistics(); code.BytecodeAndMetadataSize == 0 {
+		t.Errorf("expected bytecode, got %+v", code)
+	}
+}
+
+func TestIsolateMeasureMemory(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	small := v8.NewContext(iso)
+	defer small.Close()
+	large := v8.NewContext(iso)
+	defer large.Close()
+
+	_, err := large.RunScript("var data = []; for (let i = 0; i < 1e5; i++) data.push({i})", "large.js")
+	fatalIf(t, err)
+
+	m, err := iso.MeasureMemory()
+	fatalIf(t, err)
+	if len(m.Contexts) != 2 {
+		t.Fatalf("expected 2 contexts to be measured, got %v", m.Contexts)
+	}
+	if m.Contexts[large] < 1<<20 || m.Contexts[large] < 4*m.Contexts[small] {
+		t.Errorf("expected the large context to take up the most memory, got %d and %d", m.Contexts[large], m.Contexts[small])
+	}
+}
+
+func TestIsolateGarbageCollection(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	_, err := ctx.RunScript("var garbage = []; for (let i = 0; i < 1e5; i++) garbage.push({i}); garbage = null", "garbage.js")
+	fatalIf(t, err)
+	used := iso.GetHeapStatistics().UsedHeapSize
+	iso.MemoryPressureNotification(v8.MemoryPressureModerate)
+	iso.MemoryPressureNotification(v8.MemoryPressureNone)
+	for i := 0; i < 100; i++ {
+		if iso.IdleNotification(10 * time.Millisecond) {
+			break
+		}
+	}
+	iso.LowMemoryNotification()
+	if after := iso.GetHeapStatistics().UsedHeapSize; after >= used {
+		t.Errorf("expected the garbage to be collected, used %d bytes before and %d after", used, after)
+	}
+
+	external := iso.AdjustAmountOfExternalAllocatedMemory(1 << 20)
+	if external < 1<<20 {
+		t.Errorf("expected at least 1MB of external memory, got %d", external)
+	}
+	if n := iso.AdjustAmountOfExternalAllocatedMemory(-1 << 20); n != external-1<<20 {
+		t.Errorf("expected %d bytes of external memory, got %d", external-1<<20, n)
+	}
+}
+
+func TestIsolateResourceConstraints(t *testing.T) {
+	t.Parallel()
+
+	defaults := v8.NewIsolate()
+	defaultLimit := defaults.GetHeapStatistics().HeapSizeLimit
+	defaults.Dispose()
+
+	for _, opt := range []v8.IsolateOption{
+		v8.HeapSize(0, 32<<20),
+		v8.ResourceConstraints{MaxOldGenerationSize: 24 << 20, MaxYoungGenerationSize: 4 << 20},
+	} {
+		iso := v8.NewIsolate(opt)
+		limit := iso.GetHeapStatistics().HeapSizeLimit
+		if limit == 0 || limit > 40<<20 || limit >= defaultLimit {
+			t.Errorf("unexpected heap size limit %d, the default is %d", limit, defaultLimit)
+		}
+		ctx := v8.NewContext(iso)
+		val, err := ctx.RunScript("[1, 2, 3].map(x => x * 2).join()", "heap.js")
+		fatalIf(t, err)
+		if val.String() != "2,4,6" {
+			t.Errorf("unexpected result: %v", val)
+		}
+		ctx.Close()
+		iso.Dispose()
+	}
+}
+
+func TestIsolateUncaughtStackTrace(t *testing.T) {
+	t.Parallel()
+
+	for _, opt := range []v8.IsolateOption{
+		v8.UncaughtStackTrace(0, 0),
+		v8.UncaughtStackTrace(3, v8.StackTraceDetailed|v8.StackTraceScriptID),
+	} {
+		iso := v8.NewIsolate(opt)
+		ctx := v8.NewContext(iso)
+		_, err := ctx.RunScript("function fail() { throw new Error('fail') }\nfail()", "fail.js")
+		e := err.(*v8.JSError)
+		if e.Location != "fail.js:1:19" || !strings.Contains(e.StackTrace, "at fail (fail.js:1:25)") {
+			t.Errorf("unexpected error %#v", e)
+		}
+		ctx.Close()
+		iso.Dispose()
+	}
+}
+
 func TestCallbackRegistry(t *testing.T) {
 	t.Parallel()
 
@@ -199,6 +385,109 @@ func TestIsolateDispose(t *testing.T) {
 	}
 }
 
+func TestIsolateLock(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	iso.Lock()
+	iso.Lock()
+	obj, err := ctx.RunScript("({a: 1, b: 'two'})", "")
+	fatalIf(t, err)
+	iso.Unlock()
+	for _, key := range []string{"a", "b"} {
+		if _, err := obj.Object().Get(key); err != nil {
+			t.Errorf("unexpected error getting %q: %v", key, err)
+		}
+	}
+	iso.Unlock()
+
+	// Once the session has ended, other threads can use the isolate again.
+	done := make(chan error)
+	go func() {
+		_, err := ctx.RunScript("1 + 1", "")
+		done <- err
+	}()
+	fatalIf(t, <-done)
+}
+
+func TestIsolateLockBlocksOtherGoroutines(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	iso.Lock()
+	locked := make(chan struct{})
+	done := make(chan error)
+	go func() {
+		// The session of another goroutine does not nest in this one: Lock
+		// waits for it to end.
+		iso.Lock()
+		close(locked)
+		_, err := ctx.RunScript("1 + 1", "")
+		iso.Unlock()
+		done <- err
+	}()
+	select {
+	case <-locked:
+		t.Fatal("expected Lock to block while another goroutine holds the session")
+	case <-time.After(100 * time.Millisecond):
+	}
+	iso.Unlock()
+	fatalIf(t, <-done)
+}
+
+func TestIsolateArrayBufferAllocator(t *testing.T) {
+	t.Parallel()
+
+	for _, pooled := range []bool{false, true} {
+		opts := []v8.IsolateOption{v8.ArrayBufferQuota(1 << 20)}
+		if pooled {
+			opts = append(opts, v8.PooledArrayBuffers)
+		}
+		iso := v8.NewIsolate(opts...)
+		ctx := v8.NewContext(iso)
+
+		val, err := ctx.RunScript("globalThis.big = new Uint8Array(512 << 10); big.length", "quota.js")
+		fatalIf(t, err)
+		if val.Int32() != 512<<10 {
+			t.Errorf("unexpected length: %v", val)
+		}
+		if n := iso.ArrayBufferMemory(); n < 512<<10 {
+			t.Errorf("expected at least %d bytes of array buffer memory, got %d", 512<<10, n)
+		}
+		if _, err := ctx.RunScript("new ArrayBuffer(768 << 10)", "quota.js"); err == nil {
+			t.Error("expected error but got <nil>")
+		}
+		if _, err := v8.NewArrayBuffer(ctx, 768<<10); err == nil {
+			t.Error("expected error but got <nil>")
+		}
+
+		// Recycled memory is zeroed again.
+		val, err = ctx.RunScript(`
+			for (let i = 0; i < 100; i++) new Uint8Array(1000).fill(1);
+			new Uint8Array(1000).every(b => b === 0)`, "pool.js")
+		fatalIf(t, err)
+		if !val.Boolean() {
+			t.Error("expected zeroed memory")
+		}
+		ab, err := v8.NewArrayBuffer(ctx, 100)
+		fatalIf(t, err)
+		if ab.ByteLength() != 100 {
+			t.Errorf("unexpected byte length: %d", ab.ByteLength())
+		}
+
+		ctx.Close()
+		iso.Dispose()
+	}
+}
+
 func TestIsolateThrowException(t *testing.T) {
 	t.Parallel()
 	iso := v8.NewIsolate()
@@ -296,3 +585,67 @@ func makeObject() interface{} {
 		"b": "AAAABBBBAAAABBBBAAAABBBBAAAABBBBAAAABBBB",
 	}
 }
+
+// BenchmarkIsolateParallel runs a script in an isolate per goroutine, for
+// the scaling of isolates across GOMAXPROCS, see the -cpu flag of go test.
+func BenchmarkIsolateParallel(b *testing.B) {
+	b.ReportAllocs()
+	b.RunParallel(func(pb *testing.PB) {
+		iso := v8.NewIsolate()
+		defer iso.Dispose()
+		ctx := v8.NewContext(iso)
+		defer ctx.Close()
+		us, err := iso.CompileUnboundScript("(() => { let s = 0; for (let i = 0; i < 1000; i++) s += i; return s; })()", "parallel.js", v8.CompileOptions{})
+		if err != nil {
+			b.Fatal(err)
+		}
+		for pb.Next() {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				if _, err := us.Run(ctx); err != nil {
+					b.Fatal(err)
+				}
+			})
+		}
+	})
+}
+
+// BenchmarkIsolateRSS reports the resident memory that an isolate with a
+// context adds to the process, which the v8go_sharedcage build variant
+// lowers by sharing the read-only heap between isolates. The isolates are
+// kept until the end, since the memory of disposed isolates stays resident
+// for the next ones; -benchtime 100x measures a hundred of them at once.
+func BenchmarkIsolateRSS(b *testing.B) {
+	if runtime.GOOS != "linux" {
+		b.Skip("the resident memory is read from /proc")
+	}
+	isos := make([]*v8.Isolate, b.N)
+	defer func() {
+		for _, iso := range isos {
+			if iso != nil {
+				iso.Dispose()
+			}
+		}
+	}()
+	before := residentBytes(b)
+	for n := range isos {
+		isos[n] = v8.NewIsolate()
+		if _, err := v8.NewContext(isos[n]).RunScript("0", "rss.js"); err != nil {
+			b.Fatal(err)
+		}
+	}
+	b.ReportMetric(float64(residentBytes(b)-before)/float64(b.N), "rss-bytes/isolate")
+}
+
+// residentBytes returns the resident memory of the process.
+func residentBytes(b *testing.B) int64 {
+	statm, err := os.ReadFile("/proc/self/statm")
+	if err != nil {
+		b.Fatal(err)
+	}
+	fields := strings.Fields(string(statm))
+	pages, err := strconv.ParseInt(fields[1], 10, 64)
+	if err != nil {
+		b.Fatal(err)
+	}
+	return pages * int64(os.Getpagesize())
+}
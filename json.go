@@ -9,6 +9,9 @@ package v8go
 import "C"
 import (
 	"errors"
+	"io"
+	"runtime"
+	"sync"
 	"unsafe"
 )
 
@@ -18,25 +21,194 @@ func JSONParse(ctx *Context, str string) (*Value, error) {
 	if ctx == nil {
 		return nil, errors.New("v8go: Context is required")
 	}
-	cstr := C.CString(str)
-	defer C.free(unsafe.Pointer(cstr))
+	rtn := C.JSONParse(ctx.ptr, stringArg(str))
+	runtime.KeepAlive(str)
+	return valueResult(ctx, rtn)
+}
+
+// JSONParseBytes is like JSONParse, but parses the UTF-8 encoded JSON text of
+// data, which is copied once, straight into V8's memory, rather than to a Go
+// string and a C string first.
+func JSONParseBytes(ctx *Context, data []byte) (*Value, error) {
+	if ctx == nil {
+		return nil, errors.New("v8go: Context is required")
+	}
+	rtn := C.JSONParse(ctx.ptr, bytesArg(data))
+	runtime.KeepAlive(data)
+	return valueResult(ctx, rtn)
+}
+
+// jsonReadBuffer is the size of the buffer that JSONParseReader starts reading
+// into, which it doubles whenever it is full.
+const jsonReadBuffer = 64 << 10
+
+// JSONParseReader is like JSONParse, but parses the UTF-8 encoded JSON text
+// read from r until EOF, for large bodies. The text is read into memory
+// outside of the Go heap, which an ASCII text is then parsed from in
+// place, as an external string, without copying it again.
+func JSONParseReader(ctx *Context, r io.Reader) (*Value, error) {
+	if ctx == nil {
+		return nil, errors.New("v8go: Context is required")
+	}
+	if r == nil {
+		return nil, errors.New("v8go: io.Reader is required")
+	}
 
-	rtn := C.JSONParse(ctx.ptr, cstr)
+	size, length := jsonReadBuffer, 0
+	buf := C.malloc(C.size_t(size))
+	for {
+		if length == size {
+			if size == maxStringLength {
+				C.free(buf)
+				return nil, errors.New("v8go: JSON text is too long")
+			}
+			size *= 2
+			if size > maxStringLength {
+				size = maxStringLength
+			}
+			grown := C.realloc(buf, C.size_t(size))
+			if grown == nil {
+				C.free(buf)
+				return nil, errors.New("v8go: JSON text allocation failed")
+			}
+			buf = grown
+		}
+		n, err := r.Read((*[maxStringLength]byte)(buf)[length:size:size])
+		length += n
+		if err == io.EOF {
+			break
+		}
+		if err != nil {
+			C.free(buf)
+			return nil, err
+		}
+	}
+
+	text := (*[maxStringLength]byte)(buf)[:length:length]
+	arg := C.StringArg{data: (*C.char)(buf), length: C.int(length)}
+	if length >= externalStringMinLength && isASCII(*(*string)(unsafe.Pointer(&text))) {
+		// V8 owns, and eventually frees, the memory of an external string.
+		arg.external = 1
+	} else {
+		defer C.free(buf)
+	}
+	rtn := C.JSONParse(ctx.ptr, arg)
 	return valueResult(ctx, rtn)
 }
 
+// JSONOption configures how a value is stringified, see JSONStringify.
+type JSONOption interface {
+	apply(*jsonOptions)
+}
+
+type jsonOptions struct {
+	replacer *Function
+	gap      string
+}
+
+type jsonOptionFunc func(*jsonOptions)
+
+func (f jsonOptionFunc) apply(o *jsonOptions) {
+	f(o)
+}
+
+// JSONReplacer stringifies values with the replacer function of
+// JSON.stringify, which is called for each key and value and returns the value
+// to stringify in its place. JSON.stringify is then looked up in the context
+// rather than called natively.
+func JSONReplacer(replacer *Function) JSONOption {
+	return jsonOptionFunc(func(o *jsonOptions) {
+		o.replacer = replacer
+	})
+}
+
+// JSONGap indents the JSON text with gap, like the space argument of
+// JSON.stringify; V8 uses at most its first 10 characters.
+func JSONGap(gap string) JSONOption {
+	return jsonOptionFunc(func(o *jsonOptions) {
+		o.gap = gap
+	})
+}
+
 // JSONStringify tries to stringify the JSON-serializable object value and returns it as string.
-func JSONStringify(ctx *Context, val Valuer) (string, error) {
+// Any JS errors, such as for a value with a cycle, will be returned as `JSError`.
+func JSONStringify(ctx *Context, val Valuer, opts ...JSONOption) (string, error) {
+	write, err := jsonStringify(ctx, val, opts)
+	if err != nil {
+		return "", err
+	}
+	str, rtnErr := utf8String(write)
+	if hasError(rtnErr) {
+		return "", newJSError(rtnErr)
+	}
+	return str, nil
+}
+
+// AppendJSON is like JSONStringify, but appends the JSON text to dst, which
+// V8 writes it into straight away if it has the capacity, and returns the
+// extended buffer. Reusing the buffer saves allocating one for each value.
+func AppendJSON(dst []byte, ctx *Context, val Valuer, opts ...JSONOption) ([]byte, error) {
+	write, err := jsonStringify(ctx, val, opts)
+	if err != nil {
+		return dst, err
+	}
+	dst, rtnErr := utf8Append(dst, write)
+	if hasError(rtnErr) {
+		return dst, newJSError(rtnErr)
+	}
+	return dst, nil
+}
+
+// jsonWriteBufferMax is the capacity up to which the buffers of WriteJSON are
+// kept for reuse.
+const jsonWriteBufferMax = 8 << 20
+
+var jsonWriteBuffers = sync.Pool{
+	New: func() interface{} { return new([]byte) },
+}
+
+// WriteJSON is like JSONStringify, but writes the JSON text to w, from a
+// buffer that is reused across calls, and returns the number of bytes written.
+func WriteJSON(w io.Writer, ctx *Context, val Valuer, opts ...JSONOption) (int, error) {
+	buf := jsonWriteBuffers.Get().(*[]byte)
+	defer func() {
+		if cap(*buf) <= jsonWriteBufferMax {
+			jsonWriteBuffers.Put(buf)
+		}
+	}()
+	var err error
+	*buf, err = AppendJSON((*buf)[:0], ctx, val, opts...)
+	if err != nil {
+		return 0, err
+	}
+	return w.Write(*buf)
+}
+
+func jsonStringify(ctx *Context, val Valuer, opts []JSONOption) (func(buf *C.char, cap C.int) C.RtnUtf8, error) {
 	if val == nil || val.value() == nil {
-		return "", errors.New("v8go: Value is required")
+		return nil, errors.New("v8go: Value is required")
+	}
+	var options jsonOptions
+	for _, o := range opts {
+		if o != nil {
+			o.apply(&options)
+		}
 	}
 	// If a nil context is passed we'll use the context/isolate that created the value.
 	var ctxPtr C.ContextPtr
 	if ctx != nil {
 		ctxPtr = ctx.ptr
 	}
+	var replacer C.ValuePtr
+	if options.replacer != nil {
+		replacer = options.replacer.ptr
+	}
 
-	str := C.JSONStringify(ctxPtr, val.value().ptr)
-	defer C.free(unsafe.Pointer(str))
-	return C.GoString(str), nil
+	return func(buf *C.char, cap C.int) C.RtnUtf8 {
+		rtn := C.JSONStringify(ctxPtr, val.value().ptr, replacer, stringArg(options.gap), buf, cap)
+		runtime.KeepAlive(val)
+		runtime.KeepAlive(options.replacer)
+		runtime.KeepAlive(options.gap)
+		return rtn
+	}, nil
 }
@@ -5,8 +5,11 @@
 package v8go_test
 
 import (
+	"errors"
 	"fmt"
+	"strings"
 	"testing"
+	"testing/iotest"
 
 	v8 "rogchap.com/v8go"
 )
@@ -31,6 +34,42 @@ func TestJSONParse(t *testing.T) {
 	}
 }
 
+func TestJSONParseBytesAndReader(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	// ASCII texts from 64KiB are parsed from external strings.
+	ascii := `{"rows":[` + strings.Repeat(`{"id":1,"name":"row"},`, 10000) + `{"id":2}]}`
+	unicode := `{"rows":["` + strings.Repeat("Ω", 100000) + `"]}`
+	for _, text := range []string{`{"a":[1,"b"]}`, ascii, unicode} {
+		fromBytes, err := v8.JSONParseBytes(ctx, []byte(text))
+		fatalIf(t, err)
+		// A reader that returns a few bytes at a time.
+		fromReader, err := v8.JSONParseReader(ctx, iotest.HalfReader(strings.NewReader(text)))
+		fatalIf(t, err)
+		for _, val := range []*v8.Value{fromBytes, fromReader} {
+			got, err := v8.JSONStringify(ctx, val)
+			fatalIf(t, err)
+			if got != text {
+				t.Errorf("expected the JSON text of %d bytes back, got %d bytes", len(text), len(got))
+			}
+		}
+	}
+
+	if _, err := v8.JSONParseBytes(ctx, []byte("{")); err == nil {
+		t.Error("expected error but got <nil>")
+	}
+	if _, err := v8.JSONParseBytes(ctx, nil); err == nil {
+		t.Error("expected error but got <nil>")
+	}
+	if _, err := v8.JSONParseReader(ctx, iotest.ErrReader(errors.New("read failed"))); err == nil || err.Error() != "read failed" {
+		t.Errorf("expected the error of the reader, got %v", err)
+	}
+}
+
 func TestJSONStringify(t *testing.T) {
 	t.Parallel()
 
@@ -40,6 +79,95 @@ func TestJSONStringify(t *testing.T) {
 	if _, err := v8.JSONStringify(ctx, nil); err == nil {
 		t.Error("expected error but got <nil>")
 	}
+
+	// Larger than the scratch buffer strings are first written into.
+	want := `["` + strings.Repeat("Ω", 1000) + `"]`
+	val, err := v8.JSONParse(ctx, want)
+	fatalIf(t, err)
+	for _, c := range []*v8.Context{ctx, nil} {
+		got, err := v8.JSONStringify(c, val)
+		fatalIf(t, err)
+		if got != want {
+			t.Errorf("unexpected JSON of %d bytes: got %d bytes", len(want), len(got))
+		}
+	}
+}
+
+func TestJSONStringifyOptions(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`({a: 1, secret: "x", nested: {b: [true, null]}})`, "value.js")
+	fatalIf(t, err)
+	replacerVal, err := ctx.RunScript(`(key, value) => key === "secret" ? undefined : value`, "replacer.js")
+	fatalIf(t, err)
+	replacer, err := replacerVal.AsFunction()
+	fatalIf(t, err)
+
+	got, err := v8.JSONStringify(ctx, val, v8.JSONGap("  "))
+	fatalIf(t, err)
+	if want := "{\n  \"a\": 1,\n  \"secret\": \"x\",\n  \"nested\": {\n    \"b\": [\n      true,\n      null\n    ]\n  }\n}"; got != want {
+		t.Errorf("expected %q, got %q", want, got)
+	}
+	got, err = v8.JSONStringify(ctx, val, v8.JSONReplacer(replacer), v8.JSONGap("\t"))
+	fatalIf(t, err)
+	if want := "{\n\t\"a\": 1,\n\t\"nested\": {\n\t\t\"b\": [\n\t\t\ttrue,\n\t\t\tnull\n\t\t]\n\t}\n}"; got != want {
+		t.Errorf("expected %q, got %q", want, got)
+	}
+
+	cyclic, err := ctx.RunScript("var o = {}; o.o = o; o", "cyclic.js")
+	fatalIf(t, err)
+	if _, err := v8.JSONStringify(ctx, cyclic); err == nil || !strings.Contains(err.Error(), "circular") {
+		t.Errorf("expected an error for a cyclic value, got %v", err)
+	}
+	throwing, err := ctx.RunScript(`(function() { throw new Error("replacer failed") })`, "throw.js")
+	fatalIf(t, err)
+	throwingFn, err := throwing.AsFunction()
+	fatalIf(t, err)
+	if _, err := v8.JSONStringify(ctx, val, v8.JSONReplacer(throwingFn)); err == nil || err.Error() != "Error: replacer failed" {
+		t.Errorf("expected the error of the replacer, got %v", err)
+	}
+}
+
+func TestAppendJSON(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	val, err := v8.JSONParse(ctx, `["a\u0000b"]`)
+	fatalIf(t, err)
+	buf := make([]byte, 0, 64)
+	buf = append(buf, "data: "...)
+	out, err := v8.AppendJSON(buf, ctx, val)
+	fatalIf(t, err)
+	if want := "data: [\"a\\u0000b\"]"; string(out) != want {
+		t.Errorf("expected %q, got %q", want, out)
+	}
+	if &out[0] != &buf[:1][0] {
+		t.Error("expected the JSON text to be written into the spare capacity")
+	}
+
+	// Longer than the spare capacity.
+	long := `["` + strings.Repeat("Ω", 1000) + `"]`
+	val, err = v8.JSONParse(ctx, long)
+	fatalIf(t, err)
+	out, err = v8.AppendJSON(buf, ctx, val)
+	fatalIf(t, err)
+	if string(out) != "data: "+long {
+		t.Errorf("unexpected JSON of %d bytes", len(out))
+	}
+
+	var sb strings.Builder
+	n, err := v8.WriteJSON(&sb, ctx, val)
+	fatalIf(t, err)
+	if n != len(long) || sb.String() != long {
+		t.Errorf("unexpected JSON of %d bytes written", n)
+	}
 }
 
 func ExampleJSONParse() {
@@ -65,3 +193,54 @@ func ExampleJSONStringify() {
 	// Output:
 	// {"a":1,"b":"foo"}
 }
+
+// benchJSON is a JSON array of n records.
+func benchJSON(n int) string {
+	records := make([]string, n)
+	for i := range records {
+		records[i] = fmt.Sprintf(`{"id":%d,"name":"record %d","tags":["a","b"],"score":%d.5}`, i, i, i)
+	}
+	return "[" + strings.Join(records, ",") + "]"
+}
+
+func BenchmarkJSONParse(b *testing.B) {
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+	for _, size := range []int{1, 100, 10000} {
+		data := benchJSON(size)
+		b.Run(fmt.Sprintf("Records%d", size), func(b *testing.B) {
+			b.ReportAllocs()
+			b.SetBytes(int64(len(data)))
+			for n := 0; n < b.N; n++ {
+				ctx.WithValueScope(func(*v8.ValueScope) {
+					if _, err := v8.JSONParse(ctx, data); err != nil {
+						b.Fatal(err)
+					}
+				})
+			}
+		})
+	}
+}
+
+func BenchmarkJSONStringify(b *testing.B) {
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+	for _, size := range []int{1, 100, 10000} {
+		data := benchJSON(size)
+		val, err := v8.JSONParse(ctx, data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		b.Run(fmt.Sprintf("Records%d", size), func(b *testing.B) {
+			b.ReportAllocs()
+			b.SetBytes(int64(len(data)))
+			for n := 0; n < b.N; n++ {
+				if _, err := v8.JSONStringify(ctx, val); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
@@ -0,0 +1,102 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"errors"
+	"os"
+	"sync"
+	"syscall"
+)
+
+// MappedCachedData is a code cache file mapped read-only into memory. V8
+// consumes the mapping in place, so every isolate that compiles a script from
+// it shares the same pages of the page cache instead of holding a copy.
+type MappedCachedData struct {
+	mu     sync.Mutex
+	data   []byte
+	refs   int
+	closed bool
+}
+
+var errEmptyCachedData = errors.New("v8go: empty code cache file")
+
+// MapCachedData maps the code cache file at path, for example one written
+// from UnboundScript.CreateCodeCache. The file must be replaced by renaming a
+// new file over it rather than rewritten in place while it is mapped.
+func MapCachedData(path string) (*MappedCachedData, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+	fi, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+	if fi.Size() == 0 {
+		return nil, errEmptyCachedData
+	}
+	data, err := syscall.Mmap(int(f.Fd()), 0, int(fi.Size()), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return nil, err
+	}
+	return &MappedCachedData{data: data}, nil
+}
+
+// CachedData returns CompilerCachedData whose Bytes are the mapped file, to set
+// as CompileOptions.CachedData. Each call returns a new value, so that isolates
+// compiling at the same time each get their own Rejected result. The Bytes are
+// only valid until Close is called.
+func (m *MappedCachedData) CachedData() *CompilerCachedData {
+	return &CompilerCachedData{Bytes: m.data}
+}
+
+// Len returns the size of the mapped file.
+func (m *MappedCachedData) Len() int {
+	return len(m.data)
+}
+
+// Close unmaps the file. Scripts compiled from CachedData must have finished
+// compiling; compiles started by a CodeCache hold the mapping open themselves.
+func (m *MappedCachedData) Close() error {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.closed {
+		return nil
+	}
+	m.closed = true
+	if m.refs > 0 {
+		return nil
+	}
+	return m.unmap()
+}
+
+// acquire holds the mapping open until the matching release, failing if it
+// has been closed.
+func (m *MappedCachedData) acquire() bool {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.closed {
+		return false
+	}
+	m.refs++
+	return true
+}
+
+func (m *MappedCachedData) release() {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.refs--
+	if m.refs == 0 && m.closed {
+		m.unmap()
+	}
+}
+
+func (m *MappedCachedData) unmap() error {
+	data := m.data
+	m.data = nil
+	return syscall.Munmap(data)
+}
@@ -0,0 +1,108 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import "time"
+
+// MetricBuckets is the number of buckets of a MetricHistogram.
+const MetricBuckets = C.METRIC_BUCKETS
+
+// MetricHistogram is the distribution of the durations of the events of an
+// engine metric, or of the calls of a callback.
+type MetricHistogram struct {
+	Count uint64
+	Sum   time.Duration
+	Min   time.Duration
+	Max   time.Duration
+	// Buckets[i] counts the events that took less than 2^i Units, and at
+	// least 2^(i-1); the last bucket counts the longer ones.
+	Buckets [MetricBuckets]uint64
+	// Unit is time.Microsecond for engine metrics, and time.Nanosecond for
+	// CallbackStats.
+	Unit time.Duration
+}
+
+// Mean returns the mean duration of the events.
+func (h MetricHistogram) Mean() time.Duration {
+	if h.Count == 0 {
+		return 0
+	}
+	return h.Sum / time.Duration(h.Count)
+}
+
+// newMetricHistogram converts c, whose durations are in unit.
+func newMetricHistogram(c *C.MetricHistogram, unit time.Duration) MetricHistogram {
+	h := MetricHistogram{
+		Count: uint64(c.count),
+		Sum:   time.Duration(c.sum) * unit,
+		Max:   time.Duration(c.max) * unit,
+		Unit:  unit,
+	}
+	if h.Count > 0 {
+		h.Min = time.Duration(c.min) * unit
+	}
+	for b, n := range c.buckets {
+		h.Buckets[b] = uint64(n)
+	}
+	return h
+}
+
+// EngineMetrics are the metrics that V8 records for an isolate of the work it
+// does outside of JavaScript, see Isolate.Metrics.
+type EngineMetrics struct {
+	// The pauses of the isolate's thread for full garbage collections, and
+	// for the incremental marking and sweeping steps that lead up to them.
+	GCFullCycle            MetricHistogram
+	GCFullIncrementalMark  MetricHistogram
+	GCFullIncrementalSweep MetricHistogram
+	// GCFullFreed is the number of bytes freed by full garbage collections.
+	GCFullFreed uint64
+	// The pauses for garbage collections of the young generation.
+	GCYoungCycle MetricHistogram
+
+	// The decoding, compilation, instantiation and tier up of WebAssembly
+	// modules.
+	WasmModuleDecoded      MetricHistogram
+	WasmModuleCompiled     MetricHistogram
+	WasmModuleInstantiated MetricHistogram
+	WasmModuleTieredUp     MetricHistogram
+	// WasmModules is the number of WebAssembly modules of the isolate, as V8
+	// last reported it.
+	WasmModules uint64
+}
+
+// Metrics returns the engine metrics that V8 has recorded for the isolate
+// since it was created. V8 delivers the events of WebAssembly modules about a
+// second after they happen, by foreground tasks that Metrics does not run:
+// they are counted once Isolate.RunPendingTasks or Context.RunTimers has run
+// them.
+func (i *Isolate) Metrics() EngineMetrics {
+	rtn := C.IsolateMetrics(i.ptr)
+	hist := func(kind C.MetricKind) MetricHistogram {
+		return newMetricHistogram(&rtn.histograms[kind], time.Microsecond)
+	}
+	return EngineMetrics{
+		GCFullCycle:            hist(C.METRIC_GC_FULL_CYCLE),
+		GCFullIncrementalMark:  hist(C.METRIC_GC_FULL_INCREMENTAL_MARK),
+		GCFullIncrementalSweep: hist(C.METRIC_GC_FULL_INCREMENTAL_SWEEP),
+		GCFullFreed:            uint64(rtn.gcFullFreed),
+		GCYoungCycle:           hist(C.METRIC_GC_YOUNG_CYCLE),
+		WasmModuleDecoded:      hist(C.METRIC_WASM_MODULE_DECODED),
+		WasmModuleCompiled:     hist(C.METRIC_WASM_MODULE_COMPILED),
+		WasmModuleInstantiated: hist(C.METRIC_WASM_MODULE_INSTANTIATED),
+		WasmModuleTieredUp:     hist(C.METRIC_WASM_MODULE_TIERED_UP),
+		WasmModules:            uint64(rtn.wasmModules),
+	}
+}
+
+// RunPendingTasks runs the foreground tasks that V8 has posted for the
+// isolate, until there are none, and returns whether it ran any. The tasks
+// can run JavaScript, such as the cleanups of a FinalizationRegistry, so it
+// must be called where the scripts of the isolate may run.
+func (i *Isolate) RunPendingTasks() bool {
+	return C.IsolateRunPendingTasks(i.ptr) != 0
+}
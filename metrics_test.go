@@ -0,0 +1,71 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func checkHistogram(t *testing.T, name string, h v8.MetricHistogram) {
+	t.Helper()
+	if h.Count == 0 {
+		t.Errorf("expected %s events, got %+v", name, h)
+		return
+	}
+	var n uint64
+	for _, b := range h.Buckets {
+		n += b
+	}
+	if n != h.Count || h.Min > h.Max || h.Mean() < h.Min || h.Mean() > h.Max {
+		t.Errorf("inconsistent %s histogram %+v", name, h)
+	}
+}
+
+func TestIsolateMetricsGC(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	_, err := ctx.RunScript("var garbage = []; for (let i = 0; i < 2e5; i++) garbage.push({i}); garbage = null", "garbage.js")
+	fatalIf(t, err)
+	iso.LowMemoryNotification()
+	m := iso.Metrics()
+	checkHistogram(t, "GCYoungCycle", m.GCYoungCycle)
+	checkHistogram(t, "GCFullCycle", m.GCFullCycle)
+	if m.GCFullFreed == 0 {
+		t.Error("expected full collections to free the garbage")
+	}
+}
+
+func TestIsolateMetricsWasm(t *testing.T) {
+	t.Parallel()
+	skipWithoutWasm(t)
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	mod, err := ctx.CompileWasmModule(addWasm)
+	fatalIf(t, err)
+	callWasmAdd(t, ctx, mod)
+	var m v8.EngineMetrics
+	for deadline := time.Now().Add(10 * time.Second); ; time.Sleep(50 * time.Millisecond) {
+		iso.RunPendingTasks()
+		m = iso.Metrics()
+		if m.WasmModuleInstantiated.Count > 0 || time.Now().After(deadline) {
+			break
+		}
+	}
+	checkHistogram(t, "WasmModuleDecoded", m.WasmModuleDecoded)
+	checkHistogram(t, "WasmModuleCompiled", m.WasmModuleCompiled)
+	checkHistogram(t, "WasmModuleInstantiated", m.WasmModuleInstantiated)
+}
@@ -0,0 +1,191 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"fmt"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// ModuleStatus is the status of a Module, see Module.Status.
+type ModuleStatus int
+
+const (
+	ModuleUninstantiated ModuleStatus = iota
+	ModuleInstantiating
+	ModuleInstantiated
+	ModuleEvaluating
+	ModuleEvaluated
+	ModuleErrored
+)
+
+// Module is an ES module, compiled in a context with Context.CompileModule.
+// A module is instantiated and evaluated once, in the context it was compiled
+// in, and it lives until it is released or the context is closed.
+type Module struct {
+	ptr    C.ModulePtr
+	ctx    *Context
+	origin string
+}
+
+// ModuleResolver is called, while a module is being instantiated, for each
+// import statement of the module and its dependencies with the specifier that
+// is imported and the module that imports it. It returns the module to link,
+// which must have been compiled in the same context.
+type ModuleResolver func(specifier string, referrer *Module) (*Module, error)
+
+// moduleResolverRegistry maps refs to the ModuleResolver of Module.Instantiate
+// calls in progress.
+var moduleResolverMutex sync.Mutex
+var moduleResolverRegistry sync.Map
+var moduleResolverSeq = 0
+
+// CompileModule compiles source as an ES module; origin (a.k.a. filename)
+// identifies the module in stack traces and is returned by Module.Origin.
+// If opts contain a non-null CachedData, the compile will use that code cache,
+// which Module.CreateCodeCache creates.
+// error will be of type `JSError` if not nil.
+func (c *Context) CompileModule(source, origin string, opts CompileOptions) (*Module, error) {
+	rtn := C.ContextCompileModule(c.ptr, stringArg(source), stringArg(origin), opts.cOptions())
+	runtime.KeepAlive(source)
+	runtime.KeepAlive(origin)
+	if rtn.ptr == nil {
+		return nil, newJSError(rtn.error)
+	}
+	if opts.CachedData != nil {
+		opts.CachedData.Rejected = int(rtn.cachedDataRejected) == 1
+	}
+	m := &Module{ptr: rtn.ptr, ctx: c, origin: origin}
+	c.modules.Store(m.ptr, m)
+	return m, nil
+}
+
+// Origin returns the origin the module was compiled with.
+func (m *Module) Origin() string {
+	return m.origin
+}
+
+// Context returns the context the module was compiled in.
+func (m *Module) Context() *Context {
+	return m.ctx
+}
+
+// Status returns the status of the module.
+func (m *Module) Status() ModuleStatus {
+	return ModuleStatus(C.ModuleGetStatus(m.ptr))
+}
+
+// Instantiate links the module to its dependencies, and them to theirs, with
+// the modules that resolve returns for their imports.
+// error will be of type `JSError` if not nil, including the errors returned
+// by resolve.
+func (m *Module) Instantiate(resolve ModuleResolver) error {
+	moduleResolverMutex.Lock()
+	moduleResolverSeq++
+	ref := moduleResolverSeq
+	moduleResolverMutex.Unlock()
+	moduleResolverRegistry.Store(ref, resolve)
+	defer moduleResolverRegistry.Delete(ref)
+
+	rtn := C.ModuleInstantiate(m.ptr, C.int(ref))
+	_, err := valueResult(m.ctx, rtn)
+	return err
+}
+
+// Evaluate runs the module, which must have been instantiated, and returns a
+// Promise that settles once it and its dependencies have been evaluated. The
+// promise is already settled unless a module in the graph uses top-level
+// await.
+// error will be of type `JSError` if not nil.
+func (m *Module) Evaluate() (*Value, error) {
+	rtn := C.ModuleEvaluate(m.ptr)
+	return valueResult(m.ctx, rtn)
+}
+
+// Namespace returns the module namespace object, whose properties are the
+// exports of the module. The module must have been instantiated.
+func (m *Module) Namespace() *Object {
+	if m.Status() < ModuleInstantiated {
+		panic("attempted to get the namespace of a module that has not been instantiated")
+	}
+	ptr := C.ModuleGetNamespace(m.ptr)
+	return &Object{newValue(m.ctx, ptr)}
+}
+
+// Exception returns the exception that the module threw, if its status is
+// ModuleErrored, and nil otherwise.
+func (m *Module) Exception() *Value {
+	if m.Status() != ModuleErrored {
+		return nil
+	}
+	ptr := C.ModuleGetException(m.ptr)
+	return newValue(m.ctx, ptr)
+}
+
+// CreateCodeCache creates a code cache from the module, to pass as CachedData
+// when it is compiled again. The module must not have been evaluated yet.
+func (m *Module) CreateCodeCache() *CompilerCachedData {
+	if m.Status() >= ModuleEvaluating {
+		panic("attempted to create a code cache from a module that has been evaluated")
+	}
+	rtn := C.ModuleCreateCodeCache(m.ptr)
+	cachedData := &CompilerCachedData{
+		Bytes: C.GoBytes(unsafe.Pointer(rtn.data), rtn.length),
+	}
+	C.ScriptCompilerCachedDataDelete(rtn)
+	return cachedData
+}
+
+// Release frees the module without waiting for its context to be closed. Modules
+// that import it keep it alive for as long as they live. The module must not be
+// used after it has been released; calling Release more than once is a no-op.
+func (m *Module) Release() {
+	if m == nil || m.ptr == nil {
+		return
+	}
+	m.ctx.modules.Delete(m.ptr)
+	C.ModuleRelease(m.ptr)
+	m.ptr = nil
+}
+
+//export goResolveModule
+func goResolveModule(ctxref int, resolverref int, specifier *C.char, specifierLen C.int, referrer C.ModulePtr) (rmod C.ModulePtr, rerr C.ValuePtr) {
+	ctx := getContext(ctxref)
+	v, ok := moduleResolverRegistry.Load(resolverref)
+	if !ok {
+		return nil, resolveError(ctx, errors.New("v8go: modules can only be imported while instantiating"))
+	}
+	resolve := v.(ModuleResolver)
+
+	var ref *Module
+	if r, ok := ctx.modules.Load(referrer); ok {
+		ref = r.(*Module)
+	}
+	m, err := resolve(C.GoStringN(specifier, specifierLen), ref)
+	if err != nil {
+		return nil, resolveError(ctx, err)
+	}
+	if m == nil || m.ctx.ptr != ctx.ptr {
+		return nil, resolveError(ctx, fmt.Errorf("v8go: no module in this context for %q", C.GoStringN(specifier, specifierLen)))
+	}
+	return m.ptr, nil
+}
+
+func resolveError(ctx *Context, err error) C.ValuePtr {
+	if verr, ok := err.(ValueError); ok {
+		return verr.value().ptr
+	}
+	errv, err := NewValue(ctx.iso, err.Error())
+	if err != nil {
+		panic(err)
+	}
+	return errv.ptr
+}
@@ -0,0 +1,203 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+import (
+	"errors"
+	"sync"
+)
+
+// ModuleLoader returns the source of the module that specifier names.
+type ModuleLoader func(specifier string) (source string, err error)
+
+// ModuleCacheConfig configures a ModuleCache.
+type ModuleCacheConfig struct {
+	// Load is called the first time a specifier is imported. It may be
+	// called from any goroutine when the cache handles dynamic imports.
+	Load ModuleLoader
+	// CodeCache, if set, persists the code caches of the modules. Otherwise
+	// they are only kept in memory, for the contexts of the isolate.
+	CodeCache *CodeCache
+}
+
+// ModuleCache loads and compiles the modules of an isolate, keyed by their
+// specifier. Specifiers are used as they are, whichever module imports them,
+// so they should be absolute. The source of each module is loaded once, and
+// its compiled code is cached so that importing it in more contexts skips
+// compiling it again. ModuleCache is safe for concurrent use.
+type ModuleCache struct {
+	iso    *Isolate
+	config ModuleCacheConfig
+
+	mu      sync.Mutex
+	entries map[string]*moduleEntry
+}
+
+type moduleEntry struct {
+	once   sync.Once
+	source string
+	err    error
+
+	mu     sync.Mutex
+	cached *CompilerCachedData
+}
+
+// moduleImportKey is the key of the module that a ModuleCache imported for a
+// specifier in Context.imports.
+type moduleImportKey struct {
+	cache     *ModuleCache
+	specifier string
+}
+
+// NewModuleCache creates a module cache for the contexts of iso.
+func NewModuleCache(iso *Isolate, config ModuleCacheConfig) *ModuleCache {
+	if config.Load == nil {
+		panic("v8go: ModuleCacheConfig.Load must be set")
+	}
+	return &ModuleCache{
+		iso:     iso,
+		config:  config,
+		entries: make(map[string]*moduleEntry),
+	}
+}
+
+// Module returns the module that specifier names in ctx, compiling it the first
+// time it is used in ctx.
+// error will be of type `JSError` if not nil, unless loading the module failed.
+func (c *ModuleCache) Module(ctx *Context, specifier string) (*Module, error) {
+	if ctx.iso != c.iso {
+		panic("attempted to use a module cache in a context that belongs to a different isolate")
+	}
+	key := moduleImportKey{c, specifier}
+	if m, ok := ctx.imports.Load(key); ok {
+		return m.(*Module), nil
+	}
+
+	e := c.load(specifier)
+	if e.err != nil {
+		return nil, e.err
+	}
+
+	m, err := c.compile(ctx, specifier, e)
+	if err != nil {
+		return nil, err
+	}
+	if prev, loaded := ctx.imports.LoadOrStore(key, m); loaded {
+		m.Release()
+		return prev.(*Module), nil
+	}
+	return m, nil
+}
+
+func (c *ModuleCache) compile(ctx *Context, specifier string, e *moduleEntry) (*Module, error) {
+	if c.config.CodeCache != nil {
+		return c.config.CodeCache.CompileModule(ctx, e.source, specifier, CompileOptions{})
+	}
+
+	e.mu.Lock()
+	cached := e.cached
+	e.mu.Unlock()
+	if cached != nil {
+		// Each compile gets its own CompilerCachedData for its Rejected result.
+		opt := &CompilerCachedData{Bytes: cached.Bytes}
+		m, err := ctx.CompileModule(e.source, specifier, CompileOptions{CachedData: opt})
+		if err != nil || !opt.Rejected {
+			return m, err
+		}
+		m.Release()
+	}
+
+	m, err := ctx.CompileModule(e.source, specifier, CompileOptions{})
+	if err != nil {
+		return nil, err
+	}
+	e.mu.Lock()
+	e.cached = m.CreateCodeCache()
+	e.mu.Unlock()
+	return m, nil
+}
+
+// Resolve is a ModuleResolver that imports modules from the cache, in the
+// context of the module that imports them.
+func (c *ModuleCache) Resolve(specifier string, referrer *Module) (*Module, error) {
+	if referrer == nil {
+		return nil, errors.New("v8go: unknown referrer for " + specifier)
+	}
+	return c.Module(referrer.Context(), specifier)
+}
+
+// Import returns the module that specifier names in ctx, instantiated with the
+// modules of the cache and evaluated. A module that is already instantiated in
+// ctx is returned as it is. Use Module, Module.Instantiate and Module.Evaluate
+// to wait for the evaluation of modules that use top-level await.
+// error will be of type `JSError` if not nil, unless loading a module failed.
+func (c *ModuleCache) Import(ctx *Context, specifier string) (*Module, error) {
+	m, err := c.Module(ctx, specifier)
+	if err != nil {
+		return nil, err
+	}
+	if m.Status() != ModuleUninstantiated {
+		return m, nil
+	}
+	if err := m.Instantiate(c.Resolve); err != nil {
+		return nil, err
+	}
+	val, err := m.Evaluate()
+	if err != nil {
+		return nil, err
+	}
+	if p, err := val.AsPromise(); err == nil && p.State() == Rejected {
+		return nil, newJSErrorFromValue(p.Result())
+	}
+	if m.Status() == ModuleErrored {
+		return nil, newJSErrorFromValue(m.Exception())
+	}
+	return m, nil
+}
+
+// DynamicImport is a DynamicImportHandler that imports modules from the cache.
+// The module that is imported is loaded on a goroutine of its own, and it is
+// compiled, linked and evaluated in the importing context at the next
+// microtask checkpoint, when the modules it imports are loaded if they have
+// not been yet.
+func (c *ModuleCache) DynamicImport(imp *DynamicImport) {
+	if imp.Context().iso != c.iso {
+		imp.Reject(errors.New("v8go: module cache of a different isolate"))
+		return
+	}
+	go func() {
+		if e := c.load(imp.Specifier); e.err != nil {
+			imp.Reject(e.err)
+			return
+		}
+		imp.Finish(func() (*Module, error) {
+			return c.Import(imp.Context(), imp.Specifier)
+		})
+	}()
+}
+
+// Delete forgets the module that specifier names, so that the next context to
+// import it loads and compiles it again. Contexts that have already imported it
+// keep their modules, since a module can not be linked again.
+func (c *ModuleCache) Delete(specifier string) {
+	c.mu.Lock()
+	delete(c.entries, specifier)
+	c.mu.Unlock()
+}
+
+// load returns the entry of specifier, loading its source the first time.
+func (c *ModuleCache) load(specifier string) *moduleEntry {
+	c.mu.Lock()
+	e, ok := c.entries[specifier]
+	if !ok {
+		e = &moduleEntry{}
+		c.entries[specifier] = e
+	}
+	c.mu.Unlock()
+	e.once.Do(func() {
+		e.source, e.err = c.config.Load(specifier)
+	})
+	return e
+}
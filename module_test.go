@@ -0,0 +1,221 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"errors"
+	"fmt"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestModule(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	dep, err := ctx.CompileModule("export const answer = 42;", "dep.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	main, err := ctx.CompileModule("import { answer } from 'dep'; export const double = answer * 2;", "main.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	if main.Origin() != "main.js" || main.Status() != v8.ModuleUninstantiated {
+		t.Fatalf("unexpected origin %q or status %v", main.Origin(), main.Status())
+	}
+
+	var referrers []string
+	fatalIf(t, main.Instantiate(func(specifier string, referrer *v8.Module) (*v8.Module, error) {
+		referrers = append(referrers, referrer.Origin())
+		if specifier != "dep" {
+			return nil, fmt.Errorf("unknown module %q", specifier)
+		}
+		return dep, nil
+	}))
+	if len(referrers) != 1 || referrers[0] != "main.js" {
+		t.Errorf("unexpected referrers: %v", referrers)
+	}
+	if main.Status() != v8.ModuleInstantiated {
+		t.Errorf("expected the module to be instantiated, got %v", main.Status())
+	}
+
+	val, err := main.Evaluate()
+	fatalIf(t, err)
+	if !val.IsPromise() {
+		t.Errorf("expected a promise, got %v", val)
+	}
+	double, err := main.Namespace().Get("double")
+	fatalIf(t, err)
+	if double.Integer() != 84 {
+		t.Errorf("expected 84, got %v", double)
+	}
+	if main.Status() != v8.ModuleEvaluated || main.Exception() != nil {
+		t.Errorf("expected the module to be evaluated, got %v", main.Status())
+	}
+}
+
+func TestModuleErrors(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	if _, err := ctx.CompileModule("export const = ;", "bad.js", v8.CompileOptions{}); err == nil {
+		t.Error("expected a syntax error")
+	}
+
+	m, err := ctx.CompileModule("import 'missing';", "main.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	err = m.Instantiate(func(specifier string, referrer *v8.Module) (*v8.Module, error) {
+		return nil, errors.New("no such module: " + specifier)
+	})
+	if err == nil || !strings.Contains(err.Error(), "no such module: missing") {
+		t.Errorf("expected the resolver's error, got %v", err)
+	}
+
+	thrower, err := ctx.CompileModule("throw new Error('boom');", "throw.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	fatalIf(t, thrower.Instantiate(nil))
+	val, err := thrower.Evaluate()
+	fatalIf(t, err)
+	p, err := val.AsPromise()
+	fatalIf(t, err)
+	if p.State() != v8.Rejected || thrower.Status() != v8.ModuleErrored {
+		t.Errorf("expected the module to have errored, got %v", thrower.Status())
+	}
+	if ex := thrower.Exception(); ex == nil || !strings.Contains(ex.String(), "boom") {
+		t.Errorf("unexpected exception: %v", ex)
+	}
+}
+
+func TestModuleCodeCache(t *testing.T) {
+	t.Parallel()
+
+	const source = "export function greet(name) { return 'hello ' + name; }"
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	m, err := ctx.CompileModule(source, "greet.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	cachedData := m.CreateCodeCache()
+	m.Release()
+	m.Release()
+
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	ctx2 := v8.NewContext(iso2)
+	defer ctx2.Close()
+	m2, err := ctx2.CompileModule(source, "greet.js", v8.CompileOptions{CachedData: cachedData})
+	fatalIf(t, err)
+	if cachedData.Rejected {
+		t.Error("expected the code cache to be accepted")
+	}
+	fatalIf(t, m2.Instantiate(nil))
+	_, err = m2.Evaluate()
+	fatalIf(t, err)
+}
+
+func TestModuleCache(t *testing.T) {
+	t.Parallel()
+
+	sources := map[string]string{
+		"/main.js": "import { add } from '/math.js'; import { one } from '/one.js'; export const two = add(one, one);",
+		"/math.js": "import { one } from '/one.js'; export function add(a, b) { return a + b + one - one; }",
+		"/one.js":  "export const one = 1;",
+	}
+	loads := map[string]int{}
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	cache := v8.NewModuleCache(iso, v8.ModuleCacheConfig{
+		Load: func(specifier string) (string, error) {
+			loads[specifier]++
+			source, ok := sources[specifier]
+			if !ok {
+				return "", fmt.Errorf("no such module: %s", specifier)
+			}
+			return source, nil
+		},
+	})
+
+	for i := 0; i < 2; i++ {
+		ctx := v8.NewContext(iso)
+		m, err := cache.Import(ctx, "/main.js")
+		fatalIf(t, err)
+		two, err := m.Namespace().Get("two")
+		fatalIf(t, err)
+		if two.Integer() != 2 {
+			t.Errorf("expected 2, got %v", two)
+		}
+		again, err := cache.Import(ctx, "/main.js")
+		fatalIf(t, err)
+		if again != m {
+			t.Error("expected the module imported in the context to be reused")
+		}
+		ctx.Close()
+	}
+	for specifier, n := range loads {
+		if n != 1 {
+			t.Errorf("expected %s to be loaded once, got %d", specifier, n)
+		}
+	}
+
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	if _, err := cache.Import(ctx, "/missing.js"); err == nil {
+		t.Error("expected an error importing a missing module")
+	}
+
+	sources["/one.js"] = "export const one = 2;"
+	cache.Delete("/one.js")
+	m, err := cache.Import(ctx, "/main.js")
+	fatalIf(t, err)
+	two, err := m.Namespace().Get("two")
+	fatalIf(t, err)
+	if two.Integer() != 4 {
+		t.Errorf("expected the reloaded module to be used, got %v", two)
+	}
+
+	sources["/throw.js"] = "throw new Error('boom');"
+	if _, err := cache.Import(ctx, "/throw.js"); err == nil || !strings.Contains(err.Error(), "boom") {
+		t.Errorf("expected the module's error, got %v", err)
+	}
+}
+
+func TestModuleCacheCodeCache(t *testing.T) {
+	t.Parallel()
+
+	codeCache, err := v8.NewCodeCache(t.TempDir())
+	fatalIf(t, err)
+	defer codeCache.Close()
+
+	for i := 0; i < 2; i++ {
+		iso := v8.NewIsolate()
+		cache := v8.NewModuleCache(iso, v8.ModuleCacheConfig{
+			Load: func(specifier string) (string, error) {
+				return "export default 'cached';", nil
+			},
+			CodeCache: codeCache,
+		})
+		ctx := v8.NewContext(iso)
+		m, err := cache.Import(ctx, "/mod.js")
+		fatalIf(t, err)
+		val, err := m.Namespace().Get("default")
+		fatalIf(t, err)
+		if val.String() != "cached" {
+			t.Errorf("expected cached, got %v", val)
+		}
+		ctx.Close()
+		iso.Dispose()
+	}
+	if s := codeCache.Stats(); s.Misses != 1 || s.Hits != 1 {
+		t.Errorf("unexpected code cache stats: %+v", s)
+	}
+}
@@ -0,0 +1,170 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"fmt"
+	"io/ioutil"
+	"path/filepath"
+	"runtime"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"syscall"
+	"unsafe"
+)
+
+// NUMANode is a NUMA node of the machine, a socket or a part of one, whose
+// CPUs share the memory closest to them.
+type NUMANode struct {
+	ID   int
+	CPUs []int
+}
+
+var numaNodes struct {
+	once  sync.Once
+	nodes []NUMANode
+	// byCPU maps each CPU to the index of its node in nodes.
+	byCPU map[int]int
+}
+
+// NUMANodes returns the NUMA nodes of the machine that have CPUs, as Linux
+// reports them in sysfs. Elsewhere, or if they cannot be read, it returns a
+// single node of the CPUs of the process.
+func NUMANodes() []NUMANode {
+	numaNodes.once.Do(func() {
+		numaNodes.nodes = readNUMANodes("/sys/devices/system/node")
+		if len(numaNodes.nodes) == 0 {
+			cpus, _ := threadAffinity()
+			numaNodes.nodes = []NUMANode{{ID: 0, CPUs: cpus}}
+		}
+		numaNodes.byCPU = make(map[int]int)
+		for i, node := range numaNodes.nodes {
+			for _, cpu := range node.CPUs {
+				numaNodes.byCPU[cpu] = i
+			}
+		}
+	})
+	return numaNodes.nodes
+}
+
+func readNUMANodes(dir string) []NUMANode {
+	paths, _ := filepath.Glob(filepath.Join(dir, "node[0-9]*"))
+	var nodes []NUMANode
+	for _, path := range paths {
+		id, err := strconv.Atoi(strings.TrimPrefix(filepath.Base(path), "node"))
+		if err != nil {
+			continue
+		}
+		list, err := ioutil.ReadFile(filepath.Join(path, "cpulist"))
+		if err != nil {
+			continue
+		}
+		cpus, err := parseCPUList(string(list))
+		if err != nil || len(cpus) == 0 {
+			continue
+		}
+		nodes = append(nodes, NUMANode{ID: id, CPUs: cpus})
+	}
+	sort.Slice(nodes, func(i, j int) bool { return nodes[i].ID < nodes[j].ID })
+	return nodes
+}
+
+// parseCPUList parses a list of CPUs in the format of sysfs, such as
+// "0-3,8,10-11".
+func parseCPUList(list string) ([]int, error) {
+	var cpus []int
+	for _, r := range strings.Split(strings.TrimSpace(list), ",") {
+		if r == "" {
+			continue
+		}
+		lo, hi := r, r
+		if i := strings.IndexByte(r, '-'); i >= 0 {
+			lo, hi = r[:i], r[i+1:]
+		}
+		first, err := strconv.Atoi(lo)
+		if err != nil {
+			return nil, fmt.Errorf("v8go: bad CPU list %q", list)
+		}
+		last, err := strconv.Atoi(hi)
+		if err != nil || last < first {
+			return nil, fmt.Errorf("v8go: bad CPU list %q", list)
+		}
+		for cpu := first; cpu <= last; cpu++ {
+			cpus = append(cpus, cpu)
+		}
+	}
+	return cpus, nil
+}
+
+// currentNUMANode returns the index in NUMANodes of the node of the CPU that
+// the calling thread runs on, or 0 if it is unknown.
+func currentNUMANode() int {
+	NUMANodes()
+	return numaNodes.byCPU[currentCPU()]
+}
+
+// currentCPU returns the CPU that the calling thread runs on, or -1 if it is
+// unknown.
+func currentCPU() int {
+	return int(C.ThreadCurrentCPU())
+}
+
+func threadAffinity() ([]int, error) {
+	cpus := make([]int32, 256)
+	for {
+		n := int(C.ThreadAffinity((*C.int)(unsafe.Pointer(&cpus[0])), C.int(len(cpus))))
+		if n < 0 {
+			return nil, syscall.ENOSYS
+		}
+		if n <= len(cpus) {
+			rtn := make([]int, n)
+			for i := range rtn {
+				rtn[i] = int(cpus[i])
+			}
+			return rtn, nil
+		}
+		cpus = make([]int32, n)
+	}
+}
+
+func setThreadAffinity(cpus []int) error {
+	if len(cpus) == 0 {
+		return syscall.EINVAL
+	}
+	c := make([]int32, len(cpus))
+	for i, cpu := range cpus {
+		c[i] = int32(cpu)
+	}
+	if errno := C.ThreadSetAffinity((*C.int)(unsafe.Pointer(&c[0])), C.int(len(c))); errno != 0 {
+		return syscall.Errno(errno)
+	}
+	return nil
+}
+
+// LockOSThreadToNode locks the calling goroutine to its operating system
+// thread, like runtime.LockOSThread, and restricts the thread to the CPUs of
+// node, so that the isolates it creates and runs touch the memory of the node
+// first, which Linux then allocates on the node. unlock restores the CPUs
+// that the thread could run on before, and unlocks the goroutine from it. It
+// is only supported on Linux.
+func LockOSThreadToNode(node NUMANode) (unlock func(), err error) {
+	runtime.LockOSThread()
+	prev, err := threadAffinity()
+	if err == nil {
+		err = setThreadAffinity(node.CPUs)
+	}
+	if err != nil {
+		runtime.UnlockOSThread()
+		return nil, fmt.Errorf("v8go: pinning to NUMA node %d: %w", node.ID, err)
+	}
+	return func() {
+		setThreadAffinity(prev)
+		runtime.UnlockOSThread()
+	}, nil
+}
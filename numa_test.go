@@ -0,0 +1,98 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"reflect"
+	"runtime"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestNUMANodes(t *testing.T) {
+	t.Parallel()
+
+	nodes := v8.NUMANodes()
+	if len(nodes) == 0 {
+		t.Fatal("expected a node")
+	}
+	seen := map[int]bool{}
+	for _, node := range nodes {
+		if len(node.CPUs) == 0 && runtime.GOOS == "linux" {
+			t.Errorf("expected node %d to have CPUs", node.ID)
+		}
+		for _, cpu := range node.CPUs {
+			if seen[cpu] {
+				t.Errorf("expected CPU %d in one node", cpu)
+			}
+			seen[cpu] = true
+		}
+	}
+}
+
+func TestReadNUMANodes(t *testing.T) {
+	t.Parallel()
+
+	dir, err := ioutil.TempDir("", "v8go-numa")
+	fatalIf(t, err)
+	defer os.RemoveAll(dir)
+	for name, list := range map[string]string{
+		"node1":  "4-7,12\n",
+		"node0":  "0-3,8,10-11\n",
+		"node2":  "\n",
+		"online": "0-2\n",
+	} {
+		fatalIf(t, os.MkdirAll(filepath.Join(dir, name), 0o755))
+		fatalIf(t, ioutil.WriteFile(filepath.Join(dir, name, "cpulist"), []byte(list), 0o644))
+	}
+	want := []v8.NUMANode{
+		{ID: 0, CPUs: []int{0, 1, 2, 3, 8, 10, 11}},
+		{ID: 1, CPUs: []int{4, 5, 6, 7, 12}},
+	}
+	if got := v8.ReadNUMANodes(dir); !reflect.DeepEqual(got, want) {
+		t.Errorf("expected %v, got %v", want, got)
+	}
+	if _, err := v8.ParseCPUList("3-1"); err == nil {
+		t.Error("expected an error for a backwards range")
+	}
+}
+
+func TestLockOSThreadToNode(t *testing.T) {
+	if runtime.GOOS != "linux" {
+		t.Skip("CPU affinity is only supported on Linux")
+	}
+	t.Parallel()
+
+	before, err := v8.ThreadAffinity()
+	fatalIf(t, err)
+	// A node of a single CPU shows where the thread runs.
+	cpu := before[len(before)-1]
+	unlock, err := v8.LockOSThreadToNode(v8.NUMANode{CPUs: []int{cpu}})
+	fatalIf(t, err)
+	got, err := v8.ThreadAffinity()
+	fatalIf(t, err)
+	if !reflect.DeepEqual(got, []int{cpu}) || v8.CurrentCPU() != cpu {
+		t.Errorf("expected the thread to run on CPU %d, got %v on %d", cpu, got, v8.CurrentCPU())
+	}
+	iso := v8.NewIsolate()
+	ctx := v8.NewContext(iso)
+	_, err = ctx.RunScript("1 + 1", "node.js")
+	fatalIf(t, err)
+	ctx.Close()
+	iso.Dispose()
+	unlock()
+
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+	after, err := v8.ThreadAffinity()
+	fatalIf(t, err)
+	if !reflect.DeepEqual(after, before) {
+		t.Errorf("expected the CPUs to be restored to %v, got %v", before, after)
+	}
+}
@@ -10,6 +10,7 @@ import "C"
 import (
 	"fmt"
 	"math/big"
+	"runtime"
 	"unsafe"
 )
 
@@ -61,6 +62,8 @@ func (o *Object) Set(key string, val interface{}) error {
 	ckey := C.CString(key)
 	defer C.free(unsafe.Pointer(ckey))
 	C.ObjectSet(o.ptr, ckey, value.ptr)
+	runtime.KeepAlive(o)
+	runtime.KeepAlive(value)
 	return nil
 }
 
@@ -75,6 +78,23 @@ func (o *Object) SetSymbol(key *Symbol, val interface{}) error {
 	}
 
 	C.ObjectSetAnyKey(o.ptr, key.ptr, value.ptr)
+	runtime.KeepAlive(o)
+	runtime.KeepAlive(key)
+	runtime.KeepAlive(value)
+	return nil
+}
+
+// SetKey will set a property on the Object to a given value, like Set.
+func (o *Object) SetKey(key *PropertyKey, val interface{}) error {
+	value, err := coerceValue(o.ctx.iso, val)
+	if err != nil {
+		return err
+	}
+
+	C.ObjectSetAnyKey(o.ptr, key.ptr, value.ptr)
+	runtime.KeepAlive(o)
+	runtime.KeepAlive(key)
+	runtime.KeepAlive(value)
 	return nil
 }
 
@@ -89,6 +109,8 @@ func (o *Object) SetIdx(idx uint32, val interface{}) error {
 	}
 
 	C.ObjectSetIdx(o.ptr, C.uint32_t(idx), value.ptr)
+	runtime.KeepAlive(o)
+	runtime.KeepAlive(value)
 
 	return nil
 }
@@ -103,6 +125,8 @@ func (o *Object) SetInternalField(idx uint32, val interface{}) error {
 	}
 
 	inserted := C.ObjectSetInternalField(o.ptr, C.int(idx), value.ptr)
+	runtime.KeepAlive(o)
+	runtime.KeepAlive(value)
 
 	if inserted == 0 {
 		panic(fmt.Errorf("index out of range [%v] with length %v", idx, o.InternalFieldCount()))
@@ -111,6 +135,26 @@ func (o *Object) SetInternalField(idx uint32, val interface{}) error {
 	return nil
 }
 
+// SetAlignedPointerInInternalField stores the handle h in an internal field,
+// from which GetAlignedPointerFromInternalField reads it back without a lookup
+// by object or a V8 value being created, so that the callbacks of methods can
+// find the Go value of their receiver, info.This(), in constant time.
+// Panics if the index isn't in the range set by (*ObjectTemplate).SetInternalFieldCount.
+func (o *Object) SetAlignedPointerInInternalField(idx uint32, h Handle) {
+	if C.ObjectSetAlignedPointerInInternalField(o.ptr, C.int(idx), C.uintptr_t(h)) == 0 {
+		panic(fmt.Errorf("index out of range [%v] with length %v", idx, o.InternalFieldCount()))
+	}
+}
+
+// GetAlignedPointerFromInternalField returns the handle stored in an internal
+// field by SetAlignedPointerInInternalField, or the zero Handle if the field
+// holds a value or the index is out of range. A field set by SetInternalField
+// to a small integer cannot be told from a handle, so fields should hold
+// either handles or values, not both.
+func (o *Object) GetAlignedPointerFromInternalField(idx uint32) Handle {
+	return Handle(C.ObjectGetAlignedPointerFromInternalField(o.ptr, C.int(idx)))
+}
+
 // InternalFieldCount returns the number of internal fields this Object has.
 func (o *Object) InternalFieldCount() uint32 {
 	count := C.ObjectInternalFieldCount(o.ptr)
@@ -129,6 +173,14 @@ func (o *Object) Get(key string) (*Value, error) {
 // GetSymbol tries to get a Value for a given Object property key.
 func (o *Object) GetSymbol(key *Symbol) (*Value, error) {
 	rtn := C.ObjectGetAnyKey(o.ptr, key.ptr)
+	runtime.KeepAlive(key)
+	return valueResult(o.ctx, rtn)
+}
+
+// GetKey tries to get a Value for a given Object property key, like Get.
+func (o *Object) GetKey(key *PropertyKey) (*Value, error) {
+	rtn := C.ObjectGetAnyKey(o.ptr, key.ptr)
+	runtime.KeepAlive(key)
 	return valueResult(o.ctx, rtn)
 }
 
@@ -140,7 +192,7 @@ func (o *Object) GetInternalField(idx uint32) *Value {
 	if rtn == nil {
 		panic(fmt.Errorf("index out of range [%v] with length %v", idx, o.InternalFieldCount()))
 	}
-	return &Value{rtn, o.ctx}
+	return newValue(o.ctx, rtn)
 }
 
 // GetIdx tries to get a Value at a give Object index.
@@ -160,7 +212,17 @@ func (o *Object) Has(key string) bool {
 // HasSymbol calls the abstract operation HasProperty(O, P) described in ECMA-262, 7.3.10.
 // Returns true, if the object has the property, either own or on the prototype chain.
 func (o *Object) HasSymbol(key *Symbol) bool {
-	return C.ObjectHasAnyKey(o.ptr, key.ptr) != 0
+	has := C.ObjectHasAnyKey(o.ptr, key.ptr) != 0
+	runtime.KeepAlive(key)
+	return has
+}
+
+// HasKey calls the abstract operation HasProperty(O, P) described in ECMA-262, 7.3.10.
+// Returns true, if the object has the property, either own or on the prototype chain.
+func (o *Object) HasKey(key *PropertyKey) bool {
+	has := C.ObjectHasAnyKey(o.ptr, key.ptr) != 0
+	runtime.KeepAlive(key)
+	return has
 }
 
 // HasIdx returns true if the object has a value at the given index.
@@ -177,10 +239,55 @@ func (o *Object) Delete(key string) bool {
 
 // DeleteSymbol returns true if successful in deleting a named property on the object.
 func (o *Object) DeleteSymbol(key *Symbol) bool {
-	return C.ObjectDeleteAnyKey(o.ptr, key.ptr) != 0
+	deleted := C.ObjectDeleteAnyKey(o.ptr, key.ptr) != 0
+	runtime.KeepAlive(key)
+	return deleted
+}
+
+// DeleteKey returns true if successful in deleting a named property on the object.
+func (o *Object) DeleteKey(key *PropertyKey) bool {
+	deleted := C.ObjectDeleteAnyKey(o.ptr, key.ptr) != 0
+	runtime.KeepAlive(key)
+	return deleted
 }
 
 // DeleteIdx returns true if successful in deleting a value at a given index of the object.
 func (o *Object) DeleteIdx(idx uint32) bool {
 	return C.ObjectDeleteIdx(o.ptr, C.uint32_t(idx)) != 0
 }
+
+// CopyFloat64 copies the first len(dst) elements of an Array or TypedArray to
+// dst, converted as by Number(), and returns the number of elements copied,
+// which is fewer if the array is shorter. The elements are read within V8
+// rather than by a GetIdx for each, and the TypedArrays other than
+// BigInt64Array and BigUint64Array are copied without converting each
+// element to a Value. If an element throws as it is converted, the elements
+// before it are copied.
+func (o *Object) CopyFloat64(dst []float64) (int, error) {
+	var ptr *C.double
+	if len(dst) > 0 {
+		ptr = (*C.double)(unsafe.Pointer(&dst[0]))
+	}
+	var done C.size_t
+	rtn := C.ObjectCopyFloat64(o.ptr, ptr, C.size_t(len(dst)), &done)
+	if hasError(rtn) {
+		return int(done), newJSError(rtn)
+	}
+	return int(done), nil
+}
+
+// CopyInt32 copies the first len(dst) elements of an Array or TypedArray to
+// dst, converted as by the bitwise operators of JavaScript, such as x|0, in
+// the same way as CopyFloat64.
+func (o *Object) CopyInt32(dst []int32) (int, error) {
+	var ptr *C.int32_t
+	if len(dst) > 0 {
+		ptr = (*C.int32_t)(unsafe.Pointer(&dst[0]))
+	}
+	var done C.size_t
+	rtn := C.ObjectCopyInt32(o.ptr, ptr, C.size_t(len(dst)), &done)
+	if hasError(rtn) {
+		return int(done), newJSError(rtn)
+	}
+	return int(done), nil
+}
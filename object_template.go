@@ -41,11 +41,16 @@ func NewObjectTemplate(iso *Isolate) *ObjectTemplate {
 		panic("nil Isolate argument not supported")
 	}
 
+	return newObjectTemplate(iso, C.NewObjectTemplate(iso.ptr))
+}
+
+func newObjectTemplate(iso *Isolate, ptr C.TemplatePtr) *ObjectTemplate {
 	tmpl := &template{
-		ptr: C.NewObjectTemplate(iso.ptr),
+		ptr: ptr,
 		iso: iso,
 	}
 	runtime.SetFinalizer(tmpl, (*template).finalizer)
+	iso.trackTemplate(tmpl)
 	return &ObjectTemplate{tmpl}
 }
 
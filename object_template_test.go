@@ -5,6 +5,7 @@
 package v8go_test
 
 import (
+	"fmt"
 	"math/big"
 	"runtime"
 	"testing"
@@ -159,6 +160,73 @@ func TestObjectTemplateNewInstance(t *testing.T) {
 	}
 }
 
+func TestObjectTemplateSetLazy(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	var calls int
+	ns := v8.NewObjectTemplate(iso)
+	fatalIf(t, ns.Set("version", "1.0"))
+	fatalIf(t, ns.Set("call", v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		calls++
+		return nil
+	})))
+	global := v8.NewObjectTemplate(iso)
+	fatalIf(t, global.SetLazy("api", ns))
+	fatalIf(t, global.SetLazy("fn", v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		val, _ := v8.NewValue(iso, "called")
+		return val
+	})))
+	if err := global.SetLazy("value", "string"); err == nil {
+		t.Error("expected an error for a value that is not a template")
+	}
+
+	for i := 0; i < 2; i++ {
+		ctx := v8.NewContext(iso, global)
+		val, err := ctx.RunScript("api.call(); [api.version, api === api, fn(), Object.getOwnPropertyDescriptor(this, 'api').writable].join()", "lazy.js")
+		fatalIf(t, err)
+		if want := "1.0,true,called,true"; val.String() != want {
+			t.Errorf("expected %q, got %q", want, val.String())
+		}
+		ctx.Close()
+	}
+	if calls != 2 {
+		t.Errorf("expected 2 calls, got %v", calls)
+	}
+}
+
+func BenchmarkNewContextGlobals(b *testing.B) {
+	for _, lazy := range []bool{false, true} {
+		b.Run(fmt.Sprintf("lazy=%v", lazy), func(b *testing.B) {
+			iso := v8.NewIsolate()
+			defer iso.Dispose()
+			global := v8.NewObjectTemplate(iso)
+			for i := 0; i < 50; i++ {
+				ns := v8.NewObjectTemplate(iso)
+				for j := 0; j < 40; j++ {
+					ns.Set(fmt.Sprintf("fn%d", j), v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+						return nil
+					}))
+				}
+				name := fmt.Sprintf("ns%d", i)
+				if lazy {
+					global.SetLazy(name, ns)
+				} else {
+					global.Set(name, ns)
+				}
+			}
+			b.ResetTimer()
+			for n := 0; n < b.N; n++ {
+				ctx := v8.NewContext(iso, global)
+				ctx.RunScript("ns0.fn0()", "use.js")
+				ctx.Close()
+			}
+		})
+	}
+}
+
 func TestObjectTemplate_garbageCollection(t *testing.T) {
 	t.Parallel()
 
@@ -6,6 +6,8 @@ package v8go_test
 
 import (
 	"fmt"
+	"math"
+	"runtime"
 	"testing"
 
 	v8 "rogchap.com/v8go"
@@ -92,6 +94,44 @@ func TestObjectSet(t *testing.T) {
 	}
 }
 
+func TestObjectSetUnderGC(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.ReleaseUnreachableValues)
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	o := ctx.Global()
+	done := make(chan struct{})
+	stopped := make(chan struct{})
+	go func() {
+		defer close(stopped)
+		for {
+			select {
+			case <-done:
+				return
+			default:
+				runtime.GC()
+			}
+		}
+	}()
+	// Each value is unreachable from Go once its pointer is passed to Set,
+	// and must not be released by its finalizer until the call returns.
+	for i := 0; i < 100000; i++ {
+		v, err := ctx.RunScript("'v'+1", "gc.js")
+		fatalIf(t, err)
+		fatalIf(t, o.Set("k", v))
+	}
+	close(done)
+	<-stopped
+	k, err := o.Get("k")
+	fatalIf(t, err)
+	if k.String() != "v1" {
+		t.Errorf("expected \"v1\", got %q", k.String())
+	}
+}
+
 func TestObjectInternalFields(t *testing.T) {
 	iso := v8.NewIsolate()
 	defer iso.Dispose()
@@ -139,6 +179,91 @@ func TestObjectInternalFields(t *testing.T) {
 	}
 }
 
+func TestObjectAlignedPointerInInternalField(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	type counter struct{ n int32 }
+	tmpl := v8.NewObjectTemplate(iso)
+	tmpl.SetInternalFieldCount(2)
+	incr := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		c := info.This().GetAlignedPointerFromInternalField(0).Value().(*counter)
+		c.n++
+		val, _ := v8.NewValue(iso, c.n)
+		return val
+	})
+	fatalIf(t, tmpl.Set("incr", incr))
+
+	c := &counter{}
+	h := v8.NewHandle(c)
+	defer h.Delete()
+	obj, err := tmpl.NewInstance(ctx)
+	fatalIf(t, err)
+	if got := obj.GetAlignedPointerFromInternalField(0); got != 0 {
+		t.Errorf("expected the zero Handle for an unset field, got %v", got)
+	}
+	obj.SetAlignedPointerInInternalField(0, h)
+	if got := obj.GetAlignedPointerFromInternalField(0); got != h {
+		t.Errorf("expected %v, got %v", h, got)
+	}
+	fatalIf(t, obj.SetInternalField(1, "value"))
+	if got := obj.GetAlignedPointerFromInternalField(1); got != 0 {
+		t.Errorf("expected the zero Handle for a field holding a value, got %v", got)
+	}
+	if got := obj.GetAlignedPointerFromInternalField(2); got != 0 {
+		t.Errorf("expected the zero Handle out of range, got %v", got)
+	}
+	if recoverPanic(func() { obj.SetAlignedPointerInInternalField(2, h) }) == nil {
+		t.Error("expected panic from index out of bounds")
+	}
+
+	fatalIf(t, ctx.Global().Set("counter", obj))
+	val, err := ctx.RunScript("counter.incr(); counter.incr(); counter.incr()", "incr.js")
+	fatalIf(t, err)
+	if val.Int32() != 3 || c.n != 3 {
+		t.Errorf("expected 3 calls, got %v and %v", val, c.n)
+	}
+}
+
+func TestExternal(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	h := v8.NewHandle("go value")
+	ext := v8.NewExternal(iso, h)
+	if !ext.IsExternal() {
+		t.Error("expected an External value")
+	}
+	fatalIf(t, ctx.Global().Set("ext", ext))
+	val, err := ctx.RunScript("[ext, 1]", "ext.js")
+	fatalIf(t, err)
+	obj, err := val.AsObject()
+	fatalIf(t, err)
+	got, err := obj.GetIdx(0)
+	fatalIf(t, err)
+	if got.External().Value() != "go value" {
+		t.Errorf("unexpected value: %v", got.External().Value())
+	}
+	num, err := obj.GetIdx(1)
+	fatalIf(t, err)
+	if num.IsExternal() || num.External() != 0 {
+		t.Error("expected a number not to be an External")
+	}
+
+	h.Delete()
+	if recoverPanic(func() { h.Value() }) == nil {
+		t.Error("expected panic from a deleted Handle")
+	}
+}
+
 func TestObjectGet(t *testing.T) {
 	t.Parallel()
 
@@ -225,6 +350,111 @@ func TestObjectDelete(t *testing.T) {
 
 }
 
+func TestObjectPropertyKey(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	key := v8.NewPropertyKey(iso, "bär")
+
+	// A key can be used with objects from any context of its isolate.
+	for i := 0; i < 2; i++ {
+		ctx := v8.NewContext(iso)
+		val, _ := ctx.RunScript("({ 'bär': 'baz' })", "")
+		obj, _ := val.AsObject()
+
+		if !obj.HasKey(key) {
+			t.Error("expected property to exist")
+		}
+		got, err := obj.GetKey(key)
+		fatalIf(t, err)
+		if got.String() != "baz" {
+			t.Errorf("unexpected value: %q", got)
+		}
+		fatalIf(t, obj.SetKey(key, "qux"))
+		if got, _ := obj.Get("bär"); got.String() != "qux" {
+			t.Errorf("unexpected value after SetKey: %q", got)
+		}
+		if !obj.DeleteKey(key) || obj.HasKey(key) {
+			t.Error("expected property to be deleted")
+		}
+		ctx.Close()
+	}
+	if key.String() != "bär" {
+		t.Errorf("unexpected key string: %q", key)
+	}
+}
+
+func TestObjectCopyNumbers(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	tests := [...]struct {
+		source  string
+		float64 []float64
+		int32   []int32
+	}{
+		{"[1, 2.5, -3, 2**31]", []float64{1, 2.5, -3, 1 << 31}, []int32{1, 2, -3, -1 << 31}},
+		{"['4', null, , {valueOf: () => 7}]", []float64{4, 0, math.NaN(), 7}, []int32{4, 0, 0, 7}},
+		{"new Float64Array([1.5, -2, 1e10])", []float64{1.5, -2, 1e10}, []int32{1, -2, 1410065408}},
+		{"new Float32Array([0.5, 3])", []float64{0.5, 3}, []int32{0, 3}},
+		{"new Int32Array([-1, 2, 3])", []float64{-1, 2, 3}, []int32{-1, 2, 3}},
+		{"new Uint32Array([2**32-1, 5])", []float64{1<<32 - 1, 5}, []int32{-1, 5}},
+		{"new Int8Array([-128, 127])", []float64{-128, 127}, []int32{-128, 127}},
+		{"new Uint8Array([255, 0, 1])", []float64{255, 0, 1}, []int32{255, 0, 1}},
+		{"new Uint16Array(new Uint8Array([1, 2, 3, 4, 5, 6]).buffer, 2, 2)", []float64{0x0403, 0x0605}, []int32{0x0403, 0x0605}},
+	}
+	for _, tt := range tests {
+		val, err := ctx.RunScript(tt.source, "")
+		fatalIf(t, err)
+		obj, _ := val.AsObject()
+
+		// A longer slice is filled up to the length of the array.
+		floats := make([]float64, len(tt.float64)+1)
+		n, err := obj.CopyFloat64(floats)
+		fatalIf(t, err)
+		if n != len(tt.float64) {
+			t.Errorf("%s: CopyFloat64 copied %d elements", tt.source, n)
+		}
+		for i, want := range tt.float64 {
+			if got := floats[i]; got != want && !(math.IsNaN(got) && math.IsNaN(want)) {
+				t.Errorf("%s: CopyFloat64 element %d = %v, want %v", tt.source, i, got, want)
+			}
+		}
+
+		// A shorter slice gets the first elements.
+		ints := make([]int32, len(tt.int32)-1)
+		n, err = obj.CopyInt32(ints)
+		fatalIf(t, err)
+		if n != len(ints) {
+			t.Errorf("%s: CopyInt32 copied %d elements", tt.source, n)
+		}
+		for i, got := range ints {
+			if got != tt.int32[i] {
+				t.Errorf("%s: CopyInt32 element %d = %v, want %v", tt.source, i, got, tt.int32[i])
+			}
+		}
+	}
+
+	val, _ := ctx.RunScript("[1, 2, {valueOf() { throw new Error('nope') }}, 4]", "")
+	obj, _ := val.AsObject()
+	floats := make([]float64, 4)
+	if n, err := obj.CopyFloat64(floats); err == nil || n != 2 || floats[1] != 2 {
+		t.Errorf("expected an error after 2 elements, got %d, %v", n, err)
+	}
+	val, _ = ctx.RunScript("new BigInt64Array([1n])", "")
+	obj, _ = val.AsObject()
+	if _, err := obj.CopyInt32(make([]int32, 1)); err == nil {
+		t.Error("expected an error for a BigInt64Array")
+	}
+	if _, err := ctx.Global().CopyFloat64(floats); err == nil {
+		t.Error("expected an error for an object that is not an array")
+	}
+}
+
 func ExampleObject_global() {
 	iso := v8.NewIsolate()
 	defer iso.Dispose()
@@ -245,3 +475,52 @@ func ExampleObject_global() {
 	// Output:
 	// foo
 }
+
+func BenchmarkObjectGet(b *testing.B) {
+	b.ReportAllocs()
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+	val, _ := ctx.RunScript("({ name: 'v8go', count: 1 })", "obj.js")
+	obj, _ := val.AsObject()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		ctx.WithValueScope(func(*v8.ValueScope) {
+			if _, err := obj.Get("count"); err != nil {
+				b.Fatal(err)
+			}
+		})
+	}
+}
+
+func BenchmarkObjectSet(b *testing.B) {
+	b.ReportAllocs()
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+	obj := ctx.Global()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		ctx.WithValueScope(func(*v8.ValueScope) {
+			if err := obj.Set("count", int32(n)); err != nil {
+				b.Fatal(err)
+			}
+		})
+	}
+}
+
+func BenchmarkObjectCopyFloat64(b *testing.B) {
+	b.ReportAllocs()
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+	val, _ := ctx.RunScript("Array.from({length: 100000}, (_, i) => i / 2)", "array.js")
+	obj, _ := val.AsObject()
+	dst := make([]float64, 100000)
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		if _, err := obj.CopyFloat64(dst); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
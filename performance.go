@@ -0,0 +1,27 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import "time"
+
+// Performance installs a performance object in the global object of the
+// context, whose now method returns the milliseconds since the context was
+// created by a monotonic clock, and whose timeOrigin is the time it was
+// created at in milliseconds since the Unix epoch. Both are rounded down to a
+// multiple of resolution, if it is positive, to coarsen the timers of
+// untrusted code.
+//
+// performance.now is implemented natively, without calling into Go, and
+// optimized code calls it through the V8 Fast API when the
+// --turbo-fast-api-calls flag is set, see SetFlags. Date.now is native in V8
+// already.
+func Performance(resolution time.Duration) ContextOption {
+	return contextOptionFunc(func(opts *contextOptions) {
+		opts.performance = true
+		opts.timerResolution = resolution
+	})
+}
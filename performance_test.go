@@ -0,0 +1,76 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"math"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestPerformance(t *testing.T) {
+	v8.SetFlags("--turbo-fast-api-calls", "--allow-natives-syntax")
+	defer v8.SetFlags("--noturbo-fast-api-calls", "--noallow-natives-syntax")
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Performance(0))
+	defer ctx.Close()
+
+	start := float64(time.Now().UnixNano()) / 1e6
+	time.Sleep(5 * time.Millisecond)
+	val, err := ctx.RunScript(`
+		function f() { return performance.now(); }
+		%PrepareFunctionForOptimization(f);
+		f();
+		%OptimizeFunctionOnNextCall(f);
+		const a = f(), b = f();
+		[a, b - a, performance.timeOrigin]`, "performance.js")
+	fatalIf(t, err)
+	obj := val.Object()
+	now, _ := obj.GetIdx(0)
+	diff, _ := obj.GetIdx(1)
+	origin, _ := obj.GetIdx(2)
+	if now.Number() < 5 || now.Number() > 5000 {
+		t.Errorf("expected about 5ms since the context was created, got %v", now.Number())
+	}
+	if diff.Number() < 0 {
+		t.Errorf("expected a monotonic clock, got %v", diff.Number())
+	}
+	if math.Abs(origin.Number()-start) > 1000 {
+		t.Errorf("expected a time origin about %v, got %v", start, origin.Number())
+	}
+
+	_, err = ctx.RunScript(`const now = performance.now; now()`, "receiver.js")
+	if err == nil {
+		t.Error("expected an error for performance.now without its receiver")
+	}
+
+	coarse := v8.NewContext(iso, v8.Performance(100*time.Millisecond))
+	defer coarse.Close()
+	val, err = coarse.RunScript(`[performance.now(), performance.timeOrigin].every((t) => t % 100 === 0)`, "coarse.js")
+	fatalIf(t, err)
+	if !val.Boolean() {
+		t.Error("expected times coarsened to 100ms")
+	}
+}
+
+func BenchmarkPerformanceNow(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.Performance(0))
+	defer ctx.Close()
+	fn, _ := ctx.RunScript(`(n) => { let t = 0; for (let i = 0; i < n; i++) t += performance.now(); return t; }`, "bench.js")
+	f, _ := fn.AsFunction()
+	n, _ := v8.NewValue(iso, int32(1000))
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := f.Call(v8.Undefined(iso), n); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
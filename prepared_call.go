@@ -0,0 +1,149 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"runtime"
+	"unsafe"
+)
+
+// PreparedCall is a call of a function with a fixed receiver and number of
+// arguments that is made over and over, see Function.Prepare. Its argument
+// slots are kept in V8's memory and written from Go in place, so that each
+// call takes a single cgo call and, with primitive arguments and CallNumber,
+// allocates no more than the cgo call itself.
+//
+// Arguments keep their values between calls and are undefined until set. A
+// PreparedCall belongs to the context of its function, and must not be used
+// after Release is called or the context is closed.
+type PreparedCall struct {
+	ptr    C.PreparedCallPtr
+	ctx    *Context
+	args   []C.CallbackArg
+	values []C.ValuePtr
+	// kept are the Values of the arguments set with SetValue, which must not
+	// be released by a finalizer while they are arguments.
+	kept []*Value
+}
+
+// Prepare prepares a call of this function with recv and argc arguments.
+func (fn *Function) Prepare(recv Valuer, argc int) *PreparedCall {
+	if argc < 0 {
+		panic("v8go: negative argument count")
+	}
+	rtn := C.FunctionPrepareCall(fn.ptr, recv.value().ptr, C.int(argc))
+	runtime.KeepAlive(recv)
+	c := &PreparedCall{ptr: rtn.ptr, ctx: fn.ctx}
+	if argc > 0 {
+		c.args = (*[1 << 28]C.CallbackArg)(unsafe.Pointer(rtn.args))[:argc:argc]
+		c.values = (*[1 << 28]C.ValuePtr)(unsafe.Pointer(rtn.values))[:argc:argc]
+		c.kept = make([]*Value, argc)
+	}
+	return c
+}
+
+// Len returns the number of arguments of the call.
+func (c *PreparedCall) Len() int {
+	return len(c.args)
+}
+
+// SetUndefined sets the nth argument to undefined.
+func (c *PreparedCall) SetUndefined(n int) {
+	c.args[n].kind = C.CALLBACK_ARG_UNDEFINED
+}
+
+// SetNull sets the nth argument to null.
+func (c *PreparedCall) SetNull(n int) {
+	c.args[n].kind = C.CALLBACK_ARG_NULL
+}
+
+// SetBoolean sets the nth argument to the boolean v.
+func (c *PreparedCall) SetBoolean(n int, v bool) {
+	arg := &c.args[n]
+	arg.kind = C.CALLBACK_ARG_BOOLEAN
+	arg.int32 = 0
+	if v {
+		arg.int32 = 1
+	}
+}
+
+// SetInt32 sets the nth argument to the number v.
+func (c *PreparedCall) SetInt32(n int, v int32) {
+	arg := &c.args[n]
+	arg.kind = C.CALLBACK_ARG_INT32
+	arg.int32 = C.int32_t(v)
+}
+
+// SetNumber sets the nth argument to the number v.
+func (c *PreparedCall) SetNumber(n int, v float64) {
+	arg := &c.args[n]
+	arg.kind = C.CALLBACK_ARG_NUMBER
+	arg.number = C.double(v)
+}
+
+// SetString sets the nth argument to the string v. Strings of more than 64
+// bytes are created as values first, which allocates.
+func (c *PreparedCall) SetString(n int, v string) {
+	arg := &c.args[n]
+	if len(v) > C.CALLBACK_ARG_STRING_MAX {
+		val, err := NewValue(c.ctx.iso, v)
+		if err != nil {
+			panic(err)
+		}
+		c.SetValue(n, val)
+		return
+	}
+	data := (*[C.CALLBACK_ARG_STRING_MAX]byte)(unsafe.Pointer(&arg.data[0]))
+	arg.kind = C.CALLBACK_ARG_STRING
+	arg.length = C.int(copy(data[:], v))
+}
+
+// SetValue sets the nth argument to the value v, which must stay valid for
+// as long as it is the argument.
+func (c *PreparedCall) SetValue(n int, v Valuer) {
+	c.args[n].kind = C.CALLBACK_ARG_VALUE
+	c.kept[n] = v.value()
+	c.values[n] = c.kept[n].ptr
+}
+
+// Call makes the call with the arguments that are set.
+// error will be of type `JSError` if not nil.
+func (c *PreparedCall) Call() (*Value, error) {
+	ptr := c.preparedCall()
+	rtn := C.PreparedCallInvoke(ptr)
+	return valueResult(c.ctx, rtn)
+}
+
+// CallNumber makes the call and converts its result to a number, without
+// creating a value for it.
+func (c *PreparedCall) CallNumber() (float64, error) {
+	ptr := c.preparedCall()
+	rtn := C.PreparedCallInvokeNumber(ptr)
+	if hasError(rtn.error) {
+		return 0, newJSError(rtn.error)
+	}
+	return float64(rtn.number), nil
+}
+
+// Release frees the call before its context is closed.
+func (c *PreparedCall) Release() {
+	if c.ptr == nil {
+		return
+	}
+	C.PreparedCallRelease(c.ptr)
+	c.ptr = nil
+	c.args = nil
+	c.values = nil
+	c.kept = nil
+}
+
+func (c *PreparedCall) preparedCall() C.PreparedCallPtr {
+	if c.ptr == nil {
+		panic("v8go: PreparedCall used after Release")
+	}
+	return c.ptr
+}
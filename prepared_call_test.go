@@ -0,0 +1,132 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestPreparedCall(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript(`(function(...args) {
+		if (args[0] === "throw") throw new Error("thrown");
+		return this.prefix + args.map(a => typeof a + ":" + a).join(",");
+	})`, "describe.js")
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	recv, err := ctx.RunScript(`({prefix: ">"})`, "recv.js")
+	fatalIf(t, err)
+	obj, err := ctx.RunScript("[1, 2]", "obj.js")
+	fatalIf(t, err)
+
+	call := fn.Prepare(recv, 7)
+	defer call.Release()
+	if call.Len() != 7 {
+		t.Errorf("expected 7 arguments, got %v", call.Len())
+	}
+	call.SetNull(1)
+	call.SetBoolean(2, true)
+	call.SetInt32(3, -7)
+	call.SetNumber(4, 1.5)
+	call.SetString(5, "héllo")
+	call.SetValue(6, obj)
+	res, err := call.Call()
+	fatalIf(t, err)
+	if want := ">undefined:undefined,object:null,boolean:true,number:-7,number:1.5,string:héllo,object:1,2"; res.String() != want {
+		t.Errorf("expected %q, got %q", want, res.String())
+	}
+
+	long := strings.Repeat("x", 100)
+	call.SetString(0, long)
+	call.SetUndefined(6)
+	res, err = call.Call()
+	fatalIf(t, err)
+	if !strings.HasPrefix(res.String(), ">string:"+long+",") || !strings.HasSuffix(res.String(), "undefined:undefined") {
+		t.Errorf("unexpected result %q", res.String())
+	}
+
+	call.SetString(0, "throw")
+	if _, err := call.Call(); err == nil || err.Error() != "Error: thrown" {
+		t.Errorf("expected the exception of the call, got %v", err)
+	}
+	if _, err := call.CallNumber(); err == nil {
+		t.Error("expected the exception of the call")
+	}
+}
+
+func TestPreparedCallNumber(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	val, err := ctx.RunScript("(function(a, b) { return a * b })", "mul.js")
+	fatalIf(t, err)
+	fn, err := val.AsFunction()
+	fatalIf(t, err)
+	call := fn.Prepare(v8.Undefined(iso), 2)
+	call.SetInt32(1, 3)
+	for i := int32(0); i < 10; i++ {
+		call.SetInt32(0, i)
+		n, err := call.CallNumber()
+		fatalIf(t, err)
+		if n != float64(i*3) {
+			t.Errorf("expected %v, got %v", i*3, n)
+		}
+	}
+	// The one allocation is the cgo call's.
+	if allocs := testing.AllocsPerRun(100, func() { call.CallNumber() }); allocs > 1 {
+		t.Errorf("expected at most one allocation, got %v", allocs)
+	}
+
+	call.Release()
+	call.Release()
+	if err := recoverPanic(func() { call.CallNumber() }); err == nil {
+		t.Error("expected a panic for a released call")
+	}
+}
+
+func BenchmarkPreparedCall(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	val, _ := ctx.RunScript("(function(a, b) { return a + b })", "")
+	fn, _ := val.AsFunction()
+	recv := v8.Undefined(iso)
+
+	b.Run("Call", func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				a, _ := v8.NewValue(iso, int32(i))
+				res, _ := fn.Call(recv, a, a)
+				res.Number()
+			})
+		}
+	})
+	b.Run("Prepared", func(b *testing.B) {
+		b.ReportAllocs()
+		call := fn.Prepare(recv, 2)
+		defer call.Release()
+		for i := 0; i < b.N; i++ {
+			call.SetInt32(0, int32(i))
+			call.SetInt32(1, int32(i))
+			call.CallNumber()
+		}
+	})
+}
@@ -9,6 +9,7 @@ package v8go
 import "C"
 import (
 	"errors"
+	"runtime"
 )
 
 // PromiseState is the state of the Promise.
@@ -53,7 +54,7 @@ func NewPromiseResolver(ctx *Context) (*PromiseResolver, error) {
 func (r *PromiseResolver) GetPromise() *Promise {
 	if r.prom == nil {
 		ptr := C.PromiseResolverGetPromise(r.ptr)
-		val := &Value{ptr, r.ctx}
+		val := newValue(r.ctx, ptr)
 		r.prom = &Promise{&Object{val}}
 	}
 	return r.prom
@@ -62,13 +63,88 @@ func (r *PromiseResolver) GetPromise() *Promise {
 // Resolve invokes the Promise resolve state with the given value.
 // The Promise state will transition from Pending to Fulfilled.
 func (r *PromiseResolver) Resolve(val Valuer) bool {
-	return C.PromiseResolverResolve(r.ptr, val.value().ptr) != 0
+	resolved := C.PromiseResolverResolve(r.ptr, val.value().ptr) != 0
+	runtime.KeepAlive(val)
+	return resolved
 }
 
 // Reject invokes the Promise reject state with the given value.
 // The Promise state will transition from Pending to Rejected.
 func (r *PromiseResolver) Reject(err *Value) bool {
-	return C.PromiseResolverReject(r.ptr, err.ptr) != 0
+	rejected := C.PromiseResolverReject(r.ptr, err.ptr) != 0
+	runtime.KeepAlive(err)
+	return rejected
+}
+
+// ResolvePromises resolves the promise of each of resolvers with the value of
+// vals at the same index, like PromiseResolver.Resolve, taking the lock of the
+// isolate once for the whole batch. The resolvers must belong to the same
+// isolate. It returns the number of promises that were resolved.
+func ResolvePromises(resolvers []*PromiseResolver, vals []Valuer) int {
+	if len(resolvers) != len(vals) {
+		panic("v8go: ResolvePromises needs one value per resolver")
+	}
+	cVals := make([]C.ValuePtr, len(vals))
+	for i, val := range vals {
+		cVals[i] = val.value().ptr
+	}
+	n := settlePromises(resolvers, cVals, false)
+	runtime.KeepAlive(vals)
+	return n
+}
+
+// RejectPromises rejects the promise of each of resolvers with the error of
+// errs at the same index, like PromiseResolver.Reject, taking the lock of the
+// isolate once for the whole batch. The resolvers must belong to the same
+// isolate. It returns the number of promises that were rejected.
+func RejectPromises(resolvers []*PromiseResolver, errs []*Value) int {
+	if len(resolvers) != len(errs) {
+		panic("v8go: RejectPromises needs one error per resolver")
+	}
+	cVals := make([]C.ValuePtr, len(errs))
+	for i, err := range errs {
+		cVals[i] = err.ptr
+	}
+	n := settlePromises(resolvers, cVals, true)
+	runtime.KeepAlive(errs)
+	return n
+}
+
+func settlePromises(resolvers []*PromiseResolver, cVals []C.ValuePtr, reject bool) int {
+	if len(resolvers) == 0 {
+		return 0
+	}
+	cResolvers := make([]C.ValuePtr, len(resolvers))
+	for i, r := range resolvers {
+		cResolvers[i] = r.ptr
+	}
+	var cReject C.int
+	if reject {
+		cReject = 1
+	}
+	n := C.PromiseResolversSettle(&cResolvers[0], &cVals[0], C.int(len(resolvers)), cReject)
+	runtime.KeepAlive(resolvers)
+	return int(n)
+}
+
+// PromiseStates returns the states of promises, which must belong to the same
+// isolate, taking the lock of the isolate once for the whole batch. The states
+// are appended to dst, which can be reused from one call to the next.
+func PromiseStates(dst []PromiseState, promises []*Promise) []PromiseState {
+	if len(promises) == 0 {
+		return dst
+	}
+	cPromises := make([]C.ValuePtr, len(promises))
+	for i, p := range promises {
+		cPromises[i] = p.ptr
+	}
+	states := make([]C.int, len(promises))
+	C.PromiseStates(&cPromises[0], C.int(len(promises)), &states[0])
+	runtime.KeepAlive(promises)
+	for _, state := range states {
+		dst = append(dst, PromiseState(state))
+	}
+	return dst
 }
 
 // State returns the current state of the Promise.
@@ -81,7 +157,7 @@ func (p *Promise) State() PromiseState {
 // to validate state before calling for the result.
 func (p *Promise) Result() *Value {
 	ptr := C.PromiseResult(p.ptr)
-	val := &Value{ptr, p.ctx}
+	val := newValue(p.ctx, ptr)
 	return val
 }
 
@@ -93,6 +169,7 @@ func (p *Promise) Result() *Value {
 // V8 only invokes the callback when processing "microtasks".
 // The default MicrotaskPolicy processes them when the call depth decreases to 0.
 // Call (*Context).PerformMicrotaskCheckpoint to trigger it manually.
+// The callbacks are released once one of them has been called.
 func (p *Promise) Then(cbs ...FunctionCallback) *Promise {
 	cbwes := make([]FunctionCallbackWithError, len(cbs))
 	for i, cb := range cbs {
@@ -109,12 +186,11 @@ func (p *Promise) ThenWithError(cbs ...FunctionCallbackWithError) *Promise {
 	var rtn C.RtnValue
 	switch len(cbs) {
 	case 1:
-		cbID := p.ctx.iso.registerCallback(cbs[0])
-		rtn = C.PromiseThen(p.ptr, C.int(cbID))
+		refs := p.ctx.iso.registerContinuation(p.ctx, cbs[0])
+		rtn = C.PromiseThen(p.ptr, C.int(refs[0]))
 	case 2:
-		cbID1 := p.ctx.iso.registerCallback(cbs[0])
-		cbID2 := p.ctx.iso.registerCallback(cbs[1])
-		rtn = C.PromiseThen2(p.ptr, C.int(cbID1), C.int(cbID2))
+		refs := p.ctx.iso.registerContinuation(p.ctx, cbs[0], cbs[1])
+		rtn = C.PromiseThen2(p.ptr, C.int(refs[0]), C.int(refs[1]))
 
 	default:
 		panic("1 or 2 callbacks required")
@@ -135,8 +211,8 @@ func (p *Promise) Catch(cb FunctionCallback) *Promise {
 }
 
 func (p *Promise) CatchWithError(cb FunctionCallbackWithError) *Promise {
-	cbID := p.ctx.iso.registerCallback(cb)
-	rtn := C.PromiseCatch(p.ptr, C.int(cbID))
+	refs := p.ctx.iso.registerContinuation(p.ctx, cb)
+	rtn := C.PromiseCatch(p.ptr, C.int(refs[0]))
 	obj, err := objectResult(p.ctx, rtn)
 	if err != nil {
 		panic(err) // TODO: Return error
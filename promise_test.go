@@ -164,3 +164,139 @@ func TestPromiseThenPanic(t *testing.T) {
 		t.Errorf("expected a panic")
 	})
 }
+
+func TestPromiseBatch(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	const n = 500
+	resolvers := make([]*v8.PromiseResolver, n)
+	promises := make([]*v8.Promise, n)
+	for i := range resolvers {
+		r, err := v8.NewPromiseResolver(ctx)
+		fatalIf(t, err)
+		resolvers[i] = r
+		promises[i] = r.GetPromise()
+	}
+	for _, state := range v8.PromiseStates(nil, promises) {
+		if state != v8.Pending {
+			t.Fatalf("expected pending promises, got %v", state)
+		}
+	}
+
+	vals := make([]v8.Valuer, n/2)
+	errs := make([]*v8.Value, n/2)
+	for i := range vals {
+		val, err := v8.NewValue(iso, int32(i))
+		fatalIf(t, err)
+		vals[i] = val
+		errs[i] = v8.NewError(iso, "failed").Value
+	}
+	if got := v8.ResolvePromises(resolvers[:n/2], vals); got != n/2 {
+		t.Errorf("expected %d promises to be resolved, got %d", n/2, got)
+	}
+	if got := v8.RejectPromises(resolvers[n/2:], errs); got != n/2 {
+		t.Errorf("expected %d promises to be rejected, got %d", n/2, got)
+	}
+
+	states := v8.PromiseStates(make([]v8.PromiseState, 0, n), promises)
+	for i, state := range states {
+		want := v8.Fulfilled
+		if i >= n/2 {
+			want = v8.Rejected
+		}
+		if state != want {
+			t.Fatalf("expected promise %d to be %v, got %v", i, want, state)
+		}
+	}
+	if res := promises[7].Result(); res.Int32() != 7 {
+		t.Errorf("expected 7, got %v", res)
+	}
+}
+
+func BenchmarkPromiseBatch(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	val, _ := v8.NewValue(iso, "ok")
+	const n = 500
+	vals := make([]v8.Valuer, n)
+	for i := range vals {
+		vals[i] = val
+	}
+	resolvers := make([]*v8.PromiseResolver, n)
+	promises := make([]*v8.Promise, n)
+	var states []v8.PromiseState
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		ctx.WithValueScope(func(*v8.ValueScope) {
+			for j := range resolvers {
+				resolvers[j], _ = v8.NewPromiseResolver(ctx)
+				promises[j] = resolvers[j].GetPromise()
+			}
+			v8.ResolvePromises(resolvers, vals)
+			states = v8.PromiseStates(states[:0], promises)
+		})
+	}
+}
+
+func TestPromiseThenReleasesCallbacks(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	// Microtasks only run at checkpoints of a context with its own queue.
+	ctx := v8.NewContext(iso, v8.OwnMicrotaskQueue)
+	defer ctx.Close()
+
+	before := iso.CallbackCount()
+	var calls int
+	for i := 0; i < 100; i++ {
+		resolver, err := v8.NewPromiseResolver(ctx)
+		fatalIf(t, err)
+		prom := resolver.GetPromise()
+		prom.Then(func(info *v8.FunctionCallbackInfo) *v8.Value {
+			calls++
+			return info.Args()[0]
+		}, func(info *v8.FunctionCallbackInfo) *v8.Value {
+			t.Error("expected the promise to be fulfilled")
+			return nil
+		})
+		prom.Catch(func(info *v8.FunctionCallbackInfo) *v8.Value {
+			t.Error("expected the promise to be fulfilled")
+			return nil
+		})
+		val, _ := v8.NewValue(iso, int32(i))
+		resolver.Resolve(val)
+	}
+	if got := iso.CallbackCount() - before; got != 300 {
+		t.Fatalf("expected 300 pending callbacks, got %d", got)
+	}
+	ctx.PerformMicrotaskCheckpoint()
+	if calls != 100 {
+		t.Errorf("expected 100 calls, got %d", calls)
+	}
+	// The Catch continuations of fulfilled promises are never called.
+	if got := iso.CallbackCount() - before; got != 100 {
+		t.Errorf("expected the called continuations to be released, %d callbacks left", got)
+	}
+
+	// Continuations receive the value, and not the bound ref.
+	resolver, _ := v8.NewPromiseResolver(ctx)
+	var args []*v8.Value
+	resolver.GetPromise().Then(func(info *v8.FunctionCallbackInfo) *v8.Value {
+		args = info.Args()
+		return nil
+	})
+	val, _ := v8.NewValue(iso, "value")
+	resolver.Resolve(val)
+	ctx.PerformMicrotaskCheckpoint()
+	if len(args) != 1 || args[0].String() != "value" {
+		t.Errorf("expected the continuation to be called with the value, got %v", args)
+	}
+}
@@ -0,0 +1,38 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"fmt"
+	"unsafe"
+)
+
+// A PropertyKey is a property name that has been turned into an
+// internalized JS string once, for use with the *Key methods of Object.
+// Accessing a property by a PropertyKey does not need to copy the name to C or
+// to create a new JS string from it, so hot property names should be created
+// once per isolate and reused. A PropertyKey lives as long as its isolate.
+type PropertyKey struct {
+	*Value
+}
+
+// NewPropertyKey creates a PropertyKey for the property name.
+func NewPropertyKey(iso *Isolate, name string) *PropertyKey {
+	cname := C.CString(name)
+	defer C.free(unsafe.Pointer(cname))
+	ptr := C.NewPropertyKey(iso.ptr, cname, C.int(len(name)))
+	if ptr == nil {
+		panic(fmt.Errorf("v8go: failed to create property key of length %d", len(name)))
+	}
+	return &PropertyKey{newValue(nil, ptr)}
+}
+
+// value implements Valuer.
+func (k *PropertyKey) value() *Value {
+	return k.Value
+}
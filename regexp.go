@@ -0,0 +1,60 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"runtime"
+)
+
+// RegExpFlags are the flags of a RegExp, which can be or'ed together.
+type RegExpFlags int
+
+const (
+	RegExpGlobal     RegExpFlags = 1 << iota // g
+	RegExpIgnoreCase                         // i
+	RegExpMultiline                          // m
+	RegExpSticky                             // y
+	RegExpUnicode                            // u
+	RegExpDotAll                             // s
+	// RegExpLinear matches in time linear in the length of the subject, with
+	// the experimental engine of V8, which must be turned on for the process
+	// with the RegExpLinearEngine flag. The engine does not support
+	// backreferences, lookarounds or quantifiers over possibly empty
+	// expressions.
+	RegExpLinear     // l
+	RegExpHasIndices // d
+)
+
+// NewRegExp compiles pattern into a RegExp in the given context, as
+// new RegExp(pattern, flags) would.
+func NewRegExp(ctx *Context, pattern string, flags RegExpFlags) (*Object, error) {
+	return newRegExp(ctx, pattern, flags, 0)
+}
+
+// NewRegExpWithBacktrackLimit is NewRegExp for a RegExp that gives up and
+// fails to match once a single exec has backtracked more than limit times,
+// so that a pattern with catastrophic backtracking, such as /(a+)+$/, cannot
+// hold its isolate for long. With the RegExpBacktrackFallback flag, set for
+// the process, V8 retries the match with its linear-time engine instead, when
+// the pattern allows it.
+func NewRegExpWithBacktrackLimit(ctx *Context, pattern string, flags RegExpFlags, limit uint32) (*Object, error) {
+	if limit == 0 {
+		return nil, errors.New("v8go: RegExp backtrack limit must be positive")
+	}
+	return newRegExp(ctx, pattern, flags, limit)
+}
+
+func newRegExp(ctx *Context, pattern string, flags RegExpFlags, limit uint32) (*Object, error) {
+	if ctx == nil {
+		return nil, errors.New("v8go: Context is required")
+	}
+	rtn := C.NewRegExp(ctx.ptr, stringArg(pattern), C.int(flags), C.uint32_t(limit))
+	runtime.KeepAlive(pattern)
+	return objectResult(ctx, rtn)
+}
@@ -0,0 +1,102 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"os"
+	"os/exec"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+// backtracking is a pattern that backtracks exponentially in the length of
+// the a's of backtrackingSubject before its second alternative matches.
+const backtracking = "(a+)+c|a+b"
+
+var backtrackingSubject = strings.Repeat("a", 30) + "b"
+
+func TestNewRegExp(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	re, err := v8.NewRegExp(ctx, "a.c", v8.RegExpGlobal|v8.RegExpIgnoreCase)
+	fatalIf(t, err)
+	if !re.IsRegExp() {
+		t.Fatal("expected a RegExp")
+	}
+	fatalIf(t, ctx.Global().Set("re", re))
+	val, err := ctx.RunScript("re.flags + ' ' + re.source + ' ' + 'xAbCx'.match(re)", "regexp.js")
+	fatalIf(t, err)
+	if got := val.String(); got != "gi a.c AbC" {
+		t.Errorf("unexpected RegExp %q", got)
+	}
+
+	if _, err := v8.NewRegExp(ctx, "(", 0); err == nil || !strings.HasPrefix(err.Error(), "SyntaxError") {
+		t.Errorf("expected a SyntaxError, got %v", err)
+	}
+	if _, err := v8.NewRegExpWithBacktrackLimit(ctx, "a", 0, 0); err == nil {
+		t.Error("expected an error for a zero backtrack limit")
+	}
+	if _, err := v8.NewRegExp(nil, "a", 0); err == nil {
+		t.Error("expected an error without a context")
+	}
+}
+
+func TestNewRegExpWithBacktrackLimit(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	re, err := v8.NewRegExpWithBacktrackLimit(ctx, backtracking, 0, 1000)
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("re", re))
+	fatalIf(t, ctx.Global().Set("subject", backtrackingSubject))
+	val, err := ctx.RunScript("re.exec(subject)", "regexp.js")
+	fatalIf(t, err)
+	if !val.IsNull() {
+		t.Errorf("expected the match to fail at the backtrack limit, got %v", val)
+	}
+}
+
+// TestRegExpLinearEngine runs in a process of its own, as the flags are
+// global.
+func TestRegExpLinearEngine(t *testing.T) {
+	if os.Getenv("V8GO_TEST_REGEXP_FLAGS") == "" {
+		t.Parallel()
+		cmd := exec.Command(os.Args[0], "-test.run=^TestRegExpLinearEngine$", "-test.v")
+		cmd.Env = append(os.Environ(), "V8GO_TEST_REGEXP_FLAGS=1")
+		if out, err := cmd.CombinedOutput(); err != nil {
+			t.Fatalf("%v\n%s", err, out)
+		}
+		return
+	}
+
+	fatalIf(t, v8.SetEngineFlags(v8.RegExpLinearEngine(true), v8.RegExpBacktrackFallback(true)))
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	fatalIf(t, ctx.Global().Set("subject", backtrackingSubject))
+
+	linear, err := v8.NewRegExp(ctx, backtracking, v8.RegExpLinear)
+	fatalIf(t, err)
+	fallback, err := v8.NewRegExpWithBacktrackLimit(ctx, backtracking, 0, 1000)
+	fatalIf(t, err)
+	for name, re := range map[string]*v8.Object{"linear": linear, "fallback": fallback} {
+		fatalIf(t, ctx.Global().Set("re", re))
+		val, err := ctx.RunScript("String(re.exec(subject))", "regexp.js")
+		fatalIf(t, err)
+		if got := val.String(); got != backtrackingSubject+"," {
+			t.Errorf("expected the %s RegExp to match, got %q", name, got)
+		}
+	}
+}
@@ -0,0 +1,314 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"fmt"
+	"sync"
+	"time"
+)
+
+// ErrSchedulerClosed is returned by Scheduler.Do once the scheduler is closed.
+var ErrSchedulerClosed = errors.New("v8go: scheduler closed")
+
+// schedulerBatch is the most work a Scheduler runs per acquisition of the
+// isolate's lock, so that other users of the isolate get a turn.
+const schedulerBatch = 64
+
+// schedulerReclaimSlice is the number of values of the contexts closed with
+// Context.CloseDeferred that a Scheduler frees at a time while it is idle,
+// which takes in the order of a millisecond.
+const schedulerReclaimSlice = 16 << 10
+
+// Scheduler runs work for the contexts of an isolate that is submitted from
+// any number of goroutines. Rather than each goroutine waiting for the
+// isolate's V8 lock in turn, the work is queued and run back to back by one
+// goroutine, which holds the lock for a batch of work at a time, see
+// Isolate.Lock.
+//
+// Contexts take turns: the scheduler runs one piece of work of each context
+// that has work queued, in the order the contexts queued it, so that a busy
+// context does not hold up the others. While no work is queued, the scheduler
+// frees the values of contexts closed with Context.CloseDeferred.
+type Scheduler struct {
+	iso *Isolate
+
+	mutex  sync.Mutex
+	queues map[*Context]*schedulerQueue
+	ready  []*schedulerQueue
+	closed bool
+	stats  SchedulerStats
+
+	wake  chan struct{}
+	done  chan struct{}
+	owner bool
+}
+
+// SchedulerOption configures a Scheduler, see NewScheduler.
+type SchedulerOption interface {
+	apply(*Scheduler)
+}
+
+type schedulerOptionFunc func(*Scheduler)
+
+func (f schedulerOptionFunc) apply(s *Scheduler) {
+	f(s)
+}
+
+// OwnerThread makes the Scheduler the owner of its isolate: its goroutine is
+// locked to an operating system thread of its own, which takes the isolate's
+// lock once and holds it until the scheduler is closed, so that the isolate
+// stays entered on the one thread, along with its stack limit and thread
+// local caches. All use of the isolate, including the creation and closing of
+// its contexts, must then go through the scheduler's Do, and the scheduler
+// must be closed before the isolate is disposed.
+var OwnerThread SchedulerOption = schedulerOptionFunc(func(s *Scheduler) {
+	s.owner = true
+})
+
+// SchedulerStats are the counters of a Scheduler.
+type SchedulerStats struct {
+	// Items is the number of pieces of work that have run, and Batches the
+	// number of batches they ran in, each under one acquisition of the
+	// isolate's lock unless the scheduler owns it, see OwnerThread.
+	Items   uint64
+	Batches uint64
+	// The total and longest time that work waited in the queue, and took to
+	// run.
+	WaitTotal time.Duration
+	WaitMax   time.Duration
+	RunTotal  time.Duration
+	RunMax    time.Duration
+}
+
+type schedulerQueue struct {
+	ctx   *Context
+	items []*schedulerItem
+}
+
+type schedulerItem struct {
+	work   func(ctx *Context) error
+	queued time.Time
+	err    error
+	done   chan struct{}
+}
+
+// NewScheduler creates a Scheduler for the contexts of iso, which runs work
+// until it is closed.
+func NewScheduler(iso *Isolate, opts ...SchedulerOption) *Scheduler {
+	if iso == nil {
+		panic("nil Isolate argument not supported")
+	}
+	s := &Scheduler{
+		iso:    iso,
+		queues: make(map[*Context]*schedulerQueue),
+		wake:   make(chan struct{}, 1),
+		done:   make(chan struct{}),
+	}
+	for _, o := range opts {
+		if o != nil {
+			o.apply(s)
+		}
+	}
+	locked := make(chan struct{})
+	go s.run(locked)
+	<-locked
+	return s
+}
+
+// Do queues work to run with ctx, which must be a context of the scheduler's
+// isolate, and waits for it to return with an error of its own. A panic of
+// work is returned as an error. ctx is nil for work that is not bound to a
+// context, such as creating or closing contexts, which share a turn.
+//
+// A caller that holds the isolate's lock, such as scheduled work or a
+// callback of its scripts, would wait for itself if its work were queued: Do
+// runs that work at once instead, ahead of the queue.
+func (s *Scheduler) Do(ctx *Context, work func(ctx *Context) error) error {
+	if ctx != nil && ctx.iso != s.iso {
+		return errors.New("v8go: Context of the Scheduler's isolate is required")
+	}
+	item := &schedulerItem{work: work, queued: time.Now(), done: make(chan struct{})}
+	// Only a goroutine locked to the thread that holds the lock can see it
+	// held, so another goroutine never runs work inline.
+	inline := C.IsolateLockedByThread(s.iso.ptr) != 0
+
+	s.mutex.Lock()
+	if s.closed {
+		s.mutex.Unlock()
+		return ErrSchedulerClosed
+	}
+	if inline {
+		s.mutex.Unlock()
+		s.runItem(ctx, item, false)
+		return item.err
+	}
+	q := s.queues[ctx]
+	if q == nil {
+		q = &schedulerQueue{ctx: ctx}
+		s.queues[ctx] = q
+	}
+	q.items = append(q.items, item)
+	if len(q.items) == 1 {
+		s.ready = append(s.ready, q)
+	}
+	select {
+	case s.wake <- struct{}{}:
+	default:
+	}
+	s.mutex.Unlock()
+
+	<-item.done
+	return item.err
+}
+
+// Pending returns the number of pieces of work that are queued.
+func (s *Scheduler) Pending() int {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+	n := 0
+	for _, q := range s.ready {
+		n += len(q.items)
+	}
+	return n
+}
+
+// Stats returns the counters of the scheduler.
+func (s *Scheduler) Stats() SchedulerStats {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+	return s.stats
+}
+
+// Close stops the scheduler once the work that is running returns; work that
+// is still queued fails with ErrSchedulerClosed.
+func (s *Scheduler) Close() {
+	s.mutex.Lock()
+	if s.closed {
+		s.mutex.Unlock()
+		<-s.done
+		return
+	}
+	s.closed = true
+	close(s.wake)
+	s.mutex.Unlock()
+	<-s.done
+
+	s.mutex.Lock()
+	ready := s.ready
+	s.ready = nil
+	s.queues = nil
+	s.mutex.Unlock()
+	for _, q := range ready {
+		for _, item := range q.items {
+			item.err = ErrSchedulerClosed
+			close(item.done)
+		}
+	}
+}
+
+// next takes the first piece of work of the context whose turn it is.
+func (s *Scheduler) next() (*Context, *schedulerItem) {
+	s.mutex.Lock()
+	defer s.mutex.Unlock()
+	if s.closed || len(s.ready) == 0 {
+		return nil, nil
+	}
+	q := s.ready[0]
+	s.ready = s.ready[1:]
+	item := q.items[0]
+	q.items = q.items[1:]
+	if len(q.items) > 0 {
+		s.ready = append(s.ready, q)
+	} else {
+		delete(s.queues, q.ctx)
+	}
+	return q.ctx, item
+}
+
+// run runs the queued work once locked is closed, which for an
+// OwnerThread scheduler is once it holds the isolate's lock.
+func (s *Scheduler) run(locked chan struct{}) {
+	defer close(s.done)
+	if s.owner {
+		s.iso.Lock()
+		defer s.iso.Unlock()
+	}
+	close(locked)
+	for range s.wake {
+		for {
+			ctx, item := s.next()
+			if item == nil {
+				break
+			}
+			if !s.owner {
+				s.iso.Lock()
+			}
+			for n := 0; item != nil; n++ {
+				s.runItem(ctx, item, n == 0)
+				if n+1 == schedulerBatch {
+					break
+				}
+				ctx, item = s.next()
+			}
+			if !s.owner {
+				s.iso.Unlock()
+			}
+		}
+		for s.reclaim() {
+		}
+	}
+}
+
+// reclaim frees a slice of the values of the contexts closed with
+// Context.CloseDeferred unless work is queued, and reports whether values are
+// left to free.
+func (s *Scheduler) reclaim() bool {
+	s.mutex.Lock()
+	idle := !s.closed && len(s.ready) == 0
+	s.mutex.Unlock()
+	if !idle || s.iso.deadValues() == 0 {
+		return false
+	}
+	if !s.owner {
+		s.iso.Lock()
+		defer s.iso.Unlock()
+	}
+	return s.iso.ReclaimContexts(schedulerReclaimSlice) > 0
+}
+
+func (s *Scheduler) runItem(ctx *Context, item *schedulerItem, batch bool) {
+	start := time.Now()
+	func() {
+		defer func() {
+			if r := recover(); r != nil {
+				item.err = fmt.Errorf("v8go: scheduled work panicked: %v", r)
+			}
+		}()
+		item.err = item.work(ctx)
+	}()
+	end := time.Now()
+
+	s.mutex.Lock()
+	st := &s.stats
+	st.Items++
+	if batch {
+		st.Batches++
+	}
+	wait, ran := start.Sub(item.queued), end.Sub(start)
+	st.WaitTotal += wait
+	st.RunTotal += ran
+	if wait > st.WaitMax {
+		st.WaitMax = wait
+	}
+	if ran > st.RunMax {
+		st.RunMax = ran
+	}
+	s.mutex.Unlock()
+	close(item.done)
+}
@@ -0,0 +1,273 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"fmt"
+	"sync"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestScheduler(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	s := v8.NewScheduler(iso)
+	defer s.Close()
+
+	ctxs := make([]*v8.Context, 3)
+	for i := range ctxs {
+		ctxs[i] = v8.NewContext(iso)
+		defer ctxs[i].Close()
+		_, err := ctxs[i].RunScript("var n = 0", "init.js")
+		fatalIf(t, err)
+	}
+
+	var wg sync.WaitGroup
+	for g := 0; g < 30; g++ {
+		wg.Add(1)
+		go func(ctx *v8.Context) {
+			defer wg.Done()
+			for i := 0; i < 10; i++ {
+				err := s.Do(ctx, func(ctx *v8.Context) error {
+					_, err := ctx.RunScript("n++", "incr.js")
+					return err
+				})
+				if err != nil {
+					t.Error(err)
+				}
+			}
+		}(ctxs[g%len(ctxs)])
+	}
+	wg.Wait()
+
+	for i, ctx := range ctxs {
+		val, err := ctx.RunScript("n", "n.js")
+		fatalIf(t, err)
+		if val.Int32() != 100 {
+			t.Errorf("context %d: expected 100 runs, got %v", i, val)
+		}
+	}
+	stats := s.Stats()
+	if stats.Items != 300 || stats.Batches == 0 || stats.Batches > stats.Items {
+		t.Errorf("unexpected stats: %+v", stats)
+	}
+
+	if err := s.Do(ctxs[0], func(*v8.Context) error { panic("boom") }); err == nil {
+		t.Error("expected the panic to be returned as an error")
+	}
+	other := v8.NewContext()
+	defer other.Isolate().Dispose()
+	defer other.Close()
+	if err := s.Do(other, nil); err == nil {
+		t.Error("expected an error for a context of another isolate")
+	}
+}
+
+func TestSchedulerReentrantDo(t *testing.T) {
+	t.Parallel()
+
+	for _, opts := range [][]v8.SchedulerOption{nil, {v8.OwnerThread}} {
+		iso := v8.NewIsolate()
+		s := v8.NewScheduler(iso, opts...)
+		var ctx *v8.Context
+		fatalIf(t, s.Do(nil, func(*v8.Context) error {
+			ctx = v8.NewContext(iso)
+			return nil
+		}))
+
+		done := make(chan error)
+		go func() {
+			done <- s.Do(ctx, func(ctx *v8.Context) error {
+				// Work queued from scheduled work would wait for itself.
+				return s.Do(ctx, func(ctx *v8.Context) error {
+					_, err := ctx.RunScript("1 + 1", "nested.js")
+					return err
+				})
+			})
+		}()
+		select {
+		case err := <-done:
+			fatalIf(t, err)
+		case <-time.After(10 * time.Second):
+			t.Fatal("nested Do deadlocked")
+		}
+		fatalIf(t, s.Do(nil, func(*v8.Context) error {
+			ctx.Close()
+			return nil
+		}))
+		s.Close()
+		iso.Dispose()
+	}
+}
+
+func TestSchedulerOwnerThread(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	s := v8.NewScheduler(iso, v8.OwnerThread)
+	defer s.Close()
+	var ctx *v8.Context
+	fatalIf(t, s.Do(nil, func(*v8.Context) error {
+		ctx = v8.NewContext(iso)
+		return nil
+	}))
+	defer s.Do(nil, func(*v8.Context) error {
+		ctx.Close()
+		return nil
+	})
+
+	var wg sync.WaitGroup
+	for g := 0; g < 10; g++ {
+		wg.Add(1)
+		go func(g int) {
+			defer wg.Done()
+			err := s.Do(ctx, func(ctx *v8.Context) error {
+				// Nested sessions, such as those of Export, are cheap while the
+				// scheduler holds the lock.
+				val, err := ctx.RunScript(fmt.Sprintf("({g: %d, list: [1, 2, 3]})", g), "g.js")
+				if err != nil {
+					return err
+				}
+				_, err = val.Export()
+				return err
+			})
+			if err != nil {
+				t.Error(err)
+			}
+		}(g)
+	}
+	wg.Wait()
+	if items := s.Stats().Items; items != 11 {
+		t.Errorf("expected 11 items, got %v", items)
+	}
+}
+
+func TestSchedulerReclaimContexts(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	s := v8.NewScheduler(iso, v8.OwnerThread)
+	defer s.Close()
+	fatalIf(t, s.Do(nil, func(*v8.Context) error {
+		ctx := v8.NewContext(iso)
+		fillValues(t, ctx, 100000)
+		ctx.CloseDeferred()
+		return nil
+	}))
+	deadline := time.Now().Add(10 * time.Second)
+	for iso.DeadValues() > 0 {
+		if time.Now().After(deadline) {
+			t.Fatal("expected the idle scheduler to free the values")
+		}
+		time.Sleep(time.Millisecond)
+	}
+	fatalIf(t, s.Do(nil, func(*v8.Context) error {
+		if left := iso.ReclaimContexts(1); left != 0 {
+			t.Errorf("expected no values left, got %d", left)
+		}
+		return nil
+	}))
+}
+
+func BenchmarkScheduler(b *testing.B) {
+	for _, mode := range []string{"direct", "scheduler", "owner"} {
+		b.Run(mode, func(b *testing.B) {
+			iso := v8.NewIsolate()
+			defer iso.Dispose()
+			ctx := v8.NewContext(iso)
+			defer ctx.Close()
+			global := ctx.Global()
+			var s *v8.Scheduler
+			switch mode {
+			case "scheduler":
+				s = v8.NewScheduler(iso)
+			case "owner":
+				s = v8.NewScheduler(iso, v8.OwnerThread)
+			}
+			work := func(*v8.Context) error {
+				_, err := global.Get("Object")
+				return err
+			}
+			b.RunParallel(func(pb *testing.PB) {
+				for pb.Next() {
+					if s == nil {
+						work(ctx)
+					} else {
+						s.Do(ctx, work)
+					}
+				}
+			})
+			b.StopTimer()
+			if s != nil {
+				s.Close()
+			}
+		})
+	}
+}
+
+func TestSchedulerFairness(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	s := v8.NewScheduler(iso)
+	a, b := v8.NewContext(iso), v8.NewContext(iso)
+	defer a.Close()
+	defer b.Close()
+
+	release := make(chan struct{})
+	var mutex sync.Mutex
+	var order []string
+	record := func(name string) func(*v8.Context) error {
+		return func(*v8.Context) error {
+			mutex.Lock()
+			order = append(order, name)
+			mutex.Unlock()
+			return nil
+		}
+	}
+	var wg sync.WaitGroup
+	submit := func(ctx *v8.Context, work func(*v8.Context) error, pending int) {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			s.Do(ctx, work)
+		}()
+		for s.Pending() < pending {
+			time.Sleep(time.Millisecond)
+		}
+	}
+	// The first piece of work of a holds up the scheduler while the others
+	// are queued.
+	started := make(chan struct{})
+	submit(a, func(*v8.Context) error {
+		close(started)
+		<-release
+		return nil
+	}, 0)
+	<-started
+	for i := 1; i <= 3; i++ {
+		submit(a, record(fmt.Sprintf("a%d", i)), i)
+	}
+	submit(b, record("b1"), 4)
+	close(release)
+	wg.Wait()
+
+	if got := fmt.Sprint(order); got != "[a1 b1 a2 a3]" {
+		t.Errorf("expected the contexts to take turns, got %v", got)
+	}
+
+	s.Close()
+	if err := s.Do(a, record("closed")); err != v8.ErrSchedulerClosed {
+		t.Errorf("expected ErrSchedulerClosed, got %v", err)
+	}
+}
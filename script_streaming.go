@@ -0,0 +1,86 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"bytes"
+	"io"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// streamingSource is the state of a streaming compile, which V8 reads the
+// source of through goStreamingSourceRead.
+type streamingSource struct {
+	r io.Reader
+	// source is a copy of what has been read; V8 needs the full source to
+	// finish the compile.
+	source bytes.Buffer
+	err    error
+}
+
+// streamRegistry maps refs to the *streamingSource of streaming compiles.
+var streamMutex sync.Mutex
+var streamRegistry sync.Map
+var streamSeq = 0
+
+// CompileUnboundScriptStreaming creates an UnboundScript like
+// CompileUnboundScript does, from source that is read from r while it is
+// being parsed and compiled. The parsing and compiling happen on the calling
+// goroutine without holding the isolate's lock, so other goroutines can keep
+// using the isolate in the meantime; only starting and finishing the compile
+// take the lock.
+// error will be of type `JSError` if not nil, unless reading from r failed.
+func (i *Isolate) CompileUnboundScriptStreaming(r io.Reader, origin string) (*UnboundScript, error) {
+	streamMutex.Lock()
+	streamSeq++
+	ref := streamSeq
+	streamMutex.Unlock()
+	s := &streamingSource{r: r}
+	streamRegistry.Store(ref, s)
+	defer streamRegistry.Delete(ref)
+
+	task := C.IsolateStartStreamingScript(i.ptr, C.int(ref))
+	C.StreamingTaskRun(task)
+
+	b := s.source.Bytes()
+	source := *(*string)(unsafe.Pointer(&b))
+	rtn := C.StreamingTaskFinish(i.ptr, task, stringArg(source), stringArg(origin))
+	runtime.KeepAlive(s)
+	runtime.KeepAlive(origin)
+	if s.err != nil {
+		return nil, s.err
+	}
+	if rtn.ptr == nil {
+		return nil, newJSError(rtn.error)
+	}
+	return &UnboundScript{
+		ptr: rtn.ptr,
+		iso: i,
+	}, nil
+}
+
+//export goStreamingSourceRead
+func goStreamingSourceRead(ref int, buf *C.uint8_t, length int) int {
+	v, _ := streamRegistry.Load(ref)
+	s := v.(*streamingSource)
+	if s.err != nil {
+		return 0
+	}
+	// Full chunks are read, as V8 only handles UTF-8 characters that are
+	// split across two chunks at most.
+	chunk := (*[1 << 30]byte)(unsafe.Pointer(buf))[:length:length]
+	n, err := io.ReadFull(s.r, chunk)
+	if err != nil && err != io.EOF && err != io.ErrUnexpectedEOF {
+		s.err = err
+		return 0
+	}
+	s.source.Write(chunk[:n])
+	return n
+}
@@ -0,0 +1,107 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// SerializedValue is a JS value serialized with the structured clone
+// algorithm of V8's ValueSerializer, which keeps the Maps, Sets, Dates,
+// RegExps, typed arrays, BigInts and shared references of the value that JSON
+// loses. It can be deserialized in any context of any isolate, see
+// Context.Serialize.
+type SerializedValue struct {
+	mu  sync.Mutex
+	ptr C.SerializedPtr
+}
+
+// Serialize serializes value with the structured clone algorithm. The memory
+// of the ArrayBuffers in transfer moves to the serialized value without being
+// copied, leaving the buffers detached, and from it to the value deserialized
+// first. SharedArrayBuffers are shared with the deserialized values rather
+// than copied. Functions and host objects cannot be serialized.
+// error will be of type `JSError` if not nil.
+func (c *Context) Serialize(value Valuer, transfer ...*ArrayBuffer) (*SerializedValue, error) {
+	var transferptr *C.ValuePtr
+	if len(transfer) > 0 {
+		cTransfer := make([]C.ValuePtr, len(transfer))
+		for i, ab := range transfer {
+			cTransfer[i] = ab.ptr
+		}
+		transferptr = &cTransfer[0]
+	}
+	rtn := C.ContextSerialize(c.ptr, value.value().ptr, transferptr, C.int(len(transfer)))
+	runtime.KeepAlive(value)
+	runtime.KeepAlive(transfer)
+	if rtn.ptr == nil {
+		return nil, newJSError(rtn.error)
+	}
+	return wrapSerializedValue(rtn.ptr), nil
+}
+
+// Deserialize creates the value that s was serialized from in the context.
+// error will be of type `JSError` if not nil.
+func (c *Context) Deserialize(s *SerializedValue) (*Value, error) {
+	if s == nil {
+		return nil, errors.New("v8go: SerializedValue is required")
+	}
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.ptr == nil {
+		return nil, errors.New("v8go: SerializedValue has been released")
+	}
+	rtn := C.ContextDeserialize(c.ptr, s.ptr)
+	return valueResult(c, rtn)
+}
+
+// NewSerializedValue creates a SerializedValue from its wire format, see
+// SerializedValue.Bytes.
+func NewSerializedValue(data []byte) *SerializedValue {
+	var ptr unsafe.Pointer
+	if len(data) > 0 {
+		ptr = unsafe.Pointer(&data[0])
+	}
+	defer runtime.KeepAlive(data)
+	return wrapSerializedValue(C.NewSerialized(ptr, C.size_t(len(data))))
+}
+
+func wrapSerializedValue(ptr C.SerializedPtr) *SerializedValue {
+	s := &SerializedValue{ptr: ptr}
+	runtime.SetFinalizer(s, (*SerializedValue).Release)
+	return s
+}
+
+// Bytes returns a copy of the wire format of the value, to store it or send
+// it to another process. The memory of transferred ArrayBuffers and
+// SharedArrayBuffers is not part of the wire format, so values with them
+// cannot be deserialized from it.
+func (s *SerializedValue) Bytes() []byte {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.ptr == nil {
+		panic("v8go: SerializedValue used after Release")
+	}
+	data := C.SerializedData(s.ptr)
+	return C.GoBytes(data.data, C.int(data.byteLength))
+}
+
+// Release frees the serialized value, and the memory of the ArrayBuffers
+// transferred to it that has not moved to a deserialized value. Release is
+// safe to call more than once, and is called when s is garbage collected.
+func (s *SerializedValue) Release() {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.ptr != nil {
+		C.SerializedRelease(s.ptr)
+		s.ptr = nil
+	}
+}
@@ -0,0 +1,172 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestSerializeBetweenIsolates(t *testing.T) {
+	t.Parallel()
+
+	iso1 := v8.NewIsolate()
+	defer iso1.Dispose()
+	ctx1 := v8.NewContext(iso1)
+	defer ctx1.Close()
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	ctx2 := v8.NewContext(iso2)
+	defer ctx2.Close()
+
+	val, err := ctx1.RunScript(`
+		var shared = {n: 1};
+		({
+			map: new Map([["a", 1]]),
+			set: new Set([2]),
+			date: new Date(0),
+			big: 2n ** 64n,
+			bytes: new Uint8Array([1, 2, 3]),
+			re: /x/g,
+			left: shared,
+			right: shared,
+		})
+	`, "value.js")
+	fatalIf(t, err)
+	s, err := ctx1.Serialize(val)
+	fatalIf(t, err)
+	defer s.Release()
+
+	for _, s := range []*v8.SerializedValue{s, v8.NewSerializedValue(s.Bytes())} {
+		copied, err := ctx2.Deserialize(s)
+		fatalIf(t, err)
+		fatalIf(t, ctx2.Global().Set("v", copied))
+		res, err := ctx2.RunScript(`[
+			v.map.get("a"), v.set.has(2), v.date.getTime(), v.big.toString(),
+			v.bytes.join("-"), v.re.flags, v.left === v.right,
+		].join()`, "check.js")
+		fatalIf(t, err)
+		if want := "1,true,0,18446744073709551616,1-2-3,g,true"; res.String() != want {
+			t.Errorf("expected %q, got %q", want, res.String())
+		}
+	}
+
+	fn, err := ctx1.RunScript("(() => 1)", "fn.js")
+	fatalIf(t, err)
+	if _, err := ctx1.Serialize(fn); err == nil || !strings.Contains(err.Error(), "could not be cloned") {
+		t.Errorf("expected a function not to be serializable, got %v", err)
+	}
+	if _, err := ctx2.Deserialize(v8.NewSerializedValue([]byte{0xff})); err == nil {
+		t.Error("expected invalid data not to be deserializable")
+	}
+}
+
+func TestSerializeTransfer(t *testing.T) {
+	t.Parallel()
+
+	iso1 := v8.NewIsolate()
+	defer iso1.Dispose()
+	ctx1 := v8.NewContext(iso1)
+	defer ctx1.Close()
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	ctx2 := v8.NewContext(iso2)
+	defer ctx2.Close()
+
+	ab, err := v8.NewArrayBufferFromBytes(ctx1, []byte("moved"))
+	fatalIf(t, err)
+	data := &ab.Bytes()[0]
+	view, err := ctx1.RunScript("(ab) => ({view: new Uint8Array(ab, 1, 3)})", "view.js")
+	fatalIf(t, err)
+	wrap, err := view.AsFunction()
+	fatalIf(t, err)
+	obj, err := wrap.Call(v8.Undefined(iso1), ab)
+	fatalIf(t, err)
+
+	s, err := ctx1.Serialize(obj, ab)
+	fatalIf(t, err)
+	defer s.Release()
+	if ab.ByteLength() != 0 {
+		t.Errorf("expected the transferred buffer to be detached, got %v bytes", ab.ByteLength())
+	}
+	other, err := v8.NewArrayBuffer(ctx1, 1)
+	fatalIf(t, err)
+	if _, err := ctx1.Serialize(other, other, other); err == nil {
+		t.Error("expected a buffer not to be transferable twice")
+	}
+
+	copied, err := ctx2.Deserialize(s)
+	fatalIf(t, err)
+	viewVal, err := copied.Object().Get("view")
+	fatalIf(t, err)
+	got, err := viewVal.AsArrayBufferView()
+	fatalIf(t, err)
+	if string(got.Bytes()) != "ove" {
+		t.Errorf("expected the view of the moved buffer, got %q", got.Bytes())
+	}
+	if all := got.Buffer().Bytes(); &all[0] != data {
+		t.Error("expected the memory of the buffer to move without a copy")
+	}
+	if _, err := ctx2.Deserialize(s); err == nil {
+		t.Error("expected the transferred buffer to move only once")
+	}
+}
+
+func TestSerializeSharedArrayBuffer(t *testing.T) {
+	t.Parallel()
+
+	iso1 := v8.NewIsolate()
+	defer iso1.Dispose()
+	ctx1 := v8.NewContext(iso1)
+	defer ctx1.Close()
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	ctx2 := v8.NewContext(iso2)
+	defer ctx2.Close()
+
+	val, err := ctx1.RunScript("var sab = new SharedArrayBuffer(4); sab", "sab.js")
+	fatalIf(t, err)
+	s, err := ctx1.Serialize(val)
+	fatalIf(t, err)
+	defer s.Release()
+	copied, err := ctx2.Deserialize(s)
+	fatalIf(t, err)
+	sab, err := copied.AsSharedArrayBuffer()
+	fatalIf(t, err)
+	sab.Bytes()[0] = 42
+	res, err := ctx1.RunScript("new Uint8Array(sab)[0]", "read.js")
+	fatalIf(t, err)
+	if res.Int32() != 42 {
+		t.Errorf("expected the memory to be shared, got %v", res.Int32())
+	}
+}
+
+func BenchmarkSerialize(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	val, _ := ctx.RunScript(`({rows: Array.from({length: 100}, (_, i) => ({id: i, name: "row " + i, tags: ["a", "b"]}))})`, "")
+
+	b.Run("JSON", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				json, _ := v8.JSONStringify(ctx, val)
+				v8.JSONParse(ctx, json)
+			})
+		}
+	})
+	b.Run("Serialize", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			ctx.WithValueScope(func(*v8.ValueScope) {
+				s, _ := ctx.Serialize(val)
+				ctx.Deserialize(s)
+				s.Release()
+			})
+		}
+	})
+}
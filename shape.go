@@ -0,0 +1,235 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"fmt"
+	"math"
+	"reflect"
+	"sync"
+	"unsafe"
+)
+
+// structField is a field of a struct type that is a property of its objects,
+// see Context.Import.
+type structField struct {
+	index int
+	name  string
+}
+
+var structFieldCache sync.Map // reflect.Type -> []structField
+
+// structFields returns the fields of the struct type t that are properties of
+// its objects, which are worked out once per type.
+func structFields(t reflect.Type) []structField {
+	if fields, ok := structFieldCache.Load(t); ok {
+		return fields.([]structField)
+	}
+	var fields []structField
+	for i := 0; i < t.NumField(); i++ {
+		f := t.Field(i)
+		if f.PkgPath != "" {
+			continue
+		}
+		name := f.Name
+		if tag := f.Tag.Get("v8"); tag == "-" {
+			continue
+		} else if tag != "" {
+			name = tag
+		}
+		fields = append(fields, structField{index: i, name: name})
+	}
+	structFieldCache.Store(t, fields)
+	return fields
+}
+
+// structShape returns the id of the shape of the struct type t in the
+// isolate, registering its keys on first use.
+func (i *Isolate) structShape(t reflect.Type, fields []structField) uint32 {
+	if id, ok := i.shapes.Load(t); ok {
+		return id.(uint32)
+	}
+	var e bulkEncoder
+	for _, f := range fields {
+		e.string(f.name)
+	}
+	var keys *C.char
+	if len(e.buf) > 0 {
+		keys = (*C.char)(unsafe.Pointer(&e.buf[0]))
+	}
+	id := uint32(C.IsolateNewShape(i.ptr, keys, C.int(len(fields))))
+	// A concurrent first use registers the shape twice, which is harmless.
+	actual, _ := i.shapes.LoadOrStore(t, id)
+	return actual.(uint32)
+}
+
+func (e *bulkEncoder) encodeStruct(rv reflect.Value) error {
+	fields := structFields(rv.Type())
+	if err := e.enter(); err != nil {
+		return err
+	}
+	e.tag(C.BULK_SHAPE)
+	e.uint32(int(e.iso.structShape(rv.Type(), fields)))
+	for _, f := range fields {
+		field := rv.Field(f.index)
+		var err error
+		switch field.Kind() {
+		case reflect.Ptr, reflect.Interface, reflect.Slice, reflect.Map, reflect.Struct, reflect.Array:
+			err = e.encode(field.Interface())
+		default:
+			err = e.encodeReflect(field)
+		}
+		if err != nil {
+			return err
+		}
+	}
+	e.depth--
+	return nil
+}
+
+// ExportTo converts the value, and all the values it contains, to the Go
+// value that dst points to, with a single call into V8 like Export. Structs
+// are set from objects by the names of their fields, as Context.Import names
+// them, while properties that no field is named after are ignored. Numbers are
+// converted to integers only if they are whole numbers in range, and BigInts
+// to int64 and uint64 if they fit; *Value and interface{} take any value.
+func (v *Value) ExportTo(dst interface{}) error {
+	rv := reflect.ValueOf(dst)
+	if rv.Kind() != reflect.Ptr || rv.IsNil() {
+		return fmt.Errorf("v8go: ExportTo requires a non-nil pointer, got %T", dst)
+	}
+	x, err := v.Export()
+	if err != nil {
+		return err
+	}
+	return exportTo(rv.Elem(), x)
+}
+
+var valueType = reflect.TypeOf((*Value)(nil))
+
+func exportTo(rv reflect.Value, x interface{}) error {
+	if val, ok := x.(*Value); ok && rv.Type() == valueType {
+		rv.Set(reflect.ValueOf(val))
+		return nil
+	}
+	if rv.Kind() == reflect.Interface && rv.NumMethod() == 0 {
+		if x == nil {
+			rv.Set(reflect.Zero(rv.Type()))
+		} else {
+			rv.Set(reflect.ValueOf(x))
+		}
+		return nil
+	}
+	if x == nil {
+		rv.Set(reflect.Zero(rv.Type()))
+		return nil
+	}
+
+	switch rv.Kind() {
+	case reflect.Ptr:
+		elem := reflect.New(rv.Type().Elem())
+		if err := exportTo(elem.Elem(), x); err != nil {
+			return err
+		}
+		rv.Set(elem)
+		return nil
+	case reflect.Bool:
+		if b, ok := x.(bool); ok {
+			rv.SetBool(b)
+			return nil
+		}
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		if f, ok := x.(float64); ok && f == math.Trunc(f) && f >= math.MinInt64 && f < math.MaxInt64 && !rv.OverflowInt(int64(f)) {
+			rv.SetInt(int64(f))
+			return nil
+		}
+		if val, ok := x.(*Value); ok && val.IsBigInt() {
+			if b := val.BigInt(); b.IsInt64() && !rv.OverflowInt(b.Int64()) {
+				rv.SetInt(b.Int64())
+				return nil
+			}
+		}
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64, reflect.Uintptr:
+		if f, ok := x.(float64); ok && f == math.Trunc(f) && f >= 0 && f < math.MaxUint64 && !rv.OverflowUint(uint64(f)) {
+			rv.SetUint(uint64(f))
+			return nil
+		}
+		if val, ok := x.(*Value); ok && val.IsBigInt() {
+			if b := val.BigInt(); b.IsUint64() && !rv.OverflowUint(b.Uint64()) {
+				rv.SetUint(b.Uint64())
+				return nil
+			}
+		}
+	case reflect.Float32, reflect.Float64:
+		if f, ok := x.(float64); ok {
+			rv.SetFloat(f)
+			return nil
+		}
+	case reflect.String:
+		if s, ok := x.(string); ok {
+			rv.SetString(s)
+			return nil
+		}
+	case reflect.Slice, reflect.Array:
+		elems, ok := x.([]interface{})
+		if !ok {
+			break
+		}
+		if rv.Kind() == reflect.Slice {
+			rv.Set(reflect.MakeSlice(rv.Type(), len(elems), len(elems)))
+		} else if len(elems) != rv.Len() {
+			return fmt.Errorf("v8go: cannot export an array of %d elements to `%s`", len(elems), rv.Type())
+		}
+		for i, elem := range elems {
+			if err := exportTo(rv.Index(i), elem); err != nil {
+				return err
+			}
+		}
+		return nil
+	case reflect.Map:
+		props, ok := x.(map[string]interface{})
+		if !ok || rv.Type().Key().Kind() != reflect.String {
+			break
+		}
+		m := reflect.MakeMapWithSize(rv.Type(), len(props))
+		for key, prop := range props {
+			elem := reflect.New(rv.Type().Elem()).Elem()
+			if err := exportTo(elem, prop); err != nil {
+				return err
+			}
+			m.SetMapIndex(reflect.ValueOf(key).Convert(rv.Type().Key()), elem)
+		}
+		rv.Set(m)
+		return nil
+	case reflect.Struct:
+		props, ok := x.(map[string]interface{})
+		if !ok {
+			break
+		}
+		for _, f := range structFields(rv.Type()) {
+			if prop, ok := props[f.name]; ok {
+				if err := exportTo(rv.Field(f.index), prop); err != nil {
+					return fmt.Errorf("%w of field %s", err, f.name)
+				}
+			}
+		}
+		return nil
+	}
+	return fmt.Errorf("v8go: cannot export %s to `%s`", exportedKind(x), rv.Type())
+}
+
+// exportedKind describes x, as returned by Export, for errors.
+func exportedKind(x interface{}) string {
+	switch x := x.(type) {
+	case float64:
+		return fmt.Sprintf("the number %v", x)
+	case *Value:
+		return "the value " + x.DetailString()
+	default:
+		return fmt.Sprintf("a %T", x)
+	}
+}
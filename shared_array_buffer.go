@@ -0,0 +1,130 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// SharedBackingStore is memory that can back SharedArrayBuffers in any number
+// of contexts, of any number of isolates, at once. The memory is reference
+// counted: it is freed once the SharedBackingStore has been released and every
+// SharedArrayBuffer on it has been garbage collected or had its isolate
+// disposed.
+type SharedBackingStore struct {
+	mu  sync.Mutex
+	ptr C.BackingStorePtr
+}
+
+// NewSharedBackingStore allocates a zero-filled backing store of byteLength
+// bytes.
+func NewSharedBackingStore(byteLength int) (*SharedBackingStore, error) {
+	return newSharedBackingStore(nil, byteLength)
+}
+
+// NewSharedBackingStoreFromBytes allocates a backing store that holds a copy of
+// data.
+func NewSharedBackingStoreFromBytes(data []byte) (*SharedBackingStore, error) {
+	if len(data) == 0 {
+		return newSharedBackingStore(nil, 0)
+	}
+	return newSharedBackingStore(unsafe.Pointer(&data[0]), len(data))
+}
+
+func newSharedBackingStore(data unsafe.Pointer, byteLength int) (*SharedBackingStore, error) {
+	if byteLength < 0 {
+		return nil, errors.New("v8go: backing store length must not be negative")
+	}
+	ptr := C.NewSharedBackingStore(data, C.size_t(byteLength))
+	if ptr == nil {
+		return nil, errors.New("v8go: backing store allocation failed")
+	}
+	return wrapSharedBackingStore(ptr), nil
+}
+
+func wrapSharedBackingStore(ptr C.BackingStorePtr) *SharedBackingStore {
+	s := &SharedBackingStore{ptr: ptr}
+	runtime.SetFinalizer(s, (*SharedBackingStore).Release)
+	return s
+}
+
+// Bytes returns the memory of the backing store, without copying it. The slice
+// must not be used once the backing store has been released.
+func (s *SharedBackingStore) Bytes() []byte {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.ptr == nil {
+		panic("v8go: SharedBackingStore used after Release")
+	}
+	return arrayBufferBytes(C.BackingStoreContents(s.ptr))
+}
+
+// Release drops the reference to the memory held by s. SharedArrayBuffers that
+// were created on it are unaffected. Release is safe to call more than once,
+// and is called when s is garbage collected.
+func (s *SharedBackingStore) Release() {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.ptr != nil {
+		C.BackingStoreRelease(s.ptr)
+		s.ptr = nil
+	}
+}
+
+// SharedArrayBuffer is a JavaScript SharedArrayBuffer, whose memory may be
+// shared with other contexts and isolates.
+type SharedArrayBuffer struct {
+	*Object
+}
+
+// NewSharedArrayBuffer creates a SharedArrayBuffer on the memory of store in
+// the given context. The buffer holds its own reference to the memory.
+func NewSharedArrayBuffer(ctx *Context, store *SharedBackingStore) (*SharedArrayBuffer, error) {
+	if ctx == nil {
+		return nil, errors.New("v8go: Context is required")
+	}
+	if store == nil {
+		return nil, errors.New("v8go: SharedBackingStore is required")
+	}
+	store.mu.Lock()
+	defer store.mu.Unlock()
+	if store.ptr == nil {
+		return nil, errors.New("v8go: SharedBackingStore has been released")
+	}
+	ptr := C.NewSharedArrayBuffer(ctx.ptr, store.ptr)
+	return &SharedArrayBuffer{&Object{newValue(ctx, ptr)}}, nil
+}
+
+// AsSharedArrayBuffer will cast the value to the SharedArrayBuffer type. If
+// the value is not a SharedArrayBuffer then an error is returned.
+func (v *Value) AsSharedArrayBuffer() (*SharedArrayBuffer, error) {
+	if !v.IsSharedArrayBuffer() {
+		return nil, errors.New("v8go: value is not a SharedArrayBuffer")
+	}
+	return &SharedArrayBuffer{&Object{v}}, nil
+}
+
+// BackingStore returns a new reference to the memory of the buffer, with which
+// the buffer can be shared with other isolates.
+func (sab *SharedArrayBuffer) BackingStore() *SharedBackingStore {
+	return wrapSharedBackingStore(C.SharedArrayBufferBackingStore(sab.ptr))
+}
+
+// ByteLength returns the length of the buffer in bytes.
+func (sab *SharedArrayBuffer) ByteLength() int {
+	return int(C.ValueArrayBufferContents(sab.ptr).byteLength)
+}
+
+// Bytes returns the contents of the buffer, without copying them, in the same
+// way as ArrayBuffer.Bytes.
+func (sab *SharedArrayBuffer) Bytes() []byte {
+	return arrayBufferBytes(C.ValueArrayBufferContents(sab.ptr))
+}
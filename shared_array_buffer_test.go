@@ -0,0 +1,82 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"runtime"
+	"sync"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestSharedArrayBuffer(t *testing.T) {
+	t.Parallel()
+
+	store, err := v8.NewSharedBackingStoreFromBytes([]byte{1, 2, 3, 4})
+	fatalIf(t, err)
+
+	const workers = 4
+	var wg sync.WaitGroup
+	sums := make([]int32, workers)
+	for i := 0; i < workers; i++ {
+		i := i
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			iso := v8.NewIsolate()
+			defer iso.Dispose()
+			ctx := v8.NewContext(iso)
+			defer ctx.Close()
+
+			sab, err := v8.NewSharedArrayBuffer(ctx, store)
+			if err != nil {
+				t.Error(err)
+				return
+			}
+			ctx.Global().Set("sab", sab)
+			val, err := ctx.RunScript("new Uint8Array(sab).reduce((a,b) => a+b)", "sab.js")
+			if err != nil {
+				t.Error(err)
+				return
+			}
+			sums[i] = val.Int32()
+		}()
+	}
+	wg.Wait()
+	for i, sum := range sums {
+		if sum != 10 {
+			t.Errorf("worker %d: unexpected sum %d", i, sum)
+		}
+	}
+
+	// The memory outlives the store's reference while a buffer is using it.
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	sab, err := v8.NewSharedArrayBuffer(ctx, store)
+	fatalIf(t, err)
+	store.Release()
+	store.Release()
+	if _, err := v8.NewSharedArrayBuffer(ctx, store); err == nil {
+		t.Error("expected error but got <nil>")
+	}
+	runtime.GC()
+	if sab.ByteLength() != 4 || sab.Bytes()[3] != 4 {
+		t.Errorf("unexpected contents: %v", sab.Bytes())
+	}
+
+	// Buffers created in JS can be shared too.
+	val, err := ctx.RunScript("const shared = new SharedArrayBuffer(8); new Uint8Array(shared)[7] = 9; shared", "sab.js")
+	fatalIf(t, err)
+	sab, err = val.AsSharedArrayBuffer()
+	fatalIf(t, err)
+	other := sab.BackingStore()
+	defer other.Release()
+	if b := other.Bytes(); len(b) != 8 || b[7] != 9 {
+		t.Errorf("unexpected contents: %v", b)
+	}
+}
@@ -0,0 +1,93 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"crypto/sha256"
+	"runtime"
+	"sync"
+)
+
+// SharedSource is a script source that is interned in a process wide
+// registry, keyed by its content. Its characters are copied to C once and
+// shared by every isolate that compiles it, as external strings, and the code
+// cache of its first compile is kept with it so that compiling it in other
+// isolates skips the full parse.
+type SharedSource struct {
+	ptr  C.SourcePtr
+	hash [sha256.Size]byte
+	refs int
+}
+
+// sourceRegistry maps the hash of each interned source to its *SharedSource;
+// sourceMutex guards it and their refs.
+var sourceMutex sync.Mutex
+var sourceRegistry = make(map[[sha256.Size]byte]*SharedSource)
+
+// InternSource returns the SharedSource of source, interning it if it is not
+// in the registry yet. Every call must be matched by a call to Release.
+func InternSource(source string) *SharedSource {
+	hash := sha256.Sum256([]byte(source))
+	sourceMutex.Lock()
+	defer sourceMutex.Unlock()
+	if s, ok := sourceRegistry[hash]; ok {
+		s.refs++
+		return s
+	}
+	s := &SharedSource{
+		ptr:  C.NewSharedSource(stringData(source), C.int(len(source))),
+		hash: hash,
+		refs: 1,
+	}
+	runtime.KeepAlive(source)
+	sourceRegistry[hash] = s
+	return s
+}
+
+// Release gives up a reference to the source, which is removed from the
+// registry once all of them have been released, which must not happen while
+// it is being compiled. Scripts compiled from it remain valid, and keep its
+// characters for as long as they live.
+func (s *SharedSource) Release() {
+	sourceMutex.Lock()
+	defer sourceMutex.Unlock()
+	if s.refs == 0 {
+		return
+	}
+	s.refs--
+	if s.refs == 0 {
+		delete(sourceRegistry, s.hash)
+		C.SharedSourceRelease(s.ptr)
+	}
+}
+
+// CodeCacheSize returns the size of the code cache kept with the source, which
+// is zero until it has been compiled once.
+func (s *SharedSource) CodeCacheSize() int {
+	return int(C.SharedSourceCodeCacheSize(s.ptr))
+}
+
+// CompileSharedSource creates an UnboundScript like CompileUnboundScript
+// does, from an interned source. The first compile of the source in the
+// process creates its code cache, which later compiles consume; opts.Mode is
+// used until then, and opts.CachedData must be nil.
+// error will be of type `JSError` if not nil.
+func (i *Isolate) CompileSharedSource(source *SharedSource, origin string, opts CompileOptions) (*UnboundScript, error) {
+	if opts.CachedData != nil {
+		panic("On CompileSharedSource, CachedData can't be set")
+	}
+	rtn := C.IsolateCompileSharedSource(i.ptr, source.ptr, stringArg(origin), C.int(opts.Mode))
+	runtime.KeepAlive(origin)
+	if rtn.ptr == nil {
+		return nil, newJSError(rtn.error)
+	}
+	return &UnboundScript{
+		ptr: rtn.ptr,
+		iso: i,
+	}, nil
+}
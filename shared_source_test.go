@@ -0,0 +1,70 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestSharedSource(t *testing.T) {
+	t.Parallel()
+
+	for _, tc := range []struct {
+		name   string
+		source string
+		want   string
+	}{
+		{"ascii", "function greet() { return 'hello'; }; greet()", "hello"},
+		{"unicode", "function greet() { return 'héllo 世界 😀'; }; greet()", "héllo 世界 😀"},
+		{"invalid utf-8", "'a\xffb'", "a�b"},
+		{"empty", "", "undefined"},
+	} {
+		tc := tc
+		t.Run(tc.name, func(t *testing.T) {
+			t.Parallel()
+			src := v8.InternSource(tc.source)
+			defer src.Release()
+			if again := v8.InternSource(string([]byte(tc.source))); again != src {
+				t.Error("expected the same source to be interned once")
+			} else {
+				again.Release()
+			}
+
+			for i := 0; i < 3; i++ {
+				iso := v8.NewIsolate()
+				us, err := iso.CompileSharedSource(src, "shared.js", v8.CompileOptions{})
+				fatalIf(t, err)
+				ctx := v8.NewContext(iso)
+				val, err := us.Run(ctx)
+				fatalIf(t, err)
+				if val.String() != tc.want {
+					t.Errorf("expected %q, got %q", tc.want, val.String())
+				}
+				ctx.Close()
+				iso.Dispose()
+			}
+			if tc.source != "" && src.CodeCacheSize() == 0 {
+				t.Error("expected the code cache of the first compile to be kept")
+			}
+		})
+	}
+}
+
+func TestSharedSourceErrors(t *testing.T) {
+	t.Parallel()
+
+	src := v8.InternSource("function (")
+	defer src.Release()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	if _, err := iso.CompileSharedSource(src, "bad.js", v8.CompileOptions{}); err == nil {
+		t.Error("expected a syntax error")
+	}
+	if src.CodeCacheSize() != 0 {
+		t.Error("expected no code cache for a source that does not compile")
+	}
+}
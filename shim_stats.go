@@ -0,0 +1,71 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"time"
+	"unsafe"
+)
+
+// RecordShimStats is an IsolateOption that makes the isolate count the calls
+// that v8go makes into V8 for it, see Isolate.ShimStats, at the cost of two
+// reads of the clock per call.
+var RecordShimStats IsolateOption = isolateOptionFunc(func(opts *isolateOptions) {
+	opts.shimStats = true
+})
+
+// ShimStats are the counters of the calls into V8 of an isolate created with
+// RecordShimStats, which tell the time spent waiting for the isolate and the
+// values marshalled between Go and JavaScript apart from the time spent
+// running JavaScript.
+type ShimStats struct {
+	// Calls is the number of calls by the name of the C function of v8go
+	// that made them, for the functions that take the isolate's lock.
+	Calls map[string]uint64
+	// LockWaitTotal and LockWaitMax are the total and longest time that the
+	// calls waited to take the isolate's lock, see Isolate.Lock.
+	LockWaitTotal time.Duration
+	LockWaitMax   time.Duration
+	// ValuesAllocated and ValuesFreed are the number of values that have been
+	// created for Go and freed, either with Value.Release or along with their
+	// context; the difference is the number of values in use.
+	ValuesAllocated uint64
+	ValuesFreed     uint64
+}
+
+// LiveValues returns the number of values in use.
+func (s ShimStats) LiveValues() uint64 {
+	if s.ValuesFreed > s.ValuesAllocated {
+		return 0
+	}
+	return s.ValuesAllocated - s.ValuesFreed
+}
+
+// ShimStats returns the counters of the isolate, and false if it was created
+// without RecordShimStats.
+func (i *Isolate) ShimStats() (ShimStats, bool) {
+	rtn := C.IsolateShimStats(i.ptr)
+	if rtn.enabled == 0 {
+		return ShimStats{}, false
+	}
+	stats := ShimStats{
+		Calls:           make(map[string]uint64, int(rtn.callsLength)),
+		LockWaitTotal:   time.Duration(rtn.lockWaitTotal),
+		LockWaitMax:     time.Duration(rtn.lockWaitMax),
+		ValuesAllocated: uint64(rtn.valuesAllocated),
+		ValuesFreed:     uint64(rtn.valuesFreed),
+	}
+	if rtn.callsLength > 0 {
+		defer C.free(unsafe.Pointer(rtn.calls))
+		calls := (*[1 << 20]C.ShimCallCount)(unsafe.Pointer(rtn.calls))[:rtn.callsLength:rtn.callsLength]
+		for _, c := range calls {
+			stats.Calls[C.GoString(c.name)] += uint64(c.count)
+		}
+	}
+	return stats, true
+}
@@ -0,0 +1,57 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestIsolateShimStats(t *testing.T) {
+	t.Parallel()
+
+	plain := v8.NewIsolate()
+	defer plain.Dispose()
+	if _, ok := plain.ShimStats(); ok {
+		t.Error("expected no stats without RecordShimStats")
+	}
+
+	iso := v8.NewIsolate(v8.RecordShimStats)
+	defer iso.Dispose()
+	before, ok := iso.ShimStats()
+	if !ok {
+		t.Fatal("expected stats with RecordShimStats")
+	}
+
+	ctx := v8.NewContext(iso)
+	for i := 0; i < 3; i++ {
+		_, err := ctx.RunScript("({})", "stats.js")
+		fatalIf(t, err)
+	}
+	val, err := ctx.RunScript("'released'", "stats.js")
+	fatalIf(t, err)
+	val.Release()
+
+	stats, _ := iso.ShimStats()
+	if n := stats.Calls["RunScript"] - before.Calls["RunScript"]; n != 4 {
+		t.Errorf("expected 4 calls of RunScript, got %d in %v", n, stats.Calls)
+	}
+	if stats.LockWaitTotal <= 0 || stats.LockWaitMax <= 0 || stats.LockWaitMax > stats.LockWaitTotal {
+		t.Errorf("unexpected lock wait times %v and %v", stats.LockWaitTotal, stats.LockWaitMax)
+	}
+	if n := stats.ValuesAllocated - before.ValuesAllocated; n < 4 {
+		t.Errorf("expected the 4 results to be allocated, got %d", n)
+	}
+	if n := stats.ValuesFreed - before.ValuesFreed; n != 1 {
+		t.Errorf("expected the released value to be freed, got %d", n)
+	}
+
+	ctx.Close()
+	stats, _ = iso.ShimStats()
+	if stats.LiveValues() != before.LiveValues() {
+		t.Errorf("expected the values of the context to be freed with it, got %d live, want %d", stats.LiveValues(), before.LiveValues())
+	}
+}
@@ -0,0 +1,251 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// FunctionCodeHandling is whether a snapshot includes the code of the
+// functions that were compiled while it was being set up.
+type FunctionCodeHandling int
+
+const (
+	// FunctionCodeClear leaves compiled code out of the snapshot, so that it
+	// is compiled again, lazily, by the isolates created from it.
+	FunctionCodeClear FunctionCodeHandling = iota
+	// FunctionCodeKeep includes compiled code in the snapshot.
+	FunctionCodeKeep
+)
+
+// SnapshotCreator creates a startup snapshot: the state of a context after it
+// has been set up, from which isolates can be created whose contexts start out
+// in that state, without running the setup again. The context is set up as
+// usual, on the isolate returned by Isolate, including with global templates
+// that bind FunctionTemplates.
+type SnapshotCreator struct {
+	ptr C.SnapshotCreatorPtr
+	iso *Isolate
+
+	// templates are the templates created on the creator's isolate, whose
+	// handles have to be released before the snapshot is created.
+	templatesMutex sync.Mutex
+	templates      []*template
+}
+
+// NewSnapshotCreator creates a SnapshotCreator with a new isolate.
+func NewSnapshotCreator() *SnapshotCreator {
+	initV8()
+	ptr := C.NewSnapshotCreator()
+	s := &SnapshotCreator{
+		ptr: ptr,
+		iso: newIsolate(C.SnapshotCreatorGetIsolate(ptr)),
+	}
+	s.iso.creator = s
+	return s
+}
+
+// Isolate returns the isolate in which the context of the snapshot is set up.
+// It is disposed of by Create or Dispose; disposing of the isolate disposes of
+// the creator.
+func (s *SnapshotCreator) Isolate() *Isolate {
+	return s.iso
+}
+
+// Create creates a snapshot of ctx, which must be a context of the creator's
+// isolate, and of the more contexts of the isolate, which contexts can start
+// from by index with the SnapshotContext option: ctx is at index 0 and more
+// follow from index 1, so that a single isolate can start contexts set up for
+// different purposes. It closes every context of the isolate and disposes of
+// the isolate along with the creator, so values and templates of the isolate
+// must not be used afterwards.
+func (s *SnapshotCreator) Create(ctx *Context, code FunctionCodeHandling, more ...*Context) (*Snapshot, error) {
+	if s.ptr == nil {
+		return nil, errors.New("v8go: SnapshotCreator has been disposed")
+	}
+	ctxs := append([]*Context{ctx}, more...)
+	cptrs := make([]C.ContextPtr, len(ctxs))
+	for i, c := range ctxs {
+		if c == nil || c.iso != s.iso {
+			return nil, errors.New("v8go: Context of the SnapshotCreator's isolate is required")
+		}
+		for _, prev := range ctxs[:i] {
+			if prev == c {
+				return nil, errors.New("v8go: Context given more than once")
+			}
+		}
+		cptrs[i] = c.ptr
+	}
+	s.closeContexts(ctxs)
+	for _, c := range ctxs {
+		c.deregister()
+	}
+
+	snapshot := &Snapshot{cbSeq: s.iso.cbSeq, contexts: len(ctxs)}
+	s.iso.cbs.Range(func(ref, cb interface{}) bool {
+		snapshot.callbacks = append(snapshot.callbacks, snapshotCallback{ref.(int), cb})
+		return true
+	})
+	for ref := range s.iso.fastRefs {
+		fn, _ := fastRegistry.Load(fastKey{s.iso.ptr, ref})
+		snapshot.fastFunctions = append(snapshot.fastFunctions, snapshotFastFunction{ref, fn.(fastFunction)})
+	}
+	s.iso.unregisterFastFunctions()
+
+	keep := 0
+	if code == FunctionCodeKeep {
+		keep = 1
+	}
+	s.templatesMutex.Lock()
+	templates := make([]C.TemplatePtr, len(s.templates))
+	for i, t := range s.templates {
+		templates[i] = t.ptr
+	}
+	s.templates = nil
+	s.templatesMutex.Unlock()
+	var templatesPtr *C.TemplatePtr
+	if len(templates) > 0 {
+		templatesPtr = (*C.TemplatePtr)(unsafe.Pointer(&templates[0]))
+	}
+
+	snapshot.ptr = C.SnapshotCreatorCreateBlob(s.ptr, &cptrs[0], C.int(len(cptrs)), templatesPtr, C.int(len(templates)), C.int(keep))
+	for _, c := range ctxs {
+		c.ptr = nil
+	}
+	s.ptr = nil
+	s.iso.ptr = nil
+	if snapshot.ptr == nil {
+		return nil, errors.New("v8go: failed to create snapshot")
+	}
+	runtime.SetFinalizer(snapshot, (*Snapshot).finalizer)
+	return snapshot, nil
+}
+
+// Dispose disposes of the creator and its isolate without creating a
+// snapshot.
+func (s *SnapshotCreator) Dispose() {
+	if s.ptr == nil {
+		return
+	}
+	s.closeContexts(nil)
+	s.iso.unregisterFastFunctions()
+	s.templatesMutex.Lock()
+	s.templates = nil
+	s.templatesMutex.Unlock()
+	C.SnapshotCreatorDispose(s.ptr)
+	s.ptr = nil
+	s.iso.ptr = nil
+}
+
+// closeContexts closes the contexts of the creator's isolate other than keep,
+// as the isolate may not hold on to any handles when the snapshot is created.
+func (s *SnapshotCreator) closeContexts(keep []*Context) {
+	ctxRegistry.Range(func(_, r interface{}) bool {
+		ctx := r.(*ctxRef).ctx
+		if ctx.iso != s.iso {
+			return true
+		}
+		for _, k := range keep {
+			if ctx == k {
+				return true
+			}
+		}
+		ctx.Close()
+		return true
+	})
+}
+
+// trackTemplate keeps hold of templates of a SnapshotCreator's isolate, so
+// that the creator can release them.
+func (i *Isolate) trackTemplate(t *template) {
+	if s := i.creator; s != nil {
+		s.templatesMutex.Lock()
+		s.templates = append(s.templates, t)
+		s.templatesMutex.Unlock()
+	}
+}
+
+// untrackTemplate forgets a template that is released before the snapshot is
+// created, and reports whether it was still tracked.
+func (s *SnapshotCreator) untrackTemplate(t *template) bool {
+	s.templatesMutex.Lock()
+	defer s.templatesMutex.Unlock()
+	for n, tracked := range s.templates {
+		if tracked == t {
+			s.templates = append(s.templates[:n], s.templates[n+1:]...)
+			return true
+		}
+	}
+	return false
+}
+
+// Snapshot is a startup snapshot created by a SnapshotCreator. The contexts
+// of isolates created from it with the FromSnapshot option start out as a
+// copy of the snapshot's first context, or of the one selected with the
+// SnapshotContext option, unless they are given a global template.
+//
+// Go functions bound through FunctionTemplates cannot be serialized, so a
+// snapshot holds on to the callbacks of its creator's isolate and can only be
+// used by the process that created it.
+type Snapshot struct {
+	ptr           C.StartupDataPtr
+	contexts      int
+	cbSeq         int
+	callbacks     []snapshotCallback
+	fastFunctions []snapshotFastFunction
+}
+
+// snapshotCallback is a FunctionCallbackWithError or a propertyCallback.
+type snapshotCallback struct {
+	ref int
+	cb  interface{}
+}
+
+type snapshotFastFunction struct {
+	ref int
+	fn  fastFunction
+}
+
+// Contexts returns the number of contexts in the snapshot, which the
+// SnapshotContext option selects from.
+func (s *Snapshot) Contexts() int {
+	return s.contexts
+}
+
+// Size returns the size of the snapshot in bytes.
+func (s *Snapshot) Size() int {
+	return int(C.StartupDataSize(s.ptr))
+}
+
+func (s *Snapshot) finalizer() {
+	C.StartupDataFree(s.ptr)
+	s.ptr = nil
+}
+
+// FromSnapshot creates the isolate from the given snapshot. The snapshot is
+// kept alive by the isolate.
+func FromSnapshot(s *Snapshot) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.snapshot = s
+	})
+}
+
+// restoreSnapshotCallbacks registers the callbacks of the snapshot's creator
+// with the isolate, under the refs that the snapshot refers to them by.
+func (i *Isolate) restoreSnapshotCallbacks(s *Snapshot) {
+	i.cbSeq = s.cbSeq
+	for _, c := range s.callbacks {
+		i.cbs.Store(c.ref, c.cb)
+	}
+	for _, f := range s.fastFunctions {
+		i.registerFastFunction(f.ref, f.fn)
+	}
+}
@@ -0,0 +1,117 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestSnapshotCreator(t *testing.T) {
+	t.Parallel()
+
+	creator := v8.NewSnapshotCreator()
+	iso := creator.Isolate()
+	global := v8.NewObjectTemplate(iso)
+	greet := v8.NewFunctionTemplate(iso, func(info *v8.FunctionCallbackInfo) *v8.Value {
+		val, _ := v8.NewValue(info.Context().Isolate(), "hello "+info.Args()[0].String())
+		return val
+	})
+	fatalIf(t, global.Set("greet", greet))
+	ctx := v8.NewContext(iso, global)
+	_, err := ctx.RunScript(`
+		const table = Array.from({length: 100}, (_, i) => i * i);
+		function lookup(i) { return table[i]; }
+		globalThis.message = greet("snapshot");`, "setup.js")
+	fatalIf(t, err)
+	other := v8.NewContext(iso)
+
+	snapshot, err := creator.Create(ctx, v8.FunctionCodeKeep)
+	fatalIf(t, err)
+	if snapshot.Size() == 0 {
+		t.Error("expected a non-empty snapshot")
+	}
+	other.Close()
+	iso.Dispose()
+
+	for i := 0; i < 2; i++ {
+		iso := v8.NewIsolate(v8.FromSnapshot(snapshot))
+		ctx := v8.NewContext(iso)
+
+		val, err := ctx.RunScript(`lookup(12) + " " + message + " " + greet("again")`, "main.js")
+		fatalIf(t, err)
+		if want := "144 hello snapshot hello again"; val.String() != want {
+			t.Errorf("unexpected result: expected %q, got %q", want, val.String())
+		}
+
+		// A global template replaces the snapshot's context.
+		fresh := v8.NewContext(iso, v8.NewObjectTemplate(iso))
+		val, err = fresh.RunScript("typeof lookup", "main.js")
+		fatalIf(t, err)
+		if val.String() != "undefined" {
+			t.Errorf("unexpected type of lookup: %q", val.String())
+		}
+
+		fresh.Close()
+		ctx.Close()
+		iso.Dispose()
+	}
+}
+
+func TestSnapshotCreatorDispose(t *testing.T) {
+	t.Parallel()
+
+	creator := v8.NewSnapshotCreator()
+	ctx := v8.NewContext(creator.Isolate())
+	_, err := ctx.RunScript("1 + 1", "setup.js")
+	fatalIf(t, err)
+	creator.Dispose()
+	creator.Dispose()
+	if _, err := creator.Create(ctx, v8.FunctionCodeClear); err == nil {
+		t.Error("expected error but got <nil>")
+	}
+}
+
+func TestSnapshotCreatorContexts(t *testing.T) {
+	t.Parallel()
+
+	creator := v8.NewSnapshotCreator()
+	iso := creator.Isolate()
+	first := v8.NewContext(iso)
+	_, err := first.RunScript("var role = 'first'", "first.js")
+	fatalIf(t, err)
+	global := v8.NewObjectTemplate(iso)
+	global.SetAccessor("answer", func(info *v8.PropertyCallbackInfo) (*v8.Value, error) {
+		return v8.NewValue(info.Context().Isolate(), int32(42))
+	}, nil)
+	second := v8.NewContext(iso, global)
+	_, err = second.RunScript("var role = 'second'", "second.js")
+	fatalIf(t, err)
+	if _, err := creator.Create(first, v8.FunctionCodeClear, first); err == nil {
+		t.Error("expected an error for a context given twice")
+	}
+
+	snapshot, err := creator.Create(first, v8.FunctionCodeClear, second)
+	fatalIf(t, err)
+	if snapshot.Contexts() != 2 {
+		t.Errorf("expected 2 contexts, got %d", snapshot.Contexts())
+	}
+
+	iso = v8.NewIsolate(v8.FromSnapshot(snapshot))
+	defer iso.Dispose()
+	for i, want := range []string{"first,", "second,42"} {
+		ctx := v8.NewContext(iso, v8.SnapshotContext(i))
+		val, err := ctx.RunScript("[role, globalThis.answer].join()", "role.js")
+		fatalIf(t, err)
+		if val.String() != want {
+			t.Errorf("context %d: expected %q, got %q", i, want, val.String())
+		}
+		ctx.Close()
+	}
+	if recoverPanic(func() { v8.NewContext(iso, v8.SnapshotContext(2)) }) == nil {
+		t.Error("expected a panic for a context index out of range")
+	}
+}
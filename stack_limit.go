@@ -0,0 +1,19 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// StackSize is an IsolateOption that sets how much stack JavaScript may use
+// in the isolate, in bytes, below the point at which a goroutine's call
+// enters it. Calls that recurse deeper throw a RangeError. V8's default of
+// about 1MB is derived from the thread that first enters the isolate, and
+// crashes the process on threads with smaller stacks; with StackSize, the
+// limit is set each time a thread enters the isolate, and capped to the
+// bounds of the thread's stack, less a margin for native code, where the
+// platform tells them.
+func StackSize(bytes uint64) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.stackSize = bytes
+	})
+}
@@ -0,0 +1,71 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"strconv"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+// recursionDepth returns how deep a function recurses in a context of an
+// isolate created with opts before it overflows the stack.
+func recursionDepth(t *testing.T, opts ...v8.IsolateOption) int {
+	t.Helper()
+	iso := v8.NewIsolate(opts...)
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	val, err := ctx.RunScript(`
+		let depth = 0;
+		function recurse(a, b, c) { depth++; return recurse(a + 1, b, c) + 1; }
+		let name;
+		try { recurse(0, 1, 2) } catch (e) { name = e.name }
+		name + " " + depth`, "recurse.js")
+	fatalIf(t, err)
+	parts := strings.Fields(val.String())
+	if parts[0] != "RangeError" {
+		t.Fatalf("expected a RangeError, got %q", val.String())
+	}
+	depth, err := strconv.Atoi(parts[1])
+	fatalIf(t, err)
+	return depth
+}
+
+func TestStackSize(t *testing.T) {
+	t.Parallel()
+
+	small := recursionDepth(t, v8.StackSize(64<<10))
+	large := recursionDepth(t, v8.StackSize(1<<20))
+	if small <= 0 || large < 4*small {
+		t.Errorf("expected the stack size to bound the recursion, got %d and %d", small, large)
+	}
+	// More than the thread has is capped to its stack, rather than crashing.
+	if huge := recursionDepth(t, v8.StackSize(1<<40)); huge < large {
+		t.Errorf("expected the thread's stack to bound the recursion, got %d", huge)
+	}
+
+	// The limit holds across sessions, and for callbacks that enter again.
+	iso := v8.NewIsolate(v8.StackSize(64 << 10))
+	defer iso.Dispose()
+	global := v8.NewObjectTemplate(iso)
+	var nested *v8.Context
+	fn := v8.NewFunctionTemplateWithError(iso, func(info *v8.FunctionCallbackInfo) (*v8.Value, error) {
+		return nested.RunScript(`try { (function f() { f() })() } catch (e) { e.name }`, "nested.js")
+	})
+	fatalIf(t, global.Set("nested", fn))
+	ctx := v8.NewContext(iso, global)
+	defer ctx.Close()
+	nested = ctx
+	iso.Lock()
+	val, err := ctx.RunScript(`nested()`, "outer.js")
+	iso.Unlock()
+	fatalIf(t, err)
+	if val.String() != "RangeError" {
+		t.Errorf("expected a RangeError, got %q", val.String())
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+
+// CacheNewStrings makes the isolate keep the JavaScript strings that NewValue
+// makes of Go strings of up to maxLength bytes, up to capacity of them: a
+// string that is made again, such as a tenant ID, route name or configuration
+// value injected on every request, reuses the internalized string made before
+// rather than decoding and allocating it anew. The least recently used string
+// makes room for a new one once the cache is full. The cache is keyed by the
+// bytes of the strings, so each lookup hashes them.
+func CacheNewStrings(capacity, maxLength int) IsolateOption {
+	return isolateOptionFunc(func(opts *isolateOptions) {
+		opts.stringCacheCapacity = capacity
+		opts.stringCacheMaxLength = maxLength
+	})
+}
+
+// StringCacheStats counts the lookups of the strings of NewValue in the cache
+// of an isolate created with CacheNewStrings.
+type StringCacheStats struct {
+	// Hits is the number of strings found in the cache.
+	Hits uint64
+	// Misses is the number of strings that were made and cached.
+	Misses uint64
+	// Length is the number of strings in the cache.
+	Length int
+}
+
+// StringCacheStats returns the counts of the string cache of the isolate,
+// which are all 0 unless it was created with CacheNewStrings.
+func (i *Isolate) StringCacheStats() StringCacheStats {
+	s := C.IsolateStringCacheStats(i.ptr)
+	return StringCacheStats{
+		Hits:   uint64(s.hits),
+		Misses: uint64(s.misses),
+		Length: int(s.length),
+	}
+}
+
+// newStringArg is stringArg for the string of NewValue, which is passed as is
+// when the isolate caches it, as the cache reads the bytes.
+func (i *Isolate) newStringArg(s string) C.StringArg {
+	if len(s) <= i.stringCacheMaxLength {
+		return C.StringArg{data: stringData(s), length: C.int(len(s))}
+	}
+	return stringArg(s)
+}
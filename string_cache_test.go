@@ -0,0 +1,88 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"fmt"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestCacheNewStrings(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.CacheNewStrings(2, 16))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	for _, s := range []string{"tenant-1", "tenant-1", "tenant-2", "", "tenant-1", "ünïcode", strings.Repeat("x", 17)} {
+		val, err := v8.NewValue(iso, s)
+		fatalIf(t, err)
+		if val.String() != s {
+			t.Errorf("expected %q, got %q", s, val.String())
+		}
+		val.Release()
+	}
+	// With room for two, "" makes "tenant-1" go, which is made again and
+	// makes "tenant-2" go; "ünïcode" then makes "" go, which leaves
+	// "tenant-1". The long string is not cached.
+	want := v8.StringCacheStats{Hits: 1, Misses: 5, Length: 2}
+	if got := iso.StringCacheStats(); got != want {
+		t.Errorf("expected %+v, got %+v", want, got)
+	}
+	val, err := v8.NewValue(iso, "tenant-1")
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("tenant", val))
+	res, err := ctx.RunScript(`({[tenant]: 1})["tenant-1"]`, "cache.js")
+	fatalIf(t, err)
+	if res.Int32() != 1 {
+		t.Errorf("expected the cached string to be a key, got %v", res)
+	}
+	if got := iso.StringCacheStats(); got.Hits != 2 {
+		t.Errorf("expected a hit, got %+v", got)
+	}
+}
+
+func TestCacheNewStringsDisabled(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	_, err := v8.NewValue(iso, "tenant-1")
+	fatalIf(t, err)
+	if got := iso.StringCacheStats(); got != (v8.StringCacheStats{}) {
+		t.Errorf("expected no stats, got %+v", got)
+	}
+}
+
+func BenchmarkNewValueString(b *testing.B) {
+	for _, bench := range []struct {
+		name string
+		opts []v8.IsolateOption
+	}{
+		{"Uncached", nil},
+		{"Cached", []v8.IsolateOption{v8.CacheNewStrings(64, 1024)}},
+	} {
+		b.Run(bench.name, func(b *testing.B) {
+			iso := v8.NewIsolate(bench.opts...)
+			defer iso.Dispose()
+			strs := make([]string, 16)
+			for i := range strs {
+				strs[i] = fmt.Sprintf("/api/v1/tenants/%d/route/%s", i, strings.Repeat("é", 200))
+			}
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				val, err := v8.NewValue(iso, strs[i%len(strs)])
+				if err != nil {
+					b.Fatal(err)
+				}
+				val.Release()
+			}
+		})
+	}
+}
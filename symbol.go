@@ -6,7 +6,6 @@ package v8go
 
 import (
 	"fmt"
-	"unsafe"
 
 	// #include <stdlib.h>
 	// #include "v8go.h"
@@ -38,15 +37,16 @@ func symbolByIndex(iso *Isolate, idx C.SymbolIndex) *Symbol {
 	if val == nil {
 		panic(fmt.Errorf("unknown symbol index: %d", idx))
 	}
-	return &Symbol{&Value{val, nil}}
+	return &Symbol{newValue(nil, val)}
 }
 
 // Description returns the string representation of the symbol,
 // e.g. "Symbol.asyncIterator".
 func (sym *Symbol) Description() string {
-	s := C.SymbolDescription(sym.Value.ptr)
-	defer C.free(unsafe.Pointer(s))
-	return C.GoString(s)
+	s, _ := utf8String(func(buf *C.char, cap C.int) C.RtnUtf8 {
+		return C.SymbolDescription(sym.Value.ptr, buf, cap)
+	})
+	return s
 }
 
 // String returns Description().
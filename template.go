@@ -55,6 +55,7 @@ func (t *template) Set(name string, val interface{}, attributes ...PropertyAttri
 		return fmt.Errorf("v8go: unsupported property type `%T`, must be one of string, int32, uint32, int64, uint64, float64, *big.Int, *v8go.Value, *v8go.ObjectTemplate or *v8go.FunctionTemplate", v)
 	}
 	runtime.KeepAlive(t)
+	runtime.KeepAlive(val)
 
 	return nil
 }
@@ -99,14 +100,94 @@ func (t *template) SetSymbol(key *Symbol, val interface{}, attributes ...Propert
 		return fmt.Errorf("v8go: unsupported property type `%T`, must be one of string, int32, uint32, int64, uint64, float64, *big.Int, *v8go.Value, *v8go.ObjectTemplate or *v8go.FunctionTemplate", v)
 	}
 	runtime.KeepAlive(t)
+	runtime.KeepAlive(key)
+	runtime.KeepAlive(val)
 
 	return nil
 }
 
+// SetLazy adds a property to each instance created by this template, whose
+// value is only made from the ObjectTemplate or FunctionTemplate val when it
+// is first accessed in a context, after which it is a plain data property.
+// Use it for host namespaces that only some scripts use, so that contexts do
+// not instantiate them all up front.
+//
+// The templates of an isolate that creates a snapshot are set eagerly, as by
+// Set, so that they are serialized with the context.
+func (t *template) SetLazy(name string, val interface{}, attributes ...PropertyAttribute) error {
+	var ptr C.TemplatePtr
+	switch v := val.(type) {
+	case *ObjectTemplate:
+		ptr = v.ptr
+	case *FunctionTemplate:
+		ptr = v.ptr
+	default:
+		return fmt.Errorf("v8go: unsupported lazy property type `%T`, must be one of *v8go.ObjectTemplate or *v8go.FunctionTemplate", v)
+	}
+	if t.iso.creator != nil {
+		return t.Set(name, val, attributes...)
+	}
+
+	cname := C.CString(name)
+	defer C.free(unsafe.Pointer(cname))
+
+	var attrs PropertyAttribute
+	for _, a := range attributes {
+		attrs |= a
+	}
+	C.TemplateSetLazyTemplate(t.ptr, cname, ptr, C.int(attrs))
+	runtime.KeepAlive(t)
+	runtime.KeepAlive(val)
+	return nil
+}
+
+// Release frees the template before its isolate is disposed, once no more
+// functions or objects are to be made from it; those that were made keep
+// working. The callback of a FunctionTemplate is unregistered once V8 has
+// collected the template along with every function made from it.
+func (t *template) Release() {
+	if t.ptr == nil {
+		return
+	}
+	runtime.SetFinalizer(t, nil)
+	iso := t.iso
+	if s := iso.creator; s != nil {
+		// Unless the template is still tracked, the SnapshotCreator has reset
+		// its handle already.
+		if s.untrackTemplate(t) {
+			C.TemplatesFree(iso.ptr, &t.ptr, 1)
+		} else {
+			C.TemplateFreeWrapper(t.ptr)
+		}
+		t.ptr = nil
+		return
+	}
+	iso.templateMutex.Lock()
+	if iso.templatesDisposed {
+		C.TemplateFreeWrapper(t.ptr)
+	} else {
+		C.TemplatesFree(iso.ptr, &t.ptr, 1)
+	}
+	iso.templateMutex.Unlock()
+	t.ptr = nil
+}
+
 func (t *template) finalizer() {
 	// Using v8::PersistentBase::Reset() wouldn't be thread-safe to do from
-	// this finalizer goroutine so just free the wrapper and let the template
-	// itself get cleaned up when the isolate is disposed.
-	C.TemplateFreeWrapper(t.ptr)
-	t.ptr = nil
+	// this finalizer goroutine, so the handle is reset by the isolate later;
+	// the templates of a SnapshotCreator are reset when its snapshot is
+	// created.
+	iso := t.iso
+	if iso.creator == nil {
+		iso.templateMutex.Lock()
+		if !iso.templatesDisposed {
+			iso.freedTemplates = append(iso.freedTemplates, t.ptr)
+			t.ptr = nil
+		}
+		iso.templateMutex.Unlock()
+	}
+	if t.ptr != nil {
+		C.TemplateFreeWrapper(t.ptr)
+		t.ptr = nil
+	}
 }
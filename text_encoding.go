@@ -0,0 +1,20 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// TextEncoding installs the TextEncoder and TextDecoder classes of the
+// Encoding Standard, for UTF-8, in the global object of the context. They
+// are implemented natively, without calling into Go: TextEncoder.encode
+// writes its string straight into the backing store of the Uint8Array it
+// returns, and encodeInto into the one it is given, while
+// TextDecoder.decode creates its string straight from the bytes of the
+// buffer or view it is given, checking runs of ASCII 16 bytes at a time.
+// TextDecoder supports the fatal and ignoreBOM options and streaming, and
+// throws a RangeError for the labels of encodings other than UTF-8. The
+// memory of the arrays that encode creates counts against the
+// ArrayBufferQuota of the isolate.
+var TextEncoding ContextOption = contextOptionFunc(func(opts *contextOptions) {
+	opts.textEncoding = true
+})
@@ -0,0 +1,106 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestTextEncoding(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+
+	tests := [...]struct {
+		name   string
+		source string
+		out    string
+	}{
+		{"encode ascii", `new TextEncoder().encode("abc").join()`, "97,98,99"},
+		{"encode latin1", `new TextEncoder().encode("aé").join()`, "97,195,169"},
+		{"encode two-byte", `new TextEncoder().encode("€😀").join()`, "226,130,172,240,159,152,128"},
+		{"encode lone surrogate", `new TextEncoder().encode("\ud800").join()`, "239,191,189"},
+		{"encode empty", `new TextEncoder().encode().length`, "0"},
+		{"encode long", `const s = "é".repeat(1000) + "x"; new TextDecoder().decode(new TextEncoder().encode(s)) === s`, "true"},
+		{"encodeInto", `
+			const dst = new Uint8Array(5);
+			const r = new TextEncoder().encodeInto("a€😀", dst);
+			[r.read, r.written, dst.join()].join(";")`, "2;4;97,226,130,172,0"},
+		{"encoding", `[new TextEncoder().encoding, new TextDecoder("UTF8 ").encoding].join()`, "utf-8,utf-8"},
+		{"decode", `new TextDecoder().decode(new Uint8Array([104, 195, 169, 240, 159, 152, 128]))`, "hé😀"},
+		{"decode view", `new TextDecoder().decode(new Uint8Array([0, 104, 105, 0]).subarray(1, 3))`, "hi"},
+		{"decode buffer", `new TextDecoder().decode(new Uint8Array([104, 105]).buffer)`, "hi"},
+		{"decode replacement", `escape(new TextDecoder().decode(new Uint8Array([0xf0, 0x80, 0x80, 0x41, 0xf0, 0x9f, 0x98])))`, "%uFFFD%uFFFD%uFFFDA%uFFFD"},
+		{"decode bom", `[new TextDecoder().decode(new Uint8Array([0xef, 0xbb, 0xbf, 0x41])), new TextDecoder("utf-8", {ignoreBOM: true}).decode(new Uint8Array([0xef, 0xbb, 0xbf])).length].join()`, "A,1"},
+		{"decode stream", `
+			const d = new TextDecoder();
+			const bytes = new TextEncoder().encode("\ufeffé€😀");
+			let s = "";
+			for (const b of bytes) s += d.decode(new Uint8Array([b]), {stream: true});
+			s + d.decode()`, "é€😀"},
+		{"decode fatal", `
+			const d = new TextDecoder("utf-8", {fatal: true});
+			const errors = [];
+			for (const bytes of [[0xc0, 0x80], [0xed, 0xa0, 0x80], [0xe2, 0x82]]) {
+				try { d.decode(new Uint8Array(bytes)); } catch (e) { errors.push(e instanceof TypeError); }
+			}
+			[d.fatal, d.ignoreBOM, ...errors, d.decode(new Uint8Array([0xe2, 0x82]), {stream: true}) === ""].join()`, "true,false,true,true,true,true"},
+		{"errors", `
+			const errors = [];
+			for (const f of [() => new TextDecoder("latin1"), () => TextEncoder(), () => new TextDecoder().decode("x"),
+				() => new TextEncoder().encodeInto("x", []), () => TextDecoder.prototype.decode.call({})]) {
+				try { f(); } catch (e) { errors.push(e.name); }
+			}
+			errors.join()`, "RangeError,TypeError,TypeError,TypeError,TypeError"},
+	}
+	for _, tt := range tests {
+		tt := tt
+		t.Run(tt.name, func(t *testing.T) {
+			ctx := v8.NewContext(iso, v8.TextEncoding)
+			defer ctx.Close()
+			val, err := ctx.RunScript(tt.source, "text.js")
+			fatalIf(t, err)
+			if got := val.String(); got != tt.out {
+				t.Errorf("expected %q, got %q", tt.out, got)
+			}
+		})
+	}
+}
+
+func TestTextEncodingQuota(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.ArrayBufferQuota(1 << 10))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.TextEncoding)
+	defer ctx.Close()
+	_, err := ctx.RunScript(`new TextEncoder().encode("x".repeat(4096))`, "quota.js")
+	if err == nil || !strings.Contains(err.Error(), "allocation failed") {
+		t.Errorf("expected an allocation failure, got %v", err)
+	}
+}
+
+func BenchmarkTextDecoder(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.TextEncoding)
+	defer ctx.Close()
+	fn, _ := ctx.RunScript(`
+		const d = new TextDecoder("utf-8", {fatal: true});
+		const bytes = new TextEncoder().encode("hello, world ".repeat(1000) + "é");
+		() => d.decode(bytes).length`, "bench.js")
+	f, _ := fn.AsFunction()
+	b.SetBytes(13001)
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := f.Call(v8.Undefined(iso)); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
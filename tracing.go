@@ -0,0 +1,118 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"io"
+	"sync"
+	"unsafe"
+)
+
+// The trace event categories of V8 for the execution, compilation and
+// garbage collection of scripts. A category enables the events whose
+// category group lists it.
+const (
+	TraceV8        = "v8"
+	TraceV8Execute = "v8.execute"
+	TraceV8Compile = "disabled-by-default-v8.compile"
+	TraceV8GC      = "disabled-by-default-v8.gc"
+	TraceV8Wasm    = "v8.wasm"
+)
+
+// DefaultTraceEvents is the number of events that a trace keeps, unless
+// TraceConfig.MaxEvents is set.
+const DefaultTraceEvents = 1 << 20
+
+// ErrTracing is returned by StartTracing while a trace is in progress.
+var ErrTracing = errors.New("v8go: a trace is already in progress")
+
+// TraceConfig configures a trace, see StartTracing.
+type TraceConfig struct {
+	// Categories are the categories of the events to record, such as
+	// TraceV8 and TraceV8GC; V8 records the events of no category by
+	// default.
+	Categories []string
+	// MaxEvents is the number of events that the trace keeps; once it is
+	// full, the oldest events are dropped for new ones.
+	MaxEvents int
+}
+
+// Tracer is a trace of the V8 platform in progress, see StartTracing.
+type Tracer struct {
+	w   io.Writer
+	err error
+}
+
+var (
+	tracingMutex sync.Mutex
+	tracer       *Tracer
+)
+
+// StartTracing starts recording the trace events of the categories of
+// config, from every isolate of the process, until Tracer.Stop writes them to
+// w. There can be one trace in progress at a time.
+func StartTracing(w io.Writer, config TraceConfig) (*Tracer, error) {
+	if w == nil {
+		return nil, errors.New("v8go: io.Writer is required")
+	}
+	initV8()
+
+	tracingMutex.Lock()
+	defer tracingMutex.Unlock()
+	if tracer != nil {
+		return nil, ErrTracing
+	}
+	maxEvents := config.MaxEvents
+	if maxEvents <= 0 {
+		maxEvents = DefaultTraceEvents
+	}
+	categories := make([]*C.char, len(config.Categories))
+	for i, c := range config.Categories {
+		categories[i] = C.CString(c)
+		defer C.free(unsafe.Pointer(categories[i]))
+	}
+	var cats **C.char
+	if len(categories) > 0 {
+		cats = &categories[0]
+	}
+	t := &Tracer{w: w}
+	tracer = t
+	if C.StartTracing(cats, C.int(len(categories)), C.size_t(maxEvents)) == 0 {
+		tracer = nil
+		return nil, ErrTracing
+	}
+	return t, nil
+}
+
+// Stop stops the trace and writes its events to the io.Writer of
+// StartTracing, in the JSON trace event format that chrome://tracing and
+// Perfetto load. It returns the first error of the writer, after which the
+// rest of the trace is dropped. Stop is safe to call more than once.
+func (t *Tracer) Stop() error {
+	tracingMutex.Lock()
+	defer tracingMutex.Unlock()
+	if tracer != t {
+		return t.err
+	}
+	C.StopTracing()
+	tracer = nil
+	return t.err
+}
+
+//export goTraceWrite
+func goTraceWrite(data *C.char, size C.int) C.int {
+	// Only called by StopTracing, with tracingMutex held.
+	t := tracer
+	chunk := (*[1 << 30]byte)(unsafe.Pointer(data))[:size:size]
+	if _, err := t.w.Write(chunk); err != nil {
+		t.err = err
+		return 0
+	}
+	return 1
+}
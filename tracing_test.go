@@ -0,0 +1,71 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"bytes"
+	"encoding/json"
+	"errors"
+	"strings"
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+type errWriter struct{}
+
+func (errWriter) Write([]byte) (int, error) { return 0, errors.New("write failed") }
+
+func TestStartTracing(t *testing.T) {
+	var buf bytes.Buffer
+	tracer, err := v8.StartTracing(&buf, v8.TraceConfig{
+		Categories: []string{v8.TraceV8, v8.TraceV8Execute, v8.TraceV8Compile, v8.TraceV8GC},
+	})
+	fatalIf(t, err)
+	if _, err := v8.StartTracing(&buf, v8.TraceConfig{}); err != v8.ErrTracing {
+		t.Errorf("expected ErrTracing for a second trace, got %v", err)
+	}
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	_, err = ctx.RunScript("function add(a, b) { return a + b }; for (let i = 0; i < 1000; i++) add(i, 1)", "trace.js")
+	fatalIf(t, err)
+	iso.LowMemoryNotification()
+
+	fatalIf(t, tracer.Stop())
+	fatalIf(t, tracer.Stop())
+	var trace struct {
+		TraceEvents []struct {
+			Cat  string `json:"cat"`
+			Name string `json:"name"`
+			Ph   string `json:"ph"`
+		} `json:"traceEvents"`
+	}
+	if err := json.Unmarshal(buf.Bytes(), &trace); err != nil {
+		t.Fatalf("expected a JSON trace, got %v: %.200s", err, buf.String())
+	}
+	cats := map[string]bool{}
+	for _, e := range trace.TraceEvents {
+		for _, c := range strings.Split(e.Cat, ",") {
+			cats[c] = true
+		}
+	}
+	for _, c := range []string{v8.TraceV8, v8.TraceV8Execute, v8.TraceV8GC} {
+		if !cats[c] {
+			t.Errorf("expected events of category %q, got %v", c, cats)
+		}
+	}
+
+	// A trace can be started again once stopped, and fails with its writer.
+	tracer, err = v8.StartTracing(errWriter{}, v8.TraceConfig{Categories: []string{v8.TraceV8}, MaxEvents: 10})
+	fatalIf(t, err)
+	_, err = ctx.RunScript("1 + 1", "again.js")
+	fatalIf(t, err)
+	if err := tracer.Stop(); err == nil || err.Error() != "write failed" {
+		t.Errorf("expected the error of the writer, got %v", err)
+	}
+}
@@ -14,11 +14,16 @@ type UnboundScript struct {
 	iso *Isolate
 }
 
-// Run will bind the unbound script to the provided context and run it.
+// Run will bind the unbound script to the provided context and run it. The
+// script is bound to each context once, and the bound script is reused when it
+// runs again in the same context.
 // If the context provided does not belong to the same isolate that the script
 // was compiled in, Run will panic.
 // If an error occurs, it will be of type `JSError`.
 func (u *UnboundScript) Run(ctx *Context) (*Value, error) {
+	if u.ptr == nil {
+		panic("attempted to run an unbound script that has been released")
+	}
 	if ctx.Isolate() != u.iso {
 		panic("attempted to run unbound script in a context that belongs to a different isolate")
 	}
@@ -26,8 +31,27 @@ func (u *UnboundScript) Run(ctx *Context) (*Value, error) {
 	return valueResult(ctx, rtn)
 }
 
-// Create a code cache from the unbound script.
+// Release frees the script, and the scripts bound from it in every context it
+// has run in, without waiting for the isolate to be disposed. Scripts that are
+// replaced while the isolate lives on, such as reloaded code, should be
+// released so that memory usage stays flat. The script must not be used after
+// it has been released; calling Release more than once is a no-op.
+func (u *UnboundScript) Release() {
+	if u == nil || u.ptr == nil {
+		return
+	}
+	C.UnboundScriptRelease(u.ptr)
+	u.ptr = nil
+}
+
+// Create a code cache from the unbound script. The cache includes the
+// functions that have been compiled by the time it is created, so a cache
+// created after the script has run also covers the functions that were
+// compiled lazily while it ran; see CreateCodeCacheAfterRun.
 func (u *UnboundScript) CreateCodeCache() *CompilerCachedData {
+	if u.ptr == nil {
+		panic("attempted to create a code cache from an unbound script that has been released")
+	}
 	rtn := C.UnboundScriptCreateCodeCache(u.iso.ptr, u.ptr)
 
 	cachedData := &CompilerCachedData{
@@ -37,3 +61,25 @@ func (u *UnboundScript) CreateCodeCache() *CompilerCachedData {
 	C.ScriptCompilerCachedDataDelete(rtn)
 	return cachedData
 }
+
+// CreateCodeCacheAfterRun runs the script in each of the contexts, which must
+// belong to the script's isolate, and then creates a code cache from it. After
+// each run, warm is called with the context and the result of the run, if it is
+// not nil, to call into the functions the script defined. Functions compiled by
+// any of the runs are shared by the isolate and included in the one cache, so it
+// merges what each warm-up exercised.
+// If an error occurs in a run it is returned and no cache is created.
+func (u *UnboundScript) CreateCodeCacheAfterRun(warm func(ctx *Context, result *Value) error, contexts ...*Context) (*CompilerCachedData, error) {
+	for _, ctx := range contexts {
+		val, err := u.Run(ctx)
+		if err != nil {
+			return nil, err
+		}
+		if warm != nil {
+			if err := warm(ctx, val); err != nil {
+				return nil, err
+			}
+		}
+	}
+	return u.CreateCodeCache(), nil
+}
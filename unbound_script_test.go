@@ -5,6 +5,8 @@
 package v8go_test
 
 import (
+	"fmt"
+	"strings"
 	"testing"
 
 	v8 "rogchap.com/v8go"
@@ -45,3 +47,183 @@ func TestUnboundScriptRun_OnlyInTheSameIsolate(t *testing.T) {
 		t.Error("expected panic running unbound script in a context belonging to a different isolate")
 	}
 }
+
+func TestUnboundScriptCreateCodeCacheAfterRun(t *testing.T) {
+	t.Parallel()
+
+	const source = `
+		function helper(n) { let s = 0; for (let i = 0; i < n; i++) s += i; return s; }
+		function handler(n) { return helper(n) * 2; }
+		handler;`
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	us, err := iso.CompileUnboundScript(source, "script.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	cold := us.CreateCodeCache()
+
+	ctx1 := v8.NewContext(iso)
+	defer ctx1.Close()
+	ctx2 := v8.NewContext(iso)
+	defer ctx2.Close()
+	ten, err := v8.NewValue(iso, int32(10))
+	fatalIf(t, err)
+	calls := 0
+	warm, err := us.CreateCodeCacheAfterRun(func(ctx *v8.Context, result *v8.Value) error {
+		calls++
+		fn, err := result.AsFunction()
+		if err != nil {
+			return err
+		}
+		_, err = fn.Call(v8.Undefined(iso), ten)
+		return err
+	}, ctx1, ctx2)
+	fatalIf(t, err)
+	if calls != 2 {
+		t.Errorf("expected warm to be called for each context, got %d calls", calls)
+	}
+	if len(warm.Bytes) <= len(cold.Bytes) {
+		t.Errorf("expected the warm cache (%d bytes) to be larger than the cold cache (%d bytes)", len(warm.Bytes), len(cold.Bytes))
+	}
+
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	_, err = iso2.CompileUnboundScript(source, "script.js", v8.CompileOptions{CachedData: warm})
+	fatalIf(t, err)
+	if warm.Rejected {
+		t.Error("expected the warm cache to be accepted")
+	}
+
+	bad, err := iso.CompileUnboundScript("throw new Error('boom')", "bad.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	if _, err := bad.CreateCodeCacheAfterRun(nil, ctx1); err == nil {
+		t.Error("expected the error of the run")
+	}
+}
+
+func TestUnboundScriptRelease(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	us, err := iso.CompileUnboundScript("globalThis.n = (globalThis.n || 0) + 1", "script.js", v8.CompileOptions{})
+	fatalIf(t, err)
+	for i := 1; i <= 3; i++ {
+		val, err := us.Run(ctx)
+		fatalIf(t, err)
+		if val.Integer() != int64(i) {
+			t.Fatalf("expected run %d to return %d, got %v", i, i, val)
+		}
+	}
+
+	// A context closed before the script is released drops its bound script.
+	closed := v8.NewContext(iso)
+	_, err = us.Run(closed)
+	fatalIf(t, err)
+	closed.Close()
+
+	us.Release()
+	us.Release()
+	if recoverPanic(func() { us.Run(ctx) }) == nil {
+		t.Error("expected a panic running a released script")
+	}
+
+	// Reloading scripts reuses the slots of released ones.
+	for i := 0; i < 100; i++ {
+		us, err := iso.CompileUnboundScript("globalThis.n = 0", "reload.js", v8.CompileOptions{})
+		fatalIf(t, err)
+		_, err = us.Run(ctx)
+		fatalIf(t, err)
+		us.Release()
+	}
+	val, err := ctx.RunScript("n", "check.js")
+	fatalIf(t, err)
+	if val.Integer() != 0 {
+		t.Errorf("expected n to be reset, got %v", val)
+	}
+}
+
+// benchScript is a script of many small functions, for the cost of its
+// compilation to show.
+var benchScript = func() string {
+	var sb strings.Builder
+	for i := 0; i < 200; i++ {
+		fmt.Fprintf(&sb, "function f%d(a, b) { const r = []; for (const x of a) r.push(x * %d + b); return r; }\n", i, i)
+	}
+	sb.WriteString("f1([1, 2, 3], 4).length")
+	return sb.String()
+}()
+
+// BenchmarkScriptRun compares compiling and running a script with RunScript,
+// which compiles it each time, to running an UnboundScript compiled once or
+// compiled each time with and without a code cache. The source of each
+// compilation differs, for V8's compilation cache of the isolate not to hit.
+func BenchmarkScriptRun(b *testing.B) {
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	runs := 0
+	source := func(n int) string {
+		runs++
+		return fmt.Sprintf("%s // %d", benchScript, runs)
+	}
+
+	b.Run("RunScript", func(b *testing.B) {
+		b.ReportAllocs()
+		for n := 0; n < b.N; n++ {
+			if _, err := ctx.RunScript(source(n), "bench.js"); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	b.Run("UnboundScriptRun", func(b *testing.B) {
+		b.ReportAllocs()
+		us, err := iso.CompileUnboundScript(benchScript, "bench.js", v8.CompileOptions{})
+		if err != nil {
+			b.Fatal(err)
+		}
+		b.ResetTimer()
+		for n := 0; n < b.N; n++ {
+			if _, err := us.Run(ctx); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	for _, cached := range []bool{false, true} {
+		name := "Compile"
+		if cached {
+			name = "CompileWithCodeCache"
+		}
+		b.Run(name, func(b *testing.B) {
+			b.ReportAllocs()
+			sources := make([]string, b.N)
+			caches := make([]*v8.CompilerCachedData, b.N)
+			for n := range sources {
+				sources[n] = source(n)
+				if cached {
+					// The cache of each source is made in another isolate.
+					other := v8.NewIsolate()
+					us, err := other.CompileUnboundScript(sources[n], "bench.js", v8.CompileOptions{})
+					if err != nil {
+						b.Fatal(err)
+					}
+					caches[n] = us.CreateCodeCache()
+					other.Dispose()
+				}
+			}
+			b.ResetTimer()
+			for n := 0; n < b.N; n++ {
+				us, err := iso.CompileUnboundScript(sources[n], "bench.js", v8.CompileOptions{CachedData: caches[n]})
+				if err != nil {
+					b.Fatal(err)
+				}
+				if _, err := us.Run(ctx); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
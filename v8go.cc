@@ -2,1587 +2,8766 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#ifdef _WIN32
+// rand_s is declared by stdlib.h only when this is defined first.
+#define _CRT_RAND_S
+#endif
 #include "v8go.h"
 
+#include <errno.h>
 #include <stdio.h>
+#include <time.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sys/random.h>
+#include <unistd.h>
+#else
+#define NOMINMAX
+#include <windows.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "_cgo_export.h"
+#include "v8-fast-api-calls.h"
+#include "v8-inspector.h"
+#include "v8-metrics.h"
 
 using namespace v8;
 
-auto default_platform = platform::NewDefaultPlatform();
-auto default_allocator = ArrayBuffer::Allocator::NewDefaultAllocator();
+// The platform is created by Init, with the options that Go has set by then.
+std::unique_ptr<Platform> default_platform;
+// The tracing controller of the platform, which it owns, and its buffer.
+class TraceSession;
+platform::tracing::TracingController* tracing_controller;
+TraceSession* trace_session;
+// The perf map of the process, if Init was asked to write one.
+class PerfMap;
+PerfMap* perf_map;
+class InspectorClient;
+static bool idle_tasks = false;
 
 const int ScriptCompilerNoCompileOptions = ScriptCompiler::kNoCompileOptions;
 const int ScriptCompilerConsumeCodeCache = ScriptCompiler::kConsumeCodeCache;
 const int ScriptCompilerEagerCompile = ScriptCompiler::kEagerCompile;
 
-struct m_ctx {
-  Isolate* iso;
-  std::vector<m_value*> vals;
-  std::vector<m_unboundScript*> unboundScripts;
-  Persistent<Context> ptr;
-};
+const int StackTraceLineNumber = StackTrace::kLineNumber;
+const int StackTraceColumnOffset = StackTrace::kColumnOffset;
+const int StackTraceScriptName = StackTrace::kScriptName;
+const int StackTraceFunctionName = StackTrace::kFunctionName;
+const int StackTraceIsEval = StackTrace::kIsEval;
+const int StackTraceIsConstructor = StackTrace::kIsConstructor;
+const int StackTraceScriptNameOrSourceURL = StackTrace::kScriptNameOrSourceURL;
+const int StackTraceScriptId = StackTrace::kScriptId;
+const int StackTraceOverview = StackTrace::kOverview;
+const int StackTraceDetailed = StackTrace::kDetailed;
+
+// Slab hands out fixed size entries from blocks that are allocated with a bump
+// pointer and only freed, in bulk, when the slab itself is destroyed. Entries
+// are addressed by their slot number; released slots are kept on a free list
+// and handed out again before the bump pointer moves on.
+template <class T, uint32_t N = 256>
+class Slab {
+ public:
+  Slab() = default;
+  Slab(const Slab&) = delete;
+  Slab& operator=(const Slab&) = delete;
+  ~Slab() {
+    for (T* block : blocks_) {
+      delete[] block;
+    }
+  }
 
-struct m_value {
-  Isolate* iso;
-  m_ctx* ctx;
-  Persistent<Value, CopyablePersistentTraits<Value>> ptr;
-};
+  T* Alloc(uint32_t* slot) {
+    if (!free_.empty()) {
+      *slot = free_.back();
+      free_.pop_back();
+    } else {
+      if (size_ % N == 0) {
+        blocks_.push_back(new T[N]());
+      }
+      *slot = size_++;
+    }
+    return At(*slot);
+  }
 
-struct m_template {
-  Isolate* iso;
-  Persistent<Template> ptr;
-};
+  void Free(uint32_t slot) { free_.push_back(slot); }
 
-struct m_unboundScript {
-  Persistent<UnboundScript> ptr;
-};
+  T* At(uint32_t slot) { return &blocks_[slot / N][slot % N]; }
 
-const char* CopyString(std::string str) {
-  int len = str.length();
-  char* mem = (char*)malloc(len + 1);
-  memcpy(mem, str.data(), len);
-  mem[len] = 0;
-  return mem;
-}
+  // Size is the number of slots handed out so far, including free ones.
+  uint32_t Size() const { return size_; }
 
-const char* CopyString(String::Utf8Value& value) {
-  if (value.length() == 0) {
-    return nullptr;
+  // Live is the number of slots in use.
+  uint32_t Live() const { return size_ - free_.size(); }
+
+  // Capacity is the number of entries in the blocks of the slab.
+  uint32_t Capacity() const { return blocks_.size() * N; }
+
+  // Shrink destroys the last blocks of entries, at least one if there are
+  // any, until it has destroyed about budget entries, and returns how many
+  // it destroyed. A slab that has been shrunk must not hand out entries
+  // again.
+  uint32_t Shrink(uint32_t budget) {
+    uint32_t destroyed = 0;
+    while (!blocks_.empty() && (destroyed == 0 || destroyed < budget)) {
+      delete[] blocks_.back();
+      blocks_.pop_back();
+      destroyed += N;
+    }
+    size_ = std::min(size_, Capacity());
+    return destroyed;
   }
-  return CopyString(std::string(*value, value.length()));
-}
 
-static RtnError ExceptionError(TryCatch& try_catch,
-                               Isolate* iso,
-                               Local<Context> ctx) {
-  HandleScope handle_scope(iso);
+ private:
+  std::vector<T*> blocks_;
+  std::vector<uint32_t> free_;
+  uint32_t size_ = 0;
+};
 
-  RtnError rtn = {nullptr, nullptr, nullptr};
+// ArrayBufferAllocator is the allocator of an isolate's array buffers. It
+// keeps count of the bytes it has handed out, which may be capped by a quota,
+// and optionally recycles freed memory in power-of-two size classes rather
+// than returning it to malloc. It is shared with V8, as backing stores may
+// outlive their isolate.
+class ArrayBufferAllocator : public ArrayBuffer::Allocator {
+ public:
+  ArrayBufferAllocator(bool pooled, size_t quota)
+      : pooled_(pooled), quota_(quota) {}
+  ~ArrayBufferAllocator() override {
+    for (std::vector<void*>& free_list : pool_) {
+      for (void* data : free_list) {
+        free(data);
+      }
+    }
+  }
 
-  if (try_catch.HasTerminated()) {
-    rtn.msg =
-        CopyString("ExecutionTerminated: script execution has been terminated");
-    return rtn;
+  void* Allocate(size_t length) override {
+    void* data = Take(length);
+    if (data != nullptr) {
+      memset(data, 0, length);
+      return data;
+    }
+    return Reserve(length) ? Fits(calloc(ClassSize(length), 1), length)
+                           : nullptr;
   }
 
-  String::Utf8Value exception(iso, try_catch.Exception());
-  rtn.msg = CopyString(exception);
+  void* AllocateUninitialized(size_t length) override {
+    void* data = Take(length);
+    if (data != nullptr) {
+      return data;
+    }
+    return Reserve(length) ? Fits(malloc(ClassSize(length)), length) : nullptr;
+  }
 
-  Local<Message> msg = try_catch.Message();
-  if (!msg.IsEmpty()) {
-    String::Utf8Value origin(iso, msg->GetScriptOrigin().ResourceName());
-    std::ostringstream sb;
-    sb << *origin;
-    Maybe<int> line = try_catch.Message()->GetLineNumber(ctx);
-    if (line.IsJust()) {
-      sb << ":" << line.ToChecked();
+  void Free(void* data, size_t length) override {
+    used_ -= length;
+    if (pooled_ && length <= kPoolMaxSize) {
+      std::lock_guard<std::mutex> lock(mu_);
+      std::vector<void*>& free_list = pool_[SizeClass(length)];
+      if (free_list.size() * ClassSize(length) < kPoolClassCacheBytes) {
+        free_list.push_back(data);
+        return;
+      }
     }
-    Maybe<int> start = try_catch.Message()->GetStartColumn(ctx);
-    if (start.IsJust()) {
-      sb << ":"
-         << start.ToChecked() + 1;  // + 1 to match output from stack trace
+    free(data);
+  }
+
+  size_t Used() const { return used_; }
+
+  // Adopt counts length bytes of memory that was allocated elsewhere with
+  // malloc as handed out, if they fit in the quota, and Release stops
+  // counting them; see NewArrayBufferAdopted.
+  bool Adopt(size_t length) { return Reserve(length); }
+  void Release(size_t length) { used_ -= length; }
+
+ private:
+  static const size_t kPoolMinSize = 64;
+  static const size_t kPoolMaxSize = 1 << 20;
+  static const int kPoolClasses = 15;  // 64 bytes to 1MB
+  // How much freed memory each size class holds on to at most.
+  static const size_t kPoolClassCacheBytes = 4 << 20;
+
+  static int SizeClass(size_t length) {
+    int c = 0;
+    for (size_t size = kPoolMinSize; size < length; size <<= 1) {
+      c++;
     }
-    rtn.location = CopyString(sb.str());
+    return c;
   }
 
-  Local<Value> mstack;
-  if (try_catch.StackTrace(ctx).ToLocal(&mstack)) {
-    String::Utf8Value stack(iso, mstack);
-    rtn.stack = CopyString(stack);
+  // ClassSize is the size of the memory allocated for length bytes, which is
+  // rounded up to its size class so that it can be recycled for any length of
+  // the same class.
+  size_t ClassSize(size_t length) const {
+    if (!pooled_ || length > kPoolMaxSize) {
+      return length;
+    }
+    return kPoolMinSize << SizeClass(length);
   }
 
-  return rtn;
-}
+  bool Reserve(size_t length) {
+    if (used_.fetch_add(length) + length > quota_) {
+      used_ -= length;
+      return false;
+    }
+    return true;
+  }
 
-m_value* tracked_value(m_ctx* ctx, m_value* val) {
-  // (rogchap) we track values against a context so that when the context is
-  // closed (either manually or GC'd by Go) we can also release all the
-  // values associated with the context; previously the Go GC would not run
-  // quickly enough, as it has no understanding of the C memory allocation size.
-  // By doing so we hold pointers to all values that are created/returned to Go
-  // until the context is released; this is a compromise.
-  // Ideally we would be able to delete the value object and cancel the
-  // finalizer on the Go side, but we currently don't pass the Go ptr, but
-  // rather the C ptr. A potential future iteration would be to use an
-  // unordered_map, where we could do O(1) lookups for the value, but then know
-  // if the object has been finalized or not by being in the map or not. This
-  // would require some ref id for the value rather than passing the ptr between
-  // Go <--> C, which would be a significant change, as there are places where
-  // we get the context from the value, but if we then need the context to get
-  // the value, we would be in a circular bind.
-  ctx->vals.push_back(val);
+  void* Fits(void* data, size_t length) {
+    if (data == nullptr) {
+      used_ -= length;
+    }
+    return data;
+  }
 
-  return val;
-}
+  // Take returns recycled memory for length bytes, if there is any.
+  void* Take(size_t length) {
+    if (!pooled_ || length > kPoolMaxSize) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    std::vector<void*>& free_list = pool_[SizeClass(length)];
+    if (free_list.empty() || !Reserve(length)) {
+      return nullptr;
+    }
+    void* data = free_list.back();
+    free_list.pop_back();
+    return data;
+  }
 
-m_unboundScript* tracked_unbound_script(m_ctx* ctx, m_unboundScript* us) {
-  ctx->unboundScripts.push_back(us);
+  const bool pooled_;
+  const size_t quota_;
+  std::atomic<size_t> used_{0};
+  std::mutex mu_;
+  std::vector<void*> pool_[kPoolClasses];
+};
 
-  return us;
-}
+struct m_value {
+  Isolate* iso;
+  m_ctx* ctx;
+  // slot is the position of the value in the context's value slab; the
+  // generation is bumped every time the slot is released. References that
+  // may outlive the value, those of Go, value scopes and deferred releases,
+  // keep the generation they were made at, and release_value_of releases the
+  // slot only if it still has it, as it may be free or hold a newer value.
+  uint32_t slot;
+  uint32_t gen;
+  Persistent<Value, CopyablePersistentTraits<Value>> ptr;
+};
 
-extern "C" {
+static_assert(offsetof(m_value, gen) == offsetof(ValueHead, gen),
+              "ValueHead must match the head of m_value");
 
-/********** Isolate **********/
+// A value whose Go Value has been finalized, queued for release by the next
+// call into its context, see ValueReleaseDeferred.
+struct m_deferredRelease {
+  m_value* val;
+  uint32_t gen;
+  m_deferredRelease* next;
+};
 
-#define ISOLATE_SCOPE(iso)           \
-  Locker locker(iso);                \
-  Isolate::Scope isolate_scope(iso); \
-  HandleScope handle_scope(iso);
+struct m_consumeTask {
+  std::unique_ptr<ScriptCompiler::ConsumeCodeCacheTask> task;
+};
 
-#define ISOLATE_SCOPE_INTERNAL_CONTEXT(iso) \
-  ISOLATE_SCOPE(iso);                       \
-  m_ctx* ctx = isolateInternalContext(iso);
+struct m_unboundScript {
+  Persistent<UnboundScript> ptr;
+  // The context whose slab holds the script, and its slot there.
+  m_ctx* ctx;
+  uint32_t slot;
+  // The contexts that cache a Script bound from this script, see
+  // UnboundScriptRun.
+  std::vector<m_ctx*> boundIn;
+};
 
-void Init() {
-#ifdef _WIN32
-  V8::InitializeExternalStartupData(".");
-#endif
-  V8::InitializePlatform(default_platform.get());
-  V8::Initialize();
-  return;
-}
+struct m_module {
+  Global<Module> ptr;
+  m_ctx* ctx;
+  uint32_t slot;
+};
 
-IsolatePtr NewIsolate() {
-  Isolate::CreateParams params;
-  params.array_buffer_allocator = default_allocator;
-  Isolate* iso = Isolate::New(params);
-  Locker locker(iso);
-  Isolate::Scope isolate_scope(iso);
-  HandleScope handle_scope(iso);
+// A function call whose function, receiver and argument slots are kept
+// between calls, see FunctionPrepareCall. Go writes the arguments into args
+// in place, with the values of CALLBACK_ARG_VALUE arguments in values.
+struct m_preparedCall {
+  Global<Function> fn;
+  Global<Value> recv;
+  std::vector<CallbackArg> args;
+  std::vector<ValuePtr> values;
+  m_ctx* ctx;
+  uint32_t slot;
+};
 
-  iso->SetCaptureStackTraceForUncaughtExceptions(true);
+// A reference to a value that was created inside a value scope, along with
+// the generation of its slot at the time, so that values released before the
+// scope exits are not released a second time.
+struct m_scopedValue {
+  m_value* val;
+  uint32_t gen;
+};
 
-  // Create a Context for internal use
-  m_ctx* ctx = new m_ctx;
-  ctx->ptr.Reset(iso, Context::New(iso));
-  ctx->iso = iso;
-  iso->SetData(0, ctx);
+// The console delegate of V8, from src/debug/interface-types.h, which is not
+// one of the headers of deps/include. The methods are in the order of the
+// vtable that the console builtins of the library call into, so this block
+// must be synced with that header of the new version whenever V8 is upgraded.
+static_assert(V8_MAJOR_VERSION == 9 && V8_MINOR_VERSION == 7,
+              "the v8::debug console delegate below is that of V8 9.7");
+namespace v8 {
+namespace debug {
+
+class ConsoleCallArguments : private FunctionCallbackInfo<Value> {
+ public:
+  int Length() const { return FunctionCallbackInfo<Value>::Length(); }
+  Local<Value> operator[](int i) const {
+    return FunctionCallbackInfo<Value>::operator[](i);
+  }
+};
 
-  return iso;
-}
+class ConsoleContext {
+ public:
+  int id() const { return id_; }
+  Local<String> name() const { return name_; }
 
-static inline m_ctx* isolateInternalContext(Isolate* iso) {
-  return static_cast<m_ctx*>(iso->GetData(0));
-}
+ private:
+  int id_;
+  Local<String> name_;
+};
 
-void IsolatePerformMicrotaskCheckpoint(IsolatePtr iso) {
-  ISOLATE_SCOPE(iso)
-  iso->PerformMicrotaskCheckpoint();
-}
+#define CONSOLE_DELEGATE_METHOD(name) \
+  virtual void name(const ConsoleCallArguments&, const ConsoleContext&) {}
+
+class ConsoleDelegate {
+ public:
+  CONSOLE_DELEGATE_METHOD(Debug)
+  CONSOLE_DELEGATE_METHOD(Error)
+  CONSOLE_DELEGATE_METHOD(Info)
+  CONSOLE_DELEGATE_METHOD(Log)
+  CONSOLE_DELEGATE_METHOD(Warn)
+  CONSOLE_DELEGATE_METHOD(Dir)
+  CONSOLE_DELEGATE_METHOD(DirXml)
+  CONSOLE_DELEGATE_METHOD(Table)
+  CONSOLE_DELEGATE_METHOD(Trace)
+  CONSOLE_DELEGATE_METHOD(Group)
+  CONSOLE_DELEGATE_METHOD(GroupCollapsed)
+  CONSOLE_DELEGATE_METHOD(GroupEnd)
+  CONSOLE_DELEGATE_METHOD(Clear)
+  CONSOLE_DELEGATE_METHOD(Count)
+  CONSOLE_DELEGATE_METHOD(CountReset)
+  CONSOLE_DELEGATE_METHOD(Assert)
+  CONSOLE_DELEGATE_METHOD(Profile)
+  CONSOLE_DELEGATE_METHOD(ProfileEnd)
+  CONSOLE_DELEGATE_METHOD(Time)
+  CONSOLE_DELEGATE_METHOD(TimeLog)
+  CONSOLE_DELEGATE_METHOD(TimeEnd)
+  CONSOLE_DELEGATE_METHOD(TimeStamp)
+  virtual ~ConsoleDelegate() = default;
+};
 
-void IsolateDispose(IsolatePtr iso) {
-  if (iso == nullptr) {
-    return;
+#undef CONSOLE_DELEGATE_METHOD
+
+void SetConsoleDelegate(Isolate* isolate, ConsoleDelegate* delegate);
+
+}  // namespace debug
+}  // namespace v8
+
+// ConsoleRing buffers the console messages of a context for Go to drain,
+// keeping the latest of them: a message that finds the ring full drops the
+// oldest one. Messages are pushed with the isolate's lock and drained without
+// it, under the lock of the ring.
+class ConsoleRing {
+ public:
+  explicit ConsoleRing(size_t capacity) : messages_(capacity) {}
+
+  void Push(int level, std::string text) {
+    int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size_ == messages_.size()) {
+      head_ = (head_ + 1) % messages_.size();
+      size_--;
+      dropped_++;
+    }
+    Message& m = messages_[(head_ + size_) % messages_.size()];
+    m.level = level;
+    m.time = time;
+    m.text = std::move(text);
+    size_++;
   }
-  ContextFree(isolateInternalContext(iso));
 
-  iso->Dispose();
-}
+  size_t Drain(ConsoleRecord* records,
+               size_t n,
+               char* buf,
+               size_t buf_len,
+               uint64_t* dropped) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t i = 0;
+    size_t used = 0;
+    for (; i < n && i < size_; i++) {
+      Message& m = messages_[(head_ + i) % messages_.size()];
+      if (m.text.size() > buf_len - used) {
+        break;
+      }
+      memcpy(buf + used, m.text.data(), m.text.size());
+      records[i] = {m.level, static_cast<int>(m.text.size()), m.time};
+      used += m.text.size();
+      std::string().swap(m.text);
+    }
+    head_ = (head_ + i) % messages_.size();
+    size_ -= i;
+    *dropped = dropped_;
+    dropped_ = 0;
+    return i;
+  }
 
-void IsolateTerminateExecution(IsolatePtr iso) {
-  iso->TerminateExecution();
-}
+ private:
+  struct Message {
+    int level;
+    int64_t time;
+    std::string text;
+  };
 
-int IsolateIsExecutionTerminating(IsolatePtr iso) {
-  return iso->IsExecutionTerminating();
-}
+  std::mutex mutex_;
+  std::vector<Message> messages_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  uint64_t dropped_ = 0;
+};
 
-IsolateHStatistics IsolationGetHeapStatistics(IsolatePtr iso) {
-  if (iso == nullptr) {
-    return IsolateHStatistics{0};
-  }
-  v8::HeapStatistics hs;
-  iso->GetHeapStatistics(&hs);
+// A timer of setTimeout or setInterval, see ContextInstallTimers.
+struct m_timer {
+  Global<Function> fn;
+  std::vector<Global<Value>> args;
+  // The interval in milliseconds of a timer of setInterval, or -1.
+  double interval;
+};
 
-  return IsolateHStatistics{hs.total_heap_size(),
-                            hs.total_heap_size_executable(),
-                            hs.total_physical_size(),
-                            hs.total_available_size(),
-                            hs.used_heap_size(),
-                            hs.heap_size_limit(),
-                            hs.malloced_memory(),
-                            hs.external_memory(),
-                            hs.peak_malloced_memory(),
-                            hs.number_of_native_contexts(),
-                            hs.number_of_detached_contexts()};
-}
+// An entry of the timer heap of a context. The entries of cleared timers are
+// left in the heap and skipped when they come up.
+struct m_timerDue {
+  // The platform's monotonic time in milliseconds at which the timer is due.
+  double due;
+  uint32_t id;
 
-RtnUnboundScript IsolateCompileUnboundScript(IsolatePtr iso,
-                                             const char* s,
-                                             const char* o,
-                                             CompileOptions opts) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  TryCatch try_catch(iso);
-  Local<Context> local_ctx = ctx->ptr.Get(iso);
-  Context::Scope context_scope(local_ctx);
+  bool operator>(const m_timerDue& other) const {
+    return due > other.due || (due == other.due && id > other.id);
+  }
+};
 
-  RtnUnboundScript rtn = {};
+// The clock of the performance object of a context, which the object holds
+// in its internal field, and which is freed once the object is collected.
+struct m_performance {
+  Global<Object> handle;
+  // The platform's monotonic time in milliseconds that performance.now counts
+  // from, and the resolution that it is coarsened to, or 0.
+  double origin;
+  double resolution;
+};
 
-  Local<String> src =
-      String::NewFromUtf8(iso, s, NewStringType::kNormal).ToLocalChecked();
-  Local<String> ogn =
-      String::NewFromUtf8(iso, o, NewStringType::kNormal).ToLocalChecked();
+struct m_ctx {
+  Isolate* iso;
+  int ref;
+  Slab<m_value> vals;
+  Slab<m_unboundScript> unboundScripts;
+  // Values created while a value scope is open, and the start of each open
+  // scope within scopedVals; see ContextEnterValueScope.
+  std::vector<m_scopedValue> scopedVals;
+  std::vector<size_t> scopeMarks;
+  // Scripts bound to this context by UnboundScriptRun, so that running an
+  // unbound script again does not bind it again.
+  std::unordered_map<m_unboundScript*, Global<Script>> boundScripts;
+  // Modules compiled in this context, and an index of them by their identity
+  // hash so that the module resolver can identify a referrer.
+  Slab<m_module> modules;
+  Slab<m_preparedCall> preparedCalls;
+  std::unordered_multimap<int, m_module*> moduleIndex;
+  // The Go module resolver of the InstantiateModule call in progress.
+  int moduleResolverRef = 0;
+  // The microtask queue of the context, if it has one of its own rather
+  // than the isolate's default queue; it outlives the context's handle.
+  std::unique_ptr<MicrotaskQueue> microtasks;
+  // The timers of setTimeout and setInterval by id, and the heap of their
+  // due times; see ContextRunTimers.
+  std::unordered_map<uint32_t, m_timer> timers;
+  std::priority_queue<m_timerDue,
+                      std::vector<m_timerDue>,
+                      std::greater<m_timerDue>>
+      timerHeap;
+  uint32_t timerSeq = 0;
+  // The promises of Atomics.waitAsync that have not settled yet, see
+  // ContextTrackAtomicsWaitAsync.
+  int asyncWaits = 0;
+  // The native function that calls the Go callbacks of promise
+  // continuations, and the original Function.prototype.bind that binds their
+  // refs to it; see promiseContinuation.
+  Global<Function> continuationDispatch;
+  Global<Function> continuationBind;
+  // Whether the context is known to the isolate's inspector, see
+  // ContextNewInspectorSession.
+  bool inspected = false;
+  // The values queued by ValueReleaseDeferred, pushed without the isolate's
+  // lock and drained with it.
+  std::atomic<m_deferredRelease*> deferredReleases{nullptr};
+  // The console messages of the context, if its isolate buffers them.
+  std::unique_ptr<ConsoleRing> console;
+  Persistent<Context> ptr;
+};
 
-  ScriptCompiler::CompileOptions option =
-      static_cast<ScriptCompiler::CompileOptions>(opts.compileOption);
+// GCEventRing buffers the GC events of an isolate for Go to drain. The
+// isolate's GC callbacks push events and Go pops them, from any thread and
+// without the isolate's lock; events that find the ring full are dropped.
+class GCEventRing {
+ public:
+  explicit GCEventRing(size_t capacity)
+      : events_(new GCEvent[capacity]), capacity_(capacity) {}
+
+  static void Prologue(Isolate* iso, GCType type, GCCallbackFlags, void* data) {
+    GCEventRing* ring = static_cast<GCEventRing*>(data);
+    HeapStatistics hs;
+    iso->GetHeapStatistics(&hs);
+    // The start is reported as a wall clock time, while the duration is
+    // measured with the steady clock, which does not jump when the wall
+    // clock is set.
+    ring->startTime_ = std::chrono::system_clock::now();
+    ring->start_ = std::chrono::steady_clock::now();
+    ring->usedBefore_ = hs.used_heap_size();
+  }
 
-  ScriptCompiler::CachedData* cached_data = nullptr;
+  static void Epilogue(Isolate* iso, GCType type, GCCallbackFlags, void* data) {
+    GCEventRing* ring = static_cast<GCEventRing*>(data);
+    HeapStatistics hs;
+    iso->GetHeapStatistics(&hs);
+    auto duration = std::chrono::steady_clock::now() - ring->start_;
+    ring->Push(GCEvent{
+        type,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            ring->startTime_.time_since_epoch())
+            .count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+        ring->usedBefore_, hs.used_heap_size()});
+  }
 
-  if (opts.cachedData.data) {
-    cached_data = new ScriptCompiler::CachedData(opts.cachedData.data,
-                                                 opts.cachedData.length);
+  // Drain moves up to n events to events, returning how many it moved, and
+  // the number of events dropped since the last call to dropped.
+  size_t Drain(GCEvent* events, size_t n, uint64_t* dropped) {
+    std::lock_guard<std::mutex> lock(drain_);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    n = std::min<uint64_t>(n, head - tail);
+    for (size_t i = 0; i < n; i++) {
+      events[i] = events_[(tail + i) % capacity_];
+    }
+    tail_.store(tail + n, std::memory_order_release);
+    *dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    return n;
   }
 
-  ScriptOrigin script_origin(ogn);
+ private:
+  void Push(const GCEvent& event) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == capacity_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    events_[head % capacity_] = event;
+    head_.store(head + 1, std::memory_order_release);
+  }
 
-  ScriptCompiler::Source source(src, script_origin, cached_data);
+  std::unique_ptr<GCEvent[]> events_;
+  const size_t capacity_;
+  // The number of events pushed and popped so far.
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+  // Serializes the Go side, which may drain from several goroutines.
+  std::mutex drain_;
+  // The GC in progress, between the prologue and the epilogue.
+  std::chrono::system_clock::time_point startTime_;
+  std::chrono::steady_clock::time_point start_;
+  size_t usedBefore_ = 0;
+};
 
-  Local<UnboundScript> unbound_script;
-  if (!ScriptCompiler::CompileUnboundScript(iso, &source, option)
-           .ToLocal(&unbound_script)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
-  };
+// histogramAdd records an event of the given duration in h, whose min is -1
+// until the first event.
+static void histogramAdd(MetricHistogram& h, int64_t duration) {
+  h.count++;
+  h.sum += duration;
+  if (h.min < 0 || duration < h.min) {
+    h.min = duration;
+  }
+  h.max = std::max(h.max, duration);
+  int bucket = 0;
+  while (bucket < METRIC_BUCKETS - 1 && duration >= (int64_t(1) << bucket)) {
+    bucket++;
+  }
+  h.buckets[bucket]++;
+}
+
+// MetricsRecorder collects the engine metrics that V8 records for an isolate
+// into histograms, see IsolateMetrics. V8 calls it on the isolate's thread,
+// delaying the events of background work to foreground tasks, and Go reads it
+// from any thread.
+class MetricsRecorder : public metrics::Recorder {
+ public:
+  MetricsRecorder() {
+    for (MetricHistogram& h : metrics_.histograms) {
+      h.min = -1;
+    }
+  }
 
-  if (cached_data) {
-    rtn.cachedDataRejected = cached_data->rejected;
+  // V8 only measures the garbage collections of the C++ heap for the
+  // recorder, which v8go does not have; those of the JavaScript heap are
+  // timed by the isolate's GC callbacks.
+  static void Prologue(Isolate* iso, GCType type, GCCallbackFlags, void* data) {
+    MetricsRecorder* recorder = static_cast<MetricsRecorder*>(data);
+    HeapStatistics hs;
+    iso->GetHeapStatistics(&hs);
+    recorder->gcStart_ = std::chrono::steady_clock::now();
+    recorder->gcUsedBefore_ = hs.used_heap_size();
   }
 
-  m_unboundScript* us = new m_unboundScript;
-  us->ptr.Reset(iso, unbound_script);
-  rtn.ptr = tracked_unbound_script(ctx, us);
-  return rtn;
-}
+  static void Epilogue(Isolate* iso, GCType type, GCCallbackFlags, void* data) {
+    MetricsRecorder* recorder = static_cast<MetricsRecorder*>(data);
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - recorder->gcStart_)
+                     .count();
+    HeapStatistics hs;
+    iso->GetHeapStatistics(&hs);
+    std::lock_guard<std::mutex> lock(recorder->mutex_);
+    if (type == kGCTypeScavenge) {
+      recorder->add(METRIC_GC_YOUNG_CYCLE, us);
+    } else if (type == kGCTypeMarkSweepCompact) {
+      recorder->add(METRIC_GC_FULL_CYCLE, us);
+      if (hs.used_heap_size() < recorder->gcUsedBefore_) {
+        recorder->metrics_.gcFullFreed +=
+            recorder->gcUsedBefore_ - hs.used_heap_size();
+      }
+    }
+  }
 
-/********** Exceptions & Errors **********/
+  void AddMainThreadEvent(
+      const metrics::GarbageCollectionFullMainThreadIncrementalMark& event,
+      ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(METRIC_GC_FULL_INCREMENTAL_MARK, event.wall_clock_duration_in_us);
+  }
 
-ValuePtr IsolateThrowException(IsolatePtr iso, ValuePtr value) {
-  ISOLATE_SCOPE(iso);
-  m_ctx* ctx = value->ctx;
+  void AddMainThreadEvent(
+      const metrics::GarbageCollectionFullMainThreadBatchedIncrementalMark&
+          batch,
+      ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& event : batch.events) {
+      add(METRIC_GC_FULL_INCREMENTAL_MARK, event.wall_clock_duration_in_us);
+    }
+  }
 
-  Local<Value> throw_ret_val = iso->ThrowException(value->ptr.Get(iso));
+  void AddMainThreadEvent(
+      const metrics::GarbageCollectionFullMainThreadIncrementalSweep& event,
+      ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(METRIC_GC_FULL_INCREMENTAL_SWEEP, event.wall_clock_duration_in_us);
+  }
 
-  m_value* new_val = new m_value;
-  new_val->iso = iso;
-  new_val->ctx = ctx;
-  new_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, throw_ret_val);
+  void AddMainThreadEvent(
+      const metrics::GarbageCollectionFullMainThreadBatchedIncrementalSweep&
+          batch,
+      ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& event : batch.events) {
+      add(METRIC_GC_FULL_INCREMENTAL_SWEEP, event.wall_clock_duration_in_us);
+    }
+  }
 
-  return tracked_value(ctx, new_val);
-}
+  void AddMainThreadEvent(const metrics::WasmModuleDecoded& event,
+                          ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(METRIC_WASM_MODULE_DECODED, event.wall_clock_duration_in_us);
+  }
 
-/********** CpuProfiler **********/
+  void AddMainThreadEvent(const metrics::WasmModuleCompiled& event,
+                          ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(METRIC_WASM_MODULE_COMPILED, event.wall_clock_duration_in_us);
+  }
 
-CPUProfiler* NewCPUProfiler(IsolatePtr iso_ptr) {
-  Isolate* iso = static_cast<Isolate*>(iso_ptr);
-  Locker locker(iso);
-  Isolate::Scope isolate_scope(iso);
-  HandleScope handle_scope(iso);
+  void AddMainThreadEvent(const metrics::WasmModuleInstantiated& event,
+                          ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(METRIC_WASM_MODULE_INSTANTIATED, event.wall_clock_duration_in_us);
+  }
 
-  CPUProfiler* c = new CPUProfiler;
-  c->iso = iso;
-  c->ptr = CpuProfiler::New(iso);
-  return c;
-}
+  void AddMainThreadEvent(const metrics::WasmModuleTieredUp& event,
+                          ContextId) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    add(METRIC_WASM_MODULE_TIERED_UP, event.wall_clock_duration_in_us);
+  }
 
-void CPUProfilerDispose(CPUProfiler* profiler) {
-  if (profiler->ptr == nullptr) {
-    return;
+  void AddThreadSafeEvent(const metrics::WasmModulesPerIsolate& event) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    metrics_.wasmModules = event.count;
   }
-  profiler->ptr->Dispose();
 
-  delete profiler;
-}
+  EngineMetrics Get() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return metrics_;
+  }
 
-void CPUProfilerStartProfiling(CPUProfiler* profiler, const char* title) {
-  if (profiler->iso == nullptr) {
-    return;
+ private:
+  // add records an event that took us microseconds; V8 reports -1 for
+  // durations it did not measure.
+  void add(MetricKind kind, int64_t us) {
+    if (us < 0) {
+      return;
+    }
+    histogramAdd(metrics_.histograms[kind], us);
   }
 
-  Locker locker(profiler->iso);
-  Isolate::Scope isolate_scope(profiler->iso);
-  HandleScope handle_scope(profiler->iso);
+  std::mutex mutex_;
+  EngineMetrics metrics_ = {};
+  // The garbage collection in progress, between the prologue and the
+  // epilogue.
+  std::chrono::steady_clock::time_point gcStart_;
+  size_t gcUsedBefore_ = 0;
+};
 
-  Local<String> title_str =
-      String::NewFromUtf8(profiler->iso, title, NewStringType::kNormal)
-          .ToLocalChecked();
-  profiler->ptr->StartProfiling(title_str);
-}
+// A streaming compilation of a WebAssembly module, whose bytes Go feeds to
+// the WasmStreaming of WebAssembly.compileStreaming once StreamWasmModule has
+// been called with its id; see ContextNewWasmStream.
+struct m_wasmStream {
+  m_ctx* ctx;
+  std::shared_ptr<WasmStreaming> streaming;
+  Global<Promise> promise;
+  // The serialized code to deserialize in place of compiling, which must
+  // outlive the compilation.
+  std::vector<uint8_t> cache;
+  bool cacheAccepted;
+};
 
-CPUProfileNode* NewCPUProfileNode(const CpuProfileNode* ptr_) {
-  int count = ptr_->GetChildrenCount();
-  CPUProfileNode** children = new CPUProfileNode*[count];
-  for (int i = 0; i < count; ++i) {
-    children[i] = NewCPUProfileNode(ptr_->GetChild(i));
+// Per isolate state, stored in the isolate's data slot 0.
+struct m_isolate;
+
+// A weak handle on a function template, which tells Go that the template's
+// callback can be unregistered once V8 has collected the template, that is
+// once the template is released and no function made from it is left.
+struct m_callbackWatch {
+  m_isolate* data;
+  int ref;
+  Global<FunctionTemplate> handle;
+};
+
+// A weak handle on an object, which tells Go that the object has been
+// collected so that the finalizer that Go registered as ref can run.
+struct m_weakObject {
+  m_isolate* data;
+  int ref;
+  Global<Object> handle;
+};
+
+// BytesLRU holds up to a capacity of values of type T by keys of bytes, the
+// least recently used of which makes room for a new one once it is full.
+template <typename T>
+class BytesLRU {
+ public:
+  explicit BytesLRU(size_t capacity) : capacity_(capacity) {
+    index_.reserve(capacity);
   }
 
-  CPUProfileNode* root = new CPUProfileNode{
-      ptr_,
-      ptr_->GetScriptResourceNameStr(),
-      ptr_->GetFunctionNameStr(),
-      ptr_->GetLineNumber(),
-      ptr_->GetColumnNumber(),
-      count,
-      children,
-  };
-  return root;
-}
+  // Find returns the value of the key, or nullptr if there is none, and
+  // counts a hit or a miss.
+  T* Find(const char* data, size_t length) {
+    auto it = index_.find(Key{data, length});
+    if (it == index_.end()) {
+      misses_++;
+      return nullptr;
+    }
+    hits_++;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value;
+  }
 
-CPUProfile* CPUProfilerStopProfiling(CPUProfiler* profiler, const char* title) {
-  if (profiler->iso == nullptr) {
-    return nullptr;
+  // Insert returns the value of a new entry for the key, which must not be
+  // in the cache; it is the reused value of the oldest entry if the cache is
+  // full.
+  T& Insert(const char* data, size_t length) {
+    if (entries_.size() < capacity_) {
+      entries_.emplace_front();
+    } else {
+      Entry& oldest = entries_.back();
+      index_.erase(Key{oldest.bytes.data(), oldest.bytes.size()});
+      entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+    }
+    Entry& entry = entries_.front();
+    entry.bytes.assign(data, length);
+    index_.emplace(Key{entry.bytes.data(), entry.bytes.size()},
+                   entries_.begin());
+    return entry.value;
   }
 
-  Locker locker(profiler->iso);
-  Isolate::Scope isolate_scope(profiler->iso);
-  HandleScope handle_scope(profiler->iso);
+  CacheStats Stats() const {
+    return CacheStats{hits_, misses_, entries_.size()};
+  }
 
-  Local<String> title_str =
-      String::NewFromUtf8(profiler->iso, title, NewStringType::kNormal)
-          .ToLocalChecked();
+ private:
+  struct Entry {
+    std::string bytes;
+    T value;
+  };
 
-  CPUProfile* profile = new CPUProfile;
-  profile->ptr = profiler->ptr->StopProfiling(title_str);
+  // The bytes of a key, which the keys of the index borrow from the entries.
+  struct Key {
+    const char* data;
+    size_t length;
 
-  Local<String> str = profile->ptr->GetTitle();
-  String::Utf8Value t(profiler->iso, str);
-  profile->title = CopyString(t);
+    bool operator==(const Key& other) const {
+      return length == other.length &&
+             (length == 0 || memcmp(data, other.data, length) == 0);
+    }
+  };
 
-  CPUProfileNode* root = NewCPUProfileNode(profile->ptr->GetTopDownRoot());
-  profile->root = root;
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      // FNV-1a
+      uint32_t hash = 2166136261u;
+      for (size_t i = 0; i < key.length; i++) {
+        hash = (hash ^ uint8_t(key.data[i])) * 16777619u;
+      }
+      return hash;
+    }
+  };
 
-  profile->startTime = profile->ptr->GetStartTime();
-  profile->endTime = profile->ptr->GetEndTime();
+  size_t capacity_;
+  // The entries, most recently used first.
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator, KeyHash> index_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
 
-  return profile;
-}
+// StringCache keeps the internalized strings that NewValueString made of the
+// recently used Go strings of up to a maximum length, by their UTF-8 bytes,
+// so that a string that is made again is neither decoded nor allocated on
+// the heap.
+class StringCache {
+ public:
+  StringCache(size_t capacity, int maxLength)
+      : strings_(capacity), maxLength_(maxLength) {}
+
+  // Get returns the cached string of the bytes of str, making and caching
+  // it if there is none. str must not be external.
+  MaybeLocal<String> Get(Isolate* iso, StringArg str) {
+    Global<String>* cached = strings_.Find(str.data, str.length);
+    if (cached != nullptr) {
+      return cached->Get(iso);
+    }
+    Local<String> local;
+    if (!String::NewFromUtf8(iso, str.data, NewStringType::kInternalized,
+                             str.length)
+             .ToLocal(&local)) {
+      return MaybeLocal<String>();
+    }
+    strings_.Insert(str.data, str.length).Reset(iso, local);
+    return local;
+  }
 
-void CPUProfileNodeDelete(CPUProfileNode* node) {
-  for (int i = 0; i < node->childrenCount; ++i) {
-    CPUProfileNodeDelete(node->children[i]);
+  // Caches reports whether str is one that Get caches.
+  bool Caches(StringArg str) const {
+    return !str.external && str.length <= maxLength_;
   }
 
-  delete[] node->children;
-  delete node;
-}
+  CacheStats Stats() const { return strings_.Stats(); }
 
-void CPUProfileDelete(CPUProfile* profile) {
-  if (profile->ptr == nullptr) {
-    return;
-  }
-  profile->ptr->Delete();
-  free((void*)profile->title);
+ private:
+  BytesLRU<Global<String>> strings_;
+  int maxLength_;
+};
 
-  CPUProfileNodeDelete(profile->root);
+// The counters of the calls into the shim of an isolate created with
+// IsolateOptions.shimStats, see IsolateShimStats. They are only written with
+// the isolate's Locker held.
+struct m_shimStats {
+  // The calls by the index of the function that made them, see shimSite.
+  std::vector<uint64_t> calls;
+  // Nanoseconds spent waiting to take the Locker.
+  int64_t lockWaitTotal = 0;
+  int64_t lockWaitMax = 0;
+  uint64_t valuesAllocated = 0;
+  uint64_t valuesFreed = 0;
+};
 
-  delete profile;
-}
+// The largest console message that is buffered; longer ones are truncated.
+static const int kConsoleMessageMax = 16 << 10;
 
-/********** Template **********/
+// ConsoleBuffer is the console of an isolate created with BufferConsole. It
+// formats the arguments of each call of a console method at or above its
+// level into a message, which goes to the ConsoleRing of the context of the
+// call; the methods that write no message do nothing.
+class ConsoleBuffer : public debug::ConsoleDelegate {
+ public:
+  ConsoleBuffer(Isolate* iso, size_t capacity, int level)
+      : iso_(iso), capacity_(capacity), level_(level) {}
 
-#define LOCAL_TEMPLATE(tmpl_ptr)     \
-  Isolate* iso = tmpl_ptr->iso;      \
-  Locker locker(iso);                \
-  Isolate::Scope isolate_scope(iso); \
-  HandleScope handle_scope(iso);     \
-  Local<Template> tmpl = tmpl_ptr->ptr.Get(iso);
+  size_t Capacity() const { return capacity_; }
 
-void TemplateFreeWrapper(TemplatePtr tmpl) {
-  tmpl->ptr.Empty();  // Just does `val_ = 0;` without calling V8::DisposeGlobal
-  delete tmpl;
-}
+  void Debug(const debug::ConsoleCallArguments& args,
+             const debug::ConsoleContext&) override {
+    Write(CONSOLE_DEBUG, args);
+  }
+  void Error(const debug::ConsoleCallArguments& args,
+             const debug::ConsoleContext&) override {
+    Write(CONSOLE_ERROR, args);
+  }
+  void Info(const debug::ConsoleCallArguments& args,
+            const debug::ConsoleContext&) override {
+    Write(CONSOLE_LOG, args);
+  }
+  void Log(const debug::ConsoleCallArguments& args,
+           const debug::ConsoleContext&) override {
+    Write(CONSOLE_LOG, args);
+  }
+  void Warn(const debug::ConsoleCallArguments& args,
+            const debug::ConsoleContext&) override {
+    Write(CONSOLE_WARN, args);
+  }
+  void Dir(const debug::ConsoleCallArguments& args,
+           const debug::ConsoleContext&) override {
+    Write(CONSOLE_LOG, args);
+  }
+  void DirXml(const debug::ConsoleCallArguments& args,
+              const debug::ConsoleContext&) override {
+    Write(CONSOLE_LOG, args);
+  }
+  void Table(const debug::ConsoleCallArguments& args,
+             const debug::ConsoleContext&) override {
+    Write(CONSOLE_LOG, args);
+  }
+  void Trace(const debug::ConsoleCallArguments& args,
+             const debug::ConsoleContext&) override {
+    Write(CONSOLE_LOG, args);
+  }
+  // console.assert writes its message only if its condition is falsy.
+  void Assert(const debug::ConsoleCallArguments& args,
+              const debug::ConsoleContext&) override {
+    if (args.Length() > 0 && args[0]->BooleanValue(iso_)) {
+      return;
+    }
+    Write(CONSOLE_ERROR, args, "Assertion failed", 1);
+  }
 
-void TemplateSetValue(TemplatePtr ptr,
-                      const char* name,
-                      ValuePtr val,
-                      int attributes) {
-  LOCAL_TEMPLATE(ptr);
+ private:
+  // Write joins the arguments from start on with spaces, as strings; the
+  // ones that are not strings are converted without running JavaScript, as
+  // Value::ToDetailString does.
+  void Write(int level,
+             const debug::ConsoleCallArguments& args,
+             const char* prefix = nullptr,
+             int start = 0) {
+    if (level < level_) {
+      return;
+    }
+    HandleScope handle_scope(iso_);
+    Local<Context> local_ctx = iso_->GetCurrentContext();
+    if (local_ctx->GetNumberOfEmbedderDataFields() < 2) {
+      return;
+    }
+    m_ctx* ctx =
+        static_cast<m_ctx*>(local_ctx->GetAlignedPointerFromEmbedderData(1));
+    if (ctx == nullptr || ctx->console == nullptr) {
+      return;
+    }
+    TryCatch try_catch(iso_);
+    std::string text = prefix == nullptr ? "" : prefix;
+    if (prefix != nullptr && args.Length() > start) {
+      text += ":";
+    }
+    for (int i = start; i < args.Length(); i++) {
+      Local<String> str;
+      if (args[i]->IsString()) {
+        str = args[i].As<String>();
+      } else if (!args[i]->ToDetailString(local_ctx).ToLocal(&str)) {
+        continue;
+      }
+      if (i > start || prefix != nullptr) {
+        text += ' ';
+      }
+      size_t at = text.size();
+      int left = kConsoleMessageMax - static_cast<int>(at);
+      if (left <= 0) {
+        break;
+      }
+      // Only whole characters are written, up to the space that is left.
+      int length = std::min(str->Utf8Length(iso_), left);
+      text.resize(at + length);
+      length = str->WriteUtf8(
+          iso_, &text[at], length, nullptr,
+          String::NO_NULL_TERMINATION | String::REPLACE_INVALID_UTF8);
+      text.resize(at + length);
+    }
+    ctx->console->Push(level, std::move(text));
+  }
 
-  Local<String> prop_name =
-      String::NewFromUtf8(iso, name, NewStringType::kNormal).ToLocalChecked();
-  tmpl->Set(prop_name, val->ptr.Get(iso), (PropertyAttribute)attributes);
-}
+  Isolate* iso_;
+  const size_t capacity_;
+  const int level_;
+};
 
-int TemplateSetAnyValue(TemplatePtr ptr,
-                        ValuePtr key,
-                        ValuePtr val,
-                        int attributes) {
-  LOCAL_TEMPLATE(ptr);
+struct m_isolate {
+  // A Context for internal use, which also tracks values that are created
+  // with the isolate rather than a context.
+  m_ctx* ctx;
+  // Immortal primitives that are handed out without taking the Locker or
+  // allocating; they occupy the first slots of the internal context.
+  m_value* cachedValues[CACHED_VALUE_COUNT];
+  uint64_t cachedValueTypes[CACHED_VALUE_COUNT];
+  // The Locker held by an isolate session, see IsolateLock; the Lockers and
+  // Isolate::Scopes that every call takes are cheap while it is held.
+  Locker* sessionLocker;
+  int sessionDepth;
+  std::shared_ptr<ArrayBufferAllocator> allocator;
+  // Whether contexts are created from the context of the isolate's startup
+  // snapshot, see SnapshotCreatorCreateBlob.
+  bool snapshotContext;
+  // Whether the heap has run out, see NearHeapLimit; the isolate should be
+  // disposed of once its execution has been terminated.
+  std::atomic<bool> heapLimitReached;
+  // The GC events recorded for Go, if the isolate was created to record them.
+  GCEventRing* gcEvents;
+  // The function templates of the isolate by callback ref, and the refs of
+  // the templates collected since Go last drained them; see
+  // IsolateDrainReleasedCallbacks.
+  std::unordered_map<int, std::unique_ptr<m_callbackWatch>> callbackWatches;
+  std::vector<int> releasedCallbacks;
+  // The objects that Go waits to be collected by finalizer ref, and the refs
+  // of those collected since Go last drained them; see ObjectSetWeak.
+  std::unordered_map<int, std::unique_ptr<m_weakObject>> weakObjects;
+  std::vector<int> finalizedObjects;
+  // The templates of lazy properties, by the index that is their accessor's
+  // data; see TemplateSetLazyTemplate.
+  std::vector<Global<Template>> lazyTemplates;
+  // The internalized keys of the objects of Go struct types, by the id that
+  // the BULK_SHAPE tag refers to; see IsolateNewShape.
+  std::vector<std::vector<Global<String>>> shapes;
+  // The WebAssembly streams that wait for StreamWasmModule, by the id that
+  // is passed to WebAssembly.compileStreaming; see ContextNewWasmStream.
+  std::unordered_map<uint32_t, m_wasmStream*> wasmStreams;
+  uint32_t wasmStreamSeq;
+  // The counters of the shim, if the isolate was created to keep them.
+  std::unique_ptr<m_shimStats> shimStats;
+  // The contexts closed by ContextFreeDeferred whose values have not all
+  // been freed yet, oldest first, and the number of entries of their value
+  // slabs; see IsolateReclaimContexts.
+  std::deque<m_ctx*> deadContexts;
+  std::atomic<size_t> deadValues{0};
+  // The stack that JavaScript may use, or 0 for V8's default; see
+  // applyStackLimit.
+  size_t stackSize = 0;
+  // The strings of NewValueString, if the isolate was created to cache
+  // them.
+  std::unique_ptr<StringCache> stringCache;
+  // The formatters of IntlFormatterCallback, made in the internal context,
+  // by their kind, locales and options, and the template of their wrappers.
+  std::unique_ptr<BytesLRU<Global<Object>>> intlFormatters;
+  Global<FunctionTemplate> intlFormatter;
+  // The stats of the callbacks of function templates by their ref, if the
+  // isolate was created to keep them; see CallbackTimer.
+  std::unique_ptr<std::unordered_map<int, CallbackStats>> callbackStats;
+  // The engine metrics of the isolate, which V8 shares.
+  std::shared_ptr<MetricsRecorder> metrics;
+  // The inspector of the isolate, created with its first session.
+  std::unique_ptr<InspectorClient> inspector;
+  // The console of the isolate, if it buffers the console messages of its
+  // contexts; an inspector replaces it as the console of the isolate.
+  std::unique_ptr<ConsoleBuffer> console;
+  // The classes of TextEncoder and TextDecoder, created for the first context
+  // that installs them; see ContextInstallTextCoding.
+  Global<FunctionTemplate> textEncoder;
+  Global<FunctionTemplate> textDecoder;
+  // The class of the performance objects of contexts, and the clocks of
+  // those objects, which are freed as they are collected; see
+  // ContextInstallPerformance.
+  Global<FunctionTemplate> performance;
+  std::unordered_map<m_performance*, std::unique_ptr<m_performance>>
+      performanceClocks;
+  // The template of the crypto objects of contexts, see ContextInstallCrypto.
+  Global<ObjectTemplate> crypto;
+  // The wake handle of the Atomics.wait that the isolate is blocked in, if
+  // any; see IsolateWakeAtomicsWait.
+  std::mutex atomicsWaitMutex;
+  Isolate::AtomicsWaitWakeHandle* atomicsWait = nullptr;
+  // Whether ExceptionError keeps exceptions for Go to format, or for Go to
+  // read, see RtnError.
+  bool lazyErrors = false;
+  bool keepExceptions = false;
+};
 
-  Local<Value> local_key = key->ptr.Get(iso);
-  if (!local_key->IsName()) {
-    return false;
+static inline m_isolate* isolateData(Isolate* iso) {
+  return static_cast<m_isolate*>(iso->GetData(0));
+}
+
+// freeDeadContexts frees the contexts closed by ContextFreeDeferred at once.
+static void freeDeadContexts(m_isolate* data) {
+  for (m_ctx* ctx : data->deadContexts) {
+    delete ctx;
   }
-  tmpl->Set(local_key.As<Name>(), val->ptr.Get(iso), (PropertyAttribute)attributes);
-  return true;
+  data->deadContexts.clear();
+  data->deadValues = 0;
 }
 
-void TemplateSetTemplate(TemplatePtr ptr,
-                         const char* name,
-                         TemplatePtr obj,
-                         int attributes) {
-  LOCAL_TEMPLATE(ptr);
+// shimStats returns the counters of the shim of iso, or nullptr if it keeps
+// none or is not set up yet.
+static inline m_shimStats* shimStats(Isolate* iso) {
+  m_isolate* data = isolateData(iso);
+  return data == nullptr ? nullptr : data->shimStats.get();
+}
 
-  Local<String> prop_name =
-      String::NewFromUtf8(iso, name, NewStringType::kNormal).ToLocalChecked();
-  tmpl->Set(prop_name, obj->ptr.Get(iso), (PropertyAttribute)attributes);
+// The names of the functions that take an isolate's Locker with
+// LOCK_ISOLATE, by the index of their counter in m_shimStats::calls.
+static std::mutex shim_sites_mutex;
+static std::vector<const char*> shim_sites;
+
+static int shimSite(const char* name) {
+  std::lock_guard<std::mutex> lock(shim_sites_mutex);
+  shim_sites.push_back(name);
+  return shim_sites.size() - 1;
 }
 
-int TemplateSetAnyTemplate(TemplatePtr ptr,
-                           ValuePtr key,
-                           TemplatePtr obj,
-                           int attributes) {
-  LOCAL_TEMPLATE(ptr);
+// ShimLockTimer times how long the Locker of an isolate that keeps shim stats
+// takes to be acquired, and counts the call it is acquired for.
+class ShimLockTimer {
+ public:
+  explicit ShimLockTimer(Isolate* iso) : stats_(shimStats(iso)) {
+    if (stats_ != nullptr) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
 
-  Local<Value> local_key = key->ptr.Get(iso);
-  if (!local_key->IsName()) {
-    return false;
+  void Locked(int site) {
+    if (stats_ == nullptr) {
+      return;
+    }
+    int64_t wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start_)
+                       .count();
+    stats_->lockWaitTotal += wait;
+    stats_->lockWaitMax = std::max(stats_->lockWaitMax, wait);
+    if (site >= (int)stats_->calls.size()) {
+      stats_->calls.resize(site + 1);
+    }
+    stats_->calls[site]++;
   }
-  tmpl->Set(Local<Name>::Cast(local_key), obj->ptr.Get(iso), (PropertyAttribute)attributes);
-  return true;
-}
 
-/********** ObjectTemplate **********/
+ private:
+  m_shimStats* stats_;
+  std::chrono::steady_clock::time_point start_;
+};
 
-TemplatePtr NewObjectTemplate(IsolatePtr iso) {
-  Locker locker(iso);
-  Isolate::Scope isolate_scope(iso);
-  HandleScope handle_scope(iso);
+// The bounds of the stack of a thread, or zeros if they are unknown.
+struct m_threadStack {
+  uintptr_t low = 0;
+  uintptr_t high = 0;
+};
 
-  m_template* ot = new m_template;
-  ot->iso = iso;
-  ot->ptr.Reset(iso, ObjectTemplate::New(iso));
-  return ot;
+static m_threadStack detectThreadStack() {
+  m_threadStack stack;
+#if defined(_WIN32)
+  ULONG_PTR low, high;
+  GetCurrentThreadStackLimits(&low, &high);
+  stack.low = low;
+  stack.high = high;
+#elif defined(__APPLE__)
+  pthread_t self = pthread_self();
+  stack.high = reinterpret_cast<uintptr_t>(pthread_get_stackaddr_np(self));
+  stack.low = stack.high - pthread_get_stacksize_np(self);
+#elif defined(__linux__)
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+    void* addr;
+    size_t size;
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+      stack.low = reinterpret_cast<uintptr_t>(addr);
+      stack.high = stack.low + size;
+    }
+    pthread_attr_destroy(&attr);
+  }
+#endif
+  return stack;
 }
 
-RtnValue ObjectTemplateNewInstance(TemplatePtr ptr, ContextPtr ctx) {
-  LOCAL_TEMPLATE(ptr);
-  TryCatch try_catch(iso);
-  Local<Context> local_ctx = ctx->ptr.Get(iso);
-  Context::Scope context_scope(local_ctx);
-
-  RtnValue rtn = {};
+// threadStack returns the bounds of the stack of the calling thread, which
+// are looked up once per thread.
+static const m_threadStack& threadStack() {
+  thread_local m_threadStack stack = detectThreadStack();
+  return stack;
+}
 
-  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
-  Local<Object> obj;
-  if (!obj_tmpl->NewInstance(local_ctx).ToLocal(&obj)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
+int ThreadAffinity(int* cpus, int n) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+    return -1;
   }
-
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, obj);
-  rtn.value = tracked_value(ctx, val);
-  return rtn;
+  int count = 0;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &set)) {
+      if (count < n) {
+        cpus[count] = cpu;
+      }
+      count++;
+    }
+  }
+  return count;
+#else
+  return -1;
+#endif
 }
 
-void ObjectTemplateSetInternalFieldCount(TemplatePtr ptr, int field_count) {
-  LOCAL_TEMPLATE(ptr);
+int ThreadSetAffinity(const int* cpus, int n) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int i = 0; i < n; i++) {
+    if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) {
+      CPU_SET(cpus[i], &set);
+    }
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : errno;
+#else
+  return ENOSYS;
+#endif
+}
 
-  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
-  obj_tmpl->SetInternalFieldCount(field_count);
+int ThreadCurrentCPU() {
+#if defined(__linux__)
+  return sched_getcpu();
+#else
+  return -1;
+#endif
 }
 
-int ObjectTemplateInternalFieldCount(TemplatePtr ptr) {
-  LOCAL_TEMPLATE(ptr);
+// The stack that is left below the stack limit of an isolate for the native
+// code that V8 and v8go run without checking the limit.
+static const uintptr_t kStackMargin = 128 << 10;
 
-  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
-  return obj_tmpl->InternalFieldCount();
-}
+// applyStackLimit sets the stack limit of iso, whose Locker the calling
+// thread holds, for an isolate created with IsolateOptions.stackSize: the
+// thread may use that much stack below the current position, and no more
+// than its stack leaves, less kStackMargin. It only applies as the isolate is
+// entered, as the limit of nested calls must not move.
+static void applyStackLimit(Isolate* iso) {
+  m_isolate* data = isolateData(iso);
+  if (data == nullptr || data->stackSize == 0 || iso->IsInUse()) {
+    return;
+  }
+  uintptr_t sp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+  uintptr_t limit = sp > data->stackSize ? sp - data->stackSize : 0;
+  const m_threadStack& stack = threadStack();
+  if (stack.low != 0 && sp > stack.low + kStackMargin) {
+    limit = std::max(limit, stack.low + kStackMargin);
+  }
+  iso->SetStackLimit(limit);
+}
+
+// LOCK_ISOLATE takes the Locker of iso as locker, which for an isolate that
+// keeps shim stats counts the call of the enclosing function and the time it
+// waited for the lock.
+#define LOCK_ISOLATE(iso)                          \
+  static const int shim_site = shimSite(__func__); \
+  ShimLockTimer shim_lock_timer(iso);              \
+  Locker locker(iso);                              \
+  shim_lock_timer.Locked(shim_site);               \
+  applyStackLimit(iso);
+
+// MeasureMemoryResult collects the memory measurement of IsolateMeasureMemory,
+// which attributes memory to the contexts created by NewContext; the others,
+// and contexts that have been closed, count as unattributed.
+// The result is shared with the delegate, which V8 owns, in case the
+// measurement completes after IsolateMeasureMemory has given up on it.
+class MeasureMemoryResult : public MeasureMemoryDelegate {
+ public:
+  struct Result {
+    bool completed = false;
+    std::vector<ContextMemory> contexts;
+    size_t unattributed = 0;
+  };
 
-/********** FunctionTemplate **********/
+  explicit MeasureMemoryResult(std::shared_ptr<Result> result)
+      : result_(result) {}
+
+  bool ShouldMeasure(Local<Context> context) override { return true; }
+
+  void MeasurementComplete(
+      const std::vector<std::pair<Local<Context>, size_t>>& sizes,
+      size_t unattributed) override {
+    result_->unattributed = unattributed;
+    for (auto& size : sizes) {
+      m_ctx* ctx = nullptr;
+      if (size.first->GetNumberOfEmbedderDataFields() > 1) {
+        ctx = static_cast<m_ctx*>(
+            size.first->GetAlignedPointerFromEmbedderData(1));
+      }
+      if (ctx == nullptr || ctx->ref == 0) {
+        result_->unattributed += size.second;
+        continue;
+      }
+      result_->contexts.push_back(ContextMemory{ctx->ref, size.second});
+    }
+    result_->completed = true;
+  }
 
-static void FunctionTemplateCallback(const FunctionCallbackInfo<Value>& info) {
-  Isolate* iso = info.GetIsolate();
-  ISOLATE_SCOPE(iso);
+ private:
+  std::shared_ptr<Result> result_;
+};
 
-  // This callback function can be called from any Context, which we only know
-  // at runtime. We extract the Context reference from the embedder data so that
-  // we can use the context registry to match the Context on the Go side
-  Local<Context> local_ctx = iso->GetCurrentContext();
-  int ctx_ref = local_ctx->GetEmbedderData(1).As<Integer>()->Value();
-  m_ctx* ctx = goContext(ctx_ref);
+// A reference to a backing store held by Go, which can be shared by the
+// SharedArrayBuffers of any number of isolates.
+struct m_backingStore {
+  std::shared_ptr<BackingStore> ptr;
+};
 
-  int callback_ref = info.Data().As<Integer>()->Value();
+// A value serialized with ValueSerializer, along with the backing stores of
+// the ArrayBuffers that were transferred and of the SharedArrayBuffers that
+// were shared, which the wire format refers to by index.
+struct m_serialized {
+  std::vector<uint8_t> data;
+  std::vector<std::shared_ptr<BackingStore>> transfers;
+  std::vector<std::shared_ptr<BackingStore>> shared;
+};
 
-  m_value* _this = new m_value;
-  _this->iso = iso;
-  _this->ctx = ctx;
-  _this->ptr.Reset(iso, Persistent<Value, CopyablePersistentTraits<Value>>(
-                            iso, info.This()));
+class SerializerDelegate : public ValueSerializer::Delegate {
+ public:
+  SerializerDelegate(Isolate* iso, m_serialized* out) : iso_(iso), out_(out) {}
 
-  int args_count = info.Length();
-  ValuePtr thisAndArgs[args_count + 1];
-  thisAndArgs[0] = tracked_value(ctx, _this);
-  ValuePtr* args = thisAndArgs + 1;
-  for (int i = 0; i < args_count; i++) {
-    m_value* val = new m_value;
-    val->iso = iso;
-    val->ctx = ctx;
-    val->ptr.Reset(
-        iso, Persistent<Value, CopyablePersistentTraits<Value>>(iso, info[i]));
-    args[i] = tracked_value(ctx, val);
+  void ThrowDataCloneError(Local<String> message) override {
+    iso_->ThrowException(Exception::Error(message));
   }
 
-  goFunctionCallback_return retval =
-      goFunctionCallback(ctx_ref, callback_ref, thisAndArgs, args_count);
-  if (retval.r1 != nullptr) {
-    iso->ThrowException(retval.r1->ptr.Get(iso));
-  } else if (retval.r0 != nullptr) {
-    info.GetReturnValue().Set(retval.r0->ptr.Get(iso));
-  } else {
-    info.GetReturnValue().SetUndefined();
+  Maybe<uint32_t> GetSharedArrayBufferId(
+      Isolate* iso,
+      Local<SharedArrayBuffer> shared_array_buffer) override {
+    out_->shared.push_back(shared_array_buffer->GetBackingStore());
+    return Just<uint32_t>(out_->shared.size() - 1);
   }
-}
-
-TemplatePtr NewFunctionTemplate(IsolatePtr iso, int callback_ref) {
-  Locker locker(iso);
-  Isolate::Scope isolate_scope(iso);
-  HandleScope handle_scope(iso);
-
-  // (rogchap) We only need to store one value, callback_ref, into the
-  // C++ callback function data, but if we needed to store more items we could
-  // use an V8::Array; this would require the internal context from
-  // iso->GetData(0)
-  Local<Integer> cbData = Integer::New(iso, callback_ref);
-
-  m_template* ot = new m_template;
-  ot->iso = iso;
-  ot->ptr.Reset(iso,
-                FunctionTemplate::New(iso, FunctionTemplateCallback, cbData));
-  return ot;
-}
 
-RtnValue FunctionTemplateGetFunction(TemplatePtr ptr, ContextPtr ctx) {
-  LOCAL_TEMPLATE(ptr);
-  TryCatch try_catch(iso);
-  Local<Context> local_ctx = ctx->ptr.Get(iso);
-  Context::Scope context_scope(local_ctx);
+ private:
+  Isolate* iso_;
+  m_serialized* out_;
+};
 
-  Local<FunctionTemplate> fn_tmpl = tmpl.As<FunctionTemplate>();
-  RtnValue rtn = {};
-  Local<Function> fn;
-  if (!fn_tmpl->GetFunction(local_ctx).ToLocal(&fn)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
+class DeserializerDelegate : public ValueDeserializer::Delegate {
+ public:
+  explicit DeserializerDelegate(m_serialized* in) : in_(in) {}
+
+  MaybeLocal<SharedArrayBuffer> GetSharedArrayBufferFromId(
+      Isolate* iso,
+      uint32_t id) override {
+    if (id >= in_->shared.size()) {
+      iso->ThrowException(Exception::Error(String::NewFromUtf8Literal(
+          iso, "SharedArrayBuffer of the serialized value is missing")));
+      return MaybeLocal<SharedArrayBuffer>();
+    }
+    return SharedArrayBuffer::New(iso, in_->shared[id]);
   }
 
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, fn);
-  rtn.value = tracked_value(ctx, val);
-  return rtn;
-}
+ private:
+  m_serialized* in_;
+};
 
-/********** Context **********/
+// A compiled WebAssembly module held by Go, which can be instantiated in any
+// isolate without being compiled again.
+struct m_compiledWasmModule {
+  CompiledWasmModule module;
+};
 
-#define LOCAL_CONTEXT(ctx)                      \
-  Isolate* iso = ctx->iso;                      \
-  Locker locker(iso);                           \
-  Isolate::Scope isolate_scope(iso);            \
-  HandleScope handle_scope(iso);                \
-  TryCatch try_catch(iso);                      \
-  Local<Context> local_ctx = ctx->ptr.Get(iso); \
-  Context::Scope context_scope(local_ctx);
+struct m_template {
+  Isolate* iso;
+  Persistent<Template> ptr;
+};
 
-ContextPtr NewContext(IsolatePtr iso,
-                      TemplatePtr global_template_ptr,
-                      int ref) {
-  Locker locker(iso);
-  Isolate::Scope isolate_scope(iso);
-  HandleScope handle_scope(iso);
+const char* CopyString(const char* data, size_t length) {
+  char* mem = (char*)malloc(length + 1);
+  memcpy(mem, data, length);
+  mem[length] = 0;
+  return mem;
+}
 
-  Local<ObjectTemplate> global_template;
-  if (global_template_ptr != nullptr) {
-    global_template = global_template_ptr->ptr.Get(iso).As<ObjectTemplate>();
-  } else {
-    global_template = ObjectTemplate::New(iso);
+const char* CopyString(const std::string& str) {
+  return CopyString(str.data(), str.length());
+}
+
+const char* CopyString(String::Utf8Value& value) {
+  if (value.length() == 0) {
+    return nullptr;
   }
+  return CopyString(*value, value.length());
+}
 
-  // For function callbacks we need a reference to the context, but because of
-  // the complexities of C -> Go function pointers, we store a reference to the
-  // context as a simple integer identifier; this can then be used on the Go
-  // side to lookup the context in the context registry. We use slot 1 as slot 0
-  // has special meaning for the Chrome debugger.
-  Local<Context> local_ctx = Context::New(iso, nullptr, global_template);
-  local_ctx->SetEmbedderData(1, Integer::New(iso, ref));
+m_value* tracked_value(m_ctx* ctx, Local<Value> value);
 
-  m_ctx* ctx = new m_ctx;
-  ctx->ptr.Reset(iso, local_ctx);
-  ctx->iso = iso;
-  return ctx;
-}
+static RtnError ExceptionError(TryCatch& try_catch,
+                               Isolate* iso,
+                               Local<Context> ctx) {
+  HandleScope handle_scope(iso);
 
-void ContextFree(ContextPtr ctx) {
-  if (ctx == nullptr) {
-    return;
+  RtnError rtn = {};
+
+  if (try_catch.HasTerminated()) {
+    rtn.msg =
+        CopyString("ExecutionTerminated: script execution has been terminated");
+    return rtn;
   }
-  ctx->ptr.Reset();
 
-  for (m_value* val : ctx->vals) {
-    val->ptr.Reset();
-    delete val;
+  Local<Message> msg = try_catch.Message();
+  if (!msg.IsEmpty()) {
+    String::Utf8Value origin(iso, msg->GetScriptOrigin().ResourceName());
+    std::ostringstream sb;
+    sb << *origin;
+    Maybe<int> line = try_catch.Message()->GetLineNumber(ctx);
+    if (line.IsJust()) {
+      sb << ":" << line.ToChecked();
+    }
+    Maybe<int> start = try_catch.Message()->GetStartColumn(ctx);
+    if (start.IsJust()) {
+      sb << ":"
+         << start.ToChecked() + 1;  // + 1 to match output from stack trace
+    }
+    rtn.location = CopyString(sb.str());
   }
 
-  for (m_unboundScript* us : ctx->unboundScripts) {
-    us->ptr.Reset();
-    delete us;
+  // Converting an object to a string runs JavaScript, as does formatting the
+  // stack of an Error, which an isolate with lazy errors leaves for Go to ask
+  // for. The location is taken now, as only the message of the exception
+  // tells where it was thrown. Contexts of v8go have their m_ctx as embedder
+  // data, which the internal context of the isolate does not.
+  Local<Value> exception = try_catch.Exception();
+  m_isolate* data = isolateData(iso);
+  bool lazy = data->lazyErrors && exception->IsObject();
+  if ((lazy || data->keepExceptions) &&
+      ctx->GetNumberOfEmbedderDataFields() > 1) {
+    m_ctx* exception_ctx =
+        static_cast<m_ctx*>(ctx->GetAlignedPointerFromEmbedderData(1));
+    if (exception_ctx != nullptr) {
+      rtn.exception = tracked_value(exception_ctx, exception);
+      rtn.exceptionContext = exception_ctx->ref;
+      if (lazy) {
+        return rtn;
+      }
+    }
   }
 
-  delete ctx;
+  String::Utf8Value exception_str(iso, exception);
+  rtn.msg = CopyString(exception_str);
+
+  Local<Value> mstack;
+  if (try_catch.StackTrace(ctx).ToLocal(&mstack)) {
+    String::Utf8Value stack(iso, mstack);
+    rtn.stack = CopyString(stack);
+  }
+
+  return rtn;
 }
 
-RtnValue RunScript(ContextPtr ctx, const char* source, const char* origin) {
-  LOCAL_CONTEXT(ctx);
+m_value* tracked_value(m_ctx* ctx, Local<Value> value) {
+  // (rogchap) we track values against a context so that when the context is
+  // closed (either manually or GC'd by Go) we can also release all the
+  // values associated with the context; previously the Go GC would not run
+  // quickly enough, as it has no understanding of the C memory allocation size.
+  // Values live in a slab owned by the context, so creating one is a bump
+  // allocation and closing the context frees them in bulk. A value can also be
+  // released early (see ValueRelease), in which case its slot is recycled.
+  uint32_t slot;
+  m_value* val = ctx->vals.Alloc(&slot);
+  val->iso = ctx->iso;
+  val->ctx = ctx;
+  val->slot = slot;
+  val->ptr.Reset(ctx->iso, value);
+  if (m_shimStats* stats = shimStats(ctx->iso)) {
+    stats->valuesAllocated++;
+  }
 
-  RtnValue rtn = {};
+  if (!ctx->scopeMarks.empty()) {
+    ctx->scopedVals.push_back(m_scopedValue{val, val->gen});
+  }
 
-  MaybeLocal<String> maybeSrc =
-      String::NewFromUtf8(iso, source, NewStringType::kNormal);
-  MaybeLocal<String> maybeOgn =
-      String::NewFromUtf8(iso, origin, NewStringType::kNormal);
-  Local<String> src, ogn;
-  if (!maybeSrc.ToLocal(&src) || !maybeOgn.ToLocal(&ogn)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
+  return val;
+}
+
+static const int kUtf8WriteOptions =
+    String::NO_NULL_TERMINATION | String::REPLACE_INVALID_UTF8;
+
+// countNonASCII returns the number of bytes of Latin-1 text that are not
+// ASCII, each of which takes two bytes in UTF-8, 16 bytes at a time.
+static size_t countNonASCII(const uint8_t* p, size_t n) {
+  size_t count = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  // The bytes from 0x80 compare below zero as signed, to -1, which counts
+  // them in each lane of acc; the lanes are summed before they overflow.
+  const __m128i zero = _mm_setzero_si128();
+  while (i + 16 <= n) {
+    __m128i acc = zero;
+    size_t end = std::min(n & ~size_t(15), i + 255 * 16);
+    for (; i < end; i += 16) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      acc = _mm_sub_epi8(acc, _mm_cmplt_epi8(v, zero));
+    }
+    __m128i sums = _mm_sad_epu8(acc, zero);
+    count += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= n; i += 16) {
+    count += vaddvq_u8(vshrq_n_u8(vld1q_u8(p + i), 7));
   }
+#else
+  for (; i + 8 <= n; i += 8) {
+    uint64_t w;
+    memcpy(&w, p + i, 8);
+    // The top bit of each byte, moved to its bottom and summed into the top
+    // byte.
+    count += (((w >> 7) & 0x0101010101010101ull) * 0x0101010101010101ull) >> 56;
+  }
+#endif
+  for (; i < n; i++) {
+    count += p[i] >> 7;
+  }
+  return count;
+}
+
+// asciiMask16 returns a mask of the bytes of the 16 at p that are not ASCII,
+// by their bit, or 0 if they are all ASCII.
+static inline uint32_t asciiMask16(const uint8_t* p) {
+#if defined(__SSE2__)
+  return _mm_movemask_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+#elif defined(__ARM_NEON)
+  return vmaxvq_u8(vld1q_u8(p)) >> 7;
+#else
+  uint64_t w[2];
+  memcpy(w, p, 16);
+  return ((w[0] | w[1]) & 0x8080808080808080ull) != 0;
+#endif
+}
 
-  ScriptOrigin script_origin(ogn);
-  Local<Script> script;
-  if (!Script::Compile(local_ctx, src, &script_origin).ToLocal(&script)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
+// widenLatin1 converts the n bytes of Latin-1 text at the start of buf to
+// the utf8_length bytes of their UTF-8 in place, from the end, where each
+// character is written at or after the one it is read from. Runs of ASCII
+// are moved 16 bytes at a time, which leaves the bytes before them in place.
+static void widenLatin1(char* buf, size_t n, size_t utf8_length) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(buf);
+  size_t i = n;
+  size_t o = utf8_length;
+  while (o > i) {
+    size_t stop = 0;
+    if (i >= 16) {
+      if (asciiMask16(src + i - 16) == 0) {
+        memmove(buf + o - 16, buf + i - 16, 16);
+        i -= 16;
+        o -= 16;
+        continue;
+      }
+      stop = i - 16;
+    }
+    while (i > stop) {
+      uint8_t c = src[--i];
+      if (c < 0x80) {
+        buf[--o] = c;
+      } else {
+        buf[--o] = static_cast<char>(0x80 | (c & 0x3f));
+        buf[--o] = static_cast<char>(0xc0 | (c >> 6));
+      }
+    }
   }
-  Local<Value> result;
-  if (!script->Run(local_ctx).ToLocal(&result)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+}
+
+// writeOneByteUtf8 writes the one-byte string str, of length characters, as
+// UTF-8 into buf of cap bytes, which is at least length, and returns the
+// length of its UTF-8, or -1 and the length in *utf8_length if it does not
+// fit. WriteOneByte copies the characters as they are, so that the common
+// case of ASCII is a copy and a scan, rather than V8's transcoding one
+// character at a time.
+static int writeOneByteUtf8(Isolate* iso,
+                            Local<String> str,
+                            int length,
+                            char* buf,
+                            int cap,
+                            int* utf8_length) {
+  str->WriteOneByte(iso, reinterpret_cast<uint8_t*>(buf), 0, length,
+                    String::NO_NULL_TERMINATION);
+  size_t non_ascii =
+      countNonASCII(reinterpret_cast<const uint8_t*>(buf), length);
+  *utf8_length = length + static_cast<int>(non_ascii);
+  if (*utf8_length > cap) {
+    return -1;
+  }
+  if (non_ascii > 0) {
+    widenLatin1(buf, length, *utf8_length);
+  }
+  return *utf8_length;
+}
+
+// Utf8Result writes str into buf if it fits in cap bytes. Otherwise only its
+// length is returned, along with the string itself, which the caller writes
+// with StringWriteUtf8 into a buffer of its own once it has allocated one.
+static RtnUtf8 Utf8Result(m_ctx* ctx, Local<String> str, char* buf, int cap) {
+  Isolate* iso = ctx->iso;
+  RtnUtf8 rtn = {};
+  int length = str->Length();
+  if (!str->IsOneByte()) {
+    rtn.length = str->Utf8Length(iso);
+  } else if (length > cap) {
+    // Measuring the UTF-8 would take a pass over the string of its own;
+    // StringWriteUtf8 measures it as it writes it instead.
+    rtn.length = length;
+  } else if (writeOneByteUtf8(iso, str, length, buf, cap, &rtn.length) >= 0) {
     return rtn;
   }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-
-  rtn.value = tracked_value(ctx, val);
+  if (rtn.length <= cap) {
+    str->WriteUtf8(iso, buf, cap, nullptr, kUtf8WriteOptions);
+  } else {
+    // The string is returned, rather than converted again, so that a toString
+    // method is not called twice.
+    rtn.string = tracked_value(ctx, str);
+  }
   return rtn;
 }
 
-/********** UnboundScript & ScriptCompilerCachedData **********/
+static void release_value(m_value* val) {
+  val->ptr.Reset();
+  val->gen++;
+  val->ctx->vals.Free(val->slot);
+  if (m_shimStats* stats = shimStats(val->iso)) {
+    stats->valuesFreed++;
+  }
+}
 
-ScriptCompilerCachedData* UnboundScriptCreateCodeCache(
-    IsolatePtr iso,
-    UnboundScriptPtr us_ptr) {
-  ISOLATE_SCOPE(iso);
+// release_value_of releases val for a reference made while its slot was of
+// the generation gen, unless the slot has been released since.
+static inline void release_value_of(m_value* val, uint32_t gen) {
+  if (val->gen == gen) {
+    release_value(val);
+  }
+}
 
-  Local<UnboundScript> unbound_script = us_ptr->ptr.Get(iso);
+// drainDeferredReleases releases the values that ValueReleaseDeferred has
+// queued on ctx, unless their slot has been released, and possibly reused,
+// since. The queue is checked on every call into the context, which costs a
+// load while it is empty.
+static inline void drainDeferredReleases(m_ctx* ctx) {
+  if (ctx->deferredReleases.load(std::memory_order_relaxed) == nullptr) {
+    return;
+  }
+  m_deferredRelease* node =
+      ctx->deferredReleases.exchange(nullptr, std::memory_order_acquire);
+  while (node != nullptr) {
+    release_value_of(node->val, node->gen);
+    m_deferredRelease* next = node->next;
+    delete node;
+    node = next;
+  }
+}
 
-  ScriptCompiler::CachedData* cached_data =
-      ScriptCompiler::CreateCodeCache(unbound_script);
+m_unboundScript* tracked_unbound_script(m_ctx* ctx,
+                                        Local<UnboundScript> unbound_script) {
+  uint32_t slot;
+  m_unboundScript* us = ctx->unboundScripts.Alloc(&slot);
+  us->ptr.Reset(ctx->iso, unbound_script);
+  us->ctx = ctx;
+  us->slot = slot;
 
-  ScriptCompilerCachedData* cd = new ScriptCompilerCachedData;
-  cd->ptr = cached_data;
-  cd->data = cached_data->data;
-  cd->length = cached_data->length;
-  cd->rejected = cached_data->rejected;
-  return cd;
+  return us;
 }
 
-void ScriptCompilerCachedDataDelete(ScriptCompilerCachedData* cached_data) {
-  delete cached_data->ptr;
-  delete cached_data;
+static inline m_ctx* isolateInternalContext(Isolate* iso) {
+  return isolateData(iso)->ctx;
 }
 
-// This can only run in contexts that belong to the same isolate
-// the script was compiled in
-RtnValue UnboundScriptRun(ContextPtr ctx, UnboundScriptPtr us_ptr) {
-  LOCAL_CONTEXT(ctx)
-
-  RtnValue rtn = {};
-
-  Local<UnboundScript> unbound_script = us_ptr->ptr.Get(iso);
+static inline bool isCachedValue(m_value* val) {
+  return val->ctx == isolateInternalContext(val->iso) &&
+         val->slot < CACHED_VALUE_COUNT;
+}
 
-  Local<Script> script = unbound_script->BindToCurrentContext();
-  Local<Value> result;
-  if (!script->Run(local_ctx).ToLocal(&result)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
+#define VALUE_TYPE_BIT(name) (uint64_t(1) << VALUE_TYPE_##name)
+#define SET_VALUE_TYPE_BIT(name, pred) \
+  if (value->pred()) {                 \
+    types |= VALUE_TYPE_BIT(name);     \
   }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-
-  rtn.value = tracked_value(ctx, val);
-  return rtn;
-}
 
-RtnValue JSONParse(ContextPtr ctx, const char* str) {
-  LOCAL_CONTEXT(ctx);
-  RtnValue rtn = {};
+// Evaluates all the ValueIs* predicates at once, skipping the ones that
+// cannot hold for the kind of value, e.g. the object predicates for
+// primitives.
+static uint64_t valueTypeOf(Local<Value> value) {
+  uint64_t types = 0;
+  SET_VALUE_TYPE_BIT(NULL_OR_UNDEFINED, IsNullOrUndefined);
+  if (types != 0) {
+    types |= value->IsUndefined() ? VALUE_TYPE_BIT(UNDEFINED)
+                                  : VALUE_TYPE_BIT(NULL);
+    return types;
+  }
+  SET_VALUE_TYPE_BIT(BOOLEAN, IsBoolean);
+  if (types != 0) {
+    types |= value->IsTrue() ? VALUE_TYPE_BIT(TRUE) : VALUE_TYPE_BIT(FALSE);
+    return types;
+  }
+  SET_VALUE_TYPE_BIT(NUMBER, IsNumber);
+  if (types != 0) {
+    SET_VALUE_TYPE_BIT(INT32, IsInt32);
+    SET_VALUE_TYPE_BIT(UINT32, IsUint32);
+    return types;
+  }
+  SET_VALUE_TYPE_BIT(STRING, IsString);
+  SET_VALUE_TYPE_BIT(SYMBOL, IsSymbol);
+  if (types != 0) {
+    return types | VALUE_TYPE_BIT(NAME);
+  }
+  SET_VALUE_TYPE_BIT(BIG_INT, IsBigInt);
+  SET_VALUE_TYPE_BIT(EXTERNAL, IsExternal);
+  if (types != 0 || !value->IsObject()) {
+    return types;
+  }
 
-  Local<String> v8Str;
-  if (!String::NewFromUtf8(iso, str, NewStringType::kNormal).ToLocal(&v8Str)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+  types |= VALUE_TYPE_BIT(OBJECT);
+  SET_VALUE_TYPE_BIT(FUNCTION, IsFunction);
+  if (types & VALUE_TYPE_BIT(FUNCTION)) {
+    SET_VALUE_TYPE_BIT(ASYNC_FUNCTION, IsAsyncFunction);
+    SET_VALUE_TYPE_BIT(GENERATOR_FUNCTION, IsGeneratorFunction);
+  }
+  SET_VALUE_TYPE_BIT(ARRAY_BUFFER_VIEW, IsArrayBufferView);
+  if (types & VALUE_TYPE_BIT(ARRAY_BUFFER_VIEW)) {
+    SET_VALUE_TYPE_BIT(DATA_VIEW, IsDataView);
+    SET_VALUE_TYPE_BIT(TYPED_ARRAY, IsTypedArray);
+    SET_VALUE_TYPE_BIT(UINT8_ARRAY, IsUint8Array);
+    SET_VALUE_TYPE_BIT(UINT8_CLAMPED_ARRAY, IsUint8ClampedArray);
+    SET_VALUE_TYPE_BIT(INT8_ARRAY, IsInt8Array);
+    SET_VALUE_TYPE_BIT(UINT16_ARRAY, IsUint16Array);
+    SET_VALUE_TYPE_BIT(INT16_ARRAY, IsInt16Array);
+    SET_VALUE_TYPE_BIT(UINT32_ARRAY, IsUint32Array);
+    SET_VALUE_TYPE_BIT(INT32_ARRAY, IsInt32Array);
+    SET_VALUE_TYPE_BIT(FLOAT32_ARRAY, IsFloat32Array);
+    SET_VALUE_TYPE_BIT(FLOAT64_ARRAY, IsFloat64Array);
+    SET_VALUE_TYPE_BIT(BIG_INT64_ARRAY, IsBigInt64Array);
+    SET_VALUE_TYPE_BIT(BIG_UINT64_ARRAY, IsBigUint64Array);
+    return types;
   }
+  SET_VALUE_TYPE_BIT(ARRAY, IsArray);
+  SET_VALUE_TYPE_BIT(DATE, IsDate);
+  SET_VALUE_TYPE_BIT(ARGUMENTS_OBJECT, IsArgumentsObject);
+  SET_VALUE_TYPE_BIT(BIG_INT_OBJECT, IsBigIntObject);
+  SET_VALUE_TYPE_BIT(NUMBER_OBJECT, IsNumberObject);
+  SET_VALUE_TYPE_BIT(STRING_OBJECT, IsStringObject);
+  SET_VALUE_TYPE_BIT(SYMBOL_OBJECT, IsSymbolObject);
+  SET_VALUE_TYPE_BIT(NATIVE_ERROR, IsNativeError);
+  SET_VALUE_TYPE_BIT(REG_EXP, IsRegExp);
+  SET_VALUE_TYPE_BIT(GENERATOR_OBJECT, IsGeneratorObject);
+  SET_VALUE_TYPE_BIT(PROMISE, IsPromise);
+  SET_VALUE_TYPE_BIT(MAP, IsMap);
+  SET_VALUE_TYPE_BIT(SET, IsSet);
+  SET_VALUE_TYPE_BIT(MAP_ITERATOR, IsMapIterator);
+  SET_VALUE_TYPE_BIT(SET_ITERATOR, IsSetIterator);
+  SET_VALUE_TYPE_BIT(WEAK_MAP, IsWeakMap);
+  SET_VALUE_TYPE_BIT(WEAK_SET, IsWeakSet);
+  SET_VALUE_TYPE_BIT(ARRAY_BUFFER, IsArrayBuffer);
+  SET_VALUE_TYPE_BIT(SHARED_ARRAY_BUFFER, IsSharedArrayBuffer);
+  SET_VALUE_TYPE_BIT(PROXY, IsProxy);
+  SET_VALUE_TYPE_BIT(WASM_MODULE_OBJECT, IsWasmModuleObject);
+  SET_VALUE_TYPE_BIT(MODULE_NAMESPACE_OBJECT, IsModuleNamespaceObject);
+  return types;
+}
+
+// ExternalOneByteString owns the malloc'd characters of an external string
+// created from a StringArg; V8 deletes it once the string is collected.
+class ExternalOneByteString : public String::ExternalOneByteStringResource {
+ public:
+  ExternalOneByteString(const char* data, size_t length)
+      : data_(data), length_(length) {}
+  ~ExternalOneByteString() override { free(const_cast<char*>(data_)); }
+
+  const char* data() const override { return data_; }
+  size_t length() const override { return length_; }
+
+ private:
+  const char* data_;
+  size_t length_;
+};
 
-  Local<Value> result;
-  if (!JSON::Parse(local_ctx, v8Str).ToLocal(&result)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
+static MaybeLocal<String> NewString(Isolate* iso, StringArg str) {
+  if (!str.external) {
+    return String::NewFromUtf8(iso, str.data, NewStringType::kNormal,
+                               str.length);
   }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
+  ExternalOneByteString* resource =
+      new ExternalOneByteString(str.data, str.length);
+  MaybeLocal<String> result = String::NewExternalOneByte(iso, resource);
+  if (result.IsEmpty()) {
+    delete resource;
+  }
+  return result;
+}
+
+// A script source interned in the process wide source registry. Its characters
+// are shared by the external strings of every isolate that compiles it, and
+// the code cache of its first compile is kept alongside for the next ones.
+// It is reference counted by Go, which holds one reference for the registry,
+// and by each of its external strings.
+struct m_source {
+  std::atomic<int> refs{1};
+  // The characters, as ASCII when the source is, or else as UTF-16.
+  std::string oneByte;
+  std::vector<uint16_t> twoByte;
+  std::mutex mu;
+  std::unique_ptr<ScriptCompiler::CachedData> cache;
+};
 
-  rtn.value = tracked_value(ctx, val);
-  return rtn;
+static void releaseSource(m_source* src) {
+  if (--src->refs == 0) {
+    delete src;
+  }
 }
 
-const char* JSONStringify(ContextPtr ctx, ValuePtr val) {
-  Isolate* iso;
-  Local<Context> local_ctx;
+class SharedOneByteSource : public String::ExternalOneByteStringResource {
+ public:
+  explicit SharedOneByteSource(m_source* src) : src_(src) { src_->refs++; }
+  ~SharedOneByteSource() override { releaseSource(src_); }
 
-  if (ctx != nullptr) {
-    iso = ctx->iso;
-  } else {
-    iso = val->iso;
-  }
+  const char* data() const override { return src_->oneByte.data(); }
+  size_t length() const override { return src_->oneByte.length(); }
 
-  Locker locker(iso);
-  Isolate::Scope isolate_scope(iso);
-  HandleScope handle_scope(iso);
+ private:
+  m_source* src_;
+};
 
-  if (ctx != nullptr) {
-    local_ctx = ctx->ptr.Get(iso);
-  } else {
-    if (val->ctx != nullptr) {
-      local_ctx = val->ctx->ptr.Get(iso);
+class SharedTwoByteSource : public String::ExternalStringResource {
+ public:
+  explicit SharedTwoByteSource(m_source* src) : src_(src) { src_->refs++; }
+  ~SharedTwoByteSource() override { releaseSource(src_); }
+
+  const uint16_t* data() const override { return src_->twoByte.data(); }
+  size_t length() const override { return src_->twoByte.size(); }
+
+ private:
+  m_source* src_;
+};
+
+// decodeUtf8 appends the UTF-16 code units of the UTF-8 in data to out, with
+// invalid sequences replaced by U+FFFD as V8 does.
+static void decodeUtf8(const char* data,
+                       size_t length,
+                       std::vector<uint16_t>* out) {
+  const unsigned char* s = reinterpret_cast<const unsigned char*>(data);
+  size_t i = 0;
+  while (i < length) {
+    unsigned char c = s[i];
+    uint32_t cp;
+    size_t n;
+    if (c < 0x80) {
+      cp = c, n = 1;
+    } else if ((c & 0xe0) == 0xc0) {
+      cp = c & 0x1f, n = 2;
+    } else if ((c & 0xf0) == 0xe0) {
+      cp = c & 0x0f, n = 3;
+    } else if ((c & 0xf8) == 0xf0) {
+      cp = c & 0x07, n = 4;
+    } else {
+      cp = 0xfffd, n = 0;
+    }
+    size_t j = 1;
+    for (; j < n && i + j < length && (s[i + j] & 0xc0) == 0x80; j++) {
+      cp = (cp << 6) | (s[i + j] & 0x3f);
+    }
+    static const uint32_t kMin[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (n == 0 || j < n || cp < kMin[n] || cp > 0x10ffff ||
+        (cp >= 0xd800 && cp <= 0xdfff)) {
+      cp = 0xfffd;
+      n = j;
+    }
+    if (cp >= 0x10000) {
+      cp -= 0x10000;
+      out->push_back(0xd800 + (cp >> 10));
+      out->push_back(0xdc00 + (cp & 0x3ff));
     } else {
-      m_ctx* ctx = isolateInternalContext(iso);
-      local_ctx = ctx->ptr.Get(iso);
+      out->push_back(cp);
     }
+    i += n;
   }
+}
 
-  Context::Scope context_scope(local_ctx);
-
-  Local<String> str;
-  if (!JSON::Stringify(local_ctx, val->ptr.Get(iso)).ToLocal(&str)) {
-    return nullptr;
+static MaybeLocal<String> NewSharedString(Isolate* iso, m_source* src) {
+  if (src->oneByte.empty() && src->twoByte.empty()) {
+    return String::Empty(iso);
+  }
+  if (src->twoByte.empty()) {
+    SharedOneByteSource* resource = new SharedOneByteSource(src);
+    MaybeLocal<String> result = String::NewExternalOneByte(iso, resource);
+    if (result.IsEmpty()) {
+      delete resource;
+    }
+    return result;
+  }
+  SharedTwoByteSource* resource = new SharedTwoByteSource(src);
+  MaybeLocal<String> result = String::NewExternalTwoByte(iso, resource);
+  if (result.IsEmpty()) {
+    delete resource;
   }
-  String::Utf8Value json(iso, str);
-  return CopyString(json);
+  return result;
 }
 
-ValuePtr ContextGlobal(ContextPtr ctx) {
-  LOCAL_CONTEXT(ctx);
-  m_value* val = new m_value;
+// GoSourceStream feeds a streaming compile with source read by Go, in chunks
+// that are allocated here and owned by V8 once handed over.
+class GoSourceStream : public ScriptCompiler::ExternalSourceStream {
+ public:
+  explicit GoSourceStream(int ref) : ref_(ref) {}
 
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(
-      iso, local_ctx->Global());
+  size_t GetMoreData(const uint8_t** src) override {
+    uint8_t* chunk = new uint8_t[kChunkSize];
+    int n = goStreamingSourceRead(ref_, chunk, kChunkSize);
+    if (n <= 0) {
+      delete[] chunk;
+      return 0;
+    }
+    *src = chunk;
+    return n;
+  }
 
-  return tracked_value(ctx, val);
-}
+ private:
+  static const int kChunkSize = 64 << 10;
+  int ref_;
+};
 
-/********** Value **********/
+// GoOutputStream writes a serialized heap snapshot to a Go io.Writer, one
+// chunk at a time, so that the snapshot is never buffered as a whole.
+class GoOutputStream : public OutputStream {
+ public:
+  explicit GoOutputStream(int ref) : ref_(ref) {}
 
-#define LOCAL_VALUE(val)                   \
-  Isolate* iso = val->iso;                 \
-  Locker locker(iso);                      \
-  Isolate::Scope isolate_scope(iso);       \
-  HandleScope handle_scope(iso);           \
-  TryCatch try_catch(iso);                 \
-  m_ctx* ctx = val->ctx;                   \
-  Local<Context> local_ctx;                \
-  if (ctx != nullptr) {                    \
-    local_ctx = ctx->ptr.Get(iso);         \
-  } else {                                 \
-    ctx = isolateInternalContext(iso);     \
-    local_ctx = ctx->ptr.Get(iso);         \
-  }                                        \
-  Context::Scope context_scope(local_ctx); \
-  Local<Value> value = val->ptr.Get(iso);
+  int GetChunkSize() override { return kChunkSize; }
 
-ValuePtr NewValueInteger(IsolatePtr iso, int32_t v) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(
-      iso, Integer::New(iso, v));
-  return tracked_value(ctx, val);
-}
+  WriteResult WriteAsciiChunk(char* data, int size) override {
+    if (!goHeapSnapshotWrite(ref_, data, size)) {
+      return kAbort;
+    }
+    return kContinue;
+  }
 
-ValuePtr NewValueIntegerFromUnsigned(IsolatePtr iso, uint32_t v) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(
-      iso, Integer::NewFromUnsigned(iso, v));
-  return tracked_value(ctx, val);
-}
+  void EndOfStream() override {}
 
-RtnValue NewValueString(IsolatePtr iso, const char* v, int v_length) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  TryCatch try_catch(iso);
-  RtnValue rtn = {};
-  Local<String> str;
-  if (!String::NewFromUtf8(iso, v, NewStringType::kNormal, v_length)
-           .ToLocal(&str)) {
-    rtn.error = ExceptionError(try_catch, iso, ctx->ptr.Get(iso));
-    return rtn;
+ private:
+  static const int kChunkSize = 64 << 10;
+  int ref_;
+};
+
+// GoTraceStreambuf writes the JSON of a trace to the io.Writer of the trace
+// in Go, in chunks; see goTraceWrite. Writing stops at the first error.
+class GoTraceStreambuf : public std::streambuf {
+ public:
+  GoTraceStreambuf() { setp(buf_, buf_ + kChunkSize); }
+
+ protected:
+  int overflow(int c) override {
+    write();
+    if (c != traits_type::eof()) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
   }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, str);
-  rtn.value = tracked_value(ctx, val);
-  return rtn;
-}
 
-ValuePtr NewValueNull(IsolatePtr iso) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, Null(iso));
-  return tracked_value(ctx, val);
-}
+  int sync() override {
+    write();
+    return 0;
+  }
 
-ValuePtr NewValueUndefined(IsolatePtr iso) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, Undefined(iso));
-  return tracked_value(ctx, val);
-}
+ private:
+  void write() {
+    int n = pptr() - pbase();
+    if (n > 0 && ok_) {
+      ok_ = goTraceWrite(pbase(), n);
+    }
+    setp(buf_, buf_ + kChunkSize);
+  }
 
-ValuePtr NewValueBoolean(IsolatePtr iso, int v) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(
-      iso, Boolean::New(iso, v));
-  return tracked_value(ctx, val);
-}
+  static const int kChunkSize = 64 << 10;
+  bool ok_ = true;
+  char buf_[kChunkSize];
+};
+
+// TraceSession is the trace buffer of the platform's tracing controller. It
+// holds the events of the trace in progress, see StartTracing, in a ring
+// buffer that is written as JSON once the trace stops. The handles of the
+// events carry the number of their trace, so that the end of an event of an
+// earlier trace does not update one of the current buffer.
+class TraceSession : public platform::tracing::TraceBuffer {
+ public:
+  platform::tracing::TraceObject* AddTraceEvent(uint64_t* handle) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffer_ == nullptr) {
+      return nullptr;
+    }
+    platform::tracing::TraceObject* event = buffer_->AddTraceEvent(handle);
+    *handle = (*handle & kHandleMask) | (uint64_t(generation_) << 48);
+    return event;
+  }
+
+  platform::tracing::TraceObject* GetEventByHandle(uint64_t handle) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffer_ == nullptr || (handle >> 48) != generation_) {
+      return nullptr;
+    }
+    return buffer_->GetEventByHandle(handle & kHandleMask);
+  }
+
+  bool Flush() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffer_ == nullptr || buffer_->Flush();
+  }
+
+  // Start sets up the buffer of a trace of up to max_events events; it
+  // returns false if a trace is in progress.
+  bool Start(size_t max_events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffer_ != nullptr) {
+      return false;
+    }
+    size_t chunks = std::max<size_t>(
+        1, (max_events + platform::tracing::TraceBufferChunk::kChunkSize - 1) /
+               platform::tracing::TraceBufferChunk::kChunkSize);
+    streambuf_.reset(new GoTraceStreambuf);
+    stream_.reset(new std::ostream(streambuf_.get()));
+    buffer_.reset(platform::tracing::TraceBuffer::CreateTraceBufferRingBuffer(
+        chunks, platform::tracing::TraceWriter::CreateJSONTraceWriter(*stream_)));
+    generation_ = (generation_ + 1) & 0xffff;
+    return true;
+  }
+
+  // Finish ends the JSON of the trace, once the controller has flushed its
+  // events, and frees the buffer.
+  void Finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The writer, which its buffer owns, closes the JSON when it is deleted.
+    buffer_.reset();
+    if (stream_ != nullptr) {
+      stream_->flush();
+    }
+    stream_.reset();
+    streambuf_.reset();
+  }
+
+ private:
+  static const uint64_t kHandleMask = (uint64_t(1) << 48) - 1;
+  std::mutex mutex_;
+  std::unique_ptr<GoTraceStreambuf> streambuf_;
+  std::unique_ptr<std::ostream> stream_;
+  std::unique_ptr<platform::tracing::TraceBuffer> buffer_;
+  uint64_t generation_ = 0;
+};
+
+// PerfMap writes the names of the code of every isolate to /tmp/perf-PID.map,
+// the symbol map of JIT code that Linux perf and profilers like it read; see
+// PlatformOptions.perfMap. Where --perf-basic-prof opens the file anew for each
+// isolate, truncating it, the map is shared by the isolates of the process.
+// It keeps track of the code that is live, as the GC moves code and reuses
+// its memory, and rewrites the file with that code alone once most of its
+// lines are stale, so that the file does not grow without bound.
+class PerfMap {
+ public:
+  PerfMap() {
+    path_ = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+    open("w");
+  }
+
+  static void Handler(const JitCodeEvent* event) { perf_map->Add(event); }
+
+ private:
+  struct Code {
+    size_t size;
+    std::string name;
+  };
+
+  void Add(const JitCodeEvent* event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ == nullptr) {
+      return;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(event->code_start);
+    switch (event->type) {
+      case JitCodeEvent::CODE_ADDED: {
+        // Bytecode is interpreted rather than run, see
+        // --interpreted-frames-native-stack.
+        if (event->code_len == 0 ||
+            event->code_type == JitCodeEvent::BYTE_CODE) {
+          return;
+        }
+        std::string name(event->name.str, event->name.len);
+        std::replace(name.begin(), name.end(), '\n', ' ');
+        Put(start, Code{event->code_len, std::move(name)});
+        break;
+      }
+      case JitCodeEvent::CODE_MOVED: {
+        auto it = code_.find(start);
+        if (it == code_.end()) {
+          return;
+        }
+        Code code = std::move(it->second);
+        code_.erase(it);
+        Put(reinterpret_cast<uintptr_t>(event->new_code_start),
+            std::move(code));
+        break;
+      }
+      case JitCodeEvent::CODE_REMOVED:
+        code_.erase(start);
+        break;
+      default:
+        return;
+    }
+    if (lines_ > kMinRewriteLines && lines_ > 4 * code_.size()) {
+      Rewrite();
+    }
+  }
+
+  // Put adds the code at start, which replaces the code it overlaps, as V8
+  // does not report the removal of code whose memory is reused.
+  void Put(uintptr_t start, Code code) {
+    auto it = code_.lower_bound(start);
+    if (it != code_.begin()) {
+      auto prev = std::prev(it);
+      if (prev->first + prev->second.size > start) {
+        it = prev;
+      }
+    }
+    while (it != code_.end() && it->first < start + code.size) {
+      it = code_.erase(it);
+    }
+    Write(file_, start, code);
+    lines_++;
+    code_.emplace(start, std::move(code));
+  }
+
+  static void Write(FILE* file, uintptr_t start, const Code& code) {
+    fprintf(file, "%" PRIxPTR " %zx %s\n", start, code.size,
+            code.name.c_str());
+  }
+
+  // Rewrite replaces the file with one of the live code, which profilers
+  // that read the file meanwhile see as a whole, as it is renamed into place.
+  void Rewrite() {
+    std::string tmp = path_ + ".tmp";
+    FILE* file = fopen(tmp.c_str(), "w");
+    if (file == nullptr) {
+      return;
+    }
+    for (const auto& entry : code_) {
+      Write(file, entry.first, entry.second);
+    }
+    fclose(file);
+    if (rename(tmp.c_str(), path_.c_str()) != 0) {
+      remove(tmp.c_str());
+      return;
+    }
+    fclose(file_);
+    open("a");
+    lines_ = code_.size();
+  }
+
+  void open(const char* mode) {
+    file_ = fopen(path_.c_str(), mode);
+    if (file_ != nullptr) {
+      // Profilers read the file while the process runs.
+      setvbuf(file_, nullptr, _IOLBF, 0);
+    }
+  }
+
+  static const size_t kMinRewriteLines = 1 << 16;
+  std::mutex mutex_;
+  std::string path_;
+  FILE* file_;
+  std::map<uintptr_t, Code> code_;
+  // The number of lines of the file.
+  size_t lines_ = 0;
+};
+
+// inspectorUTF8 converts a string of the inspector protocol, which is Latin-1
+// or UTF-16, to UTF-8.
+static std::string inspectorUTF8(const v8_inspector::StringView& view) {
+  std::string str;
+  str.reserve(view.length());
+  auto put = [&str](uint32_t c) {
+    if (c < 0x80) {
+      str += static_cast<char>(c);
+    } else if (c < 0x800) {
+      str += static_cast<char>(0xc0 | c >> 6);
+      str += static_cast<char>(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+      str += static_cast<char>(0xe0 | c >> 12);
+      str += static_cast<char>(0x80 | (c >> 6 & 0x3f));
+      str += static_cast<char>(0x80 | (c & 0x3f));
+    } else {
+      str += static_cast<char>(0xf0 | c >> 18);
+      str += static_cast<char>(0x80 | (c >> 12 & 0x3f));
+      str += static_cast<char>(0x80 | (c >> 6 & 0x3f));
+      str += static_cast<char>(0x80 | (c & 0x3f));
+    }
+  };
+  if (view.is8Bit()) {
+    for (size_t i = 0; i < view.length(); i++) {
+      put(view.characters8()[i]);
+    }
+    return str;
+  }
+  const uint16_t* chars = view.characters16();
+  for (size_t i = 0; i < view.length(); i++) {
+    uint32_t c = chars[i];
+    if (c >= 0xd800 && c < 0xdc00 && i + 1 < view.length() &&
+        chars[i + 1] >= 0xdc00 && chars[i + 1] < 0xe000) {
+      c = 0x10000 + ((c - 0xd800) << 10) + (chars[++i] - 0xdc00);
+    } else if (c >= 0xd800 && c < 0xe000) {
+      c = 0xfffd;
+    }
+    put(c);
+  }
+  return str;
+}
+
+// The context group of the contexts of an isolate's inspector, to which all
+// of its sessions connect.
+static const int kInspectorContextGroup = 1;
+
+// A session of the Chrome DevTools protocol with the inspector of an isolate,
+// which sends the responses and notifications of the session to its Go
+// handler ref as they are made, with the isolate's lock held; see
+// goInspectorMessage.
+struct m_inspectorSession : public v8_inspector::V8Inspector::Channel {
+  m_inspectorSession(Isolate* iso, v8_inspector::V8Inspector* inspector,
+                     int ref)
+      : iso(iso), ref(ref) {
+    session = inspector->connect(kInspectorContextGroup, this,
+                                 v8_inspector::StringView());
+  }
+
+  void sendResponse(
+      int callId,
+      std::unique_ptr<v8_inspector::StringBuffer> message) override {
+    Send(message->string());
+  }
+  void sendNotification(
+      std::unique_ptr<v8_inspector::StringBuffer> message) override {
+    Send(message->string());
+  }
+  void flushProtocolNotifications() override {}
+
+  void Send(const v8_inspector::StringView& view) {
+    std::string message = inspectorUTF8(view);
+    goInspectorMessage(ref, const_cast<char*>(message.data()),
+                       message.size());
+  }
+
+  Isolate* iso;
+  int ref;
+  std::unique_ptr<v8_inspector::V8InspectorSession> session;
+};
+
+// InspectorClient is the inspector of an isolate and owns its sessions. The
+// contexts that it inspects are those that a session has been created for.
+// It cannot pause JavaScript, as the debugger would have it do on a
+// breakpoint: that would take a loop that dispatches the messages of the
+// sessions meanwhile, which Go sends from other threads.
+class InspectorClient : public v8_inspector::V8InspectorClient {
+ public:
+  explicit InspectorClient(Isolate* iso)
+      : iso_(iso), inspector_(v8_inspector::V8Inspector::create(iso, this)) {}
+
+  ~InspectorClient() override {
+    for (m_inspectorSession* session : sessions_) {
+      delete session;
+    }
+  }
+
+  void ContextCreated(m_ctx* ctx) {
+    static const char name[] = "v8go";
+    inspector_->contextCreated(v8_inspector::V8ContextInfo(
+        ctx->ptr.Get(iso_), kInspectorContextGroup,
+        v8_inspector::StringView(reinterpret_cast<const uint8_t*>(name),
+                                 sizeof(name) - 1)));
+    contexts_.push_back(ctx);
+  }
+
+  void ContextDestroyed(m_ctx* ctx) {
+    inspector_->contextDestroyed(ctx->ptr.Get(iso_));
+    contexts_.erase(std::remove(contexts_.begin(), contexts_.end(), ctx),
+                    contexts_.end());
+  }
+
+  m_inspectorSession* Connect(Isolate* iso, int ref) {
+    m_inspectorSession* session =
+        new m_inspectorSession(iso, inspector_.get(), ref);
+    sessions_.insert(session);
+    return session;
+  }
+
+  void Disconnect(m_inspectorSession* session) {
+    sessions_.erase(session);
+    delete session;
+  }
+
+  // The context of the commands that name none, such as Runtime.evaluate
+  // without a contextId, is the first inspected context that is left.
+  Local<Context> ensureDefaultContextInGroup(int) override {
+    if (contexts_.empty()) {
+      return Local<Context>();
+    }
+    return contexts_.front()->ptr.Get(iso_);
+  }
+
+  double currentTimeMS() override {
+    return default_platform->CurrentClockTimeMillis();
+  }
+
+ private:
+  Isolate* iso_;
+  std::unique_ptr<v8_inspector::V8Inspector> inspector_;
+  std::unordered_set<m_inspectorSession*> sessions_;
+  // The inspected contexts, in the order they were created for sessions.
+  std::vector<m_ctx*> contexts_;
+};
+
+// CPUProfileTableBuilder flattens the node tree of a CPU profile, sharing the
+// strings and functions that many nodes have in common.
+class CPUProfileTableBuilder {
+ public:
+  CPUProfileTableBuilder() { String(""); }
+
+  void Add(const CpuProfileNode* node, int parent) {
+    int index = nodes_.size();
+    int line = node->GetLineNumber();
+    CPUProfileTableFunction function{String(node->GetFunctionNameStr()),
+                                     String(node->GetScriptResourceNameStr()),
+                                     line};
+    auto it = functions_.emplace(FunctionKey(function), functions_.size());
+    nodes_.push_back(CPUProfileTableNode{parent, it.first->second, line,
+                                         node->GetHitCount()});
+    if (it.second) {
+      functionList_.push_back(function);
+    }
+    for (int i = 0; i < node->GetChildrenCount(); i++) {
+      Add(node->GetChild(i), index);
+    }
+  }
+
+  CPUProfileTable* Build() {
+    CPUProfileTable* table = new CPUProfileTable;
+    table->nodeCount = nodes_.size();
+    table->nodes = Copy(nodes_);
+    table->functionCount = functionList_.size();
+    table->functions = Copy(functionList_);
+    table->stringCount = offsets_.size();
+    offsets_.push_back(data_.size());
+    table->stringOffsets = Copy(offsets_);
+    table->stringData = Copy(data_);
+    return table;
+  }
+
+ private:
+  typedef std::tuple<int, int, int> FunctionKeyType;
+
+  struct FunctionKeyHash {
+    size_t operator()(const FunctionKeyType& key) const {
+      return std::get<0>(key) * 31 * 31 + std::get<1>(key) * 31 +
+             std::get<2>(key);
+    }
+  };
+
+  static FunctionKeyType FunctionKey(const CPUProfileTableFunction& f) {
+    return FunctionKeyType(f.name, f.scriptName, f.line);
+  }
+
+  int String(const char* str) {
+    auto it = strings_.emplace(str, offsets_.size());
+    if (it.second) {
+      offsets_.push_back(data_.size());
+      data_.insert(data_.end(), str, str + strlen(str));
+    }
+    return it.first->second;
+  }
+
+  template <typename T>
+  static T* Copy(const std::vector<T>& v) {
+    T* mem = static_cast<T*>(malloc(sizeof(T) * std::max<size_t>(v.size(), 1)));
+    std::copy(v.begin(), v.end(), mem);
+    return mem;
+  }
+
+  std::vector<CPUProfileTableNode> nodes_;
+  std::vector<CPUProfileTableFunction> functionList_;
+  std::unordered_map<FunctionKeyType, int, FunctionKeyHash> functions_;
+  std::unordered_map<std::string, int> strings_;
+  std::vector<int> offsets_;
+  std::vector<char> data_;
+};
+
+// BulkWriter is a growable buffer of malloc'd memory, which is handed over to
+// Go as is.
+class BulkWriter {
+ public:
+  ~BulkWriter() { free(data_); }
+
+  char* Reserve(size_t n) {
+    if (length_ + n > capacity_) {
+      capacity_ = std::max(capacity_ * 2, length_ + n);
+      data_ = static_cast<char*>(realloc(data_, capacity_));
+    }
+    char* p = data_ + length_;
+    length_ += n;
+    return p;
+  }
+
+  void Tag(BulkTag tag) { *Reserve(1) = static_cast<char>(tag); }
+
+  template <class T>
+  void Put(T v) {
+    memcpy(Reserve(sizeof(T)), &v, sizeof(T));
+  }
+
+  char* Release(size_t* length) {
+    char* data = data_;
+    *length = length_;
+    data_ = nullptr;
+    length_ = capacity_ = 0;
+    return data;
+  }
+
+ private:
+  char* data_ = nullptr;
+  size_t length_ = 0;
+  size_t capacity_ = 0;
+};
+
+// Values of these types are exported as BULK_VALUE, rather than as the plain
+// object that they also are.
+static const uint64_t kBulkValueTypes =
+    VALUE_TYPE_BIT(FUNCTION) | VALUE_TYPE_BIT(PROXY) | VALUE_TYPE_BIT(DATE) |
+    VALUE_TYPE_BIT(REG_EXP) | VALUE_TYPE_BIT(NATIVE_ERROR) |
+    VALUE_TYPE_BIT(PROMISE) | VALUE_TYPE_BIT(MAP) | VALUE_TYPE_BIT(SET) |
+    VALUE_TYPE_BIT(WEAK_MAP) | VALUE_TYPE_BIT(WEAK_SET) |
+    VALUE_TYPE_BIT(MAP_ITERATOR) | VALUE_TYPE_BIT(SET_ITERATOR) |
+    VALUE_TYPE_BIT(GENERATOR_OBJECT) | VALUE_TYPE_BIT(ARRAY_BUFFER) |
+    VALUE_TYPE_BIT(SHARED_ARRAY_BUFFER) | VALUE_TYPE_BIT(ARRAY_BUFFER_VIEW) |
+    VALUE_TYPE_BIT(BIG_INT_OBJECT) | VALUE_TYPE_BIT(NUMBER_OBJECT) |
+    VALUE_TYPE_BIT(STRING_OBJECT) | VALUE_TYPE_BIT(SYMBOL_OBJECT) |
+    VALUE_TYPE_BIT(ARGUMENTS_OBJECT) | VALUE_TYPE_BIT(WASM_MODULE_OBJECT) |
+    VALUE_TYPE_BIT(MODULE_NAMESPACE_OBJECT);
+
+// Nesting deeper than this is reported as an error rather than risking the
+// C stack.
+static const size_t kBulkMaxDepth = 1000;
+
+// BulkExporter walks a value graph, writing it in the bulk value format.
+// Write returns false with an exception pending on the TryCatch of the caller
+// if a getter throws, or the graph has a cycle or is nested too deeply.
+class BulkExporter {
+ public:
+  BulkExporter(m_ctx* ctx, Local<Context> local_ctx)
+      : ctx_(ctx), iso_(ctx->iso), local_ctx_(local_ctx) {}
+
+  bool Write(Local<Value> value) {
+    if (value->IsUndefined()) {
+      out.Tag(BULK_UNDEFINED);
+    } else if (value->IsNull()) {
+      out.Tag(BULK_NULL);
+    } else if (value->IsBoolean()) {
+      out.Tag(value->IsTrue() ? BULK_TRUE : BULK_FALSE);
+    } else if (value->IsInt32()) {
+      out.Tag(BULK_INT32);
+      out.Put<int32_t>(value.As<Int32>()->Value());
+    } else if (value->IsNumber()) {
+      out.Tag(BULK_NUMBER);
+      out.Put<double>(value.As<Number>()->Value());
+    } else if (value->IsString()) {
+      out.Tag(BULK_STRING);
+      WriteString(value.As<String>());
+    } else if (!value->IsObject() || (valueTypeOf(value) & kBulkValueTypes)) {
+      out.Tag(BULK_VALUE);
+      out.Put<uint32_t>(values.size());
+      values.push_back(tracked_value(ctx_, value));
+    } else {
+      return WriteObject(value.As<Object>());
+    }
+    return true;
+  }
+
+  // WriteProperties writes the keys of obj, which are strings, and the value
+  // of each if entries is set. The values are not converted any deeper than
+  // the properties themselves: those that are objects are written as values.
+  bool WriteProperties(Local<Object> obj, Local<Array> keys, bool entries) {
+    uint32_t count = keys->Length();
+    out.Tag(BULK_ARRAY);
+    out.Put<uint32_t>(count);
+    for (uint32_t i = 0; i < count; i++) {
+      HandleScope handle_scope(iso_);
+      Local<Value> key, value;
+      if (!keys->Get(local_ctx_, i).ToLocal(&key)) {
+        return false;
+      }
+      out.Tag(BULK_STRING);
+      WriteString(key.As<String>());
+      if (!entries) {
+        continue;
+      }
+      if (!obj->Get(local_ctx_, key).ToLocal(&value)) {
+        return false;
+      }
+      WriteShallow(value);
+    }
+    return true;
+  }
+
+  // WriteElements writes the elements of arr, which has no holes, as
+  // WriteProperties writes the values of properties.
+  void WriteElements(Local<Array> arr) {
+    uint32_t length = arr->Length();
+    out.Tag(BULK_ARRAY);
+    out.Put<uint32_t>(length);
+    for (uint32_t i = 0; i < length; i++) {
+      HandleScope handle_scope(iso_);
+      WriteShallow(arr->Get(local_ctx_, i).ToLocalChecked());
+    }
+  }
+
+  // Finish hands the buffer and the values over to rtn.
+  void Finish(RtnBulk* rtn) {
+    rtn->data = out.Release(&rtn->length);
+    rtn->valuesCount = values.size();
+    if (rtn->valuesCount > 0) {
+      size_t size = rtn->valuesCount * sizeof(ValuePtr);
+      rtn->values = static_cast<ValuePtr*>(malloc(size));
+      memcpy(rtn->values, values.data(), size);
+    }
+  }
+
+  BulkWriter out;
+  std::vector<ValuePtr> values;
+
+ private:
+  // WriteShallow writes a primitive as Write does, and an object as a value.
+  void WriteShallow(Local<Value> value) {
+    if (value->IsObject()) {
+      out.Tag(BULK_VALUE);
+      out.Put<uint32_t>(values.size());
+      values.push_back(tracked_value(ctx_, value));
+    } else {
+      Write(value);
+    }
+  }
+
+  void WriteString(Local<String> str) {
+    int length = str->Utf8Length(iso_);
+    out.Put<uint32_t>(length);
+    str->WriteUtf8(iso_, out.Reserve(length), length, nullptr,
+                   String::NO_NULL_TERMINATION | String::REPLACE_INVALID_UTF8);
+  }
+
+  bool WriteObject(Local<Object> obj) {
+    for (const Local<Object>& ancestor : ancestors_) {
+      if (ancestor == obj) {
+        iso_->ThrowException(Exception::TypeError(
+            String::NewFromUtf8Literal(iso_, "Converting circular structure")));
+        return false;
+      }
+    }
+    if (ancestors_.size() >= kBulkMaxDepth) {
+      iso_->ThrowException(Exception::RangeError(
+          String::NewFromUtf8Literal(iso_, "Maximum nesting depth exceeded")));
+      return false;
+    }
+    ancestors_.push_back(obj);
+    bool ok = obj->IsArray() ? WriteArrayElements(obj.As<Array>())
+                             : WriteObjectProperties(obj);
+    ancestors_.pop_back();
+    return ok;
+  }
+
+  bool WriteArrayElements(Local<Array> arr) {
+    uint32_t length = arr->Length();
+    out.Tag(BULK_ARRAY);
+    out.Put<uint32_t>(length);
+    for (uint32_t i = 0; i < length; i++) {
+      HandleScope handle_scope(iso_);
+      Local<Value> element;
+      if (!arr->Get(local_ctx_, i).ToLocal(&element) || !Write(element)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool WriteObjectProperties(Local<Object> obj) {
+    HandleScope handle_scope(iso_);
+    Local<Array> keys;
+    if (!obj->GetOwnPropertyNames(
+                local_ctx_,
+                static_cast<PropertyFilter>(ONLY_ENUMERABLE | SKIP_SYMBOLS),
+                KeyConversionMode::kConvertToString)
+             .ToLocal(&keys)) {
+      return false;
+    }
+    uint32_t count = keys->Length();
+    out.Tag(BULK_OBJECT);
+    out.Put<uint32_t>(count);
+    for (uint32_t i = 0; i < count; i++) {
+      HandleScope handle_scope(iso_);
+      Local<Value> key, value;
+      if (!keys->Get(local_ctx_, i).ToLocal(&key) ||
+          !obj->Get(local_ctx_, key).ToLocal(&value)) {
+        return false;
+      }
+      WriteString(key.As<String>());
+      if (!Write(value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  m_ctx* ctx_;
+  Isolate* iso_;
+  Local<Context> local_ctx_;
+  std::vector<Local<Object>> ancestors_;
+};
+
+// BulkImporter builds the values of a buffer in the bulk value format, which
+// Go has checked to be well formed. Read returns an empty handle if a string
+// cannot be created.
+class BulkImporter {
+ public:
+  BulkImporter(Isolate* iso, const char* data, ValuePtr* values)
+      : iso_(iso), p_(data), values_(values) {}
+
+  MaybeLocal<Value> Read() {
+    switch (static_cast<BulkTag>(*p_++)) {
+      case BULK_UNDEFINED:
+        return Undefined(iso_);
+      case BULK_NULL:
+        return Null(iso_);
+      case BULK_FALSE:
+        return False(iso_);
+      case BULK_TRUE:
+        return True(iso_);
+      case BULK_INT32:
+        return Integer::New(iso_, Get<int32_t>());
+      case BULK_NUMBER:
+        return Number::New(iso_, Get<double>());
+      case BULK_STRING: {
+        Local<String> str;
+        if (!ReadString(NewStringType::kNormal).ToLocal(&str)) {
+          return MaybeLocal<Value>();
+        }
+        return str;
+      }
+      case BULK_ARRAY:
+        return ReadArray();
+      case BULK_OBJECT:
+        return ReadObject();
+      case BULK_VALUE:
+        return values_[Get<uint32_t>()]->ptr.Get(iso_);
+      case BULK_SHAPE:
+        return ReadShape();
+      case BULK_BIGINT:
+        return ReadBigInt();
+    }
+    return MaybeLocal<Value>();
+  }
+
+ private:
+  template <class T>
+  T Get() {
+    T v;
+    memcpy(&v, p_, sizeof(T));
+    p_ += sizeof(T);
+    return v;
+  }
+
+  MaybeLocal<String> ReadString(NewStringType type) {
+    uint32_t length = Get<uint32_t>();
+    const char* data = p_;
+    p_ += length;
+    return String::NewFromUtf8(iso_, data, type, length);
+  }
+
+  MaybeLocal<Value> ReadArray() {
+    uint32_t length = Get<uint32_t>();
+    std::vector<Local<Value>> elements(length);
+    for (uint32_t i = 0; i < length; i++) {
+      if (!Read().ToLocal(&elements[i])) {
+        return MaybeLocal<Value>();
+      }
+    }
+    return Array::New(iso_, elements.data(), length);
+  }
+
+  MaybeLocal<Value> ReadObject() {
+    uint32_t count = Get<uint32_t>();
+    // Keys are internalized, so that objects built from the same Go types
+    // share their keys, and their hidden classes.
+    std::vector<Local<Name>> names(count);
+    std::vector<Local<Value>> values(count);
+    for (uint32_t i = 0; i < count; i++) {
+      Local<String> name;
+      if (!ReadString(NewStringType::kInternalized).ToLocal(&name) ||
+          !Read().ToLocal(&values[i])) {
+        return MaybeLocal<Value>();
+      }
+      names[i] = name;
+    }
+    return NewObject(names.data(), values.data(), count);
+  }
+
+  MaybeLocal<Value> ReadBigInt() {
+    int sign_bit = Get<uint8_t>();
+    uint32_t count = Get<uint32_t>();
+    std::vector<uint64_t> words(count);
+    for (uint32_t i = 0; i < count; i++) {
+      words[i] = Get<uint64_t>();
+    }
+    Local<BigInt> value;
+    if (!BigInt::NewFromWords(iso_->GetCurrentContext(), sign_bit, count,
+                              words.data())
+             .ToLocal(&value)) {
+      return MaybeLocal<Value>();
+    }
+    return value;
+  }
+
+  // Objects of a shape are created with the same keys in the same order, so
+  // they share a hidden class like the objects of a literal do.
+  MaybeLocal<Value> ReadShape() {
+    const std::vector<Global<String>>& keys =
+        isolateData(iso_)->shapes[Get<uint32_t>()];
+    size_t count = keys.size();
+    std::vector<Local<Name>> names(count);
+    std::vector<Local<Value>> values(count);
+    for (size_t i = 0; i < count; i++) {
+      names[i] = keys[i].Get(iso_);
+      if (!Read().ToLocal(&values[i])) {
+        return MaybeLocal<Value>();
+      }
+    }
+    return NewObject(names.data(), values.data(), count);
+  }
+
+  Local<Object> NewObject(Local<Name>* names,
+                          Local<Value>* values,
+                          size_t count) {
+    if (prototype_.IsEmpty()) {
+      prototype_ = Object::New(iso_)->GetPrototype();
+    }
+    return Object::New(iso_, prototype_, names, values, count);
+  }
+
+  Isolate* iso_;
+  const char* p_;
+  ValuePtr* values_;
+  Local<Value> prototype_;
+};
+
+// threadCPUTime returns the CPU time used by the calling thread.
+static int64_t threadCPUTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Watchdog terminates the execution of isolates whose deadline has passed, or
+// that have used up their CPU budget. A single thread serves every isolate of
+// the process, keeping the deadlines in a hashed timer wheel of one
+// millisecond ticks, so that arming and disarming a deadline are constant
+// time; the thread only ticks while one is armed. CPU budgets are timers that
+// periodically interrupt the isolate, so that the thread running it can read
+// its own CPU time.
+class Watchdog {
+ public:
+  static Watchdog* Get() {
+    // Never destroyed, the thread runs until the process exits.
+    static Watchdog* watchdog = new Watchdog();
+    return watchdog;
+  }
+
+  uint64_t Arm(Isolate* iso, int64_t timeout_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    return AddTimer(iso, timeout_ms, false);
+  }
+
+  // ArmBudget limits the CPU time of the calling thread, which must be the
+  // one that runs the isolate until DisarmBudget is called.
+  uint64_t ArmBudget(Isolate* iso, int64_t limit_ns, int ref) {
+    std::lock_guard<std::mutex> lock(mu_);
+    uint64_t id = AddTimer(iso, kSampleTicks, true);
+    budgets_.emplace(id, Budget{threadCPUTime(), limit_ns, ref, false});
+    return id;
+  }
+
+  // Disarm cancels a deadline, returning whether it has already fired.
+  bool Disarm(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    RemoveTimer(id);
+    return fired_.erase(id) > 0;
+  }
+
+  // DisarmBudget cancels a CPU budget, returning whether it was exceeded.
+  bool DisarmBudget(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mu_);
+    RemoveTimer(id);
+    auto it = budgets_.find(id);
+    bool exceeded = it != budgets_.end() && it->second.exceeded;
+    budgets_.erase(id);
+    return exceeded;
+  }
+
+ private:
+  static const uint64_t kSlots = 1024;
+  // How often a fired timer terminates the isolate again until it is
+  // disarmed. A termination that is requested while no thread holds the
+  // isolate's lock can be lost when the next one takes it.
+  static const uint64_t kRetryTicks = 10;
+  // How often the CPU time of an isolate with a budget is sampled.
+  static const uint64_t kSampleTicks = 5;
+
+  struct Timer {
+    uint64_t id;
+    Isolate* iso;
+    // The number of times the wheel turns before the timer is due.
+    uint64_t rounds;
+    // Whether the timer samples a CPU budget rather than being a deadline.
+    bool sample;
+  };
+
+  struct Armed {
+    size_t slot;
+    std::list<Timer>::iterator timer;
+  };
+
+  struct Budget {
+    int64_t start;
+    int64_t limit;
+    int ref;
+    bool exceeded;
+  };
+
+  Watchdog() : start_(std::chrono::steady_clock::now()) {
+    std::thread(&Watchdog::Run, this).detach();
+  }
+
+  uint64_t AddTimer(Isolate* iso, int64_t timeout_ms, bool sample) {
+    if (timers_.empty()) {
+      // The wheel stood still while nothing was armed.
+      tick_ = Now();
+      cv_.notify_one();
+    }
+    // A tick is started already, so one more is waited for to be sure that
+    // the whole timeout has passed.
+    uint64_t target = Now() + std::max<int64_t>(timeout_ms, 0) + 1;
+    if (target < tick_) {
+      target = tick_;
+    }
+    uint64_t id = next_id_++;
+    size_t slot = target % kSlots;
+    slots_[slot].push_front(Timer{id, iso, (target - tick_) / kSlots, sample});
+    timers_.emplace(id, Armed{slot, slots_[slot].begin()});
+    return id;
+  }
+
+  void RemoveTimer(uint64_t id) {
+    auto it = timers_.find(id);
+    if (it != timers_.end()) {
+      slots_[it->second.slot].erase(it->second.timer);
+      timers_.erase(it);
+    }
+  }
+
+  // Requeue moves the due timer it of slot to ticks from now.
+  void Requeue(std::list<Timer>& slot,
+               std::list<Timer>::iterator it,
+               uint64_t ticks) {
+    size_t next = (tick_ + ticks) % kSlots;
+    slots_[next].splice(slots_[next].begin(), slot, it);
+    timers_[it->id].slot = next;
+  }
+
+  static void SampleInterrupt(Isolate* iso, void* data) {
+    Get()->Sample(iso, reinterpret_cast<uintptr_t>(data));
+  }
+
+  // Sample runs on the thread running the isolate, between two JavaScript
+  // operations, and terminates its execution if its budget is exceeded and
+  // Go does not extend it.
+  void Sample(Isolate* iso, uint64_t id) {
+    int64_t used;
+    int ref;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      auto it = budgets_.find(id);
+      if (it == budgets_.end() || it->second.exceeded) {
+        return;
+      }
+      used = threadCPUTime() - it->second.start;
+      if (used < it->second.limit) {
+        return;
+      }
+      ref = it->second.ref;
+    }
+    int64_t extension = goCPUBudgetExceeded(ref, used);
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = budgets_.find(id);
+    if (it == budgets_.end()) {
+      return;
+    }
+    if (extension > 0) {
+      it->second.limit = used + extension;
+      return;
+    }
+    it->second.exceeded = true;
+    iso->TerminateExecution();
+  }
+
+  uint64_t Now() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start_)
+        .count();
+  }
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+      cv_.wait(lock, [this] { return !timers_.empty(); });
+      for (uint64_t now = Now(); tick_ <= now; tick_++) {
+        std::list<Timer>& slot = slots_[tick_ % kSlots];
+        for (auto it = slot.begin(); it != slot.end();) {
+          if (it->rounds > 0) {
+            it->rounds--;
+            ++it;
+            continue;
+          }
+          auto due = it++;
+          if (due->sample) {
+            due->iso->RequestInterrupt(SampleInterrupt,
+                                       reinterpret_cast<void*>(due->id));
+            Requeue(slot, due, kSampleTicks);
+            continue;
+          }
+          due->iso->TerminateExecution();
+          fired_.insert(due->id);
+          Requeue(slot, due, kRetryTicks);
+        }
+      }
+      cv_.wait_until(lock, start_ + std::chrono::milliseconds(tick_));
+    }
+  }
+
+  const std::chrono::steady_clock::time_point start_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::list<Timer> slots_[kSlots];
+  std::unordered_map<uint64_t, Armed> timers_;
+  std::unordered_set<uint64_t> fired_;
+  std::unordered_map<uint64_t, Budget> budgets_;
+  // The next tick of the wheel to process.
+  uint64_t tick_ = 0;
+  uint64_t next_id_ = 1;
+};
+
+// WorkerPoolPlatform is the platform of V8 when Go enables the worker pool of
+// v8go, see Init. It runs the worker tasks of V8, such as those of concurrent
+// marking and compilation, on a bounded pool of threads of its own, which keeps
+// statistics of the tasks, and leaves everything else to the libplatform
+// default platform, whose message loop runs the foreground tasks. Tasks run by
+// priority, blocking tasks first and low priority tasks last.
+class WorkerPoolPlatform : public Platform {
+ public:
+  WorkerPoolPlatform(Platform* delegate, int threads)
+      : delegate_(delegate), threads_(threads) {
+    // The workers run until the process exits, the platform is never
+    // destroyed.
+    for (int i = 0; i < threads; i++) {
+      std::thread(&WorkerPoolPlatform::Work, this).detach();
+    }
+  }
+
+  PlatformStatistics Statistics() {
+    std::lock_guard<std::mutex> lock(mu_);
+    PlatformStatistics stats = stats_;
+    stats.workerThreads = threads_;
+    stats.queuedTasks = 0;
+    for (auto& queue : queues_) {
+      stats.queuedTasks += queue.size();
+    }
+    stats.delayedTasks = delayed_.size();
+    return stats;
+  }
+
+  int NumberOfWorkerThreads() override { return threads_; }
+
+  void CallOnWorkerThread(std::unique_ptr<Task> task) override {
+    Post(kNormal, std::move(task));
+  }
+
+  void CallBlockingTaskOnWorkerThread(std::unique_ptr<Task> task) override {
+    Post(kBlocking, std::move(task));
+  }
+
+  void CallLowPriorityTaskOnWorkerThread(std::unique_ptr<Task> task) override {
+    Post(kLow, std::move(task));
+  }
+
+  void CallDelayedOnWorkerThread(std::unique_ptr<Task> task,
+                                 double delay_in_seconds) override {
+    auto due = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(
+                                      std::max(delay_in_seconds, 0.0)));
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      delayed_.emplace(due, std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  std::unique_ptr<JobHandle> PostJob(
+      TaskPriority priority,
+      std::unique_ptr<JobTask> job_task) override {
+    // The workers of jobs are posted to the pool as worker tasks.
+    return platform::NewDefaultJobHandle(this, priority, std::move(job_task),
+                                         threads_);
+  }
+
+  PageAllocator* GetPageAllocator() override {
+    return delegate_->GetPageAllocator();
+  }
+
+  void OnCriticalMemoryPressure() override {
+    delegate_->OnCriticalMemoryPressure();
+  }
+
+  bool OnCriticalMemoryPressure(size_t length) override {
+    return delegate_->OnCriticalMemoryPressure(length);
+  }
+
+  std::shared_ptr<TaskRunner> GetForegroundTaskRunner(Isolate* iso) override {
+    return delegate_->GetForegroundTaskRunner(iso);
+  }
+
+  bool IdleTasksEnabled(Isolate* iso) override {
+    return delegate_->IdleTasksEnabled(iso);
+  }
+
+  double MonotonicallyIncreasingTime() override {
+    return delegate_->MonotonicallyIncreasingTime();
+  }
+
+  double CurrentClockTimeMillis() override {
+    return delegate_->CurrentClockTimeMillis();
+  }
+
+  StackTracePrinter GetStackTracePrinter() override {
+    return delegate_->GetStackTracePrinter();
+  }
+
+  TracingController* GetTracingController() override {
+    return delegate_->GetTracingController();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  enum { kBlocking, kNormal, kLow, kPriorities };
+
+  struct Queued {
+    std::unique_ptr<Task> task;
+    Clock::time_point queued;
+  };
+
+  static int64_t Nanoseconds(Clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+  }
+
+  void Post(int priority, std::unique_ptr<Task> task) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      queues_[priority].push_back(Queued{std::move(task), Clock::now()});
+    }
+    cv_.notify_one();
+  }
+
+  void Work() {
+    std::unique_lock<std::mutex> lock(mu_);
+    for (;;) {
+      Clock::time_point now = Clock::now();
+      // Delayed tasks that are due queue up with normal priority, waiting
+      // from the time they were due.
+      while (!delayed_.empty() && delayed_.begin()->first <= now) {
+        auto due = delayed_.begin();
+        queues_[kNormal].push_back(
+            Queued{std::move(due->second), due->first});
+        delayed_.erase(due);
+      }
+      std::deque<Queued>* queue = nullptr;
+      for (auto& q : queues_) {
+        if (!q.empty()) {
+          queue = &q;
+          break;
+        }
+      }
+      if (queue == nullptr) {
+        if (delayed_.empty()) {
+          cv_.wait(lock);
+        } else {
+          cv_.wait_until(lock, delayed_.begin()->first);
+        }
+        continue;
+      }
+
+      Queued next = std::move(queue->front());
+      queue->pop_front();
+      bool more = !queue->empty();
+      int64_t waited = Nanoseconds(now - next.queued);
+      stats_.totalQueueTime += waited;
+      stats_.maxQueueTime = std::max(stats_.maxQueueTime, waited);
+      stats_.runningTasks++;
+      lock.unlock();
+      if (more) {
+        cv_.notify_one();
+      }
+      next.task->Run();
+      next.task.reset();
+      Clock::time_point end = Clock::now();
+      lock.lock();
+      stats_.runningTasks--;
+      stats_.completedTasks++;
+      stats_.totalRunTime += Nanoseconds(end - now);
+    }
+  }
+
+  Platform* delegate_;
+  const int threads_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<Queued> queues_[kPriorities];
+  std::multimap<Clock::time_point, std::unique_ptr<Task>> delayed_;
+  PlatformStatistics stats_ = {};
+};
+
+// The platform of V8 when the worker pool is enabled, never destroyed.
+static WorkerPoolPlatform* worker_platform = nullptr;
+
+// widenElements converts the n elements of T at the start of dst to U in
+// place, from the last: a U overlaps only the Ts after its own, which are
+// converted before it.
+template <typename T, typename U>
+static void widenElements(void* dst, size_t n) {
+  char* bytes = static_cast<char*>(dst);
+  for (size_t i = n; i-- > 0;) {
+    T t;
+    memcpy(&t, bytes + i * sizeof(T), sizeof(T));
+    U u = static_cast<U>(t);
+    memcpy(bytes + i * sizeof(U), &u, sizeof(U));
+  }
+}
+
+template <typename T, typename U>
+static bool copyTypedElements(Local<TypedArray> arr, void* dst, size_t n) {
+  // CopyContents reads typed arrays on the JS heap as they are, which Buffer
+  // would move off it first.
+  arr->CopyContents(dst, n * sizeof(T));
+  if (!std::is_same<T, U>::value) {
+    widenElements<T, U>(dst, n);
+  }
+  return true;
+}
+
+// copyTypedArray copies the first n elements of arr to dst if they convert to
+// U as they are, and returns false for the elements that ToNumber or ToInt32
+// must convert one by one, as those of a BigInt64Array.
+template <typename U>
+static bool copyTypedArray(Local<TypedArray> arr, U* dst, size_t n) {
+  if (arr->IsInt8Array()) {
+    return copyTypedElements<int8_t, U>(arr, dst, n);
+  } else if (arr->IsUint8Array() || arr->IsUint8ClampedArray()) {
+    return copyTypedElements<uint8_t, U>(arr, dst, n);
+  } else if (arr->IsInt16Array()) {
+    return copyTypedElements<int16_t, U>(arr, dst, n);
+  } else if (arr->IsUint16Array()) {
+    return copyTypedElements<uint16_t, U>(arr, dst, n);
+  } else if (arr->IsInt32Array()) {
+    return copyTypedElements<int32_t, U>(arr, dst, n);
+  } else if (arr->IsUint32Array()) {
+    // ToInt32 wraps the elements above 2^31-1 around, as the cast does.
+    return copyTypedElements<uint32_t, U>(arr, dst, n);
+  } else if (std::is_same<U, double>::value && arr->IsFloat32Array()) {
+    return copyTypedElements<float, U>(arr, dst, n);
+  } else if (std::is_same<U, double>::value && arr->IsFloat64Array()) {
+    return copyTypedElements<double, U>(arr, dst, n);
+  }
+  return false;
+}
+
+static bool numberElement(Local<Context> ctx, Local<Value> v, double* dst) {
+  if (v->IsNumber()) {
+    *dst = v.As<Number>()->Value();
+    return true;
+  }
+  return v->NumberValue(ctx).To(dst);
+}
+
+static bool numberElement(Local<Context> ctx, Local<Value> v, int32_t* dst) {
+  if (v->IsInt32()) {
+    *dst = v.As<Int32>()->Value();
+    return true;
+  }
+  return v->Int32Value(ctx).To(dst);
+}
+
+// copyNumbers copies the first n elements of the Array or TypedArray value to
+// dst as U, setting done to the number of elements copied.
+template <typename U>
+static RtnError copyNumbers(Isolate* iso,
+                            Local<Context> local_ctx,
+                            TryCatch& try_catch,
+                            Local<Value> value,
+                            U* dst,
+                            size_t n,
+                            size_t* done) {
+  RtnError rtn = {};
+  *done = 0;
+  if (value->IsTypedArray()) {
+    Local<TypedArray> arr = value.As<TypedArray>();
+    n = std::min(n, arr->Length());
+    if (copyTypedArray(arr, dst, n)) {
+      *done = n;
+      return rtn;
+    }
+  } else if (value->IsArray()) {
+    n = std::min<size_t>(n, value.As<Array>()->Length());
+  } else {
+    rtn.msg = CopyString("TypeError: value is not an Array or a TypedArray");
+    return rtn;
+  }
+  Local<Object> obj = value.As<Object>();
+  // The handles of the elements are released a chunk at a time.
+  const size_t chunk = 1024;
+  for (size_t start = 0; start < n; start += chunk) {
+    HandleScope chunk_scope(iso);
+    size_t end = std::min(n, start + chunk);
+    for (size_t i = start; i < end; i++) {
+      Local<Value> element;
+      if (!obj->Get(local_ctx, static_cast<uint32_t>(i)).ToLocal(&element) ||
+          !numberElement(local_ctx, element, &dst[i])) {
+        *done = i;
+        return ExceptionError(try_catch, iso, local_ctx);
+      }
+    }
+  }
+  *done = n;
+  return rtn;
+}
+
+extern "C" {
+
+/********** Isolate **********/
+
+#define ISOLATE_SCOPE(iso)           \
+  LOCK_ISOLATE(iso);                 \
+  Isolate::Scope isolate_scope(iso); \
+  HandleScope handle_scope(iso);
+
+#define ISOLATE_SCOPE_INTERNAL_CONTEXT(iso) \
+  ISOLATE_SCOPE(iso);                       \
+  m_ctx* ctx = isolateInternalContext(iso);
+
+PlatformStatistics GetPlatformStatistics() {
+  if (worker_platform == nullptr) {
+    PlatformStatistics stats = {};
+    return stats;
+  }
+  return worker_platform->Statistics();
+}
+
+// The C API of the ICU of V8, whose headers are not part of deps/include. ICU
+// suffixes its functions with its major version, which the version of V8
+// determines; UErrorCode and UDataFileAccess are int enums.
+#define V8GO_ICU_VERSION_SUFFIX _69
+#define V8GO_ICU_CONCAT(name, suffix) name##suffix
+#define V8GO_ICU_RENAME(name, suffix) V8GO_ICU_CONCAT(name, suffix)
+#define V8GO_ICU(name) V8GO_ICU_RENAME(name, V8GO_ICU_VERSION_SUFFIX)
+extern "C" {
+void V8GO_ICU(udata_setCommonData)(const void* data, int* err);
+void V8GO_ICU(udata_setFileAccess)(int access, int* err);
+}
+const int UDataOnlyPackages = 1;
+
+int ICUDataFromFile() {
+  // A library that embeds its ICU data, or has no Intl support, ignores the
+  // file, where one that loads it fails without one.
+  return !V8::InitializeICU(nullptr);
+}
+
+int SetICUData(const void* data) {
+  int err = 0;
+  V8GO_ICU(udata_setCommonData)(data, &err);
+  if (err > 0) {
+    return err;
+  }
+  // The data is all there is, so ICU is not to look for files of its own.
+  V8GO_ICU(udata_setFileAccess)(UDataOnlyPackages, &err);
+  return err > 0 ? err : 0;
+}
+
+void Init(PlatformOptions opts) {
+#ifdef _WIN32
+  V8::InitializeExternalStartupData(".");
+#endif
+  idle_tasks = opts.idleTasks;
+  platform::IdleTaskSupport idle_task_support =
+      idle_tasks ? platform::IdleTaskSupport::kEnabled
+                 : platform::IdleTaskSupport::kDisabled;
+#ifndef _WIN32
+  if (opts.perfMap) {
+    perf_map = new PerfMap;
+  }
+#endif
+  // The controller records nothing until StartTracing is called.
+  trace_session = new TraceSession;
+  tracing_controller = new platform::tracing::TracingController;
+  tracing_controller->Initialize(trace_session);
+  std::unique_ptr<TracingController> controller(tracing_controller);
+  if (!opts.workerPool) {
+    default_platform = platform::NewDefaultPlatform(
+        opts.threadPoolSize, idle_task_support,
+        platform::InProcessStackDumping::kDisabled, std::move(controller));
+    V8::InitializePlatform(default_platform.get());
+    V8::Initialize();
+    return;
+  }
+
+  // The worker tasks of the default platform go to the pool instead, so it
+  // gets a single worker thread, which stays idle.
+  default_platform = platform::NewDefaultPlatform(
+      1, idle_task_support, platform::InProcessStackDumping::kDisabled,
+      std::move(controller));
+  int threads = opts.threadPoolSize;
+  if (threads <= 0) {
+    // The same default as the default platform.
+    int cpus = std::thread::hardware_concurrency();
+    threads = std::max(1, std::min(cpus - 1, 16));
+  }
+  worker_platform = new WorkerPoolPlatform(default_platform.get(), threads);
+  V8::InitializePlatform(worker_platform);
+  V8::Initialize();
+  return;
+}
+
+int StartTracing(const char** categories,
+                 int categories_count,
+                 size_t max_events) {
+  if (!trace_session->Start(max_events)) {
+    return 0;
+  }
+  platform::tracing::TraceConfig* config =
+      new platform::tracing::TraceConfig;
+  for (int i = 0; i < categories_count; i++) {
+    config->AddIncludedCategory(categories[i]);
+  }
+  tracing_controller->StartTracing(config);
+  return 1;
+}
+
+void StopTracing() {
+  // The controller flushes the events of the buffer to its writer.
+  tracing_controller->StopTracing();
+  trace_session->Finish();
+}
+
+static const intptr_t* externalReferences();
+static void TextCodingCallback(const FunctionCallbackInfo<Value>& info);
+
+// NearHeapLimit keeps a script that exhausts the heap of an isolate from
+// aborting the process. It terminates the execution, raising the limit for the
+// script to unwind, and reports the isolate to Go the first time.
+static size_t NearHeapLimit(void* data,
+                            size_t current_heap_limit,
+                            size_t initial_heap_limit) {
+  Isolate* iso = static_cast<Isolate*>(data);
+  iso->TerminateExecution();
+  if (!isolateData(iso)->heapLimitReached.exchange(true)) {
+    goHeapLimitReached(iso, current_heap_limit, initial_heap_limit);
+  }
+  return current_heap_limit + initial_heap_limit;
+}
+
+// StreamWasmModule hands the WasmStreaming of WebAssembly.compileStreaming
+// to the stream whose id it is called with. There is no fetch to stream a
+// Response from, so other arguments are rejected.
+static void StreamWasmModule(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  std::shared_ptr<WasmStreaming> streaming =
+      WasmStreaming::Unpack(iso, info.Data());
+  m_isolate* data = isolateData(iso);
+  auto it = data->wasmStreams.end();
+  if (info[0]->IsUint32()) {
+    it = data->wasmStreams.find(info[0].As<Uint32>()->Value());
+  }
+  if (it == data->wasmStreams.end()) {
+    streaming->Abort(Exception::TypeError(String::NewFromUtf8Literal(
+        iso, "WebAssembly streaming of a Response is not supported")));
+    return;
+  }
+  m_wasmStream* stream = it->second;
+  data->wasmStreams.erase(it);
+  if (!stream->cache.empty()) {
+    stream->cacheAccepted = streaming->SetCompiledModuleBytes(
+        stream->cache.data(), stream->cache.size());
+  }
+  stream->streaming = streaming;
+}
+
+// initIsolate sets up the per isolate state of a new isolate.
+static void initIsolate(Isolate* iso,
+                        std::shared_ptr<ArrayBufferAllocator> allocator,
+                        bool snapshotContext) {
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+
+  iso->SetCaptureStackTraceForUncaughtExceptions(true);
+  // Before any context is created, for their WebAssembly objects to have
+  // compileStreaming.
+  iso->SetWasmStreamingCallback(StreamWasmModule);
+
+  // Create a Context for internal use
+  m_ctx* ctx = new m_ctx;
+  ctx->ptr.Reset(iso, Context::New(iso));
+  ctx->iso = iso;
+  ctx->ref = 0;
+
+  m_isolate* data = new m_isolate;
+  data->ctx = ctx;
+  data->sessionLocker = nullptr;
+  data->sessionDepth = 0;
+  data->allocator = allocator;
+  data->snapshotContext = snapshotContext;
+  data->heapLimitReached = false;
+  data->gcEvents = nullptr;
+  data->wasmStreamSeq = 0;
+  m_value** cached = data->cachedValues;
+  cached[CACHED_VALUE_UNDEFINED] = tracked_value(ctx, Undefined(iso));
+  cached[CACHED_VALUE_NULL] = tracked_value(ctx, Null(iso));
+  cached[CACHED_VALUE_TRUE] = tracked_value(ctx, True(iso));
+  cached[CACHED_VALUE_FALSE] = tracked_value(ctx, False(iso));
+  for (int i = CACHED_SMALL_INT_MIN; i <= CACHED_SMALL_INT_MAX; i++) {
+    cached[CACHED_VALUE_SMALL_INT + i - CACHED_SMALL_INT_MIN] =
+        tracked_value(ctx, Integer::New(iso, i));
+  }
+  for (int i = 0; i < CACHED_VALUE_COUNT; i++) {
+    data->cachedValueTypes[i] = valueTypeOf(cached[i]->ptr.Get(iso));
+  }
+  iso->SetData(0, data);
+  iso->AddNearHeapLimitCallback(NearHeapLimit, iso);
+}
+
+// AtomicsWait records the wake handle of the Atomics.wait that the isolate is
+// blocked in, if any, for IsolateWakeAtomicsWait to stop it from another
+// thread.
+static void AtomicsWait(Isolate::AtomicsWaitEvent event,
+                        Local<SharedArrayBuffer> array_buffer,
+                        size_t offset_in_bytes,
+                        int64_t value,
+                        double timeout_in_ms,
+                        Isolate::AtomicsWaitWakeHandle* stop_handle,
+                        void* data) {
+  m_isolate* iso_data = static_cast<m_isolate*>(data);
+  std::lock_guard<std::mutex> lock(iso_data->atomicsWaitMutex);
+  iso_data->atomicsWait =
+      event == Isolate::AtomicsWaitEvent::kStartWait ? stop_handle : nullptr;
+}
+
+int IsolateWakeAtomicsWait(IsolatePtr iso) {
+  m_isolate* data = isolateData(iso);
+  std::lock_guard<std::mutex> lock(data->atomicsWaitMutex);
+  if (data->atomicsWait == nullptr) {
+    return 0;
+  }
+  data->atomicsWait->Wake();
+  data->atomicsWait = nullptr;
+  return 1;
+}
+
+IsolatePtr NewIsolate(IsolateOptions opts) {
+  std::shared_ptr<ArrayBufferAllocator> allocator =
+      std::make_shared<ArrayBufferAllocator>(
+          opts.pooledArrayBuffers,
+          opts.arrayBufferQuota ? opts.arrayBufferQuota : SIZE_MAX);
+  Isolate::CreateParams params;
+  params.array_buffer_allocator_shared = allocator;
+  ResourceConstraints& constraints = params.constraints;
+  if (opts.heapSizeMax) {
+    constraints.ConfigureDefaultsFromHeapSize(opts.heapSizeInitial,
+                                              opts.heapSizeMax);
+  }
+  if (opts.initialOldGenerationSize) {
+    constraints.set_initial_old_generation_size_in_bytes(
+        opts.initialOldGenerationSize);
+  }
+  if (opts.maxOldGenerationSize) {
+    constraints.set_max_old_generation_size_in_bytes(
+        opts.maxOldGenerationSize);
+  }
+  if (opts.initialYoungGenerationSize) {
+    constraints.set_initial_young_generation_size_in_bytes(
+        opts.initialYoungGenerationSize);
+  }
+  if (opts.maxYoungGenerationSize) {
+    constraints.set_max_young_generation_size_in_bytes(
+        opts.maxYoungGenerationSize);
+  }
+  if (opts.codeRangeSize) {
+    constraints.set_code_range_size_in_bytes(opts.codeRangeSize);
+  }
+  if (opts.snapshot != nullptr) {
+    params.snapshot_blob = opts.snapshot;
+    params.external_references = externalReferences();
+  }
+  Isolate* iso = Isolate::New(params);
+  // Before the isolate is used and V8 starts background threads for it.
+  std::shared_ptr<MetricsRecorder> metrics =
+      std::make_shared<MetricsRecorder>();
+  iso->SetMetricsRecorder(metrics);
+  if (perf_map != nullptr) {
+    // Along with the code that the isolate is set up with, and builtins.
+    iso->SetJitCodeEventHandler(kJitCodeEventEnumExisting, PerfMap::Handler);
+  }
+  iso->AddGCPrologueCallback(MetricsRecorder::Prologue, metrics.get());
+  iso->AddGCEpilogueCallback(MetricsRecorder::Epilogue, metrics.get());
+  initIsolate(iso, allocator, opts.snapshot != nullptr);
+  isolateData(iso)->metrics = metrics;
+  if (opts.shimStats) {
+    isolateData(iso)->shimStats.reset(new m_shimStats);
+  }
+  if (opts.callbackStats) {
+    isolateData(iso)->callbackStats.reset(
+        new std::unordered_map<int, CallbackStats>);
+  }
+  if (opts.stringCacheCapacity > 0) {
+    isolateData(iso)->stringCache.reset(new StringCache(
+        opts.stringCacheCapacity, opts.stringCacheMaxLength));
+  }
+  isolateData(iso)->lazyErrors = opts.lazyErrors;
+  isolateData(iso)->keepExceptions = opts.keepExceptions;
+  if (opts.uncaughtStackTraceFrames != 0 ||
+      opts.uncaughtStackTraceOptions != 0) {
+    // initIsolate captures them by V8's defaults.
+    LOCK_ISOLATE(iso);
+    iso->SetCaptureStackTraceForUncaughtExceptions(
+        opts.uncaughtStackTraceFrames >= 0,
+        opts.uncaughtStackTraceFrames > 0 ? opts.uncaughtStackTraceFrames : 10,
+        opts.uncaughtStackTraceOptions
+            ? static_cast<StackTrace::StackTraceOptions>(
+                  opts.uncaughtStackTraceOptions)
+            : StackTrace::kOverview);
+  }
+  if (opts.consoleCapacity > 0) {
+    ConsoleBuffer* console =
+        new ConsoleBuffer(iso, opts.consoleCapacity, opts.consoleLevel);
+    isolateData(iso)->console.reset(console);
+    debug::SetConsoleDelegate(iso, console);
+  }
+  if (opts.disallowAtomicsWait) {
+    iso->SetAllowAtomicsWait(false);
+  }
+  isolateData(iso)->stackSize = opts.stackSize;
+  iso->SetAtomicsWaitCallback(AtomicsWait, isolateData(iso));
+  if (opts.gcEventCapacity > 0) {
+    GCEventRing* ring = new GCEventRing(opts.gcEventCapacity);
+    isolateData(iso)->gcEvents = ring;
+    iso->AddGCPrologueCallback(GCEventRing::Prologue, ring);
+    iso->AddGCEpilogueCallback(GCEventRing::Epilogue, ring);
+  }
+  return iso;
+}
+
+ValuePtr* IsolateCachedValues(IsolatePtr iso) {
+  return isolateData(iso)->cachedValues;
+}
+
+uint64_t* IsolateCachedValueTypes(IsolatePtr iso) {
+  return isolateData(iso)->cachedValueTypes;
+}
+
+ShimStats IsolateShimStats(IsolatePtr iso) {
+  ShimStats rtn = {};
+  m_shimStats* stats = shimStats(iso);
+  if (stats == nullptr) {
+    return rtn;
+  }
+  Locker locker(iso);
+  rtn.enabled = 1;
+  rtn.lockWaitTotal = stats->lockWaitTotal;
+  rtn.lockWaitMax = stats->lockWaitMax;
+  rtn.valuesAllocated = stats->valuesAllocated;
+  rtn.valuesFreed = stats->valuesFreed;
+  for (uint64_t count : stats->calls) {
+    rtn.callsLength += count > 0;
+  }
+  if (rtn.callsLength == 0) {
+    return rtn;
+  }
+  rtn.calls = (ShimCallCount*)malloc(rtn.callsLength * sizeof(ShimCallCount));
+  std::lock_guard<std::mutex> lock(shim_sites_mutex);
+  int n = 0;
+  for (size_t i = 0; i < stats->calls.size(); i++) {
+    if (stats->calls[i] > 0) {
+      rtn.calls[n++] = {shim_sites[i], stats->calls[i]};
+    }
+  }
+  return rtn;
+}
+
+CallbackStats* IsolateCallbackStats(IsolatePtr iso, int ref, int* length) {
+  m_isolate* data = isolateData(iso);
+  if (data->callbackStats == nullptr) {
+    *length = -1;
+    return nullptr;
+  }
+  Locker locker(iso);
+  std::unordered_map<int, CallbackStats>& stats = *data->callbackStats;
+  *length = 0;
+  if (ref != 0) {
+    auto it = stats.find(ref);
+    if (it == stats.end()) {
+      return nullptr;
+    }
+    CallbackStats* rtn = (CallbackStats*)malloc(sizeof(CallbackStats));
+    *rtn = it->second;
+    *length = 1;
+    return rtn;
+  }
+  if (stats.empty()) {
+    return nullptr;
+  }
+  CallbackStats* rtn =
+      (CallbackStats*)malloc(stats.size() * sizeof(CallbackStats));
+  for (auto& it : stats) {
+    rtn[(*length)++] = it.second;
+  }
+  return rtn;
+}
+
+EngineMetrics IsolateMetrics(IsolatePtr iso) {
+  MetricsRecorder* metrics = isolateData(iso)->metrics.get();
+  if (metrics == nullptr) {
+    EngineMetrics rtn = {};
+    return rtn;
+  }
+  return metrics->Get();
+}
+
+int IsolateRunPendingTasks(IsolatePtr iso) {
+  ISOLATE_SCOPE(iso);
+  int ran = 0;
+  while (platform::PumpMessageLoop(default_platform.get(), iso)) {
+    ran = 1;
+  }
+  return ran;
+}
+
+int IsolateHeapLimitReached(IsolatePtr iso) {
+  return isolateData(iso)->heapLimitReached;
+}
+
+size_t IsolateDrainGCEvents(IsolatePtr iso,
+                            GCEvent* events,
+                            size_t n,
+                            uint64_t* dropped) {
+  GCEventRing* ring = isolateData(iso)->gcEvents;
+  if (ring == nullptr) {
+    *dropped = 0;
+    return 0;
+  }
+  return ring->Drain(events, n, dropped);
+}
+
+size_t IsolateArrayBufferMemory(IsolatePtr iso) {
+  return isolateData(iso)->allocator->Used();
+}
+
+// The session of an isolate belongs to the thread that holds its Locker, and
+// only that thread reads or writes sessionDepth: another thread blocks in the
+// Locker until the session ends, rather than nesting in it.
+void IsolateLock(IsolatePtr iso) {
+  m_isolate* data = isolateData(iso);
+  if (Locker::IsLocked(iso) && data->sessionDepth > 0) {
+    data->sessionDepth++;
+    return;
+  }
+  static const int shim_site = shimSite(__func__);
+  ShimLockTimer shim_lock_timer(iso);
+  Locker* locker = new Locker(iso);
+  shim_lock_timer.Locked(shim_site);
+  data->sessionLocker = locker;
+  data->sessionDepth = 1;
+  applyStackLimit(iso);
+  iso->Enter();
+}
+
+void IsolateUnlock(IsolatePtr iso) {
+  m_isolate* data = isolateData(iso);
+  if (!Locker::IsLocked(iso) || data->sessionDepth == 0 ||
+      --data->sessionDepth > 0) {
+    return;
+  }
+  iso->Exit();
+  delete data->sessionLocker;
+  data->sessionLocker = nullptr;
+}
+
+int IsolateLockedByThread(IsolatePtr iso) {
+  return Locker::IsLocked(iso);
+}
+
+void IsolateLowMemoryNotification(IsolatePtr iso) {
+  ISOLATE_SCOPE(iso);
+  iso->LowMemoryNotification();
+}
+
+void IsolateMemoryPressureNotification(IsolatePtr iso, int level) {
+  // Needs no lock; a critical level interrupts a running script to collect.
+  iso->MemoryPressureNotification(static_cast<MemoryPressureLevel>(level));
+}
+
+int IsolateIdleNotification(IsolatePtr iso, double idle_seconds) {
+  ISOLATE_SCOPE(iso);
+  double deadline =
+      default_platform->MonotonicallyIncreasingTime() + idle_seconds;
+  int done = iso->IdleNotificationDeadline(deadline);
+  if (idle_tasks) {
+    double left = deadline - default_platform->MonotonicallyIncreasingTime();
+    if (left > 0) {
+      platform::RunIdleTasks(default_platform.get(), iso, left);
+    }
+  }
+  return done;
+}
+
+int64_t IsolateAdjustExternalMemory(IsolatePtr iso, int64_t change) {
+  ISOLATE_SCOPE(iso);
+  return iso->AdjustAmountOfExternalAllocatedMemory(change);
+}
+
+void IsolatePerformMicrotaskCheckpoint(IsolatePtr iso) {
+  ISOLATE_SCOPE(iso)
+  iso->PerformMicrotaskCheckpoint();
+}
+
+// endIsolateSession ends the session of the isolate, however deeply it is
+// nested, if the calling thread holds it, ahead of its disposal.
+static void endIsolateSession(Isolate* iso) {
+  m_isolate* data = isolateData(iso);
+  if (data->sessionDepth > 0) {
+    data->sessionDepth = 1;
+    IsolateUnlock(iso);
+  }
+}
+
+// releaseIsolateData drops the contexts, handles and caches that the isolate
+// data holds, which disposing of the isolate, or creating a snapshot of it,
+// requires. Members of m_isolate that hold handles must be released here.
+// The isolate must be locked.
+static void releaseIsolateData(Isolate* iso, m_isolate* data) {
+  HandleScope handle_scope(iso);
+  freeDeadContexts(data);
+  data->inspector.reset();
+  debug::SetConsoleDelegate(iso, nullptr);
+  data->console.reset();
+  data->callbackWatches.clear();
+  data->weakObjects.clear();
+  data->lazyTemplates.clear();
+  data->shapes.clear();
+  data->textEncoder.Reset();
+  data->textDecoder.Reset();
+  data->performance.Reset();
+  data->performanceClocks.clear();
+  data->crypto.Reset();
+  data->stringCache.reset();
+  data->intlFormatters.reset();
+  data->intlFormatter.Reset();
+}
+
+void IsolateDispose(IsolatePtr iso) {
+  if (iso == nullptr) {
+    return;
+  }
+  m_isolate* data = isolateData(iso);
+  endIsolateSession(iso);
+  iso->RemoveNearHeapLimitCallback(NearHeapLimit, 0);
+  if (data->metrics != nullptr) {
+    iso->RemoveGCPrologueCallback(MetricsRecorder::Prologue,
+                                  data->metrics.get());
+    iso->RemoveGCEpilogueCallback(MetricsRecorder::Epilogue,
+                                  data->metrics.get());
+  }
+  ContextFree(data->ctx);
+  GCEventRing* gcEvents = data->gcEvents;
+  {
+    LOCK_ISOLATE(iso);
+    releaseIsolateData(iso, data);
+  }
+  delete data;
+
+  iso->Dispose();
+  // Disposing of the isolate may collect garbage once more.
+  delete gcEvents;
+}
+
+CacheStats IsolateStringCacheStats(IsolatePtr iso) {
+  LOCK_ISOLATE(iso);
+  StringCache* cache = isolateData(iso)->stringCache.get();
+  if (cache == nullptr) {
+    return CacheStats{};
+  }
+  return cache->Stats();
+}
+
+size_t IsolateDrainReleasedCallbacks(IsolatePtr iso, int* refs, size_t n) {
+  LOCK_ISOLATE(iso);
+  std::vector<int>& released = isolateData(iso)->releasedCallbacks;
+  n = std::min(n, released.size());
+  std::copy(released.end() - n, released.end(), refs);
+  released.resize(released.size() - n);
+  return n;
+}
+
+uint64_t IsolateArmWatchdog(IsolatePtr iso, int64_t timeout_ms) {
+  return Watchdog::Get()->Arm(iso, timeout_ms);
+}
+
+int IsolateDisarmWatchdog(IsolatePtr iso, uint64_t id) {
+  if (!Watchdog::Get()->Disarm(id)) {
+    return 0;
+  }
+  // The execution that the watchdog terminated has returned, the isolate can
+  // run JavaScript again.
+  iso->CancelTerminateExecution();
+  return 1;
+}
+
+uint64_t IsolateArmCPUBudget(IsolatePtr iso, int64_t limit_ns, int ref) {
+  return Watchdog::Get()->ArmBudget(iso, limit_ns, ref);
+}
+
+int IsolateDisarmCPUBudget(IsolatePtr iso, uint64_t id) {
+  if (!Watchdog::Get()->DisarmBudget(id)) {
+    return 0;
+  }
+  iso->CancelTerminateExecution();
+  return 1;
+}
+
+void IsolateTerminateExecution(IsolatePtr iso) {
+  iso->TerminateExecution();
+  // V8 wakes an Atomics.wait on being interrupted, which it is checked for
+  // when it starts as well; stopping it here does not depend on that.
+  IsolateWakeAtomicsWait(iso);
+}
+
+void IsolateCancelTerminateExecution(IsolatePtr iso) {
+  iso->CancelTerminateExecution();
+}
+
+int IsolateIsExecutionTerminating(IsolatePtr iso) {
+  return iso->IsExecutionTerminating();
+}
+
+IsolateHStatistics IsolationGetHeapStatistics(IsolatePtr iso) {
+  if (iso == nullptr) {
+    return IsolateHStatistics{0};
+  }
+  v8::HeapStatistics hs;
+  iso->GetHeapStatistics(&hs);
+
+  return IsolateHStatistics{hs.total_heap_size(),
+                            hs.total_heap_size_executable(),
+                            hs.total_physical_size(),
+                            hs.total_available_size(),
+                            hs.used_heap_size(),
+                            hs.heap_size_limit(),
+                            hs.malloced_memory(),
+                            hs.external_memory(),
+                            hs.peak_malloced_memory(),
+                            hs.number_of_native_contexts(),
+                            hs.number_of_detached_contexts()};
+}
+
+int IsolateNumberOfHeapSpaces(IsolatePtr iso) {
+  return iso->NumberOfHeapSpaces();
+}
+
+IsolateHSpaceStatistics IsolateGetHeapSpaceStatistics(IsolatePtr iso,
+                                                      int index) {
+  v8::HeapSpaceStatistics hss;
+  if (!iso->GetHeapSpaceStatistics(&hss, index)) {
+    return IsolateHSpaceStatistics{""};
+  }
+  return IsolateHSpaceStatistics{hss.space_name(), hss.space_size(),
+                                 hss.space_used_size(),
+                                 hss.space_available_size(),
+                                 hss.physical_space_size()};
+}
+
+IsolateHCodeStatistics IsolateGetHeapCodeStatistics(IsolatePtr iso) {
+  ISOLATE_SCOPE(iso);
+  v8::HeapCodeStatistics hcs;
+  iso->GetHeapCodeAndMetadataStatistics(&hcs);
+  return IsolateHCodeStatistics{hcs.code_and_metadata_size(),
+                                hcs.bytecode_and_metadata_size(),
+                                hcs.external_script_source_size()};
+}
+
+MemoryMeasurement IsolateMeasureMemory(IsolatePtr iso) {
+  ISOLATE_SCOPE(iso);
+  auto result = std::make_shared<MeasureMemoryResult::Result>();
+  iso->MeasureMemory(std::make_unique<MeasureMemoryResult>(result),
+                     MeasureMemoryExecution::kEager);
+  // The measurement is taken by the next full garbage collection and
+  // reported by a task of the platform, which the isolate does not run by
+  // itself; a few collections are forced in case one does not suffice.
+  for (int i = 0; !result->completed && i < 8; i++) {
+    iso->LowMemoryNotification();
+    while (!result->completed &&
+           platform::PumpMessageLoop(default_platform.get(), iso)) {
+    }
+  }
+  MemoryMeasurement rtn{nullptr, 0, 0, result->completed};
+  if (!result->completed) {
+    return rtn;
+  }
+  size_t n = result->contexts.size();
+  rtn.contexts = static_cast<ContextMemory*>(malloc(sizeof(ContextMemory) * n));
+  std::copy(result->contexts.begin(), result->contexts.end(), rtn.contexts);
+  rtn.count = n;
+  rtn.unattributed = result->unattributed;
+  return rtn;
+}
+
+// NewCachedData returns the code cache to consume in a compile, if any, which
+// is owned by the ScriptCompiler::Source it is given to.
+static ScriptCompiler::CachedData* NewCachedData(const CompileOptions& opts) {
+  if (!opts.cachedData.data) {
+    return nullptr;
+  }
+  // The bytes are borrowed, they may be Go memory or a mapping of a code
+  // cache file that is shared by every isolate.
+  return new ScriptCompiler::CachedData(
+      opts.cachedData.data, opts.cachedData.length,
+      ScriptCompiler::CachedData::BufferNotOwned);
+}
+
+// CachedDataResult hands a code cache created by V8 over to Go, which frees
+// it with ScriptCompilerCachedDataDelete. cached_data may be null when the
+// code could not be serialized.
+static ScriptCompilerCachedData* CachedDataResult(
+    ScriptCompiler::CachedData* cached_data) {
+  ScriptCompilerCachedData* cd = new ScriptCompilerCachedData{};
+  if (cached_data != nullptr) {
+    cd->ptr = cached_data;
+    cd->data = cached_data->data;
+    cd->length = cached_data->length;
+    cd->rejected = cached_data->rejected;
+  }
+  return cd;
+}
+
+RtnUnboundScript IsolateCompileUnboundScript(IsolatePtr iso,
+                                             StringArg source,
+                                             StringArg origin,
+                                             CompileOptions opts) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  TryCatch try_catch(iso);
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+  Context::Scope context_scope(local_ctx);
+
+  RtnUnboundScript rtn = {};
+
+  Local<String> src, ogn;
+  // Both strings are created up front, so that an external string is always
+  // handed over to V8, which then owns it.
+  MaybeLocal<String> maybe_src = NewString(iso, source);
+  MaybeLocal<String> maybe_ogn = NewString(iso, origin);
+  if (!maybe_src.ToLocal(&src) || !maybe_ogn.ToLocal(&ogn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  ScriptCompiler::CompileOptions option =
+      static_cast<ScriptCompiler::CompileOptions>(opts.compileOption);
+
+  ScriptCompiler::CachedData* cached_data = NewCachedData(opts);
+  ScriptCompiler::ConsumeCodeCacheTask* consume_task = nullptr;
+  if (opts.consumeTask != nullptr) {
+    consume_task = opts.consumeTask->task.release();
+    delete opts.consumeTask;
+  }
+
+  ScriptOrigin script_origin(ogn);
+
+  ScriptCompiler::Source script_source(src, script_origin, cached_data,
+                                       consume_task);
+
+  Local<UnboundScript> unbound_script;
+  if (!ScriptCompiler::CompileUnboundScript(iso, &script_source, option)
+           .ToLocal(&unbound_script)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  };
+
+  if (cached_data) {
+    rtn.cachedDataRejected = cached_data->rejected;
+  }
+
+  rtn.ptr = tracked_unbound_script(ctx, unbound_script);
+  return rtn;
+}
+
+/********** Exceptions & Errors **********/
+
+ValuePtr IsolateThrowException(IsolatePtr iso, ValuePtr value) {
+  ISOLATE_SCOPE(iso);
+  m_ctx* ctx = value->ctx;
+
+  Local<Value> throw_ret_val = iso->ThrowException(value->ptr.Get(iso));
+
+  return tracked_value(ctx, throw_ret_val);
+}
+
+/********** CpuProfiler **********/
+
+CPUProfiler* NewCPUProfiler(IsolatePtr iso_ptr) {
+  Isolate* iso = static_cast<Isolate*>(iso_ptr);
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+
+  CPUProfiler* c = new CPUProfiler;
+  c->iso = iso;
+  c->ptr = CpuProfiler::New(iso);
+  return c;
+}
+
+void CPUProfilerDispose(CPUProfiler* profiler) {
+  if (profiler->ptr == nullptr) {
+    return;
+  }
+  profiler->ptr->Dispose();
+
+  delete profiler;
+}
+
+void CPUProfilerSetSamplingInterval(CPUProfiler* profiler, int us) {
+  profiler->ptr->SetSamplingInterval(us);
+}
+
+void CPUProfilerSetUsePreciseSampling(CPUProfiler* profiler, int precise) {
+  profiler->ptr->SetUsePreciseSampling(precise);
+}
+
+void CPUProfilerStartProfiling(CPUProfiler* profiler, const char* title) {
+  if (profiler->iso == nullptr) {
+    return;
+  }
+
+  LOCK_ISOLATE(profiler->iso);
+  Isolate::Scope isolate_scope(profiler->iso);
+  HandleScope handle_scope(profiler->iso);
+
+  Local<String> title_str =
+      String::NewFromUtf8(profiler->iso, title, NewStringType::kNormal)
+          .ToLocalChecked();
+  profiler->ptr->StartProfiling(title_str);
+}
+
+void CPUProfilerStartProfilingWithOptions(CPUProfiler* profiler,
+                                          const char* title,
+                                          CPUProfilingOptions options) {
+  if (profiler->iso == nullptr) {
+    return;
+  }
+
+  LOCK_ISOLATE(profiler->iso);
+  Isolate::Scope isolate_scope(profiler->iso);
+  HandleScope handle_scope(profiler->iso);
+
+  Local<String> title_str =
+      String::NewFromUtf8(profiler->iso, title, NewStringType::kNormal)
+          .ToLocalChecked();
+  // V8 records samples up to max_samples, none for a limit of 0.
+  unsigned max_samples = 0;
+  if (options.recordSamples) {
+    max_samples = options.maxSamples ? options.maxSamples
+                                     : CpuProfilingOptions::kNoSampleLimit;
+  }
+  profiler->ptr->StartProfiling(
+      title_str,
+      CpuProfilingOptions(static_cast<CpuProfilingMode>(options.mode),
+                          max_samples, options.samplingIntervalUs));
+}
+
+CPUProfileNode* NewCPUProfileNode(const CpuProfileNode* ptr_) {
+  int count = ptr_->GetChildrenCount();
+  CPUProfileNode** children = new CPUProfileNode*[count];
+  for (int i = 0; i < count; ++i) {
+    children[i] = NewCPUProfileNode(ptr_->GetChild(i));
+  }
+
+  unsigned line_count = ptr_->GetHitLineCount();
+  CPUProfileLineTick* line_ticks = new CPUProfileLineTick[line_count];
+  if (line_count > 0) {
+    std::vector<CpuProfileNode::LineTick> ticks(line_count);
+    if (!ptr_->GetLineTicks(ticks.data(), line_count)) {
+      line_count = 0;
+    }
+    for (unsigned i = 0; i < line_count; i++) {
+      line_ticks[i] = CPUProfileLineTick{ticks[i].line, ticks[i].hit_count};
+    }
+  }
+
+  const std::vector<CpuProfileDeoptInfo>& deopts = ptr_->GetDeoptInfos();
+  CPUProfileDeoptInfo* deopt_infos = new CPUProfileDeoptInfo[deopts.size()];
+  for (size_t i = 0; i < deopts.size(); i++) {
+    deopt_infos[i] = CPUProfileDeoptInfo{deopts[i].deopt_reason, 0, 0};
+    if (!deopts[i].stack.empty()) {
+      deopt_infos[i].scriptId = deopts[i].stack[0].script_id;
+      deopt_infos[i].position = deopts[i].stack[0].position;
+    }
+  }
+
+  CPUProfileNode* root = new CPUProfileNode{
+      ptr_,
+      ptr_->GetNodeId(),
+      ptr_->GetScriptId(),
+      ptr_->GetScriptResourceNameStr(),
+      ptr_->GetFunctionNameStr(),
+      ptr_->GetLineNumber(),
+      ptr_->GetColumnNumber(),
+      ptr_->GetHitCount(),
+      ptr_->GetBailoutReason(),
+      ptr_->GetSourceType(),
+      static_cast<int>(line_count),
+      line_ticks,
+      static_cast<int>(deopts.size()),
+      deopt_infos,
+      count,
+      children,
+  };
+  return root;
+}
+
+CPUProfile* CPUProfilerStopProfiling(CPUProfiler* profiler, const char* title) {
+  if (profiler->iso == nullptr) {
+    return nullptr;
+  }
+
+  LOCK_ISOLATE(profiler->iso);
+  Isolate::Scope isolate_scope(profiler->iso);
+  HandleScope handle_scope(profiler->iso);
+
+  Local<String> title_str =
+      String::NewFromUtf8(profiler->iso, title, NewStringType::kNormal)
+          .ToLocalChecked();
+
+  CPUProfile* profile = new CPUProfile;
+  profile->ptr = profiler->ptr->StopProfiling(title_str);
+
+  Local<String> str = profile->ptr->GetTitle();
+  String::Utf8Value t(profiler->iso, str);
+  profile->title = CopyString(t);
+
+  // The node tree is built on demand, see CPUProfileGetTopDownRoot.
+  profile->root = nullptr;
+
+  profile->startTime = profile->ptr->GetStartTime();
+  profile->endTime = profile->ptr->GetEndTime();
+  profile->samplesCount = profile->ptr->GetSamplesCount();
+
+  return profile;
+}
+
+void CPUProfileNodeDelete(CPUProfileNode* node) {
+  for (int i = 0; i < node->childrenCount; ++i) {
+    CPUProfileNodeDelete(node->children[i]);
+  }
+
+  delete[] node->children;
+  delete[] node->lineTicks;
+  delete[] node->deoptInfos;
+  delete node;
+}
+
+CPUProfileNode* CPUProfileGetTopDownRoot(CPUProfile* profile) {
+  if (profile->root == nullptr) {
+    profile->root = NewCPUProfileNode(profile->ptr->GetTopDownRoot());
+  }
+  return profile->root;
+}
+
+void CPUProfileGetSamples(CPUProfile* profile,
+                          unsigned* node_ids,
+                          int64_t* timestamps) {
+  for (int i = 0; i < profile->samplesCount; i++) {
+    node_ids[i] = profile->ptr->GetSample(i)->GetNodeId();
+    timestamps[i] = profile->ptr->GetSampleTimestamp(i);
+  }
+}
+
+CPUProfileTable* CPUProfileGetTable(CPUProfile* profile) {
+  CPUProfileTableBuilder builder;
+  builder.Add(profile->ptr->GetTopDownRoot(), -1);
+  return builder.Build();
+}
+
+void CPUProfileTableFree(CPUProfileTable* table) {
+  free(table->nodes);
+  free(table->functions);
+  free(table->stringData);
+  free(table->stringOffsets);
+  delete table;
+}
+
+void CPUProfileDelete(CPUProfile* profile) {
+  if (profile->ptr == nullptr) {
+    return;
+  }
+  profile->ptr->Delete();
+  free((void*)profile->title);
+
+  if (profile->root != nullptr) {
+    CPUProfileNodeDelete(profile->root);
+  }
+
+  delete profile;
+}
+
+/********** HeapProfiler **********/
+
+void IsolateWriteHeapSnapshot(IsolatePtr iso, int ref) {
+  ISOLATE_SCOPE(iso);
+  const HeapSnapshot* snapshot = iso->GetHeapProfiler()->TakeHeapSnapshot();
+  GoOutputStream stream(ref);
+  snapshot->Serialize(&stream, HeapSnapshot::kJSON);
+  const_cast<HeapSnapshot*>(snapshot)->Delete();
+}
+
+int IsolateStartSamplingHeapProfiler(IsolatePtr iso,
+                                     uint64_t sample_interval,
+                                     int stack_depth) {
+  ISOLATE_SCOPE(iso);
+  return iso->GetHeapProfiler()->StartSamplingHeapProfiler(sample_interval,
+                                                           stack_depth);
+}
+
+void IsolateStopSamplingHeapProfiler(IsolatePtr iso) {
+  ISOLATE_SCOPE(iso);
+  iso->GetHeapProfiler()->StopSamplingHeapProfiler();
+}
+
+static AllocationProfileNode* NewAllocationProfileNode(
+    Isolate* iso,
+    AllocationProfile::Node* node) {
+  int count = node->children.size();
+  AllocationProfileNode** children = new AllocationProfileNode*[count];
+  for (int i = 0; i < count; ++i) {
+    children[i] = NewAllocationProfileNode(iso, node->children[i]);
+  }
+  size_t size = 0;
+  unsigned int objects = 0;
+  for (auto& allocation : node->allocations) {
+    size += allocation.size * allocation.count;
+    objects += allocation.count;
+  }
+  String::Utf8Value script_name(iso, node->script_name);
+  String::Utf8Value name(iso, node->name);
+  return new AllocationProfileNode{
+      CopyString(script_name),
+      CopyString(name),
+      node->line_number,
+      node->column_number,
+      size,
+      objects,
+      count,
+      children,
+  };
+}
+
+AllocationProfileNode* IsolateGetAllocationProfile(IsolatePtr iso) {
+  ISOLATE_SCOPE(iso);
+  std::unique_ptr<AllocationProfile> profile(
+      iso->GetHeapProfiler()->GetAllocationProfile());
+  if (profile == nullptr) {
+    return nullptr;
+  }
+  return NewAllocationProfileNode(iso, profile->GetRootNode());
+}
+
+void AllocationProfileNodeDelete(AllocationProfileNode* node) {
+  for (int i = 0; i < node->childrenCount; ++i) {
+    AllocationProfileNodeDelete(node->children[i]);
+  }
+  free((void*)node->scriptResourceName);
+  free((void*)node->functionName);
+  delete[] node->children;
+  delete node;
+}
+
+/********** Template **********/
+
+#define LOCAL_TEMPLATE(tmpl_ptr)     \
+  Isolate* iso = tmpl_ptr->iso;      \
+  LOCK_ISOLATE(iso);                 \
+  Isolate::Scope isolate_scope(iso); \
+  HandleScope handle_scope(iso);     \
+  Local<Template> tmpl = tmpl_ptr->ptr.Get(iso);
+
+void TemplateFreeWrapper(TemplatePtr tmpl) {
+  tmpl->ptr.Empty();  // Just does `val_ = 0;` without calling V8::DisposeGlobal
+  delete tmpl;
+}
+
+void TemplatesFree(IsolatePtr iso, TemplatePtr* tmpls, int n) {
+  LOCK_ISOLATE(iso);
+  for (int i = 0; i < n; i++) {
+    tmpls[i]->ptr.Reset();
+    delete tmpls[i];
+  }
+}
+
+void TemplateSetValue(TemplatePtr ptr,
+                      const char* name,
+                      ValuePtr val,
+                      int attributes) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<String> prop_name =
+      String::NewFromUtf8(iso, name, NewStringType::kNormal).ToLocalChecked();
+  tmpl->Set(prop_name, val->ptr.Get(iso), (PropertyAttribute)attributes);
+}
+
+int TemplateSetAnyValue(TemplatePtr ptr,
+                        ValuePtr key,
+                        ValuePtr val,
+                        int attributes) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<Value> local_key = key->ptr.Get(iso);
+  if (!local_key->IsName()) {
+    return false;
+  }
+  tmpl->Set(local_key.As<Name>(), val->ptr.Get(iso), (PropertyAttribute)attributes);
+  return true;
+}
+
+void TemplateSetTemplate(TemplatePtr ptr,
+                         const char* name,
+                         TemplatePtr obj,
+                         int attributes) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<String> prop_name =
+      String::NewFromUtf8(iso, name, NewStringType::kNormal).ToLocalChecked();
+  tmpl->Set(prop_name, obj->ptr.Get(iso), (PropertyAttribute)attributes);
+}
+
+int TemplateSetAnyTemplate(TemplatePtr ptr,
+                           ValuePtr key,
+                           TemplatePtr obj,
+                           int attributes) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<Value> local_key = key->ptr.Get(iso);
+  if (!local_key->IsName()) {
+    return false;
+  }
+  tmpl->Set(Local<Name>::Cast(local_key), obj->ptr.Get(iso), (PropertyAttribute)attributes);
+  return true;
+}
+
+// Instantiates the template of a lazy property in the current context, on the
+// first access of the property, after which V8 replaces it with a data
+// property holding the instance.
+static void LazyTemplateGetter(Local<Name> property,
+                               const PropertyCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  m_isolate* data = isolateData(iso);
+  size_t idx = info.Data().As<Integer>()->Value();
+  if (idx >= data->lazyTemplates.size()) {
+    return;
+  }
+  Local<Context> local_ctx = iso->GetCurrentContext();
+  Local<Template> tmpl = data->lazyTemplates[idx].Get(iso);
+  Local<Object> instance;
+  if (tmpl->IsFunctionTemplate()) {
+    Local<Function> fn;
+    if (!tmpl.As<FunctionTemplate>()->GetFunction(local_ctx).ToLocal(&fn)) {
+      return;
+    }
+    instance = fn;
+  } else if (!tmpl.As<ObjectTemplate>()->NewInstance(local_ctx).ToLocal(
+                 &instance)) {
+    return;
+  }
+  info.GetReturnValue().Set(instance);
+}
+
+void TemplateSetLazyTemplate(TemplatePtr ptr,
+                             const char* name,
+                             TemplatePtr obj,
+                             int attributes) {
+  LOCAL_TEMPLATE(ptr);
+
+  m_isolate* data = isolateData(iso);
+  Local<Integer> idx = Integer::NewFromUnsigned(iso, data->lazyTemplates.size());
+  data->lazyTemplates.emplace_back(iso, obj->ptr.Get(iso));
+
+  Local<String> prop_name =
+      String::NewFromUtf8(iso, name, NewStringType::kInternalized)
+          .ToLocalChecked();
+  tmpl->SetLazyDataProperty(prop_name, LazyTemplateGetter, idx,
+                            (PropertyAttribute)attributes);
+}
+
+/********** ObjectTemplate **********/
+
+TemplatePtr NewObjectTemplate(IsolatePtr iso) {
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+
+  m_template* ot = new m_template;
+  ot->iso = iso;
+  ot->ptr.Reset(iso, ObjectTemplate::New(iso));
+  return ot;
+}
+
+RtnValue ObjectTemplateNewInstance(TemplatePtr ptr, ContextPtr ctx) {
+  LOCAL_TEMPLATE(ptr);
+  TryCatch try_catch(iso);
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+  Context::Scope context_scope(local_ctx);
+
+  RtnValue rtn = {};
+
+  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
+  Local<Object> obj;
+  if (!obj_tmpl->NewInstance(local_ctx).ToLocal(&obj)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  rtn.value = tracked_value(ctx, obj);
+  return rtn;
+}
+
+void ObjectTemplateSetInternalFieldCount(TemplatePtr ptr, int field_count) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
+  obj_tmpl->SetInternalFieldCount(field_count);
+}
+
+int ObjectTemplateInternalFieldCount(TemplatePtr ptr) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
+  return obj_tmpl->InternalFieldCount();
+}
+
+/********** FunctionTemplate **********/
+
+// This callback function can be called from any Context, which we only know
+// at runtime. We extract the m_ctx from the embedder data, and pass its ref to
+// Go so that the context registry can match the Context on the Go side.
+static inline m_ctx* callbackContext(Isolate* iso) {
+  Local<Context> local_ctx = iso->GetCurrentContext();
+  return static_cast<m_ctx*>(local_ctx->GetAlignedPointerFromEmbedderData(1));
+}
+
+static inline void setCallbackReturn(const FunctionCallbackInfo<Value>& info,
+                                     ValuePtr rtn,
+                                     ValuePtr err) {
+  Isolate* iso = info.GetIsolate();
+  if (err != nullptr) {
+    iso->ThrowException(err->ptr.Get(iso));
+  } else if (rtn != nullptr) {
+    info.GetReturnValue().Set(rtn->ptr.Get(iso));
+  } else {
+    info.GetReturnValue().SetUndefined();
+  }
+}
+
+// CallbackTimer times the phases of a call of the callback with ref into the
+// stats of the isolate, if it keeps them, see IsolateCallbackStats. The stats
+// of a callback are created by its first call, with the Locker held.
+class CallbackTimer {
+ public:
+  CallbackTimer(Isolate* iso, int ref) {
+    std::unordered_map<int, CallbackStats>* stats =
+        isolateData(iso)->callbackStats.get();
+    if (stats == nullptr) {
+      return;
+    }
+    auto it = stats->find(ref);
+    if (it == stats->end()) {
+      CallbackStats cs = {};
+      cs.ref = ref;
+      for (MetricHistogram& h : cs.phases) {
+        h.min = -1;
+      }
+      it = stats->emplace(ref, cs).first;
+    }
+    stats_ = &it->second;
+    last_ = std::chrono::steady_clock::now();
+  }
+
+  // Done records the end of phase, which started at the end of the last one.
+  void Done(CallbackPhase phase) {
+    if (stats_ == nullptr) {
+      return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    histogramAdd(stats_->phases[phase],
+                 std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_)
+                     .count());
+    last_ = now;
+  }
+
+ private:
+  CallbackStats* stats_ = nullptr;
+  std::chrono::steady_clock::time_point last_;
+};
+
+static void FunctionTemplateCallback(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  int callback_ref = info.Data().As<Integer>()->Value();
+  CallbackTimer timer(iso, callback_ref);
+
+  m_ctx* ctx = callbackContext(iso);
+
+  int args_count = info.Length();
+  ValuePtr thisAndArgs[args_count + 1];
+  thisAndArgs[0] = tracked_value(ctx, info.This());
+  ValuePtr* args = thisAndArgs + 1;
+  for (int i = 0; i < args_count; i++) {
+    args[i] = tracked_value(ctx, info[i]);
+  }
+  timer.Done(CALLBACK_PHASE_ARGS);
+
+  goFunctionCallback_return retval =
+      goFunctionCallback(ctx->ref, callback_ref, thisAndArgs, args_count);
+  timer.Done(CALLBACK_PHASE_GO);
+  setCallbackReturn(info, retval.r0, retval.r1);
+  timer.Done(CALLBACK_PHASE_RETURN);
+}
+
+struct m_callbackInfo {
+  m_ctx* ctx;
+  const FunctionCallbackInfo<Value>* info;
+};
+
+// ContinuationCallback calls the Go callback of a promise continuation, whose
+// ref is bound as the first argument, see promiseContinuation.
+static void ContinuationCallback(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  m_ctx* ctx = callbackContext(iso);
+
+  int callback_ref = info[0].As<Integer>()->Value();
+
+  int args_count = std::max(info.Length() - 1, 0);
+  ValuePtr thisAndArgs[args_count + 1];
+  thisAndArgs[0] = tracked_value(ctx, info.This());
+  ValuePtr* args = thisAndArgs + 1;
+  for (int i = 0; i < args_count; i++) {
+    args[i] = tracked_value(ctx, info[i + 1]);
+  }
+
+  goFunctionCallback_return retval =
+      goFunctionCallback(ctx->ref, callback_ref, thisAndArgs, args_count);
+  setCallbackReturn(info, retval.r0, retval.r1);
+}
+
+static void packCallbackArg(Isolate* iso, Local<Value> v, CallbackArg* arg) {
+  if (v->IsInt32()) {
+    arg->kind = CALLBACK_ARG_INT32;
+    arg->int32 = v.As<Int32>()->Value();
+    arg->number = arg->int32;
+  } else if (v->IsNumber()) {
+    arg->kind = CALLBACK_ARG_NUMBER;
+    arg->number = v.As<Number>()->Value();
+  } else if (v->IsBoolean()) {
+    arg->kind = CALLBACK_ARG_BOOLEAN;
+    arg->int32 = v->IsTrue();
+  } else if (v->IsUndefined()) {
+    arg->kind = CALLBACK_ARG_UNDEFINED;
+  } else if (v->IsNull()) {
+    arg->kind = CALLBACK_ARG_NULL;
+  } else if (v->IsString() &&
+             v.As<String>()->Length() <= CALLBACK_ARG_STRING_MAX) {
+    Local<String> str = v.As<String>();
+    int nchars = 0;
+    arg->length = str->WriteUtf8(
+        iso, arg->data, CALLBACK_ARG_STRING_MAX, &nchars,
+        String::NO_NULL_TERMINATION | String::REPLACE_INVALID_UTF8);
+    // Multi-byte characters may not all fit, in which case the argument is
+    // delivered as a value instead.
+    arg->kind = nchars == str->Length() ? CALLBACK_ARG_STRING
+                                        : CALLBACK_ARG_VALUE;
+  } else {
+    arg->kind = CALLBACK_ARG_VALUE;
+  }
+}
+
+// Unlike FunctionTemplateCallback, primitive arguments are passed to Go by
+// value and no values are created for the receiver or the arguments unless Go
+// asks for them with CallbackInfoThis or CallbackInfoArg.
+static void FunctionTemplatePackedCallback(
+    const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  int callback_ref = info.Data().As<Integer>()->Value();
+  CallbackTimer timer(iso, callback_ref);
+
+  m_ctx* ctx = callbackContext(iso);
+  m_callbackInfo cb_info = {ctx, &info};
+
+  int args_count = info.Length();
+  CallbackArg args[args_count > 0 ? args_count : 1];
+  for (int i = 0; i < args_count; i++) {
+    packCallbackArg(iso, info[i], &args[i]);
+  }
+  timer.Done(CALLBACK_PHASE_ARGS);
+
+  goPackedFunctionCallback_return retval = goPackedFunctionCallback(
+      ctx->ref, callback_ref, &cb_info, args, args_count);
+  timer.Done(CALLBACK_PHASE_GO);
+  setCallbackReturn(info, retval.r0, retval.r1);
+  timer.Done(CALLBACK_PHASE_RETURN);
+}
+
+ValuePtr CallbackInfoThis(CallbackInfoPtr ptr) {
+  LOCK_ISOLATE(ptr->ctx->iso);
+  return tracked_value(ptr->ctx, ptr->info->This());
+}
+
+ValuePtr CallbackInfoArg(CallbackInfoPtr ptr, int idx) {
+  LOCK_ISOLATE(ptr->ctx->iso);
+  return tracked_value(ptr->ctx, (*ptr->info)[idx]);
+}
+
+// Fast callbacks are called directly by optimized code, without a
+// FunctionCallbackInfo, handle scope or Locker, so they must not call back into
+// V8; they only pass their arguments on to the Go function registered for the
+// template's callback_ref, which is the function data, in the isolate the
+// calling code runs in.
+static inline double callFastFunction(FastApiCallbackOptions& options,
+                                      FastCallbackArgs* args) {
+  int callback_ref = Integer::Cast(&options.data)->Value();
+  return goFastFunctionCallback(Isolate::GetCurrent(), callback_ref, args);
+}
+
+static double FastCallbackFloat64(Local<Object> receiver,
+                                  double a,
+                                  FastApiCallbackOptions& options) {
+  FastCallbackArgs args = {};
+  args.number[0] = a;
+  return callFastFunction(options, &args);
+}
+
+static double FastCallbackFloat64Float64(Local<Object> receiver,
+                                         double a,
+                                         double b,
+                                         FastApiCallbackOptions& options) {
+  FastCallbackArgs args = {};
+  args.number[0] = a;
+  args.number[1] = b;
+  return callFastFunction(options, &args);
+}
+
+static int32_t FastCallbackInt32Int32(Local<Object> receiver,
+                                      int32_t a,
+                                      int32_t b,
+                                      FastApiCallbackOptions& options) {
+  FastCallbackArgs args = {};
+  args.int32[0] = a;
+  args.int32[1] = b;
+  return callFastFunction(options, &args);
+}
+
+static double FastCallbackInt32Float64(Local<Object> receiver,
+                                       int32_t a,
+                                       double b,
+                                       FastApiCallbackOptions& options) {
+  FastCallbackArgs args = {};
+  args.int32[0] = a;
+  args.number[0] = b;
+  return callFastFunction(options, &args);
+}
+
+static double FastCallbackFloat64Array(Local<Object> receiver,
+                                       const FastApiTypedArray<double>& a,
+                                       FastApiCallbackOptions& options) {
+  FastCallbackArgs args = {};
+  // Go needs the elements to be aligned; the slow callback copes with the
+  // rare typed array that is not.
+  if (!a.getStorageIfAligned(&args.float64s)) {
+    options.fallback = true;
+    return 0;
+  }
+  args.length = a.length();
+  return callFastFunction(options, &args);
+}
+
+static const CFunction* fastCallback(int signature) {
+  static const CFunction float64 = CFunction::Make(FastCallbackFloat64);
+  static const CFunction float64Float64 =
+      CFunction::Make(FastCallbackFloat64Float64);
+  static const CFunction int32Int32 = CFunction::Make(FastCallbackInt32Int32);
+  static const CFunction int32Float64 =
+      CFunction::Make(FastCallbackInt32Float64);
+  static const CFunction float64Array =
+      CFunction::Make(FastCallbackFloat64Array);
+
+  switch (signature) {
+    case FAST_CALLBACK_FLOAT64_FLOAT64:
+      return &float64;
+    case FAST_CALLBACK_FLOAT64_FLOAT64_FLOAT64:
+      return &float64Float64;
+    case FAST_CALLBACK_INT32_INT32_INT32:
+      return &int32Int32;
+    case FAST_CALLBACK_INT32_FLOAT64_FLOAT64:
+      return &int32Float64;
+    case FAST_CALLBACK_FLOAT64ARRAY_FLOAT64:
+      return &float64Array;
+  }
+  return nullptr;
+}
+
+static void CallbackTemplateCollected(
+    const WeakCallbackInfo<m_callbackWatch>& info) {
+  m_callbackWatch* watch = info.GetParameter();
+  watch->handle.Reset();
+  watch->data->releasedCallbacks.push_back(watch->ref);
+  if (watch->data->callbackStats != nullptr) {
+    watch->data->callbackStats->erase(watch->ref);
+  }
+  watch->data->callbackWatches.erase(watch->ref);
+}
+
+TemplatePtr NewFunctionTemplate(IsolatePtr iso,
+                                int callback_ref,
+                                FunctionTemplateOptions opts) {
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+
+  // (rogchap) We only need to store one value, callback_ref, into the
+  // C++ callback function data, but if we needed to store more items we could
+  // use an V8::Array; this would require the internal context from
+  // iso->GetData(0)
+  Local<Integer> cbData = Integer::New(iso, callback_ref);
+
+  FunctionCallback callback = opts.packedArgs ? FunctionTemplatePackedCallback
+                                              : FunctionTemplateCallback;
+
+  Local<Signature> signature;
+  if (opts.signature != nullptr) {
+    signature = Signature::New(
+        iso, opts.signature->ptr.Get(iso).As<FunctionTemplate>());
+  }
+
+  // Functions that throw when called as constructors have no prototype
+  // object allocated either.
+  Local<FunctionTemplate> tmpl = FunctionTemplate::New(
+      iso, callback, cbData, signature, opts.length,
+      opts.nonConstructor ? ConstructorBehavior::kThrow
+                          : ConstructorBehavior::kAllow,
+      opts.sideEffectFree ? SideEffectType::kHasNoSideEffect
+                          : SideEffectType::kHasSideEffect,
+      fastCallback(opts.fastSignature));
+  m_template* ot = new m_template;
+  ot->iso = iso;
+  ot->ptr.Reset(iso, tmpl);
+
+  m_isolate* data = isolateData(iso);
+  auto watch = std::unique_ptr<m_callbackWatch>(
+      new m_callbackWatch{data, callback_ref, Global<FunctionTemplate>()});
+  watch->handle.Reset(iso, tmpl);
+  watch->handle.SetWeak(watch.get(), CallbackTemplateCollected,
+                        WeakCallbackType::kParameter);
+  data->callbackWatches[callback_ref] = std::move(watch);
+  return ot;
+}
+
+// The prototype and instance templates are owned by the function template;
+// the wrappers returned here only hold handles on them.
+TemplatePtr FunctionTemplatePrototypeTemplate(TemplatePtr ptr) {
+  LOCAL_TEMPLATE(ptr);
+
+  m_template* ot = new m_template;
+  ot->iso = iso;
+  ot->ptr.Reset(iso, tmpl.As<FunctionTemplate>()->PrototypeTemplate());
+  return ot;
+}
+
+TemplatePtr FunctionTemplateInstanceTemplate(TemplatePtr ptr) {
+  LOCAL_TEMPLATE(ptr);
+
+  m_template* ot = new m_template;
+  ot->iso = iso;
+  ot->ptr.Reset(iso, tmpl.As<FunctionTemplate>()->InstanceTemplate());
+  return ot;
+}
+
+void FunctionTemplateInherit(TemplatePtr ptr, TemplatePtr parent) {
+  LOCAL_TEMPLATE(ptr);
+
+  tmpl.As<FunctionTemplate>()->Inherit(
+      parent->ptr.Get(iso).As<FunctionTemplate>());
+}
+
+void FunctionTemplateSetClassName(TemplatePtr ptr, const char* name) {
+  LOCAL_TEMPLATE(ptr);
+
+  tmpl.As<FunctionTemplate>()->SetClassName(
+      String::NewFromUtf8(iso, name, NewStringType::kInternalized)
+          .ToLocalChecked());
+}
+
+RtnValue FunctionTemplateGetFunction(TemplatePtr ptr, ContextPtr ctx) {
+  LOCAL_TEMPLATE(ptr);
+  TryCatch try_catch(iso);
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+  Context::Scope context_scope(local_ctx);
+
+  Local<FunctionTemplate> fn_tmpl = tmpl.As<FunctionTemplate>();
+  RtnValue rtn = {};
+  Local<Function> fn;
+  if (!fn_tmpl->GetFunction(local_ctx).ToLocal(&fn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  rtn.value = tracked_value(ctx, fn);
+  return rtn;
+}
+
+/********** Accessors and Interceptors **********/
+
+// propertyCallback calls the Go callback of an accessor or interceptor, whose
+// ref is the callback data, for the property named key or at index. It reports
+// whether Go handled the operation, in which case result holds the value it
+// returned, if any; exceptions are thrown here and count as handled.
+static bool propertyCallback(Isolate* iso,
+                             Local<Value> data,
+                             PropertyOp op,
+                             Local<Object> self,
+                             const char* key,
+                             int key_length,
+                             uint32_t index,
+                             Local<Value> value,
+                             Local<Value>* result) {
+  m_ctx* ctx = callbackContext(iso);
+  int callback_ref = data.As<Integer>()->Value();
+
+  ValuePtr this_ptr = tracked_value(ctx, self);
+  ValuePtr value_ptr = value.IsEmpty() ? nullptr : tracked_value(ctx, value);
+  goPropertyCallback_return retval =
+      goPropertyCallback(ctx->ref, callback_ref, op, this_ptr,
+                         const_cast<char*>(key), key_length, index, value_ptr);
+  if (retval.r1 != nullptr) {
+    iso->ThrowException(retval.r1->ptr.Get(iso));
+    return true;
+  }
+  if (retval.r0 != nullptr) {
+    *result = retval.r0->ptr.Get(iso);
+  }
+  return retval.r2;
+}
+
+static bool namedPropertyCallback(Isolate* iso,
+                                  Local<Value> data,
+                                  PropertyOp op,
+                                  Local<Object> self,
+                                  Local<Name> property,
+                                  Local<Value> value,
+                                  Local<Value>* result) {
+  String::Utf8Value key(iso, property);
+  return propertyCallback(iso, data, op, self, *key, key.length(), 0, value,
+                          result);
+}
+
+static void AccessorGetter(Local<Name> property,
+                           const PropertyCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (namedPropertyCallback(iso, info.Data(), PROPERTY_GET, info.This(),
+                            property, Local<Value>(), &result) &&
+      !result.IsEmpty()) {
+    info.GetReturnValue().Set(result);
+  }
+}
+
+static void AccessorSetter(Local<Name> property,
+                           Local<Value> value,
+                           const PropertyCallbackInfo<void>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  namedPropertyCallback(iso, info.Data(), PROPERTY_SET, info.This(), property,
+                        value, &result);
+}
+
+void ObjectTemplateSetAccessor(TemplatePtr ptr,
+                               const char* name,
+                               int callback_ref,
+                               int has_setter,
+                               int attributes,
+                               int kind) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
+  Local<String> prop_name =
+      String::NewFromUtf8(iso, name, NewStringType::kInternalized)
+          .ToLocalChecked();
+  Local<Integer> data = Integer::New(iso, callback_ref);
+  AccessorNameSetterCallback setter = has_setter ? AccessorSetter : nullptr;
+  PropertyAttribute attrs = (PropertyAttribute)attributes;
+
+  switch (kind) {
+    case ACCESSOR_PROPERTY:
+      obj_tmpl->SetAccessor(prop_name, AccessorGetter, setter, data, DEFAULT,
+                            attrs);
+      break;
+    case NATIVE_DATA_PROPERTY:
+      obj_tmpl->SetNativeDataProperty(prop_name, AccessorGetter, setter, data,
+                                      attrs);
+      break;
+    case LAZY_DATA_PROPERTY:
+      obj_tmpl->SetLazyDataProperty(prop_name, AccessorGetter, data, attrs);
+      break;
+  }
+}
+
+// Interceptors only handle an operation if Go says so: getters by returning
+// a value, setters and deleters by setting any return value.
+
+static void NamedPropertyGetter(Local<Name> property,
+                                const PropertyCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (namedPropertyCallback(iso, info.Data(), PROPERTY_GET, info.This(),
+                            property, Local<Value>(), &result) &&
+      !result.IsEmpty()) {
+    info.GetReturnValue().Set(result);
+  }
+}
+
+static void NamedPropertySetter(Local<Name> property,
+                                Local<Value> value,
+                                const PropertyCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (namedPropertyCallback(iso, info.Data(), PROPERTY_SET, info.This(),
+                            property, value, &result)) {
+    info.GetReturnValue().Set(value);
+  }
+}
+
+static void NamedPropertyDeleter(Local<Name> property,
+                                 const PropertyCallbackInfo<Boolean>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (namedPropertyCallback(iso, info.Data(), PROPERTY_DELETE, info.This(),
+                            property, Local<Value>(), &result)) {
+    info.GetReturnValue().Set(true);
+  }
+}
+
+static void IndexedPropertyGetter(uint32_t index,
+                                  const PropertyCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (propertyCallback(iso, info.Data(), PROPERTY_GET, info.This(), nullptr, 0,
+                       index, Local<Value>(), &result) &&
+      !result.IsEmpty()) {
+    info.GetReturnValue().Set(result);
+  }
+}
+
+static void IndexedPropertySetter(uint32_t index,
+                                  Local<Value> value,
+                                  const PropertyCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (propertyCallback(iso, info.Data(), PROPERTY_SET, info.This(), nullptr, 0,
+                       index, value, &result)) {
+    info.GetReturnValue().Set(value);
+  }
+}
+
+static void IndexedPropertyDeleter(uint32_t index,
+                                   const PropertyCallbackInfo<Boolean>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (propertyCallback(iso, info.Data(), PROPERTY_DELETE, info.This(), nullptr,
+                       0, index, Local<Value>(), &result)) {
+    info.GetReturnValue().Set(true);
+  }
+}
+
+// The enumerators of both kinds return the array of names or indexes that Go
+// made with ContextImport.
+static void PropertyEnumerator(const PropertyCallbackInfo<Array>& info) {
+  Isolate* iso = info.GetIsolate();
+  ISOLATE_SCOPE(iso);
+
+  Local<Value> result;
+  if (propertyCallback(iso, info.Data(), PROPERTY_ENUMERATE, info.This(),
+                       nullptr, 0, 0, Local<Value>(), &result) &&
+      !result.IsEmpty() && result->IsArray()) {
+    info.GetReturnValue().Set(result.As<Array>());
+  }
+}
+
+void ObjectTemplateSetHandler(TemplatePtr ptr,
+                              int callback_ref,
+                              int indexed,
+                              int ops) {
+  LOCAL_TEMPLATE(ptr);
+
+  Local<ObjectTemplate> obj_tmpl = tmpl.As<ObjectTemplate>();
+  Local<Integer> data = Integer::New(iso, callback_ref);
+  auto has = [ops](PropertyOp op) { return (ops & (1 << op)) != 0; };
+
+  if (indexed) {
+    obj_tmpl->SetHandler(IndexedPropertyHandlerConfiguration(
+        has(PROPERTY_GET) ? IndexedPropertyGetter : nullptr,
+        has(PROPERTY_SET) ? IndexedPropertySetter : nullptr, nullptr,
+        has(PROPERTY_DELETE) ? IndexedPropertyDeleter : nullptr,
+        has(PROPERTY_ENUMERATE) ? PropertyEnumerator : nullptr, data));
+    return;
+  }
+  // Symbols are left to the object's own properties, so that Go only ever
+  // sees string names.
+  obj_tmpl->SetHandler(NamedPropertyHandlerConfiguration(
+      has(PROPERTY_GET) ? NamedPropertyGetter : nullptr,
+      has(PROPERTY_SET) ? NamedPropertySetter : nullptr, nullptr,
+      has(PROPERTY_DELETE) ? NamedPropertyDeleter : nullptr,
+      has(PROPERTY_ENUMERATE) ? PropertyEnumerator : nullptr, data,
+      PropertyHandlerFlags::kOnlyInterceptStrings));
+}
+
+/********** Context **********/
+
+#define LOCAL_CONTEXT(ctx)                      \
+  Isolate* iso = ctx->iso;                      \
+  LOCK_ISOLATE(iso);                            \
+  Isolate::Scope isolate_scope(iso);            \
+  HandleScope handle_scope(iso);                \
+  TryCatch try_catch(iso);                      \
+  Local<Context> local_ctx = ctx->ptr.Get(iso); \
+  Context::Scope context_scope(local_ctx);      \
+  drainDeferredReleases(ctx);
+
+ContextPtr NewContext(IsolatePtr iso,
+                      TemplatePtr global_template_ptr,
+                      int ref,
+                      ContextOptions opts) {
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+
+  std::unique_ptr<MicrotaskQueue> microtasks;
+  if (opts.ownMicrotaskQueue) {
+    microtasks = MicrotaskQueue::New(iso, MicrotasksPolicy::kExplicit);
+  }
+  MaybeLocal<Value> global_object;
+  if (opts.globalObject != nullptr) {
+    global_object = opts.globalObject->ptr.Get(iso);
+  }
+
+  Local<Context> local_ctx;
+  if (global_template_ptr == nullptr && isolateData(iso)->snapshotContext) {
+    if (!Context::FromSnapshot(iso, opts.snapshotIndex,
+                               DeserializeInternalFieldsCallback(), nullptr,
+                               global_object, microtasks.get())
+             .ToLocal(&local_ctx)) {
+      return nullptr;
+    }
+  } else {
+    Local<ObjectTemplate> global_template;
+    if (global_template_ptr != nullptr) {
+      global_template =
+          global_template_ptr->ptr.Get(iso).As<ObjectTemplate>();
+    } else {
+      global_template = ObjectTemplate::New(iso);
+    }
+    local_ctx = Context::New(iso, nullptr, global_template, global_object,
+                             DeserializeInternalFieldsCallback(),
+                             microtasks.get());
+  }
+
+  // For function callbacks we need the m_ctx of the context, which we store as
+  // an aligned pointer so that callbacks find it without calling into Go. Its
+  // ref, a simple integer identifier, is used on the Go side to lookup the
+  // context in the context registry. We use slot 1 as slot 0 has special
+  // meaning for the Chrome debugger.
+
+  m_ctx* ctx = new m_ctx;
+  ctx->ptr.Reset(iso, local_ctx);
+  ctx->iso = iso;
+  ctx->ref = ref;
+  ctx->microtasks = std::move(microtasks);
+  local_ctx->SetAlignedPointerInEmbedderData(1, ctx);
+  if (ConsoleBuffer* console = isolateData(iso)->console.get()) {
+    ctx->console.reset(new ConsoleRing(console->Capacity()));
+  }
+
+  // Taken before any script runs, so that scripts can neither reach the
+  // dispatcher through a replaced bind nor call it with refs of their own.
+  Context::Scope context_scope(local_ctx);
+  Local<Function> dispatch =
+      Function::New(local_ctx, ContinuationCallback, Local<Value>(), 1,
+                    ConstructorBehavior::kThrow)
+          .ToLocalChecked();
+  Local<Value> bind =
+      dispatch->Get(local_ctx, String::NewFromUtf8Literal(iso, "bind"))
+          .ToLocalChecked();
+  ctx->continuationDispatch.Reset(iso, dispatch);
+  ctx->continuationBind.Reset(iso, bind.As<Function>());
+  return ctx;
+}
+
+// ContextDetachGlobal detaches the global proxy from the context, so that it
+// can be given to NewContext to become the global proxy of a new context.
+ValuePtr ContextDetachGlobal(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  ValuePtr global = tracked_value(ctx, local_ctx->Global());
+  local_ctx->DetachGlobal();
+  return global;
+}
+
+// detachContext releases everything of ctx but the handles of its values,
+// which are freed along with their slab when ctx is deleted.
+static void detachContext(m_ctx* ctx) {
+  if (ctx->inspected) {
+    Isolate* iso = ctx->iso;
+    LOCK_ISOLATE(iso);
+    HandleScope handle_scope(iso);
+    isolateData(iso)->inspector->ContextDestroyed(ctx);
+  }
+  ctx->ptr.Reset();
+  if (m_shimStats* stats = shimStats(ctx->iso)) {
+    stats->valuesFreed += ctx->vals.Live();
+  }
+  // The values still queued are freed with the slab.
+  m_deferredRelease* node = ctx->deferredReleases.exchange(nullptr);
+  while (node != nullptr) {
+    m_deferredRelease* next = node->next;
+    delete node;
+    node = next;
+  }
+
+  for (auto& bound : ctx->boundScripts) {
+    std::vector<m_ctx*>& in = bound.first->boundIn;
+    in.erase(std::remove(in.begin(), in.end(), ctx), in.end());
+  }
+  ctx->boundScripts.clear();
+
+  // Value handles reset themselves when their slab is destroyed, unbound
+  // script handles have non-copyable traits and need an explicit reset.
+  for (uint32_t i = 0; i < ctx->unboundScripts.Size(); i++) {
+    ctx->unboundScripts.At(i)->ptr.Reset();
+  }
+
+  if (ctx->microtasks != nullptr) {
+    // The queue unlinks itself from the isolate.
+    LOCK_ISOLATE(ctx->iso);
+    ctx->microtasks.reset();
+  }
+}
+
+void ContextFree(ContextPtr ctx) {
+  if (ctx == nullptr) {
+    return;
+  }
+  detachContext(ctx);
+  delete ctx;
+}
+
+// ContextFreeDeferred closes ctx like ContextFree, but leaves the handles of
+// its values, which take the most time to free, to IsolateReclaimContexts.
+void ContextFreeDeferred(ContextPtr ctx) {
+  if (ctx == nullptr) {
+    return;
+  }
+  Isolate* iso = ctx->iso;
+  LOCK_ISOLATE(iso);
+  detachContext(ctx);
+  m_isolate* data = isolateData(iso);
+  data->deadContexts.push_back(ctx);
+  data->deadValues += ctx->vals.Capacity();
+}
+
+size_t IsolateReclaimContexts(IsolatePtr iso, size_t budget) {
+  LOCK_ISOLATE(iso);
+  m_isolate* data = isolateData(iso);
+  if (budget == 0) {
+    freeDeadContexts(data);
+    return 0;
+  }
+  size_t freed = 0;
+  while (!data->deadContexts.empty() && freed < budget) {
+    m_ctx* ctx = data->deadContexts.front();
+    uint32_t n = ctx->vals.Shrink(std::min<size_t>(budget - freed, UINT32_MAX));
+    freed += n;
+    data->deadValues -= n;
+    if (ctx->vals.Capacity() == 0) {
+      data->deadContexts.pop_front();
+      delete ctx;
+      // Each context counts as a value, as one without values has a cost too.
+      freed++;
+    }
+  }
+  return data->deadValues;
+}
+
+size_t IsolateDeadValues(IsolatePtr iso) {
+  return isolateData(iso)->deadValues;
+}
+
+size_t ContextDrainConsole(ContextPtr ctx,
+                           ConsoleRecord* records,
+                           size_t n,
+                           char* buf,
+                           size_t buf_len,
+                           uint64_t* dropped) {
+  if (ctx->console == nullptr) {
+    *dropped = 0;
+    return 0;
+  }
+  return ctx->console->Drain(records, n, buf, buf_len, dropped);
+}
+
+static double monotonicMillis() {
+  return default_platform->MonotonicallyIncreasingTime() * 1000;
+}
+
+static void performContextCheckpoint(m_ctx* ctx) {
+  if (ctx->microtasks == nullptr) {
+    ctx->iso->PerformMicrotaskCheckpoint();
+  } else {
+    ctx->microtasks->PerformCheckpoint(ctx->iso);
+  }
+}
+
+// The largest delay of a timer, as in browsers; longer delays mean 1ms.
+static const double kMaxTimerDelay = 2147483647;
+
+static void setTimer(const FunctionCallbackInfo<Value>& info, bool repeat) {
+  Isolate* iso = info.GetIsolate();
+  m_ctx* ctx = callbackContext(iso);
+  if (info.Length() < 1 || !info[0]->IsFunction()) {
+    iso->ThrowException(Exception::TypeError(
+        String::NewFromUtf8Literal(iso, "callback must be a function")));
+    return;
+  }
+  double delay = 0;
+  if (info.Length() > 1 &&
+      !info[1]->NumberValue(iso->GetCurrentContext()).To(&delay)) {
+    return;
+  }
+  // Like in browsers, timers wait at least 1ms, which also keeps a timer that
+  // is set by a timer callback from running in the same ContextRunTimers.
+  if (!(delay >= 1 && delay <= kMaxTimerDelay)) {
+    delay = 1;
+  }
+
+  uint32_t id = ++ctx->timerSeq;
+  m_timer& timer = ctx->timers[id];
+  timer.fn.Reset(iso, info[0].As<Function>());
+  for (int i = 2; i < info.Length(); i++) {
+    timer.args.emplace_back(iso, info[i]);
+  }
+  timer.interval = repeat ? delay : -1;
+  ctx->timerHeap.push({monotonicMillis() + delay, id});
+  info.GetReturnValue().Set(id);
+}
+
+static void SetTimeoutCallback(const FunctionCallbackInfo<Value>& info) {
+  setTimer(info, false);
+}
+
+static void SetIntervalCallback(const FunctionCallbackInfo<Value>& info) {
+  setTimer(info, true);
+}
+
+static void ClearTimerCallback(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  m_ctx* ctx = callbackContext(iso);
+  if (info.Length() < 1 || !info[0]->IsNumber()) {
+    return;
+  }
+  uint32_t id = info[0]->Uint32Value(iso->GetCurrentContext()).FromMaybe(0);
+  ctx->timers.erase(id);
+}
+
+void ContextInstallTimers(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  Local<Object> global = local_ctx->Global();
+  struct {
+    const char* name;
+    FunctionCallback callback;
+  } functions[] = {
+      {"setTimeout", SetTimeoutCallback},
+      {"setInterval", SetIntervalCallback},
+      {"clearTimeout", ClearTimerCallback},
+      {"clearInterval", ClearTimerCallback},
+  };
+  for (auto& f : functions) {
+    Local<Function> fn =
+        Function::New(local_ctx, f.callback).ToLocalChecked();
+    Local<String> name =
+        String::NewFromUtf8(iso, f.name, NewStringType::kInternalized)
+            .ToLocalChecked();
+    fn->SetName(name);
+    global->Set(local_ctx, name, fn).Check();
+  }
+}
+
+RtnTimers ContextRunTimers(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  RtnTimers rtn = {};
+  rtn.next = -1;
+
+  // Foreground tasks that V8 posted to the platform, such as those of
+  // FinalizationRegistry cleanups and wasm compilation.
+  while (platform::PumpMessageLoop(default_platform.get(), iso)) {
+  }
+
+  // Only the timers that are due by now run, timers set or rearmed by their
+  // callbacks are due later.
+  double now = monotonicMillis();
+  auto& heap = ctx->timerHeap;
+  while (!heap.empty() && heap.top().due <= now) {
+    uint32_t id = heap.top().id;
+    heap.pop();
+    auto it = ctx->timers.find(id);
+    if (it == ctx->timers.end()) {
+      continue;
+    }
+    m_timer& timer = it->second;
+    Local<Function> fn = timer.fn.Get(iso);
+    std::vector<Local<Value>> args;
+    args.reserve(timer.args.size());
+    for (auto& arg : timer.args) {
+      args.push_back(arg.Get(iso));
+    }
+    if (timer.interval < 0) {
+      ctx->timers.erase(it);
+    } else {
+      heap.push({now + timer.interval, id});
+    }
+
+    if (fn->Call(local_ctx, Undefined(iso), args.size(), args.data())
+            .IsEmpty()) {
+      rtn.error = ExceptionError(try_catch, iso, local_ctx);
+      break;
+    }
+    performContextCheckpoint(ctx);
+  }
+
+  while (!heap.empty() &&
+         ctx->timers.find(heap.top().id) == ctx->timers.end()) {
+    heap.pop();
+  }
+  if (!heap.empty()) {
+    rtn.next = std::max(heap.top().due - monotonicMillis(), 0.0);
+  }
+  rtn.asyncWaits = ctx->asyncWaits;
+  return rtn;
+}
+
+/********** Atomics **********/
+
+static void AtomicsWaitAsyncSettled(const FunctionCallbackInfo<Value>& info) {
+  callbackContext(info.GetIsolate())->asyncWaits--;
+}
+
+// AtomicsWaitAsyncCallback calls the original Atomics.waitAsync, which is its
+// data, and counts the promise that it returns until it settles.
+static void AtomicsWaitAsyncCallback(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  Local<Context> local_ctx = iso->GetCurrentContext();
+  std::vector<Local<Value>> args;
+  for (int i = 0; i < info.Length(); i++) {
+    args.push_back(info[i]);
+  }
+  Local<Value> result;
+  if (!info.Data()
+           .As<Function>()
+           ->Call(local_ctx, info.This(), args.size(), args.data())
+           .ToLocal(&result)) {
+    return;
+  }
+  info.GetReturnValue().Set(result);
+  Local<Object> obj = result.As<Object>();
+  Local<Value> async, promise;
+  if (!obj->Get(local_ctx, String::NewFromUtf8Literal(iso, "async"))
+           .ToLocal(&async) ||
+      !async->IsTrue() ||
+      !obj->Get(local_ctx, String::NewFromUtf8Literal(iso, "value"))
+           .ToLocal(&promise) ||
+      !promise->IsPromise()) {
+    return;
+  }
+  Local<Function> settled;
+  if (!Function::New(local_ctx, AtomicsWaitAsyncSettled).ToLocal(&settled) ||
+      promise.As<Promise>()->Then(local_ctx, settled, settled).IsEmpty()) {
+    return;
+  }
+  callbackContext(iso)->asyncWaits++;
+}
+
+void ContextTrackAtomicsWaitAsync(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  Local<Value> atomics, wait_async;
+  Local<String> name = String::NewFromUtf8Literal(iso, "waitAsync");
+  if (!local_ctx->Global()
+           ->Get(local_ctx, String::NewFromUtf8Literal(iso, "Atomics"))
+           .ToLocal(&atomics) ||
+      !atomics->IsObject() ||
+      !atomics.As<Object>()->Get(local_ctx, name).ToLocal(&wait_async) ||
+      !wait_async->IsFunction()) {
+    return;
+  }
+  Local<Function> fn =
+      Function::New(local_ctx, AtomicsWaitAsyncCallback, wait_async, 4)
+          .ToLocalChecked();
+  fn->SetName(name);
+  atomics.As<Object>()->Set(local_ctx, name, fn).Check();
+}
+
+/********** Performance **********/
+
+static void PerformanceCollected(const WeakCallbackInfo<m_performance>& info) {
+  m_performance* clock = info.GetParameter();
+  clock->handle.Reset();
+  isolateData(info.GetIsolate())->performanceClocks.erase(clock);
+}
+
+// coarsen rounds the time t in milliseconds down to a multiple of the
+// resolution of clock.
+static inline double coarsen(const m_performance* clock, double t) {
+  if (clock->resolution > 0) {
+    t = std::floor(t / clock->resolution) * clock->resolution;
+  }
+  return t;
+}
+
+// performanceNow reads the clock of the performance object receiver. It
+// neither allocates nor takes a handle, so that optimized code can call it
+// through the Fast API.
+static double performanceNow(Local<Object> receiver) {
+  const m_performance* clock = static_cast<const m_performance*>(
+      receiver->GetAlignedPointerFromInternalField(0));
+  return coarsen(clock, monotonicMillis() - clock->origin);
+}
+
+static void PerformanceNowCallback(const FunctionCallbackInfo<Value>& info) {
+  info.GetReturnValue().Set(performanceNow(info.This()));
+}
+
+static double PerformanceNowFastCallback(Local<Object> receiver) {
+  return performanceNow(receiver);
+}
+
+static const CFunction* performanceNowFunction() {
+  static const CFunction now = CFunction::Make(PerformanceNowFastCallback);
+  return &now;
+}
+
+void ContextInstallPerformance(ContextPtr ctx, double resolution) {
+  LOCAL_CONTEXT(ctx);
+  m_isolate* data = isolateData(iso);
+  if (data->performance.IsEmpty()) {
+    Local<FunctionTemplate> tmpl = FunctionTemplate::New(iso);
+    tmpl->SetClassName(String::NewFromUtf8Literal(iso, "Performance"));
+    tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+    Local<FunctionTemplate> now = FunctionTemplate::New(
+        iso, PerformanceNowCallback, Local<Value>(), Signature::New(iso, tmpl),
+        0, ConstructorBehavior::kThrow, SideEffectType::kHasNoSideEffect,
+        performanceNowFunction());
+    tmpl->PrototypeTemplate()->Set(iso, "now", now);
+    data->performance.Reset(iso, tmpl);
+  }
+
+  Local<Object> performance = data->performance.Get(iso)
+                                  ->InstanceTemplate()
+                                  ->NewInstance(local_ctx)
+                                  .ToLocalChecked();
+  auto clock = std::unique_ptr<m_performance>(new m_performance);
+  clock->origin = monotonicMillis();
+  clock->resolution = resolution;
+  clock->handle.Reset(iso, performance);
+  clock->handle.SetWeak(clock.get(), PerformanceCollected,
+                        WeakCallbackType::kParameter);
+  performance->SetAlignedPointerInInternalField(0, clock.get());
+  // The time origin is the wall-clock time of the monotonic origin, which is
+  // coarsened as well, so that the two cannot be combined into a finer clock.
+  double time_origin =
+      coarsen(clock.get(), default_platform->CurrentClockTimeMillis());
+  data->performanceClocks[clock.get()] = std::move(clock);
+
+  performance
+      ->DefineOwnProperty(local_ctx,
+                          String::NewFromUtf8Literal(iso, "timeOrigin"),
+                          Number::New(iso, time_origin),
+                          static_cast<PropertyAttribute>(ReadOnly | DontDelete))
+      .Check();
+  local_ctx->Global()
+      ->Set(local_ctx, String::NewFromUtf8Literal(iso, "performance"),
+            performance)
+      .Check();
+}
+
+int ContextPerformMicrotaskCheckpoint(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  performContextCheckpoint(ctx);
+  return try_catch.HasTerminated();
+}
+
+RtnValue RunScript(ContextPtr ctx, StringArg source, StringArg origin) {
+  LOCAL_CONTEXT(ctx);
+
+  RtnValue rtn = {};
+
+  Local<String> src, ogn;
+  // Both strings are created up front, so that an external string is always
+  // handed over to V8, which then owns it.
+  MaybeLocal<String> maybe_src = NewString(iso, source);
+  MaybeLocal<String> maybe_ogn = NewString(iso, origin);
+  if (!maybe_src.ToLocal(&src) || !maybe_ogn.ToLocal(&ogn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  ScriptOrigin script_origin(ogn);
+  Local<Script> script;
+  if (!Script::Compile(local_ctx, src, &script_origin).ToLocal(&script)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  Local<Value> result;
+  if (!script->Run(local_ctx).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
+}
+
+RtnFunction ContextCompileFunction(ContextPtr ctx,
+                                   StringArg source,
+                                   StringArg origin,
+                                   int argc,
+                                   const char* args[],
+                                   int extc,
+                                   ValuePtr exts[],
+                                   CompileOptions opts) {
+  LOCAL_CONTEXT(ctx);
+
+  RtnFunction rtn = {};
+
+  Local<String> src, ogn;
+  MaybeLocal<String> maybe_src = NewString(iso, source);
+  MaybeLocal<String> maybe_ogn = NewString(iso, origin);
+  if (!maybe_src.ToLocal(&src) || !maybe_ogn.ToLocal(&ogn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  Local<String> arguments[argc];
+  for (int i = 0; i < argc; i++) {
+    if (!String::NewFromUtf8(iso, args[i]).ToLocal(&arguments[i])) {
+      rtn.error = ExceptionError(try_catch, iso, local_ctx);
+      return rtn;
+    }
+  }
+  Local<Object> extensions[extc];
+  for (int i = 0; i < extc; i++) {
+    extensions[i] = exts[i]->ptr.Get(iso).As<Object>();
+  }
+
+  ScriptCompiler::CachedData* cached_data = NewCachedData(opts);
+  ScriptOrigin script_origin(ogn);
+  ScriptCompiler::Source script_source(src, script_origin, cached_data);
+
+  Local<Function> fn;
+  if (!ScriptCompiler::CompileFunction(
+           local_ctx, &script_source, argc, arguments, extc, extensions,
+           static_cast<ScriptCompiler::CompileOptions>(opts.compileOption))
+           .ToLocal(&fn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  if (cached_data) {
+    rtn.cachedDataRejected = cached_data->rejected;
+  }
+
+  rtn.value = tracked_value(ctx, fn);
+  return rtn;
+}
+
+/********** Crypto **********/
+
+// The random bytes of a thread, drawn from the operating system's CSPRNG in
+// bulk, so that the small requests of getRandomValues and randomUUID are
+// mostly copies. The bytes are wiped as they are handed out.
+struct RandomPool {
+  static const size_t kSize = 4096;
+  uint8_t bytes[kSize];
+  size_t pos = kSize;
+};
+
+static thread_local RandomPool random_pool;
+
+// systemRandom fills buf with n bytes of the operating system's CSPRNG.
+static bool systemRandom(uint8_t* buf, size_t n) {
+#if defined(__linux__)
+  while (n > 0) {
+    ssize_t got = getrandom(buf, n, 0);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buf += got;
+    n -= got;
+  }
+  return true;
+#elif defined(_WIN32)
+  for (size_t i = 0; i < n; i += sizeof(unsigned int)) {
+    unsigned int r;
+    if (rand_s(&r) != 0) {
+      return false;
+    }
+    memcpy(buf + i, &r, std::min(n - i, sizeof(r)));
+  }
+  return true;
+#else
+  // getentropy returns at most 256 bytes at a time.
+  for (size_t i = 0; i < n; i += 256) {
+    if (getentropy(buf + i, std::min<size_t>(n - i, 256)) != 0) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+// randomBytes fills buf with n random bytes, from the pool of the thread
+// unless they would take most of it.
+static bool randomBytes(uint8_t* buf, size_t n) {
+  RandomPool& pool = random_pool;
+  if (n > RandomPool::kSize / 2) {
+    return systemRandom(buf, n);
+  }
+  while (n > 0) {
+    if (pool.pos == RandomPool::kSize) {
+      if (!systemRandom(pool.bytes, RandomPool::kSize)) {
+        return false;
+      }
+      pool.pos = 0;
+    }
+    size_t k = std::min(n, RandomPool::kSize - pool.pos);
+    memcpy(buf, pool.bytes + pool.pos, k);
+    memset(pool.bytes + pool.pos, 0, k);
+    pool.pos += k;
+    buf += k;
+    n -= k;
+  }
+  return true;
+}
+
+static void throwRandomFailure(Isolate* iso) {
+  iso->ThrowException(Exception::Error(String::NewFromUtf8Literal(
+      iso, "The operating system failed to provide random bytes")));
+}
+
+// getRandomValues fills the integer typed array that it is given in place,
+// and returns it.
+static void CryptoGetRandomValuesCallback(
+    const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  Local<Value> array = info[0];
+  if (!array->IsTypedArray() || array->IsFloat32Array() ||
+      array->IsFloat64Array()) {
+    iso->ThrowException(Exception::TypeError(String::NewFromUtf8Literal(
+        iso, "The \"array\" argument must be an integer typed array")));
+    return;
+  }
+  Local<TypedArray> view = array.As<TypedArray>();
+  size_t length = view->ByteLength();
+  if (length > 65536) {
+    iso->ThrowException(Exception::RangeError(String::NewFromUtf8Literal(
+        iso,
+        "The byte length of the array exceeds the maximum of 65536 bytes")));
+    return;
+  }
+  // Buffer() moves the contents of small typed arrays off the JS heap.
+  std::shared_ptr<BackingStore> store = view->Buffer()->GetBackingStore();
+  uint8_t* data = static_cast<uint8_t*>(store->Data()) + view->ByteOffset();
+  if (!randomBytes(data, length)) {
+    throwRandomFailure(iso);
+    return;
+  }
+  info.GetReturnValue().Set(array);
+}
+
+// randomUUID returns a random version 4 UUID, see RFC 4122.
+static void CryptoRandomUUIDCallback(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  uint8_t b[16];
+  if (!randomBytes(b, sizeof(b))) {
+    throwRandomFailure(iso);
+    return;
+  }
+  b[6] = (b[6] & 0x0f) | 0x40;
+  b[8] = (b[8] & 0x3f) | 0x80;
+  static const char hex[] = "0123456789abcdef";
+  uint8_t uuid[36];
+  size_t o = 0;
+  for (int i = 0; i < 16; i++) {
+    if (i == 4 || i == 6 || i == 8 || i == 10) {
+      uuid[o++] = '-';
+    }
+    uuid[o++] = hex[b[i] >> 4];
+    uuid[o++] = hex[b[i] & 0xf];
+  }
+  info.GetReturnValue().Set(
+      String::NewFromOneByte(iso, uuid, NewStringType::kNormal, sizeof(uuid))
+          .ToLocalChecked());
+}
+
+void ContextInstallCrypto(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  m_isolate* data = isolateData(iso);
+  if (data->crypto.IsEmpty()) {
+    Local<ObjectTemplate> tmpl = ObjectTemplate::New(iso);
+    tmpl->Set(iso, "getRandomValues",
+              FunctionTemplate::New(iso, CryptoGetRandomValuesCallback,
+                                    Local<Value>(), Local<Signature>(), 1,
+                                    ConstructorBehavior::kThrow));
+    tmpl->Set(iso, "randomUUID",
+              FunctionTemplate::New(iso, CryptoRandomUUIDCallback,
+                                    Local<Value>(), Local<Signature>(), 0,
+                                    ConstructorBehavior::kThrow));
+    data->crypto.Reset(iso, tmpl);
+  }
+  Local<Object> crypto =
+      data->crypto.Get(iso)->NewInstance(local_ctx).ToLocalChecked();
+  local_ctx->Global()
+      ->Set(local_ctx, String::NewFromUtf8Literal(iso, "crypto"), crypto)
+      .Check();
+}
+
+/********** Intl **********/
+
+// The Intl constructors that IntlFormatterCallback makes formatters of, by
+// the index that is the data of its function.
+static const char* const kIntlFormatterKinds[] = {
+    "Collator",     "DateTimeFormat", "DisplayNames",       "ListFormat",
+    "NumberFormat", "PluralRules",    "RelativeTimeFormat",
+};
+
+// The methods of the wrappers of formatters, by the index that is the data of
+// IntlFormatterMethodCallback.
+static const char* const kIntlFormatterMethods[] = {
+    "compare",       "format", "formatRange",     "formatRangeToParts",
+    "formatToParts", "of",     "resolvedOptions", "select",
+};
+
+// The number of formatters that an isolate keeps.
+static const size_t kIntlFormatterCacheSize = 256;
+
+// intlError returns an error of the current context of the same type and
+// message as exception, an error of the internal context, so that no object
+// of the internal context reaches a script.
+static Local<Value> intlError(Isolate* iso,
+                              Local<Context> internal,
+                              Local<Value> exception) {
+  Local<String> message = String::Empty(iso);
+  Local<String> name = String::Empty(iso);
+  {
+    TryCatch try_catch(iso);
+    Context::Scope context_scope(internal);
+    Local<Value> v;
+    if (!exception->IsObject()) {
+      if (exception->ToString(internal).ToLocal(&v)) {
+        message = v.As<String>();
+      }
+    } else {
+      Local<Object> obj = exception.As<Object>();
+      if (obj->Get(internal, String::NewFromUtf8Literal(iso, "message"))
+              .ToLocal(&v) &&
+          v->IsString()) {
+        message = v.As<String>();
+      }
+      if (obj->Get(internal, String::NewFromUtf8Literal(iso, "name"))
+              .ToLocal(&v) &&
+          v->IsString()) {
+        name = v.As<String>();
+      }
+    }
+  }
+  if (name->StringEquals(String::NewFromUtf8Literal(iso, "RangeError"))) {
+    return Exception::RangeError(message);
+  }
+  if (name->StringEquals(String::NewFromUtf8Literal(iso, "TypeError"))) {
+    return Exception::TypeError(message);
+  }
+  return Exception::Error(message);
+}
+
+static Local<Value> intlTypeError(Isolate* iso, const std::string& msg) {
+  return Exception::TypeError(String::NewFromUtf8(iso, msg.data(),
+                                                  NewStringType::kNormal,
+                                                  msg.length())
+                                  .ToLocalChecked());
+}
+
+// intoContext returns value of the internal context as a value of ctx: a
+// primitive as is, and an object as a copy made through JSON, which the
+// resolved options and parts of formatters are fit for.
+static MaybeLocal<Value> intoContext(Isolate* iso,
+                                     Local<Context> internal,
+                                     Local<Context> ctx,
+                                     Local<Value> value) {
+  if (!value->IsObject()) {
+    return value;
+  }
+  Local<String> json;
+  {
+    Context::Scope context_scope(internal);
+    if (!JSON::Stringify(internal, value).ToLocal(&json)) {
+      return MaybeLocal<Value>();
+    }
+  }
+  return JSON::Parse(ctx, json);
+}
+
+// newIntlFormatter makes the formatter of key, see IntlFormatterCallback, in
+// the internal context. It sets error to the error to throw if it fails,
+// unless execution is terminating.
+static MaybeLocal<Object> newIntlFormatter(Isolate* iso,
+                                           Local<Context> internal,
+                                           const std::string& key,
+                                           Local<Value>* error) {
+  const char* kind = kIntlFormatterKinds[int(key[0])];
+  TryCatch try_catch(iso);
+  Context::Scope context_scope(internal);
+  // The locales and options are copied into the internal context through
+  // their JSON, so that the formatter is made of data alone.
+  Local<Value> args[2] = {Undefined(iso), Undefined(iso)};
+  size_t pos = 2;
+  for (Local<Value>& arg : args) {
+    size_t end = std::min(key.find('\0', pos), key.size());
+    Local<String> json;
+    if (end > pos &&
+        (!String::NewFromUtf8(iso, key.data() + pos, NewStringType::kNormal,
+                              end - pos)
+              .ToLocal(&json) ||
+         !JSON::Parse(internal, json).ToLocal(&arg))) {
+      break;
+    }
+    pos = end + 1;
+  }
+  Local<Value> intl;
+  Local<Value> ctor;
+  Local<Object> formatter;
+  if (!try_catch.HasCaught() &&
+      internal->Global()
+          ->Get(internal, String::NewFromUtf8Literal(iso, "Intl"))
+          .ToLocal(&intl) &&
+      intl->IsObject() &&
+      intl.As<Object>()
+          ->Get(internal, String::NewFromUtf8(iso, kind).ToLocalChecked())
+          .ToLocal(&ctor) &&
+      ctor->IsFunction() &&
+      ctor.As<Function>()
+          ->NewInstance(internal, 2, args)
+          .ToLocal(&formatter)) {
+    return formatter;
+  }
+  if (!try_catch.HasCaught()) {
+    *error = intlTypeError(iso, std::string("Intl.") + kind +
+                                    " is not supported");
+  } else if (!try_catch.HasTerminated()) {
+    *error = try_catch.Exception();
+  }
+  return MaybeLocal<Object>();
+}
+
+// intlFormatter returns the formatter of the internal context for key, see
+// IntlFormatterCallback, making it unless the isolate has it already. It
+// throws in the current context if the formatter cannot be made.
+static MaybeLocal<Object> intlFormatter(Isolate* iso, const std::string& key) {
+  m_isolate* data = isolateData(iso);
+  if (data->intlFormatters == nullptr) {
+    data->intlFormatters.reset(
+        new BytesLRU<Global<Object>>(kIntlFormatterCacheSize));
+  }
+  Global<Object>* cached = data->intlFormatters->Find(key.data(), key.size());
+  if (cached != nullptr) {
+    return cached->Get(iso);
+  }
+  Local<Context> internal = isolateInternalContext(iso)->ptr.Get(iso);
+  Local<Value> error;
+  Local<Object> formatter;
+  if (!newIntlFormatter(iso, internal, key, &error).ToLocal(&formatter)) {
+    if (!error.IsEmpty()) {
+      iso->ThrowException(intlError(iso, internal, error));
+    }
+    return MaybeLocal<Object>();
+  }
+  data->intlFormatters->Insert(key.data(), key.size()).Reset(iso, formatter);
+  return formatter;
+}
+
+// callIntlFormatter calls the method name of formatter in the internal
+// context, and sets error like newIntlFormatter if it fails.
+static MaybeLocal<Value> callIntlFormatter(
+    Isolate* iso,
+    Local<Context> internal,
+    Local<Object> formatter,
+    const char* name,
+    const FunctionCallbackInfo<Value>& info,
+    Local<Value>* error) {
+  std::vector<Local<Value>> args(info.Length());
+  for (int i = 0; i < info.Length(); i++) {
+    args[i] = info[i];
+  }
+  TryCatch try_catch(iso);
+  Context::Scope context_scope(internal);
+  Local<Value> method;
+  Local<Value> result;
+  if (formatter
+          ->Get(internal, String::NewFromUtf8(iso, name).ToLocalChecked())
+          .ToLocal(&method) &&
+      method->IsFunction() &&
+      method.As<Function>()
+          ->Call(internal, formatter, args.size(), args.data())
+          .ToLocal(&result)) {
+    return result;
+  }
+  if (!try_catch.HasCaught()) {
+    *error = intlTypeError(
+        iso, std::string(name) + " is not a method of the formatter");
+  } else if (!try_catch.HasTerminated()) {
+    *error = try_catch.Exception();
+  }
+  return MaybeLocal<Value>();
+}
+
+// IntlFormatterMethodCallback calls a method of the formatter of the wrapper
+// that it is called on in the internal context.
+static void IntlFormatterMethodCallback(
+    const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  Local<Context> ctx = iso->GetCurrentContext();
+  Local<Context> internal = isolateInternalContext(iso)->ptr.Get(iso);
+  const char* name = kIntlFormatterMethods[info.Data().As<Integer>()->Value()];
+  String::Utf8Value key(iso, info.Holder()->GetInternalField(0));
+  Local<Object> formatter;
+  if (!intlFormatter(iso, std::string(*key, key.length()))
+           .ToLocal(&formatter)) {
+    return;
+  }
+  Local<Value> error;
+  Local<Value> result;
+  if (!callIntlFormatter(iso, internal, formatter, name, info, &error)
+           .ToLocal(&result)) {
+    if (!error.IsEmpty()) {
+      iso->ThrowException(intlError(iso, internal, error));
+    }
+    return;
+  }
+  if (!intoContext(iso, internal, ctx, result).ToLocal(&result)) {
+    return;
+  }
+  info.GetReturnValue().Set(result);
+}
+
+// intlFormatterTemplate returns the template of the wrappers of formatters,
+// whose internal field holds the key of the formatter, so that the wrappers
+// of a startup snapshot make their formatter again.
+static Local<FunctionTemplate> intlFormatterTemplate(Isolate* iso) {
+  m_isolate* data = isolateData(iso);
+  if (!data->intlFormatter.IsEmpty()) {
+    return data->intlFormatter.Get(iso);
+  }
+  Local<FunctionTemplate> tmpl = FunctionTemplate::New(iso);
+  tmpl->SetClassName(String::NewFromUtf8Literal(iso, "IntlFormatter"));
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+  Local<Signature> signature = Signature::New(iso, tmpl);
+  Local<ObjectTemplate> proto = tmpl->PrototypeTemplate();
+  for (size_t i = 0;
+       i < sizeof(kIntlFormatterMethods) / sizeof(*kIntlFormatterMethods);
+       i++) {
+    proto->Set(iso, kIntlFormatterMethods[i],
+               FunctionTemplate::New(iso, IntlFormatterMethodCallback,
+                                     Integer::New(iso, i), signature, 0,
+                                     ConstructorBehavior::kThrow));
+  }
+  data->intlFormatter.Reset(iso, tmpl);
+  return tmpl;
+}
+
+// jsonKey appends a separator and the JSON of value to key, or just the
+// separator for undefined, and reports whether value could be stringified.
+static bool jsonKey(Isolate* iso,
+                    Local<Context> ctx,
+                    Local<Value> value,
+                    std::string& key) {
+  key.push_back('\0');
+  if (value->IsUndefined()) {
+    return true;
+  }
+  Local<String> json;
+  if (!JSON::Stringify(ctx, value).ToLocal(&json)) {
+    return false;
+  }
+  String::Utf8Value utf8(iso, json);
+  key.append(*utf8, utf8.length());
+  return true;
+}
+
+// IntlFormatterCallback returns a wrapper of the formatter of its kind for
+// its locales and options, which are keyed by the index of the kind and
+// their JSON.
+static void IntlFormatterCallback(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  Local<Context> ctx = iso->GetCurrentContext();
+  int kind = info.Data().As<Integer>()->Value();
+  std::string key(1, char(kind));
+  if (!jsonKey(iso, ctx, info[0], key) || !jsonKey(iso, ctx, info[1], key)) {
+    return;
+  }
+  // The formatter is made up front, so that bad locales and options throw
+  // here.
+  if (intlFormatter(iso, key).IsEmpty()) {
+    return;
+  }
+  Local<Object> wrapper;
+  if (!intlFormatterTemplate(iso)
+           ->InstanceTemplate()
+           ->NewInstance(ctx)
+           .ToLocal(&wrapper)) {
+    return;
+  }
+  wrapper->SetInternalField(
+      0, String::NewFromUtf8(iso, key.data(), NewStringType::kNormal,
+                             key.size())
+             .ToLocalChecked());
+  info.GetReturnValue().Set(wrapper);
+}
+
+TemplatePtr NewIntlFormattersTemplate(IsolatePtr iso) {
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+  Local<ObjectTemplate> tmpl = ObjectTemplate::New(iso);
+  for (size_t i = 0;
+       i < sizeof(kIntlFormatterKinds) / sizeof(*kIntlFormatterKinds); i++) {
+    tmpl->Set(iso, kIntlFormatterKinds[i],
+              FunctionTemplate::New(iso, IntlFormatterCallback,
+                                    Integer::New(iso, i), Local<Signature>(),
+                                    2, ConstructorBehavior::kThrow));
+  }
+  m_template* ot = new m_template;
+  ot->iso = iso;
+  ot->ptr.Reset(iso, tmpl);
+  return ot;
+}
+
+CacheStats IsolateIntlFormatterStats(IsolatePtr iso) {
+  LOCK_ISOLATE(iso);
+  m_isolate* data = isolateData(iso);
+  if (data->intlFormatters == nullptr) {
+    return CacheStats{};
+  }
+  return data->intlFormatters->Stats();
+}
+
+/********** Inspector **********/
+
+InspectorSessionPtr ContextNewInspectorSession(ContextPtr ctx, int ref) {
+  LOCAL_CONTEXT(ctx);
+  m_isolate* data = isolateData(iso);
+  if (data->inspector == nullptr) {
+    data->inspector.reset(new InspectorClient(iso));
+  }
+  if (!ctx->inspected) {
+    data->inspector->ContextCreated(ctx);
+    ctx->inspected = true;
+  }
+  return data->inspector->Connect(iso, ref);
+}
+
+void InspectorSessionDispatch(InspectorSessionPtr session,
+                              const char* message,
+                              int message_length) {
+  Isolate* iso = session->iso;
+  ISOLATE_SCOPE(iso);
+  session->session->dispatchProtocolMessage(v8_inspector::StringView(
+      reinterpret_cast<const uint8_t*>(message), message_length));
+  // Some commands, such as HeapProfiler.collectGarbage, respond from a task
+  // that they post to the platform.
+  while (platform::PumpMessageLoop(default_platform.get(), iso)) {
+  }
+}
+
+void InspectorSessionFree(InspectorSessionPtr session) {
+  Isolate* iso = session->iso;
+  ISOLATE_SCOPE(iso);
+  isolateData(iso)->inspector->Disconnect(session);
+}
+
+/********** Module **********/
+
+RtnModule ContextCompileModule(ContextPtr ctx,
+                               StringArg source,
+                               StringArg origin,
+                               CompileOptions opts) {
+  LOCAL_CONTEXT(ctx);
+
+  RtnModule rtn = {};
+
+  Local<String> src, ogn;
+  MaybeLocal<String> maybe_src = NewString(iso, source);
+  MaybeLocal<String> maybe_ogn = NewString(iso, origin);
+  if (!maybe_src.ToLocal(&src) || !maybe_ogn.ToLocal(&ogn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  ScriptCompiler::CachedData* cached_data = NewCachedData(opts);
+  ScriptOrigin script_origin(iso, ogn, 0, 0, false, -1, Local<Value>(), false,
+                             false, true);
+  ScriptCompiler::Source script_source(src, script_origin, cached_data);
+
+  Local<Module> module;
+  if (!ScriptCompiler::CompileModule(
+           iso, &script_source,
+           static_cast<ScriptCompiler::CompileOptions>(opts.compileOption))
+           .ToLocal(&module)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  if (cached_data) {
+    rtn.cachedDataRejected = cached_data->rejected;
+  }
+
+  uint32_t slot;
+  m_module* m = ctx->modules.Alloc(&slot);
+  m->ptr.Reset(iso, module);
+  m->ctx = ctx;
+  m->slot = slot;
+  ctx->moduleIndex.emplace(module->GetIdentityHash(), m);
+  rtn.ptr = m;
+  return rtn;
+}
+
+static m_module* findModule(m_ctx* ctx, Local<Module> module) {
+  auto range = ctx->moduleIndex.equal_range(module->GetIdentityHash());
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->ptr == module) {
+      return it->second;
+    }
+  }
+  return nullptr;
+}
+
+static MaybeLocal<Module> ResolveModuleCallback(
+    Local<Context> context,
+    Local<String> specifier,
+    Local<FixedArray> import_assertions,
+    Local<Module> referrer) {
+  Isolate* iso = context->GetIsolate();
+  m_ctx* ctx =
+      static_cast<m_ctx*>(context->GetAlignedPointerFromEmbedderData(1));
+
+  String::Utf8Value spec(iso, specifier);
+  goResolveModule_return ret =
+      goResolveModule(ctx->ref, ctx->moduleResolverRef, *spec, spec.length(),
+                      findModule(ctx, referrer));
+  if (ret.r1 != nullptr) {
+    iso->ThrowException(ret.r1->ptr.Get(iso));
+    return MaybeLocal<Module>();
+  }
+  return ret.r0->ptr.Get(iso);
+}
+
+RtnValue ModuleInstantiate(ModulePtr ptr, int resolver_ref) {
+  m_ctx* ctx = ptr->ctx;
+  LOCAL_CONTEXT(ctx);
+
+  RtnValue rtn = {};
+  Local<Module> module = ptr->ptr.Get(iso);
+
+  int outer_ref = ctx->moduleResolverRef;
+  ctx->moduleResolverRef = resolver_ref;
+  Maybe<bool> ok = module->InstantiateModule(local_ctx, ResolveModuleCallback);
+  ctx->moduleResolverRef = outer_ref;
+
+  if (ok.IsNothing()) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, Boolean::New(iso, ok.FromJust()));
+  return rtn;
+}
+
+RtnValue ModuleEvaluate(ModulePtr ptr) {
+  m_ctx* ctx = ptr->ctx;
+  LOCAL_CONTEXT(ctx);
+
+  RtnValue rtn = {};
+  Local<Module> module = ptr->ptr.Get(iso);
+  Local<Value> result;
+  if (!module->Evaluate(local_ctx).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
+}
+
+int ModuleGetStatus(ModulePtr ptr) {
+  Isolate* iso = ptr->ctx->iso;
+  ISOLATE_SCOPE(iso);
+  return ptr->ptr.Get(iso)->GetStatus();
+}
+
+ValuePtr ModuleGetNamespace(ModulePtr ptr) {
+  m_ctx* ctx = ptr->ctx;
+  LOCAL_CONTEXT(ctx);
+  return tracked_value(ctx, ptr->ptr.Get(iso)->GetModuleNamespace());
+}
+
+ValuePtr ModuleGetException(ModulePtr ptr) {
+  m_ctx* ctx = ptr->ctx;
+  LOCAL_CONTEXT(ctx);
+  return tracked_value(ctx, ptr->ptr.Get(iso)->GetException());
+}
+
+ScriptCompilerCachedData* ModuleCreateCodeCache(ModulePtr ptr) {
+  Isolate* iso = ptr->ctx->iso;
+  ISOLATE_SCOPE(iso);
+  Local<Module> module = ptr->ptr.Get(iso);
+  return CachedDataResult(
+      ScriptCompiler::CreateCodeCache(module->GetUnboundModuleScript()));
+}
+
+void ModuleRelease(ModulePtr ptr) {
+  m_ctx* ctx = ptr->ctx;
+  Isolate* iso = ctx->iso;
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+
+  auto range = ctx->moduleIndex.equal_range(
+      ptr->ptr.Get(iso)->GetIdentityHash());
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == ptr) {
+      ctx->moduleIndex.erase(it);
+      break;
+    }
+  }
+  ptr->ptr.Reset();
+  ctx->modules.Free(ptr->slot);
+}
+
+static MaybeLocal<Promise> DynamicImportCallback(
+    Local<Context> context,
+    Local<ScriptOrModule> referrer,
+    Local<String> specifier,
+    Local<FixedArray> import_assertions) {
+  Isolate* iso = context->GetIsolate();
+  m_ctx* ctx =
+      static_cast<m_ctx*>(context->GetAlignedPointerFromEmbedderData(1));
+
+  Local<Promise::Resolver> resolver;
+  if (!Promise::Resolver::New(context).ToLocal(&resolver)) {
+    return MaybeLocal<Promise>();
+  }
+  String::Utf8Value spec(iso, specifier);
+  String::Utf8Value origin(iso, referrer->GetResourceName());
+  if (!goDynamicImport(ctx->ref, *spec, spec.length(), *origin,
+                       origin.length(), tracked_value(ctx, resolver))) {
+    resolver
+        ->Reject(context, Exception::Error(String::NewFromUtf8Literal(
+                              iso, "dynamic import is not supported")))
+        .Check();
+  }
+  return resolver->GetPromise();
+}
+
+void IsolateSetDynamicImport(IsolatePtr iso, int enabled) {
+  ISOLATE_SCOPE(iso);
+  iso->SetHostImportModuleDynamicallyCallback(
+      enabled ? DynamicImportCallback : nullptr);
+}
+
+/********** ScriptStreamingTask **********/
+
+struct m_streamingTask {
+  ScriptCompiler::StreamedSource source;
+  std::unique_ptr<ScriptCompiler::ScriptStreamingTask> task;
+
+  explicit m_streamingTask(int ref)
+      : source(std::make_unique<GoSourceStream>(ref),
+               ScriptCompiler::StreamedSource::UTF8) {}
+};
+
+StreamingTaskPtr IsolateStartStreamingScript(IsolatePtr iso, int ref) {
+  ISOLATE_SCOPE(iso);
+  m_streamingTask* task = new m_streamingTask(ref);
+  task->task.reset(ScriptCompiler::StartStreaming(iso, &task->source));
+  return task;
+}
+
+void StreamingTaskRun(StreamingTaskPtr task) {
+  // Parsing and compiling happen here, without the isolate's Locker.
+  task->task->Run();
+}
+
+RtnUnboundScript StreamingTaskFinish(IsolatePtr iso,
+                                     StreamingTaskPtr task,
+                                     StringArg source,
+                                     StringArg origin) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  TryCatch try_catch(iso);
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+  Context::Scope context_scope(local_ctx);
+  std::unique_ptr<m_streamingTask> owned(task);
+
+  RtnUnboundScript rtn = {};
+
+  Local<String> src, ogn;
+  MaybeLocal<String> maybe_src = NewString(iso, source);
+  MaybeLocal<String> maybe_ogn = NewString(iso, origin);
+  if (!maybe_src.ToLocal(&src) || !maybe_ogn.ToLocal(&ogn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  ScriptOrigin script_origin(ogn);
+  Local<Script> script;
+  if (!ScriptCompiler::Compile(local_ctx, &task->source, src, script_origin)
+           .ToLocal(&script)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.ptr = tracked_unbound_script(ctx, script->GetUnboundScript());
+  return rtn;
+}
+
+/********** ConsumeCodeCacheTask **********/
+
+ConsumeTaskPtr IsolateStartConsumingCodeCache(IsolatePtr iso,
+                                              const uint8_t* data,
+                                              int length) {
+  ISOLATE_SCOPE(iso);
+  // The task keeps the bytes, which may be Go memory, until it is finished.
+  uint8_t* copy = new uint8_t[length];
+  memcpy(copy, data, length);
+  std::unique_ptr<ScriptCompiler::CachedData> cached_data(
+      new ScriptCompiler::CachedData(
+          copy, length, ScriptCompiler::CachedData::BufferOwned));
+  ScriptCompiler::ConsumeCodeCacheTask* task =
+      ScriptCompiler::StartConsumingCodeCache(iso, std::move(cached_data));
+  if (task == nullptr) {
+    return nullptr;
+  }
+  m_consumeTask* rtn = new m_consumeTask;
+  rtn->task.reset(task);
+  return rtn;
+}
+
+void ConsumeTaskRun(ConsumeTaskPtr task) {
+  // Deserializing happens here, without the isolate's Locker.
+  task->task->Run();
+}
+
+/********** SnapshotCreator **********/
+
+// The addresses of the native functions that templates and functions may
+// refer to, which are serialized as indexes into this list.
+static const intptr_t* externalReferences() {
+  static const std::vector<intptr_t> refs = [] {
+    std::vector<intptr_t> refs = {
+        reinterpret_cast<intptr_t>(FunctionTemplateCallback),
+        reinterpret_cast<intptr_t>(FunctionTemplatePackedCallback),
+        reinterpret_cast<intptr_t>(ContinuationCallback),
+        reinterpret_cast<intptr_t>(SetTimeoutCallback),
+        reinterpret_cast<intptr_t>(SetIntervalCallback),
+        reinterpret_cast<intptr_t>(ClearTimerCallback),
+        reinterpret_cast<intptr_t>(TextCodingCallback),
+        reinterpret_cast<intptr_t>(PerformanceNowCallback),
+        reinterpret_cast<intptr_t>(performanceNowFunction()->GetAddress()),
+        reinterpret_cast<intptr_t>(performanceNowFunction()->GetTypeInfo()),
+        reinterpret_cast<intptr_t>(CryptoGetRandomValuesCallback),
+        reinterpret_cast<intptr_t>(CryptoRandomUUIDCallback),
+        reinterpret_cast<intptr_t>(IntlFormatterCallback),
+        reinterpret_cast<intptr_t>(IntlFormatterMethodCallback),
+        reinterpret_cast<intptr_t>(AtomicsWaitAsyncCallback),
+        reinterpret_cast<intptr_t>(AtomicsWaitAsyncSettled),
+        reinterpret_cast<intptr_t>(LazyTemplateGetter),
+        reinterpret_cast<intptr_t>(AccessorGetter),
+        reinterpret_cast<intptr_t>(AccessorSetter),
+        reinterpret_cast<intptr_t>(NamedPropertyGetter),
+        reinterpret_cast<intptr_t>(NamedPropertySetter),
+        reinterpret_cast<intptr_t>(NamedPropertyDeleter),
+        reinterpret_cast<intptr_t>(IndexedPropertyGetter),
+        reinterpret_cast<intptr_t>(IndexedPropertySetter),
+        reinterpret_cast<intptr_t>(IndexedPropertyDeleter),
+        reinterpret_cast<intptr_t>(PropertyEnumerator),
+    };
+    for (int sig = FAST_CALLBACK_FLOAT64_FLOAT64;
+         sig <= FAST_CALLBACK_FLOAT64ARRAY_FLOAT64; sig++) {
+      const CFunction* fn = fastCallback(sig);
+      refs.push_back(reinterpret_cast<intptr_t>(fn->GetAddress()));
+      refs.push_back(reinterpret_cast<intptr_t>(fn->GetTypeInfo()));
+    }
+    refs.push_back(0);
+    return refs;
+  }();
+  return refs.data();
+}
+
+SnapshotCreatorPtr NewSnapshotCreator() {
+  Isolate* iso = Isolate::Allocate();
+  SnapshotCreator* creator = new SnapshotCreator(iso, externalReferences());
+  // The creator enters the isolate on this thread, while calls into the
+  // isolate may come from any thread; they enter it themselves instead.
+  iso->Exit();
+  initIsolate(iso, std::make_shared<ArrayBufferAllocator>(false, SIZE_MAX),
+              false);
+  return creator;
+}
+
+IsolatePtr SnapshotCreatorGetIsolate(SnapshotCreatorPtr creator) {
+  return creator->GetIsolate();
+}
+
+StartupDataPtr SnapshotCreatorCreateBlob(SnapshotCreatorPtr creator,
+                                         ContextPtr* ctxs,
+                                         int ctxs_count,
+                                         TemplatePtr* templates,
+                                         int templates_count,
+                                         int keep_function_code) {
+  Isolate* iso = creator->GetIsolate();
+  m_isolate* data = isolateData(iso);
+  endIsolateSession(iso);
+
+  StartupData blob = {};
+  {
+    LOCK_ISOLATE(iso);
+    Isolate::Scope isolate_scope(iso);
+    {
+      HandleScope handle_scope(iso);
+      // The default context is a plain one, which the internal contexts of
+      // isolates created from the snapshot are made from, and ctxs become the
+      // contexts that their NewContext starts from, by index.
+      creator->SetDefaultContext(Context::New(iso));
+      for (int i = 0; i < ctxs_count; i++) {
+        Local<Context> local_ctx = ctxs[i]->ptr.Get(iso);
+        local_ctx->SetAlignedPointerInEmbedderData(1, nullptr);
+        creator->AddContext(local_ctx);
+      }
+    }
+    // Every handle must have been released for the blob to be created; the
+    // wrappers of the templates are still freed by Go.
+    for (int i = 0; i < ctxs_count; i++) {
+      ContextFree(ctxs[i]);
+    }
+    ContextFree(data->ctx);
+    releaseIsolateData(iso, data);
+    for (int i = 0; i < templates_count; i++) {
+      templates[i]->ptr.Reset();
+    }
+    blob = creator->CreateBlob(
+        keep_function_code ? SnapshotCreator::FunctionCodeHandling::kKeep
+                           : SnapshotCreator::FunctionCodeHandling::kClear);
+  }
+  iso->SetData(0, nullptr);
+  delete data;
+  // The creator exits the isolate before disposing of it.
+  iso->Enter();
+  delete creator;
+
+  if (blob.data == nullptr) {
+    return nullptr;
+  }
+  return new StartupData(blob);
+}
+
+void SnapshotCreatorDispose(SnapshotCreatorPtr creator) {
+  Isolate* iso = creator->GetIsolate();
+  m_isolate* data = isolateData(iso);
+  endIsolateSession(iso);
+  ContextFree(data->ctx);
+  {
+    LOCK_ISOLATE(iso);
+    releaseIsolateData(iso, data);
+  }
+  iso->SetData(0, nullptr);
+  delete data;
+  // The creator exits the isolate before disposing of it.
+  iso->Enter();
+  delete creator;
+}
+
+int StartupDataSize(StartupDataPtr blob) {
+  return blob->raw_size;
+}
+
+void StartupDataFree(StartupDataPtr blob) {
+  delete[] blob->data;
+  delete blob;
+}
+
+/********** SharedSource **********/
+
+SourcePtr NewSharedSource(const char* data, int length) {
+  m_source* src = new m_source;
+  bool ascii = true;
+  for (int i = 0; i < length && ascii; i++) {
+    ascii = static_cast<unsigned char>(data[i]) < 0x80;
+  }
+  if (ascii || length == 0) {
+    src->oneByte.assign(data, length);
+  } else {
+    decodeUtf8(data, length, &src->twoByte);
+  }
+  return src;
+}
+
+void SharedSourceRelease(SourcePtr src) {
+  releaseSource(src);
+}
+
+int SharedSourceCodeCacheSize(SourcePtr src) {
+  std::lock_guard<std::mutex> lock(src->mu);
+  return src->cache ? src->cache->length : 0;
+}
+
+RtnUnboundScript IsolateCompileSharedSource(IsolatePtr iso,
+                                            SourcePtr source,
+                                            StringArg origin,
+                                            int compile_option) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  TryCatch try_catch(iso);
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+  Context::Scope context_scope(local_ctx);
+
+  RtnUnboundScript rtn = {};
+
+  Local<String> src, ogn;
+  MaybeLocal<String> maybe_src = NewSharedString(iso, source);
+  MaybeLocal<String> maybe_ogn = NewString(iso, origin);
+  if (!maybe_src.ToLocal(&src) || !maybe_ogn.ToLocal(&ogn)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+
+  // The code cache is set once and never changes after, so it can be read
+  // without the lock for as long as the source lives.
+  ScriptCompiler::CachedData* cache;
+  {
+    std::lock_guard<std::mutex> lock(source->mu);
+    cache = source->cache.get();
+  }
+  ScriptCompiler::CachedData* cached_data = nullptr;
+  ScriptCompiler::CompileOptions option =
+      static_cast<ScriptCompiler::CompileOptions>(compile_option);
+  if (cache != nullptr) {
+    cached_data = new ScriptCompiler::CachedData(
+        cache->data, cache->length,
+        ScriptCompiler::CachedData::BufferNotOwned);
+    option = ScriptCompiler::kConsumeCodeCache;
+  }
+
+  ScriptOrigin script_origin(ogn);
+  ScriptCompiler::Source script_source(src, script_origin, cached_data);
+
+  Local<UnboundScript> unbound_script;
+  if (!ScriptCompiler::CompileUnboundScript(iso, &script_source, option)
+           .ToLocal(&unbound_script)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  };
+
+  if (cached_data) {
+    rtn.cachedDataRejected = cached_data->rejected;
+  }
+  if (cache == nullptr) {
+    ScriptCompiler::CachedData* created =
+        ScriptCompiler::CreateCodeCache(unbound_script);
+    std::lock_guard<std::mutex> lock(source->mu);
+    if (!source->cache) {
+      source->cache.reset(created);
+    } else {
+      delete created;
+    }
+  }
+
+  rtn.ptr = tracked_unbound_script(ctx, unbound_script);
+  return rtn;
+}
+
+/********** UnboundScript & ScriptCompilerCachedData **********/
+
+ScriptCompilerCachedData* UnboundScriptCreateCodeCache(
+    IsolatePtr iso,
+    UnboundScriptPtr us_ptr) {
+  ISOLATE_SCOPE(iso);
+
+  Local<UnboundScript> unbound_script = us_ptr->ptr.Get(iso);
+
+  return CachedDataResult(ScriptCompiler::CreateCodeCache(unbound_script));
+}
+
+void ScriptCompilerCachedDataDelete(ScriptCompilerCachedData* cached_data) {
+  delete cached_data->ptr;
+  delete cached_data;
+}
+
+// This can only run in contexts that belong to the same isolate
+// the script was compiled in
+void UnboundScriptRelease(UnboundScriptPtr us_ptr) {
+  Isolate* iso = us_ptr->ctx->iso;
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+
+  for (m_ctx* ctx : us_ptr->boundIn) {
+    ctx->boundScripts.erase(us_ptr);
+  }
+  us_ptr->boundIn.clear();
+  us_ptr->ptr.Reset();
+  us_ptr->ctx->unboundScripts.Free(us_ptr->slot);
+}
+
+RtnValue UnboundScriptRun(ContextPtr ctx, UnboundScriptPtr us_ptr) {
+  LOCAL_CONTEXT(ctx)
+
+  RtnValue rtn = {};
+
+  Local<Script> script;
+  auto bound = ctx->boundScripts.find(us_ptr);
+  if (bound != ctx->boundScripts.end()) {
+    script = bound->second.Get(iso);
+  } else {
+    Local<UnboundScript> unbound_script = us_ptr->ptr.Get(iso);
+    script = unbound_script->BindToCurrentContext();
+    ctx->boundScripts.emplace(us_ptr, Global<Script>(iso, script));
+    us_ptr->boundIn.push_back(ctx);
+  }
+
+  Local<Value> result;
+  if (!script->Run(local_ctx).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
+}
+
+RtnValue JSONParse(ContextPtr ctx, StringArg str) {
+  LOCAL_CONTEXT(ctx);
+  RtnValue rtn = {};
+
+  Local<String> v8Str;
+  if (!NewString(iso, str).ToLocal(&v8Str)) {
+    rtn.error.msg = CopyString("RangeError: Invalid string length");
+    return rtn;
+  }
+
+  Local<Value> result;
+  if (!JSON::Parse(local_ctx, v8Str).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
+}
+
+RtnUtf8 JSONStringify(ContextPtr ctx,
+                      ValuePtr val,
+                      ValuePtr replacer,
+                      StringArg gap,
+                      char* buf,
+                      int cap) {
+  Isolate* iso;
+
+  if (ctx != nullptr) {
+    iso = ctx->iso;
+  } else {
+    iso = val->iso;
+  }
+
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+
+  if (ctx == nullptr) {
+    if (val->ctx != nullptr) {
+      ctx = val->ctx;
+    } else {
+      ctx = isolateInternalContext(iso);
+    }
+  }
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+
+  Context::Scope context_scope(local_ctx);
+  TryCatch try_catch(iso);
+
+  RtnUtf8 rtn = {};
+  Local<String> gap_str = String::Empty(iso);
+  if (gap.length > 0 && !NewString(iso, gap).ToLocal(&gap_str)) {
+    return rtn;
+  }
+
+  Local<Value> str;
+  if (replacer == nullptr) {
+    Local<String> result;
+    if (JSON::Stringify(local_ctx, val->ptr.Get(iso), gap_str)
+            .ToLocal(&result)) {
+      str = result;
+    }
+  } else {
+    // JSON::Stringify has no replacer, so JSON.stringify of the context is
+    // called instead.
+    Local<Value> json, stringify;
+    if (local_ctx->Global()
+            ->Get(local_ctx, String::NewFromUtf8Literal(iso, "JSON"))
+            .ToLocal(&json) &&
+        json->IsObject() &&
+        json.As<Object>()
+            ->Get(local_ctx, String::NewFromUtf8Literal(iso, "stringify"))
+            .ToLocal(&stringify) &&
+        stringify->IsFunction()) {
+      Local<Value> argv[] = {val->ptr.Get(iso), replacer->ptr.Get(iso),
+                             gap_str};
+      str = stringify.As<Function>()
+                ->Call(local_ctx, json, 3, argv)
+                .FromMaybe(Local<Value>());
+    }
+  }
+
+  if (try_catch.HasCaught()) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  // Values that have no JSON text, such as undefined, stringify to nothing.
+  if (str.IsEmpty() || !str->IsString()) {
+    return rtn;
+  }
+  return Utf8Result(ctx, str.As<String>(), buf, cap);
+}
+
+ValuePtr ContextGlobal(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  return tracked_value(ctx, local_ctx->Global());
+}
+
+/********** ValueScope **********/
+
+static void enterValueScope(m_ctx* ctx) {
+  ctx->scopeMarks.push_back(ctx->scopedVals.size());
+}
+
+static void exitValueScope(m_ctx* ctx) {
+  if (ctx->scopeMarks.empty()) {
+    return;
+  }
+  size_t mark = ctx->scopeMarks.back();
+  ctx->scopeMarks.pop_back();
+  for (size_t i = mark; i < ctx->scopedVals.size(); i++) {
+    m_scopedValue& sv = ctx->scopedVals[i];
+    if (sv.val != nullptr) {
+      release_value_of(sv.val, sv.gen);
+    }
+  }
+  ctx->scopedVals.resize(mark);
+}
+
+// Values created with the isolate, rather than a context, are tracked on the
+// internal context so a value scope covers both.
+void ContextEnterValueScope(ContextPtr ctx) {
+  Isolate* iso = ctx->iso;
+  LOCK_ISOLATE(iso);
+  enterValueScope(ctx);
+  m_ctx* internal_ctx = isolateInternalContext(iso);
+  if (internal_ctx != ctx) {
+    enterValueScope(internal_ctx);
+  }
+}
+
+void ContextExitValueScope(ContextPtr ctx) {
+  Isolate* iso = ctx->iso;
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  exitValueScope(ctx);
+  m_ctx* internal_ctx = isolateInternalContext(iso);
+  if (internal_ctx != ctx) {
+    exitValueScope(internal_ctx);
+  }
+}
+
+void ValueScopeEscape(ValuePtr ptr) {
+  Isolate* iso = ptr->iso;
+  LOCK_ISOLATE(iso);
+  m_ctx* ctx = ptr->ctx;
+  if (ctx->scopeMarks.empty()) {
+    return;
+  }
+  size_t mark = ctx->scopeMarks.back();
+  for (size_t i = ctx->scopedVals.size(); i > mark; i--) {
+    m_scopedValue& sv = ctx->scopedVals[i - 1];
+    if (sv.val != ptr || sv.gen != ptr->gen) {
+      continue;
+    }
+    sv.val = nullptr;
+    // Like an EscapableHandleScope, the value now belongs to the enclosing
+    // scope, if there is one, and is released when that scope exits.
+    if (ctx->scopeMarks.size() > 1) {
+      ctx->scopedVals.insert(ctx->scopedVals.begin() + mark,
+                             m_scopedValue{ptr, ptr->gen});
+      ctx->scopeMarks.back()++;
+    }
+    return;
+  }
+}
+
+/********** Value **********/
+
+void ValueReleaseDeferred(ValuePtr ptr, uint32_t gen) {
+  if (isCachedValue(ptr)) {
+    return;
+  }
+  std::atomic<m_deferredRelease*>& queue = ptr->ctx->deferredReleases;
+  m_deferredRelease* node =
+      new m_deferredRelease{ptr, gen, queue.load(std::memory_order_relaxed)};
+  while (!queue.compare_exchange_weak(node->next, node,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+int ValueRelease(ValuePtr ptr, uint32_t gen) {
+  if (ptr == nullptr || isCachedValue(ptr)) {
+    return 0;
+  }
+  Isolate* iso = ptr->iso;
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+
+  release_value_of(ptr, gen);
+  return 1;
+}
+
+#define LOCAL_VALUE(val)                   \
+  Isolate* iso = val->iso;                 \
+  LOCK_ISOLATE(iso);                       \
+  Isolate::Scope isolate_scope(iso);       \
+  HandleScope handle_scope(iso);           \
+  TryCatch try_catch(iso);                 \
+  m_ctx* ctx = val->ctx;                   \
+  Local<Context> local_ctx;                \
+  if (ctx != nullptr) {                    \
+    local_ctx = ctx->ptr.Get(iso);         \
+  } else {                                 \
+    ctx = isolateInternalContext(iso);     \
+    local_ctx = ctx->ptr.Get(iso);         \
+  }                                        \
+  Context::Scope context_scope(local_ctx); \
+  Local<Value> value = val->ptr.Get(iso);  \
+  drainDeferredReleases(ctx);
+
+ValuePtr NewValueInteger(IsolatePtr iso, int32_t v) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx, Integer::New(iso, v));
+}
+
+ValuePtr NewValueIntegerFromUnsigned(IsolatePtr iso, uint32_t v) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx, Integer::NewFromUnsigned(iso, v));
+}
+
+RtnValue NewValueString(IsolatePtr iso, StringArg v) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  TryCatch try_catch(iso);
+  RtnValue rtn = {};
+  StringCache* cache = isolateData(iso)->stringCache.get();
+  Local<String> str;
+  if (!(cache != nullptr && cache->Caches(v) ? cache->Get(iso, v)
+                                             : NewString(iso, v))
+           .ToLocal(&str)) {
+    rtn.error = ExceptionError(try_catch, iso, ctx->ptr.Get(iso));
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, str);
+  return rtn;
+}
+
+ValuePtr NewValueNull(IsolatePtr iso) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx, Null(iso));
+}
+
+ValuePtr NewValueUndefined(IsolatePtr iso) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx, Undefined(iso));
+}
+
+ValuePtr NewValueExternal(IsolatePtr iso, uintptr_t handle) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx,
+                       External::New(iso, reinterpret_cast<void*>(handle)));
+}
+
+ValuePtr NewValueBoolean(IsolatePtr iso, int v) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx, Boolean::New(iso, v));
+}
 
 ValuePtr NewValueNumber(IsolatePtr iso, double v) {
   ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(
-      iso, Number::New(iso, v));
-  return tracked_value(ctx, val);
+  return tracked_value(ctx, Number::New(iso, v));
+}
+
+ValuePtr NewValueBigInt(IsolatePtr iso, int64_t v) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx, BigInt::New(iso, v));
+}
+
+ValuePtr NewValueBigIntFromUnsigned(IsolatePtr iso, uint64_t v) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  return tracked_value(ctx, BigInt::NewFromUnsigned(iso, v));
+}
+
+RtnValue NewValueBigIntFromWords(IsolatePtr iso,
+                                 int sign_bit,
+                                 int word_count,
+                                 const uint64_t* words) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  TryCatch try_catch(iso);
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+
+  RtnValue rtn = {};
+  Local<BigInt> bigint;
+  if (!BigInt::NewFromWords(local_ctx, sign_bit, word_count, words)
+           .ToLocal(&bigint)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, bigint);
+  return rtn;
+}
+
+ValuePtr NewValueError(IsolatePtr iso, ErrorTypeIndex idx, const char* message) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  Local<Context> local_ctx = ctx->ptr.Get(iso);
+  Context::Scope context_scope(local_ctx);
+
+  Local<String> local_msg = String::NewFromUtf8(iso, message).ToLocalChecked();
+  Local<Value> v;
+  switch (idx) {
+  case ERROR_RANGE:
+    v = Exception::RangeError(local_msg);
+    break;
+  case ERROR_REFERENCE:
+    v = Exception::ReferenceError(local_msg);
+    break;
+  case ERROR_SYNTAX:
+    v = Exception::SyntaxError(local_msg);
+    break;
+  case ERROR_TYPE:
+    v = Exception::TypeError(local_msg);
+    break;
+  case ERROR_WASM_COMPILE:
+    v = Exception::WasmCompileError(local_msg);
+    break;
+  case ERROR_WASM_LINK:
+    v = Exception::WasmLinkError(local_msg);
+    break;
+  case ERROR_WASM_RUNTIME:
+    v = Exception::WasmRuntimeError(local_msg);
+    break;
+  case ERROR_GENERIC:
+    v = Exception::Error(local_msg);
+    break;
+  default:
+    return nullptr;
+  }
+  return tracked_value(ctx, v);
+}
+
+const uint32_t* ValueToArrayIndex(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  Local<Uint32> array_index;
+  if (!value->ToArrayIndex(local_ctx).ToLocal(&array_index)) {
+    return nullptr;
+  }
+
+  uint32_t* idx = (uint32_t*)malloc(sizeof(uint32_t));
+  *idx = array_index->Value();
+  return idx;
+}
+
+int ValueToBoolean(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->BooleanValue(iso);
+}
+
+int32_t ValueToInt32(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->Int32Value(local_ctx).ToChecked();
+}
+
+int64_t ValueToInteger(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IntegerValue(local_ctx).ToChecked();
+}
+
+uintptr_t ValueToExternal(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  if (!value->IsExternal()) {
+    return 0;
+  }
+  return reinterpret_cast<uintptr_t>(value.As<External>()->Value());
+}
+
+double ValueToNumber(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->NumberValue(local_ctx).ToChecked();
+}
+
+RtnUtf8 ValueToDetailString(ValuePtr ptr, char* buf, int cap) {
+  LOCAL_VALUE(ptr);
+  Local<String> str;
+  if (!value->ToDetailString(local_ctx).ToLocal(&str)) {
+    RtnUtf8 rtn = {};
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  return Utf8Result(ctx, str, buf, cap);
+}
+
+RtnUtf8 ValueToUtf8(ValuePtr ptr, char* buf, int cap) {
+  LOCAL_VALUE(ptr);
+  // Conversion to a string results in an empty string if it fails
+  // TODO: Consider propagating the JS error. A fallback value could be returned
+  // in Value.String()
+  Local<String> str;
+  if (!value->ToString(local_ctx).ToLocal(&str)) {
+    return RtnUtf8{};
+  }
+  return Utf8Result(ctx, str, buf, cap);
+}
+
+RtnUtf8 ValueToUtf8Hash(ValuePtr ptr,
+                        char* buf,
+                        int cap,
+                        int max_length) {
+  LOCAL_VALUE(ptr);
+  Local<String> str;
+  if (!value->ToString(local_ctx).ToLocal(&str)) {
+    return RtnUtf8{};
+  }
+  RtnUtf8 rtn = Utf8Result(ctx, str, buf, cap);
+  if (rtn.string == nullptr && rtn.length <= max_length) {
+    // The hash of a string is computed once and kept with it, as that of an
+    // internalized string, such as a property name or literal, already is.
+    rtn.hash = str->GetIdentityHash();
+  }
+  return rtn;
+}
+
+int StringWriteUtf8(ValuePtr ptr, char* buf, int length) {
+  LOCAL_VALUE(ptr);
+  Local<String> str = value.As<String>();
+  if (str->IsOneByte()) {
+    int utf8_length = str->Length();
+    if (utf8_length <= length) {
+      writeOneByteUtf8(iso, str, utf8_length, buf, length, &utf8_length);
+    }
+    return utf8_length;
+  }
+  return str->WriteUtf8(iso, buf, length, nullptr, kUtf8WriteOptions);
+}
+
+uint32_t ValueToUint32(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->Uint32Value(local_ctx).ToChecked();
+}
+
+ValueBigInt ValueToBigInt(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  Local<BigInt> bint;
+  if (!value->ToBigInt(local_ctx).ToLocal(&bint)) {
+    return {nullptr, 0};
+  }
+
+  int word_count = bint->WordCount();
+  int sign_bit = 0;
+  uint64_t* words = (uint64_t*)malloc(sizeof(uint64_t) * word_count);
+  bint->ToWordsArray(&sign_bit, &word_count, words);
+  ValueBigInt rtn = {words, word_count, sign_bit};
+  return rtn;
+}
+
+RtnValue ValueToObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  RtnValue rtn = {};
+  Local<Object> obj;
+  if (!value->ToObject(local_ctx).ToLocal(&obj)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, obj);
+  return rtn;
+}
+
+int ValueSameValue(ValuePtr val1, ValuePtr val2) {
+  Isolate* iso = val1->iso;
+  ISOLATE_SCOPE(iso);
+  Local<Value> value1 = val1->ptr.Get(iso);
+  Local<Value> value2 = val2->ptr.Get(iso);
+
+  return value1->SameValue(value2);
 }
 
-ValuePtr NewValueBigInt(IsolatePtr iso, int64_t v) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(
-      iso, BigInt::New(iso, v));
-  return tracked_value(ctx, val);
+uint64_t ValueTypeOf(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return valueTypeOf(value);
 }
 
-ValuePtr NewValueBigIntFromUnsigned(IsolatePtr iso, uint64_t v) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(
-      iso, BigInt::NewFromUnsigned(iso, v));
-  return tracked_value(ctx, val);
+int ValueIsUndefined(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsUndefined();
 }
 
-RtnValue NewValueBigIntFromWords(IsolatePtr iso,
-                                 int sign_bit,
-                                 int word_count,
-                                 const uint64_t* words) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  TryCatch try_catch(iso);
-  Local<Context> local_ctx = ctx->ptr.Get(iso);
+int ValueIsNull(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsNull();
+}
 
-  RtnValue rtn = {};
-  Local<BigInt> bigint;
-  if (!BigInt::NewFromWords(local_ctx, sign_bit, word_count, words)
-           .ToLocal(&bigint)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
-  }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, bigint);
-  rtn.value = tracked_value(ctx, val);
-  return rtn;
+int ValueIsNullOrUndefined(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsNullOrUndefined();
 }
 
-ValuePtr NewValueError(IsolatePtr iso, ErrorTypeIndex idx, const char* message) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  Local<Context> local_ctx = ctx->ptr.Get(iso);
-  Context::Scope context_scope(local_ctx);
+int ValueIsTrue(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsTrue();
+}
 
-  Local<String> local_msg = String::NewFromUtf8(iso, message).ToLocalChecked();
-  Local<Value> v;
-  switch (idx) {
-  case ERROR_RANGE:
-    v = Exception::RangeError(local_msg);
-    break;
-  case ERROR_REFERENCE:
-    v = Exception::ReferenceError(local_msg);
-    break;
-  case ERROR_SYNTAX:
-    v = Exception::SyntaxError(local_msg);
-    break;
-  case ERROR_TYPE:
-    v = Exception::TypeError(local_msg);
-    break;
-  case ERROR_WASM_COMPILE:
-    v = Exception::WasmCompileError(local_msg);
-    break;
-  case ERROR_WASM_LINK:
-    v = Exception::WasmLinkError(local_msg);
-    break;
-  case ERROR_WASM_RUNTIME:
-    v = Exception::WasmRuntimeError(local_msg);
-    break;
-  case ERROR_GENERIC:
-    v = Exception::Error(local_msg);
-    break;
-  default:
-    return nullptr;
-  }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, v);
-  return tracked_value(ctx, val);
+int ValueIsFalse(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsFalse();
 }
 
-const uint32_t* ValueToArrayIndex(ValuePtr ptr) {
+int ValueIsName(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  Local<Uint32> array_index;
-  if (!value->ToArrayIndex(local_ctx).ToLocal(&array_index)) {
-    return nullptr;
-  }
+  return value->IsName();
+}
 
-  uint32_t* idx = (uint32_t*)malloc(sizeof(uint32_t));
-  *idx = array_index->Value();
-  return idx;
+int ValueIsString(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsString();
+}
+
+int ValueIsSymbol(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsSymbol();
+}
+
+int ValueIsFunction(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsFunction();
+}
+
+int ValueIsObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsObject();
+}
+
+int ValueIsBigInt(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsBigInt();
+}
+
+int ValueIsBoolean(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsBoolean();
+}
+
+int ValueIsNumber(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsNumber();
+}
+
+int ValueIsExternal(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsExternal();
+}
+
+int ValueIsInt32(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsInt32();
+}
+
+int ValueIsUint32(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsUint32();
+}
+
+int ValueIsDate(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsDate();
+}
+
+int ValueIsArgumentsObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsArgumentsObject();
+}
+
+int ValueIsBigIntObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsBigIntObject();
+}
+
+int ValueIsNumberObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsNumberObject();
+}
+
+int ValueIsStringObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsStringObject();
+}
+
+int ValueIsSymbolObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsSymbolObject();
+}
+
+int ValueIsNativeError(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsNativeError();
+}
+
+int ValueIsRegExp(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsRegExp();
+}
+
+int ValueIsAsyncFunction(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsAsyncFunction();
+}
+
+int ValueIsGeneratorFunction(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsGeneratorFunction();
+}
+
+int ValueIsGeneratorObject(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsGeneratorObject();
+}
+
+int ValueIsPromise(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsPromise();
+}
+
+int ValueIsMap(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsMap();
+}
+
+int ValueIsSet(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsSet();
+}
+
+int ValueIsMapIterator(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsMapIterator();
+}
+
+int ValueIsSetIterator(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsSetIterator();
+}
+
+int ValueIsWeakMap(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsWeakMap();
+}
+
+int ValueIsWeakSet(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsWeakSet();
+}
+
+int ValueIsArray(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsArray();
+}
+
+int ValueIsArrayBuffer(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsArrayBuffer();
+}
+
+int ValueIsArrayBufferView(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsArrayBufferView();
+}
+
+int ValueIsTypedArray(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsTypedArray();
+}
+
+int ValueIsUint8Array(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsUint8Array();
+}
+
+int ValueIsUint8ClampedArray(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsUint8ClampedArray();
 }
 
-int ValueToBoolean(ValuePtr ptr) {
+int ValueIsInt8Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->BooleanValue(iso);
+  return value->IsInt8Array();
 }
 
-int32_t ValueToInt32(ValuePtr ptr) {
+int ValueIsUint16Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->Int32Value(local_ctx).ToChecked();
+  return value->IsUint16Array();
 }
 
-int64_t ValueToInteger(ValuePtr ptr) {
+int ValueIsInt16Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IntegerValue(local_ctx).ToChecked();
+  return value->IsInt16Array();
 }
 
-double ValueToNumber(ValuePtr ptr) {
+int ValueIsUint32Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->NumberValue(local_ctx).ToChecked();
+  return value->IsUint32Array();
 }
 
-RtnString ValueToDetailString(ValuePtr ptr) {
+int ValueIsInt32Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  RtnString rtn = {0};
-  Local<String> str;
-  if (!value->ToDetailString(local_ctx).ToLocal(&str)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
-  }
-  String::Utf8Value ds(iso, str);
-  rtn.data = CopyString(ds);
-  rtn.length = ds.length();
-  return rtn;
+  return value->IsInt32Array();
 }
 
-RtnString ValueToString(ValuePtr ptr) {
+int ValueIsFloat32Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  RtnString rtn = {0};
-  // String::Utf8Value will result in an empty string if conversion to a string
-  // fails
-  // TODO: Consider propagating the JS error. A fallback value could be returned
-  // in Value.String()
-  String::Utf8Value src(iso, value);
-  char* data = static_cast<char*>(malloc(src.length()));
-  memcpy(data, *src, src.length());
-  rtn.data = data;
-  rtn.length = src.length();
-  return rtn;
+  return value->IsFloat32Array();
 }
 
-uint32_t ValueToUint32(ValuePtr ptr) {
+int ValueIsFloat64Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->Uint32Value(local_ctx).ToChecked();
+  return value->IsFloat64Array();
 }
 
-ValueBigInt ValueToBigInt(ValuePtr ptr) {
+int ValueIsBigInt64Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  Local<BigInt> bint;
-  if (!value->ToBigInt(local_ctx).ToLocal(&bint)) {
-    return {nullptr, 0};
-  }
-
-  int word_count = bint->WordCount();
-  int sign_bit = 0;
-  uint64_t* words = (uint64_t*)malloc(sizeof(uint64_t) * word_count);
-  bint->ToWordsArray(&sign_bit, &word_count, words);
-  ValueBigInt rtn = {words, word_count, sign_bit};
-  return rtn;
+  return value->IsBigInt64Array();
 }
 
-RtnValue ValueToObject(ValuePtr ptr) {
+int ValueIsBigUint64Array(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  RtnValue rtn = {};
-  Local<Object> obj;
-  if (!value->ToObject(local_ctx).ToLocal(&obj)) {
-    rtn.error = ExceptionError(try_catch, iso, local_ctx);
-    return rtn;
-  }
-  m_value* new_val = new m_value;
-  new_val->iso = iso;
-  new_val->ctx = ctx;
-  new_val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, obj);
-  rtn.value = tracked_value(ctx, new_val);
-  return rtn;
+  return value->IsBigUint64Array();
 }
 
-int ValueSameValue(ValuePtr val1, ValuePtr val2) {
-  Isolate* iso = val1->iso;
-  ISOLATE_SCOPE(iso);
-  Local<Value> value1 = val1->ptr.Get(iso);
-  Local<Value> value2 = val2->ptr.Get(iso);
-
-  return value1->SameValue(value2);
+int ValueIsDataView(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return value->IsDataView();
 }
 
-int ValueIsUndefined(ValuePtr ptr) {
+int ValueIsSharedArrayBuffer(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsUndefined();
+  return value->IsSharedArrayBuffer();
 }
 
-int ValueIsNull(ValuePtr ptr) {
+int ValueIsProxy(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsNull();
+  return value->IsProxy();
 }
 
-int ValueIsNullOrUndefined(ValuePtr ptr) {
+int ValueIsWasmModuleObject(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsNullOrUndefined();
+  return value->IsWasmModuleObject();
 }
 
-int ValueIsTrue(ValuePtr ptr) {
+int ValueIsModuleNamespaceObject(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsTrue();
+  return value->IsModuleNamespaceObject();
 }
 
-int ValueIsFalse(ValuePtr ptr) {
+/********** Exception **********/
+
+RtnUtf8 ExceptionGetMessageString(ValuePtr ptr, char* buf, int cap) {
   LOCAL_VALUE(ptr);
-  return value->IsFalse();
+
+  Local<Message> local_msg = Exception::CreateMessage(iso, value);
+  return Utf8Result(ctx, local_msg->Get(), buf, cap);
+}
+
+RtnError ExceptionErrorFormat(ValuePtr exception, int keep) {
+  LOCAL_VALUE(exception);
+  RtnError rtn = {};
+  String::Utf8Value msg(iso, value);
+  rtn.msg = CopyString(msg);
+  // As TryCatch::StackTrace reads it.
+  Local<Object> obj = value.As<Object>();
+  Local<String> stack_key = String::NewFromUtf8Literal(iso, "stack");
+  Local<Value> stack;
+  if (obj->Has(local_ctx, stack_key).FromMaybe(false) &&
+      obj->Get(local_ctx, stack_key).ToLocal(&stack)) {
+    String::Utf8Value stack_str(iso, stack);
+    rtn.stack = CopyString(stack_str);
+  }
+  if (!keep) {
+    release_value(exception);
+  }
+  return rtn;
 }
 
-int ValueIsName(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsName();
+/********** Object **********/
+
+#define LOCAL_OBJECT(ptr) \
+  LOCAL_VALUE(ptr)        \
+  Local<Object> obj = value.As<Object>()
+
+void ObjectSet(ValuePtr ptr, const char* key, ValuePtr prop_val) {
+  LOCAL_OBJECT(ptr);
+  Local<String> key_val =
+      String::NewFromUtf8(iso, key, NewStringType::kNormal).ToLocalChecked();
+  obj->Set(local_ctx, key_val, prop_val->ptr.Get(iso)).Check();
 }
 
-int ValueIsString(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsString();
+void ObjectSetAnyKey(ValuePtr ptr, ValuePtr key, ValuePtr prop_val) {
+  LOCAL_OBJECT(ptr);
+  Local<Value> local_key = key->ptr.Get(iso);
+  obj->Set(local_ctx, local_key, prop_val->ptr.Get(iso)).Check();
 }
 
-int ValueIsSymbol(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsSymbol();
+void ObjectSetIdx(ValuePtr ptr, uint32_t idx, ValuePtr prop_val) {
+  LOCAL_OBJECT(ptr);
+  obj->Set(local_ctx, idx, prop_val->ptr.Get(iso)).Check();
 }
 
-int ValueIsFunction(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsFunction();
+int ObjectSetInternalField(ValuePtr ptr, int idx, ValuePtr val_ptr) {
+  LOCAL_OBJECT(ptr);
+  m_value* prop_val = static_cast<m_value*>(val_ptr);
+
+  if (idx >= obj->InternalFieldCount()) {
+    return 0;
+  }
+
+  obj->SetInternalField(idx, prop_val->ptr.Get(iso));
+
+  return 1;
 }
 
-int ValueIsObject(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsObject();
+int ObjectSetAlignedPointerInInternalField(ValuePtr ptr,
+                                           int idx,
+                                           uintptr_t handle) {
+  LOCAL_OBJECT(ptr);
+
+  if (idx >= obj->InternalFieldCount()) {
+    return 0;
+  }
+
+  obj->SetAlignedPointerInInternalField(idx,
+                                        reinterpret_cast<void*>(handle << 1));
+
+  return 1;
 }
 
-int ValueIsBigInt(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsBigInt();
+uintptr_t ObjectGetAlignedPointerFromInternalField(ValuePtr ptr, int idx) {
+  LOCAL_OBJECT(ptr);
+
+  if (idx >= obj->InternalFieldCount()) {
+    return 0;
+  }
+
+  // A field that holds a value, such as the undefined of a field that was
+  // never set, reads as a tagged heap object pointer, whose low bit is set.
+  uintptr_t field = reinterpret_cast<uintptr_t>(
+      obj->GetAlignedPointerFromInternalField(idx));
+  if (field & 1) {
+    return 0;
+  }
+  return field >> 1;
 }
 
-int ValueIsBoolean(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsBoolean();
+int ObjectInternalFieldCount(ValuePtr ptr) {
+  LOCAL_OBJECT(ptr);
+  return obj->InternalFieldCount();
 }
 
-int ValueIsNumber(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsNumber();
+RtnValue ObjectGet(ValuePtr ptr, const char* key) {
+  LOCAL_OBJECT(ptr);
+  RtnValue rtn = {};
+
+  Local<String> key_val;
+  if (!String::NewFromUtf8(iso, key, NewStringType::kNormal)
+           .ToLocal(&key_val)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  Local<Value> result;
+  if (!obj->Get(local_ctx, key_val).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
 }
 
-int ValueIsExternal(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsExternal();
+RtnValue ObjectGetAnyKey(ValuePtr ptr, ValuePtr key) {
+  LOCAL_OBJECT(ptr);
+  RtnValue rtn = {nullptr, nullptr};
+
+  Local<Value> local_key = key->ptr.Get(iso);
+  Local<Value> result;
+  if (!obj->Get(local_ctx, local_key).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
 }
 
-int ValueIsInt32(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsInt32();
+ValuePtr ObjectGetInternalField(ValuePtr ptr, int idx) {
+  LOCAL_OBJECT(ptr);
+
+  if (idx >= obj->InternalFieldCount()) {
+    return nullptr;
+  }
+
+  Local<Value> result = obj->GetInternalField(idx);
+
+  return tracked_value(ctx, result);
 }
 
-int ValueIsUint32(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsUint32();
+RtnValue ObjectGetIdx(ValuePtr ptr, uint32_t idx) {
+  LOCAL_OBJECT(ptr);
+  RtnValue rtn = {};
+
+  Local<Value> result;
+  if (!obj->Get(local_ctx, idx).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
 }
 
-int ValueIsDate(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsDate();
+int ObjectHas(ValuePtr ptr, const char* key) {
+  LOCAL_OBJECT(ptr);
+  Local<String> key_val =
+      String::NewFromUtf8(iso, key, NewStringType::kNormal).ToLocalChecked();
+  return obj->Has(local_ctx, key_val).ToChecked();
 }
 
-int ValueIsArgumentsObject(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsArgumentsObject();
+int ObjectHasAnyKey(ValuePtr ptr, ValuePtr key) {
+  LOCAL_OBJECT(ptr);
+  Local<Value> local_key = key->ptr.Get(iso);
+  return obj->Has(local_ctx, local_key).ToChecked();
 }
 
-int ValueIsBigIntObject(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsBigIntObject();
+int ObjectHasIdx(ValuePtr ptr, uint32_t idx) {
+  LOCAL_OBJECT(ptr);
+  return obj->Has(local_ctx, idx).ToChecked();
 }
 
-int ValueIsNumberObject(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsNumberObject();
+int ObjectDelete(ValuePtr ptr, const char* key) {
+  LOCAL_OBJECT(ptr);
+  Local<String> key_val =
+      String::NewFromUtf8(iso, key, NewStringType::kNormal).ToLocalChecked();
+  return obj->Delete(local_ctx, key_val).ToChecked();
+}
+
+int ObjectDeleteAnyKey(ValuePtr ptr, ValuePtr key) {
+  LOCAL_OBJECT(ptr);
+  Local<Value> local_key = key->ptr.Get(iso);
+  return obj->Delete(local_ctx, local_key).ToChecked();
 }
 
-int ValueIsStringObject(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsStringObject();
+int ObjectDeleteIdx(ValuePtr ptr, uint32_t idx) {
+  LOCAL_OBJECT(ptr);
+  return obj->Delete(local_ctx, idx).ToChecked();
 }
 
-int ValueIsSymbolObject(ValuePtr ptr) {
+RtnError ObjectCopyFloat64(ValuePtr ptr, double* dst, size_t n, size_t* done) {
   LOCAL_VALUE(ptr);
-  return value->IsSymbolObject();
+  return copyNumbers(iso, local_ctx, try_catch, value, dst, n, done);
 }
 
-int ValueIsNativeError(ValuePtr ptr) {
+RtnError ObjectCopyInt32(ValuePtr ptr, int32_t* dst, size_t n, size_t* done) {
   LOCAL_VALUE(ptr);
-  return value->IsNativeError();
+  return copyNumbers(iso, local_ctx, try_catch, value, dst, n, done);
 }
 
-int ValueIsRegExp(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsRegExp();
+static void ObjectCollected(const WeakCallbackInfo<m_weakObject>& info) {
+  m_weakObject* weak = info.GetParameter();
+  weak->handle.Reset();
+  weak->data->finalizedObjects.push_back(weak->ref);
+  weak->data->weakObjects.erase(weak->ref);
 }
 
-int ValueIsAsyncFunction(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsAsyncFunction();
+void ObjectSetWeak(ValuePtr ptr, int ref) {
+  LOCAL_OBJECT(ptr);
+  m_isolate* data = isolateData(iso);
+  auto weak = std::unique_ptr<m_weakObject>(
+      new m_weakObject{data, ref, Global<Object>()});
+  weak->handle.Reset(iso, obj);
+  weak->handle.SetWeak(weak.get(), ObjectCollected,
+                       WeakCallbackType::kParameter);
+  data->weakObjects[ref] = std::move(weak);
 }
 
-int ValueIsGeneratorFunction(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsGeneratorFunction();
+size_t IsolateDrainFinalizedObjects(IsolatePtr iso, int* refs, size_t n) {
+  LOCK_ISOLATE(iso);
+  std::vector<int>& finalized = isolateData(iso)->finalizedObjects;
+  n = std::min(n, finalized.size());
+  std::copy(finalized.begin(), finalized.begin() + n, refs);
+  finalized.erase(finalized.begin(), finalized.begin() + n);
+  return n;
 }
 
-int ValueIsGeneratorObject(ValuePtr ptr) {
+/********** Bulk **********/
+
+RtnBulk ValueExport(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsGeneratorObject();
+  RtnBulk rtn = {};
+  BulkExporter exporter(ctx, local_ctx);
+  if (!exporter.Write(value)) {
+    for (ValuePtr val : exporter.values) {
+      release_value(val);
+    }
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  exporter.Finish(&rtn);
+  return rtn;
 }
 
-int ValueIsPromise(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsPromise();
+static_assert(
+    int(PROPERTY_FILTER_ONLY_WRITABLE) == int(ONLY_WRITABLE) &&
+        int(PROPERTY_FILTER_ONLY_ENUMERABLE) == int(ONLY_ENUMERABLE) &&
+        int(PROPERTY_FILTER_ONLY_CONFIGURABLE) == int(ONLY_CONFIGURABLE),
+    "PropertyFilterBit must match PropertyFilter");
+
+RtnBulk ObjectPropertyNames(ValuePtr ptr, int mode, int filter, int entries) {
+  LOCAL_OBJECT(ptr);
+  RtnBulk rtn = {};
+  BulkExporter exporter(ctx, local_ctx);
+  Local<Array> keys;
+  // Symbols are left out, so that the names are all strings, as are indices.
+  if (!obj->GetPropertyNames(
+               local_ctx, static_cast<KeyCollectionMode>(mode),
+               static_cast<PropertyFilter>(filter | SKIP_SYMBOLS),
+               IndexFilter::kIncludeIndices, KeyConversionMode::kConvertToString)
+           .ToLocal(&keys) ||
+      !exporter.WriteProperties(obj, keys, entries)) {
+    for (ValuePtr val : exporter.values) {
+      release_value(val);
+    }
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  exporter.Finish(&rtn);
+  return rtn;
 }
 
-int ValueIsMap(ValuePtr ptr) {
+RtnBulk ObjectCollectionEntries(ValuePtr ptr, int map) {
   LOCAL_VALUE(ptr);
-  return value->IsMap();
+  RtnBulk rtn = {};
+  // AsArray copies the entries of a Map as its keys and values in turn.
+  Local<Array> entries;
+  if (map && value->IsMap()) {
+    entries = value.As<Map>()->AsArray();
+  } else if (!map && value->IsSet()) {
+    entries = value.As<Set>()->AsArray();
+  } else {
+    rtn.error.msg = CopyString(map ? "TypeError: value is not a Map"
+                                   : "TypeError: value is not a Set");
+    return rtn;
+  }
+  BulkExporter exporter(ctx, local_ctx);
+  exporter.WriteElements(entries);
+  exporter.Finish(&rtn);
+  return rtn;
 }
 
-int ValueIsSet(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsSet();
+RtnValue ContextImport(ContextPtr ctx, const char* data, ValuePtr* values) {
+  LOCAL_CONTEXT(ctx);
+  RtnValue rtn = {};
+  BulkImporter importer(iso, data, values);
+  Local<Value> value;
+  if (!importer.Read().ToLocal(&value)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, value);
+  return rtn;
 }
 
-int ValueIsMapIterator(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsMapIterator();
+uint32_t IsolateNewShape(IsolatePtr iso, const char* keys, int count) {
+  ISOLATE_SCOPE(iso);
+  std::vector<Global<String>> shape;
+  for (int i = 0; i < count; i++) {
+    uint32_t length;
+    memcpy(&length, keys, sizeof(length));
+    keys += sizeof(length);
+    Local<String> key =
+        String::NewFromUtf8(iso, keys, NewStringType::kInternalized, length)
+            .ToLocalChecked();
+    keys += length;
+    shape.emplace_back(iso, key);
+  }
+  std::vector<std::vector<Global<String>>>& shapes = isolateData(iso)->shapes;
+  shapes.push_back(std::move(shape));
+  return shapes.size() - 1;
 }
 
-int ValueIsSetIterator(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsSetIterator();
+/********** PropertyKey **********/
+
+ValuePtr NewPropertyKey(IsolatePtr iso, const char* name, int length) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  Local<String> key;
+  if (!String::NewFromUtf8(iso, name, NewStringType::kInternalized, length)
+           .ToLocal(&key)) {
+    return nullptr;
+  }
+  return tracked_value(ctx, key);
 }
 
-int ValueIsWeakMap(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsWeakMap();
+/********** Symbol **********/
+
+ValuePtr BuiltinSymbol(IsolatePtr iso, SymbolIndex idx) {
+  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
+  Local<Symbol> sym;
+  switch (idx) {
+  case SYMBOL_ASYNC_ITERATOR:
+    sym = Symbol::GetAsyncIterator(iso);
+    break;
+  case SYMBOL_HAS_INSTANCE:
+    sym = Symbol::GetHasInstance(iso);
+    break;
+  case SYMBOL_IS_CONCAT_SPREADABLE:
+    sym = Symbol::GetIsConcatSpreadable(iso);
+    break;
+  case SYMBOL_ITERATOR:
+    sym = Symbol::GetIterator(iso);
+    break;
+  case SYMBOL_MATCH:
+    sym = Symbol::GetMatch(iso);
+    break;
+  case SYMBOL_REPLACE:
+    sym = Symbol::GetReplace(iso);
+    break;
+  case SYMBOL_SEARCH:
+    sym = Symbol::GetSearch(iso);
+    break;
+  case SYMBOL_SPLIT:
+    sym = Symbol::GetSplit(iso);
+    break;
+  case SYMBOL_TO_PRIMITIVE:
+    sym = Symbol::GetToPrimitive(iso);
+    break;
+  case SYMBOL_TO_STRING_TAG:
+    sym = Symbol::GetToStringTag(iso);
+    break;
+  case SYMBOL_UNSCOPABLES:
+    sym = Symbol::GetUnscopables(iso);
+    break;
+  default:
+    return nullptr;
+  }
+  return tracked_value(ctx, sym);
 }
 
-int ValueIsWeakSet(ValuePtr ptr) {
+RtnUtf8 SymbolDescription(ValuePtr ptr, char* buf, int cap) {
   LOCAL_VALUE(ptr);
-  return value->IsWeakSet();
+  Local<Symbol> sym = value.As<Symbol>();
+  Local<String> descr;
+  if (!sym->Description()->ToString(local_ctx).ToLocal(&descr)) {
+    return RtnUtf8{};
+  }
+  return Utf8Result(ctx, descr, buf, cap);
 }
 
-int ValueIsArray(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsArray();
+/********** ArrayBuffer **********/
+
+static void FreeBackingStore(void* data, size_t length, void* deleter_data) {
+  free(data);
 }
 
-int ValueIsArrayBuffer(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsArrayBuffer();
+// Backing stores of buffers created by NewArrayBuffer hold a reference to
+// the allocator of their isolate, which they are returned to.
+static void FreeAllocatorBackingStore(void* data,
+                                      size_t length,
+                                      void* deleter_data) {
+  std::shared_ptr<ArrayBufferAllocator>* allocator =
+      static_cast<std::shared_ptr<ArrayBufferAllocator>*>(deleter_data);
+  (*allocator)->Free(data, length);
+  delete allocator;
 }
 
-int ValueIsArrayBufferView(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsArrayBufferView();
+RtnValue NewArrayBuffer(ContextPtr ctx, const void* data, size_t byte_length) {
+  LOCAL_CONTEXT(ctx);
+  RtnValue rtn = {};
+  std::shared_ptr<ArrayBufferAllocator>& allocator =
+      isolateData(iso)->allocator;
+  // The memory is allocated here rather than by ArrayBuffer::NewBackingStore,
+  // so that it is filled without first being zeroed.
+  void* mem = data ? allocator->AllocateUninitialized(byte_length)
+                   : allocator->Allocate(byte_length);
+  if (mem == nullptr) {
+    rtn.error.msg = CopyString("Array buffer allocation failed");
+    return rtn;
+  }
+  if (data) {
+    memcpy(mem, data, byte_length);
+  }
+  std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+      mem, byte_length, FreeAllocatorBackingStore,
+      new std::shared_ptr<ArrayBufferAllocator>(allocator));
+  rtn.value = tracked_value(ctx, ArrayBuffer::New(iso, std::move(store)));
+  return rtn;
 }
 
-int ValueIsTypedArray(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsTypedArray();
+// Backing stores of buffers created by NewArrayBufferAdopted free the memory
+// that they adopted and release it from the allocator that counts it.
+static void FreeAdoptedBackingStore(void* data,
+                                    size_t length,
+                                    void* deleter_data) {
+  std::shared_ptr<ArrayBufferAllocator>* allocator =
+      static_cast<std::shared_ptr<ArrayBufferAllocator>*>(deleter_data);
+  (*allocator)->Release(length);
+  free(data);
+  delete allocator;
 }
 
-int ValueIsUint8Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsUint8Array();
+RtnValue NewArrayBufferAdopted(ContextPtr ctx, void* data, size_t byte_length) {
+  LOCAL_CONTEXT(ctx);
+  RtnValue rtn = {};
+  std::shared_ptr<ArrayBufferAllocator>& allocator =
+      isolateData(iso)->allocator;
+  if (!allocator->Adopt(byte_length)) {
+    free(data);
+    rtn.error.msg = CopyString("Array buffer allocation failed");
+    return rtn;
+  }
+  std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+      data, byte_length, FreeAdoptedBackingStore,
+      new std::shared_ptr<ArrayBufferAllocator>(allocator));
+  rtn.value = tracked_value(ctx, ArrayBuffer::New(iso, std::move(store)));
+  return rtn;
 }
 
-int ValueIsUint8ClampedArray(ValuePtr ptr) {
+ArrayBufferContents ValueArrayBufferContents(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsUint8ClampedArray();
+  ArrayBufferContents rtn = {};
+  if (value->IsArrayBuffer()) {
+    std::shared_ptr<BackingStore> store =
+        value.As<ArrayBuffer>()->GetBackingStore();
+    rtn.data = store->Data();
+    rtn.byteLength = store->ByteLength();
+  } else if (value->IsSharedArrayBuffer()) {
+    std::shared_ptr<BackingStore> store =
+        value.As<SharedArrayBuffer>()->GetBackingStore();
+    rtn.data = store->Data();
+    rtn.byteLength = store->ByteLength();
+  } else if (value->IsArrayBufferView()) {
+    // Buffer() moves the contents of small typed arrays off the JS heap, where
+    // they could otherwise be moved by the GC.
+    Local<ArrayBufferView> view = value.As<ArrayBufferView>();
+    std::shared_ptr<BackingStore> store = view->Buffer()->GetBackingStore();
+    rtn.data = static_cast<char*>(store->Data()) + view->ByteOffset();
+    rtn.byteLength = view->ByteLength();
+  }
+  return rtn;
 }
 
-int ValueIsInt8Array(ValuePtr ptr) {
+ValuePtr ArrayBufferViewBuffer(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsInt8Array();
+  return tracked_value(ctx, value.As<ArrayBufferView>()->Buffer());
 }
 
-int ValueIsUint16Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsUint16Array();
+BackingStorePtr NewSharedBackingStore(const void* data, size_t byte_length) {
+  void* mem = data ? malloc(byte_length) : calloc(byte_length, 1);
+  if (mem == nullptr && byte_length > 0) {
+    return nullptr;
+  }
+  if (data) {
+    memcpy(mem, data, byte_length);
+  }
+  m_backingStore* store = new m_backingStore;
+  store->ptr = SharedArrayBuffer::NewBackingStore(mem, byte_length,
+                                                  FreeBackingStore, nullptr);
+  return store;
 }
 
-int ValueIsInt16Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsInt16Array();
+ArrayBufferContents BackingStoreContents(BackingStorePtr ptr) {
+  return ArrayBufferContents{ptr->ptr->Data(), ptr->ptr->ByteLength()};
 }
 
-int ValueIsUint32Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsUint32Array();
+void BackingStoreRelease(BackingStorePtr ptr) {
+  // The memory itself is freed once the last SharedArrayBuffer on it is gone.
+  delete ptr;
 }
 
-int ValueIsInt32Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsInt32Array();
+ValuePtr NewSharedArrayBuffer(ContextPtr ctx, BackingStorePtr ptr) {
+  LOCAL_CONTEXT(ctx);
+  return tracked_value(ctx, SharedArrayBuffer::New(iso, ptr->ptr));
 }
 
-int ValueIsFloat32Array(ValuePtr ptr) {
+BackingStorePtr SharedArrayBufferBackingStore(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
-  return value->IsFloat32Array();
+  m_backingStore* store = new m_backingStore;
+  store->ptr = value.As<SharedArrayBuffer>()->GetBackingStore();
+  return store;
+}
+
+/********** TextEncoder & TextDecoder **********/
+
+// The operations of TextCodingCallback, which is the callback of every
+// function of TextEncoder and TextDecoder, by its data.
+enum TextCodingOp {
+  TEXT_ENCODER_NEW,
+  TEXT_ENCODER_ENCODE,
+  TEXT_ENCODER_ENCODE_INTO,
+  TEXT_DECODER_NEW,
+  TEXT_DECODER_DECODE,
+  TEXT_CODING_ENCODING,
+  TEXT_DECODER_FATAL,
+  TEXT_DECODER_IGNORE_BOM,
+};
+
+// The state of a TextDecoder, kept as a small integer in its internal field:
+// its options, whether the start of the stream has been decoded, past any
+// byte order mark, and the bytes at the end of the last chunk of a stream
+// that begin a character which the next chunk ends.
+static const uint32_t kDecoderFatal = 1;
+static const uint32_t kDecoderIgnoreBOM = 2;
+static const uint32_t kDecoderStarted = 4;
+static const int kDecoderPendingShift = 3;
+static const int kDecoderBytesShift = 5;
+
+// asciiPrefix returns the number of bytes at the start of p that are ASCII,
+// skipping 16 bytes at a time.
+static size_t asciiPrefix(const uint8_t* p, size_t n) {
+  size_t i = 0;
+  while (i + 16 <= n && asciiMask16(p + i) == 0) {
+    i += 16;
+  }
+  while (i < n && p[i] < 0x80) {
+    i++;
+  }
+  return i;
 }
 
-int ValueIsFloat64Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsFloat64Array();
+// utf8Lead returns the length of the sequence that the byte c starts, along
+// with the range of the byte after it, or 0 if c cannot start one; see
+// Table 3-7 of the Unicode Standard.
+static size_t utf8Lead(uint8_t c, uint8_t* lo, uint8_t* hi) {
+  *lo = 0x80;
+  *hi = 0xbf;
+  if (c >= 0xc2 && c <= 0xdf) {
+    return 2;
+  }
+  if (c >= 0xe0 && c <= 0xef) {
+    if (c == 0xe0) {
+      *lo = 0xa0;
+    } else if (c == 0xed) {
+      *hi = 0x9f;
+    }
+    return 3;
+  }
+  if (c >= 0xf0 && c <= 0xf4) {
+    if (c == 0xf0) {
+      *lo = 0x90;
+    } else if (c == 0xf4) {
+      *hi = 0x8f;
+    }
+    return 4;
+  }
+  return 0;
 }
 
-int ValueIsBigInt64Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsBigInt64Array();
+// utf8Valid returns whether the n bytes at p are well-formed UTF-8. Runs of
+// ASCII, which most text is made of, are checked 16 bytes at a time.
+static bool utf8Valid(const uint8_t* p, size_t n) {
+  size_t i = 0;
+  for (;;) {
+    i += asciiPrefix(p + i, n - i);
+    if (i == n) {
+      return true;
+    }
+    uint8_t lo, hi;
+    size_t len = utf8Lead(p[i], &lo, &hi);
+    if (len == 0 || n - i < len || p[i + 1] < lo || p[i + 1] > hi) {
+      return false;
+    }
+    for (size_t k = 2; k < len; k++) {
+      if ((p[i + k] & 0xc0) != 0x80) {
+        return false;
+      }
+    }
+    i += len;
+  }
 }
 
-int ValueIsBigUint64Array(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsBigUint64Array();
+// utf8Incomplete returns the number of bytes at the end of the n at p that
+// begin a well-formed sequence, but too few of them to end it.
+static size_t utf8Incomplete(const uint8_t* p, size_t n) {
+  for (size_t k = 1; k <= 3 && k <= n; k++) {
+    uint8_t c = p[n - k];
+    if ((c & 0xc0) == 0x80) {
+      continue;
+    }
+    uint8_t lo, hi;
+    size_t len = utf8Lead(c, &lo, &hi);
+    if (len <= k || (k > 1 && (p[n - k + 1] < lo || p[n - k + 1] > hi))) {
+      return 0;
+    }
+    return k;
+  }
+  return 0;
+}
+
+// bufferSourceBytes sets data and length to the bytes of value, which is an
+// ArrayBuffer, a SharedArrayBuffer or a view of either, and returns false for
+// any other value.
+static bool bufferSourceBytes(Local<Value> value,
+                              const uint8_t** data,
+                              size_t* length) {
+  std::shared_ptr<BackingStore> store;
+  size_t offset = 0;
+  if (value->IsArrayBuffer()) {
+    store = value.As<ArrayBuffer>()->GetBackingStore();
+    *length = store->ByteLength();
+  } else if (value->IsSharedArrayBuffer()) {
+    store = value.As<SharedArrayBuffer>()->GetBackingStore();
+    *length = store->ByteLength();
+  } else if (value->IsArrayBufferView()) {
+    // Buffer() moves the contents of small typed arrays off the JS heap.
+    Local<ArrayBufferView> view = value.As<ArrayBufferView>();
+    store = view->Buffer()->GetBackingStore();
+    offset = view->ByteOffset();
+    *length = view->ByteLength();
+  } else {
+    return false;
+  }
+  *data = static_cast<const uint8_t*>(store->Data()) + offset;
+  return true;
 }
 
-int ValueIsDataView(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsDataView();
+static void throwTextCoding(Isolate* iso,
+                            Local<Value> (*error)(Local<String>),
+                            const char* message) {
+  iso->ThrowException(error(String::NewFromUtf8(iso, message).ToLocalChecked()));
 }
 
-int ValueIsSharedArrayBuffer(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsSharedArrayBuffer();
+// textEncode encodes str into a new Uint8Array. One-byte strings are copied
+// as they are, which is their UTF-8 if they are ASCII, and widened otherwise,
+// rather than transcoded a character at a time by V8.
+static void textEncode(const FunctionCallbackInfo<Value>& info,
+                       Local<String> str) {
+  Isolate* iso = info.GetIsolate();
+  std::shared_ptr<ArrayBufferAllocator>& allocator =
+      isolateData(iso)->allocator;
+  size_t length = str->Length();
+  size_t utf8_length = length;
+  void* mem = nullptr;
+  if (str->IsOneByte()) {
+    mem = allocator->AllocateUninitialized(length);
+    if (mem != nullptr) {
+      str->WriteOneByte(iso, static_cast<uint8_t*>(mem), 0, length,
+                        String::NO_NULL_TERMINATION);
+      utf8_length +=
+          countNonASCII(static_cast<const uint8_t*>(mem), length);
+    }
+    if (mem != nullptr && utf8_length > length) {
+      void* wide = allocator->AllocateUninitialized(utf8_length);
+      if (wide != nullptr) {
+        memcpy(wide, mem, length);
+        widenLatin1(static_cast<char*>(wide), length, utf8_length);
+      }
+      allocator->Free(mem, length);
+      mem = wide;
+    }
+  } else {
+    utf8_length = str->Utf8Length(iso);
+    mem = allocator->AllocateUninitialized(utf8_length);
+    if (mem != nullptr) {
+      str->WriteUtf8(iso, static_cast<char*>(mem), utf8_length, nullptr,
+                     String::NO_NULL_TERMINATION |
+                         String::REPLACE_INVALID_UTF8);
+    }
+  }
+  if (mem == nullptr && utf8_length > 0) {
+    throwTextCoding(iso, Exception::RangeError,
+                    "Array buffer allocation failed");
+    return;
+  }
+  std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+      mem, utf8_length, FreeAllocatorBackingStore,
+      new std::shared_ptr<ArrayBufferAllocator>(allocator));
+  Local<ArrayBuffer> buffer = ArrayBuffer::New(iso, std::move(store));
+  info.GetReturnValue().Set(Uint8Array::New(buffer, 0, utf8_length));
+}
+
+// textEncodeInto writes as much of str as fits into the Uint8Array dst, and
+// returns how many UTF-16 code units it read and bytes it wrote.
+static void textEncodeInto(const FunctionCallbackInfo<Value>& info,
+                           Local<String> str,
+                           Local<Value> dst) {
+  Isolate* iso = info.GetIsolate();
+  Local<Context> local_ctx = iso->GetCurrentContext();
+  if (!dst->IsUint8Array()) {
+    throwTextCoding(iso, Exception::TypeError,
+                    "The \"dest\" argument must be a Uint8Array");
+    return;
+  }
+  const uint8_t* data;
+  size_t length;
+  bufferSourceBytes(dst, &data, &length);
+  int read = 0;
+  int written = str->WriteUtf8(
+      iso, reinterpret_cast<char*>(const_cast<uint8_t*>(data)),
+      static_cast<int>(std::min<size_t>(length, INT_MAX)), &read,
+      String::NO_NULL_TERMINATION | String::REPLACE_INVALID_UTF8);
+  Local<Object> result = Object::New(iso);
+  result->Set(local_ctx, String::NewFromUtf8Literal(iso, "read"),
+              Integer::New(iso, read))
+      .Check();
+  result->Set(local_ctx, String::NewFromUtf8Literal(iso, "written"),
+              Integer::New(iso, written))
+      .Check();
+  info.GetReturnValue().Set(result);
+}
+
+// textDecoderNew initializes a TextDecoder from its label and options; only
+// the labels of UTF-8 are supported.
+static void textDecoderNew(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  Local<Context> local_ctx = iso->GetCurrentContext();
+  if (!info[0]->IsUndefined()) {
+    Local<String> label;
+    if (!info[0]->ToString(local_ctx).ToLocal(&label)) {
+      return;
+    }
+    String::Utf8Value utf8(iso, label);
+    std::string name(*utf8, utf8.length());
+    size_t start = name.find_first_not_of(" \t\n\f\r");
+    size_t end = name.find_last_not_of(" \t\n\f\r");
+    name = start == std::string::npos ? "" : name.substr(start, end - start + 1);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](char c) { return c >= 'A' && c <= 'Z' ? c + 32 : c; });
+    static const char* labels[] = {"utf-8",          "utf8",
+                                   "unicode-1-1-utf-8", "unicode11utf8",
+                                   "unicode20utf8",  "x-unicode20utf8"};
+    if (std::find(std::begin(labels), std::end(labels), name) ==
+        std::end(labels)) {
+      std::string message =
+          "The encoding label provided ('" + std::string(*utf8) +
+          "') is not supported";
+      throwTextCoding(iso, Exception::RangeError, message.c_str());
+      return;
+    }
+  }
+  uint32_t state = 0;
+  if (info[1]->IsObject()) {
+    Local<Object> options = info[1].As<Object>();
+    Local<Value> fatal, ignore_bom;
+    if (!options->Get(local_ctx, String::NewFromUtf8Literal(iso, "fatal"))
+             .ToLocal(&fatal) ||
+        !options->Get(local_ctx, String::NewFromUtf8Literal(iso, "ignoreBOM"))
+             .ToLocal(&ignore_bom)) {
+      return;
+    }
+    state |= fatal->BooleanValue(iso) ? kDecoderFatal : 0;
+    state |= ignore_bom->BooleanValue(iso) ? kDecoderIgnoreBOM : 0;
+  }
+  info.This()->SetInternalField(0, Integer::NewFromUnsigned(iso, state));
 }
 
-int ValueIsProxy(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsProxy();
+// textDecode decodes the bytes of input, after the pending bytes of the last
+// chunk, into a string. Unless the call streams, the decoder is reset.
+static void textDecode(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  Local<Context> local_ctx = iso->GetCurrentContext();
+  Local<Object> self = info.This();
+  uint32_t state = self->GetInternalField(0).As<Uint32>()->Value();
+
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  if (!info[0]->IsUndefined() &&
+      !bufferSourceBytes(info[0], &data, &length)) {
+    throwTextCoding(iso, Exception::TypeError,
+                    "The \"input\" argument must be an ArrayBuffer or "
+                    "ArrayBufferView");
+    return;
+  }
+  bool stream = false;
+  if (info[1]->IsObject()) {
+    Local<Value> value;
+    if (!info[1]
+             .As<Object>()
+             ->Get(local_ctx, String::NewFromUtf8Literal(iso, "stream"))
+             .ToLocal(&value)) {
+      return;
+    }
+    stream = value->BooleanValue(iso);
+  }
+
+  // Only the pending bytes, at most three, and the input are joined, which
+  // is rare enough to copy.
+  std::string joined;
+  size_t pending = (state >> kDecoderPendingShift) & 3;
+  if (pending > 0) {
+    joined.reserve(pending + length);
+    for (size_t i = 0; i < pending; i++) {
+      joined.push_back(
+          static_cast<char>(state >> (kDecoderBytesShift + 8 * i)));
+    }
+    joined.append(reinterpret_cast<const char*>(data), length);
+    data = reinterpret_cast<const uint8_t*>(joined.data());
+    length = joined.size();
+  }
+  size_t tail = stream ? utf8Incomplete(data, length) : 0;
+  size_t n = length - tail;
+
+  uint32_t next = state & (kDecoderFatal | kDecoderIgnoreBOM | kDecoderStarted);
+  if (!(state & kDecoderStarted) && n > 0) {
+    if (!(state & kDecoderIgnoreBOM) && n >= 3 && data[0] == 0xef &&
+        data[1] == 0xbb && data[2] == 0xbf) {
+      data += 3;
+      n -= 3;
+    }
+    next |= kDecoderStarted;
+  }
+  if (!stream) {
+    next &= kDecoderFatal | kDecoderIgnoreBOM;
+  } else {
+    next |= tail << kDecoderPendingShift;
+    for (size_t i = 0; i < tail; i++) {
+      next |= uint32_t(data[n + i]) << (kDecoderBytesShift + 8 * i);
+    }
+  }
+
+  if ((state & kDecoderFatal) && !utf8Valid(data, n)) {
+    self->SetInternalField(
+        0, Integer::NewFromUnsigned(
+               iso, state & (kDecoderFatal | kDecoderIgnoreBOM)));
+    throwTextCoding(iso, Exception::TypeError,
+                    "The encoded data was not valid for encoding utf-8");
+    return;
+  }
+  self->SetInternalField(0, Integer::NewFromUnsigned(iso, next));
+
+  // ASCII is copied as Latin-1, without V8 decoding it. Malformed sequences
+  // are decoded by V8 to U+FFFD, each maximal subpart of one to its own.
+  Local<String> str;
+  if (n > static_cast<size_t>(String::kMaxLength) ||
+      !(asciiPrefix(data, n) == n
+            ? String::NewFromOneByte(iso, data, NewStringType::kNormal, n)
+            : String::NewFromUtf8(iso, reinterpret_cast<const char*>(data),
+                                  NewStringType::kNormal, n))
+           .ToLocal(&str)) {
+    throwTextCoding(iso, Exception::RangeError, "Invalid string length");
+    return;
+  }
+  info.GetReturnValue().Set(str);
 }
 
-int ValueIsWasmModuleObject(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsWasmModuleObject();
+static void TextCodingCallback(const FunctionCallbackInfo<Value>& info) {
+  Isolate* iso = info.GetIsolate();
+  Local<Context> local_ctx = iso->GetCurrentContext();
+  TextCodingOp op =
+      static_cast<TextCodingOp>(info.Data().As<Integer>()->Value());
+  switch (op) {
+    case TEXT_ENCODER_NEW:
+    case TEXT_DECODER_NEW:
+      if (!info.IsConstructCall()) {
+        throwTextCoding(iso, Exception::TypeError,
+                        "Class constructor cannot be invoked without 'new'");
+        return;
+      }
+      if (op == TEXT_DECODER_NEW) {
+        textDecoderNew(info);
+      }
+      return;
+    case TEXT_ENCODER_ENCODE:
+    case TEXT_ENCODER_ENCODE_INTO: {
+      Local<String> str = String::Empty(iso);
+      if (!info[0]->IsUndefined() &&
+          !info[0]->ToString(local_ctx).ToLocal(&str)) {
+        return;
+      }
+      if (op == TEXT_ENCODER_ENCODE) {
+        textEncode(info, str);
+      } else {
+        textEncodeInto(info, str, info[1]);
+      }
+      return;
+    }
+    case TEXT_DECODER_DECODE:
+      textDecode(info);
+      return;
+    case TEXT_CODING_ENCODING:
+      info.GetReturnValue().Set(String::NewFromUtf8Literal(iso, "utf-8"));
+      return;
+    case TEXT_DECODER_FATAL:
+    case TEXT_DECODER_IGNORE_BOM: {
+      uint32_t state = info.This()->GetInternalField(0).As<Uint32>()->Value();
+      uint32_t flag =
+          op == TEXT_DECODER_FATAL ? kDecoderFatal : kDecoderIgnoreBOM;
+      info.GetReturnValue().Set((state & flag) != 0);
+      return;
+    }
+  }
 }
 
-int ValueIsModuleNamespaceObject(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  return value->IsModuleNamespaceObject();
+// newTextCodingClass creates the template of the class name, whose methods
+// and getters call TextCodingCallback with the ops given by name.
+static Local<FunctionTemplate> newTextCodingClass(
+    Isolate* iso,
+    const char* name,
+    TextCodingOp ctor,
+    std::initializer_list<std::pair<const char*, TextCodingOp>> methods,
+    std::initializer_list<std::pair<const char*, TextCodingOp>> getters) {
+  Local<FunctionTemplate> tmpl = FunctionTemplate::New(
+      iso, TextCodingCallback, Integer::New(iso, ctor));
+  tmpl->SetClassName(String::NewFromUtf8(iso, name).ToLocalChecked());
+  tmpl->InstanceTemplate()->SetInternalFieldCount(1);
+  Local<Signature> signature = Signature::New(iso, tmpl);
+  Local<ObjectTemplate> proto = tmpl->PrototypeTemplate();
+  for (auto& m : methods) {
+    Local<FunctionTemplate> fn = FunctionTemplate::New(
+        iso, TextCodingCallback, Integer::New(iso, m.second), signature, 0,
+        ConstructorBehavior::kThrow);
+    proto->Set(iso, m.first, fn);
+  }
+  for (auto& g : getters) {
+    Local<FunctionTemplate> fn = FunctionTemplate::New(
+        iso, TextCodingCallback, Integer::New(iso, g.second), signature, 0,
+        ConstructorBehavior::kThrow);
+    proto->SetAccessorProperty(
+        String::NewFromUtf8(iso, g.first, NewStringType::kInternalized)
+            .ToLocalChecked(),
+        fn);
+  }
+  return tmpl;
 }
 
-/********** Exception **********/
-
-const char* ExceptionGetMessageString(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
+void ContextInstallTextCoding(ContextPtr ctx) {
+  LOCAL_CONTEXT(ctx);
+  m_isolate* data = isolateData(iso);
+  if (data->textEncoder.IsEmpty()) {
+    data->textEncoder.Reset(
+        iso, newTextCodingClass(
+                 iso, "TextEncoder", TEXT_ENCODER_NEW,
+                 {{"encode", TEXT_ENCODER_ENCODE},
+                  {"encodeInto", TEXT_ENCODER_ENCODE_INTO}},
+                 {{"encoding", TEXT_CODING_ENCODING}}));
+    data->textDecoder.Reset(
+        iso, newTextCodingClass(iso, "TextDecoder", TEXT_DECODER_NEW,
+                                {{"decode", TEXT_DECODER_DECODE}},
+                                {{"encoding", TEXT_CODING_ENCODING},
+                                 {"fatal", TEXT_DECODER_FATAL},
+                                 {"ignoreBOM", TEXT_DECODER_IGNORE_BOM}}));
+  }
+  Local<Object> global = local_ctx->Global();
+  global
+      ->Set(local_ctx, String::NewFromUtf8Literal(iso, "TextEncoder"),
+            data->textEncoder.Get(iso)->GetFunction(local_ctx).ToLocalChecked())
+      .Check();
+  global
+      ->Set(local_ctx, String::NewFromUtf8Literal(iso, "TextDecoder"),
+            data->textDecoder.Get(iso)->GetFunction(local_ctx).ToLocalChecked())
+      .Check();
+}
+
+/********** Serializer **********/
+
+RtnSerialized ContextSerialize(ContextPtr ctx,
+                               ValuePtr val,
+                               ValuePtr* transfers,
+                               int transfers_count) {
+  LOCAL_CONTEXT(ctx);
+  RtnSerialized rtn = {};
+  std::unique_ptr<m_serialized> out(new m_serialized);
+  SerializerDelegate delegate(iso, out.get());
+  ValueSerializer serializer(iso, &delegate);
+
+  std::vector<Local<ArrayBuffer>> buffers;
+  for (int i = 0; i < transfers_count; i++) {
+    Local<ArrayBuffer> ab = transfers[i]->ptr.Get(iso).As<ArrayBuffer>();
+    if (!ab->IsDetachable() ||
+        std::find(buffers.begin(), buffers.end(), ab) != buffers.end()) {
+      delegate.ThrowDataCloneError(String::NewFromUtf8Literal(
+          iso, "ArrayBuffer cannot be transferred"));
+      rtn.error = ExceptionError(try_catch, iso, local_ctx);
+      return rtn;
+    }
+    serializer.TransferArrayBuffer(i, ab);
+    buffers.push_back(ab);
+  }
 
-  Local<Message> local_msg = Exception::CreateMessage(iso, value);
-  Local<String> local_str = local_msg->Get();
-  String::Utf8Value utf8(iso, local_str);
-  return CopyString(utf8);
+  serializer.WriteHeader();
+  if (serializer.WriteValue(local_ctx, val->ptr.Get(iso)).IsNothing()) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  std::pair<uint8_t*, size_t> data = serializer.Release();
+  out->data.assign(data.first, data.first + data.second);
+  free(data.first);
+
+  // The memory moves from the buffers to the serialized value, leaving them
+  // detached.
+  for (Local<ArrayBuffer> ab : buffers) {
+    out->transfers.push_back(ab->GetBackingStore());
+    ab->Detach();
+  }
+  rtn.ptr = out.release();
+  return rtn;
 }
 
-/********** Object **********/
+RtnValue ContextDeserialize(ContextPtr ctx, SerializedPtr ptr) {
+  LOCAL_CONTEXT(ctx);
+  RtnValue rtn = {};
+  DeserializerDelegate delegate(ptr);
+  ValueDeserializer deserializer(iso, ptr->data.data(), ptr->data.size(),
+                                 &delegate);
+  for (size_t i = 0; i < ptr->transfers.size(); i++) {
+    if (ptr->transfers[i] != nullptr) {
+      deserializer.TransferArrayBuffer(
+          i, ArrayBuffer::New(iso, std::move(ptr->transfers[i])));
+    }
+  }
 
-#define LOCAL_OBJECT(ptr) \
-  LOCAL_VALUE(ptr)        \
-  Local<Object> obj = value.As<Object>()
+  Local<Value> result;
+  if (deserializer.ReadHeader(local_ctx).IsNothing() ||
+      !deserializer.ReadValue(local_ctx).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
+}
 
-void ObjectSet(ValuePtr ptr, const char* key, ValuePtr prop_val) {
-  LOCAL_OBJECT(ptr);
-  Local<String> key_val =
-      String::NewFromUtf8(iso, key, NewStringType::kNormal).ToLocalChecked();
-  obj->Set(local_ctx, key_val, prop_val->ptr.Get(iso)).Check();
+SerializedPtr NewSerialized(const void* data, size_t length) {
+  m_serialized* ptr = new m_serialized;
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  ptr->data.assign(bytes, bytes + length);
+  return ptr;
 }
 
-void ObjectSetAnyKey(ValuePtr ptr, ValuePtr key, ValuePtr prop_val) {
-  LOCAL_OBJECT(ptr);
-  Local<Value> local_key = key->ptr.Get(iso);
-  obj->Set(local_ctx, local_key, prop_val->ptr.Get(iso)).Check();
+ArrayBufferContents SerializedData(SerializedPtr ptr) {
+  return ArrayBufferContents{ptr->data.data(), ptr->data.size()};
 }
 
-void ObjectSetIdx(ValuePtr ptr, uint32_t idx, ValuePtr prop_val) {
-  LOCAL_OBJECT(ptr);
-  obj->Set(local_ctx, idx, prop_val->ptr.Get(iso)).Check();
+void SerializedRelease(SerializedPtr ptr) {
+  delete ptr;
 }
 
-int ObjectSetInternalField(ValuePtr ptr, int idx, ValuePtr val_ptr) {
-  LOCAL_OBJECT(ptr);
-  m_value* prop_val = static_cast<m_value*>(val_ptr);
+/********** WebAssembly **********/
 
-  if (idx >= obj->InternalFieldCount()) {
-    return 0;
+// wasmFunction gets WebAssembly[name] of the context, throwing if the
+// context has no such function.
+static MaybeLocal<Function> wasmFunction(Isolate* iso,
+                                         Local<Context> local_ctx,
+                                         const char* name) {
+  Local<Value> wasm, fn;
+  if (!local_ctx->Global()
+           ->Get(local_ctx, String::NewFromUtf8Literal(iso, "WebAssembly"))
+           .ToLocal(&wasm)) {
+    return MaybeLocal<Function>();
   }
-
-  obj->SetInternalField(idx, prop_val->ptr.Get(iso));
-
-  return 1;
-}
-
-int ObjectInternalFieldCount(ValuePtr ptr) {
-  LOCAL_OBJECT(ptr);
-  return obj->InternalFieldCount();
+  if (wasm->IsObject() &&
+      !wasm.As<Object>()
+           ->Get(local_ctx, String::NewFromUtf8(iso, name).ToLocalChecked())
+           .ToLocal(&fn)) {
+    return MaybeLocal<Function>();
+  }
+  if (fn.IsEmpty() || !fn->IsFunction()) {
+    iso->ThrowException(Exception::TypeError(String::NewFromUtf8Literal(
+        iso, "WebAssembly is not available in the context")));
+    return MaybeLocal<Function>();
+  }
+  return fn.As<Function>();
 }
 
-RtnValue ObjectGet(ValuePtr ptr, const char* key) {
-  LOCAL_OBJECT(ptr);
+RtnValue ContextCompileWasmModule(ContextPtr ctx,
+                                  const void* data,
+                                  size_t length) {
+  LOCAL_CONTEXT(ctx);
   RtnValue rtn = {};
-
-  Local<String> key_val;
-  if (!String::NewFromUtf8(iso, key, NewStringType::kNormal)
-           .ToLocal(&key_val)) {
+  Local<Function> ctor;
+  if (!wasmFunction(iso, local_ctx, "Module").ToLocal(&ctor)) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  Local<Value> result;
-  if (!obj->Get(local_ctx, key_val).ToLocal(&result)) {
+  // The bytes are copied by the constructor, so the buffer only borrows them
+  // for the call.
+  Local<ArrayBuffer> ab = ArrayBuffer::New(
+      iso, ArrayBuffer::NewBackingStore(const_cast<void*>(data), length,
+                                        BackingStore::EmptyDeleter, nullptr));
+  Local<Value> argv[] = {ab};
+  MaybeLocal<Object> result = ctor->NewInstance(local_ctx, 1, argv);
+  ab->Detach();
+  Local<Object> module;
+  if (!result.ToLocal(&module)) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* new_val = new m_value;
-  new_val->iso = iso;
-  new_val->ctx = ctx;
-  new_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-
-  rtn.value = tracked_value(ctx, new_val);
+  rtn.value = tracked_value(ctx, module);
   return rtn;
 }
 
-RtnValue ObjectGetAnyKey(ValuePtr ptr, ValuePtr key) {
-  LOCAL_OBJECT(ptr);
-  RtnValue rtn = {nullptr, nullptr};
+RtnWasmStream ContextNewWasmStream(ContextPtr ctx,
+                                   const void* cache,
+                                   size_t cache_length) {
+  LOCAL_CONTEXT(ctx);
+  RtnWasmStream rtn = {};
+  Local<Function> compile;
+  if (!wasmFunction(iso, local_ctx, "compileStreaming").ToLocal(&compile)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
 
-  Local<Value> local_key = key->ptr.Get(iso);
+  m_isolate* data = isolateData(iso);
+  std::unique_ptr<m_wasmStream> stream(new m_wasmStream);
+  stream->ctx = ctx;
+  const uint8_t* bytes = static_cast<const uint8_t*>(cache);
+  stream->cache.assign(bytes, bytes + cache_length);
+  stream->cacheAccepted = false;
+  uint32_t id = ++data->wasmStreamSeq;
+  data->wasmStreams[id] = stream.get();
+  Local<Value> argv[] = {Integer::NewFromUnsigned(iso, id)};
   Local<Value> result;
-  if (!obj->Get(local_ctx, local_key).ToLocal(&result)) {
+  if (!compile->Call(local_ctx, Undefined(iso), 1, argv).ToLocal(&result) ||
+      !result->IsPromise()) {
+    data->wasmStreams.erase(id);
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* new_val = new m_value;
-  new_val->iso = iso;
-  new_val->ctx = ctx;
-  new_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-
-  rtn.value = tracked_value(ctx, new_val);
+  // StreamWasmModule runs in a microtask.
+  performContextCheckpoint(ctx);
+  if (data->wasmStreams.erase(id) > 0) {
+    iso->ThrowException(Exception::Error(String::NewFromUtf8Literal(
+        iso, "WebAssembly.compileStreaming did not start the compilation")));
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  stream->promise.Reset(iso, result.As<Promise>());
+  rtn.promise = tracked_value(ctx, result);
+  rtn.ptr = stream.release();
   return rtn;
 }
 
-ValuePtr ObjectGetInternalField(ValuePtr ptr, int idx) {
-  LOCAL_OBJECT(ptr);
-
-  if (idx >= obj->InternalFieldCount()) {
-    return nullptr;
+void WasmStreamWrite(WasmStreamPtr ptr, const void* data, size_t length) {
+  m_ctx* ctx = ptr->ctx;
+  LOCAL_CONTEXT(ctx);
+  ptr->streaming->OnBytesReceived(static_cast<const uint8_t*>(data), length);
+  // The tasks that the compilation of the bytes received so far posted.
+  while (platform::PumpMessageLoop(default_platform.get(), iso)) {
   }
-
-  Local<Value> result = obj->GetInternalField(idx);
-
-  m_value* new_val = new m_value;
-  new_val->iso = iso;
-  new_val->ctx = ctx;
-  new_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-
-  return tracked_value(ctx, new_val);
 }
 
-RtnValue ObjectGetIdx(ValuePtr ptr, uint32_t idx) {
-  LOCAL_OBJECT(ptr);
+RtnValue WasmStreamFinish(WasmStreamPtr ptr, int* cache_accepted) {
+  std::unique_ptr<m_wasmStream> stream(ptr);
+  m_ctx* ctx = stream->ctx;
+  LOCAL_CONTEXT(ctx);
   RtnValue rtn = {};
-
-  Local<Value> result;
-  if (!obj->Get(local_ctx, idx).ToLocal(&result)) {
+  stream->streaming->Finish();
+
+  // The module is compiled, or its code deserialized, by tasks that settle
+  // the promise.
+  Local<Promise> promise = stream->promise.Get(iso);
+  while (promise->State() == Promise::kPending &&
+         !iso->IsExecutionTerminating()) {
+    if (!platform::PumpMessageLoop(default_platform.get(), iso)) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    performContextCheckpoint(ctx);
+  }
+  *cache_accepted = stream->cacheAccepted;
+  if (promise->State() == Promise::kPending) {
+    rtn.error.msg =
+        CopyString("ExecutionTerminated: script execution has been terminated");
+    return rtn;
+  }
+  if (promise->State() == Promise::kRejected) {
+    iso->ThrowException(promise->Result());
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* new_val = new m_value;
-  new_val->iso = iso;
-  new_val->ctx = ctx;
-  new_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-
-  rtn.value = tracked_value(ctx, new_val);
+  rtn.value = tracked_value(ctx, promise->Result());
   return rtn;
 }
 
-int ObjectHas(ValuePtr ptr, const char* key) {
-  LOCAL_OBJECT(ptr);
-  Local<String> key_val =
-      String::NewFromUtf8(iso, key, NewStringType::kNormal).ToLocalChecked();
-  return obj->Has(local_ctx, key_val).ToChecked();
+void WasmStreamAbort(WasmStreamPtr ptr, ValuePtr exception) {
+  std::unique_ptr<m_wasmStream> stream(ptr);
+  m_ctx* ctx = stream->ctx;
+  LOCAL_CONTEXT(ctx);
+  stream->streaming->Abort(exception->ptr.Get(iso));
+  performContextCheckpoint(ctx);
 }
 
-int ObjectHasAnyKey(ValuePtr ptr, ValuePtr key) {
-  LOCAL_OBJECT(ptr);
-  Local<Value> local_key = key->ptr.Get(iso);
-  return obj->Has(local_ctx, local_key).ToChecked();
+CompiledWasmModulePtr WasmModuleObjectGetCompiledModule(ValuePtr ptr) {
+  LOCAL_VALUE(ptr);
+  return new m_compiledWasmModule{
+      value.As<WasmModuleObject>()->GetCompiledModule()};
 }
 
-int ObjectHasIdx(ValuePtr ptr, uint32_t idx) {
-  LOCAL_OBJECT(ptr);
-  return obj->Has(local_ctx, idx).ToChecked();
+RtnValue NewWasmModuleObject(ContextPtr ctx, CompiledWasmModulePtr ptr) {
+  LOCAL_CONTEXT(ctx);
+  RtnValue rtn = {};
+  Local<WasmModuleObject> module;
+  if (!WasmModuleObject::FromCompiledModule(iso, ptr->module)
+           .ToLocal(&module)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, module);
+  return rtn;
 }
 
-int ObjectDelete(ValuePtr ptr, const char* key) {
-  LOCAL_OBJECT(ptr);
-  Local<String> key_val =
-      String::NewFromUtf8(iso, key, NewStringType::kNormal).ToLocalChecked();
-  return obj->Delete(local_ctx, key_val).ToChecked();
+ArrayBufferContents CompiledWasmModuleWireBytes(CompiledWasmModulePtr ptr) {
+  MemorySpan<const uint8_t> bytes = ptr->module.GetWireBytesRef();
+  return ArrayBufferContents{const_cast<uint8_t*>(bytes.data()),
+                             bytes.size()};
 }
 
-int ObjectDeleteAnyKey(ValuePtr ptr, ValuePtr key) {
-  LOCAL_OBJECT(ptr);
-  Local<Value> local_key = key->ptr.Get(iso);
-  return obj->Delete(local_ctx, local_key).ToChecked();
+ArrayBufferContents CompiledWasmModuleSerialize(CompiledWasmModulePtr ptr) {
+  OwnedBuffer buffer = ptr->module.Serialize();
+  void* data = malloc(buffer.size);
+  memcpy(data, buffer.buffer.get(), buffer.size);
+  return ArrayBufferContents{data, buffer.size};
 }
 
-int ObjectDeleteIdx(ValuePtr ptr, uint32_t idx) {
-  LOCAL_OBJECT(ptr);
-  return obj->Delete(local_ctx, idx).ToChecked();
+void CompiledWasmModuleRelease(CompiledWasmModulePtr ptr) {
+  delete ptr;
 }
 
-/********** Symbol **********/
-
-ValuePtr BuiltinSymbol(IsolatePtr iso, SymbolIndex idx) {
-  ISOLATE_SCOPE_INTERNAL_CONTEXT(iso);
-  Local<Symbol> sym;
-  switch (idx) {
-  case SYMBOL_ASYNC_ITERATOR:
-    sym = Symbol::GetAsyncIterator(iso);
-    break;
-  case SYMBOL_HAS_INSTANCE:
-    sym = Symbol::GetHasInstance(iso);
-    break;
-  case SYMBOL_IS_CONCAT_SPREADABLE:
-    sym = Symbol::GetIsConcatSpreadable(iso);
-    break;
-  case SYMBOL_ITERATOR:
-    sym = Symbol::GetIterator(iso);
-    break;
-  case SYMBOL_MATCH:
-    sym = Symbol::GetMatch(iso);
-    break;
-  case SYMBOL_REPLACE:
-    sym = Symbol::GetReplace(iso);
-    break;
-  case SYMBOL_SEARCH:
-    sym = Symbol::GetSearch(iso);
-    break;
-  case SYMBOL_SPLIT:
-    sym = Symbol::GetSplit(iso);
-    break;
-  case SYMBOL_TO_PRIMITIVE:
-    sym = Symbol::GetToPrimitive(iso);
-    break;
-  case SYMBOL_TO_STRING_TAG:
-    sym = Symbol::GetToStringTag(iso);
-    break;
-  case SYMBOL_UNSCOPABLES:
-    sym = Symbol::GetUnscopables(iso);
-    break;
-  default:
-    return nullptr;
-  }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, sym);
-  return tracked_value(ctx, val);
-}
+/********** RegExp **********/
 
-const char* SymbolDescription(ValuePtr ptr) {
-  LOCAL_VALUE(ptr);
-  Local<Symbol> sym = value.As<Symbol>();
-  Local<Value> descr = sym->Description();
-  String::Utf8Value utf8(iso, descr);
-  return CopyString(utf8);
+RtnValue NewRegExp(ContextPtr ctx,
+                   StringArg pattern,
+                   int flags,
+                   uint32_t backtrack_limit) {
+  LOCAL_CONTEXT(ctx);
+  RtnValue rtn = {};
 
+  Local<String> src;
+  if (!NewString(iso, pattern).ToLocal(&src)) {
+    rtn.error.msg = CopyString("RangeError: Invalid string length");
+    return rtn;
+  }
+  RegExp::Flags f = static_cast<RegExp::Flags>(flags);
+  // NewWithBacktrackLimit CHECKs that it is given a limit, 0 being none.
+  MaybeLocal<RegExp> maybe =
+      backtrack_limit == 0
+          ? RegExp::New(local_ctx, src, f)
+          : RegExp::NewWithBacktrackLimit(local_ctx, src, f, backtrack_limit);
+  Local<RegExp> re;
+  if (!maybe.ToLocal(&re)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, re);
+  return rtn;
 }
 
 /********** Promise **********/
@@ -1595,11 +8774,7 @@ RtnValue NewPromiseResolver(ContextPtr ctx) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* val = new m_value;
-  val->iso = iso;
-  val->ctx = ctx;
-  val->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, resolver);
-  rtn.value = tracked_value(ctx, val);
+  rtn.value = tracked_value(ctx, resolver);
   return rtn;
 }
 
@@ -1607,12 +8782,7 @@ ValuePtr PromiseResolverGetPromise(ValuePtr ptr) {
   LOCAL_VALUE(ptr);
   Local<Promise::Resolver> resolver = value.As<Promise::Resolver>();
   Local<Promise> promise = resolver->GetPromise();
-  m_value* promise_val = new m_value;
-  promise_val->iso = iso;
-  promise_val->ctx = ctx;
-  promise_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, promise);
-  return tracked_value(ctx, promise_val);
+  return tracked_value(ctx, promise);
 }
 
 int PromiseResolverResolve(ValuePtr ptr, ValuePtr resolve_val) {
@@ -1627,20 +8797,84 @@ int PromiseResolverReject(ValuePtr ptr, ValuePtr reject_val) {
   return resolver->Reject(local_ctx, reject_val->ptr.Get(iso)).ToChecked();
 }
 
+int PromiseResolversSettle(ValuePtr* resolvers,
+                           ValuePtr* vals,
+                           int n,
+                           int reject) {
+  if (n == 0) {
+    return 0;
+  }
+  Isolate* iso = resolvers[0]->iso;
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  TryCatch try_catch(iso);
+  int settled = 0;
+  for (int i = 0; i < n; i++) {
+    HandleScope handle_scope(iso);
+    m_ctx* ctx = resolvers[i]->ctx;
+    if (ctx == nullptr) {
+      ctx = isolateInternalContext(iso);
+    }
+    Local<Context> local_ctx = ctx->ptr.Get(iso);
+    Context::Scope context_scope(local_ctx);
+    Local<Promise::Resolver> resolver =
+        resolvers[i]->ptr.Get(iso).As<Promise::Resolver>();
+    Local<Value> val = vals[i]->ptr.Get(iso);
+    Maybe<bool> done = reject ? resolver->Reject(local_ctx, val)
+                              : resolver->Resolve(local_ctx, val);
+    if (done.FromMaybe(false)) {
+      settled++;
+    }
+    if (try_catch.HasTerminated()) {
+      break;
+    }
+    try_catch.Reset();
+  }
+  return settled;
+}
+
+void PromiseStates(ValuePtr* promises, int n, int* states) {
+  if (n == 0) {
+    return;
+  }
+  Isolate* iso = promises[0]->iso;
+  LOCK_ISOLATE(iso);
+  Isolate::Scope isolate_scope(iso);
+  HandleScope handle_scope(iso);
+  for (int i = 0; i < n; i++) {
+    states[i] = promises[i]->ptr.Get(iso).As<Promise>()->State();
+  }
+}
+
 int PromiseState(ValuePtr ptr) {
   LOCAL_VALUE(ptr)
   Local<Promise> promise = value.As<Promise>();
   return promise->State();
 }
 
+// promiseContinuation returns a function that calls the Go callback
+// callback_ref, which is the context's dispatcher with the ref bound to it:
+// a bound function is much cheaper to create than a native function.
+static MaybeLocal<Function> promiseContinuation(m_ctx* ctx,
+                                                Local<Context> local_ctx,
+                                                int callback_ref) {
+  Isolate* iso = ctx->iso;
+  Local<Value> args[] = {Undefined(iso), Integer::New(iso, callback_ref)};
+  Local<Value> bound;
+  if (!ctx->continuationBind.Get(iso)
+           ->Call(local_ctx, ctx->continuationDispatch.Get(iso), 2, args)
+           .ToLocal(&bound)) {
+    return MaybeLocal<Function>();
+  }
+  return bound.As<Function>();
+}
+
 RtnValue PromiseThen(ValuePtr ptr, int callback_ref) {
   LOCAL_VALUE(ptr)
   RtnValue rtn = {};
   Local<Promise> promise = value.As<Promise>();
-  Local<Integer> cbData = Integer::New(iso, callback_ref);
   Local<Function> func;
-  if (!Function::New(local_ctx, FunctionTemplateCallback, cbData)
-           .ToLocal(&func)) {
+  if (!promiseContinuation(ctx, local_ctx, callback_ref).ToLocal(&func)) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
@@ -1649,12 +8883,7 @@ RtnValue PromiseThen(ValuePtr ptr, int callback_ref) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* result_val = new m_value;
-  result_val->iso = iso;
-  result_val->ctx = ctx;
-  result_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-  rtn.value = tracked_value(ctx, result_val);
+  rtn.value = tracked_value(ctx, result);
   return rtn;
 }
 
@@ -1662,16 +8891,14 @@ RtnValue PromiseThen2(ValuePtr ptr, int on_fulfilled_ref, int on_rejected_ref) {
   LOCAL_VALUE(ptr)
   RtnValue rtn = {};
   Local<Promise> promise = value.As<Promise>();
-  Local<Integer> onFulfilledData = Integer::New(iso, on_fulfilled_ref);
   Local<Function> onFulfilledFunc;
-  if (!Function::New(local_ctx, FunctionTemplateCallback, onFulfilledData)
+  if (!promiseContinuation(ctx, local_ctx, on_fulfilled_ref)
            .ToLocal(&onFulfilledFunc)) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  Local<Integer> onRejectedData = Integer::New(iso, on_rejected_ref);
   Local<Function> onRejectedFunc;
-  if (!Function::New(local_ctx, FunctionTemplateCallback, onRejectedData)
+  if (!promiseContinuation(ctx, local_ctx, on_rejected_ref)
            .ToLocal(&onRejectedFunc)) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
@@ -1682,12 +8909,7 @@ RtnValue PromiseThen2(ValuePtr ptr, int on_fulfilled_ref, int on_rejected_ref) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* result_val = new m_value;
-  result_val->iso = iso;
-  result_val->ctx = ctx;
-  result_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-  rtn.value = tracked_value(ctx, result_val);
+  rtn.value = tracked_value(ctx, result);
   return rtn;
 }
 
@@ -1695,10 +8917,8 @@ RtnValue PromiseCatch(ValuePtr ptr, int callback_ref) {
   LOCAL_VALUE(ptr)
   RtnValue rtn = {};
   Local<Promise> promise = value.As<Promise>();
-  Local<Integer> cbData = Integer::New(iso, callback_ref);
   Local<Function> func;
-  if (!Function::New(local_ctx, FunctionTemplateCallback, cbData)
-           .ToLocal(&func)) {
+  if (!promiseContinuation(ctx, local_ctx, callback_ref).ToLocal(&func)) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
@@ -1707,12 +8927,7 @@ RtnValue PromiseCatch(ValuePtr ptr, int callback_ref) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* result_val = new m_value;
-  result_val->iso = iso;
-  result_val->ctx = ctx;
-  result_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-  rtn.value = tracked_value(ctx, result_val);
+  rtn.value = tracked_value(ctx, result);
   return rtn;
 }
 
@@ -1720,12 +8935,7 @@ ValuePtr PromiseResult(ValuePtr ptr) {
   LOCAL_VALUE(ptr)
   Local<Promise> promise = value.As<Promise>();
   Local<Value> result = promise->Result();
-  m_value* result_val = new m_value;
-  result_val->iso = iso;
-  result_val->ctx = ctx;
-  result_val->ptr =
-      Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-  return tracked_value(ctx, result_val);
+  return tracked_value(ctx, result);
 }
 
 /********** Function **********/
@@ -1754,14 +8964,143 @@ RtnValue FunctionCall(ValuePtr ptr, ValuePtr recv, int argc, ValuePtr args[]) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* rtnval = new m_value;
-  rtnval->iso = iso;
-  rtnval->ctx = ctx;
-  rtnval->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-  rtn.value = tracked_value(ctx, rtnval);
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
+}
+
+RtnError FunctionCallBatch(ValuePtr ptr,
+                           ValuePtr recv,
+                           int calls,
+                           int argcs[],
+                           ValuePtr args[],
+                           ValuePtr results[],
+                           double numbers[],
+                           int* done) {
+  LOCAL_VALUE(ptr)
+
+  RtnError rtn = {};
+  Local<Function> fn = Local<Function>::Cast(value);
+  Local<Value> local_recv = recv->ptr.Get(iso);
+  *done = 0;
+  for (int i = 0; i < calls; i++) {
+    HandleScope call_scope(iso);
+    int argc = argcs[i];
+    Local<Value> argv[argc > 0 ? argc : 1];
+    buildCallArguments(iso, argv, argc, args);
+    args += argc;
+
+    Local<Value> result;
+    if (!fn->Call(local_ctx, local_recv, argc, argv).ToLocal(&result)) {
+      return ExceptionError(try_catch, iso, local_ctx);
+    }
+    if (results != nullptr) {
+      results[i] = tracked_value(ctx, result);
+    } else {
+      double number;
+      if (!result->NumberValue(local_ctx).To(&number)) {
+        return ExceptionError(try_catch, iso, local_ctx);
+      }
+      numbers[i] = number;
+    }
+    *done = i + 1;
+  }
+  return rtn;
+}
+
+PreparedCall FunctionPrepareCall(ValuePtr ptr, ValuePtr recv, int argc) {
+  LOCAL_VALUE(ptr)
+  uint32_t slot;
+  m_preparedCall* call = ctx->preparedCalls.Alloc(&slot);
+  call->fn.Reset(iso, value.As<Function>());
+  call->recv.Reset(iso, recv->ptr.Get(iso));
+  call->args.assign(argc, CallbackArg{CALLBACK_ARG_UNDEFINED});
+  call->values.assign(argc, nullptr);
+  call->ctx = ctx;
+  call->slot = slot;
+  return {call, call->args.data(), call->values.data()};
+}
+
+// unpackCallArg returns the value of a prepared argument, or nothing for a
+// string that V8 cannot create.
+static MaybeLocal<Value> unpackCallArg(Isolate* iso,
+                                       const CallbackArg& arg,
+                                       ValuePtr val) {
+  switch (arg.kind) {
+    case CALLBACK_ARG_NULL:
+      return Null(iso);
+    case CALLBACK_ARG_BOOLEAN:
+      return Boolean::New(iso, arg.int32 != 0);
+    case CALLBACK_ARG_INT32:
+      return Integer::New(iso, arg.int32);
+    case CALLBACK_ARG_NUMBER:
+      return Number::New(iso, arg.number);
+    case CALLBACK_ARG_STRING: {
+      Local<String> str;
+      if (!String::NewFromUtf8(iso, arg.data, NewStringType::kNormal,
+                               arg.length)
+               .ToLocal(&str)) {
+        return MaybeLocal<Value>();
+      }
+      return str;
+    }
+    case CALLBACK_ARG_VALUE:
+      if (val != nullptr) {
+        return val->ptr.Get(iso);
+      }
+  }
+  return Undefined(iso);
+}
+
+static MaybeLocal<Value> preparedCallRun(m_preparedCall* call,
+                                         Isolate* iso,
+                                         Local<Context> local_ctx) {
+  int argc = call->args.size();
+  Local<Value> argv[argc > 0 ? argc : 1];
+  for (int i = 0; i < argc; i++) {
+    if (!unpackCallArg(iso, call->args[i], call->values[i])
+             .ToLocal(&argv[i])) {
+      iso->ThrowException(Exception::RangeError(
+          String::NewFromUtf8Literal(iso, "Invalid string length")));
+      return MaybeLocal<Value>();
+    }
+  }
+  return call->fn.Get(iso)->Call(local_ctx, call->recv.Get(iso), argc, argv);
+}
+
+RtnValue PreparedCallInvoke(PreparedCallPtr ptr) {
+  m_ctx* ctx = ptr->ctx;
+  LOCAL_CONTEXT(ctx)
+  RtnValue rtn = {};
+  Local<Value> result;
+  if (!preparedCallRun(ptr, iso, local_ctx).ToLocal(&result)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+    return rtn;
+  }
+  rtn.value = tracked_value(ctx, result);
+  return rtn;
+}
+
+RtnNumber PreparedCallInvokeNumber(PreparedCallPtr ptr) {
+  m_ctx* ctx = ptr->ctx;
+  LOCAL_CONTEXT(ctx)
+  RtnNumber rtn = {};
+  Local<Value> result;
+  if (!preparedCallRun(ptr, iso, local_ctx).ToLocal(&result) ||
+      !result->NumberValue(local_ctx).To(&rtn.number)) {
+    rtn.error = ExceptionError(try_catch, iso, local_ctx);
+  }
   return rtn;
 }
 
+void PreparedCallRelease(PreparedCallPtr ptr) {
+  LOCK_ISOLATE(ptr->ctx->iso);
+  ptr->fn.Reset();
+  ptr->recv.Reset();
+  ptr->args.clear();
+  ptr->values.clear();
+  ptr->ctx->preparedCalls.Free(ptr->slot);
+}
+
 RtnValue FunctionNewInstance(ValuePtr ptr, int argc, ValuePtr args[]) {
   LOCAL_VALUE(ptr)
   RtnValue rtn = {};
@@ -1773,11 +9112,7 @@ RtnValue FunctionNewInstance(ValuePtr ptr, int argc, ValuePtr args[]) {
     rtn.error = ExceptionError(try_catch, iso, local_ctx);
     return rtn;
   }
-  m_value* rtnval = new m_value;
-  rtnval->iso = iso;
-  rtnval->ctx = ctx;
-  rtnval->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-  rtn.value = tracked_value(ctx, rtnval);
+  rtn.value = tracked_value(ctx, result);
   return rtn;
 }
 
@@ -1785,11 +9120,13 @@ ValuePtr FunctionSourceMapUrl(ValuePtr ptr) {
   LOCAL_VALUE(ptr)
   Local<Function> fn = Local<Function>::Cast(value);
   Local<Value> result = fn->GetScriptOrigin().SourceMapUrl();
-  m_value* rtnval = new m_value;
-  rtnval->iso = iso;
-  rtnval->ctx = ctx;
-  rtnval->ptr = Persistent<Value, CopyablePersistentTraits<Value>>(iso, result);
-  return tracked_value(ctx, rtnval);
+  return tracked_value(ctx, result);
+}
+
+ScriptCompilerCachedData* FunctionCreateCodeCache(ValuePtr ptr) {
+  LOCAL_VALUE(ptr)
+  Local<Function> fn = Local<Function>::Cast(value);
+  return CachedDataResult(ScriptCompiler::CreateCodeCacheForFunction(fn));
 }
 
 /********** v8::V8 **********/
@@ -1801,4 +9138,8 @@ const char* Version() {
 void SetFlags(const char* flags) {
   V8::SetFlagsFromString(flags);
 }
+
+uint32_t CachedDataVersionTag() {
+  return ScriptCompiler::CachedDataVersionTag();
+}
 }
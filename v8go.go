@@ -11,7 +11,10 @@ package v8go
 // #include <stdlib.h>
 import "C"
 import (
+	"errors"
 	"strings"
+	"sync"
+	"time"
 	"unsafe"
 )
 
@@ -29,3 +32,146 @@ func SetFlags(flags ...string) {
 	C.SetFlags(cflags)
 	C.free(unsafe.Pointer(cflags))
 }
+
+// PlatformOptions configures the V8 platform of the process, which runs the
+// background work of every isolate, such as concurrent garbage collection and
+// compilation, on a pool of worker threads.
+type PlatformOptions struct {
+	// ThreadPoolSize is the number of worker threads. When it is 0, V8 uses
+	// one less than the number of CPUs, up to 16. On machines with many cores
+	// that also run a busy Go scheduler, runtime.GOMAXPROCS(0) or less keeps
+	// the two from competing for cores.
+	ThreadPoolSize int
+	// IdleTasks enables the idle tasks that V8 posts for work that can wait,
+	// such as parts of garbage collection. They run in the time left over by
+	// Isolate.IdleNotification.
+	IdleTasks bool
+	// WorkerPool runs the worker tasks of V8 on a bounded pool of v8go's own,
+	// of ThreadPoolSize threads, instead of the pool of the libplatform
+	// default platform, so GetPlatformStatistics can report how backlogged
+	// concurrent garbage collection and compilation are.
+	WorkerPool bool
+	// Perf makes the JIT code of JavaScript show up by name in the profiles
+	// of Linux perf and of the profilers that read its symbol maps, see
+	// PerfMode.
+	Perf PerfMode
+}
+
+// PerfMode is how V8 tells Linux perf the names of its JIT code, see
+// PlatformOptions.Perf. Each mode also gives interpreted functions native
+// frames of their own (--interpreted-frames-native-stack), so that they are
+// not all attributed to the interpreter. The stacks of samples are only
+// walked from JavaScript through V8 into Go with a V8 library built with frame
+// pointers, which deps/build.py enables.
+type PerfMode int
+
+const (
+	// PerfOff tells perf nothing.
+	PerfOff PerfMode = iota
+	// PerfMap writes the symbol map /tmp/perf-<pid>.map, which perf and the
+	// continuous profilers based on it read while the process runs.
+	// Contrary to --perf-basic-prof, the isolates of the process share the
+	// map, which is rewritten with the code that is still live once most of
+	// its entries are stale, so that it does not grow without bound.
+	PerfMap
+	// PerfJitDump writes a jit-<pid>.dump file to the working directory
+	// (--perf-prof), with the code itself, which `perf inject --jit` merges
+	// into a profile recorded with `perf record -k mono`.
+	PerfJitDump
+)
+
+// PlatformStatistics are the statistics of the worker pool of v8go, see
+// PlatformOptions.WorkerPool. They are all zero if it is not enabled.
+type PlatformStatistics struct {
+	// WorkerThreads is the number of threads of the pool.
+	WorkerThreads int
+	// QueuedTasks is the number of tasks waiting for a thread, and
+	// DelayedTasks the number of those waiting for their delay to pass.
+	QueuedTasks  int
+	DelayedTasks int
+	// RunningTasks is the number of tasks that run at the moment.
+	RunningTasks int
+	// CompletedTasks is the number of tasks that have run.
+	CompletedTasks uint64
+	// TotalQueueTime and MaxQueueTime are the total and longest times that
+	// completed and running tasks waited for a thread, and TotalRunTime the
+	// time that completed tasks ran for.
+	TotalQueueTime time.Duration
+	MaxQueueTime   time.Duration
+	TotalRunTime   time.Duration
+}
+
+// GetPlatformStatistics returns the statistics of the worker pool of v8go.
+func GetPlatformStatistics() PlatformStatistics {
+	stats := C.GetPlatformStatistics()
+	return PlatformStatistics{
+		WorkerThreads:  int(stats.workerThreads),
+		QueuedTasks:    int(stats.queuedTasks),
+		DelayedTasks:   int(stats.delayedTasks),
+		RunningTasks:   int(stats.runningTasks),
+		CompletedTasks: uint64(stats.completedTasks),
+		TotalQueueTime: time.Duration(stats.totalQueueTime),
+		MaxQueueTime:   time.Duration(stats.maxQueueTime),
+		TotalRunTime:   time.Duration(stats.totalRunTime),
+	}
+}
+
+// ErrPlatformInitialized is returned by SetPlatformOptions, and by
+// SetEngineFlags for the flags that must be set before, once the first
+// isolate has been created.
+var ErrPlatformInitialized = errors.New("v8go: the V8 platform is already initialized")
+
+var (
+	v8once              sync.Once
+	platformMutex       sync.Mutex
+	platformOptions     PlatformOptions
+	platformInitialized bool
+)
+
+// SetPlatformOptions sets the options of the V8 platform. The platform is
+// created along with the first isolate of the process, so SetPlatformOptions
+// must be called before that, typically from main or an init function.
+func SetPlatformOptions(opts PlatformOptions) error {
+	if opts.ThreadPoolSize < 0 {
+		return errors.New("v8go: negative thread pool size")
+	}
+	if opts.Perf < PerfOff || opts.Perf > PerfJitDump {
+		return errors.New("v8go: unknown PerfMode")
+	}
+	platformMutex.Lock()
+	defer platformMutex.Unlock()
+	if platformInitialized {
+		return ErrPlatformInitialized
+	}
+	platformOptions = opts
+	return nil
+}
+
+// initV8 creates the V8 platform and initializes V8 the first time it is
+// called.
+func initV8() {
+	v8once.Do(func() {
+		platformMutex.Lock()
+		defer platformMutex.Unlock()
+		var cOptions C.PlatformOptions
+		cOptions.threadPoolSize = C.int(platformOptions.ThreadPoolSize)
+		if platformOptions.IdleTasks {
+			cOptions.idleTasks = 1
+		}
+		if platformOptions.WorkerPool {
+			cOptions.workerPool = 1
+		}
+		switch platformOptions.Perf {
+		case PerfMap:
+			cOptions.perfMap = 1
+		case PerfJitDump:
+			SetFlags("--perf-prof")
+		}
+		if platformOptions.Perf != PerfOff && BuildVariant != "jitless" {
+			SetFlags("--interpreted-frames-native-stack")
+		}
+		initDefaultICU()
+		C.Init(cOptions)
+		platformInitialized = true
+	})
+}
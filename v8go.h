@@ -15,6 +15,8 @@ typedef v8::CpuProfiler* CpuProfilerPtr;
 typedef v8::CpuProfile* CpuProfilePtr;
 typedef const v8::CpuProfileNode* CpuProfileNodePtr;
 typedef v8::ScriptCompiler::CachedData* ScriptCompilerCachedDataPtr;
+typedef v8::SnapshotCreator* SnapshotCreatorPtr;
+typedef v8::StartupData* StartupDataPtr;
 
 extern "C" {
 #else
@@ -33,6 +35,12 @@ typedef const v8CpuProfileNode* CpuProfileNodePtr;
 
 typedef struct v8ScriptCompilerCachedData v8ScriptCompilerCachedData;
 typedef const v8ScriptCompilerCachedData* ScriptCompilerCachedDataPtr;
+
+typedef struct v8SnapshotCreator v8SnapshotCreator;
+typedef v8SnapshotCreator* SnapshotCreatorPtr;
+
+typedef struct v8StartupData v8StartupData;
+typedef v8StartupData* StartupDataPtr;
 #endif
 
 #include <stddef.h>
@@ -43,15 +51,58 @@ extern const int ScriptCompilerNoCompileOptions;
 extern const int ScriptCompilerConsumeCodeCache;
 extern const int ScriptCompilerEagerCompile;
 
+// StackTrace::StackTraceOptions values
+extern const int StackTraceLineNumber;
+extern const int StackTraceColumnOffset;
+extern const int StackTraceScriptName;
+extern const int StackTraceFunctionName;
+extern const int StackTraceIsEval;
+extern const int StackTraceIsConstructor;
+extern const int StackTraceScriptNameOrSourceURL;
+extern const int StackTraceScriptId;
+extern const int StackTraceOverview;
+extern const int StackTraceDetailed;
+
 typedef struct m_ctx m_ctx;
 typedef struct m_value m_value;
 typedef struct m_template m_template;
 typedef struct m_unboundScript m_unboundScript;
+typedef struct m_callbackInfo m_callbackInfo;
+typedef struct m_backingStore m_backingStore;
+typedef struct m_streamingTask m_streamingTask;
+typedef struct m_consumeTask m_consumeTask;
+typedef struct m_module m_module;
+typedef struct m_source m_source;
+typedef struct m_preparedCall m_preparedCall;
+typedef struct m_serialized m_serialized;
+typedef struct m_compiledWasmModule m_compiledWasmModule;
+typedef struct m_wasmStream m_wasmStream;
+typedef struct m_inspectorSession m_inspectorSession;
 
 typedef m_ctx* ContextPtr;
 typedef m_value* ValuePtr;
+
+// The head of every m_value, from which Go reads the generation of the slot
+// of a value without a call, see ValueRelease.
+typedef struct {
+  void* iso;
+  void* ctx;
+  uint32_t slot;
+  uint32_t gen;
+} ValueHead;
 typedef m_template* TemplatePtr;
 typedef m_unboundScript* UnboundScriptPtr;
+typedef m_callbackInfo* CallbackInfoPtr;
+typedef m_backingStore* BackingStorePtr;
+typedef m_streamingTask* StreamingTaskPtr;
+typedef m_consumeTask* ConsumeTaskPtr;
+typedef m_module* ModulePtr;
+typedef m_source* SourcePtr;
+typedef m_preparedCall* PreparedCallPtr;
+typedef m_serialized* SerializedPtr;
+typedef m_compiledWasmModule* CompiledWasmModulePtr;
+typedef m_wasmStream* WasmStreamPtr;
+typedef m_inspectorSession* InspectorSessionPtr;
 
 typedef enum {
   ERROR_RANGE = 1,
@@ -78,18 +129,203 @@ typedef enum {
   SYMBOL_UNSCOPABLES,
 } SymbolIndex;
 
+// The levels of v8::MemoryPressureLevel.
+typedef enum {
+  MEMORY_PRESSURE_NONE = 0,
+  MEMORY_PRESSURE_MODERATE,
+  MEMORY_PRESSURE_CRITICAL,
+} MemoryPressureLevelIndex;
+
+// Indexes into the per-isolate array of cached, immortal values returned by
+// IsolateCachedValues. CACHED_VALUE_SMALL_INT is the index of
+// CACHED_SMALL_INT_MIN and is followed by every integer up to, and including,
+// CACHED_SMALL_INT_MAX.
+typedef enum {
+  CACHED_VALUE_UNDEFINED = 0,
+  CACHED_VALUE_NULL,
+  CACHED_VALUE_TRUE,
+  CACHED_VALUE_FALSE,
+  CACHED_VALUE_SMALL_INT,
+} CachedValueIndex;
+
+#define CACHED_SMALL_INT_MIN -128
+#define CACHED_SMALL_INT_MAX 1023
+#define CACHED_VALUE_COUNT \
+  (CACHED_VALUE_SMALL_INT + CACHED_SMALL_INT_MAX - CACHED_SMALL_INT_MIN + 1)
+
+// Bits of the mask returned by ValueTypeOf, one for each of the ValueIs*
+// predicates.
+typedef enum {
+  VALUE_TYPE_UNDEFINED = 0,
+  VALUE_TYPE_NULL,
+  VALUE_TYPE_NULL_OR_UNDEFINED,
+  VALUE_TYPE_TRUE,
+  VALUE_TYPE_FALSE,
+  VALUE_TYPE_NAME,
+  VALUE_TYPE_STRING,
+  VALUE_TYPE_SYMBOL,
+  VALUE_TYPE_FUNCTION,
+  VALUE_TYPE_OBJECT,
+  VALUE_TYPE_BIG_INT,
+  VALUE_TYPE_BOOLEAN,
+  VALUE_TYPE_NUMBER,
+  VALUE_TYPE_EXTERNAL,
+  VALUE_TYPE_INT32,
+  VALUE_TYPE_UINT32,
+  VALUE_TYPE_DATE,
+  VALUE_TYPE_ARGUMENTS_OBJECT,
+  VALUE_TYPE_BIG_INT_OBJECT,
+  VALUE_TYPE_NUMBER_OBJECT,
+  VALUE_TYPE_STRING_OBJECT,
+  VALUE_TYPE_SYMBOL_OBJECT,
+  VALUE_TYPE_NATIVE_ERROR,
+  VALUE_TYPE_REG_EXP,
+  VALUE_TYPE_ASYNC_FUNCTION,
+  VALUE_TYPE_GENERATOR_FUNCTION,
+  VALUE_TYPE_GENERATOR_OBJECT,
+  VALUE_TYPE_PROMISE,
+  VALUE_TYPE_MAP,
+  VALUE_TYPE_SET,
+  VALUE_TYPE_MAP_ITERATOR,
+  VALUE_TYPE_SET_ITERATOR,
+  VALUE_TYPE_WEAK_MAP,
+  VALUE_TYPE_WEAK_SET,
+  VALUE_TYPE_ARRAY,
+  VALUE_TYPE_ARRAY_BUFFER,
+  VALUE_TYPE_ARRAY_BUFFER_VIEW,
+  VALUE_TYPE_TYPED_ARRAY,
+  VALUE_TYPE_UINT8_ARRAY,
+  VALUE_TYPE_UINT8_CLAMPED_ARRAY,
+  VALUE_TYPE_INT8_ARRAY,
+  VALUE_TYPE_UINT16_ARRAY,
+  VALUE_TYPE_INT16_ARRAY,
+  VALUE_TYPE_UINT32_ARRAY,
+  VALUE_TYPE_INT32_ARRAY,
+  VALUE_TYPE_FLOAT32_ARRAY,
+  VALUE_TYPE_FLOAT64_ARRAY,
+  VALUE_TYPE_BIG_INT64_ARRAY,
+  VALUE_TYPE_BIG_UINT64_ARRAY,
+  VALUE_TYPE_DATA_VIEW,
+  VALUE_TYPE_SHARED_ARRAY_BUFFER,
+  VALUE_TYPE_PROXY,
+  VALUE_TYPE_WASM_MODULE_OBJECT,
+  VALUE_TYPE_MODULE_NAMESPACE_OBJECT,
+} ValueTypeBit;
+
+// An exception, formatted for a JSError. For an isolate created with
+// IsolateOptions.keepExceptions, the exception is also kept as a handle, with
+// the ref of its context. So is an exception that is an object for an
+// isolate created with IsolateOptions.lazyErrors, whose msg and stack are
+// then left for ExceptionErrorFormat.
 typedef struct {
   const char* msg;
   const char* location;
   const char* stack;
+  ValuePtr exception;
+  int exceptionContext;
 } RtnError;
 
+// The result of running the due timers of a context: the time in milliseconds
+// until the next timer is due, or -1 if none is set, the exception of a
+// timer callback that threw, which stops the run, and the number of promises
+// of Atomics.waitAsync that have yet to settle.
+typedef struct {
+  double next;
+  RtnError error;
+  int asyncWaits;
+} RtnTimers;
+
+typedef struct {
+  double number;
+  RtnError error;
+} RtnNumber;
+
+typedef struct {
+  SerializedPtr ptr;
+  RtnError error;
+} RtnSerialized;
+
+typedef struct {
+  WasmStreamPtr ptr;
+  ValuePtr promise;
+  RtnError error;
+} RtnWasmStream;
+
+// A string passed from Go. Unless it is external, data is UTF-8 in Go memory
+// that is only valid for the duration of the call. External strings are
+// one-byte strings in malloc'd memory, which the callee takes ownership of.
+typedef struct {
+  const char* data;
+  int length;
+  int external;
+} StringArg;
+
+
+// Tags of the bulk value format written by ValueExport and read by
+// ContextImport. Each value is a one
+// byte tag followed by its payload, in host byte order.
+typedef enum {
+  BULK_UNDEFINED = 0,
+  BULK_NULL,
+  BULK_FALSE,
+  BULK_TRUE,
+  // int32_t
+  BULK_INT32,
+  // double
+  BULK_NUMBER,
+  // uint32_t byte length followed by the UTF-8 encoded string
+  BULK_STRING,
+  // uint32_t length followed by the elements
+  BULK_ARRAY,
+  // uint32_t count followed by that many properties, each an untagged string
+  // key followed by the value
+  BULK_OBJECT,
+  // uint32_t index into the values of RtnBulk, for values that are not
+  // primitives, arrays or plain objects
+  BULK_VALUE,
+  // uint32_t id of a shape registered with IsolateNewShape followed by the
+  // values of its keys, in order; only read by ContextImport
+  BULK_SHAPE,
+  // uint8_t sign bit and uint32_t word count followed by that many uint64_t
+  // words of the magnitude of a BigInt, least significant first; only read
+  // by ContextImport
+  BULK_BIGINT,
+} BulkTag;
+
+typedef struct {
+  char* data;
+  size_t length;
+  ValuePtr* values;
+  int valuesCount;
+  RtnError error;
+} RtnBulk;
+
+// The PropertyFilter bits of V8 that select property names by attribute, see
+// ObjectPropertyNames.
+typedef enum {
+  PROPERTY_FILTER_ONLY_WRITABLE = 1,
+  PROPERTY_FILTER_ONLY_ENUMERABLE = 2,
+  PROPERTY_FILTER_ONLY_CONFIGURABLE = 4,
+} PropertyFilterBit;
+
 typedef struct {
   UnboundScriptPtr ptr;
   int cachedDataRejected;
   RtnError error;
 } RtnUnboundScript;
 
+typedef struct {
+  ValuePtr value;
+  int cachedDataRejected;
+  RtnError error;
+} RtnFunction;
+
+typedef struct {
+  ModulePtr ptr;
+  int cachedDataRejected;
+  RtnError error;
+} RtnModule;
+
 typedef struct {
   ScriptCompilerCachedDataPtr ptr;
   const uint8_t* data;
@@ -100,19 +336,150 @@ typedef struct {
 typedef struct {
   ScriptCompilerCachedData cachedData;
   int compileOption;
+  // The deserialization of cachedData that has been done ahead of the
+  // compile, if any, see IsolateStartConsumingCodeCache; the compile takes
+  // it over.
+  ConsumeTaskPtr consumeTask;
 } CompileOptions;
 
+// Signatures of the Go functions that can be called by optimized code
+// through the V8 Fast API, named after their argument and return types.
+typedef enum {
+  FAST_CALLBACK_NONE = 0,
+  FAST_CALLBACK_FLOAT64_FLOAT64,
+  FAST_CALLBACK_FLOAT64_FLOAT64_FLOAT64,
+  FAST_CALLBACK_INT32_INT32_INT32,
+  FAST_CALLBACK_INT32_FLOAT64_FLOAT64,
+  FAST_CALLBACK_FLOAT64ARRAY_FLOAT64,
+} FastCallbackSignature;
+
+typedef struct {
+  int packedArgs;
+  int fastSignature;
+  int length;
+  int nonConstructor;
+  int sideEffectFree;
+  // The template that receivers must be instances of, or NULL.
+  TemplatePtr signature;
+} FunctionTemplateOptions;
+
+typedef struct {
+  int ownMicrotaskQueue;
+  // The index of the context of the isolate's startup snapshot to start
+  // from, used unless a global template is given.
+  int snapshotIndex;
+  // A global proxy detached with ContextDetachGlobal to reuse, or NULL.
+  ValuePtr globalObject;
+} ContextOptions;
+
+// The kinds of properties whose value is computed by a Go callback, see
+// ObjectTemplateSetAccessor.
+typedef enum {
+  ACCESSOR_PROPERTY = 0,
+  NATIVE_DATA_PROPERTY,
+  LAZY_DATA_PROPERTY,
+} AccessorKind;
+
+// The operations of accessors and interceptors on a property, passed to
+// goPropertyCallback; interceptors only install the callbacks of the
+// operations set in their mask, 1 << op.
+typedef enum {
+  PROPERTY_GET = 0,
+  PROPERTY_SET,
+  PROPERTY_DELETE,
+  PROPERTY_ENUMERATE,
+} PropertyOp;
+
+// The arguments of a fast callback, in the order of its signature.
+typedef struct {
+  int32_t int32[2];
+  double number[2];
+  double* float64s;
+  size_t length;
+} FastCallbackArgs;
+
+typedef enum {
+  CALLBACK_ARG_VALUE = 0,
+  CALLBACK_ARG_UNDEFINED,
+  CALLBACK_ARG_NULL,
+  CALLBACK_ARG_BOOLEAN,
+  CALLBACK_ARG_INT32,
+  CALLBACK_ARG_NUMBER,
+  CALLBACK_ARG_STRING,
+} CallbackArgKind;
+
+// Strings of up to CALLBACK_ARG_STRING_MAX bytes, encoded as UTF-8, are passed
+// to packed callbacks by value.
+#define CALLBACK_ARG_STRING_MAX 64
+
+// A function argument as delivered to a packed callback. Booleans are stored
+// in int32, the value of both int32 and number arguments in number. Only
+// arguments of kind CALLBACK_ARG_VALUE need a value to be created.
+typedef struct {
+  int kind;
+  int32_t int32;
+  double number;
+  int length;
+  char data[CALLBACK_ARG_STRING_MAX];
+} CallbackArg;
+
+// A prepared call, with its argument slots, which Go writes in place.
+typedef struct {
+  PreparedCallPtr ptr;
+  CallbackArg* args;
+  ValuePtr* values;
+} PreparedCall;
+
 typedef struct {
   CpuProfilerPtr ptr;
   IsolatePtr iso;
 } CPUProfiler;
 
+// The modes of v8::CpuProfilingMode.
+typedef enum {
+  CPU_PROFILING_LEAF_NODE_LINE_NUMBERS = 0,
+  CPU_PROFILING_CALLER_LINE_NUMBERS,
+} CPUProfilingModeIndex;
+
+// Options of CPUProfilerStartProfilingWithOptions; a maxSamples of 0 means no
+// limit to the samples recorded, if recordSamples is set, and a
+// samplingIntervalUs of 0 the interval of the profiler.
+typedef struct {
+  int mode;
+  int recordSamples;
+  unsigned maxSamples;
+  int samplingIntervalUs;
+} CPUProfilingOptions;
+
+typedef struct {
+  int line;
+  unsigned hitCount;
+} CPUProfileLineTick;
+
+// A deoptimization of the function of a node, at a position of the script of
+// the innermost frame of the deoptimized code. The reason is owned by V8.
+typedef struct {
+  const char* reason;
+  int scriptId;
+  size_t position;
+} CPUProfileDeoptInfo;
+
 typedef struct CPUProfileNode {
   CpuProfileNodePtr ptr;
+  unsigned nodeId;
+  int scriptId;
   const char* scriptResourceName;
   const char* functionName;
   int lineNumber;
   int columnNumber;
+  unsigned hitCount;
+  // Owned by V8, like the reasons of deoptInfos.
+  const char* bailoutReason;
+  int sourceType;
+  int lineTickCount;
+  CPUProfileLineTick* lineTicks;
+  int deoptInfoCount;
+  CPUProfileDeoptInfo* deoptInfos;
   int childrenCount;
   struct CPUProfileNode** children;
 } CPUProfileNode;
@@ -123,18 +490,74 @@ typedef struct {
   CPUProfileNode* root;
   int64_t startTime;
   int64_t endTime;
+  // The number of samples recorded, see CPUProfileGetSamples.
+  int samplesCount;
 } CPUProfile;
 
+// A CPU profile as flat tables, see CPUProfileGetTable. Nodes come in depth
+// first order, so a parent precedes its children; the root has a parent of
+// -1. Names are indexes into the string table, whose string i is the bytes
+// from stringOffsets[i] to stringOffsets[i + 1] of stringData; string 0 is
+// empty.
+typedef struct {
+  int parent;
+  int function;
+  int line;
+  unsigned hitCount;
+} CPUProfileTableNode;
+
+typedef struct {
+  int name;
+  int scriptName;
+  int line;
+} CPUProfileTableFunction;
+
+typedef struct {
+  CPUProfileTableNode* nodes;
+  int nodeCount;
+  CPUProfileTableFunction* functions;
+  int functionCount;
+  char* stringData;
+  int* stringOffsets;
+  int stringCount;
+} CPUProfileTable;
+
+// A node of the call tree of an allocation profile, with the sampled
+// allocations of the function itself.
+typedef struct AllocationProfileNode {
+  const char* scriptResourceName;
+  const char* functionName;
+  int lineNumber;
+  int columnNumber;
+  size_t selfSize;
+  unsigned int selfCount;
+  int childrenCount;
+  struct AllocationProfileNode** children;
+} AllocationProfileNode;
+
 typedef struct {
   ValuePtr value;
   RtnError error;
 } RtnValue;
 
+// A string written as UTF-8 into a caller-supplied buffer. If the buffer is
+// too small, only the length is written, and string is the string to write
+// into a buffer of that size with StringWriteUtf8. That length is the number
+// of characters of a one-byte string, which is the length of its UTF-8 if it
+// is ASCII. The hash of the string is only set by ValueToUtf8Hash.
 typedef struct {
-  const char* data;
+  ValuePtr string;
   int length;
+  int hash;
   RtnError error;
-} RtnString;
+} RtnUtf8;
+
+// The memory of an ArrayBuffer, SharedArrayBuffer or ArrayBufferView. It is
+// owned by the backing store of the buffer, which outlives the buffer's value.
+typedef struct {
+  void* data;
+  size_t byteLength;
+} ArrayBufferContents;
 
 typedef struct {
   size_t total_heap_size;
@@ -150,52 +573,468 @@ typedef struct {
   size_t number_of_detached_contexts;
 } IsolateHStatistics;
 
+typedef struct {
+  const char* space_name;
+  size_t space_size;
+  size_t space_used_size;
+  size_t space_available_size;
+  size_t physical_space_size;
+} IsolateHSpaceStatistics;
+
+typedef struct {
+  size_t code_and_metadata_size;
+  size_t bytecode_and_metadata_size;
+  size_t external_script_source_size;
+} IsolateHCodeStatistics;
+
+// The memory attributed to a context by IsolateMeasureMemory, identified by
+// its ref.
+typedef struct {
+  int ref;
+  size_t bytes;
+} ContextMemory;
+
+typedef struct {
+  // An array of count entries that the caller frees.
+  ContextMemory* contexts;
+  int count;
+  size_t unattributed;
+  int completed;
+} MemoryMeasurement;
+
 typedef struct {
   const uint64_t* word_array;
   int word_count;
   int sign_bit;
 } ValueBigInt;
 
-extern void Init();
-extern IsolatePtr NewIsolate();
+// Options of NewIsolate. Sizes are in bytes, and 0 keeps V8's default.
+typedef struct {
+  int pooledArrayBuffers;
+  // The most memory that array buffers may take up, or 0 for no limit.
+  size_t arrayBufferQuota;
+  // Sizes the generations of the heap from heapSizeInitial and heapSizeMax,
+  // before the sizes of each generation are applied.
+  size_t heapSizeInitial;
+  size_t heapSizeMax;
+  size_t initialOldGenerationSize;
+  size_t maxOldGenerationSize;
+  size_t initialYoungGenerationSize;
+  size_t maxYoungGenerationSize;
+  size_t codeRangeSize;
+  // A blob created by SnapshotCreatorCreateBlob, which must outlive the
+  // isolate.
+  StartupDataPtr snapshot;
+  // The number of GC events that the isolate buffers until they are drained,
+  // or 0 not to record them.
+  int gcEventCapacity;
+  // Whether the isolate counts the calls into the shim, see
+  // IsolateShimStats.
+  int shimStats;
+  // Whether the isolate times the calls of the callbacks of function
+  // templates, see IsolateCallbackStats.
+  int callbackStats;
+  // Whether the isolate formats the exceptions of errors only once Go asks
+  // for them, see RtnError.
+  int lazyErrors;
+  // Whether errors keep the exception as a handle, see RtnError.
+  int keepExceptions;
+  // The number of frames of the stack trace that is captured for the
+  // message of an uncaught exception, and the StackTraceOptions of the
+  // frames; 0 keeps 10 frames and StackTraceOverview, and fewer frames than
+  // 0 capture none.
+  int uncaughtStackTraceFrames;
+  int uncaughtStackTraceOptions;
+  // The number of console messages that each context buffers until they are
+  // drained, or 0 to leave the console methods doing nothing, and the
+  // ConsoleLevel below which messages are discarded.
+  int consoleCapacity;
+  int consoleLevel;
+  // Whether Atomics.wait throws, rather than blocking the thread.
+  int disallowAtomicsWait;
+  // The stack that JavaScript may use below the position at which a thread
+  // enters the isolate, capped to what the thread's stack leaves, or 0 for
+  // V8's default.
+  size_t stackSize;
+  // The number of strings of up to stringCacheMaxLength bytes that
+  // NewValueString keeps internalized for reuse, or 0 to cache none.
+  int stringCacheCapacity;
+  int stringCacheMaxLength;
+} IsolateOptions;
+
+// The counts of the lookups in a cache of an isolate, and the number of
+// entries it holds.
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  size_t length;
+} CacheStats;
+
+// The levels of console messages, by the methods of console that write them,
+// see ContextDrainConsole.
+typedef enum {
+  CONSOLE_DEBUG = 0,
+  CONSOLE_LOG,
+  CONSOLE_WARN,
+  CONSOLE_ERROR,
+} ConsoleLevel;
+
+// A console message drained by ContextDrainConsole, whose text is the next
+// length bytes of its buffer; time is in nanoseconds since the epoch.
+typedef struct {
+  int level;
+  int length;
+  int64_t time;
+} ConsoleRecord;
+
+// The engine metrics that V8 records for an isolate, see IsolateMetrics.
+typedef enum {
+  METRIC_GC_FULL_CYCLE = 0,
+  METRIC_GC_FULL_INCREMENTAL_MARK,
+  METRIC_GC_FULL_INCREMENTAL_SWEEP,
+  METRIC_GC_YOUNG_CYCLE,
+  METRIC_WASM_MODULE_DECODED,
+  METRIC_WASM_MODULE_COMPILED,
+  METRIC_WASM_MODULE_INSTANTIATED,
+  METRIC_WASM_MODULE_TIERED_UP,
+  METRIC_COUNT,
+} MetricKind;
+
+// Bucket i of a MetricHistogram counts the events that took less than 2^i
+// microseconds, and not less than 2^(i-1); the last bucket counts the rest.
+#define METRIC_BUCKETS 24
+
+// The durations of the events of a metric, in microseconds.
+typedef struct {
+  uint64_t count;
+  int64_t sum;
+  int64_t min;
+  int64_t max;
+  uint64_t buckets[METRIC_BUCKETS];
+} MetricHistogram;
+
+typedef struct {
+  MetricHistogram histograms[METRIC_COUNT];
+  // The bytes freed by full garbage collections.
+  int64_t gcFullFreed;
+  // The number of WebAssembly modules that the isolate has last reported.
+  uint64_t wasmModules;
+} EngineMetrics;
+
+// The number of calls into the shim of a function that takes the isolate's
+// Locker; name is static.
+typedef struct {
+  const char* name;
+  uint64_t count;
+} ShimCallCount;
+
+// The counters of the shim of an isolate, see IsolateShimStats. calls is
+// malloc'd, and times are in nanoseconds.
+typedef struct {
+  int enabled;
+  ShimCallCount* calls;
+  int callsLength;
+  int64_t lockWaitTotal;
+  int64_t lockWaitMax;
+  uint64_t valuesAllocated;
+  uint64_t valuesFreed;
+} ShimStats;
+
+// The phases of a call of the Go callback of a function template: making
+// values of the receiver and arguments, running the Go function, and handing
+// its result or error to V8.
+typedef enum {
+  CALLBACK_PHASE_ARGS = 0,
+  CALLBACK_PHASE_GO,
+  CALLBACK_PHASE_RETURN,
+  CALLBACK_PHASE_COUNT,
+} CallbackPhase;
+
+// The durations of the phases of the calls of the callback with ref, in
+// nanoseconds, see IsolateCallbackStats.
+typedef struct {
+  int ref;
+  MetricHistogram phases[CALLBACK_PHASE_COUNT];
+} CallbackStats;
+
+// A garbage collection of an isolate, recorded from its GC callbacks. Times
+// are in nanoseconds, start since the Unix epoch.
+typedef struct {
+  int type;
+  int64_t start;
+  int64_t duration;
+  size_t usedBefore;
+  size_t usedAfter;
+} GCEvent;
+
+// The options of the V8 platform, see Init. A threadPoolSize of 0 lets V8
+// size its worker thread pool from the number of CPUs, and workerPool runs
+// the worker tasks on the pool of v8go instead of that of libplatform.
+typedef struct {
+  int threadPoolSize;
+  int idleTasks;
+  int workerPool;
+  // Whether the names of the code of isolates are written to
+  // /tmp/perf-PID.map for Linux perf.
+  int perfMap;
+} PlatformOptions;
+
+// The statistics of the worker pool of v8go, when it is enabled; times are in
+// nanoseconds.
+typedef struct {
+  int workerThreads;
+  size_t queuedTasks;
+  size_t delayedTasks;
+  size_t runningTasks;
+  uint64_t completedTasks;
+  int64_t totalQueueTime;
+  int64_t maxQueueTime;
+  int64_t totalRunTime;
+} PlatformStatistics;
+
+extern void Init(PlatformOptions opts);
+// ICUDataFromFile reports whether the V8 library loads its ICU data from a
+// file instead of embedding it. SetICUData hands ICU that data, mapped into
+// memory for the life of the process, and returns the UErrorCode of ICU, 0 on
+// success; it must be called before Init.
+extern int ICUDataFromFile();
+extern int SetICUData(const void* data);
+// StartTracing starts a trace of the events of the categories, of which the
+// last max_events are written as JSON to the writer of the trace in Go by
+// StopTracing, see goTraceWrite. It returns 0 if a trace is already in
+// progress.
+extern int StartTracing(const char** categories,
+                        int categories_count,
+                        size_t max_events);
+extern void StopTracing();
+extern PlatformStatistics GetPlatformStatistics();
+// ThreadAffinity writes the CPUs that the calling thread may run on to cpus,
+// up to n of them, and returns their number, or -1 if they are unknown.
+extern int ThreadAffinity(int* cpus, int n);
+// ThreadSetAffinity restricts the calling thread to the n cpus, and returns 0
+// or the errno of the failure.
+extern int ThreadSetAffinity(const int* cpus, int n);
+// ThreadCurrentCPU returns the CPU that the calling thread runs on, or -1 if
+// it is unknown.
+extern int ThreadCurrentCPU();
+extern IsolatePtr NewIsolate(IsolateOptions opts);
+extern size_t IsolateArrayBufferMemory(IsolatePtr ptr);
+extern int IsolateHeapLimitReached(IsolatePtr ptr);
+extern ShimStats IsolateShimStats(IsolatePtr ptr);
+// IsolateCallbackStats returns the malloc'd stats of the callbacks that have
+// been called, and sets length to their number, or to -1 if the isolate was
+// created without IsolateOptions.callbackStats. With a ref other than 0,
+// only the stats of that callback are returned.
+extern CallbackStats* IsolateCallbackStats(IsolatePtr ptr,
+                                           int ref,
+                                           int* length);
+extern EngineMetrics IsolateMetrics(IsolatePtr ptr);
+// IsolateRunPendingTasks runs the foreground tasks that V8 has posted for the
+// isolate until there are none, and returns whether it ran any.
+extern int IsolateRunPendingTasks(IsolatePtr ptr);
+// IsolateDrainReleasedCallbacks copies up to n refs of the callbacks of
+// function templates that V8 has collected to refs, and returns how many.
+extern size_t IsolateDrainReleasedCallbacks(IsolatePtr ptr,
+                                            int* refs,
+                                            size_t n);
+extern size_t IsolateDrainGCEvents(IsolatePtr ptr,
+                                   GCEvent* events,
+                                   size_t n,
+                                   uint64_t* dropped);
+
+extern SnapshotCreatorPtr NewSnapshotCreator();
+extern IsolatePtr SnapshotCreatorGetIsolate(SnapshotCreatorPtr creator);
+extern StartupDataPtr SnapshotCreatorCreateBlob(SnapshotCreatorPtr creator,
+                                                ContextPtr* ctxs,
+                                                int ctxs_count,
+                                                TemplatePtr* templates,
+                                                int templates_count,
+                                                int keep_function_code);
+extern void SnapshotCreatorDispose(SnapshotCreatorPtr creator);
+extern int StartupDataSize(StartupDataPtr blob);
+extern void StartupDataFree(StartupDataPtr blob);
+extern ValuePtr* IsolateCachedValues(IsolatePtr ptr);
+extern uint64_t* IsolateCachedValueTypes(IsolatePtr ptr);
+extern void IsolateLock(IsolatePtr ptr);
+extern void IsolateUnlock(IsolatePtr ptr);
+// IsolateLockedByThread returns whether the calling thread holds the lock of
+// the isolate, in a session or a callback.
+extern int IsolateLockedByThread(IsolatePtr ptr);
 extern void IsolatePerformMicrotaskCheckpoint(IsolatePtr ptr);
+extern void IsolateLowMemoryNotification(IsolatePtr ptr);
+extern void IsolateMemoryPressureNotification(IsolatePtr ptr, int level);
+extern int IsolateIdleNotification(IsolatePtr ptr, double idle_seconds);
+extern int64_t IsolateAdjustExternalMemory(IsolatePtr ptr, int64_t change);
 extern void IsolateDispose(IsolatePtr ptr);
+extern uint64_t IsolateArmWatchdog(IsolatePtr ptr, int64_t timeout_ms);
+extern int IsolateDisarmWatchdog(IsolatePtr ptr, uint64_t id);
+extern uint64_t IsolateArmCPUBudget(IsolatePtr ptr, int64_t limit_ns, int ref);
+extern int IsolateDisarmCPUBudget(IsolatePtr ptr, uint64_t id);
 extern void IsolateTerminateExecution(IsolatePtr ptr);
+// IsolateWakeAtomicsWait stops the Atomics.wait that the isolate is blocked
+// in, which returns "ok", and returns whether there was one. It can be
+// called from any thread.
+extern int IsolateWakeAtomicsWait(IsolatePtr ptr);
+extern void IsolateCancelTerminateExecution(IsolatePtr ptr);
 extern int IsolateIsExecutionTerminating(IsolatePtr ptr);
 extern IsolateHStatistics IsolationGetHeapStatistics(IsolatePtr ptr);
+extern int IsolateNumberOfHeapSpaces(IsolatePtr ptr);
+extern IsolateHSpaceStatistics IsolateGetHeapSpaceStatistics(IsolatePtr ptr,
+                                                             int index);
+extern IsolateHCodeStatistics IsolateGetHeapCodeStatistics(IsolatePtr ptr);
+extern MemoryMeasurement IsolateMeasureMemory(IsolatePtr ptr);
 
 extern ValuePtr IsolateThrowException(IsolatePtr iso, ValuePtr value);
 
 extern RtnUnboundScript IsolateCompileUnboundScript(IsolatePtr iso_ptr,
-                                                    const char* source,
-                                                    const char* origin,
+                                                    StringArg source,
+                                                    StringArg origin,
                                                     CompileOptions options);
+extern SourcePtr NewSharedSource(const char* data, int length);
+extern void SharedSourceRelease(SourcePtr src);
+extern int SharedSourceCodeCacheSize(SourcePtr src);
+extern RtnUnboundScript IsolateCompileSharedSource(IsolatePtr iso_ptr,
+                                                   SourcePtr source,
+                                                   StringArg origin,
+                                                   int compile_option);
 extern ScriptCompilerCachedData* UnboundScriptCreateCodeCache(
     IsolatePtr iso_ptr,
     UnboundScriptPtr us_ptr);
 extern void ScriptCompilerCachedDataDelete(
     ScriptCompilerCachedData* cached_data);
 extern RtnValue UnboundScriptRun(ContextPtr ctx_ptr, UnboundScriptPtr us_ptr);
+extern void UnboundScriptRelease(UnboundScriptPtr us_ptr);
+
+extern StreamingTaskPtr IsolateStartStreamingScript(IsolatePtr iso_ptr, int ref);
+extern void StreamingTaskRun(StreamingTaskPtr task);
+extern RtnUnboundScript StreamingTaskFinish(IsolatePtr iso_ptr,
+                                            StreamingTaskPtr task,
+                                            StringArg source,
+                                            StringArg origin);
+
+// IsolateStartConsumingCodeCache starts the deserialization of a copy of a
+// code cache, which ConsumeTaskRun does without the isolate's lock, for a
+// compile of IsolateCompileUnboundScript to finish. It returns null if V8
+// does not deserialize code caches off the main thread.
+extern ConsumeTaskPtr IsolateStartConsumingCodeCache(IsolatePtr iso_ptr,
+                                                     const uint8_t* data,
+                                                     int length);
+extern void ConsumeTaskRun(ConsumeTaskPtr task);
 
 extern CPUProfiler* NewCPUProfiler(IsolatePtr iso_ptr);
 extern void CPUProfilerDispose(CPUProfiler* ptr);
+extern void CPUProfilerSetSamplingInterval(CPUProfiler* ptr, int us);
+extern void CPUProfilerSetUsePreciseSampling(CPUProfiler* ptr, int precise);
 extern void CPUProfilerStartProfiling(CPUProfiler* ptr, const char* title);
+extern void CPUProfilerStartProfilingWithOptions(CPUProfiler* ptr,
+                                                 const char* title,
+                                                 CPUProfilingOptions options);
 extern CPUProfile* CPUProfilerStopProfiling(CPUProfiler* ptr,
                                             const char* title);
+extern CPUProfileNode* CPUProfileGetTopDownRoot(CPUProfile* ptr);
+extern void CPUProfileGetSamples(CPUProfile* ptr,
+                                 unsigned* node_ids,
+                                 int64_t* timestamps);
+extern CPUProfileTable* CPUProfileGetTable(CPUProfile* ptr);
+extern void CPUProfileTableFree(CPUProfileTable* table);
 extern void CPUProfileDelete(CPUProfile* ptr);
 
+extern void IsolateWriteHeapSnapshot(IsolatePtr ptr, int ref);
+extern int IsolateStartSamplingHeapProfiler(IsolatePtr ptr,
+                                            uint64_t sample_interval,
+                                            int stack_depth);
+extern void IsolateStopSamplingHeapProfiler(IsolatePtr ptr);
+extern AllocationProfileNode* IsolateGetAllocationProfile(IsolatePtr ptr);
+extern void AllocationProfileNodeDelete(AllocationProfileNode* node);
+
+// ContextNewInspectorSession connects a session of the Chrome DevTools
+// protocol to the inspector of the context's isolate, which inspects the
+// context from then on. The messages of the session are sent to
+// goInspectorMessage with ref.
+extern InspectorSessionPtr ContextNewInspectorSession(ContextPtr ctx, int ref);
+extern void InspectorSessionDispatch(InspectorSessionPtr session,
+                                     const char* message,
+                                     int message_length);
+extern void InspectorSessionFree(InspectorSessionPtr session);
+
+// ExceptionErrorFormat formats the msg and stack of the exception of a lazy
+// RtnError, and releases the exception unless keep is set.
+extern RtnError ExceptionErrorFormat(ValuePtr exception, int keep);
+
 extern ContextPtr NewContext(IsolatePtr iso_ptr,
                              TemplatePtr global_template_ptr,
-                             int ref);
+                             int ref,
+                             ContextOptions options);
+extern ValuePtr ContextDetachGlobal(ContextPtr ptr);
 extern void ContextFree(ContextPtr ptr);
+extern void ContextFreeDeferred(ContextPtr ptr);
+// IsolateReclaimContexts frees about budget values of the contexts closed by
+// ContextFreeDeferred, or all of them for a budget of 0, and returns the
+// number of values that are left.
+extern size_t IsolateReclaimContexts(IsolatePtr ptr, size_t budget);
+// IsolateDeadValues returns the number of values that IsolateReclaimContexts
+// has left to free, without taking the isolate's lock.
+extern size_t IsolateDeadValues(IsolatePtr ptr);
+// ContextDrainConsole moves up to n of the console messages of the context to
+// records, with their UTF-8 text to buf, as many as fit in buf_len bytes, and
+// returns how many it moved; dropped is set to the number of messages dropped
+// since the last call. It takes no isolate lock.
+extern size_t ContextDrainConsole(ContextPtr ptr,
+                                  ConsoleRecord* records,
+                                  size_t n,
+                                  char* buf,
+                                  size_t buf_len,
+                                  uint64_t* dropped);
+extern int ContextPerformMicrotaskCheckpoint(ContextPtr ptr);
+extern void ContextInstallTimers(ContextPtr ptr);
+extern void ContextInstallTextCoding(ContextPtr ptr);
+extern void ContextInstallPerformance(ContextPtr ptr, double resolution);
+extern void ContextInstallCrypto(ContextPtr ptr);
+extern RtnTimers ContextRunTimers(ContextPtr ptr);
+// ContextTrackAtomicsWaitAsync wraps Atomics.waitAsync of the context to
+// count its promises until they settle, see RtnTimers.
+extern void ContextTrackAtomicsWaitAsync(ContextPtr ptr);
+extern void ContextEnterValueScope(ContextPtr ctx_ptr);
+extern void ContextExitValueScope(ContextPtr ctx_ptr);
+extern void ValueScopeEscape(ValuePtr ptr);
 extern RtnValue RunScript(ContextPtr ctx_ptr,
-                          const char* source,
-                          const char* origin);
-extern RtnValue JSONParse(ContextPtr ctx_ptr, const char* str);
-const char* JSONStringify(ContextPtr ctx_ptr, ValuePtr val_ptr);
+                          StringArg source,
+                          StringArg origin);
+extern RtnModule ContextCompileModule(ContextPtr ctx_ptr,
+                                      StringArg source,
+                                      StringArg origin,
+                                      CompileOptions options);
+extern RtnValue ModuleInstantiate(ModulePtr ptr, int resolver_ref);
+extern RtnValue ModuleEvaluate(ModulePtr ptr);
+extern int ModuleGetStatus(ModulePtr ptr);
+extern ValuePtr ModuleGetNamespace(ModulePtr ptr);
+extern ValuePtr ModuleGetException(ModulePtr ptr);
+extern ScriptCompilerCachedData* ModuleCreateCodeCache(ModulePtr ptr);
+extern void ModuleRelease(ModulePtr ptr);
+extern void IsolateSetDynamicImport(IsolatePtr iso_ptr, int enabled);
+extern RtnFunction ContextCompileFunction(ContextPtr ctx_ptr,
+                                          StringArg source,
+                                          StringArg origin,
+                                          int argc,
+                                          const char* args[],
+                                          int extc,
+                                          ValuePtr exts[],
+                                          CompileOptions options);
+extern RtnValue JSONParse(ContextPtr ctx_ptr, StringArg str);
+// JSONStringify calls JSON.stringify of the context when replacer is not
+// NULL, and JSON::Stringify otherwise, indenting with gap when it is not
+// empty.
+RtnUtf8 JSONStringify(ContextPtr ctx_ptr,
+                      ValuePtr val_ptr,
+                      ValuePtr replacer,
+                      StringArg gap,
+                      char* buf,
+                      int cap);
 extern ValuePtr ContextGlobal(ContextPtr ctx_ptr);
 
 extern void TemplateFreeWrapper(TemplatePtr ptr);
+// TemplatesFree resets the handles of n templates of iso and frees them.
+extern void TemplatesFree(IsolatePtr iso, TemplatePtr* tmpls, int n);
 extern void TemplateSetValue(TemplatePtr ptr,
                              const char* name,
                              ValuePtr val_ptr,
@@ -213,21 +1052,56 @@ extern int TemplateSetAnyTemplate(TemplatePtr ptr,
                                   TemplatePtr obj_ptr,
                                   int attributes);
 
+// TemplateSetLazyTemplate sets a property that is only instantiated from
+// the template obj on its first access.
+extern void TemplateSetLazyTemplate(TemplatePtr ptr,
+                                    const char* name,
+                                    TemplatePtr obj,
+                                    int attributes);
+
 extern TemplatePtr NewObjectTemplate(IsolatePtr iso_ptr);
 extern RtnValue ObjectTemplateNewInstance(TemplatePtr ptr, ContextPtr ctx_ptr);
 extern void ObjectTemplateSetInternalFieldCount(TemplatePtr ptr,
                                                 int field_count);
 extern int ObjectTemplateInternalFieldCount(TemplatePtr ptr);
+extern void ObjectTemplateSetAccessor(TemplatePtr ptr,
+                                      const char* name,
+                                      int callback_ref,
+                                      int has_setter,
+                                      int attributes,
+                                      int kind);
+extern void ObjectTemplateSetHandler(TemplatePtr ptr,
+                                     int callback_ref,
+                                     int indexed,
+                                     int ops);
 
-extern TemplatePtr NewFunctionTemplate(IsolatePtr iso_ptr, int callback_ref);
+extern TemplatePtr NewFunctionTemplate(IsolatePtr iso_ptr,
+                                       int callback_ref,
+                                       FunctionTemplateOptions options);
+extern TemplatePtr FunctionTemplatePrototypeTemplate(TemplatePtr ptr);
+extern TemplatePtr FunctionTemplateInstanceTemplate(TemplatePtr ptr);
+extern void FunctionTemplateInherit(TemplatePtr ptr, TemplatePtr parent);
+extern void FunctionTemplateSetClassName(TemplatePtr ptr, const char* name);
+extern ValuePtr CallbackInfoThis(CallbackInfoPtr ptr);
+extern ValuePtr CallbackInfoArg(CallbackInfoPtr ptr, int idx);
 extern RtnValue FunctionTemplateGetFunction(TemplatePtr ptr,
                                             ContextPtr ctx_ptr);
 
 extern ValuePtr NewValueNull(IsolatePtr iso_ptr);
 extern ValuePtr NewValueUndefined(IsolatePtr iso_ptr);
+extern ValuePtr NewValueExternal(IsolatePtr iso_ptr, uintptr_t handle);
+extern uintptr_t ValueToExternal(ValuePtr ptr);
 extern ValuePtr NewValueInteger(IsolatePtr iso_ptr, int32_t v);
 extern ValuePtr NewValueIntegerFromUnsigned(IsolatePtr iso_ptr, uint32_t v);
-extern RtnValue NewValueString(IsolatePtr iso_ptr, const char* v, int v_length);
+extern RtnValue NewValueString(IsolatePtr iso_ptr, StringArg v);
+extern CacheStats IsolateStringCacheStats(IsolatePtr iso_ptr);
+
+// NewIntlFormattersTemplate creates the template of an object whose methods,
+// by the names of the Intl formatter constructors, return the formatters that
+// the isolate keeps for their locales and options, see
+// IsolateIntlFormatterStats.
+extern TemplatePtr NewIntlFormattersTemplate(IsolatePtr iso_ptr);
+extern CacheStats IsolateIntlFormatterStats(IsolatePtr iso_ptr);
 extern ValuePtr NewValueBoolean(IsolatePtr iso_ptr, int v);
 extern ValuePtr NewValueNumber(IsolatePtr iso_ptr, double v);
 extern ValuePtr NewValueBigInt(IsolatePtr iso_ptr, int64_t v);
@@ -237,17 +1111,38 @@ extern RtnValue NewValueBigIntFromWords(IsolatePtr iso_ptr,
                                         int word_count,
                                         const uint64_t* words);
 extern ValuePtr NewValueError(IsolatePtr iso_ptr, ErrorTypeIndex idx, const char* message);
-extern RtnString ValueToString(ValuePtr ptr);
+// ValueRelease releases the value, unless it is cached by the isolate or its
+// slot is no longer of the generation gen, because the value has been
+// released already. It returns 0 for a cached value.
+extern int ValueRelease(ValuePtr ptr, uint32_t gen);
+// ValueReleaseDeferred queues the value for release by the next call into its
+// context, if its slot is still of the generation gen by then. It does not
+// lock the isolate, and can be called from any thread while the context is
+// open.
+extern void ValueReleaseDeferred(ValuePtr ptr, uint32_t gen);
+extern RtnUtf8 ValueToUtf8(ValuePtr ptr, char* buf, int cap);
+// ValueToUtf8Hash is ValueToUtf8 that also returns the hash of the string,
+// if it is written and its length is at most max_length.
+extern RtnUtf8 ValueToUtf8Hash(ValuePtr ptr,
+                               char* buf,
+                               int cap,
+                               int max_length);
+// StringWriteUtf8 writes the UTF-8 of the string of a RtnUtf8 into buf of
+// length bytes, and returns the length of the UTF-8, which is longer than
+// length if the string is a one-byte string that is not ASCII and does not
+// fit, in which case buf is left undefined.
+extern int StringWriteUtf8(ValuePtr ptr, char* buf, int length);
 const uint32_t* ValueToArrayIndex(ValuePtr ptr);
 int ValueToBoolean(ValuePtr ptr);
 int32_t ValueToInt32(ValuePtr ptr);
 int64_t ValueToInteger(ValuePtr ptr);
 double ValueToNumber(ValuePtr ptr);
-RtnString ValueToDetailString(ValuePtr ptr);
+RtnUtf8 ValueToDetailString(ValuePtr ptr, char* buf, int cap);
 uint32_t ValueToUint32(ValuePtr ptr);
 extern ValueBigInt ValueToBigInt(ValuePtr ptr);
 extern RtnValue ValueToObject(ValuePtr ptr);
 int ValueSameValue(ValuePtr ptr, ValuePtr otherPtr);
+uint64_t ValueTypeOf(ValuePtr ptr);
 int ValueIsUndefined(ValuePtr ptr);
 int ValueIsNull(ValuePtr ptr);
 int ValueIsNullOrUndefined(ValuePtr ptr);
@@ -303,7 +1198,7 @@ int ValueIsProxy(ValuePtr ptr);
 int ValueIsWasmModuleObject(ValuePtr ptr);
 int ValueIsModuleNamespaceObject(ValuePtr ptr);
 
-extern const char* ExceptionGetMessageString(ValuePtr ptr);
+extern RtnUtf8 ExceptionGetMessageString(ValuePtr ptr, char* buf, int cap);
 
 extern void ObjectSet(ValuePtr ptr, const char* key, ValuePtr val_ptr);
 extern void ObjectSetAnyKey(ValuePtr ptr, ValuePtr key, ValuePtr val_ptr);
@@ -313,22 +1208,140 @@ extern int ObjectInternalFieldCount(ValuePtr ptr);
 extern RtnValue ObjectGet(ValuePtr ptr, const char* key);
 extern RtnValue ObjectGetAnyKey(ValuePtr ptr, ValuePtr key);
 extern RtnValue ObjectGetIdx(ValuePtr ptr, uint32_t idx);
+extern RtnBulk ValueExport(ValuePtr ptr);
+// ObjectPropertyNames writes the string names of the properties of the
+// object, of its own or also of its prototypes as mode is a
+// KeyCollectionMode, that pass the filter of PropertyFilterBits, as a
+// BULK_ARRAY. Each name is a BULK_STRING, followed by the value of the
+// property if entries is set; values that are objects are BULK_VALUE.
+extern RtnBulk ObjectPropertyNames(ValuePtr ptr,
+                                   int mode,
+                                   int filter,
+                                   int entries);
+// ObjectCollectionEntries writes the keys and values of a Map in turn, if map
+// is set, or else the values of a Set, as a BULK_ARRAY of their primitives
+// and BULK_VALUE objects.
+extern RtnBulk ObjectCollectionEntries(ValuePtr ptr, int map);
+extern RtnValue ContextImport(ContextPtr ctx_ptr,
+                              const char* data,
+                              ValuePtr* values);
+// IsolateNewShape registers the keys of the objects of a Go struct type,
+// count untagged bulk strings, and returns the id of the shape.
+extern uint32_t IsolateNewShape(IsolatePtr iso_ptr,
+                                const char* keys,
+                                int count);
 extern ValuePtr ObjectGetInternalField(ValuePtr ptr, int idx);
+// The aligned pointer of an internal field holds a Go Handle shifted left by
+// one, so that V8 can tell it from a tagged value; 0 is returned for a field
+// that holds a value or an index that is out of range.
+extern int ObjectSetAlignedPointerInInternalField(ValuePtr ptr,
+                                                  int idx,
+                                                  uintptr_t handle);
+extern uintptr_t ObjectGetAlignedPointerFromInternalField(ValuePtr ptr,
+                                                          int idx);
 int ObjectHas(ValuePtr ptr, const char* key);
 int ObjectHasAnyKey(ValuePtr ptr, ValuePtr key);
 int ObjectHasIdx(ValuePtr ptr, uint32_t idx);
 int ObjectDelete(ValuePtr ptr, const char* key);
+// ObjectSetWeak has the object's finalizer ref queued once it is collected,
+// see IsolateDrainFinalizedObjects.
+extern void ObjectSetWeak(ValuePtr ptr, int ref);
+extern size_t IsolateDrainFinalizedObjects(IsolatePtr ptr,
+                                           int* refs,
+                                           size_t n);
 int ObjectDeleteAnyKey(ValuePtr ptr, ValuePtr key);
 int ObjectDeleteIdx(ValuePtr ptr, uint32_t idx);
+// ObjectCopyFloat64 and ObjectCopyInt32 copy the first n elements of an Array
+// or TypedArray to dst, as by ToNumber and ToInt32, setting done to the
+// number of elements copied.
+extern RtnError ObjectCopyFloat64(ValuePtr ptr,
+                                  double* dst,
+                                  size_t n,
+                                  size_t* done);
+extern RtnError ObjectCopyInt32(ValuePtr ptr,
+                                int32_t* dst,
+                                size_t n,
+                                size_t* done);
+
+extern ValuePtr NewPropertyKey(IsolatePtr iso_ptr, const char* name, int length);
 
 ValuePtr BuiltinSymbol(IsolatePtr iso_ptr, SymbolIndex idx);
-const char* SymbolDescription(ValuePtr ptr);
+RtnUtf8 SymbolDescription(ValuePtr ptr, char* buf, int cap);
+
+extern RtnValue NewArrayBuffer(ContextPtr ctx_ptr,
+                               const void* data,
+                               size_t byte_length);
+// NewArrayBufferAdopted creates an ArrayBuffer whose backing store is data,
+// byte_length bytes allocated with malloc, which it frees; it counts against
+// the quota of the isolate, and data is freed if it does not fit.
+extern RtnValue NewArrayBufferAdopted(ContextPtr ctx_ptr,
+                                      void* data,
+                                      size_t byte_length);
+extern ArrayBufferContents ValueArrayBufferContents(ValuePtr ptr);
+extern ValuePtr ArrayBufferViewBuffer(ValuePtr ptr);
+extern BackingStorePtr NewSharedBackingStore(const void* data,
+                                             size_t byte_length);
+extern ArrayBufferContents BackingStoreContents(BackingStorePtr ptr);
+extern void BackingStoreRelease(BackingStorePtr ptr);
+extern ValuePtr NewSharedArrayBuffer(ContextPtr ctx_ptr, BackingStorePtr ptr);
+extern BackingStorePtr SharedArrayBufferBackingStore(ValuePtr ptr);
+
+// ContextSerialize serializes val with a ValueSerializer, transferring the
+// ArrayBuffers of transfers, which are detached, to the serialized value.
+extern RtnSerialized ContextSerialize(ContextPtr ctx,
+                                      ValuePtr val,
+                                      ValuePtr* transfers,
+                                      int transfers_count);
+// ContextDeserialize moves the transferred buffers of ptr, on its first call,
+// to the deserialized value.
+extern RtnValue ContextDeserialize(ContextPtr ctx, SerializedPtr ptr);
+extern SerializedPtr NewSerialized(const void* data, size_t length);
+extern ArrayBufferContents SerializedData(SerializedPtr ptr);
+extern void SerializedRelease(SerializedPtr ptr);
+
+extern RtnValue ContextCompileWasmModule(ContextPtr ctx,
+                                         const void* data,
+                                         size_t length);
+// ContextNewWasmStream starts the compilation of a module by
+// WebAssembly.compileStreaming, which deserializes its code from cache if V8
+// accepts it. The bytes of the module are written to the stream, which is
+// then finished, running the isolate's tasks until the module is compiled, or
+// aborted; either frees it.
+extern RtnWasmStream ContextNewWasmStream(ContextPtr ctx,
+                                          const void* cache,
+                                          size_t cache_length);
+extern void WasmStreamWrite(WasmStreamPtr ptr, const void* data, size_t length);
+extern RtnValue WasmStreamFinish(WasmStreamPtr ptr, int* cache_accepted);
+extern void WasmStreamAbort(WasmStreamPtr ptr, ValuePtr exception);
+extern CompiledWasmModulePtr WasmModuleObjectGetCompiledModule(ValuePtr ptr);
+extern RtnValue NewWasmModuleObject(ContextPtr ctx, CompiledWasmModulePtr ptr);
+extern ArrayBufferContents CompiledWasmModuleWireBytes(
+    CompiledWasmModulePtr ptr);
+// CompiledWasmModuleSerialize returns the serialized code of the module in
+// memory that the caller frees.
+extern ArrayBufferContents CompiledWasmModuleSerialize(
+    CompiledWasmModulePtr ptr);
+extern void CompiledWasmModuleRelease(CompiledWasmModulePtr ptr);
+
+// NewRegExp compiles pattern with the RegExp::Flags flags; a backtrack_limit
+// other than 0 makes an exec fail to match once it has backtracked that often.
+extern RtnValue NewRegExp(ContextPtr ctx_ptr,
+                          StringArg pattern,
+                          int flags,
+                          uint32_t backtrack_limit);
 
 extern RtnValue NewPromiseResolver(ContextPtr ctx_ptr);
 extern ValuePtr PromiseResolverGetPromise(ValuePtr ptr);
 int PromiseResolverResolve(ValuePtr ptr, ValuePtr val_ptr);
 int PromiseResolverReject(ValuePtr ptr, ValuePtr val_ptr);
 int PromiseState(ValuePtr ptr);
+// PromiseResolversSettle resolves or rejects the promises of n resolvers of
+// the same isolate with vals, and returns how many were settled.
+extern int PromiseResolversSettle(ValuePtr* resolvers,
+                                  ValuePtr* vals,
+                                  int n,
+                                  int reject);
+extern void PromiseStates(ValuePtr* promises, int n, int* states);
 RtnValue PromiseThen(ValuePtr ptr, int callback_ref);
 RtnValue PromiseThen2(ValuePtr ptr, int on_fulfilled_ref, int on_rejected_ref);
 RtnValue PromiseCatch(ValuePtr ptr, int callback_ref);
@@ -338,11 +1351,30 @@ extern RtnValue FunctionCall(ValuePtr ptr,
                              ValuePtr recv,
                              int argc,
                              ValuePtr argv[]);
+// FunctionCallBatch calls the function once for each of calls argument
+// lists, the ith of which has argcs[i] of the values of args, in order. The
+// results are stored in results or, when it is NULL, converted to numbers in
+// numbers. It stops at the first exception, with done set to the number of
+// completed calls.
+extern RtnError FunctionCallBatch(ValuePtr ptr,
+                                  ValuePtr recv,
+                                  int calls,
+                                  int argcs[],
+                                  ValuePtr args[],
+                                  ValuePtr results[],
+                                  double numbers[],
+                                  int* done);
+extern PreparedCall FunctionPrepareCall(ValuePtr ptr, ValuePtr recv, int argc);
+extern RtnValue PreparedCallInvoke(PreparedCallPtr ptr);
+extern RtnNumber PreparedCallInvokeNumber(PreparedCallPtr ptr);
+extern void PreparedCallRelease(PreparedCallPtr ptr);
 RtnValue FunctionNewInstance(ValuePtr ptr, int argc, ValuePtr args[]);
 ValuePtr FunctionSourceMapUrl(ValuePtr ptr);
+extern ScriptCompilerCachedData* FunctionCreateCodeCache(ValuePtr ptr);
 
 const char* Version();
 extern void SetFlags(const char* flags);
+extern uint32_t CachedDataVersionTag();
 
 #ifdef __cplusplus
 }  // extern "C"
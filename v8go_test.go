@@ -5,7 +5,12 @@
 package v8go_test
 
 import (
+	"fmt"
+	"io/ioutil"
+	"os"
+	"os/exec"
 	"regexp"
+	"strings"
 	"testing"
 
 	v8 "rogchap.com/v8go"
@@ -37,3 +42,101 @@ func TestSetFlag(t *testing.T) {
 		t.Errorf("expected <nil> error, but got: %v", err)
 	}
 }
+
+func TestSetPlatformOptions(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	if err := v8.SetPlatformOptions(v8.PlatformOptions{ThreadPoolSize: -1}); err == nil {
+		t.Error("expected an error for a negative thread pool size")
+	}
+	if err := v8.SetPlatformOptions(v8.PlatformOptions{Perf: 7}); err == nil || err == v8.ErrPlatformInitialized {
+		t.Errorf("expected an error for an unknown PerfMode, got %v", err)
+	}
+	if err := v8.SetPlatformOptions(v8.PlatformOptions{ThreadPoolSize: 2}); err != v8.ErrPlatformInitialized {
+		t.Errorf("expected ErrPlatformInitialized, got %v", err)
+	}
+}
+
+// TestWorkerPoolPlatform runs in a process of its own, as the platform has to
+// be configured before the first isolate of the process is created.
+func TestWorkerPoolPlatform(t *testing.T) {
+	if os.Getenv("V8GO_TEST_WORKER_POOL") == "" {
+		t.Parallel()
+		cmd := exec.Command(os.Args[0], "-test.run=^TestWorkerPoolPlatform$", "-test.v")
+		cmd.Env = append(os.Environ(), "V8GO_TEST_WORKER_POOL=1")
+		if out, err := cmd.CombinedOutput(); err != nil {
+			t.Fatalf("%v\n%s", err, out)
+		}
+		return
+	}
+
+	fatalIf(t, v8.SetPlatformOptions(v8.PlatformOptions{ThreadPoolSize: 2, WorkerPool: true}))
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+	// Enough garbage for concurrent marking to kick in.
+	_, err := ctx.RunScript(`
+		let keep = [];
+		for (let i = 0; i < 200000; i++) {
+			keep.push({ i, s: "x" + i });
+			if (keep.length > 50000) keep = [];
+		}
+	`, "garbage.js")
+	fatalIf(t, err)
+	iso.LowMemoryNotification()
+
+	stats := v8.GetPlatformStatistics()
+	if stats.WorkerThreads != 2 {
+		t.Errorf("expected 2 worker threads, got %d", stats.WorkerThreads)
+	}
+	if stats.CompletedTasks == 0 || stats.TotalRunTime <= 0 {
+		t.Errorf("expected worker tasks to have run on the pool, got %+v", stats)
+	}
+	if stats.MaxQueueTime > stats.TotalQueueTime {
+		t.Errorf("expected the longest wait to be part of the total, got %+v", stats)
+	}
+}
+
+// TestPerfMap runs in a process of its own, like TestWorkerPoolPlatform.
+func TestPerfMap(t *testing.T) {
+	if os.Getenv("V8GO_TEST_PERF_MAP") == "" {
+		t.Parallel()
+		cmd := exec.Command(os.Args[0], "-test.run=^TestPerfMap$", "-test.v")
+		cmd.Env = append(os.Environ(), "V8GO_TEST_PERF_MAP=1")
+		if out, err := cmd.CombinedOutput(); err != nil {
+			t.Fatalf("%v\n%s", err, out)
+		}
+		return
+	}
+
+	fatalIf(t, v8.SetPlatformOptions(v8.PlatformOptions{Perf: v8.PerfMap}))
+	path := fmt.Sprintf("/tmp/perf-%d.map", os.Getpid())
+	defer os.Remove(path)
+	for _, name := range []string{"perfMapFirst", "perfMapSecond"} {
+		iso := v8.NewIsolate()
+		ctx := v8.NewContext(iso)
+		_, err := ctx.RunScript(fmt.Sprintf("function %s(i) { return i + 1 }; for (let i = 0; i < 10; i++) %[1]s(i)", name), name+".js")
+		fatalIf(t, err)
+		ctx.Close()
+		iso.Dispose()
+	}
+
+	data, err := ioutil.ReadFile(path)
+	fatalIf(t, err)
+	lines := strings.Split(strings.TrimSuffix(string(data), "\n"), "\n")
+	for _, line := range lines {
+		var start, size uint64
+		var name string
+		if n, _ := fmt.Sscanf(line, "%x %x %s", &start, &size, &name); n != 3 || size == 0 {
+			t.Fatalf("unexpected line %q", line)
+		}
+	}
+	// The map of the first isolate is kept by the second.
+	for _, name := range []string{"perfMapFirst", "perfMapSecond"} {
+		if !strings.Contains(string(data), name) {
+			t.Errorf("expected %s in the map of %d lines", name, len(lines))
+		}
+	}
+}
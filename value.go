@@ -11,7 +11,9 @@ import (
 	"errors"
 	"fmt"
 	"io"
+	"math"
 	"math/big"
+	"runtime"
 	"unsafe"
 )
 
@@ -19,6 +21,14 @@ import (
 type Value struct {
 	ptr C.ValuePtr
 	ctx *Context
+	// gen is the generation of the slot of ptr when the value was returned,
+	// which tells a release of this value from one of a later value that has
+	// been given the same slot.
+	gen uint32
+
+	// types caches the result of ValueTypeOf, a bit for each of the Is*
+	// predicates, plus valueTypesKnown once it has been fetched.
+	types uint64
 }
 
 // Valuer is an interface that reperesents anything that extends from a Value
@@ -31,26 +41,20 @@ func (v *Value) value() *Value {
 	return v
 }
 
-func newValueNull(iso *Isolate) *Value {
-	return &Value{
-		ptr: C.NewValueNull(iso.ptr),
-	}
-}
-
-func newValueUndefined(iso *Isolate) *Value {
-	return &Value{
-		ptr: C.NewValueUndefined(iso.ptr),
-	}
-}
-
 // Undefined returns the `undefined` JS value
 func Undefined(iso *Isolate) *Value {
-	return iso.undefined
+	return iso.cachedValue(C.CACHED_VALUE_UNDEFINED)
 }
 
 // Null returns the `null` JS value
 func Null(iso *Isolate) *Value {
-	return iso.null
+	return iso.cachedValue(C.CACHED_VALUE_NULL)
+}
+
+// NewExternal creates an External value, a JS value that holds the handle h
+// for JavaScript to pass around, and Value.External to read back.
+func NewExternal(iso *Isolate, h Handle) *Value {
+	return newValue(nil, C.NewValueExternal(iso.ptr, C.uintptr_t(h)))
 }
 
 // NewValue will create a primitive value. Supported values types to create are:
@@ -70,50 +74,43 @@ func NewValue(iso *Isolate, val interface{}) (*Value, error) {
 
 	switch v := val.(type) {
 	case string:
-		cstr := C.CString(v)
-		defer C.free(unsafe.Pointer(cstr))
-		rtn := C.NewValueString(iso.ptr, cstr, C.int(len(v)))
+		rtn := C.NewValueString(iso.ptr, iso.newStringArg(v))
+		runtime.KeepAlive(v)
 		return valueResult(nil, rtn)
 	case int32:
-		rtnVal = &Value{
-			ptr: C.NewValueInteger(iso.ptr, C.int(v)),
+		if cached, ok := iso.cachedInt(int64(v)); ok {
+			return cached, nil
 		}
+		rtnVal = newValue(nil, C.NewValueInteger(iso.ptr, C.int(v)))
 	case uint32:
-		rtnVal = &Value{
-			ptr: C.NewValueIntegerFromUnsigned(iso.ptr, C.uint(v)),
+		if cached, ok := iso.cachedInt(int64(v)); ok {
+			return cached, nil
 		}
+		rtnVal = newValue(nil, C.NewValueIntegerFromUnsigned(iso.ptr, C.uint(v)))
 	case int64:
-		rtnVal = &Value{
-			ptr: C.NewValueBigInt(iso.ptr, C.int64_t(v)),
-		}
+		rtnVal = newValue(nil, C.NewValueBigInt(iso.ptr, C.int64_t(v)))
 	case uint64:
-		rtnVal = &Value{
-			ptr: C.NewValueBigIntFromUnsigned(iso.ptr, C.uint64_t(v)),
-		}
+		rtnVal = newValue(nil, C.NewValueBigIntFromUnsigned(iso.ptr, C.uint64_t(v)))
 	case bool:
-		var b int
 		if v {
-			b = 1
-		}
-		rtnVal = &Value{
-			ptr: C.NewValueBoolean(iso.ptr, C.int(b)),
+			return iso.cachedValue(C.CACHED_VALUE_TRUE), nil
 		}
+		return iso.cachedValue(C.CACHED_VALUE_FALSE), nil
 	case float64:
-		rtnVal = &Value{
-			ptr: C.NewValueNumber(iso.ptr, C.double(v)),
+		if n := int64(v); float64(n) == v && !(n == 0 && math.Signbit(v)) {
+			if cached, ok := iso.cachedInt(n); ok {
+				return cached, nil
+			}
 		}
+		rtnVal = newValue(nil, C.NewValueNumber(iso.ptr, C.double(v)))
 	case *big.Int:
 		if v.IsInt64() {
-			rtnVal = &Value{
-				ptr: C.NewValueBigInt(iso.ptr, C.int64_t(v.Int64())),
-			}
+			rtnVal = newValue(nil, C.NewValueBigInt(iso.ptr, C.int64_t(v.Int64())))
 			break
 		}
 
 		if v.IsUint64() {
-			rtnVal = &Value{
-				ptr: C.NewValueBigIntFromUnsigned(iso.ptr, C.uint64_t(v.Uint64())),
-			}
+			rtnVal = newValue(nil, C.NewValueBigIntFromUnsigned(iso.ptr, C.uint64_t(v.Uint64())))
 			break
 		}
 
@@ -197,13 +194,14 @@ func (v *Value) Boolean() bool {
 
 // DetailString provide a string representation of this value usable for debugging.
 func (v *Value) DetailString() string {
-	rtn := C.ValueToDetailString(v.ptr)
-	if rtn.data == nil {
-		err := newJSError(rtn.error)
+	s, rtnErr := utf8String(func(buf *C.char, cap C.int) C.RtnUtf8 {
+		return C.ValueToDetailString(v.ptr, buf, cap)
+	})
+	if hasError(rtnErr) {
+		err := newJSError(rtnErr)
 		panic(err) // TODO: Return a fallback value
 	}
-	defer C.free(unsafe.Pointer(rtn.data))
-	return C.GoStringN(rtn.data, rtn.length)
+	return s
 }
 
 // Int32 perform the equivalent of `Number(value)` in JS and convert the result to a
@@ -239,9 +237,13 @@ func (v *Value) Object() *Object {
 // are returned as-is, objects will return `[object Object]` and functions will
 // print their definition.
 func (v *Value) String() string {
-	s := C.ValueToString(v.ptr)
-	defer C.free(unsafe.Pointer(s.data))
-	return C.GoStringN(s.data, C.int(s.length))
+	if v.ctx != nil && v.ctx.iso.interned != nil {
+		return v.ctx.iso.interned.valueString(v.ptr)
+	}
+	s, _ := utf8String(func(buf *C.char, cap C.int) C.RtnUtf8 {
+		return C.ValueToUtf8(v.ptr, buf, cap)
+	})
+	return s
 }
 
 // Uint32 perform the equivalent of `Number(value)` in JS and convert the result to an
@@ -253,294 +255,314 @@ func (v *Value) Uint32() uint32 {
 // SameValue returns true if the other value is the same value.
 // This is equivalent to `Object.is(v, other)` in JS.
 func (v *Value) SameValue(other *Value) bool {
-	return C.ValueSameValue(v.ptr, other.ptr) != 0
+	same := C.ValueSameValue(v.ptr, other.ptr) != 0
+	runtime.KeepAlive(other)
+	return same
+}
+
+// valueTypesKnown marks Value.types as fetched.
+const valueTypesKnown = 1 << 63
+
+// is reports whether the bit for the predicate at index bit of ValueTypeBit is
+// set, fetching all of them with a single call the first time. The types of a
+// value never change, so they do not need to be fetched again.
+func (v *Value) is(bit C.ValueTypeBit) bool {
+	if v.types == 0 {
+		v.types = uint64(C.ValueTypeOf(v.ptr)) | valueTypesKnown
+	}
+	return v.types&(1<<bit) != 0
 }
 
 // IsUndefined returns true if this value is the undefined value. See ECMA-262 4.3.10.
 func (v *Value) IsUndefined() bool {
-	return C.ValueIsUndefined(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_UNDEFINED)
 }
 
 // IsNull returns true if this value is the null value. See ECMA-262 4.3.11.
 func (v *Value) IsNull() bool {
-	return C.ValueIsNull(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_NULL)
 }
 
 // IsNullOrUndefined returns true if this value is either the null or the undefined value.
 // See ECMA-262 4.3.11. and 4.3.12
 // This is equivalent to `value == null` in JS.
 func (v *Value) IsNullOrUndefined() bool {
-	return C.ValueIsNullOrUndefined(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_NULL_OR_UNDEFINED)
 }
 
 // IsTrue returns true if this value is true.
 // This is not the same as `BooleanValue()`. The latter performs a conversion to boolean,
 // i.e. the result of `Boolean(value)` in JS, whereas this checks `value === true`.
 func (v *Value) IsTrue() bool {
-	return C.ValueIsTrue(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_TRUE)
 }
 
 // IsFalse returns true if this value is false.
 // This is not the same as `!BooleanValue()`. The latter performs a conversion to boolean,
 // i.e. the result of `!Boolean(value)` in JS, whereas this checks `value === false`.
 func (v *Value) IsFalse() bool {
-	return C.ValueIsFalse(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_FALSE)
 }
 
 // IsName returns true if this value is a symbol or a string.
 // This is equivalent to `typeof value === 'string' || typeof value === 'symbol'` in JS.
 func (v *Value) IsName() bool {
-	return C.ValueIsName(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_NAME)
 }
 
 // IsString returns true if this value is an instance of the String type. See ECMA-262 8.4.
 // This is equivalent to `typeof value === 'string'` in JS.
 func (v *Value) IsString() bool {
-	return C.ValueIsString(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_STRING)
 }
 
 // IsSymbol returns true if this value is a symbol.
 // This is equivalent to `typeof value === 'symbol'` in JS.
 func (v *Value) IsSymbol() bool {
-	return C.ValueIsSymbol(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_SYMBOL)
 }
 
 // IsFunction returns true if this value is a function.
 // This is equivalent to `typeof value === 'function'` in JS.
 func (v *Value) IsFunction() bool {
-	return C.ValueIsFunction(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_FUNCTION)
 }
 
 // IsObject returns true if this value is an object.
 func (v *Value) IsObject() bool {
-	return v.ctx != nil && C.ValueIsObject(v.ptr) != 0
+	return v.ctx != nil && v.is(C.VALUE_TYPE_OBJECT)
 }
 
 // IsBigInt returns true if this value is a bigint.
 // This is equivalent to `typeof value === 'bigint'` in JS.
 func (v *Value) IsBigInt() bool {
-	return C.ValueIsBigInt(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_BIG_INT)
 }
 
 // IsBoolean returns true if this value is boolean.
 // This is equivalent to `typeof value === 'boolean'` in JS.
 func (v *Value) IsBoolean() bool {
-	return C.ValueIsBoolean(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_BOOLEAN)
 }
 
 // IsNumber returns true if this value is a number.
 // This is equivalent to `typeof value === 'number'` in JS.
 func (v *Value) IsNumber() bool {
-	return C.ValueIsNumber(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_NUMBER)
 }
 
 // IsExternal returns true if this value is an `External` object.
 func (v *Value) IsExternal() bool {
-	// TODO(rogchap): requires test case
-	return v.ctx != nil && C.ValueIsExternal(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_EXTERNAL)
+}
+
+// External returns the handle held by an External value created with
+// NewExternal, or the zero Handle if the value is not an External.
+func (v *Value) External() Handle {
+	return Handle(C.ValueToExternal(v.ptr))
 }
 
 // IsInt32 returns true if this value is a 32-bit signed integer.
 func (v *Value) IsInt32() bool {
-	return C.ValueIsInt32(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_INT32)
 }
 
 // IsUint32 returns true if this value is a 32-bit unsigned integer.
 func (v *Value) IsUint32() bool {
-	return C.ValueIsUint32(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_UINT32)
 }
 
 // IsDate returns true if this value is a `Date`.
 func (v *Value) IsDate() bool {
-	return C.ValueIsDate(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_DATE)
 }
 
 // IsArgumentsObject returns true if this value is an Arguments object.
 func (v *Value) IsArgumentsObject() bool {
-	return C.ValueIsArgumentsObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_ARGUMENTS_OBJECT)
 }
 
 // IsBigIntObject returns true if this value is a BigInt object.
 func (v *Value) IsBigIntObject() bool {
-	return C.ValueIsBigIntObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_BIG_INT_OBJECT)
 }
 
 // IsNumberObject returns true if this value is a `Number` object.
 func (v *Value) IsNumberObject() bool {
-	return C.ValueIsNumberObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_NUMBER_OBJECT)
 }
 
 // IsStringObject returns true if this value is a `String` object.
 func (v *Value) IsStringObject() bool {
-	return C.ValueIsStringObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_STRING_OBJECT)
 }
 
 // IsSymbolObject returns true if this value is a `Symbol` object.
 func (v *Value) IsSymbolObject() bool {
-	return C.ValueIsSymbolObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_SYMBOL_OBJECT)
 }
 
 // IsNativeError returns true if this value is a NativeError.
 func (v *Value) IsNativeError() bool {
-	return C.ValueIsNativeError(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_NATIVE_ERROR)
 }
 
 // IsRegExp returns true if this value is a `RegExp`.
 func (v *Value) IsRegExp() bool {
-	return C.ValueIsRegExp(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_REG_EXP)
 }
 
 // IsAsyncFunc returns true if this value is an async function.
 func (v *Value) IsAsyncFunction() bool {
-	return C.ValueIsAsyncFunction(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_ASYNC_FUNCTION)
 }
 
 // Is IsGeneratorFunc returns true if this value is a Generator function.
 func (v *Value) IsGeneratorFunction() bool {
-	return C.ValueIsGeneratorFunction(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_GENERATOR_FUNCTION)
 }
 
 // IsGeneratorObject returns true if this value is a Generator object (iterator).
 func (v *Value) IsGeneratorObject() bool {
-	return C.ValueIsGeneratorObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_GENERATOR_OBJECT)
 }
 
 // IsPromise returns true if this value is a `Promise`.
 func (v *Value) IsPromise() bool {
-	return C.ValueIsPromise(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_PROMISE)
 }
 
 // IsMap returns true if this value is a `Map`.
 func (v *Value) IsMap() bool {
-	return C.ValueIsMap(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_MAP)
 }
 
 // IsSet returns true if this value is a `Set`.
 func (v *Value) IsSet() bool {
-	return C.ValueIsSet(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_SET)
 }
 
 // IsMapIterator returns true if this value is a `Map` Iterator.
 func (v *Value) IsMapIterator() bool {
-	return C.ValueIsMapIterator(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_MAP_ITERATOR)
 }
 
 // IsSetIterator returns true if this value is a `Set` Iterator.
 func (v *Value) IsSetIterator() bool {
-	return C.ValueIsSetIterator(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_SET_ITERATOR)
 }
 
 // IsWeakMap returns true if this value is a `WeakMap`.
 func (v *Value) IsWeakMap() bool {
-	return C.ValueIsWeakMap(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_WEAK_MAP)
 }
 
 // IsWeakSet returns true if this value is a `WeakSet`.
 func (v *Value) IsWeakSet() bool {
-	return C.ValueIsWeakSet(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_WEAK_SET)
 }
 
 // IsArray returns true if this value is an array.
 // Note that it will return false for a `Proxy` of an array.
 func (v *Value) IsArray() bool {
-	return C.ValueIsArray(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_ARRAY)
 }
 
 // IsArrayBuffer returns true if this value is an `ArrayBuffer`.
 func (v *Value) IsArrayBuffer() bool {
-	return C.ValueIsArrayBuffer(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_ARRAY_BUFFER)
 }
 
 // IsArrayBufferView returns true if this value is an `ArrayBufferView`.
 func (v *Value) IsArrayBufferView() bool {
-	return C.ValueIsArrayBufferView(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_ARRAY_BUFFER_VIEW)
 }
 
 // IsTypedArray returns true if this value is one of TypedArrays.
 func (v *Value) IsTypedArray() bool {
-	return C.ValueIsTypedArray(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_TYPED_ARRAY)
 }
 
 // IsUint8Array returns true if this value is an `Uint8Array`.
 func (v *Value) IsUint8Array() bool {
-	return C.ValueIsUint8Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_UINT8_ARRAY)
 }
 
 // IsUint8ClampedArray returns true if this value is an `Uint8ClampedArray`.
 func (v *Value) IsUint8ClampedArray() bool {
-	return C.ValueIsUint8ClampedArray(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_UINT8_CLAMPED_ARRAY)
 }
 
 // IsInt8Array returns true if this value is an `Int8Array`.
 func (v *Value) IsInt8Array() bool {
-	return C.ValueIsInt8Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_INT8_ARRAY)
 }
 
 // IsUint16Array returns true if this value is an `Uint16Array`.
 func (v *Value) IsUint16Array() bool {
-	return C.ValueIsUint16Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_UINT16_ARRAY)
 }
 
 // IsInt16Array returns true if this value is an `Int16Array`.
 func (v *Value) IsInt16Array() bool {
-	return C.ValueIsInt16Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_INT16_ARRAY)
 }
 
 // IsUint32Array returns true if this value is an `Uint32Array`.
 func (v *Value) IsUint32Array() bool {
-	return C.ValueIsUint32Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_UINT32_ARRAY)
 }
 
 // IsInt32Array returns true if this value is an `Int32Array`.
 func (v *Value) IsInt32Array() bool {
-	return C.ValueIsInt32Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_INT32_ARRAY)
 }
 
 // IsFloat32Array returns true if this value is a `Float32Array`.
 func (v *Value) IsFloat32Array() bool {
-	return C.ValueIsFloat32Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_FLOAT32_ARRAY)
 }
 
 // IsFloat64Array returns true if this value is a `Float64Array`.
 func (v *Value) IsFloat64Array() bool {
-	return C.ValueIsFloat64Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_FLOAT64_ARRAY)
 }
 
 // IsBigInt64Array returns true if this value is a `BigInt64Array`.
 func (v *Value) IsBigInt64Array() bool {
-	return C.ValueIsBigInt64Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_BIG_INT64_ARRAY)
 }
 
 // IsBigUint64Array returns true if this value is a BigUint64Array`.
 func (v *Value) IsBigUint64Array() bool {
-	return C.ValueIsBigUint64Array(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_BIG_UINT64_ARRAY)
 }
 
 // IsDataView returns true if this value is a `DataView`.
 func (v *Value) IsDataView() bool {
-	return C.ValueIsDataView(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_DATA_VIEW)
 }
 
 // IsSharedArrayBuffer returns true if this value is a `SharedArrayBuffer`.
 func (v *Value) IsSharedArrayBuffer() bool {
-	return C.ValueIsSharedArrayBuffer(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_SHARED_ARRAY_BUFFER)
 }
 
 // IsProxy returns true if this value is a JavaScript `Proxy`.
 func (v *Value) IsProxy() bool {
-	return C.ValueIsProxy(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_PROXY)
 }
 
 // IsWasmModuleObject returns true if this value is a `WasmModuleObject`.
 func (v *Value) IsWasmModuleObject() bool {
 	// TODO(rogchap): requires test case
-	return C.ValueIsWasmModuleObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_WASM_MODULE_OBJECT)
 }
 
 // IsModuleNamespaceObject returns true if the value is a `Module` Namespace `Object`.
 func (v *Value) IsModuleNamespaceObject() bool {
 	// TODO(rogchap): requires test case
-	return C.ValueIsModuleNamespaceObject(v.ptr) != 0
+	return v.is(C.VALUE_TYPE_MODULE_NAMESPACE_OBJECT)
 }
 
 // AsObject will cast the value to the Object type. If the value is not an Object
@@ -576,6 +598,15 @@ func (v *Value) AsException() (*Exception, error) {
 	return &Exception{v}, nil
 }
 
+// AsWasmModuleObject will cast the value to the WasmModuleObject type. If the
+// value is not a WebAssembly.Module, an error is returned.
+func (v *Value) AsWasmModuleObject() (*WasmModuleObject, error) {
+	if !v.IsWasmModuleObject() {
+		return nil, errors.New("v8go: value is not a WasmModuleObject")
+	}
+	return &WasmModuleObject{&Object{v}}, nil
+}
+
 func (v *Value) AsFunction() (*Function, error) {
 	if !v.IsFunction() {
 		return nil, errors.New("v8go: value is not a Function")
@@ -583,11 +614,22 @@ func (v *Value) AsFunction() (*Function, error) {
 	return &Function{v}, nil
 }
 
+// Release frees the C++ memory held by this value without waiting for its
+// context to be closed. Long lived contexts should release values they no
+// longer need so that memory usage stays flat. The value, and any Object,
+// Function or other type wrapping it, must not be used after it has been
+// released; calling Release more than once is a no-op. The values cached by
+// the isolate, such as Undefined and Null, are immortal and never released.
+func (v *Value) Release() {
+	if v == nil || v.ptr == nil {
+		return
+	}
+	if C.ValueRelease(v.ptr, C.uint32_t(v.gen)) != 0 {
+		v.ptr = nil
+	}
+}
+
 // MarshalJSON implements the json.Marshaler interface.
 func (v *Value) MarshalJSON() ([]byte, error) {
-	jsonStr, err := JSONStringify(nil, v)
-	if err != nil {
-		return nil, err
-	}
-	return []byte(jsonStr), nil
+	return AppendJSON(nil, nil, v)
 }
@@ -0,0 +1,39 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+
+// ValueScope tracks the values created while it is open, similar to a V8
+// EscapableHandleScope. When the scope exits all of these values are released,
+// except for those that have been escaped.
+type ValueScope struct {
+	ctx *Context
+}
+
+// WithValueScope calls fn with a new ValueScope for the context. Every value
+// created in the context, or with its isolate, while fn runs is released
+// when fn returns, unless it is passed to (*ValueScope).Escape. This lets a
+// long lived context be reused across many requests without accumulating
+// values until the context is closed. Released values must not be used after
+// the scope has exited.
+func (c *Context) WithValueScope(fn func(scope *ValueScope)) {
+	C.ContextEnterValueScope(c.ptr)
+	defer C.ContextExitValueScope(c.ptr)
+	fn(&ValueScope{ctx: c})
+}
+
+// Escape keeps the value alive after the scope exits. If the scope is nested
+// within another scope, the value is handed over to the enclosing scope and
+// released when that scope exits, otherwise it lives until it is released or
+// its context is closed.
+func (s *ValueScope) Escape(v Valuer) *Value {
+	val := v.value()
+	if val != nil && val.ptr != nil {
+		C.ValueScopeEscape(val.ptr)
+	}
+	return val
+}
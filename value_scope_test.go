@@ -0,0 +1,48 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestContextWithValueScope(t *testing.T) {
+	t.Parallel()
+	ctx := v8.NewContext()
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	var escaped, nested *v8.Value
+	for i := 0; i < 100; i++ {
+		ctx.WithValueScope(func(scope *v8.ValueScope) {
+			val, err := ctx.RunScript("'scoped'", "scope.js")
+			fatalIf(t, err)
+			if val.String() != "scoped" {
+				t.Errorf("unexpected value: %q", val.String())
+			}
+			str, err := v8.NewValue(iso, "iso")
+			fatalIf(t, err)
+			str.Release()
+
+			escaped = scope.Escape(val)
+
+			ctx.WithValueScope(func(inner *v8.ValueScope) {
+				nested, err = ctx.RunScript("'nested'", "nested.js")
+				fatalIf(t, err)
+				inner.Escape(nested)
+			})
+			if nested.String() != "nested" {
+				t.Errorf("expected nested value to escape to the outer scope, got %q", nested.String())
+			}
+		})
+		if escaped.String() != "scoped" {
+			t.Errorf("expected escaped value to survive the scope, got %q", escaped.String())
+		}
+		escaped.Release()
+	}
+}
@@ -11,7 +11,9 @@ import (
 	"math/big"
 	"reflect"
 	"runtime"
+	"strings"
 	"testing"
+	"unsafe"
 
 	v8 "rogchap.com/v8go"
 )
@@ -98,6 +100,132 @@ func TestValueString(t *testing.T) {
 	}
 }
 
+func TestValueStringInterned(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate(v8.InternStrings(16))
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	stringData := func(s string) uintptr {
+		return (*reflect.StringHeader)(unsafe.Pointer(&s)).Data
+	}
+	val, err := ctx.RunScript(`["pending", "pen" + "ding", 42, "a much longer string than 16 bytes"]`, "")
+	fatalIf(t, err)
+	obj, _ := val.AsObject()
+	first, _ := obj.GetIdx(0)
+	concat, _ := obj.GetIdx(1)
+	s1, s2 := first.String(), concat.String()
+	if s1 != "pending" || s2 != "pending" {
+		t.Fatalf("unexpected strings %q, %q", s1, s2)
+	}
+	if stringData(s1) != stringData(s2) {
+		t.Error("expected equal strings to be interned as the same Go string")
+	}
+	if number, _ := obj.GetIdx(2); number.String() != "42" {
+		t.Errorf("unexpected string of a number %q", number.String())
+	}
+	long, _ := obj.GetIdx(3)
+	if l1, l2 := long.String(), long.String(); l1 != "a much longer string than 16 bytes" || stringData(l1) == stringData(l2) {
+		t.Errorf("expected a long string not to be interned, got %q", l1)
+	}
+
+	// Export interns the keys and strings of the values it converts.
+	val, err = ctx.RunScript(`[{state: "pending"}, {state: "pending"}]`, "")
+	fatalIf(t, err)
+	exported, err := val.Export()
+	fatalIf(t, err)
+	var keys, states []string
+	for _, elem := range exported.([]interface{}) {
+		for k, v := range elem.(map[string]interface{}) {
+			keys = append(keys, k)
+			states = append(states, v.(string))
+		}
+	}
+	if len(keys) != 2 || stringData(keys[0]) != stringData(keys[1]) || stringData(states[0]) != stringData(states[1]) {
+		t.Errorf("expected the exported strings to be interned, got %q, %q", keys, states)
+	}
+}
+
+func TestValueStringLatin1(t *testing.T) {
+	t.Parallel()
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	// Strings of Latin-1 characters are one-byte strings in V8, which are
+	// widened to UTF-8 around runs of ASCII, in place in a buffer that they
+	// may or may not fit.
+	patterns := map[string]func(i int) rune{
+		"ASCII":    func(i int) rune { return 'a' + rune(i%26) },
+		"Latin-1":  func(i int) rune { return 0xe9 },
+		"Mixed":    func(i int) rune { return map[bool]rune{true: 0xff, false: 'x'}[i%7 == 3] },
+		"Trailing": func(i int) rune { return map[bool]rune{true: 0xe0, false: '-'}[i%40 == 39] },
+	}
+	for name, pattern := range patterns {
+		for _, n := range []int{0, 1, 15, 16, 17, 33, 511, 512, 513, 1023, 1024, 1025, 3000, 60000} {
+			var want strings.Builder
+			for i := 0; i < n; i++ {
+				want.WriteRune(pattern(i))
+			}
+			// The string is passed in as UTF-16 code units, to come out as a
+			// one-byte string.
+			codes := make([]string, n)
+			for i := range codes {
+				codes[i] = fmt.Sprint(pattern(i))
+			}
+			val, err := ctx.RunScript(fmt.Sprintf("String.fromCharCode(%s)", strings.Join(codes, ",")), "")
+			fatalIf(t, err)
+			if got := val.String(); got != want.String() {
+				t.Errorf("%s of %d characters: unexpected string of %d bytes, want %d bytes", name, n, len(got), want.Len())
+			}
+			if n > 0 {
+				json, err := v8.JSONStringify(ctx, val)
+				fatalIf(t, err)
+				if json != `"`+want.String()+`"` {
+					t.Errorf("%s of %d characters: unexpected JSON of %d bytes", name, n, len(json))
+				}
+			}
+		}
+	}
+}
+
+func TestValueStringLarge(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	tests := [...]struct {
+		name string
+		str  string
+	}{
+		{"ASCII", strings.Repeat("abcdefgh", 1<<14)},
+		{"Non-ASCII", strings.Repeat("abcdefΩ", 1<<14)},
+		{"Longer than scratch buffer", strings.Repeat("x", 1500)},
+	}
+
+	for _, tt := range tests {
+		tt := tt
+		t.Run(tt.name, func(t *testing.T) {
+			val, err := v8.NewValue(iso, tt.str)
+			fatalIf(t, err)
+			if str := val.String(); str != tt.str {
+				t.Errorf("unexpected round trip of %d bytes: got %d bytes", len(tt.str), len(str))
+			}
+
+			// The same string as script source.
+			src := fmt.Sprintf("'%s'.length", tt.str)
+			length, err := ctx.RunScript(src, "large.js")
+			fatalIf(t, err)
+			if want := int32(len([]rune(tt.str))); length.Int32() != want {
+				t.Errorf("unexpected length: expected %d, got %d", want, length.Int32())
+			}
+		})
+	}
+}
+
 func TestNewValue(t *testing.T) {
 	t.Parallel()
 	ctx := v8.NewContext(nil)
@@ -703,6 +831,53 @@ func TestValueIsXXX(t *testing.T) {
 	}
 }
 
+func TestValueIsXXXExclusive(t *testing.T) {
+	t.Parallel()
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	// All predicates of a value are fetched at once; check that the ones that
+	// do not hold are not reported for values of related types.
+	tests := [...]struct {
+		source string
+		assert func(*v8.Value) bool
+		want   bool
+	}{
+		{"undefined", (*v8.Value).IsNull, false},
+		{"null", (*v8.Value).IsNullOrUndefined, true},
+		{"null", (*v8.Value).IsObject, false},
+		{"-1", (*v8.Value).IsUint32, false},
+		{"1.5", (*v8.Value).IsInt32, false},
+		{"'1'", (*v8.Value).IsNumber, false},
+		{"Symbol()", (*v8.Value).IsString, false},
+		{"10n", (*v8.Value).IsNumber, false},
+		{"new Uint8Array", (*v8.Value).IsArray, false},
+		{"new Uint8Array", (*v8.Value).IsInt8Array, false},
+		{"new DataView(new ArrayBuffer)", (*v8.Value).IsTypedArray, false},
+		{"new Proxy(function() {}, {})", (*v8.Value).IsFunction, true},
+		{"new Proxy(function() {}, {})", (*v8.Value).IsProxy, true},
+		{"new Proxy([], {})", (*v8.Value).IsArray, false},
+		{"() => {}", (*v8.Value).IsAsyncFunction, false},
+		{"new Map", (*v8.Value).IsWeakMap, false},
+	}
+	for _, tt := range tests {
+		val, err := ctx.RunScript(tt.source, "test.js")
+		fatalIf(t, err)
+		for i := 0; i < 2; i++ {
+			if got := tt.assert(val); got != tt.want {
+				t.Errorf("%s for %s is %v, want %v", runtime.FuncForPC(reflect.ValueOf(tt.assert).Pointer()).Name(), tt.source, got, tt.want)
+			}
+		}
+	}
+
+	one, _ := v8.NewValue(iso, int32(1))
+	if !one.IsInt32() || !one.IsUint32() || one.IsString() {
+		t.Error("unexpected types for cached value 1")
+	}
+}
+
 func TestValueMarshalJSON(t *testing.T) {
 	t.Parallel()
 	iso := v8.NewIsolate()
@@ -758,3 +933,190 @@ func TestValueMarshalJSON(t *testing.T) {
 		})
 	}
 }
+
+func TestValueRelease(t *testing.T) {
+	t.Parallel()
+	ctx := v8.NewContext()
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	keep, err := ctx.RunScript("'keep'", "keep.js")
+	fatalIf(t, err)
+
+	for i := 0; i < 1000; i++ {
+		val, err := ctx.RunScript("({a: 1})", "release.js")
+		fatalIf(t, err)
+		obj, err := val.AsObject()
+		fatalIf(t, err)
+		a, err := obj.Get("a")
+		fatalIf(t, err)
+		if a.Int32() != 1 {
+			t.Fatalf("expected 1, got %v", a)
+		}
+		a.Release()
+		obj.Release()
+
+		s, err := v8.NewValue(iso, "str")
+		fatalIf(t, err)
+		s.Release()
+		s.Release() // no-op
+	}
+
+	if keep.String() != "keep" {
+		t.Errorf("expected unreleased value to be unaffected, got %q", keep.String())
+	}
+}
+
+func TestValueReleaseStale(t *testing.T) {
+	t.Parallel()
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	var scoped *v8.Value
+	ctx.WithValueScope(func(*v8.ValueScope) {
+		var err error
+		scoped, err = ctx.RunScript("'scoped'", "scoped.js")
+		fatalIf(t, err)
+	})
+	// The slot of the released value is given to the next one, which a
+	// release of the stale value must leave alone.
+	vals := make([]*v8.Value, 8)
+	for i := range vals {
+		var err error
+		vals[i], err = ctx.RunScript(fmt.Sprintf("'v%d'", i), "reuse.js")
+		fatalIf(t, err)
+	}
+	scoped.Release()
+	scoped.Release()
+	for i, v := range vals {
+		if want := fmt.Sprintf("v%d", i); v.String() != want {
+			t.Errorf("expected %q, got %q", want, v.String())
+		}
+	}
+	for _, v := range vals {
+		v.Release()
+	}
+	more, err := ctx.RunScript("'more'", "more.js")
+	fatalIf(t, err)
+	if more.String() != "more" {
+		t.Errorf("expected \"more\", got %q", more.String())
+	}
+}
+
+func TestValueCachedPrimitives(t *testing.T) {
+	t.Parallel()
+	ctx := v8.NewContext()
+	iso := ctx.Isolate()
+	defer iso.Dispose()
+	defer ctx.Close()
+
+	tests := [...]struct {
+		name   string
+		a, b   interface{}
+		cached bool
+		js     string
+	}{
+		{"true", true, true, true, "true"},
+		{"false", false, false, true, "false"},
+		{"int32", int32(42), uint32(42), true, "42"},
+		{"negative", int32(-128), float64(-128), true, "-128"},
+		{"float64", float64(7), int32(7), true, "7"},
+		{"large", int32(1 << 20), int32(1 << 20), false, "1048576"},
+		{"fraction", 0.5, 0.5, false, "0.5"},
+		{"negative zero", math.Copysign(0, -1), math.Copysign(0, -1), false, "0"},
+	}
+
+	for _, tt := range tests {
+		tt := tt
+		t.Run(tt.name, func(t *testing.T) {
+			a, err := v8.NewValue(iso, tt.a)
+			fatalIf(t, err)
+			b, err := v8.NewValue(iso, tt.b)
+			fatalIf(t, err)
+			if (a == b) != tt.cached {
+				t.Errorf("expected cached to be %v", tt.cached)
+			}
+			a.Release()
+			if s := b.String(); s != tt.js {
+				t.Errorf("expected %q, got %q", tt.js, s)
+			}
+		})
+	}
+
+	negZero, _ := v8.NewValue(iso, math.Copysign(0, -1))
+	if !math.Signbit(negZero.Number()) {
+		t.Error("expected -0 to keep its sign")
+	}
+
+	v8.Undefined(iso).Release()
+	if !v8.Undefined(iso).IsUndefined() {
+		t.Error("expected Undefined to survive Release")
+	}
+}
+
+func BenchmarkValueString(b *testing.B) {
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	for _, bm := range [...]struct {
+		name   string
+		source string
+	}{
+		{"Short", `"pending"`},
+		{"ASCII", `"<div class='row'>text</div>".repeat(1 << 14)`},
+		{"ASCIIFlat", `JSON.parse(JSON.stringify("<div class='row'>text</div>".repeat(1 << 14)))`},
+		{"Latin1", `"<p>café</p>".repeat(1 << 14)`},
+		{"TwoByte", `"<p>Ωmega</p>".repeat(1 << 14)`},
+	} {
+		val, err := ctx.RunScript(bm.source, "")
+		if err != nil {
+			b.Fatal(err)
+		}
+		b.Run(bm.name, func(b *testing.B) {
+			b.ReportAllocs()
+			b.SetBytes(int64(len(val.String())))
+			for n := 0; n < b.N; n++ {
+				_ = val.String()
+			}
+		})
+	}
+}
+
+func TestValueReleaseUnreachable(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate(v8.ReleaseUnreachableValues, v8.RecordShimStats)
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	kept, err := ctx.RunScript("'kept'", "release.js")
+	fatalIf(t, err)
+	before, _ := iso.ShimStats()
+	const n = 100
+	for i := 0; i < n; i++ {
+		_, err := ctx.RunScript("({})", "release.js")
+		fatalIf(t, err)
+	}
+
+	var stats v8.ShimStats
+	for try := 0; try < 10; try++ {
+		runtime.GC()
+		// The next call into the context releases the queued values.
+		_, err = ctx.RunScript("0", "release.js")
+		fatalIf(t, err)
+		stats, _ = iso.ShimStats()
+		if stats.ValuesFreed-before.ValuesFreed >= n {
+			break
+		}
+	}
+	if freed := stats.ValuesFreed - before.ValuesFreed; freed < n {
+		t.Errorf("expected the %d unreachable values to be released, got %d", n, freed)
+	}
+	if s := kept.String(); s != "kept" {
+		t.Errorf("expected the reachable value to be kept, got %q", s)
+	}
+}
@@ -0,0 +1,237 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include <stdlib.h>
+// #include "v8go.h"
+import "C"
+import (
+	"errors"
+	"io"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// WasmModuleObject is a compiled WebAssembly module, the WebAssembly.Module
+// of a context, which scripts instantiate with new WebAssembly.Instance.
+type WasmModuleObject struct {
+	*Object
+}
+
+// CompiledWasmModule is the compiled code of a WebAssembly module, which is
+// shared by the WasmModuleObjects of every isolate that it is instantiated in,
+// see Context.NewWasmModuleObject.
+type CompiledWasmModule struct {
+	mu  sync.Mutex
+	ptr C.CompiledWasmModulePtr
+}
+
+// CompileWasmModule compiles the module of the WebAssembly binary wire
+// synchronously, like new WebAssembly.Module.
+// error will be of type `JSError` if not nil.
+func (c *Context) CompileWasmModule(wire []byte) (*WasmModuleObject, error) {
+	var ptr unsafe.Pointer
+	if len(wire) > 0 {
+		ptr = unsafe.Pointer(&wire[0])
+	}
+	rtn := C.ContextCompileWasmModule(c.ptr, ptr, C.size_t(len(wire)))
+	runtime.KeepAlive(wire)
+	return wasmModuleResult(c, rtn)
+}
+
+// LoadWasmModule is like CompileWasmModule, but rather than compiling the
+// module it deserializes its code from cache, which CompiledWasmModule.Serialize
+// returned with the same wire bytes, to skip the compilation of modules that
+// are cached on disk. It reports whether V8 accepted the cache; a cache of
+// another version of V8, or of other flags, is ignored and the module is
+// compiled from wire.
+// error will be of type `JSError` if not nil.
+func (c *Context) LoadWasmModule(wire, cache []byte) (*WasmModuleObject, bool, error) {
+	s, err := c.newWasmStreaming(cache)
+	if err != nil {
+		return nil, false, err
+	}
+	s.Write(wire)
+	m, err := s.Finish()
+	return m, s.cacheAccepted, err
+}
+
+// CompileWasmModuleStreaming compiles the module of the WebAssembly binary
+// read from r as its bytes arrive, so that the compilation of a module that
+// is downloaded overlaps with its download, see WasmStreaming. The isolate is
+// only locked while the bytes that were read are handed to V8.
+// error will be of type `JSError` if not nil.
+func (c *Context) CompileWasmModuleStreaming(r io.Reader) (*WasmModuleObject, error) {
+	s, err := c.NewWasmStreaming()
+	if err != nil {
+		return nil, err
+	}
+	buf := make([]byte, wasmStreamingChunk)
+	for {
+		n, err := r.Read(buf)
+		s.Write(buf[:n])
+		if err == io.EOF {
+			return s.Finish()
+		}
+		if err != nil {
+			s.Abort(err)
+			return nil, err
+		}
+	}
+}
+
+// wasmStreamingChunk is the size of the reads of CompileWasmModuleStreaming.
+const wasmStreamingChunk = 64 << 10
+
+// WasmStreaming is the streaming compilation of a WebAssembly module, as by
+// WebAssembly.compileStreaming, whose bytes are written to it as they arrive.
+// V8 decodes the bytes that are written and compiles their functions on its
+// background threads, while more bytes are on their way. A WasmStreaming must
+// be finished or aborted, which frees it.
+type WasmStreaming struct {
+	ctx           *Context
+	ptr           C.WasmStreamPtr
+	promise       *Promise
+	cacheAccepted bool
+}
+
+// NewWasmStreaming starts the streaming compilation of a module in the
+// context.
+// error will be of type `JSError` if not nil.
+func (c *Context) NewWasmStreaming() (*WasmStreaming, error) {
+	return c.newWasmStreaming(nil)
+}
+
+func (c *Context) newWasmStreaming(cache []byte) (*WasmStreaming, error) {
+	var ptr unsafe.Pointer
+	if len(cache) > 0 {
+		ptr = unsafe.Pointer(&cache[0])
+	}
+	rtn := C.ContextNewWasmStream(c.ptr, ptr, C.size_t(len(cache)))
+	runtime.KeepAlive(cache)
+	if rtn.ptr == nil {
+		return nil, newJSError(rtn.error)
+	}
+	promise := &Promise{&Object{newValue(c, rtn.promise)}}
+	return &WasmStreaming{ctx: c, ptr: rtn.ptr, promise: promise}, nil
+}
+
+// Promise returns the promise of the compilation, which is resolved with the
+// WebAssembly.Module once the stream is finished, or rejected, for scripts to
+// wait for the module.
+func (s *WasmStreaming) Promise() *Promise {
+	return s.promise
+}
+
+// Write hands the bytes of p to the compilation. It never fails; errors of
+// the module reject its promise.
+func (s *WasmStreaming) Write(p []byte) (int, error) {
+	if s.ptr == nil {
+		panic("v8go: WasmStreaming used after Finish or Abort")
+	}
+	if len(p) == 0 {
+		return 0, nil
+	}
+	C.WasmStreamWrite(s.ptr, unsafe.Pointer(&p[0]), C.size_t(len(p)))
+	runtime.KeepAlive(p)
+	return len(p), nil
+}
+
+// Finish tells V8 that every byte of the module has been written, and waits
+// for the compilation to be done, running the tasks that V8 posts for it.
+// error will be of type `JSError` if not nil.
+func (s *WasmStreaming) Finish() (*WasmModuleObject, error) {
+	if s.ptr == nil {
+		panic("v8go: WasmStreaming used after Finish or Abort")
+	}
+	var accepted C.int
+	rtn := C.WasmStreamFinish(s.ptr, &accepted)
+	s.ptr = nil
+	s.cacheAccepted = accepted != 0
+	return wasmModuleResult(s.ctx, rtn)
+}
+
+// Abort stops the compilation and rejects its promise with err.
+func (s *WasmStreaming) Abort(err error) {
+	if s.ptr == nil {
+		panic("v8go: WasmStreaming used after Finish or Abort")
+	}
+	errVal := errorValue(s.ctx, err)
+	C.WasmStreamAbort(s.ptr, errVal.ptr)
+	runtime.KeepAlive(errVal)
+	s.ptr = nil
+}
+
+// NewWasmModuleObject creates a WasmModuleObject of the context for the
+// compiled module m, which may come from a module of another isolate, without
+// compiling it again.
+// error will be of type `JSError` if not nil.
+func (c *Context) NewWasmModuleObject(m *CompiledWasmModule) (*WasmModuleObject, error) {
+	if m == nil {
+		return nil, errors.New("v8go: CompiledWasmModule is required")
+	}
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.ptr == nil {
+		return nil, errors.New("v8go: CompiledWasmModule has been released")
+	}
+	rtn := C.NewWasmModuleObject(c.ptr, m.ptr)
+	return wasmModuleResult(c, rtn)
+}
+
+func wasmModuleResult(c *Context, rtn C.RtnValue) (*WasmModuleObject, error) {
+	val, err := valueResult(c, rtn)
+	if err != nil {
+		return nil, err
+	}
+	return &WasmModuleObject{&Object{val}}, nil
+}
+
+// CompiledModule returns the compiled code of the module, which must be
+// released once it is no longer used.
+func (m *WasmModuleObject) CompiledModule() *CompiledWasmModule {
+	cm := &CompiledWasmModule{ptr: C.WasmModuleObjectGetCompiledModule(m.ptr)}
+	runtime.SetFinalizer(cm, (*CompiledWasmModule).Release)
+	return cm
+}
+
+// WireBytes returns a copy of the WebAssembly binary of the module.
+func (m *CompiledWasmModule) WireBytes() []byte {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.ptr == nil {
+		panic("v8go: CompiledWasmModule used after Release")
+	}
+	data := C.CompiledWasmModuleWireBytes(m.ptr)
+	return C.GoBytes(data.data, C.int(data.byteLength))
+}
+
+// Serialize returns the compiled code of the module, which Context.LoadWasmModule
+// loads along with its wire bytes in place of compiling them, in a later run
+// of the same version of V8. Code that V8 has not yet optimized is compiled
+// again when it is first called.
+func (m *CompiledWasmModule) Serialize() []byte {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.ptr == nil {
+		panic("v8go: CompiledWasmModule used after Release")
+	}
+	data := C.CompiledWasmModuleSerialize(m.ptr)
+	defer C.free(data.data)
+	return C.GoBytes(data.data, C.int(data.byteLength))
+}
+
+// Release frees the reference to the compiled code, which is kept for as
+// long as WasmModuleObjects use it. Release is safe to call more than once,
+// and is called when m is garbage collected.
+func (m *CompiledWasmModule) Release() {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.ptr != nil {
+		C.CompiledWasmModuleRelease(m.ptr)
+		m.ptr = nil
+	}
+}
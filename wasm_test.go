@@ -0,0 +1,174 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"bytes"
+	"errors"
+	"testing"
+	"testing/iotest"
+
+	v8 "rogchap.com/v8go"
+)
+
+// addWasm is a module that exports add(a, b int32) int32.
+var addWasm = []byte{
+	0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,
+	0x01, 0x07, 0x01, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f,
+	0x03, 0x02, 0x01, 0x00,
+	0x07, 0x07, 0x01, 0x03, 'a', 'd', 'd', 0x00, 0x00,
+	0x0a, 0x09, 0x01, 0x07, 0x00, 0x20, 0x00, 0x20, 0x01, 0x6a, 0x0b,
+}
+
+// skipWithoutWasm skips the tests of WebAssembly with the V8 libraries that
+// have no JIT compilers, and so no WebAssembly.
+func skipWithoutWasm(t *testing.T) {
+	if v8.BuildVariant == "jitless" || v8.BuildVariant == "lite" {
+		t.Skipf("no WebAssembly in the %s build of V8", v8.BuildVariant)
+	}
+}
+
+func callWasmAdd(t *testing.T, ctx *v8.Context, m *v8.WasmModuleObject) {
+	t.Helper()
+	fatalIf(t, ctx.Global().Set("m", m))
+	val, err := ctx.RunScript("new WebAssembly.Instance(m).exports.add(40, 2)", "wasm.js")
+	fatalIf(t, err)
+	if val.Int32() != 42 {
+		t.Errorf("expected 42, got %v", val)
+	}
+}
+
+func TestWasmModuleObject(t *testing.T) {
+	t.Parallel()
+	skipWithoutWasm(t)
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	m, err := ctx.CompileWasmModule(addWasm)
+	fatalIf(t, err)
+	callWasmAdd(t, ctx, m)
+	if _, err := ctx.CompileWasmModule(addWasm[:12]); err == nil {
+		t.Error("expected an error compiling a truncated module")
+	}
+
+	val, err := ctx.RunScript("m", "m.js")
+	fatalIf(t, err)
+	if _, err := val.AsWasmModuleObject(); err != nil {
+		t.Error(err)
+	}
+	if _, err := ctx.Global().AsWasmModuleObject(); err == nil {
+		t.Error("expected an error casting an object that is not a module")
+	}
+
+	compiled := m.CompiledModule()
+	defer compiled.Release()
+	if !bytes.Equal(compiled.WireBytes(), addWasm) {
+		t.Errorf("unexpected wire bytes %v", compiled.WireBytes())
+	}
+
+	// The compiled module is instantiated in another isolate.
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	ctx2 := v8.NewContext(iso2)
+	defer ctx2.Close()
+	m2, err := ctx2.NewWasmModuleObject(compiled)
+	fatalIf(t, err)
+	callWasmAdd(t, ctx2, m2)
+
+	compiled.Release()
+	if _, err := ctx2.NewWasmModuleObject(compiled); err == nil {
+		t.Error("expected an error using a released module")
+	}
+}
+
+func TestContextLoadWasmModule(t *testing.T) {
+	t.Parallel()
+	skipWithoutWasm(t)
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	m, err := ctx.CompileWasmModule(addWasm)
+	fatalIf(t, err)
+	compiled := m.CompiledModule()
+	cache := compiled.Serialize()
+	compiled.Release()
+
+	iso2 := v8.NewIsolate()
+	defer iso2.Dispose()
+	ctx2 := v8.NewContext(iso2)
+	defer ctx2.Close()
+	m2, accepted, err := ctx2.LoadWasmModule(addWasm, cache)
+	fatalIf(t, err)
+	if !accepted {
+		t.Error("expected the cache to be accepted")
+	}
+	callWasmAdd(t, ctx2, m2)
+
+	// A bad cache falls back to compiling the wire bytes.
+	m3, accepted, err := ctx2.LoadWasmModule(addWasm, []byte("not a cache"))
+	fatalIf(t, err)
+	if accepted {
+		t.Error("expected a bad cache to be rejected")
+	}
+	callWasmAdd(t, ctx2, m3)
+
+	if _, _, err := ctx2.LoadWasmModule(addWasm[:12], nil); err == nil {
+		t.Error("expected an error loading a truncated module")
+	}
+	if _, err := ctx2.RunScript("WebAssembly.compileStreaming(1)", "stream.js"); err != nil {
+		t.Error(err)
+	}
+}
+
+func TestContextCompileWasmModuleStreaming(t *testing.T) {
+	t.Parallel()
+	skipWithoutWasm(t)
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	m, err := ctx.CompileWasmModuleStreaming(iotest.OneByteReader(bytes.NewReader(addWasm)))
+	fatalIf(t, err)
+	callWasmAdd(t, ctx, m)
+
+	if _, err := ctx.CompileWasmModuleStreaming(bytes.NewReader(addWasm[:12])); err == nil {
+		t.Error("expected an error compiling a truncated module")
+	}
+	readErr := errors.New("connection reset")
+	if _, err := ctx.CompileWasmModuleStreaming(iotest.TimeoutReader(bytes.NewReader(addWasm))); err != iotest.ErrTimeout {
+		t.Errorf("expected the read error, got %v", err)
+	}
+
+	// Scripts wait for the promise of a stream that Go feeds.
+	s, err := ctx.NewWasmStreaming()
+	fatalIf(t, err)
+	fatalIf(t, ctx.Global().Set("compiling", s.Promise()))
+	val, err := ctx.RunScript("compiling.then(m => new WebAssembly.Instance(m).exports.add(1, 2))", "stream.js")
+	fatalIf(t, err)
+	s.Write(addWasm[:20])
+	s.Write(addWasm[20:])
+	_, err = s.Finish()
+	fatalIf(t, err)
+	ctx.PerformMicrotaskCheckpoint()
+	if p, _ := val.AsPromise(); p.State() != v8.Fulfilled || p.Result().Int32() != 3 {
+		t.Errorf("expected the script to get the module, got %v", p.Result())
+	}
+
+	s, err = ctx.NewWasmStreaming()
+	fatalIf(t, err)
+	s.Write(addWasm[:20])
+	s.Abort(readErr)
+	if s.Promise().State() != v8.Rejected || s.Promise().Result().String() != "Error: connection reset" {
+		t.Errorf("expected the promise to be rejected, got %v", s.Promise().Result())
+	}
+}
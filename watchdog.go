@@ -0,0 +1,114 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+import (
+	"context"
+	"errors"
+	"time"
+)
+
+// RunScriptWithTimeout executes the source JavaScript like RunScript, and
+// terminates it if it runs for longer than timeout, in which case the error is
+// context.DeadlineExceeded. The isolate can run JavaScript again once it has
+// returned.
+func (c *Context) RunScriptWithTimeout(source string, origin string, timeout time.Duration) (*Value, error) {
+	var val *Value
+	err := c.iso.withTimeout(timeout, func() (err error) {
+		val, err = c.RunScript(source, origin)
+		return err
+	})
+	return val, err
+}
+
+// RunScriptContext executes the source JavaScript like RunScript, and
+// terminates it when ctx is done, in which case the error is ctx.Err(). The
+// deadline of ctx is enforced by the watchdog of the process; a ctx that has a
+// deadline is only checked for being canceled before the script starts. The
+// isolate can run JavaScript again once it has returned.
+func (c *Context) RunScriptContext(ctx context.Context, source string, origin string) (*Value, error) {
+	var val *Value
+	err := c.iso.withContext(ctx, func() (err error) {
+		val, err = c.RunScript(source, origin)
+		return err
+	})
+	return val, err
+}
+
+// PerformMicrotaskCheckpointWithTimeout runs the MicrotaskQueue of the
+// context like PerformMicrotaskCheckpoint, but for no longer than timeout,
+// in which case the error is context.DeadlineExceeded. V8 cannot stop a
+// checkpoint part way, so the microtasks that have not run by then are
+// dropped; this bounds the time that a context with its own queue takes from
+// the other contexts of the isolate.
+func (c *Context) PerformMicrotaskCheckpointWithTimeout(timeout time.Duration) error {
+	c.iso.finishDynamicImports()
+	c.async.settle(c)
+	return c.iso.withTimeout(timeout, func() error {
+		if C.ContextPerformMicrotaskCheckpoint(c.ptr) != 0 {
+			return errMicrotasksTerminated
+		}
+		return nil
+	})
+}
+
+// errMicrotasksTerminated reports a microtask checkpoint that was terminated.
+var errMicrotasksTerminated = errors.New("v8go: microtask checkpoint terminated")
+
+// withTimeout calls run, having the watchdog of the process terminate the
+// isolate's execution if run has not returned within timeout. Terminating is
+// only reported if run fails, run may well have finished just in time.
+func (i *Isolate) withTimeout(timeout time.Duration, run func() error) error {
+	if timeout <= 0 {
+		return context.DeadlineExceeded
+	}
+	// Timeouts are rounded up to the millisecond ticks of the watchdog.
+	ms := (timeout + time.Millisecond - 1) / time.Millisecond
+	id := C.IsolateArmWatchdog(i.ptr, C.int64_t(ms))
+	err := run()
+	if C.IsolateDisarmWatchdog(i.ptr, id) != 0 && err != nil {
+		return context.DeadlineExceeded
+	}
+	return err
+}
+
+// withContext calls run, terminating the isolate's execution when ctx is done.
+// Deadlines are left to the watchdog, without a goroutine per call, so only
+// contexts without a deadline are watched for being canceled while run runs.
+func (i *Isolate) withContext(ctx context.Context, run func() error) error {
+	if err := ctx.Err(); err != nil {
+		return err
+	}
+	done := ctx.Done()
+	if done == nil {
+		return run()
+	}
+	if deadline, ok := ctx.Deadline(); ok {
+		return i.withTimeout(time.Until(deadline), run)
+	}
+
+	// Once ctx is done the watchdog terminates the execution right away, and
+	// keeps doing so until it has been disarmed.
+	var armed uint64
+	stop := make(chan struct{})
+	stopped := make(chan struct{})
+	go func() {
+		defer close(stopped)
+		select {
+		case <-done:
+			armed = uint64(C.IsolateArmWatchdog(i.ptr, 0))
+		case <-stop:
+		}
+	}()
+	err := run()
+	close(stop)
+	<-stopped
+	if armed != 0 && C.IsolateDisarmWatchdog(i.ptr, C.uint64_t(armed)) != 0 && err != nil {
+		return ctx.Err()
+	}
+	return err
+}
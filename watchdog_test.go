@@ -0,0 +1,132 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"context"
+	"sync"
+	"testing"
+	"time"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestRunScriptWithTimeout(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	val, err := ctx.RunScriptWithTimeout("1 + 1", "quick.js", time.Second)
+	fatalIf(t, err)
+	if val.Integer() != 2 {
+		t.Errorf("expected 2, got %v", val)
+	}
+
+	start := time.Now()
+	_, err = ctx.RunScriptWithTimeout("for (;;) {}", "loop.js", 50*time.Millisecond)
+	if err != context.DeadlineExceeded {
+		t.Fatalf("expected context.DeadlineExceeded, got %v", err)
+	}
+	if elapsed := time.Since(start); elapsed < 50*time.Millisecond || elapsed > 2*time.Second {
+		t.Errorf("unexpected time to terminate: %v", elapsed)
+	}
+
+	val, err = ctx.RunScript("'alive'", "after.js")
+	fatalIf(t, err)
+	if val.String() != "alive" {
+		t.Errorf("expected the isolate to run again, got %v", val)
+	}
+}
+
+func TestPerformMicrotaskCheckpointWithTimeout(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso, v8.OwnMicrotaskQueue)
+	defer ctx.Close()
+
+	_, err := ctx.RunScript("var n = 0; Promise.resolve().then(() => { n = 1 })", "once.js")
+	fatalIf(t, err)
+	fatalIf(t, ctx.PerformMicrotaskCheckpointWithTimeout(time.Second))
+	if val, _ := ctx.RunScript("n", "n.js"); val.Integer() != 1 {
+		t.Errorf("expected the microtask to run, got %v", val)
+	}
+
+	_, err = ctx.RunScript("(function again() { Promise.resolve().then(again) })()", "forever.js")
+	fatalIf(t, err)
+	if err := ctx.PerformMicrotaskCheckpointWithTimeout(50 * time.Millisecond); err != context.DeadlineExceeded {
+		t.Fatalf("expected context.DeadlineExceeded, got %v", err)
+	}
+
+	val, err := ctx.RunScript("'alive'", "after.js")
+	fatalIf(t, err)
+	if val.String() != "alive" {
+		t.Errorf("expected the isolate to run again, got %v", val)
+	}
+}
+
+func TestRunScriptWithTimeoutConcurrent(t *testing.T) {
+	t.Parallel()
+
+	// Timeouts beyond one turn of the timer wheel, and many at once.
+	timeouts := []time.Duration{time.Millisecond, 10 * time.Millisecond, 1100 * time.Millisecond}
+	var wg sync.WaitGroup
+	for i := 0; i < 12; i++ {
+		timeout := timeouts[i%len(timeouts)]
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			ctx := v8.NewContext()
+			defer ctx.Isolate().Dispose()
+			defer ctx.Close()
+			start := time.Now()
+			if _, err := ctx.RunScriptWithTimeout("for (;;) {}", "loop.js", timeout); err != context.DeadlineExceeded {
+				t.Errorf("expected context.DeadlineExceeded, got %v", err)
+			}
+			if elapsed := time.Since(start); elapsed < timeout {
+				t.Errorf("terminated after %v, before the timeout of %v", elapsed, timeout)
+			}
+			for j := 0; j < 100; j++ {
+				if _, err := ctx.RunScriptWithTimeout("1", "quick.js", time.Second); err != nil {
+					t.Errorf("unexpected error: %v", err)
+				}
+			}
+		}()
+	}
+	wg.Wait()
+}
+
+func TestRunScriptContext(t *testing.T) {
+	t.Parallel()
+
+	ctx := v8.NewContext()
+	defer ctx.Isolate().Dispose()
+	defer ctx.Close()
+
+	deadline, cancel := context.WithTimeout(context.Background(), 50*time.Millisecond)
+	defer cancel()
+	if _, err := ctx.RunScriptContext(deadline, "for (;;) {}", "loop.js"); err != context.DeadlineExceeded {
+		t.Errorf("expected context.DeadlineExceeded, got %v", err)
+	}
+	<-deadline.Done()
+	if _, err := ctx.RunScriptContext(deadline, "1", "late.js"); err != context.DeadlineExceeded {
+		t.Errorf("expected an expired context not to run, got %v", err)
+	}
+
+	canceled, cancel := context.WithCancel(context.Background())
+	time.AfterFunc(50*time.Millisecond, cancel)
+	if _, err := ctx.RunScriptContext(canceled, "for (;;) {}", "loop.js"); err != context.Canceled {
+		t.Errorf("expected context.Canceled, got %v", err)
+	}
+
+	val, err := ctx.RunScriptContext(context.Background(), "'alive'", "after.js")
+	fatalIf(t, err)
+	if val.String() != "alive" {
+		t.Errorf("expected the isolate to run again, got %v", val)
+	}
+}
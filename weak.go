@@ -0,0 +1,61 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go
+
+// #include "v8go.h"
+import "C"
+
+// SetWeak has finalizer called once the object has been garbage collected,
+// to free the Go resources bound to it. The object can only be collected
+// once no value refers to it, so the *Object and any other *Value of it have
+// to be released, with Value.Release or a value scope, or their context
+// closed.
+//
+// Finalizers are not called during garbage collection: V8 queues them, and
+// Isolate.RunFinalizers calls them in batches on the goroutine that calls
+// it, which Context.RunEventLoop does on each turn. The finalizers of objects
+// that are still alive when the isolate is disposed are not called.
+func (o *Object) SetWeak(finalizer func()) {
+	if finalizer == nil {
+		panic("v8go: nil finalizer")
+	}
+	iso := o.ctx.iso
+	iso.finalizerMutex.Lock()
+	iso.finalizerSeq++
+	ref := iso.finalizerSeq
+	if iso.finalizers == nil {
+		iso.finalizers = make(map[int]func())
+	}
+	iso.finalizers[ref] = finalizer
+	iso.finalizerMutex.Unlock()
+	C.ObjectSetWeak(o.ptr, C.int(ref))
+}
+
+// RunFinalizers calls the finalizers of the objects that have been garbage
+// collected since it was last called, see Object.SetWeak, and returns how
+// many it called.
+func (i *Isolate) RunFinalizers() int {
+	var refs [64]C.int
+	called := 0
+	for {
+		n := int(C.IsolateDrainFinalizedObjects(i.ptr, &refs[0], C.size_t(len(refs))))
+		finalizers := make([]func(), 0, n)
+		i.finalizerMutex.Lock()
+		for _, ref := range refs[:n] {
+			if f, ok := i.finalizers[int(ref)]; ok {
+				finalizers = append(finalizers, f)
+				delete(i.finalizers, int(ref))
+			}
+		}
+		i.finalizerMutex.Unlock()
+		for _, f := range finalizers {
+			f()
+		}
+		called += len(finalizers)
+		if n < len(refs) {
+			return called
+		}
+	}
+}
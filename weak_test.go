@@ -0,0 +1,56 @@
+// Copyright 2022 the v8go contributors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package v8go_test
+
+import (
+	"testing"
+
+	v8 "rogchap.com/v8go"
+)
+
+func TestObjectSetWeak(t *testing.T) {
+	t.Parallel()
+
+	iso := v8.NewIsolate()
+	defer iso.Dispose()
+	ctx := v8.NewContext(iso)
+	defer ctx.Close()
+
+	freed := map[int]bool{}
+	var kept *v8.Object
+	for i := 0; i < 10; i++ {
+		i := i
+		val, err := ctx.RunScript("({})", "wrapper.js")
+		fatalIf(t, err)
+		obj, err := val.AsObject()
+		fatalIf(t, err)
+		obj.SetWeak(func() { freed[i] = true })
+		if i == 0 {
+			kept = obj
+			continue
+		}
+		obj.Release()
+	}
+	if n := iso.RunFinalizers(); n != 0 {
+		t.Errorf("expected no finalizers before garbage collection, got %d", n)
+	}
+
+	iso.LowMemoryNotification()
+	if len(freed) != 0 {
+		t.Error("expected the finalizers to wait for RunFinalizers")
+	}
+	if n := iso.RunFinalizers(); n != 9 {
+		t.Errorf("expected 9 finalizers, got %d", n)
+	}
+	if freed[0] || len(freed) != 9 {
+		t.Errorf("expected the finalizers of the released objects to run, got %v", freed)
+	}
+	if !kept.IsObject() {
+		t.Error("expected the object that is still referenced to be alive")
+	}
+	if n := iso.RunFinalizers(); n != 0 {
+		t.Errorf("expected the finalizers to run once, got %d more", n)
+	}
+}